@@ -22,6 +22,10 @@ check_include_files("sys/types.h;sys/time.h"    LOG4CPLUS_HAVE_SYS_TIME_H )
 check_include_files("sys/types.h;sys/timeb.h"   LOG4CPLUS_HAVE_SYS_TIMEB_H )
 check_include_files("sys/types.h;sys/stat.h"    LOG4CPLUS_HAVE_SYS_STAT_H )
 check_include_files(sys/file.h    LOG4CPLUS_HAVE_SYS_FILE_H )
+check_include_files(sys/mman.h    LOG4CPLUS_HAVE_SYS_MMAN_H )
+check_include_files(linux/io_uring.h LOG4CPLUS_HAVE_LINUX_IO_URING_H )
+check_include_files(sys/epoll.h   LOG4CPLUS_HAVE_SYS_EPOLL_H )
+check_include_files(sys/inotify.h LOG4CPLUS_HAVE_SYS_INOTIFY_H )
 check_include_files(syslog.h      LOG4CPLUS_HAVE_SYSLOG_H )
 check_include_files(arpa/inet.h   LOG4CPLUS_HAVE_ARPA_INET_H )
 check_include_files(netinet/in.h  LOG4CPLUS_HAVE_NETINET_IN_H )
@@ -51,11 +55,17 @@ find_library(LIBKERNEL32 kernel32)
 find_library(LIBNSL nsl)
 find_library(LIBRT rt)
 find_library(LIBICONV iconv)
+find_library(LIBZ z)
 find_library(LIBPOSIX4 posix4)
 find_library(LIBCPOSIX cposix)
 find_library(LIBSOCKET socket)
 find_library(LIBWS2_32 ws2_32)
 
+check_include_files(zlib.h LOG4CPLUS_HAVE_ZLIB_H)
+if (LIBZ AND LOG4CPLUS_HAVE_ZLIB_H)
+  set (LOG4CPLUS_WITH_ZLIB 1)
+endif ()
+
 check_function_exists(gmtime_r      LOG4CPLUS_HAVE_GMTIME_R )
 check_function_exists(localtime_r   LOG4CPLUS_HAVE_LOCALTIME_R )
 check_function_exists(gettimeofday  LOG4CPLUS_HAVE_GETTIMEOFDAY )
@@ -313,6 +323,9 @@ set(HAVE_STDLIB_H              ${LOG4CPLUS_HAVE_STDLIB_H} )
 set(HAVE_SYS_STAT_H            ${LOG4CPLUS_HAVE_SYS_STAT_H} )
 set(HAVE_SYS_TYPES_H           ${LOG4CPLUS_HAVE_SYS_TYPES_H} )
 set(HAVE_SYS_FILE_H            ${LOG4CPLUS_HAVE_SYS_FILE_H} )
+set(HAVE_SYS_MMAN_H            ${LOG4CPLUS_HAVE_SYS_MMAN_H} )
+set(HAVE_LINUX_IO_URING_H      ${LOG4CPLUS_HAVE_LINUX_IO_URING_H} )
+set(HAVE_SYS_EPOLL_H           ${LOG4CPLUS_HAVE_SYS_EPOLL_H} )
 set(HAVE_UNISTD_H              ${LOG4CPLUS_HAVE_UNISTD_H} )
 
 
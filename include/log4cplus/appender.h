@@ -40,7 +40,10 @@
 #include <memory>
 #include <mutex>
 #include <atomic>
+#include <cstdint>
+#include <chrono>
 #include <condition_variable>
+#include <vector>
 
 
 namespace log4cplus {
@@ -128,10 +131,61 @@ namespace log4cplus {
      * \sa FileAppender
      * </dd>
      *
+     * <dt><tt>LockFileMutex</tt></dt>
+     * <dd>Set this property to <tt>true</tt> to synchronize the
+     * processes through a robust, process shared mutex kept in a
+     * small sidecar file next to the lock file (<tt>.mtx</tt>
+     * suffix) instead of file locking syscalls. An uncontended
+     * acquisition then costs a couple of atomic operations on shared
+     * memory rather than a syscall pair per append, and a crashed
+     * lock holder is recovered by the next locker instead of
+     * deadlocking the survivors. The lock file itself is kept; it
+     * serializes the one-time initialization of the shared mutex.
+     * The property only matters together with <tt>UseLockFile</tt>
+     * and is ignored on platforms without process shared robust
+     * mutexes. Default is <tt>false</tt>.
+     * \sa helpers::LockFile
+     * </dd>
+     *
      * <dt><tt>AsyncAppend</tt></dt>
      * <dd>Set this property to <tt>true</tt> if you want all appends using
      * this appender to be done asynchronously. Default is <tt>false</tt>.</dd>
      *
+     * <dt><tt>CollectStatistics</tt></dt>
+     * <dd>Set this property to <tt>true</tt> to additionally sample
+     * per event append latency into this appender's statistics.
+     * Event, byte, filter rejection and error handler counters are
+     * always maintained; only the latency sampling with its two clock
+     * reads per append is optional. Default is <tt>false</tt>.
+     * \sa log4cplus::statistics()
+     * </dd>
+     *
+     * <dt><tt>CollapseRepeats</tt></dt>
+     * <dd>Set this property to <tt>true</tt> to collapse runs of
+     * consecutive events with the same logger, log level and message
+     * into their first occurrence followed by a synthesized "last
+     * message repeated N times" summary event. Duplicates are
+     * detected by hashing the event's identity before layout, so a
+     * suppressed event is never formatted. Default is
+     * <tt>false</tt>.</dd>
+     *
+     * <dt><tt>CollapseRepeatsWindowSeconds</tt></dt>
+     * <dd>Maximum age, in seconds, of a run of duplicates before its
+     * summary is emitted even though identical events keep arriving.
+     * Only used when <tt>CollapseRepeats</tt> is <tt>true</tt>.
+     * Default is 30.</dd>
+     *
+     * <dt><tt>SequenceNumbers</tt></dt>
+     * <dd>Set this property to <tt>true</tt> to stamp every event
+     * this appender delivers with a monotonically increasing per
+     * appender sequence number, available to layouts through the
+     * <b>%%#</b> pattern conversion specifier and emitted as a
+     * record by BinaryLayout. A consumer that remembers only the
+     * last seen number detects lost events as gaps in the sequence.
+     * Events suppressed by the threshold, the filters or repeat
+     * collapsing do not consume numbers, so a gap always means loss
+     * downstream of the appender. Default is <tt>false</tt>.</dd>
+     *
      * </dl>
      */
     class LOG4CPLUS_EXPORT Appender
@@ -190,6 +244,16 @@ namespace log4cplus {
          */
         void doAppend(const log4cplus::spi::InternalLoggingEvent& event);
 
+        /**
+         * Deliver a whole batch of events in one call. The appender
+         * lock is taken once for the batch and runs of events passing
+         * the threshold and filter checks are handed to the {@link
+         * #appendBatch} method. Appenders with the `async` flag set
+         * fall back to per event doAppend() calls.
+         */
+        void doAppendBatch(const log4cplus::spi::InternalLoggingEvent* events,
+            std::size_t count);
+
         /**
          * Get the name of this appender. The name uniquely identifies the
          * appender.
@@ -261,8 +325,14 @@ namespace log4cplus {
          * In configuration files this option is specified by setting the
          * value of the <b>Threshold</b> option to a LogLevel
          * string, such as "DEBUG", "INFO" and so on.
+         *
+         * The thresholds of attached appenders also feed the logger
+         * side effective threshold gates; changing the threshold of
+         * an already attached appender refreshes the gates of the
+         * default hierarchy. Custom hierarchies pick the change up on
+         * their next configuration change.
          */
-        void setThreshold(LogLevel th) { threshold = th; }
+        void setThreshold(LogLevel th);
 
         /**
          * Check whether the message LogLevel is below the appender's
@@ -275,10 +345,69 @@ namespace log4cplus {
 
         /**
          * This method waits for all events that are being asynchronously
-         * logged to finish.
+         * logged to finish. When <tt>CollapseRepeats</tt> is enabled
+         * it also emits the pending "repeated N times" summary of a
+         * run of duplicates that is still open.
          */
         void waitToFinishAsyncLogging();
 
+        /**
+         * Deadline bounded variant of waitToFinishAsyncLogging().
+         * Waits at most \c budget for asynchronously logged events to
+         * finish and reports through helpers::LogLog when the budget
+         * runs out with events still in flight. Returns \c true when
+         * everything was drained within the budget.
+         */
+        virtual bool waitToFinishAsyncLogging(std::chrono::milliseconds budget);
+
+        /**
+         * Point in time snapshot of this appender's activity,
+         * obtained through getStatistics() or log4cplus::statistics().
+         */
+        struct Statistics
+        {
+            //! Name of the appender the snapshot belongs to.
+            log4cplus::tstring name;
+            //! Events delivered to the append() implementation.
+            unsigned long long eventsAppended = 0;
+            //! Bytes of formatted log output produced. Appenders
+            //! that format straight into a device without a
+            //! measurable position (e.g. console) may under report.
+            unsigned long long bytesWritten = 0;
+            //! Events denied by the filter chain.
+            unsigned long long filterRejections = 0;
+            //! Events suppressed by the duplicate collapse stage
+            //! (see the <tt>CollapseRepeats</tt> property). Each
+            //! summarized run additionally appends one synthesized
+            //! summary event.
+            unsigned long long eventsCollapsed = 0;
+            //! Invocations of the error handler.
+            unsigned long long errorHandlerInvocations = 0;
+            //! Estimated append latency quantiles in microseconds.
+            //! Zero until latency sampling has been enabled (see the
+            //! <tt>CollectStatistics</tt> property) and at least one
+            //! event has been appended.
+            double appendLatencyP50Usec = 0;
+            double appendLatencyP99Usec = 0;
+        };
+
+        /**
+         * Returns a snapshot of this appender's counters and latency
+         * quantiles. The counters are maintained with relaxed atomics
+         * on the append path; the snapshot is not a consistent cut
+         * but each individual value is exact.
+         */
+        Statistics getStatistics () const;
+
+        /**
+         * Enables or disables append latency sampling for this
+         * appender. Counters are unaffected; they are always
+         * maintained.
+         */
+        void setCollectStatistics (bool enable);
+
+        bool getCollectStatistics () const;
+
     protected:
       // Methods
         /**
@@ -288,8 +417,34 @@ namespace log4cplus {
          */
         virtual void append(const log4cplus::spi::InternalLoggingEvent& event) = 0;
 
+        /**
+         * Append a run of events that have already passed the
+         * threshold and filter checks. The default implementation
+         * calls append() for each event; subclasses can override it to
+         * format and flush whole batches at once.
+         * @see doAppendBatch method.
+         */
+        virtual void appendBatch(
+            const log4cplus::spi::InternalLoggingEvent* events,
+            std::size_t count);
+
         tstring & formatEvent (const log4cplus::spi::InternalLoggingEvent& event) const;
 
+        /**
+         * Adds `count` characters of formatted output to the
+         * bytesWritten statistic. formatEvent() accounts its result
+         * itself; subclasses that format straight into their output
+         * stream should call this with the amount produced.
+         */
+        void countBytesWritten (std::size_t count) const;
+
+        /**
+         * Current value of the bytesWritten statistic, for subclasses
+         * that key periodic work off output growth without querying
+         * their output device.
+         */
+        unsigned long long getBytesWrittenStat () const;
+
       // Data
         /** The layout variable does not need to be set if the appender
          *  implementation has its own layout. */
@@ -302,7 +457,9 @@ namespace log4cplus {
         LogLevel threshold;
 
         /** The first filter in the filter chain. Set to <code>null</code>
-         *  initially. */
+         *  initially. Mutated only with access_mutex held and
+         *  republished through setFilter(); event delivery evaluates
+         *  the chain through an atomically read snapshot instead. */
         log4cplus::spi::FilterPtr filter;
 
         /** It is assumed and enforced that errorHandler is never null. */
@@ -315,6 +472,11 @@ namespace log4cplus {
         //! to log file.
         bool useLockFile;
 
+        //! Synchronize through a process shared robust mutex instead
+        //! of file locking syscalls.
+        //! \sa the <tt>LockFileMutex</tt> property.
+        bool useLockFileMutex;
+
         //! Asynchronous append.
         bool async;
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
@@ -327,6 +489,88 @@ namespace log4cplus {
         bool closed;
 
     private:
+        /** Immutable snapshot of the filter chain read with one
+         *  atomic load by syncDoAppend() and doAppendBatch() so that
+         *  filter evaluation does not contend on access_mutex. */
+        std::shared_ptr<spi::FilterPtr const> filterSnapshot;
+
+        LOG4CPLUS_PRIVATE spi::FilterPtr getFilterSnapshot() const;
+
+        /** Counters behind getStatistics(). All increments use
+         *  relaxed atomics so the instrumented path costs no more
+         *  than the additions themselves. Latencies are recorded
+         *  into a base 2 histogram of nanoseconds from which the
+         *  quantiles are estimated at snapshot time. */
+        struct StatisticsData
+        {
+            std::atomic<unsigned long long> eventsAppended {0};
+            std::atomic<unsigned long long> bytesWritten {0};
+            std::atomic<unsigned long long> filterRejections {0};
+            std::atomic<unsigned long long> eventsCollapsed {0};
+            std::atomic<unsigned long long> errorHandlerInvocations {0};
+            std::atomic<unsigned long long> latencyHistogram[64] {};
+        };
+
+        //! Mutable so that the const formatEvent() can account the
+        //! bytes it produces.
+        mutable StatisticsData stats;
+
+        //! Gates the latency sampling done by syncDoAppend() and
+        //! doAppendBatch(). See the <tt>CollectStatistics</tt>
+        //! property.
+        std::atomic<bool> collectStatistics {false};
+
+        //! Collapse consecutive duplicate events into synthesized
+        //! "last message repeated N times" summaries. See the
+        //! <tt>CollapseRepeats</tt> property. Fixed at construction.
+        bool collapseRepeats = false;
+
+        //! Stamp each delivered event with a per appender sequence
+        //! number. See the <tt>SequenceNumbers</tt> property. Fixed
+        //! at construction.
+        bool sequenceNumbers = false;
+
+        //! The last sequence number handed out. Incremented with a
+        //! single relaxed atomic operation per delivered event; per
+        //! appender monotonicity is all a gap detecting consumer
+        //! needs, no ordering with other memory is implied.
+        std::atomic<std::uint64_t> sequenceNumber {0};
+
+        //! Maximum age of a run of duplicates before its summary is
+        //! emitted even though identical events keep arriving.
+        std::chrono::steady_clock::duration collapseWindow {
+            std::chrono::seconds (30) };
+
+        //! State of the duplicate run currently being collapsed.
+        //! Only accessed with access_mutex held.
+        std::size_t lastEventHash = 0;
+        LogLevel lastEventLogLevel = NOT_SET_LOG_LEVEL;
+        log4cplus::tstring lastEventLoggerName;
+        unsigned long long repeatCount = 0;
+        bool haveLastEvent = false;
+        std::chrono::steady_clock::time_point runStart;
+
+        /** Returns true when \c event is a repeat of the previous
+         *  one and has been suppressed. Emits the summary of the
+         *  finished run when \c event breaks it. Must be called with
+         *  access_mutex held. */
+        LOG4CPLUS_PRIVATE bool collapseDuplicate (
+            const spi::InternalLoggingEvent & event);
+
+        //! Appends the "last message repeated N times" summary for
+        //! the current run, if any. Must be called with access_mutex
+        //! held.
+        LOG4CPLUS_PRIVATE void emitRepeatSummary ();
+
+        LOG4CPLUS_PRIVATE void recordAppendLatency (
+            std::chrono::steady_clock::duration, std::size_t count);
+
+        //! Cold path of the closed-appender check in syncDoAppend()
+        //! and doAppendBatch(); kept out of line so that the hot
+        //! path carries no message building code.
+        LOG4CPLUS_PRIVATE LOG4CPLUS_ATTRIBUTE_NOINLINE
+        void reportClosedAppender () const;
+
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
         void subtract_in_flight();
 #endif
@@ -335,6 +579,21 @@ namespace log4cplus {
     /** This is a pointer to an Appender. */
     typedef helpers::SharedObjectPtr<Appender> SharedAppenderPtr;
 
+
+    /**
+     * Returns a point in time statistics snapshot for every appender
+     * attached to a logger of the default hierarchy.
+     * \sa Appender::getStatistics()
+     */
+    LOG4CPLUS_EXPORT std::vector<Appender::Statistics> statistics ();
+
+    /**
+     * Writes a one line summary per appender of the snapshots
+     * returned by statistics() through helpers::LogLog debug output.
+     * Enable internal debugging to see it.
+     */
+    LOG4CPLUS_EXPORT void dumpStatistics ();
+
 } // end namespace log4cplus
 
 #endif // LOG4CPLUS_APPENDER_HEADER_
@@ -48,17 +48,270 @@
 #include <log4cplus/appender.h>
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/helpers/appenderattachableimpl.h>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 
 namespace log4cplus
 {
 
 
+namespace helpers
+{
+
+class EventSpill;
+
+}
+
+
+class AsyncAppender;
+typedef helpers::SharedObjectPtr<AsyncAppender> AsyncAppenderPtr;
+
+
+/**
+   A process-wide, named pool of worker threads that services the
+   queues of multiple `AsyncAppender` instances. Instead of every
+   asynchronous appender running its own, mostly idle, consumer
+   thread, appenders configured with the <tt>Dispatcher</tt> property
+   register their queue with a shared dispatcher; its workers scan the
+   registered queues and deliver whatever batches have accumulated, so
+   a handful of threads can drain many appenders. Any worker drains
+   any queue, but at most one worker drains a given queue at a time,
+   so per appender event ordering is preserved.
+
+   Dispatchers are created on first use through get() and live until
+   the last appender registered with them is closed.
+ */
+class LOG4CPLUS_EXPORT AsyncDispatcher
+    : public virtual helpers::SharedObject
+{
+public:
+    //! Returns the dispatcher registered under \c name, creating it
+    //! with \c worker_count worker threads first if it does not exist
+    //! yet. The worker count of an already existing dispatcher is not
+    //! changed.
+    static helpers::SharedObjectPtr<AsyncDispatcher> get (
+        tstring const & name, unsigned worker_count = 2);
+
+protected:
+    AsyncDispatcher (tstring const & name, unsigned worker_count);
+    virtual ~AsyncDispatcher ();
+
+private:
+    friend class AsyncAppender;
+
+    class Worker;
+    struct Entry;
+
+    //! Registers an appender's queue with this dispatcher.
+    void addQueue (thread::QueuePtr const & queue,
+        AsyncAppenderPtr const & appender);
+
+    //! Unregisters a queue, drains the events still held in it and,
+    //! when it was the last registered queue, stops the worker
+    //! threads and removes the dispatcher from the registry.
+    void removeQueue (thread::QueuePtr const & queue);
+
+    //! Wakes the worker threads up after an event has been enqueued.
+    void notify ();
+
+    //! Scans the registered queues once, starting at \c start, and
+    //! delivers any accumulated batches. Returns true when at least
+    //! one batch was delivered.
+    bool serviceQueues (std::size_t start,
+        thread::Queue::queue_storage_type & buf);
+
+    LOG4CPLUS_PRIVATE void shutdownWorkers ();
+
+    tstring name;
+
+    //! Worker threads servicing the registered queues.
+    std::vector<thread::AbstractThreadPtr> workers;
+
+    //! Signaled by notify() when new events are available.
+    thread::ManualResetEvent wakeup;
+
+    //! Tells the worker threads to exit.
+    std::atomic<bool> workers_exit;
+
+    //! Protects \c entries.
+    thread::Mutex entries_mutex;
+
+    //! The registered queues and their owning appenders.
+    std::vector<std::shared_ptr<Entry> > entries;
+
+    AsyncDispatcher (AsyncDispatcher const &);
+    AsyncDispatcher & operator = (AsyncDispatcher const &);
+};
+
+
+typedef helpers::SharedObjectPtr<AsyncDispatcher> AsyncDispatcherPtr;
+
+
 /**
    This `Appender` is a wrapper to which other appenders can be attached. The
    attached appendres are then appended to from a separate thread which reads
    events appended to this appender from a queue.
 
+   <h3>Properties</h3>
+   <dl>
+   <dt><tt>Appender</tt></dt>
+   <dd>Type of appender to which all events will be forwarded.</dd>
+
+   <dt><tt>QueueLimit</tt></dt>
+   <dd>Maximum number of events that can be queued up.</dd>
+
+   <dt><tt>QueueType</tt></dt>
+   <dd>Type of the events queue. The default value, <tt>"deque"</tt>,
+   selects a mutex-protected <tt>std::deque</tt> based queue
+   (thread::Queue). The value <tt>"ring"</tt> selects a bounded
+   lock-free ring buffer (thread::RingQueue) where producers enqueue
+   with a single compare-and-swap, which avoids mutex contention with
+   many producer threads. The value <tt>"doublebuffer"</tt> selects a
+   double buffered queue (thread::DoubleBufferQueue) with two
+   preallocated buffers of <tt>QueueLimit</tt> events each; the
+   consumer retires the active buffer with a single atomic exchange,
+   so producers never wait while the queue is drained.</dd>
+
+   <dt><tt>OverflowPolicy</tt></dt>
+   <dd>Policy applied when the queue is full. The default value,
+   <tt>"Block"</tt>, makes producers wait until the queue has room.
+   <tt>"DropOldest"</tt> discards the oldest queued event to make room
+   for the incoming one; the <tt>"ring"</tt> and
+   <tt>"doublebuffer"</tt> queue types treat it as
+   <tt>"DropNewest"</tt>. <tt>"DropNewest"</tt> discards the incoming
+   event. <tt>"DropBelowLevel=WARN"</tt> discards the incoming event
+   only when its LogLevel is below the given threshold (WARN when the
+   <tt>=</tt> part is omitted); more severe events still block or are
+   enqueued over the limit. <tt>"SpillToDisk"</tt> serializes
+   overflowing events into the bounded local file named by the
+   <tt>SpillFile</tt> property instead of blocking or dropping them,
+   and replays them to the attached appenders once the sink catches up
+   with the queue again; replayed events may interleave out of order
+   with fresh ones. Only the <tt>"deque"</tt> queue type supports it;
+   the other queue types treat it as <tt>"DropNewest"</tt>. The number
+   of discarded events is available through getDroppedCount().</dd>
+
+   <dt><tt>SpillFile</tt></dt>
+   <dd>Path of the local file backing the <tt>"SpillToDisk"</tt>
+   overflow policy. The file is truncated when the appender is
+   created and removed again when it closes with no events left to
+   replay. This property is required by <tt>"SpillToDisk"</tt> and has
+   no effect with the other overflow policies.</dd>
+
+   <dt><tt>SpillLimitMB</tt></dt>
+   <dd>Bound on the spill file size in MiB. When the bound is reached,
+   the oldest spilled events are discarded first and counted by
+   getDroppedCount(), so an extended sink outage costs bounded disk
+   space instead of unbounded growth. The default is 100.</dd>
+
+   <dt><tt>FastLaneThreshold</tt></dt>
+   <dd>LogLevel, e.g. <tt>"ERROR"</tt>, at or above which events are
+   routed into a separate small, high severity lane that the consumer
+   drains with priority ahead of the bulk queue. This bounds the
+   delivery latency of severe events regardless of how many low
+   severity events are backlogged in front of them. Fast lane events
+   may therefore overtake earlier bulk events at the attached
+   appenders; the monotonic <tt>%R</tt> steady timestamp field can be
+   used to reconcile the order afterwards. When unset (the default),
+   all events go through the single queue in order. The property is
+   ignored, with a warning, when <tt>Dispatcher</tt> is set.</dd>
+
+   <dt><tt>FastLaneLimit</tt></dt>
+   <dd>Maximum number of events the fast lane can hold; producers of
+   high severity events block when it is full. The default is 100.
+   It has no effect without <tt>FastLaneThreshold</tt>.</dd>
+
+   <dt><tt>AdaptiveThreshold</tt></dt>
+   <dd>LogLevel, e.g. <tt>"INFO"</tt>, that becomes the appender's
+   effective threshold while the queue is congested. When the queue
+   occupancy, as reported by getQueueOccupancy(), reaches
+   <tt>AdaptiveHighWatermarkPercent</tt> of <tt>QueueLimit</tt>,
+   events below this LogLevel are discarded at the producer instead
+   of being enqueued, trading DEBUG detail for bounded producer
+   latency; full verbosity is restored once the occupancy falls back
+   to <tt>AdaptiveLowWatermarkPercent</tt>. Discarded events are
+   counted by getDroppedCount(). When unset (the default), no
+   adaptive filtering takes place.</dd>
+
+   <dt><tt>AdaptiveHighWatermarkPercent</tt></dt>
+   <dd>Queue occupancy, in percent of <tt>QueueLimit</tt>, at which
+   the adaptive threshold engages. The default is 80.</dd>
+
+   <dt><tt>AdaptiveLowWatermarkPercent</tt></dt>
+   <dd>Queue occupancy, in percent of <tt>QueueLimit</tt>, at which
+   the adaptive threshold disengages again. Keeping it well below the
+   high watermark provides hysteresis, so that the threshold does not
+   flap around a single boundary. The default is 50.</dd>
+
+   <dt><tt>ShutdownDrainThreshold</tt></dt>
+   <dd>LogLevel, e.g. <tt>"WARN"</tt>, the final drain is restricted
+   to when a deadline bounded shutdown
+   (waitToFinishAsyncLogging(std::chrono::milliseconds)) runs out of
+   budget with events still queued. Events below it are counted by
+   getDroppedCount() instead of being delivered, so the high severity
+   tail of the log still gets out before the process is killed. The
+   default is <tt>WARN</tt>.</dd>
+
+   <dt><tt>Dispatcher</tt></dt>
+   <dd>Name of a shared AsyncDispatcher. When set, the appender does
+   not start a consumer thread of its own; instead its queue is
+   registered with the named dispatcher, whose small worker pool
+   services the queues of all appenders sharing that name. This
+   reduces the thread count in processes with many asynchronous
+   appenders and lets the workers pick up larger batches per wakeup.
+   When unset (the default), the appender runs a dedicated consumer
+   thread as before.</dd>
+
+   <dt><tt>DispatcherWorkers</tt></dt>
+   <dd>Number of worker threads of the shared dispatcher. It is only
+   used by the appender whose configuration creates the dispatcher;
+   appenders joining an existing dispatcher do not change its worker
+   count. The default is 2.</dd>
+
+   <dt><tt>ThreadAffinity</tt></dt>
+   <dd>Comma separated list of CPU indexes the dedicated consumer
+   thread is pinned to, e.g. <tt>"2,3"</tt>. When unset, the thread
+   may run on any CPU. It has no effect on the workers of a shared
+   dispatcher.</dd>
+
+   <dt><tt>ThreadPriority</tt></dt>
+   <dd>Scheduling priority of the dedicated consumer thread, one of
+   <tt>LOWEST</tt>, <tt>BELOW_NORMAL</tt>, <tt>NORMAL</tt>,
+   <tt>ABOVE_NORMAL</tt> and <tt>HIGHEST</tt>. On Windows it maps
+   onto <tt>SetThreadPriority()</tt>; on Linux it is translated into
+   a nice value unless <tt>ThreadNiceValue</tt> is set.</dd>
+
+   <dt><tt>ThreadNiceValue</tt></dt>
+   <dd>Nice value given to the dedicated consumer thread on Linux,
+   between -20 and 19; higher values mean lower priority. Raising it
+   keeps the log drain from competing with latency critical
+   application threads.</dd>
+
+   <dt><tt>ParallelFanout</tt></dt>
+   <dd>Set this property to <tt>true</tt> to deliver drained events
+   to multiple attached appenders concurrently on the shared thread
+   pool instead of one appender after another, so that a drain cycle
+   costs the slowest appender instead of the sum. Each worker formats
+   into its own per thread scratch buffers. Only useful with more
+   than one attached appender. Default is <tt>false</tt>.
+   \sa helpers::AppenderAttachableImpl::setParallelFanout()</dd>
+
+   <dt><tt>LockQueueMemory</tt></dt>
+   <dd>Set this property to <tt>true</tt> to pre-fault and pin
+   (<tt>mlock()</tt>, <tt>VirtualLock()</tt>) the queue's slot
+   storage into RAM at configuration time, so that enqueueing and
+   draining never major-fault on pages evicted under memory
+   pressure. Only the contiguous slot arrays are pinned; the heap
+   storage of the queued events' strings is not. When the storage
+   cannot be locked&mdash;because it exceeds the built-in 64 MiB
+   cap, the process lacks the privilege (e.g.
+   <tt>RLIMIT_MEMLOCK</tt>) or the platform does not support memory
+   locking&mdash;a warning is emitted and the appender continues
+   with unlocked storage. Default is <tt>false</tt>.</dd>
+   </dl>
+
    \sa helpers::AppenderAttachableImpl
  */
 class LOG4CPLUS_EXPORT AsyncAppender
@@ -72,23 +325,156 @@ public:
 
     virtual void close ();
 
+    using Appender::waitToFinishAsyncLogging;
+
+    //! Deadline bounded drain: gives the consumer up to \c budget to
+    //! empty the queue at full fidelity and, when that is not enough,
+    //! restricts the remaining drain to events at or above the
+    //! <tt>ShutdownDrainThreshold</tt> property, counting the rest as
+    //! dropped. A summary of the drain is reported through
+    //! helpers::LogLog. Returns \c true when the queue was fully
+    //! drained within the budget.
+    bool waitToFinishAsyncLogging (std::chrono::milliseconds budget) override;
+
+    //! Returns the number of events discarded by the overflow policy
+    //! so far.
+    std::size_t getDroppedCount () const;
+
+    //! Returns the approximate number of events currently waiting in
+    //! the queue. The figure comes from relaxed atomics, so it is
+    //! cheap enough to consult on every append; applications can use
+    //! it to shed verbosity before the queue fills up.
+    //! \sa the <tt>AdaptiveThreshold</tt> property.
+    std::size_t getQueueOccupancy () const;
+
+    //! Returns true when spilled events are waiting to be persisted
+    //! or replayed. The queue consumer uses it to decide between
+    //! parking on the queue and polling it while it works the spill
+    //! backlog off.
+    bool hasSpillBacklog ();
+
+    //! Delivers a drained batch to the attached appenders. Without a
+    //! spill store this is plain appendLoopOnAppenders(); with one,
+    //! the batch is delivered in chunks with parked overflow flushed
+    //! to disk in between, so that a slow sink cannot keep the spill
+    //! writer away from the parking buffer for a whole batch. It is
+    //! called by the queue's consumer only.
+    void deliverBatch (spi::InternalLoggingEvent const * events,
+        std::size_t count);
+
+    //! Persists the events parked by the SpillToDisk overflow policy
+    //! or, when none are pending, replays a bounded batch of
+    //! previously spilled events to the attached appenders. Returns
+    //! true when it did any work. It is called by the queue's
+    //! consumer only.
+    bool spillMaintenance ();
+
+    //! Delivers all remaining parked and spilled events to the
+    //! attached appenders. It is called when the queue's consumer
+    //! exits.
+    void spillDrain ();
+
+    //! Returns true when the high severity fast lane is enabled.
+    //! \sa the <tt>FastLaneThreshold</tt> property.
+    bool hasFastLane () const;
+
+    //! Drains the fast lane and delivers its events to the attached
+    //! appenders, ahead of whatever the bulk queue holds. Returns
+    //! true when any events were delivered. It is called by the
+    //! queue's consumer only.
+    bool drainFastLane ();
+
+    //! Parks the fast lane consumer until a producer enqueues into
+    //! either lane or \c millis milliseconds elapse. It is called by
+    //! the queue's consumer only.
+    void laneWait (unsigned long millis);
+
 protected:
     virtual void append (spi::InternalLoggingEvent const &);
 
-    void init_queue_thread (unsigned);
+    void init_queue_thread (unsigned,
+        tstring const & queue_type = tstring (),
+        tstring const & overflow_policy = tstring (),
+        tstring const & dispatcher_name = tstring (),
+        unsigned dispatcher_workers = 2,
+        bool lock_queue_memory = false);
 
     thread::AbstractThreadPtr queue_thread;
     thread::QueuePtr queue;
 
+    //! Scheduling options given to the dedicated consumer thread.
+    thread::AbstractThread::SchedulingOptions sched_options;
+
+    //! Shared dispatcher servicing the queue instead of a dedicated
+    //! queue_thread; null unless the Dispatcher property is set.
+    AsyncDispatcherPtr dispatcher;
+
+    //! On-disk overflow store backing the SpillToDisk policy; null
+    //! unless configured.
+    std::unique_ptr<helpers::EventSpill> spill;
+
+    //! Scratch batch holding parked overflow taken from the queue;
+    //! touched by the queue's consumer only.
+    thread::Queue::queue_storage_type spill_buf;
+
+    //! Scratch batch holding spilled events read back for replay;
+    //! separate from spill_buf because replay delivery itself flushes
+    //! parked overflow. Touched by the queue's consumer only.
+    thread::Queue::queue_storage_type replay_buf;
+
+    //! Small high severity lane drained ahead of \c queue; null
+    //! unless the FastLaneThreshold property is set.
+    thread::QueuePtr fast_queue;
+
+    //! Minimum LogLevel routed into \c fast_queue.
+    LogLevel fast_lane_threshold = NOT_SET_LOG_LEVEL;
+
+    //! Signaled by producers of either lane; the fast lane consumer
+    //! parks on it instead of the bulk queue's event object, because
+    //! it must wake up for events in either lane.
+    thread::ManualResetEvent lane_wakeup;
+
+    //! Scratch batch holding drained fast lane events; touched by
+    //! the queue's consumer only.
+    thread::Queue::queue_storage_type fast_buf;
+
+    //! LogLevel below which events are shed at the producer while the
+    //! queue is congested; NOT_SET_LOG_LEVEL unless the
+    //! AdaptiveThreshold property is set.
+    LogLevel adaptive_threshold = NOT_SET_LOG_LEVEL;
+
+    //! Queue occupancy at which the adaptive threshold engages.
+    std::size_t adaptive_high_mark = 0;
+
+    //! Queue occupancy at which the adaptive threshold disengages.
+    std::size_t adaptive_low_mark = 0;
+
+    //! True while the adaptive threshold is engaged.
+    std::atomic<bool> adaptive_engaged {false};
+
+    //! LogLevel the final drain is restricted to when the shutdown
+    //! budget runs out; set by the ShutdownDrainThreshold property.
+    LogLevel shutdown_drain_threshold = WARN_LOG_LEVEL;
+
+    //! Steady clock deadline, in microseconds since the steady
+    //! clock's epoch, past which deliverBatch() restricts delivery to
+    //! events at or above shutdown_drain_threshold; 0 until a
+    //! budgeted shutdown arms it. A deadline rather than a flag, so
+    //! that the cutoff also engages in the middle of a batch the
+    //! consumer had already taken out of the queue.
+    std::atomic<long long> drain_deadline_us {0};
+
+private:
+    //! Takes the parked overflow and writes it to the spill store in
+    //! one sequential write. Returns true when there was any.
+    LOG4CPLUS_PRIVATE bool spillWritePending ();
+
 private:
     AsyncAppender (AsyncAppender const &);
     AsyncAppender & operator = (AsyncAppender const &);
 };
 
 
-typedef helpers::SharedObjectPtr<AsyncAppender> AsyncAppenderPtr;
-
-
 } // namespace log4cplus
 
 
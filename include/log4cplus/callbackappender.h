@@ -48,6 +48,8 @@ class LOG4CPLUS_EXPORT CallbackAppender
 public:
     CallbackAppender();
     CallbackAppender(log4cplus_log_event_callback_t callback, void * cookie);
+    CallbackAppender(log4cplus_log_event_callback_v2_t callback,
+        void * cookie);
     CallbackAppender(const log4cplus::helpers::Properties&);
 
     virtual ~CallbackAppender();
@@ -55,13 +57,18 @@ public:
 
     void setCookie(void *);
     void setCallback(log4cplus_log_event_callback_t);
+    //! Sets a v2 callback receiving a borrowed
+    //! log4cplus_log_event_view_t instead of individual arguments;
+    //! it takes precedence over a v1 callback when both are set.
+    void setCallbackV2(log4cplus_log_event_callback_v2_t);
 
 protected:
     virtual void append(const log4cplus::spi::InternalLoggingEvent& event);
 
 private:
-    log4cplus_log_event_callback_t callback;
-    void * cookie;
+    log4cplus_log_event_callback_t callback = nullptr;
+    log4cplus_log_event_callback_v2_t callback_v2 = nullptr;
+    void * cookie = nullptr;
 
     // Disallow copying of instances of this class
     CallbackAppender(const CallbackAppender&) = delete;
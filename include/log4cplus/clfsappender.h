@@ -76,6 +76,12 @@ public:
 protected:
     virtual void append (spi::InternalLoggingEvent const &);
 
+    /** Reserves space for a run of records at once and appends them
+     *  through a single ReserveAndAppendLog() call per run, flushing
+     *  the marshaling area once at the end of the batch. */
+    virtual void appendBatch (spi::InternalLoggingEvent const * events,
+        std::size_t count);
+
     void init (tstring const & logname, unsigned long logsize,
         unsigned long buffersize);
 
@@ -33,6 +33,8 @@
 #pragma once
 #endif
 
+#include <stddef.h>
+
 
 #ifdef __cplusplus
 extern "C"
@@ -101,6 +103,46 @@ LOG4CPLUS_EXPORT int log4cplus_logger_force_log(const log4cplus_char_t *name,
 LOG4CPLUS_EXPORT int log4cplus_logger_force_log_str(const log4cplus_char_t *name,
     log4cplus_loglevel_t ll, const log4cplus_char_t *msg);
 
+/**
+ * Opaque handle to a resolved logger. The name based functions above
+ * look the logger up by name on every call; callers that log
+ * frequently should acquire a handle once with log4cplus_logger_get()
+ * and use the log4cplus_hlogger_* functions instead, which skip the
+ * per-call name conversion and hierarchy lookup. A handle stays valid
+ * until it is released with log4cplus_logger_release() and may be
+ * shared between threads.
+ */
+typedef void * log4cplus_logger_handle_t;
+
+/** Resolves the logger \a name (or the root logger when \a name is
+ * NULL) and returns a handle to it, or NULL on failure. */
+LOG4CPLUS_EXPORT log4cplus_logger_handle_t log4cplus_logger_get(
+    const log4cplus_char_t *name);
+
+/** Releases a handle obtained from log4cplus_logger_get(). */
+LOG4CPLUS_EXPORT int log4cplus_logger_release(log4cplus_logger_handle_t logger);
+
+/** Level check backed by the logger's cached effective log level;
+ * cheap enough to guard every emitted line. */
+LOG4CPLUS_EXPORT int log4cplus_hlogger_is_enabled_for(
+    log4cplus_logger_handle_t logger, log4cplus_loglevel_t ll);
+
+LOG4CPLUS_EXPORT int log4cplus_hlogger_log(log4cplus_logger_handle_t logger,
+    log4cplus_loglevel_t ll, const log4cplus_char_t *msgfmt, ...)
+    LOG4CPLUS_FORMAT_ATTRIBUTE (__printf__, 3, 4);
+
+LOG4CPLUS_EXPORT int log4cplus_hlogger_log_str(log4cplus_logger_handle_t logger,
+    log4cplus_loglevel_t ll, const log4cplus_char_t *msg);
+
+LOG4CPLUS_EXPORT int log4cplus_hlogger_force_log(
+    log4cplus_logger_handle_t logger, log4cplus_loglevel_t ll,
+    const log4cplus_char_t *msgfmt, ...)
+    LOG4CPLUS_FORMAT_ATTRIBUTE (__printf__, 3, 4);
+
+LOG4CPLUS_EXPORT int log4cplus_hlogger_force_log_str(
+    log4cplus_logger_handle_t logger, log4cplus_loglevel_t ll,
+    const log4cplus_char_t *msg);
+
 //! CallbackAppender callback type.
 typedef void (* log4cplus_log_event_callback_t)(void * cookie,
     log4cplus_char_t const * message, log4cplus_char_t const * loggerName,
@@ -113,6 +155,42 @@ LOG4CPLUS_EXPORT int log4cplus_add_callback_appender(
     const log4cplus_char_t * logger, log4cplus_log_event_callback_t callback,
     void * cookie);
 
+/**
+ * Borrowed view of one log event, handed to v2 callbacks. All
+ * pointers reference storage owned by the event being appended and
+ * are valid only for the duration of the callback; the strings are
+ * NUL terminated and their lengths are provided so that consumers
+ * need not call strlen(). Copy whatever must outlive the call.
+ */
+typedef struct log4cplus_log_event_view
+{
+    log4cplus_char_t const * message;
+    size_t message_len;
+    log4cplus_char_t const * logger_name;
+    size_t logger_name_len;
+    log4cplus_loglevel_t ll;
+    log4cplus_char_t const * thread;
+    size_t thread_len;
+    log4cplus_char_t const * thread2;
+    size_t thread2_len;
+    unsigned long long timestamp_secs;
+    unsigned long timestamp_usecs;
+    log4cplus_char_t const * file;
+    size_t file_len;
+    log4cplus_char_t const * function_name;
+    size_t function_name_len;
+    int line;
+} log4cplus_log_event_view_t;
+
+//! CallbackAppender v2 callback type. The view and everything it
+//! points to is only valid until the callback returns.
+typedef void (* log4cplus_log_event_callback_v2_t)(void * cookie,
+    log4cplus_log_event_view_t const * event);
+
+LOG4CPLUS_EXPORT int log4cplus_add_callback_appender_v2(
+    const log4cplus_char_t * logger,
+    log4cplus_log_event_callback_v2_t callback, void * cookie);
+
 // Custom LogLevel
 LOG4CPLUS_EXPORT int log4cplus_add_log_level(unsigned int ll,
     const log4cplus_char_t *ll_name);
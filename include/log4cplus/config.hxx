@@ -32,9 +32,14 @@
 #  include <log4cplus/config/defines.hxx>
 #endif
 
+#if defined (LOG4CPLUS_UTF8_NATIVE) && ! defined (_WIN32)
+#  error "LOG4CPLUS_UTF8_NATIVE is only meaningful on Windows."
+#endif
+
 # if ! defined (LOG4CPLUS_WORKING_LOCALE) \
   && ! defined (LOG4CPLUS_WORKING_C_LOCALE) \
-  && ! defined (LOG4CPLUS_WITH_ICONV)
+  && ! defined (LOG4CPLUS_WITH_ICONV) \
+  && ! defined (LOG4CPLUS_UTF8_NATIVE)
 # define LOG4CPLUS_POOR_MANS_CHCONV
 #endif
 
@@ -127,13 +132,23 @@
 #  define LOG4CPLUS_ATTRIBUTE_NORETURN __attribute__ ((__noreturn__))
 #  define LOG4CPLUS_ATTRIBUTE_PURE __attribute__ ((__pure__))
 #  define LOG4CPLUS_ATTRIBUTE_DEPRECATED __attribute__ ((__deprecated__))
+#  define LOG4CPLUS_ATTRIBUTE_NOINLINE __attribute__ ((__noinline__))
 #  define LOG4CPLUS_BUILTIN_EXPECT(exp, c) __builtin_expect ((exp), (c))
+#elif defined (_MSC_VER)
+#  if ! defined (LOG4CPLUS_ATTRIBUTE_NORETURN)
+#    define LOG4CPLUS_ATTRIBUTE_NORETURN /* empty */
+#  endif
+#  define LOG4CPLUS_ATTRIBUTE_PURE /* empty */
+#  define LOG4CPLUS_ATTRIBUTE_DEPRECATED /* empty */
+#  define LOG4CPLUS_ATTRIBUTE_NOINLINE __declspec (noinline)
+#  define LOG4CPLUS_BUILTIN_EXPECT(exp, c) (exp)
 #else
 #  if ! defined (LOG4CPLUS_ATTRIBUTE_NORETURN)
 #    define LOG4CPLUS_ATTRIBUTE_NORETURN /* empty */
 #  endif
 #  define LOG4CPLUS_ATTRIBUTE_PURE /* empty */
 #  define LOG4CPLUS_ATTRIBUTE_DEPRECATED /* empty */
+#  define LOG4CPLUS_ATTRIBUTE_NOINLINE /* empty */
 #  define LOG4CPLUS_BUILTIN_EXPECT(exp, c) (exp)
 #endif
 
@@ -181,6 +196,19 @@
 #if defined(__cplusplus)
 #include <cstddef>
 
+// Detect C++20 std::format. When it is available, the *_STDFMT
+// logging macros and the std::format based Logger::log() overload
+// become available as an alternative to the printf style *_FMT
+// macros.
+#if defined (__has_include)
+#  if __has_include (<version>)
+#    include <version>
+#    if defined (__cpp_lib_format) && __cpp_lib_format >= 201907L
+#      define LOG4CPLUS_HAVE_STD_FORMAT 1
+#    endif
+#  endif
+#endif
+
 namespace log4cplus
 {
 
@@ -196,6 +224,33 @@ LOG4CPLUS_EXPORT void threadCleanup ();
 //! \note using `log4cplus::Initializer` is preferred
 LOG4CPLUS_EXPORT void initialize ();
 
+//! Initializes log4cplus and in addition eagerly constructs the
+//! components that are otherwise created on first use: the factory
+//! registries and the asynchronous logging thread pool. Long-running
+//! services can call this during start up to move the cost out of the
+//! first logging call; short-lived tools should prefer plain
+//! initialization, which keeps the unused pieces lazy.
+LOG4CPLUS_EXPORT void preinitialize ();
+
+//! Fast path for resuming logging in a child process after `fork()`.
+//! The child inherits the configured hierarchy, appenders and log
+//! levels, but none of the parent's threads. Call this in the child
+//! (e.g. from a `pthread_atfork()` child handler) instead of a full
+//! re-configuration: it discards the inherited asynchronous logging
+//! thread pool, so that the next asynchronous append starts fresh
+//! worker threads, and resets the calling thread's cached thread
+//! name, so that events are stamped with the child's thread id.
+//! Threads owned by individual objects -- `ConfigureAndWatchThread`,
+//! `SocketAppender`'s connector and sender threads -- are not
+//! restarted; recreate those objects in the child if it needs them.
+//! It also bumps the internal process generation number, which makes
+//! pattern layouts re-render their cached `%i` process id and `%h`
+//! hostname output with the child's values.
+//! The usual `fork()` caveat applies: no other thread of the parent
+//! may be logging at the point of fork, otherwise mutex state
+//! inherited by the child is undefined.
+LOG4CPLUS_EXPORT void atForkChild ();
+
 //! Deinitializes log4cplus.
 //!
 //! \note using `log4cplus::Initializer` is preferred
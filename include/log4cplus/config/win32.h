@@ -182,6 +182,24 @@
 #  define LOG4CPLUS_HAVE_FUNCTION_MACRO
 #endif // __BORLANDC__
 
+// LOG4CPLUS_UTF8_NATIVE selects the UTF-8 native narrow build: tchar
+// stays char and all narrow strings are treated as UTF-8 instead of
+// the ANSI code page. Events are stored and shipped in UTF-8, which
+// halves their memory compared to the UNICODE build and lets the
+// socket and file appenders write them without any transcoding; only
+// the sinks that must speak UTF-16 (console, debugger, event log)
+// convert, right at the API call, through the CP_UTF8 conversion
+// backend in stringhelper-win32utf8.cxx.
+#if defined (LOG4CPLUS_UTF8_NATIVE)
+#  if defined (UNICODE)
+#    error "LOG4CPLUS_UTF8_NATIVE requires a narrow (non-UNICODE) build."
+#  endif
+// The locale backends would interpret narrow strings in the ANSI code
+// page; the CP_UTF8 backend replaces them.
+#  undef LOG4CPLUS_WORKING_LOCALE
+#  undef LOG4CPLUS_WORKING_C_LOCALE
+#endif
+
 #if ! defined (LOG4CPLUS_DISABLE_DLL_RUNTIME_WARNING)
 #  if defined (LOG4CPLUS_STATIC) && defined (_MSC_VER) && ! defined (_DLL)
 #    pragma message("You are not using DLL C run time library. " \
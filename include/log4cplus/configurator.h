@@ -36,12 +36,18 @@
 #include <log4cplus/helpers/property.h>
 
 #include <map>
+#include <vector>
 
 
 namespace log4cplus
 {
     class Hierarchy;
 
+    namespace spi
+    {
+        class AppenderFactory;
+    }
+
 
     /**
      * Provides configuration from an external file.  See configure() for
@@ -90,6 +96,24 @@ namespace log4cplus
 #if defined (LOG4CPLUS_HAVE_CODECVT_UTF32_FACET) && defined (UNICODE)
             , fUTF32              = (3 << fEncodingShift)
 #endif
+
+            // The encoding options above occupy bits 3 and 4.
+
+            /**
+             * Maintain a pre-parsed binary cache of the
+             * configuration next to the source file (a
+             * <tt>.l4ccache</tt> sidecar). When the sidecar exists
+             * and its recorded mtime and size still match the source
+             * file, the text parse (including <code>include</code>
+             * directives) is replaced by a few binary reads;
+             * otherwise the file is parsed and the sidecar
+             * rewritten. The cached values are captured before
+             * environment variable substitution, so
+             * <code>${...}</code> references still resolve against
+             * the current environment. Touch the top level file
+             * after editing included files to invalidate the cache.
+             */
+            , fUseConfigCache     = (1 << 5)
         };
 
         // ctor and dtor
@@ -202,6 +226,23 @@ namespace log4cplus
          * Property <pre>log4cplus.threadPoolSize</pre> can be used to adjust
          * size of log4cplus' internal thread pool.
          *
+         * Property <pre>log4cplus.coarseTimestampGranularityMillis</pre>
+         * selects coarse event timestamps: a nonzero value (capped at
+         * 1000) makes event timestamps come from a cached value
+         * refreshed by a background thread at roughly that many
+         * milliseconds, instead of querying the system clock for each
+         * event. The value 0 (the default) keeps exact timestamps.
+         *
+         * Property <pre>log4cplus.memoryBudget</pre> sets a process
+         * wide byte budget for memory owned by logging (queued events
+         * of asynchronous appenders and file appender stream
+         * buffers). The value accepts <pre>MB</pre> and <pre>KB</pre>
+         * suffixes. While usage exceeds the budget, the asynchronous
+         * queues shed events below the LogLevel given by
+         * <pre>log4cplus.memoryBudgetShedBelowLevel</pre> (WARN by
+         * default) instead of queueing them. Without this property no
+         * budget is enforced.
+         *
          * <h3>Example</h3>
          *
          * An example configuration is given below.
@@ -287,11 +328,24 @@ namespace log4cplus
       // Methods
         void init();  // called by the ctor
         void reconfigure();
+
+        /**
+         * Re-reads the property file and applies it by diffing
+         * against the currently applied configuration. Appender
+         * instances whose definitions did not change are kept alive
+         * and re-attached instead of being closed and recreated, so
+         * e.g. FileAppender streams and socket connections of
+         * unchanged appenders stay open across a configuration push.
+         * Only stale appenders are closed. Used by
+         * ConfigureAndWatchThread.
+         */
+        void reconfigureIncrementally();
         void replaceEnvironVariables();
         void configureLoggers();
         void configureLogger(log4cplus::Logger logger, const log4cplus::tstring& config);
         void configureAppenders();
         void configureAdditivity();
+        void configureMaxMessageSizes();
 
         virtual Logger getLogger(const log4cplus::tstring& name);
         virtual void addAppender(Logger &logger, log4cplus::SharedAppenderPtr& appender);
@@ -299,6 +353,20 @@ namespace log4cplus
       // Types
         typedef std::map<log4cplus::tstring, log4cplus::SharedAppenderPtr> AppenderMap;
 
+        /**
+         * One appender definition compiled from the properties: the
+         * factory is resolved to a direct reference and the
+         * per-appender property subset is extracted once, so that
+         * repeated configure passes over the same properties skip
+         * both the registry lookup and the property re-tokenization.
+         */
+        struct CompiledAppenderDef
+        {
+            log4cplus::tstring name;
+            spi::AppenderFactory * factory;
+            log4cplus::helpers::Properties props;
+        };
+
       // Data
         Hierarchy& h;
         log4cplus::tstring propertyFilename;
@@ -306,6 +374,12 @@ namespace log4cplus
         AppenderMap appenders;
         unsigned flags;
 
+        //! Appender definitions compiled by the first
+        //! configureAppenders() pass; discarded by init() whenever
+        //! the properties are reloaded.
+        std::vector<CompiledAppenderDef> compiledAppenderDefs;
+        bool compiledAppenderDefsValid = false;
+
     private:
       // Disable copy
         PropertyConfigurator(const PropertyConfigurator&);
@@ -356,6 +430,16 @@ namespace log4cplus
     class ConfigurationWatchDogThread;
 
 
+    /**
+     * Watches a properties file and reconfigures the hierarchy when
+     * the file changes. On platforms with kernel file change
+     * notification (inotify) changes are applied as soon as the
+     * kernel reports them and the thread does not wake up otherwise;
+     * elsewhere, and when the watch cannot be established, the file
+     * is polled every <code>millis</code> milliseconds. With
+     * notification available the interval only bounds how long a
+     * missed event could go unnoticed.
+     */
     class LOG4CPLUS_EXPORT ConfigureAndWatchThread {
     public:
       // ctor and dtor
@@ -31,6 +31,9 @@
 #endif
 
 #include <log4cplus/appender.h>
+#include <log4cplus/thread/syncprims.h>
+#include <log4cplus/thread/threads.h>
+#include <atomic>
 
 namespace log4cplus {
     /**
@@ -47,7 +50,26 @@ namespace log4cplus {
      * <dt><tt>ImmediateFlush</tt></dt>
      * <dd>When it is set true, output stream will be flushed after
      * each appended event.</dd>
-     * 
+     *
+     * <dt><tt>OutputEncoding</tt></dt>
+     * <dd>Selects how formatted events reach the console. The default
+     * value <tt>locale</tt> writes through the locale aware
+     * <code>tcout</code>/<code>tcerr</code> streams, which perform a
+     * codecvt conversion per event in wide character builds. The value
+     * <tt>UTF-8</tt> instead formats the event into a per thread
+     * buffer, converts it to UTF-8 once using the library's cached
+     * string converters and writes the resulting bytes directly to
+     * <code>std::cout</code>/<code>std::cerr</code>.</dd>
+     *
+     * <dt><tt>AsyncFlushIntervalMillis</tt></dt>
+     * <dd>Non-zero value of this property starts a background thread
+     * that flushes the output stream periodically, coalescing the
+     * per-event flushes of <tt>ImmediateFlush</tt> into one flush per
+     * interval. The interval adapts between the given value and one
+     * eighth of it, the same way as for FileAppender. The property is
+     * ignored in single threaded builds.
+     * </dd>
+     *
      * </dl>
      * \sa Appender
      */
@@ -77,6 +99,39 @@ namespace log4cplus {
          * will be flushed at the end of each append operation.
          */
         bool immediateFlush;
+
+        /**
+         * When true, events are converted to UTF-8 once per event and
+         * written as bytes to the narrow standard streams, bypassing
+         * the per character codecvt conversion of the locale aware
+         * streams. Set by the <tt>OutputEncoding</tt> property.
+         */
+        bool utf8Output = false;
+
+        /**
+         * Non-zero value enables the background flusher thread and
+         * gives the longest interval between its flushes, in
+         * milliseconds.
+         */
+        unsigned long asyncFlushIntervalMillis = 0;
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        class FlusherThread;
+
+        LOG4CPLUS_PRIVATE void initFlusher ();
+
+        thread::AbstractThreadPtr flusher_thread;
+
+        //! Signaled to wake the flusher thread up early, e.g. on
+        //! close().
+        thread::ManualResetEvent flusher_wakeup;
+
+        //! Tells the flusher thread to exit.
+        std::atomic<bool> flusher_exit {false};
+
+        //! Number of events appended since the last background flush.
+        std::atomic<unsigned long> appends_since_flush {0};
+#endif
     };
 
 } // end namespace log4cplus
@@ -0,0 +1,83 @@
+// -*- C++ -*-
+//  Copyright (C) 2009-2017, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file
+ * Async-signal-safe emergency logging ring.
+ *
+ * None of the regular logging pipeline may be used from signal
+ * handlers; it takes locks, allocates and runs user supplied
+ * layouts. The functions here provide a tiny escape hatch for crash
+ * handlers: a pre-allocated, locked-in-memory ring buffer that is
+ * written with only atomics and memcpy, and that can either be
+ * dumped from the crashing signal handler with raw write() or be
+ * drained through the configured appenders once the process has
+ * recovered. */
+
+#ifndef LOG4CPLUS_EMERGENCYLOG_HEADER_
+#define LOG4CPLUS_EMERGENCYLOG_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <cstddef>
+#include <log4cplus/loglevel.h>
+#include <log4cplus/logger.h>
+
+
+namespace log4cplus
+{
+
+//! Records \c msg with level \c ll into the emergency ring. This
+//! function is async-signal-safe: it does not lock, allocate or
+//! touch pageable memory and may be called from signal handlers,
+//! including handlers for synchronous signals such as \c SIGSEGV.
+//! \c msg should be a literal or otherwise valid narrow string; it
+//! is truncated to the fixed slot size. When the ring wraps, the
+//! oldest unread entries are overwritten.
+LOG4CPLUS_EXPORT void emergency_log (LogLevel ll,
+    char const * msg) LOG4CPLUS_NOEXCEPT;
+
+//! Writes all entries currently in the emergency ring to the file
+//! descriptor \c fd using raw write(), one line per entry, oldest
+//! first. Like emergency_log(), this function is async-signal-safe
+//! and is meant to be called from a crash handler, typically with
+//! the descriptor returned by FileAppenderBase::getFileDescriptor().
+//! Entries are not consumed; a later emergency_log_drain() sees them
+//! too. \return the number of entries written.
+LOG4CPLUS_EXPORT std::size_t emergency_log_dump (
+    int fd) LOG4CPLUS_NOEXCEPT;
+
+//! Feeds the entries recorded since the last drain through \c logger
+//! so that they reach the configured appenders. This function is
+//! \em not async-signal-safe; call it from normal context after the
+//! signal handler has returned, e.g. at the top of the event loop or
+//! from a watchdog thread. \return the number of entries delivered.
+LOG4CPLUS_EXPORT std::size_t emergency_log_drain (Logger logger);
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_EMERGENCYLOG_HEADER_
@@ -0,0 +1,106 @@
+// -*- C++ -*-
+// Module:  Log4CPLUS
+// File:    executor.h
+//
+//  Copyright (C) 2026, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_EXECUTOR_HEADER_
+#define LOG4CPLUS_EXECUTOR_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <functional>
+#include <memory>
+
+
+namespace log4cplus
+{
+
+    /**
+     * Interface for scheduling the library's task shaped background
+     * work. The library submits the <tt>AsyncAppend</tt> delivery
+     * tasks and the parallel fan-out workers through the installed
+     * executor; by default they run on the built-in shared thread
+     * pool (see setThreadPoolSize()).
+     *
+     * Applications that already operate their own worker pool can
+     * install an adapter through setExecutor() so that the process
+     * does not run a second pool just for logging. The injected
+     * executor must tolerate tasks that block briefly (appender I/O)
+     * and must keep executing tasks until drain() has completed
+     * during shutdown.
+     *
+     * Long lived service loops (the socket re-connector thread and
+     * the configuration watch thread) are not routed through the
+     * executor; they block indefinitely and would starve a bounded
+     * pool.
+     */
+    class LOG4CPLUS_EXPORT Executor
+    {
+    public:
+        virtual ~Executor () = 0;
+
+        /**
+         * Schedules \c task for asynchronous execution. Tasks
+         * submitted from one thread may execute concurrently and in
+         * any order.
+         */
+        virtual void execute (std::function<void ()> task) = 0;
+
+        /**
+         * Blocks until every task submitted so far has finished
+         * executing. Called when flushing asynchronous logging and
+         * during shutdown.
+         */
+        virtual void drain () = 0;
+    };
+
+
+    /**
+     * Installs \c executor as the scheduler for the library's
+     * background tasks. Passing an empty pointer reverts to the
+     * built-in shared thread pool. The previously installed executor
+     * is drained by the caller's responsibility; install a
+     * replacement only while no asynchronous logging is in flight.
+     *
+     * This function has no effect in single threaded builds.
+     */
+    LOG4CPLUS_EXPORT void setExecutor (std::shared_ptr<Executor> executor);
+
+    /**
+     * Returns the installed executor or an empty pointer when the
+     * built-in shared thread pool is in use.
+     */
+    LOG4CPLUS_EXPORT std::shared_ptr<Executor> getExecutor ();
+
+} // namespace log4cplus
+
+
+#endif // LOG4CPLUS_EXECUTOR_HEADER_
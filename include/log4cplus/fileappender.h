@@ -32,11 +32,18 @@
 
 #include <log4cplus/appender.h>
 #include <log4cplus/fstreams.h>
+#include <log4cplus/streams.h>
 #include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/helpers/lockfile.h>
+#include <log4cplus/thread/syncprims.h>
+#include <log4cplus/thread/threads.h>
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <sstream>
 #include <locale>
 #include <memory>
+#include <vector>
 
 
 namespace log4cplus
@@ -65,11 +72,77 @@ namespace log4cplus
      * to reopen log file again, after last logging failure.
      * </dd>
      *
+     * <dt><tt>ReopenMode</tt></dt>
+     * <dd>Controls how requestReopen() picks up a rotation done by an
+     * external tool such as logrotate. The default, <tt>inline</tt>,
+     * closes and reopens the stream on the next append. With
+     * <tt>atomic</tt>, a replacement stream is prepared by a
+     * background task and only swapped in under the appender mutex,
+     * so the logging path pays microseconds even when
+     * <tt>open()</tt> is slow, e.g. on network filesystems. The
+     * property is ignored by the memory mapped, io_uring and direct
+     * I/O output modes of FileAppender and in single threaded
+     * builds.</dd>
+     *
      * <dt><tt>BufferSize</tt></dt>
      * <dd>Non-zero value of this property sets up buffering of output
      * stream using a buffer of given size.
      * </dd>
      *
+     * <dt><tt>AdaptiveBuffering</tt></dt>
+     * <dd>When this property is true, the output stream buffer is
+     * resized on the fly: it doubles while events arrive faster than
+     * the current buffer can absorb and halves again after a quiet
+     * period. The buffer starts at <tt>BufferSize</tt> when that is
+     * set and at a small default otherwise. Buffers are drawn from a
+     * pool shared by all file appenders in the process, so many
+     * mostly idle appenders do not each pin a maximal buffer.
+     * </dd>
+     *
+     * <dt><tt>AdaptiveBufferMaxSize</tt></dt>
+     * <dd>Upper bound in bytes for the adaptive buffer. The default
+     * is 1 MiB. The property is only used when
+     * <tt>AdaptiveBuffering</tt> is set to true.
+     * </dd>
+     *
+     * <dt><tt>AsyncFlushIntervalMillis</tt></dt>
+     * <dd>Non-zero value of this property starts a background thread
+     * that flushes the output stream periodically, so that
+     * <tt>ImmediateFlush</tt> can be turned off without risking long
+     * data loss windows. The interval adapts between the given value
+     * and one eighth of it: it shortens while events arrive in bursts
+     * and backs off to the full value when the appender is idle. The
+     * property is ignored in single threaded builds.
+     * </dd>
+     *
+     * <dt><tt>SyncPolicy</tt></dt>
+     * <dd>Controls how often the appender forces its output to
+     * stable storage with <tt>fsync()</tt>, implementing group
+     * commit for audit-grade durability at a fraction of the cost of
+     * syncing every event. The default, <tt>none</tt>, never syncs.
+     * <tt>interval:&lt;ms&gt;</tt> syncs at most once per the given
+     * number of milliseconds and <tt>group:&lt;n&gt;</tt> once per
+     * <tt>n</tt> appended events; either way one <tt>fsync()</tt>
+     * covers the whole group of events written since the previous
+     * one. Critical events can wait on the commit through
+     * logAndSync(). The policy is ignored by the memory mapped,
+     * io_uring and direct I/O output modes of FileAppender and on
+     * platforms without <tt>fsync()</tt>.
+     * </dd>
+     *
+     * <dt><tt>PreOpenRolloverFile</tt></dt>
+     * <dd>When this property is true, a background thread keeps the
+     * next rollover target pre-created, pre-allocated with
+     * <tt>fallocate()</tt> where the platform supports it, and
+     * pre-opened, so that rollover renames the spare file into place
+     * and swaps streams instead of waiting for <tt>open()</tt>, which
+     * can take tens of milliseconds on network filesystems while the
+     * appender is locked. The property is only used by
+     * {@link RollingFileAppender} and
+     * {@link TimeBasedRollingFileAppender}, requires the <tt>File</tt>
+     * property, is not compatible with <tt>UseLockFile</tt> and is
+     * ignored in single threaded builds.</dd>
+     *
      * <dt><tt>UseLockFile</tt></dt>
      * <dd>Set this property to <tt>true</tt> if you want your output
      * to go into a log file shared by multiple processes. When this
@@ -112,6 +185,33 @@ namespace log4cplus
      * not translate EOLs to OS specific character sequence. The default value
      * is <tt>Text</tt> and the underlying stream will be opened in text
      * mode.</dd>
+     *
+     * <dt><tt>RecordFraming</tt></dt>
+     * <dd>When this property is true, every formatted event is
+     * written as a self describing record: an 8 digit hexadecimal
+     * payload length (in characters), an 8 digit hexadecimal CRC32C
+     * checksum of the payload bytes and the payload itself, separated
+     * by single spaces and terminated by a newline. Readers can
+     * verify each record and skip a torn tail left behind by a crash
+     * in O(1) instead of scanning for damage. The checksum uses the
+     * SSE4.2 CRC32 instruction when the build targets it. The
+     * property is ignored by the memory mapped, io_uring and direct
+     * I/O output modes of FileAppender.</dd>
+     *
+     * <dt><tt>LockBuffer</tt></dt>
+     * <dd>Set this property to <tt>true</tt> to pre-fault and pin
+     * (<tt>mlock()</tt>, <tt>VirtualLock()</tt>) the stream buffer
+     * given by <tt>BufferSize</tt> into RAM at configuration time,
+     * so that appends never major-fault on buffer pages evicted
+     * under memory pressure. It implies a fixed size buffer and
+     * therefore disables <tt>AdaptiveBuffering</tt>, because locked
+     * pages must not cycle through the shared buffer pool. When the
+     * buffer cannot be locked&mdash;because it exceeds the built-in
+     * 64 MiB cap, the process lacks the privilege (e.g.
+     * <tt>RLIMIT_MEMLOCK</tt>) or the platform does not support
+     * memory locking&mdash;a warning is emitted and the appender
+     * continues with an unlocked buffer. It has no effect without
+     * <tt>BufferSize</tt>.</dd>
      * </dl>
      */
     class LOG4CPLUS_EXPORT FileAppenderBase : public Appender {
@@ -126,6 +226,35 @@ namespace log4cplus
       //! \returns Locale imbued in fstream.
         virtual std::locale getloc () const;
 
+      //! \returns OS file descriptor opened in append mode on the
+      //! same file as the appender's stream, or -1 when the file is
+      //! not open or the platform does not support it. The
+      //! descriptor stays valid until close() or reopen and is
+      //! intended for crash handlers that dump the emergency logging
+      //! ring with raw write(); writes through it bypass the stream
+      //! buffer entirely. \sa emergency_log_dump()
+        int getFileDescriptor () const;
+
+      //! Requests that the log file be closed and reopened on the
+      //! next append, picking up a rename done by an external
+      //! rotation tool. No event is lost or lands in the renamed
+      //! file after the switch: the buffered tail is flushed to the
+      //! old file first. With <tt>ReopenMode=atomic</tt> the
+      //! replacement stream is prepared in the background and only a
+      //! stream swap happens on the logging path. Not
+      //! async-signal-safe; call it from the thread that handles the
+      //! rotation signal, not from the signal handler itself.
+        virtual void requestReopen ();
+
+      //! Appends \c event like doAppend() and then forces a group
+      //! commit: when the call returns, the event--and every event
+      //! written before it--has been handed to stable storage with
+      //! <tt>fsync()</tt>. Intended for the few critical events of
+      //! an audit trail that must not wait for the next scheduled
+      //! commit of the <tt>SyncPolicy</tt> property; it works (and
+      //! syncs) even with <tt>SyncPolicy=none</tt>.
+        virtual void logAndSync (const spi::InternalLoggingEvent& event);
+
     protected:
       // Ctors
         FileAppenderBase(const log4cplus::tstring& filename,
@@ -139,9 +268,38 @@ namespace log4cplus
 
         virtual void append(const spi::InternalLoggingEvent& event);
 
+        virtual void appendBatch(const spi::InternalLoggingEvent* events,
+            std::size_t count);
+
         virtual void open(std::ios_base::openmode mode);
         bool reopen();
 
+        //! Writes the layout's cached header (Layout::getHeader())
+        //! to the stream when the just opened file is empty. Called
+        //! by open() and after a spare file is adopted; reopening an
+        //! already written file in append mode leaves it alone.
+        void writeHeader();
+
+        //! Writes the layout's cached footer (Layout::getFooter())
+        //! to the stream; called before the stream is closed for
+        //! good by close() or for a rollover.
+        void writeFooter();
+
+        //! Cold path of the stream health check in append() and
+        //! appendBatch(): tries to reopen the stream and reports
+        //! through the error handler, keeping the reopen and message
+        //! building code out of the hot path. Returns false when the
+        //! stream could not be recovered.
+        LOG4CPLUS_PRIVATE LOG4CPLUS_ATTRIBUTE_NOINLINE
+        bool recoverStream();
+
+        //! Formats \c event and writes it as one length and CRC32C
+        //! framed record. Returns the number of characters written,
+        //! so size tracking subclasses can account for the framing
+        //! overhead. \sa the <tt>RecordFraming</tt> property.
+        LOG4CPLUS_PRIVATE std::size_t appendFramed(
+            const spi::InternalLoggingEvent& event);
+
       // Data
         /**
          * Immediate flush means that the underlying writer or output stream
@@ -177,7 +335,53 @@ namespace log4cplus
         unsigned long bufferSize;
         std::unique_ptr<log4cplus::tchar[]> buffer;
 
+        /**
+         * When true, the stream buffer grows during bursts and
+         * shrinks after idleness instead of staying at
+         * <code>bufferSize</code>, using buffers from a process wide
+         * pool.
+         */
+        bool adaptiveBuffering = false;
+
+        //! Upper bound in bytes for the adaptive buffer.
+        unsigned long adaptiveBufferMaxSize = 0;
+
+        //! Current size of the adaptive buffer, in characters.
+        std::size_t currentBufferSize = 0;
+
+        //! Bytes written since the last buffer size adjustment.
+        std::size_t bytesSinceAdjust = 0;
+
+        //! Time of the last buffer size adjustment.
+        log4cplus::helpers::Time lastBufferAdjust;
+
+        /**
+         * When true, each formatted event is written as a length and
+         * CRC32C framed record so readers can detect and skip a torn
+         * tail. \sa the <tt>RecordFraming</tt> property.
+         */
+        bool recordFraming = false;
+
+        /**
+         * When true, the stream buffer is pre-faulted and pinned
+         * into RAM after allocation. \sa the <tt>LockBuffer</tt>
+         * property.
+         */
+        bool lockBuffer = false;
+
+        //! Bytes of the stream buffer actually pinned, to be
+        //! unpinned by close(); 0 when the buffer is not locked.
+        std::size_t lockedBufferBytes = 0;
+
+        //! Scratch stream for formatting framed records.
+        log4cplus::tostringstream framing_oss;
+
         log4cplus::tofstream out;
+
+        //! Side descriptor on the same file as \c out, kept for
+        //! getFileDescriptor(); -1 when unavailable.
+        int dump_fd = -1;
+
         log4cplus::tstring filename;
         log4cplus::tstring localeName;
         log4cplus::tstring lockFileName;
@@ -185,6 +389,127 @@ namespace log4cplus
 
         log4cplus::helpers::Time reopen_time;
 
+        //! True when ReopenMode=atomic. \sa the <tt>ReopenMode</tt>
+        //! property.
+        bool atomicReopen = false;
+
+        //! Set by requestReopen() and consumed on the append path.
+        std::atomic<bool> reopen_requested {false};
+
+        //! True when \c pending_out holds a prepared replacement
+        //! stream.
+        std::atomic<bool> pending_stream_ready {false};
+
+        //! Replacement stream prepared in the background for an
+        //! atomic reopen. Only the preparing task touches it until
+        //! \c pending_stream_ready is set; after that, only the
+        //! append path under the appender mutex.
+        log4cplus::tofstream pending_out;
+
+        //! Cold path of the reopen check in append() and
+        //! appendBatch(): performs the requested inline reopen or
+        //! swaps in the prepared stream.
+        LOG4CPLUS_PRIVATE LOG4CPLUS_ATTRIBUTE_NOINLINE
+        void performRequestedReopen ();
+
+        /**
+         * Non-zero value enables the background flusher thread and
+         * gives the longest interval between its flushes, in
+         * milliseconds.
+         */
+        unsigned long asyncFlushIntervalMillis = 0;
+
+        //! Milliseconds between group commits; 0 unless
+        //! <tt>SyncPolicy=interval:&lt;ms&gt;</tt> is in effect.
+        unsigned long syncIntervalMillis = 0;
+
+        //! Events per group commit; 0 unless
+        //! <tt>SyncPolicy=group:&lt;n&gt;</tt> is in effect.
+        unsigned long syncGroupSize = 0;
+
+        //! Events appended since the last group commit. Guarded by
+        //! access_mutex.
+        unsigned long appendsSinceSync = 0;
+
+        //! Time of the last group commit. Guarded by access_mutex.
+        std::chrono::steady_clock::time_point lastSyncTime;
+
+        //! Flushes the stream and hands the file to stable storage
+        //! with fsync(). Called with access_mutex held.
+        LOG4CPLUS_PRIVATE void syncFile ();
+
+        //! Cold path of the group commit check on the append paths:
+        //! accounts \c count freshly appended events and performs the
+        //! commit once the configured group size or interval is
+        //! reached. Called with access_mutex held.
+        LOG4CPLUS_PRIVATE LOG4CPLUS_ATTRIBUTE_NOINLINE
+        void accountEventsForSync (std::size_t count);
+
+        //! Performs a group commit when the configured interval has
+        //! expired and uncommitted events exist; used by the flusher
+        //! thread. Called with access_mutex held.
+        LOG4CPLUS_PRIVATE void syncIfDue ();
+
+        /**
+         * When true, a background thread keeps the next rollover
+         * target pre-created and pre-opened so that rollover swaps
+         * streams instead of waiting for open().
+         */
+        bool preOpenRolloverFile = false;
+
+        //! Grows or shrinks the adaptive stream buffer based on the
+        //! write rate observed since the last adjustment. Called with
+        //! access_mutex held.
+        LOG4CPLUS_PRIVATE void adjustBuffer (std::size_t bytes_written);
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        class FlusherThread;
+        class SpareFileThread;
+
+        LOG4CPLUS_PRIVATE void initFlusher ();
+        LOG4CPLUS_PRIVATE void initSpareFile (long preallocateSize);
+        LOG4CPLUS_PRIVATE bool adoptSpareFile ();
+        LOG4CPLUS_PRIVATE void requestSpareFile ();
+        LOG4CPLUS_PRIVATE tstring spareFileName () const;
+
+        thread::AbstractThreadPtr flusher_thread;
+
+        //! Signaled to wake the flusher thread up early, e.g. on
+        //! close().
+        thread::ManualResetEvent flusher_wakeup;
+
+        //! Tells the flusher thread to exit.
+        std::atomic<bool> flusher_exit {false};
+
+        //! Number of events appended since the last background flush.
+        std::atomic<unsigned long> appends_since_flush {0};
+
+        thread::AbstractThreadPtr spare_thread;
+
+        //! Signaled when a fresh spare file should be prepared and on
+        //! close().
+        thread::ManualResetEvent spare_wakeup;
+
+        //! Tells the spare file thread to exit.
+        std::atomic<bool> spare_exit {false};
+
+        //! Set when rollover wants a fresh spare file prepared.
+        std::atomic<bool> spare_requested {false};
+
+        //! Guards spare_out and spare_ready.
+        thread::Mutex spare_mutex;
+
+        //! Stream pre-opened on the spare file by the spare file
+        //! thread.
+        tofstream spare_out;
+
+        //! True when spare_out holds a usable pre-opened spare file.
+        bool spare_ready = false;
+
+        //! Bytes to reserve in the spare file where supported.
+        long spare_prealloc_size = 0;
+#endif
+
     private:
       // Disallow copying of instances of this class
         FileAppenderBase(const FileAppenderBase&);
@@ -196,7 +521,78 @@ namespace log4cplus
      * Appends log events to a file.
      *
      * <h3>Properties</h3>
-     * <p>It has no properties additional to {@link FileAppenderBase}.
+     * <p>Properties additional to {@link FileAppenderBase}'s properties:
+     *
+     * <dl>
+     * <dt><tt>UseMemoryMappedIO</tt></dt>
+     * <dd>When this property is true and the platform supports
+     * <tt>mmap()</tt>, formatted events are appended into a memory
+     * mapped extent of the log file with plain memory copies instead
+     * of stream writes. The file is extended and remapped on demand
+     * and writeback is left to the kernel, which avoids a write()
+     * system call per flush. The property is ignored on platforms
+     * without <tt>mmap()</tt>.</dd>
+     *
+     * <dt><tt>MemoryMapExtent</tt></dt>
+     * <dd>Size in bytes of each mapped extent; rounded up to a
+     * multiple of the page size. The default is 1 MiB.</dd>
+     *
+     * <dt><tt>UseIOUring</tt></dt>
+     * <dd>When this property is true and the platform supports
+     * <tt>io_uring</tt> (Linux), formatted events are submitted to the
+     * kernel asynchronously and completions are reaped opportunistically,
+     * so a slow filesystem never blocks the logging thread. The appender
+     * only waits when all submission slots are in flight. Falls back to
+     * the stream based path when io_uring is unavailable at run time.
+     * <tt>ImmediateFlush</tt> is ignored in this mode; all outstanding
+     * writes are drained on close.</dd>
+     *
+     * <dt><tt>IOUringQueueDepth</tt></dt>
+     * <dd>Number of submission slots, the default is 64.</dd>
+     *
+     * <dt><tt>UseDirectIO</tt></dt>
+     * <dd>When this property is true and the platform supports
+     * <tt>O_DIRECT</tt> (Linux), formatted events are accumulated in
+     * an aligned buffer and written with direct I/O, bypassing the
+     * page cache. This avoids double buffering and cache pollution
+     * for very high volume logs at the cost of coarser durability:
+     * output reaches the file only when a buffer fills or the
+     * appender is closed, and <tt>ImmediateFlush</tt> is ignored.
+     * The property is ignored when <tt>UseMemoryMappedIO</tt> or
+     * <tt>UseIOUring</tt> is in effect, and on platforms or
+     * filesystems without <tt>O_DIRECT</tt> support.</dd>
+     *
+     * <dt><tt>DirectIOBufferSize</tt></dt>
+     * <dd>Size in bytes of the aligned accumulation buffer; rounded
+     * down to a multiple of the I/O alignment. The default is
+     * 1 MiB.</dd>
+     *
+     * <dt><tt>TimestampIndex</tt></dt>
+     * <dd>When this property is true, the appender maintains a sparse
+     * sidecar index named <tt>&lt;File&gt;.tsidx</tt> mapping event
+     * timestamps to byte offsets in the log file. One text line,
+     * <tt>&lt;microseconds since epoch&gt; &lt;offset&gt;</tt>, is
+     * appended when the log has grown by
+     * <tt>TimestampIndexByteInterval</tt> bytes or the last entry is
+     * <tt>TimestampIndexTimeInterval</tt> seconds old, so tools can
+     * locate a time range in a very large log with a binary search
+     * over the index and one seek instead of a scan. The stream
+     * position is only queried when an entry is written, off the hot
+     * path. The property is ignored when <tt>UseMemoryMappedIO</tt>,
+     * <tt>UseIOUring</tt> or <tt>UseDirectIO</tt> is in effect, and
+     * by the rolling subclasses, whose rollover invalidates recorded
+     * offsets.</dd>
+     *
+     * <dt><tt>TimestampIndexByteInterval</tt></dt>
+     * <dd>Log growth in bytes between index entries. It is possible
+     * to use <tt>MB</tt> and <tt>KB</tt> suffixes to specify the
+     * value in megabytes or kilobytes instead. The default is
+     * 16 MB.</dd>
+     *
+     * <dt><tt>TimestampIndexTimeInterval</tt></dt>
+     * <dd>Longest time in seconds between index entries while events
+     * keep arriving. The default is 60.</dd>
+     * </dl>
      */
     class LOG4CPLUS_EXPORT FileAppender : public FileAppenderBase {
     public:
@@ -211,14 +607,161 @@ namespace log4cplus
       // Dtor
         virtual ~FileAppender();
 
+      // Methods
+        virtual void close();
+
     protected:
         void init();
+
+        virtual void append(const spi::InternalLoggingEvent& event);
+        virtual void appendBatch(const spi::InternalLoggingEvent* events,
+            std::size_t count);
+
+      // Data
+        /**
+         * When true, append through a memory mapped view of the log
+         * file instead of the output stream.
+         */
+        bool useMemoryMappedIO = false;
+
+        /**
+         * Size of each memory mapped extent, in bytes.
+         */
+        unsigned long memoryMapExtent = 1024 * 1024;
+
+        /**
+         * When true, submit appends through io_uring instead of the
+         * output stream.
+         */
+        bool useIOUring = false;
+
+        /**
+         * Number of io_uring submission slots.
+         */
+        unsigned long ioUringQueueDepth = 64;
+
+        /**
+         * When true, write through an aligned direct I/O buffer
+         * instead of the output stream.
+         */
+        bool useDirectIO = false;
+
+        /**
+         * Size of the direct I/O accumulation buffer, in bytes.
+         */
+        unsigned long directIOBufferSize = 1024 * 1024;
+
+        /**
+         * When true, maintain the sparse timestamp to byte offset
+         * sidecar index next to the log file.
+         */
+        bool timestampIndex = false;
+
+        /**
+         * Log growth in bytes between index entries.
+         */
+        long tsIndexByteInterval = 16 * 1024 * 1024;
+
+        /**
+         * Longest time in seconds between index entries.
+         */
+        unsigned long tsIndexTimeInterval = 60;
+
+        //! Sidecar index output stream; opened lazily when the first
+        //! entry is written.
+        log4cplus::tofstream ts_index_out;
+
+        //! Value of the bytesWritten statistic at the last index
+        //! entry.
+        unsigned long long ts_index_last_bytes = 0;
+
+        //! Timestamp of the last index entry.
+        log4cplus::helpers::Time ts_index_last_time;
+
+        struct MemoryMappedFile;
+        std::unique_ptr<MemoryMappedFile> mmap_out;
+
+        struct IOUringWriter;
+        std::unique_ptr<IOUringWriter> uring_out;
+
+        struct DirectFileWriter;
+        std::unique_ptr<DirectFileWriter> direct_out;
+
+        LOG4CPLUS_PRIVATE void mmapWrite (char const * data, std::size_t size);
+        LOG4CPLUS_PRIVATE void uringWrite (char const * data, std::size_t size);
+        LOG4CPLUS_PRIVATE void directIOWrite (char const * data,
+            std::size_t size);
+        LOG4CPLUS_PRIVATE void directWrite (tstring const & str);
+        LOG4CPLUS_PRIVATE void maybeIndexTimestamp (
+            log4cplus::helpers::Time timestamp);
     };
 
     typedef helpers::SharedObjectPtr<FileAppender> SharedFileAppenderPtr;
 
 
 
+    /**
+     * RolloverStrategy is a pluggable rollover policy: it decides
+     * when the active log file is rolled over, what name the rolled
+     * file is archived under and which archives a rollover makes
+     * obsolete. Strategies are created through
+     * spi::getRolloverStrategyFactoryRegistry() and configured on a
+     * {@link RollingFileAppender} with the <tt>RolloverStrategy</tt>
+     * property; a configured strategy replaces the appender's built
+     * in size trigger and backup naming.
+     *
+     * All methods are called with the appender lock held, so a
+     * strategy may keep mutable state without its own locking but
+     * should keep shouldRollover() cheap -- it runs once per
+     * appended event.
+     */
+    class LOG4CPLUS_EXPORT RolloverStrategy
+        : public virtual helpers::SharedObject
+    {
+    public:
+        //! Facts about the active log file passed to every decision.
+        struct Status
+        {
+            //! Path of the active log file.
+            tstring const & filename;
+
+            //! Size of the active file in bytes, as tracked by the
+            //! appender.
+            long long fileSize;
+
+            //! Timestamp of the event about to be appended, or the
+            //! current time when called from rollover itself.
+            helpers::Time time;
+        };
+
+        RolloverStrategy();
+        virtual ~RolloverStrategy() = 0;
+
+        /**
+         * Returns true when the active file should be rolled over
+         * before the next event is appended.
+         */
+        virtual bool shouldRollover(const Status& status) = 0;
+
+        /**
+         * Returns the name the just closed file is archived under.
+         * The appender performs the rename itself. Called once per
+         * rollover, after shouldRollover() returned true.
+         */
+        virtual tstring archiveFilename(const Status& status) = 0;
+
+        /**
+         * Removes, or queues for removal, archives this rollover
+         * made obsolete. Called after the archive rename.
+         */
+        virtual void cleanup(const Status& status) = 0;
+    };
+
+    typedef helpers::SharedObjectPtr<RolloverStrategy>
+        SharedRolloverStrategyPtr;
+
+
+
     /**
      * RollingFileAppender extends FileAppender to backup the log
      * files when they reach a certain size.
@@ -237,6 +780,42 @@ namespace log4cplus
      * <dd>This property limits the number of backup output
      * files; e.g. how many <tt>log.1</tt>, <tt>log.2</tt> etc. files
      * will be kept.</dd>
+     *
+     * <dt><tt>RolloverNaming</tt></dt>
+     * <dd>This property selects how backup files are named. The
+     * default value, <tt>Shift</tt>, renames <tt>log.1</tt> to
+     * <tt>log.2</tt> and so on up to <tt>MaxBackupIndex</tt> on each
+     * rollover, so <tt>log.1</tt> is always the newest backup but a
+     * rollover costs <tt>MaxBackupIndex</tt> renames while the
+     * appender is locked. The value <tt>Monotonic</tt> gives each
+     * backup an ever increasing index instead and removes the single
+     * oldest backup past <tt>MaxBackupIndex</tt>, so a rollover is
+     * one rename plus at most one removal regardless of
+     * <tt>MaxBackupIndex</tt>; the newest backup is the one with the
+     * highest index.</dd>
+     *
+     * <dt><tt>CompressBackups</tt></dt>
+     * <dd>This property selects compression of backup files. The
+     * supported value is <tt>gzip</tt>: a just rotated backup is
+     * handed to a background thread owned by the appender and
+     * compressed to <tt>log.N.gz</tt> off the logging path, so
+     * rollover latency stays flat while old backups shrink. It
+     * requires zlib support compiled in and
+     * <tt>RolloverNaming=Monotonic</tt>, because the <tt>Shift</tt>
+     * naming keeps renaming backups after they have been
+     * compressed. The property is ignored in single threaded
+     * builds.</dd>
+     *
+     * <dt><tt>RolloverStrategy</tt></dt>
+     * <dd>Name of a {@link RolloverStrategy} registered with
+     * spi::getRolloverStrategyFactoryRegistry(), e.g.
+     * <tt>log4cplus::SizeOrTimeRolloverStrategy</tt>. The strategy
+     * is configured through the <tt>RolloverStrategy.</tt> property
+     * subset, mirroring the <tt>layout</tt> property. When set, the
+     * strategy decides when to roll, names the archived files and
+     * prunes obsolete archives; the <tt>MaxFileSize</tt>,
+     * <tt>MaxBackupIndex</tt>, <tt>RolloverNaming</tt> and
+     * <tt>CompressBackups</tt> properties are then ignored.</dd>
      * </dl>
      */
     class LOG4CPLUS_EXPORT RollingFileAppender : public FileAppender {
@@ -252,16 +831,78 @@ namespace log4cplus
       // Dtor
         virtual ~RollingFileAppender();
 
+      // Methods
+        virtual void close();
+
     protected:
         virtual void append(const spi::InternalLoggingEvent& event);
+        virtual void appendBatch(const spi::InternalLoggingEvent* events,
+            std::size_t count);
         void rollover(bool alreadyLocked = false);
 
       // Data
         long maxFileSize;
         int maxBackupIndex;
 
+        /**
+         * When true, backups get monotonically increasing indices and
+         * rollover is a single rename plus one amortized removal
+         * instead of shifting all backups by one.
+         */
+        bool monotonicNaming = false;
+
+        /**
+         * Index the next backup file will get with monotonic naming.
+         */
+        long nextRolloverIndex = 1;
+
+        /**
+         * When true, just rotated backups are handed to the
+         * background compressor thread.
+         */
+        bool compressBackups = false;
+
+        /**
+         * Size of the current log file as tracked by this appender,
+         * so that the rollover size check does not have to query the
+         * stream position on every event. Reconciled with the real
+         * file size at open and rollover time.
+         */
+        long long currentFileSize = 0;
+
+        /**
+         * Pluggable rollover policy replacing the built in size
+         * trigger and backup naming when set. See the
+         * <tt>RolloverStrategy</tt> property.
+         */
+        SharedRolloverStrategyPtr rolloverStrategy;
+
+#if defined (LOG4CPLUS_WITH_ZLIB) && ! defined (LOG4CPLUS_SINGLE_THREADED)
+        class CompressorThread;
+
+        LOG4CPLUS_PRIVATE void initCompressor ();
+
+        thread::AbstractThreadPtr compressor_thread;
+
+        //! Signaled when a rotated file is queued and on close().
+        thread::ManualResetEvent compressor_wakeup;
+
+        //! Tells the compressor thread to drain the queue and exit.
+        std::atomic<bool> compressor_exit {false};
+
+        //! Rotated files awaiting compression.
+        thread::Mutex compress_queue_mutex;
+        std::vector<tstring> compress_queue;
+#endif
+
     private:
         LOG4CPLUS_PRIVATE void init(long maxFileSize, int maxBackupIndex);
+        LOG4CPLUS_PRIVATE void scanMonotonicBackups();
+
+        //! Evaluates the rollover trigger: the configured strategy
+        //! when one is set, the size check otherwise.
+        LOG4CPLUS_PRIVATE bool shouldRollover(
+            const spi::InternalLoggingEvent& event);
     };
 
 
@@ -272,6 +913,76 @@ namespace log4cplus
     enum DailyRollingFileSchedule { MONTHLY, WEEKLY, DAILY,
                                     TWICE_DAILY, HOURLY, MINUTELY};
 
+
+    /**
+     * SizeOrTimeRolloverStrategy rolls the file over when it exceeds
+     * a size limit <em>or</em> crosses a schedule boundary, whichever
+     * comes first, so a single appender covers both triggers instead
+     * of two appender instances writing the same data twice.
+     *
+     * Archives are named
+     * <tt>&lt;File&gt;.&lt;date&gt;.&lt;index&gt;</tt>, where the
+     * date part follows the schedule (the same defaults as
+     * DailyRollingFileAppender's <tt>DatePattern</tt>) and the index
+     * counts rollovers within one schedule period, so several size
+     * triggered rollovers inside a period get distinct names.
+     * Archives left by a previous run are never overwritten; the
+     * index resumes past them.
+     *
+     * <h3>Properties</h3>
+     * <dl>
+     * <dt><tt>MaxFileSize</tt></dt>
+     * <dd>Size limit triggering a rollover, in bytes; the
+     * <tt>MB</tt> and <tt>KB</tt> suffixes are accepted. Default is
+     * 10&nbsp;MB.</dd>
+     *
+     * <dt><tt>Schedule</tt></dt>
+     * <dd>Time boundary triggering a rollover. The possible values
+     * are <tt>MONTHLY</tt>, <tt>WEEKLY</tt>, <tt>DAILY</tt>,
+     * <tt>TWICE_DAILY</tt>, <tt>HOURLY</tt> and <tt>MINUTELY</tt>.
+     * Default is <tt>WEEKLY</tt>.</dd>
+     *
+     * <dt><tt>MaxHistory</tt></dt>
+     * <dd>Number of schedule periods whose archives are kept; the
+     * archives of older periods are removed after each rollover.
+     * 0 disables the cleanup. Default is 10.</dd>
+     * </dl>
+     */
+    class LOG4CPLUS_EXPORT SizeOrTimeRolloverStrategy
+        : public RolloverStrategy
+    {
+    public:
+        SizeOrTimeRolloverStrategy(
+            const log4cplus::helpers::Properties& properties);
+        virtual ~SizeOrTimeRolloverStrategy();
+
+        virtual bool shouldRollover(const Status& status);
+        virtual tstring archiveFilename(const Status& status);
+        virtual void cleanup(const Status& status);
+
+    protected:
+      // Data
+        long maxFileSize;
+        DailyRollingFileSchedule schedule;
+        int maxHistory;
+        log4cplus::helpers::Time nextRolloverTime;
+
+        /**
+         * Archive name stem (file name plus date part) of the
+         * current schedule period and the index the next archive in
+         * it will get.
+         */
+        log4cplus::tstring periodStem;
+        long nextIndexInPeriod = 1;
+
+        /**
+         * Time of the last cleanup, driving the catch-up sweep over
+         * periods that elapsed since; empty before the first one.
+         */
+        log4cplus::helpers::Time lastCleanupTime;
+    };
+
+
     /**
      * DailyRollingFileAppender extends {@link FileAppender} so that the
      * underlying file is rolled over at a user chosen frequency.
@@ -328,6 +1039,8 @@ namespace log4cplus
 
     protected:
         virtual void append(const spi::InternalLoggingEvent& event);
+        virtual void appendBatch(const spi::InternalLoggingEvent* events,
+            std::size_t count);
         void rollover(bool alreadyLocked = false);
         log4cplus::helpers::Time calculateNextRolloverTime(const log4cplus::helpers::Time& t) const;
         log4cplus::tstring getFilename(const log4cplus::helpers::Time& t) const;
@@ -368,7 +1081,9 @@ namespace log4cplus
      *
      * <dt><tt>MaxHistory</tt></dt>
      * <dd>The optional maxHistory property controls the maximum number of
-     * archive files to keep, deleting older files.</dd>
+     * archive files to keep, deleting older files. In multithreaded
+     * builds the deletion runs on a background thread so that rollover
+     * itself does not block on filesystem cleanup.</dd>
      *
      * <dt><tt>CleanHistoryOnStart</tt></dt>
      * <dd>If set to true, archive removal will be executed on appender start
@@ -399,6 +1114,8 @@ namespace log4cplus
 
     protected:
         void append(const spi::InternalLoggingEvent& event);
+        void appendBatch(const spi::InternalLoggingEvent* events,
+            std::size_t count);
         void open(std::ios_base::openmode mode);
         void close();
         void rollover(bool alreadyLocked = false);
@@ -416,6 +1133,25 @@ namespace log4cplus
         log4cplus::helpers::Time nextRolloverTime;
         bool rollOnClose;
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        class CleanerThread;
+
+        LOG4CPLUS_PRIVATE void initCleaner ();
+
+        thread::AbstractThreadPtr cleaner_thread;
+
+        //! Signaled when obsolete files are queued for removal and on
+        //! close().
+        thread::ManualResetEvent cleaner_wakeup;
+
+        //! Tells the cleaner thread to drain the queue and exit.
+        std::atomic<bool> cleaner_exit {false};
+
+        //! Obsolete archive files awaiting removal.
+        thread::Mutex clean_queue_mutex;
+        std::vector<tstring> clean_queue;
+#endif
+
     private:
         LOG4CPLUS_PRIVATE void init();
     };
@@ -423,6 +1159,116 @@ namespace log4cplus
     typedef helpers::SharedObjectPtr<TimeBasedRollingFileAppender>
         SharedTimeBasedRollingFileAppenderPtr;
 
+
+    /**
+     * ChunkedFileAppender extends {@link FileAppenderBase} to write an
+     * append-only sequence of fixed-size, sequentially numbered chunk
+     * files instead of rolling a single file over. Chunks are named
+     * <tt>&lt;File&gt;.&lt;index&gt;</tt> with an ever increasing
+     * index; a full chunk gets a one line index footer recording the
+     * number of events and payload bytes it holds, is closed, and is
+     * never touched again. No file is ever renamed or removed, so
+     * rollover is constant time and downstream log shippers can tail
+     * the chunk sequence incrementally: a chunk with a footer is
+     * complete, the chunk with the highest index is the live one. On
+     * restart the appender continues the sequence after the highest
+     * existing index.
+     *
+     * <h3>Properties</h3>
+     * <p>Properties additional to {@link FileAppenderBase}'s properties:
+     *
+     * <dl>
+     * <dt><tt>MaxChunkSize</tt></dt>
+     * <dd>This property specifies the size at which the current chunk
+     * is finished and the next one is opened. The value is in
+     * bytes. It is possible to use <tt>MB</tt> and <tt>KB</tt>
+     * suffixes to specify the value in megabytes or kilobytes
+     * instead. The default is 256 MB.</dd>
+     *
+     * <dt><tt>PreallocateNextChunk</tt></dt>
+     * <dd>When this property is true, a background thread owned by
+     * the appender creates the next chunk file ahead of rollover and,
+     * where the platform supports it, reserves its blocks with
+     * <tt>fallocate()</tt>, so that switching chunks does not wait
+     * for file creation or block allocation. The property is ignored
+     * in single threaded builds.</dd>
+     * </dl>
+     */
+    class LOG4CPLUS_EXPORT ChunkedFileAppender : public FileAppenderBase {
+    public:
+      // Ctors
+        ChunkedFileAppender(const log4cplus::tstring& filename,
+                            long maxChunkSize = 256*1024*1024, // 256 MB
+                            bool immediateFlush = true,
+                            bool createDirs = false);
+        ChunkedFileAppender(const log4cplus::helpers::Properties& properties);
+
+      // Dtor
+        virtual ~ChunkedFileAppender();
+
+      // Methods
+        virtual void close();
+
+    protected:
+        virtual void append(const spi::InternalLoggingEvent& event);
+        virtual void appendBatch(const spi::InternalLoggingEvent* events,
+            std::size_t count);
+        virtual void open(std::ios_base::openmode mode);
+        void rollover();
+
+      // Data
+        long maxChunkSize;
+
+        /**
+         * Index of the chunk currently being written.
+         */
+        long currentChunkIndex = 1;
+
+        /**
+         * Bytes written into the current chunk so far.
+         */
+        long long currentChunkSize = 0;
+
+        /**
+         * Events written into the current chunk so far.
+         */
+        long long currentChunkEvents = 0;
+
+        /**
+         * When true, the next chunk is created and pre-allocated by
+         * the background thread ahead of rollover.
+         */
+        bool preallocateNextChunk = false;
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        class PreallocThread;
+
+        LOG4CPLUS_PRIVATE void initPrealloc ();
+
+        thread::AbstractThreadPtr prealloc_thread;
+
+        //! Signaled when the next chunk should be pre-created and on
+        //! close().
+        thread::ManualResetEvent prealloc_wakeup;
+
+        //! Tells the prealloc thread to exit.
+        std::atomic<bool> prealloc_exit {false};
+
+        //! Index of the chunk the prealloc thread should create next;
+        //! zero when there is nothing to do.
+        std::atomic<long> prealloc_index {0};
+#endif
+
+    private:
+        LOG4CPLUS_PRIVATE void init(long maxChunkSize);
+        LOG4CPLUS_PRIVATE tstring chunkFilename(long index) const;
+        LOG4CPLUS_PRIVATE void scanExistingChunks();
+        LOG4CPLUS_PRIVATE void finishChunk();
+    };
+
+    typedef helpers::SharedObjectPtr<ChunkedFileAppender>
+        SharedChunkedFileAppenderPtr;
+
 } // end namespace log4cplus
 
 #endif // LOG4CPLUS_FILE_APPENDER_HEADER_
@@ -35,6 +35,7 @@
 #include <log4cplus/spi/appenderattachable.h>
 #include <log4cplus/thread/syncprims.h>
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -44,6 +45,20 @@ namespace log4cplus {
  
         /**
          * This Interface is for attaching Appenders to objects.
+         *
+         * The attached appenders are published as a copy-on-write
+         * snapshot: readers (most importantly
+         * <code>appendLoopOnAppenders()</code>, which runs on every
+         * logged event) obtain the list with a single atomic load,
+         * while mutations pay for copying the list under
+         * <code>appender_list_mutex</code>. The copy is deferred to
+         * the first read after a change, so a burst of attach and
+         * detach calls &mdash; e.g. tearing down a short-lived logger
+         * &mdash; republishes once instead of once per call, and a
+         * list that is never read again after a change is never
+         * copied at all. A retired snapshot is freed by whichever
+         * reader drops its last reference; no reader ever waits for
+         * another.
          */
         class LOG4CPLUS_EXPORT AppenderAttachableImpl 
             : public log4cplus::spi::AppenderAttachable
@@ -76,7 +91,8 @@ namespace log4cplus {
              * Return the appender with that name if in the list. Return null
              * otherwise.  
              */
-            virtual SharedAppenderPtr getAppender(const log4cplus::tstring& name);
+            virtual SharedAppenderPtr getAppender(
+                const log4cplus::tstring_view& name);
 
             /**
              * Remove all previously added appenders.
@@ -92,22 +108,127 @@ namespace log4cplus {
              * Remove the appender with the name passed as parameter from the
              * list of appenders.  
              */
-            virtual void removeAppender(const log4cplus::tstring& name);
+            virtual void removeAppender(const log4cplus::tstring_view& name);
 
             /**
-             * Call the <code>doAppend</code> method on all attached appenders.  
+             * Call the <code>doAppend</code> method on all attached appenders.
+             *
+             * The appenders are visited in ascending threshold order
+             * and the loop stops at the first appender whose
+             * threshold rejects the event; every appender behind it
+             * rejects the event on its threshold too, so none of them
+             * has to be touched. The order is captured when the
+             * appender list last changed; a threshold changed on an
+             * already attached appender is still honoured by each
+             * visited appender, but only informs the stop point after
+             * the next attach or detach.
              */
             int appendLoopOnAppenders(const spi::InternalLoggingEvent& event) const;
 
+            /**
+             * Call the <code>doAppendBatch</code> method on all attached
+             * appenders for a whole batch of events.
+             */
+            int appendLoopOnAppenders(const spi::InternalLoggingEvent* events,
+                std::size_t count) const;
+
+            /**
+             * Enables or disables parallel fan-out. When enabled and
+             * more than one appender is attached,
+             * <code>appendLoopOnAppenders()</code> delivers events to
+             * all attached appenders concurrently on the shared
+             * thread pool and returns once every appender has
+             * finished, so the fan-out costs the slowest appender
+             * instead of the sum. Formatting uses per thread scratch
+             * buffers; the event's one slot formatted line cache is
+             * bypassed for the duration of the fan-out.
+             *
+             * Do not enable this on objects whose events are
+             * themselves delivered from thread pool threads (e.g.
+             * appenders with <tt>AsyncAppend</tt> set); the waiting
+             * producer would occupy the pool slot its own tasks need.
+             *
+             * The flag is ignored in single threaded builds. Default
+             * is off.
+             */
+            void setParallelFanout (bool enable);
+
+            bool getParallelFanout () const;
+
+            /**
+             * Retrieves the minimum of the attached appenders'
+             * thresholds into \c floor and returns true. Returns
+             * false without touching \c floor when no appenders are
+             * attached. Events below the floor are guaranteed to be
+             * rejected by every attached appender, so callers can
+             * gate on it before an event is even constructed.
+             */
+            bool getAppenderThresholdFloor (LogLevel & floor) const;
+
         protected:
+            /**
+             * Hook invoked after the set of attached appenders has
+             * changed, outside of <code>appender_list_mutex</code>.
+             * The default implementation does nothing; LoggerImpl
+             * overrides it to refresh the hierarchy's effective
+             * threshold table.
+             */
+            virtual void appenderListChanged ();
+
           // Types
             typedef std::vector<SharedAppenderPtr> ListType;
 
           // Data
-            /** Array of appenders. */
+            /** Array of appenders. Mutated only with
+             *  appender_list_mutex held; each change marks the
+             *  published snapshots stale and the first subsequent
+             *  read republishes them. */
             ListType appenderList;
 
         private:
+            /** Immutable snapshot of appenderList read atomically by
+             *  appendLoopOnAppenders() without taking the mutex. */
+            mutable std::shared_ptr<ListType const> appenderListSnapshot;
+
+            /** Copy of appenderListSnapshot stably sorted by
+             *  ascending appender threshold as of publication. The
+             *  per event fan-out walks this copy but checks each
+             *  appender's live threshold; Appender::setThreshold()
+             *  can change thresholds without republishing it. */
+            mutable std::shared_ptr<ListType const> appenderListByThreshold;
+
+            /** Set under appender_list_mutex when appenderList has
+             *  changed; cleared by the reader that republishes the
+             *  snapshots. */
+            mutable std::atomic<bool> appenderListStale {false};
+
+            //! See setParallelFanout().
+            std::atomic<bool> parallelFanout {false};
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+            /** Delivers `events` to every appender in `appenders`
+             *  concurrently on the shared thread pool and blocks
+             *  until all of them have finished. */
+            LOG4CPLUS_PRIVATE int appendLoopOnAppendersParallel (
+                ListType const & appenders,
+                const spi::InternalLoggingEvent * events,
+                std::size_t count) const;
+#endif
+
+            //! Publishes a fresh snapshot of appenderList. Must be
+            //! called with appender_list_mutex held.
+            LOG4CPLUS_PRIVATE void publishAppenderList() const;
+
+            //! Republishes the snapshots if a mutation has marked
+            //! them stale since they were last published.
+            LOG4CPLUS_PRIVATE void refreshAppenderListSnapshot() const;
+
+            LOG4CPLUS_PRIVATE std::shared_ptr<ListType const>
+            getAppenderListSnapshot() const;
+
+            LOG4CPLUS_PRIVATE std::shared_ptr<ListType const>
+            getAppenderListByThreshold() const;
+
             AppenderAttachableImpl(AppenderAttachableImpl const &);
             AppenderAttachableImpl & operator = (AppenderAttachableImpl const &);
         };  // end class AppenderAttachableImpl
@@ -0,0 +1,104 @@
+// -*- C++ -*-
+//  Copyright (C) 2009-2017, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_HELPERS_COMPRESSOR_HEADER_
+#define LOG4CPLUS_HELPERS_COMPRESSOR_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+
+#include <cstddef>
+#include <vector>
+
+
+namespace log4cplus {
+
+namespace helpers {
+
+
+/**
+ * Reusable deflate context. Each call compresses one whole frame
+ * independently (the stream is reset between calls), so frames can be
+ * decompressed in isolation and a lost or reconnected connection does
+ * not desynchronize the peer. The context and its internal buffers
+ * are reused across calls; steady state compression does not
+ * allocate. Not synchronized; callers serialize access.
+ */
+class LOG4CPLUS_EXPORT FrameCompressor
+{
+public:
+    FrameCompressor ();
+    ~FrameCompressor ();
+    FrameCompressor (FrameCompressor const &) = delete;
+    FrameCompressor & operator = (FrameCompressor const &) = delete;
+
+    //! Compresses \c size bytes at \c data into \c out, replacing its
+    //! contents. Returns false on failure, leaving \c out unspecified.
+    bool compress (std::vector<char> & out, char const * data,
+        std::size_t size);
+
+private:
+    //! z_stream, kept out of the public header.
+    void * stream;
+};
+
+
+/**
+ * Inflating counterpart of FrameCompressor, with the same reuse and
+ * synchronization properties.
+ */
+class LOG4CPLUS_EXPORT FrameDecompressor
+{
+public:
+    FrameDecompressor ();
+    ~FrameDecompressor ();
+    FrameDecompressor (FrameDecompressor const &) = delete;
+    FrameDecompressor & operator = (FrameDecompressor const &) = delete;
+
+    //! Decompresses \c size bytes at \c data into \c out, replacing
+    //! its contents. \c decompressed_size is the expected output size
+    //! carried by the frame header; output of any other size is an
+    //! error. Returns false on failure, leaving \c out unspecified.
+    bool decompress (std::vector<char> & out, char const * data,
+        std::size_t size, std::size_t decompressed_size);
+
+private:
+    void * stream;
+};
+
+
+} // namespace helpers
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_WITH_ZLIB
+
+#endif // LOG4CPLUS_HELPERS_COMPRESSOR_HEADER_
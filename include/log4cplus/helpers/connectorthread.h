@@ -35,6 +35,8 @@
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/helpers/socket.h>
 
+#include <random>
+
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 
@@ -63,6 +65,13 @@ protected:
     //! Sets connected flag to true in ConnectorThread's client.
     virtual void ctcSetConnected () = 0;
 
+    //! Called by ConnectorThread on every periodic wake up while the
+    //! connection is open, outside any client lock. Clients may use
+    //! it to probe the connection, e.g. by sending a heartbeat frame,
+    //! and trigger() a reconnect when the probe fails. The default
+    //! implementation does nothing.
+    virtual void ctcHeartbeat ();
+
     friend class LOG4CPLUS_EXPORT ConnectorThread;
 };
 
@@ -74,7 +83,11 @@ class LOG4CPLUS_EXPORT ConnectorThread
 {
 public:
     //! \param client reference to ConnectorThread's client object
-    ConnectorThread (IConnectorThreadClient & client);
+    //! \param wait_millis interval between periodic wake ups; each
+    //! wake up re-checks the connection and invokes the client's
+    //! ctcHeartbeat() when it is open
+    ConnectorThread (IConnectorThreadClient & client,
+        unsigned wait_millis = 30 * 1000);
     virtual ~ConnectorThread ();
     
     virtual void run();
@@ -89,14 +102,27 @@ public:
     void trigger ();
     
 protected:
+    //! Sleeps for \c millis, ignoring trigger() wake ups, so that a
+    //! failed connection attempt's backoff is not cut short by
+    //! logging activity. Returns false when terminate() was
+    //! requested, in which case the thread should exit.
+    bool backoffWait (unsigned millis);
+
     //! reference to ConnectorThread's client
     IConnectorThreadClient & ctc;
 
     //! This event is the re-connection trigger.
     thread::ManualResetEvent trigger_ev;
 
-    //! When this variable set to true when ConnectorThread is signaled to 
+    //! Milliseconds between periodic wake ups.
+    unsigned const wait_millis;
+
+    //! When this variable set to true when ConnectorThread is signaled to
     bool exit_flag;
+
+    //! Source of the reconnection backoff jitter; only ever used by
+    //! the connector thread itself.
+    std::minstd_rand backoff_rng { std::random_device {} () };
 };
 
 
@@ -0,0 +1,138 @@
+// -*- C++ -*-
+//  Copyright (C) 2009-2017, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef LOG4CPLUS_HELPERS_EVENTSPILL_H
+#define LOG4CPLUS_HELPERS_EVENTSPILL_H
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+#include <fstream>
+#include <vector>
+#include <log4cplus/tstring.h>
+#include <log4cplus/spi/loggingevent.h>
+
+
+namespace log4cplus { namespace helpers {
+
+
+//! Bounded on-disk overflow store for logging events, used by
+//! AsyncAppender's SpillToDisk overflow policy. Events are serialized
+//! with the convertToBuffer() wire format into length-prefixed records
+//! and appended to a single file with one sequential write per batch;
+//! read() deserializes records from the front for replay. When the
+//! pending data would exceed the configured bound, the oldest records
+//! are discarded first, giving the file ring-like semantics, and the
+//! physical file is compacted once the replayed prefix grows past the
+//! bound.
+//!
+//! The store is not synchronized; it is only ever touched by the
+//! single queue consumer thread. The spill file of a previous run is
+//! truncated on construction, replay does not span process restarts.
+class LOG4CPLUS_EXPORT EventSpill
+{
+public:
+    //! \param path Path of the spill file. It is created or truncated.
+    //! \param max_bytes Bound on the pending serialized data. A
+    //! single write() batch may overshoot it by the batch's size.
+    EventSpill (tstring const & path, std::size_t max_bytes);
+
+    //! Closes the spill file and removes it when it holds no pending
+    //! records.
+    ~EventSpill ();
+
+    //! Returns false when the spill file could not be opened; write()
+    //! then discards all events handed to it.
+    bool is_open () const;
+
+    //! Returns true when no records are pending for replay.
+    bool empty () const
+    {
+        return read_offset == write_size;
+    }
+
+    //! Bytes of serialized records pending for replay.
+    std::size_t pending_bytes () const
+    {
+        return write_size - read_offset;
+    }
+
+    //! Serializes \c count events and appends them to the spill file
+    //! in one sequential write, discarding the oldest pending records
+    //! as needed to stay within the bound.
+    //!
+    //! \return The number of events discarded, both oldest records
+    //! evicted by the bound and incoming events lost to I/O errors.
+    std::size_t write (spi::InternalLoggingEvent const * events,
+        std::size_t count);
+
+    //! Deserializes up to \c max_events pending records from the
+    //! front of the spill file and appends them to \c out.
+    //!
+    //! \return The number of events appended to \c out.
+    std::size_t read (std::vector<spi::InternalLoggingEvent> & out,
+        std::size_t max_events);
+
+private:
+    //! Advances the read offset past the oldest pending record.
+    //! Returns false on I/O error.
+    bool drop_oldest_record ();
+
+    //! Rewrites the pending records to the start of a fresh file so
+    //! that a long outage does not grow the file without bound.
+    void compact ();
+
+    //! Truncates the file and resets both offsets.
+    void truncate ();
+
+    tstring path;
+    std::fstream file;
+    std::size_t max_bytes;
+
+    //! Offset of the oldest record not yet replayed.
+    std::size_t read_offset;
+
+    //! Offset one past the newest record, i.e. the file size.
+    std::size_t write_size;
+
+    //! Scratch buffer assembling each write() batch and holding each
+    //! record read back, reused across calls.
+    std::vector<char> io_buf;
+
+    EventSpill (EventSpill const &);
+    EventSpill & operator = (EventSpill const &);
+};
+
+
+} } // namespace log4cplus { namespace helpers {
+
+
+#endif // LOG4CPLUS_SINGLE_THREADED
+
+#endif // LOG4CPLUS_HELPERS_EVENTSPILL_H
@@ -42,7 +42,21 @@ namespace log4cplus { namespace helpers {
 class LOG4CPLUS_EXPORT LockFile
 {
 public:
-    LockFile (tstring const & lock_file, bool create_dirs = false);
+    /**
+     * With \c use_shared_mutex set, lock() and unlock() go through a
+     * robust, process shared mutex living in a small sidecar file
+     * next to the lock file (<tt>.mtx</tt> suffix) instead of file
+     * locking syscalls. An uncontended acquisition is then a couple
+     * of atomic operations on shared memory rather than a syscall
+     * pair per append. The mutex is robust: when a lock holder dies,
+     * the next locker recovers the mutex instead of deadlocking. The
+     * lock file itself is kept; it serializes the one-time
+     * initialization of the shared mutex. On platforms without
+     * process shared robust mutexes the flag is ignored and file
+     * locking is used as before.
+     */
+    LockFile (tstring const & lock_file, bool create_dirs = false,
+        bool use_shared_mutex = false);
     ~LockFile ();
 
     void lock () const;
@@ -33,6 +33,7 @@
 #include <log4cplus/tstring.h>
 #include <log4cplus/streams.h>
 #include <log4cplus/thread/syncprims.h>
+#include <atomic>
 
 
 namespace log4cplus {
@@ -113,23 +114,39 @@ namespace log4cplus {
                 TriTrue
             };
 
+            //! One formatted diagnostic line queued for output.
+            struct PendingLine;
+
             template <typename StringType>
             LOG4CPLUS_PRIVATE
             void logging_worker (tostream & os,
                 bool (LogLog:: * cond) () const, tchar const *,
                 StringType const &, bool throw_flag = false) const;
 
-            LOG4CPLUS_PRIVATE static void set_tristate_from_env (TriState *,
-                tchar const * envvar);
+            //! Queues \c text for \c os and writes all queued lines
+            //! unless another thread is already writing them. Threads
+            //! never block on each other here; during an internal
+            //! error storm one thread writes while the others only
+            //! enqueue and continue.
+            LOG4CPLUS_PRIVATE void publish_line (tostream & os,
+                tstring & text) const;
+
+            LOG4CPLUS_PRIVATE static void set_tristate_from_env (
+                std::atomic<TriState> *, tchar const * envvar);
 
             LOG4CPLUS_PRIVATE bool get_quiet_mode () const;
             LOG4CPLUS_PRIVATE bool get_not_quiet_mode () const;
             LOG4CPLUS_PRIVATE bool get_debug_mode () const;
 
             // Data
-            mutable TriState debugEnabled;
-            mutable TriState quietMode;
-            thread::Mutex mutex;
+            mutable std::atomic<TriState> debugEnabled;
+            mutable std::atomic<TriState> quietMode;
+
+            //! Stack of lines waiting to be written, in LIFO order.
+            mutable std::atomic<PendingLine *> pending;
+
+            //! True while some thread is writing the queued lines.
+            mutable std::atomic<bool> draining;
 
             LOG4CPLUS_PRIVATE LogLog(const LogLog&);
             LOG4CPLUS_PRIVATE LogLog & operator = (LogLog const &);
@@ -0,0 +1,152 @@
+// -*- C++ -*-
+// Module:  LOG4CPLUS
+// File:    memorybudget.h
+// Created: 8/2026
+// Author:  Vaclav Zeman
+//
+//
+//  Copyright (C) 2026, Vaclav Zeman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_HELPERS_MEMORYBUDGET_H
+#define LOG4CPLUS_HELPERS_MEMORYBUDGET_H
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#include <atomic>
+#include <cstddef>
+
+#include <log4cplus/loglevel.h>
+
+
+namespace log4cplus { namespace helpers {
+
+
+/**
+ * Process wide byte budget for memory owned by logging.
+ *
+ * The asynchronous queues charge the estimated size of queued events
+ * and the file appenders charge their stream buffers, so that
+ * getUsage() approximates how much memory logging is holding at any
+ * moment. When a limit is configured through setLimit() (or the
+ * <tt>log4cplus.memoryBudget</tt> global property) and usage exceeds
+ * it, the queues shed events whose LogLevel is below
+ * getShedBelowLevel() instead of queueing them, keeping worst case
+ * logging memory bounded. With no limit set (the default) the
+ * accounting is maintained but nothing is ever shed.
+ *
+ * All counters are relaxed atomics; charging and the shed decision
+ * cost a few uncontended atomic operations on the hot path.
+ */
+class LOG4CPLUS_EXPORT MemoryBudget
+{
+public:
+    //! Returns the process wide instance.
+    static MemoryBudget & instance ();
+
+    //! Sets the budget in bytes. 0 (the default) disables shedding.
+    void setLimit (std::size_t bytes)
+    {
+        limit_.store (bytes, std::memory_order_relaxed);
+    }
+
+    std::size_t getLimit () const
+    {
+        return limit_.load (std::memory_order_relaxed);
+    }
+
+    //! Sets the LogLevel below which events are shed while over
+    //! budget. The default is WARN_LOG_LEVEL, so warnings and errors
+    //! are still queued when the budget is exhausted.
+    void setShedBelowLevel (LogLevel ll)
+    {
+        shed_below_.store (ll, std::memory_order_relaxed);
+    }
+
+    LogLevel getShedBelowLevel () const
+    {
+        return shed_below_.load (std::memory_order_relaxed);
+    }
+
+    //! Currently registered usage in bytes.
+    std::size_t getUsage () const
+    {
+        return usage_.load (std::memory_order_relaxed);
+    }
+
+    //! Number of events shed because the budget was exhausted.
+    std::size_t getShedCount () const
+    {
+        return shed_.load (std::memory_order_relaxed);
+    }
+
+    //! Registers \c bytes of logging owned memory.
+    void charge (std::size_t bytes)
+    {
+        usage_.fetch_add (bytes, std::memory_order_relaxed);
+    }
+
+    //! Unregisters \c bytes previously passed to charge().
+    void release (std::size_t bytes)
+    {
+        usage_.fetch_sub (bytes, std::memory_order_relaxed);
+    }
+
+    //! Returns true when an event of LogLevel \c ll should be shed:
+    //! a limit is set, usage exceeds it and \c ll is below the shed
+    //! threshold.
+    bool shouldShed (LogLevel ll) const
+    {
+        std::size_t const limit = getLimit ();
+        return limit != 0
+            && usage_.load (std::memory_order_relaxed) >= limit
+            && ll < getShedBelowLevel ();
+    }
+
+    //! Counts one event shed due to the exhausted budget.
+    void countShedEvent ()
+    {
+        shed_.fetch_add (1, std::memory_order_relaxed);
+    }
+
+private:
+    MemoryBudget () = default;
+    MemoryBudget (MemoryBudget const &) = delete;
+    MemoryBudget & operator = (MemoryBudget const &) = delete;
+
+    std::atomic<std::size_t> usage_ {0};
+    std::atomic<std::size_t> limit_ {0};
+    std::atomic<std::size_t> shed_ {0};
+    std::atomic<LogLevel> shed_below_ {WARN_LOG_LEVEL};
+};
+
+
+} } // namespace log4cplus { namespace helpers {
+
+#endif // LOG4CPLUS_HELPERS_MEMORYBUDGET_H
@@ -50,6 +50,16 @@ namespace log4cplus {
          *                       Class SharedObject (from pp. 204-205)                *
          ******************************************************************************/
 
+        /**
+         * Base class of intrusively reference counted objects.
+         *
+         * Build the library with
+         * <code>LOG4CPLUS_DEBUG_SHARED_OBJECT_REF_COUNT</code> defined
+         * to verify the reference counting protocol at run time:
+         * counter underflow, reference manipulation on an already
+         * destroyed object and destruction with live references then
+         * abort with a diagnostic instead of corrupting memory.
+         */
         class LOG4CPLUS_EXPORT SharedObject
         {
         public:
@@ -74,9 +74,17 @@ namespace log4cplus {
           // methods
             /**
              * Tests to see if <code>key</code> can be found in this map.
+             *
+             * Lookups are read only and allocation free: the
+             * transparent comparator lets C string and string view
+             * keys be searched without constructing a temporary
+             * tstring, so runtime consumers (e.g. pattern converter
+             * fallbacks) can query frozen configuration without
+             * locks or allocations.
              */
             bool exists(const log4cplus::tstring& key) const;
             bool exists(tchar const * key) const;
+            bool exists(tstring_view key) const;
 
             /**
              * Returns the number of entries in this map.
@@ -94,6 +102,7 @@ namespace log4cplus {
              */
             log4cplus::tstring const & getProperty(const log4cplus::tstring& key) const;
             log4cplus::tstring const & getProperty(tchar const * key) const;
+            log4cplus::tstring const & getProperty(tstring_view key) const;
 
             /**
              * Searches for the property with the specified key in this property
@@ -136,7 +145,11 @@ namespace log4cplus {
 
         protected:
           // Types
-            typedef std::map<log4cplus::tstring, log4cplus::tstring> StringMap;
+            //! The transparent std::less<> comparator allows
+            //! heterogeneous lookups by tchar pointer or string view
+            //! without materializing a temporary tstring key.
+            typedef std::map<log4cplus::tstring, log4cplus::tstring,
+                std::less<>> StringMap;
 
           // Methods
             void init(log4cplus::tistream& input);
@@ -33,7 +33,9 @@
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 
-#include <deque>
+#include <atomic>
+#include <utility>
+#include <vector>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/thread/syncprims.h>
@@ -50,8 +52,10 @@ public:
     //! Type of the state flags field.
     typedef unsigned flags_type;
 
-    //! Queue storage type.
-    typedef std::deque<spi::InternalLoggingEvent> queue_storage_type;
+    //! Queue storage type. The storage is contiguous so that whole
+    //! batches of drained events can be handed to batch oriented APIs,
+    //! e.g. Appender::doAppendBatch().
+    typedef std::vector<spi::InternalLoggingEvent> queue_storage_type;
 
     explicit Queue (unsigned len = 100);
     virtual ~Queue ();
@@ -69,13 +73,18 @@ public:
     //!
     //! \param ev spi::InternalLoggingEvent to be put into the queue.
     //! \return Flags.
-    flags_type put_event (spi::InternalLoggingEvent const & ev);
+    virtual flags_type put_event (spi::InternalLoggingEvent const & ev);
+
+    //! Overload that moves \c ev into the queue instead of copying
+    //! it. The lazily captured thread specific data of \c ev is
+    //! resolved before the move, like in the copying overload.
+    virtual flags_type put_event (spi::InternalLoggingEvent && ev);
 
     //! Sets EXIT flag and DRAIN flag and sets internal event object
     //! into signaled state.
     //! \param drain If true, DRAIN flag will be set, otherwise unset.
     //! \return Flags, ERROR_BIT can be set upon error.
-    flags_type signal_exit (bool drain = true);
+    virtual flags_type signal_exit (bool drain = true);
 
     // Consumer's methods.
 
@@ -96,7 +105,106 @@ public:
     //! \param buf Pointer to storage of spi::InternalLoggingEvent
     //! instances to be filled from queue.
     //! \return Flags.
-    flags_type get_events (queue_storage_type * buf);
+    virtual flags_type get_events (queue_storage_type * buf);
+
+    //! Non-blocking variant of get_events(). It fills <code>buf</code>
+    //! and sets the EVENT flag in the return value when the queue is
+    //! non-empty; when the queue is empty it returns immediately
+    //! without the EVENT flag instead of waiting for the internal
+    //! event object. It is used by consumers that multiplex several
+    //! queues onto one thread (AsyncDispatcher) and therefore cannot
+    //! park on a single queue's event object.
+    //!
+    //! \param buf Pointer to storage of spi::InternalLoggingEvent
+    //! instances to be filled from queue.
+    //! \return Flags.
+    virtual flags_type try_get_events (queue_storage_type * buf);
+
+    //! Pre-faults and pins the queue's slot storage into RAM using
+    //! internal::lock_memory(), so that draining never major-faults
+    //! on pages evicted under memory pressure. It must be called
+    //! before any producer or the consumer thread touches the queue;
+    //! it is not synchronized. The locked regions are unpinned by the
+    //! destructor. Only the contiguous slot arrays are covered; the
+    //! heap storage of the queued events' strings is not. Returns
+    //! false when the storage cannot be locked, e.g. because it
+    //! exceeds internal::max_lockable_memory or the platform denies
+    //! the lock; the queue then operates normally without pinned
+    //! memory.
+    virtual bool lock_storage ();
+
+    //! Possible policies applied by put_event() when the queue is
+    //! full.
+    enum OverflowPolicy
+    {
+        //! put_event() blocks until the consumer makes room. This is
+        //! the default.
+        BLOCK,
+
+        //! The oldest queued event is discarded to make room for the
+        //! incoming one. The queue backends that do not allow the
+        //! producer to touch the consumer's end of the queue
+        //! (RingQueue, DoubleBufferQueue) treat this policy as
+        //! DROP_NEWEST.
+        DROP_OLDEST,
+
+        //! The incoming event is discarded.
+        DROP_NEWEST,
+
+        //! The incoming event is discarded only when its LogLevel is
+        //! below the configured threshold; more severe events are
+        //! still enqueued, even when the queue is over its limit.
+        DROP_BELOW_LEVEL,
+
+        //! The incoming event is parked in an in-memory side buffer
+        //! for the consumer to persist to disk and replay later; see
+        //! take_spill_pending() and helpers::EventSpill. The queue
+        //! backends that do not allow producers to touch shared
+        //! storage outside their ring (RingQueue, DoubleBufferQueue)
+        //! treat this policy as DROP_NEWEST.
+        SPILL_TO_DISK
+    };
+
+    //! Sets the overflow policy. It must be called before any
+    //! producer or the consumer thread touches the queue; it is not
+    //! synchronized.
+    //!
+    //! \param policy Overflow policy to apply.
+    //! \param drop_below LogLevel threshold for DROP_BELOW_LEVEL.
+    void set_overflow_policy (OverflowPolicy policy,
+        LogLevel drop_below = WARN_LOG_LEVEL);
+
+    //! Returns the number of events discarded due to the overflow
+    //! policy so far.
+    std::size_t get_dropped_count () const
+    {
+        return dropped.load (std::memory_order_relaxed);
+    }
+
+    //! Returns the approximate number of events currently held in the
+    //! queue. The value comes from relaxed atomics and is read without
+    //! taking the queue mutex, so producers can afford to consult it
+    //! on every append, e.g. to shed verbosity as the queue fills up;
+    //! it may lag the true occupancy by events that are being enqueued
+    //! or drained concurrently.
+    virtual std::size_t get_occupancy () const;
+
+    //! Adds \c count to the dropped event count. It is used by the
+    //! spill writer when the disk bound forces it to discard records.
+    void add_dropped (std::size_t count)
+    {
+        dropped.fetch_add (count, std::memory_order_relaxed);
+    }
+
+    //! Takes the events parked by the SPILL_TO_DISK policy since the
+    //! last call, swapping them into \c buf, which must be empty.
+    //! Returns false without touching \c buf when nothing is parked.
+    //! It is called by the queue's consumer only.
+    bool take_spill_pending (queue_storage_type & buf);
+
+    //! Returns true when events are parked for the spill writer. It
+    //! is called by the queue's consumer only.
+    bool has_spill_pending ();
 
     //! Possible state flags.
     enum Flags
@@ -126,9 +234,15 @@ public:
     };
 
 protected:
-    //! Queue storage.
+    //! Queue storage. Only the first queue_size elements are live
+    //! events; elements past that count are already delivered event
+    //! shells handed back by the consumer's swap, whose string
+    //! storage put_event() recycles instead of allocating afresh.
     queue_storage_type queue;
 
+    //! Number of live events in queue.
+    std::size_t queue_size;
+
     //! Mutex protecting queue and flags.
     Mutex mutex;
 
@@ -141,7 +255,67 @@ protected:
     //! State flags.
     flags_type flags;
 
+    //! Maximal queue length as given to the constructor.
+    unsigned max_len;
+
+    //! Policy applied when the queue is full.
+    OverflowPolicy overflow_policy;
+
+    //! LogLevel threshold used by the DROP_BELOW_LEVEL policy.
+    LogLevel drop_below_level;
+
+    //! Number of events discarded due to the overflow policy.
+    std::atomic<std::size_t> dropped;
+
+    //! Mirror of queue_size, maintained under mutex and read by
+    //! get_occupancy() without locking.
+    std::atomic<std::size_t> occupancy;
+
+    //! Events parked by the SPILL_TO_DISK policy, protected by mutex.
+    //! The consumer takes them through take_spill_pending() and
+    //! persists them to disk. The buffer is bounded by
+    //! spill_pending_max_bytes of estimated event memory, sized to
+    //! absorb a burst for as long as the consumer is busy delivering
+    //! one batch to a slow sink; beyond that events are dropped.
+    queue_storage_type spill_pending;
+
+    //! Estimated memory held by the events in spill_pending.
+    std::size_t spill_pending_bytes;
+
+    //! Bound on spill_pending_bytes.
+    static std::size_t const spill_pending_max_bytes = 4 * 1024 * 1024;
+
+    //! Estimated bytes of memory held by a queued event; this is
+    //! what put_event() charges against the process wide
+    //! helpers::MemoryBudget and the drain paths release again.
+    static std::size_t event_memory_cost (
+        spi::InternalLoggingEvent const & ev);
+
+    //! Returns true and counts the event as shed when the memory
+    //! budget is exhausted and \c ev is below its shed threshold.
+    bool budget_shed (spi::InternalLoggingEvent const & ev);
+
+    //! Releases the budget charges of all events in \c buf.
+    static void budget_release (queue_storage_type const & buf);
+
+    //! Locks the region using internal::lock_memory() and records it
+    //! in locked_regions for the destructor to unlock.
+    bool lock_region (void * addr, std::size_t size);
+
+    //! Regions pinned by lock_storage(), unpinned by the destructor.
+    std::vector<std::pair<void *, std::size_t> > locked_regions;
+
 private:
+    //! Common implementation of both put_event() overloads,
+    //! instantiated for lvalue and rvalue event references.
+    template <typename EventRef>
+    flags_type put_event_worker (EventRef && ev);
+
+    //! Appends \c ev to the queue, reusing the storage of an already
+    //! delivered event shell past queue_size when one is available.
+    template <typename EventRef>
+    void recycle_push (EventRef && ev);
+
     Queue (Queue const &);
     Queue & operator = (Queue const &);
 };
@@ -150,6 +324,128 @@ private:
 typedef helpers::SharedObjectPtr<Queue> QueuePtr;
 
 
+//! Single consumer, multiple producers queue backed by a bounded
+//! lock-free ring buffer. Producers claim a slot using a single
+//! compare-and-swap and publish it through a per-slot sequence number,
+//! so no mutex is touched on the hot path. The consumer drains all
+//! published slots in one batch per get_events() call.
+//!
+//! When the ring is full, put_event() spins briefly and then yields
+//! until the consumer frees a slot, matching the blocking behaviour of
+//! the deque-based Queue.
+class LOG4CPLUS_EXPORT RingQueue
+    : public Queue
+{
+public:
+    //! \param len Requested capacity. It is rounded up to the nearest
+    //! power of two.
+    explicit RingQueue (unsigned len = 100);
+    virtual ~RingQueue ();
+
+    virtual flags_type put_event (spi::InternalLoggingEvent const & ev);
+    virtual flags_type put_event (spi::InternalLoggingEvent && ev);
+    virtual flags_type signal_exit (bool drain = true);
+    virtual flags_type get_events (queue_storage_type * buf);
+    virtual flags_type try_get_events (queue_storage_type * buf);
+    virtual bool lock_storage ();
+    virtual std::size_t get_occupancy () const;
+
+private:
+    //! Common implementation of both put_event() overloads,
+    //! instantiated for lvalue and rvalue event references.
+    template <typename EventRef>
+    flags_type put_event_worker (EventRef && ev);
+
+    struct Slot
+    {
+        //! Sequence number guarding the slot. A slot with sequence
+        //! number equal to the claiming position is free; a slot with
+        //! sequence number position + 1 holds a published event.
+        std::atomic<std::size_t> seq;
+        spi::InternalLoggingEvent ev;
+    };
+
+    //! Ring storage, its size is always a power of two.
+    std::vector<Slot> ring;
+
+    //! Mask used to map positions onto ring slots.
+    std::size_t mask;
+
+    //! Next position to be claimed by a producer.
+    std::atomic<std::size_t> enqueue_pos;
+
+    //! Next position to be consumed. Written only by the consumer;
+    //! atomic so that get_occupancy() can read it from producers.
+    std::atomic<std::size_t> dequeue_pos;
+
+    //! State flags, updated atomically instead of under mutex.
+    std::atomic<flags_type> ring_flags;
+
+    RingQueue (RingQueue const &);
+    RingQueue & operator = (RingQueue const &);
+};
+
+
+//! Single consumer, multiple producers queue that maintains two
+//! preallocated event buffers. Producers claim a slot in the active
+//! buffer with a single fetch-and-add; the consumer takes the whole
+//! active buffer out of circulation with a single atomic exchange that
+//! flips the buffer selector, so producers never wait while the
+//! consumer drains, only when a buffer is full.
+class LOG4CPLUS_EXPORT DoubleBufferQueue
+    : public Queue
+{
+public:
+    //! \param len Capacity of each of the two buffers.
+    explicit DoubleBufferQueue (unsigned len = 100);
+    virtual ~DoubleBufferQueue ();
+
+    virtual flags_type put_event (spi::InternalLoggingEvent const & ev);
+    virtual flags_type put_event (spi::InternalLoggingEvent && ev);
+    virtual flags_type signal_exit (bool drain = true);
+    virtual flags_type get_events (queue_storage_type * buf);
+    virtual flags_type try_get_events (queue_storage_type * buf);
+    virtual bool lock_storage ();
+    virtual std::size_t get_occupancy () const;
+
+private:
+    //! Common implementation of both put_event() overloads,
+    //! instantiated for lvalue and rvalue event references.
+    template <typename EventRef>
+    flags_type put_event_worker (EventRef && ev);
+
+    struct Buffer
+    {
+        //! Preallocated event slots; their string storage is reused
+        //! across swaps.
+        queue_storage_type events;
+
+        //! Number of slots whose events have been fully written.
+        std::atomic<std::size_t> published;
+    };
+
+    //! The buffer selector bit of \c state.
+    static constexpr std::size_t buffer_select_bit
+        = static_cast<std::size_t>(1)
+        << (sizeof (std::size_t) * 8 - 1);
+
+    Buffer buffers[2];
+
+    //! Capacity of each buffer.
+    std::size_t capacity;
+
+    //! Packed producer state. The topmost bit selects the active
+    //! buffer, the remaining bits count the slots claimed in it.
+    std::atomic<std::size_t> state;
+
+    //! State flags, updated atomically instead of under mutex.
+    std::atomic<flags_type> db_flags;
+
+    DoubleBufferQueue (DoubleBufferQueue const &);
+    DoubleBufferQueue & operator = (DoubleBufferQueue const &);
+};
+
+
 } } // namespace log4cplus { namespace thread {
 
 
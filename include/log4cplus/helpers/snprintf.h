@@ -32,8 +32,15 @@
 #endif
 
 #include <log4cplus/tchar.h>
+#include <log4cplus/tstring.h>
 #include <cstdarg>
 #include <vector>
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#include <format>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#endif
 
 
 namespace log4cplus { namespace helpers {
@@ -47,11 +54,50 @@ public:
     tchar const * print (tchar const * fmt, ...)
         LOG4CPLUS_FORMAT_ATTRIBUTE (__printf__, 2, 3);
 
+    //! Like print() but returns a view of the formatted output with
+    //! its length, so that callers do not have to re-measure the
+    //! string. The view is valid until the next use of this buffer.
+    tstring_view print_view (tchar const * fmt, ...)
+        LOG4CPLUS_FORMAT_ATTRIBUTE (__printf__, 2, 3);
+
     int print_va_list (tchar const * & str, tchar const * fmt, std::va_list)
         LOG4CPLUS_FORMAT_ATTRIBUTE (__printf__, 3, 0);
 
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+    //! Formats `fmt` with `args` through `std::format_to()` into the
+    //! internal buffer and returns a view of the result. The view is
+    //! valid until the next use of this buffer.
+    template <typename... Args>
+    tstring_view
+    format (std::basic_format_string<tchar,
+            std::type_identity_t<Args>...> fmt,
+        Args &&... args)
+    {
+        buf.clear ();
+        std::format_to (std::back_inserter (buf), fmt,
+            std::forward<Args> (args)...);
+        return tstring_view (buf.data (), buf.size ());
+    }
+#endif
+
 private:
+    //! Remembers, per format string identified by its pointer, how
+    //! large the formatted output was the last time, so that repeated
+    //! prints of the same call site start with a buffer that fits and
+    //! skip both the format length estimate and the grow-and-retry
+    //! loop. A stale or colliding entry only affects the initial
+    //! estimate, never correctness. The instances used by the logging
+    //! macros live in thread local storage, so no locking is needed.
+    struct format_size_cache_entry
+    {
+        tchar const * fmt = nullptr;
+        std::size_t size = 0;
+    };
+
+    static std::size_t const format_size_cache_len = 16;
+
     std::vector<tchar> buf;
+    format_size_cache_entry format_size_cache[format_size_cache_len];
 };
   
 
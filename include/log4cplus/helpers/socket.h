@@ -86,8 +86,12 @@ namespace log4cplus {
           // ctor and dtor
             Socket();
             Socket(SOCKET_TYPE sock, SocketState state, int err);
+            //! A nonzero \c connect_timeout_msec bounds the blocking
+            //! connect attempt; 0 leaves the operating system's own
+            //! timeout in effect.
             Socket(const tstring& address, unsigned short port,
-                bool udp = false, bool ipv6 = false);
+                bool udp = false, bool ipv6 = false,
+                unsigned connect_timeout_msec = 0);
             Socket(Socket &&) LOG4CPLUS_NOEXCEPT;
             virtual ~Socket();
 
@@ -107,6 +111,20 @@ namespace log4cplus {
                     (&args)... };
                 return socket.write (sizeof... (args), buffers);
             }
+
+            //! Configures TCP keepalive probing on this socket so
+            //! that dead peers are detected by the kernel instead of
+            //! by a blocked write. Parameters that are zero or
+            //! unsupported by the platform keep the system defaults.
+            //! \return 0 on success.
+            virtual int setKeepAlive (bool enable, int idleSeconds = 0,
+                int intervalSeconds = 0, int probeCount = 0);
+
+            //! Bounds how long transmitted data may stay
+            //! unacknowledged before the connection is forcibly
+            //! closed (TCP_USER_TIMEOUT where available). A no-op
+            //! returning 0 on platforms without the option.
+            virtual int setUserTimeout (int timeoutMilliseconds);
         };
 
 
@@ -119,8 +137,19 @@ namespace log4cplus {
          */
         class LOG4CPLUS_EXPORT ServerSocket : public AbstractSocket {
         public:
+            /**
+             * Binds and listens on \c port. With \c reusePort set,
+             * the listening socket is opened with
+             * <code>SO_REUSEPORT</code>, so several ServerSocket
+             * instances&mdash;in one process or across
+             * processes&mdash;can listen on the same port and the
+             * kernel distributes incoming connections between them.
+             * On platforms without the option a warning is logged
+             * and a second bind of the port fails as before.
+             */
             ServerSocket(unsigned short port, bool udp = false,
-                bool ipv6 = false, tstring const & host = tstring ());
+                bool ipv6 = false, tstring const & host = tstring (),
+                bool reusePort = false);
             ServerSocket(ServerSocket &&) LOG4CPLUS_NOEXCEPT;
             virtual ~ServerSocket();
 
@@ -138,10 +167,15 @@ namespace log4cplus {
         LOG4CPLUS_EXPORT SOCKET_TYPE openSocket(unsigned short port, bool udp,
             bool ipv6, SocketState& state);
         LOG4CPLUS_EXPORT SOCKET_TYPE openSocket(tstring const & host,
-            unsigned short port, bool udp, bool ipv6, SocketState& state);
+            unsigned short port, bool udp, bool ipv6, SocketState& state,
+            bool reusePort = false);
 
+        //! With a nonzero \c connect_timeout_msec the connect attempt
+        //! is performed non-blocking and abandoned after that many
+        //! milliseconds instead of hanging for the TCP timeout.
         LOG4CPLUS_EXPORT SOCKET_TYPE connectSocket(const log4cplus::tstring& hostn,
-            unsigned short port, bool udp, bool ipv6, SocketState& state);
+            unsigned short port, bool udp, bool ipv6, SocketState& state,
+            unsigned connect_timeout_msec = 0);
         LOG4CPLUS_EXPORT SOCKET_TYPE acceptSocket(SOCKET_TYPE sock, SocketState& state);
         LOG4CPLUS_EXPORT int closeSocket(SOCKET_TYPE sock);
         LOG4CPLUS_EXPORT int shutdownSocket(SOCKET_TYPE sock);
@@ -154,8 +188,21 @@ namespace log4cplus {
         LOG4CPLUS_EXPORT long write(SOCKET_TYPE sock,
             const std::string & buffer);
 
+        /**
+         * Re-resolves DNS cache entries that have outlived their
+         * TTL. connectSocket() caches resolutions per host:port;
+         * the connector threads call this on their periodic wake
+         * ups, off the logging path, so that a reconnect after a
+         * failure finds fresh addresses without waiting on DNS.
+         */
+        LOG4CPLUS_EXPORT void refreshStaleAddresses ();
+
         LOG4CPLUS_EXPORT tstring getHostname (bool fqdn);
         LOG4CPLUS_EXPORT int setTCPNoDelay (SOCKET_TYPE, bool);
+        LOG4CPLUS_EXPORT int setTCPKeepAlive (SOCKET_TYPE, bool enable,
+            int idleSeconds, int intervalSeconds, int probeCount);
+        LOG4CPLUS_EXPORT int setTCPUserTimeout (SOCKET_TYPE,
+            int timeoutMilliseconds);
 
     } // end namespace helpers
 } // end namespace log4cplus
@@ -43,8 +43,30 @@ class LOG4CPLUS_EXPORT SocketBuffer
 {
 public:
     explicit SocketBuffer(std::size_t max);
+
+    //! Wraps <code>size</code> bytes at <code>data</code> without
+    //! copying or taking ownership. The wrapped storage must stay
+    //! alive and unmodified for the lifetime of this buffer. This is
+    //! the zero-copy path for reading a message that has already been
+    //! received into some larger buffer.
+    SocketBuffer(char * data, std::size_t size);
+
+    //! SocketBuffer is movable but not copyable: moving transfers
+    //! the storage, while copying would duplicate the array once per
+    //! network message which is exactly the cost this type tries to
+    //! avoid.
+    SocketBuffer(SocketBuffer && rhs) noexcept;
+    SocketBuffer& operator= (SocketBuffer && rhs) noexcept;
+
     virtual ~SocketBuffer();
 
+    //! Makes the buffer hold <code>max</code> bytes of uninitialized
+    //! storage and resets the read/write position, discarding any
+    //! previous contents. Owned storage is kept when it is already
+    //! large enough, so a buffer reused across messages stops
+    //! allocating once it has seen the largest message size.
+    void reserve(std::size_t max);
+
     char *getBuffer() const { return buffer; }
     std::size_t getMaxSize() const { return maxsize; }
     std::size_t getSize() const { return size; }
@@ -56,6 +78,14 @@ public:
     unsigned int readInt();
     tstring readString(unsigned char sizeOfChar);
 
+    //! Reads a string like readString() but without copying it when
+    //! the wire character size matches the native tchar: the returned
+    //! view then points directly into this buffer and is only valid
+    //! while the buffer is alive and unmodified. When a character
+    //! size or byte order conversion is needed, the string is
+    //! converted into \c scratch and the view points into it instead.
+    tstring_view readStringView(unsigned char sizeOfChar, tstring & scratch);
+
     void appendByte(unsigned char val);
     void appendShort(unsigned short val);
     void appendInt(unsigned int val);
@@ -65,12 +95,19 @@ public:
 private:
     // Data
     std::size_t maxsize;
+    //! Bytes of owned storage behind <code>buffer</code>; zero for
+    //! non-owning buffers. May exceed <code>maxsize</code> after
+    //! reserve() shrank the logical size.
+    std::size_t capacity;
     std::size_t size;
     std::size_t pos;
     char *buffer;
+    //! False when the storage is merely wrapped and must not be
+    //! deleted.
+    bool owned;
 
-    SocketBuffer(SocketBuffer const & rhs);
-    SocketBuffer& operator= (SocketBuffer const& rhs);
+    SocketBuffer(SocketBuffer const & rhs) = delete;
+    SocketBuffer& operator= (SocketBuffer const& rhs) = delete;
 };
 
 } // end namespace helpers
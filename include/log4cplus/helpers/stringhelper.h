@@ -75,22 +75,25 @@ namespace log4cplus {
             typedef typename StringType::size_type size_type;
             size_type const slen = s.length();
             size_type first = 0;
-            size_type i = 0;
-            for (i=0; i < slen; ++i)
+            // Use find() to locate the delimiters so that the scan runs
+            // through the character traits' optimized search (memchr on
+            // common implementations) instead of a per-character loop.
+            for (;;)
             {
-                if (s[i] == c)
-                {
-                    *result = StringType (s, first, i - first);
-                    ++result;
-                    if (collapseTokens)
-                        while (i+1 < slen && s[i+1] == c)
-                            ++i;
-                    first = i + 1;
-                }
-            }
-            if (first != i)
+                size_type i = s.find (c, first);
+                if (i == StringType::npos)
+                    break;
+
                 *result = StringType (s, first, i - first);
-            else if (! collapseTokens && first == i)
+                ++result;
+                if (collapseTokens)
+                    while (i+1 < slen && s[i+1] == c)
+                        ++i;
+                first = i + 1;
+            }
+            if (first != slen)
+                *result = StringType (s, first, slen - first);
+            else if (! collapseTokens)
                 *result = StringType ();
         }
 
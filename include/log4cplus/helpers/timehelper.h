@@ -37,7 +37,9 @@
 #endif
 
 #include <ctime>
+#include <atomic>
 #include <chrono>
+#include <vector>
 
 
 namespace log4cplus {
@@ -53,6 +55,9 @@ typedef chrono::system_clock Clock;
 typedef chrono::duration<long long, std::micro> Duration;
 typedef chrono::time_point<Clock, Duration> Time;
 
+typedef chrono::steady_clock SteadyClock;
+typedef chrono::time_point<SteadyClock, Duration> SteadyTime;
+
 
 template <typename FromDuration>
 inline
@@ -63,14 +68,68 @@ time_cast (chrono::time_point<Clock, FromDuration> const & tp)
 }
 
 
+namespace detail
+{
+
+//! Microseconds since epoch maintained by the coarse timestamp
+//! ticker, or 0 (the sentinel for "coarse timestamps disabled").
+LOG4CPLUS_EXPORT extern std::atomic<long long> cached_now_usec;
+
+} // namespace detail
+
+
 inline
 Time
 now ()
 {
+    // With coarse timestamps enabled, return the cached value that
+    // the ticker thread refreshes instead of querying the system
+    // clock on every event.
+    long long const cached
+        = detail::cached_now_usec.load (std::memory_order_relaxed);
+    if (LOG4CPLUS_UNLIKELY (cached != 0))
+        return Time (Duration (cached));
+
     return time_cast (Clock::now ());
 }
 
 
+//! Monotonic companion of now(). Unlike the wall clock it never
+//! steps backwards across NTP adjustments, so its values order
+//! events reliably within one process. It is not subject to the
+//! coarse timestamp ticker.
+inline
+SteadyTime
+steady_now ()
+{
+    return chrono::time_point_cast<Duration> (SteadyClock::now ());
+}
+
+
+//! Selects between exact and coarse event timestamps. With a nonzero
+//! `granularity_msec`, helpers::now() returns a cached timestamp that
+//! a background ticker thread refreshes roughly every
+//! `granularity_msec` milliseconds, trading timestamp precision for
+//! not querying the system clock on every logged event. Granularity 0
+//! stops the ticker and restores exact timestamps. In configuration
+//! files this is exposed as the
+//! <code>log4cplus.coarseTimestampGranularityMillis</code> property.
+LOG4CPLUS_EXPORT void setCoarseTimestampGranularity (
+    unsigned granularity_msec);
+
+
+//! Enables the cached UTC offset mode of localTime(). With a nonzero
+//! `secs`, the local timezone offset is obtained from libc once and
+//! then revalidated at most every `secs` seconds; conversions in
+//! between are pure arithmetic, avoiding the lock glibc takes around
+//! its timezone state on every localtime_r() call. A DST transition
+//! or timezone change is therefore reflected up to `secs` seconds
+//! late. 0 (the default) restores exact libc conversions. In
+//! configuration files this is exposed as the
+//! <code>log4cplus.localTimeOffsetCacheSeconds</code> property.
+LOG4CPLUS_EXPORT void setLocalTimeOffsetCacheSeconds (unsigned secs);
+
+
 inline
 Time
 from_time_t (time_t t_time)
@@ -161,6 +220,64 @@ log4cplus::tstring getFormattedTime (log4cplus::tstring const & fmt,
     Time const & the_time, bool use_gmtime = false);
 
 
+/**
+ * Pre-compiled variant of getFormattedTime() for callers that format
+ * the same date format string once per event. The format string is
+ * split at construction into <code>strftime()</code> segments and the
+ * fields that change more often than the segments do -- the
+ * log4cplus specific <code>%q</code> and <code>%Q</code> sub-second
+ * specifiers and <code>%s</code> (seconds since epoch). Per call,
+ * the <code>strftime()</code> output of the segments is cached for
+ * the current second and only the sub-second fields are re-rendered,
+ * by writing their digits directly without streams.
+ *
+ * The per-second cache is not synchronized; layouts and pattern
+ * converters invoke it under their owning appender's mutex.
+ */
+class LOG4CPLUS_EXPORT CachedTimeFormatter
+{
+public:
+    CachedTimeFormatter (tstring const & fmt, bool use_gmtime);
+
+    //! Appends \c the_time formatted using the pre-compiled format
+    //! to \c result.
+    void format (tstring & result, Time const & the_time);
+
+private:
+    //! Field specifier that terminated a format segment.
+    enum Field
+    {
+        FIELD_NONE,          //!< Final segment, nothing follows.
+        FIELD_MILLIS,        //!< %q, milliseconds.
+        FIELD_FRACTIONAL,    //!< %Q, fractional milliseconds.
+        FIELD_EPOCH          //!< %s, seconds since epoch.
+    };
+
+    //! Piece of the format string free of field specifiers, followed
+    //! by the field specifier that terminated it.
+    struct Segment
+    {
+        tstring fmt;
+        Field field;
+    };
+
+    bool use_gmtime;
+
+    //! Format split at field specifiers so that the strftime based
+    //! part can be cached per second.
+    std::vector<Segment> segments;
+
+    //! Second for which cached_segments is valid.
+    std::time_t cached_sec;
+    bool cache_valid = false;
+
+    //! Formatted strftime output of each segment for cached_sec,
+    //! including the %s field whose value also only changes with the
+    //! second.
+    std::vector<tstring> cached_segments;
+};
+
+
 } // namespace helpers
 
 } // namespace log4cplus
@@ -32,6 +32,10 @@
 
 #include <log4cplus/logger.h>
 #include <log4cplus/thread/syncprims.h>
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <vector>
@@ -159,6 +163,9 @@ namespace log4cplus {
          * returned.  Otherwise, a new logger will be instantiated and
          * then linked with its existing ancestors as well as children.
          *
+         * Lookups of already existing loggers are lock-free; only the
+         * creation of a new logger serializes on the internal mutex.
+         *
          * @param name The name of the logger to retrieve.
          */
         virtual Logger getInstance(const log4cplus::tstring_view& name);
@@ -178,13 +185,75 @@ namespace log4cplus {
         virtual Logger getInstance(const log4cplus::tstring_view& name,
             spi::LoggerFactory& factory);
 
+        /**
+         * Returns the child hierarchy responsible for logger names
+         * that equal \c prefix or start with \c prefix followed by a
+         * dot, creating it on the first call. getInstance() and
+         * exists() route matching names to the partition, which has
+         * its own internal mutex, logger map and configuration, so a
+         * plugin reconfiguring or creating loggers under its prefix
+         * does not contend with other partitions or with this
+         * hierarchy. Configure a partition by passing it to
+         * PropertyConfigurator or BasicConfigurator as the target
+         * hierarchy.
+         *
+         * Events that stay additive at the partition's root fall
+         * through to this hierarchy's root and its appenders, so
+         * partitions without appenders of their own still log through
+         * the process-wide configuration.
+         *
+         * Partitions live until this hierarchy is destroyed;
+         * resetConfiguration() and clear() of this hierarchy do not
+         * touch them, while shutdown() closes them first. Overlapping
+         * prefixes are allowed; the longest match wins.
+         */
+        Hierarchy & getPartition(const log4cplus::tstring& prefix);
+
         /**
          * Returns all the currently defined loggers in this hierarchy.
          *
+         * The list is copied from the hierarchy's read-only snapshot,
+         * so calling this does not block logger creation.
+         *
          * The root logger is <em>not</em> included in the returned list.
          */
         virtual LoggerList getCurrentLoggers();
 
+        /**
+         * Visits every currently defined logger in this hierarchy in
+         * name order, without building a list. The visitor runs
+         * against the hierarchy's read-only snapshot; it does not
+         * block logger creation and may itself call getInstance().
+         * Loggers created while the visit is in progress may or may
+         * not be visited.
+         *
+         * The root logger is <em>not</em> visited.
+         */
+        virtual void forEachLogger (
+            std::function<void (Logger const &)> const & visit);
+
+        /**
+         * Point in time snapshot of one logger's activity, obtained
+         * through getStatistics().
+         */
+        struct Statistics
+        {
+            //! Name of the logger the snapshot belongs to.
+            log4cplus::tstring name;
+            //! Events emitted through the logger's forced log path.
+            unsigned long long eventsEmitted = 0;
+        };
+
+        /**
+         * Returns a snapshot of the emitted event counts of every
+         * logger in this hierarchy, including the root logger. The
+         * counters are maintained in per thread stripes with relaxed
+         * atomics on the log path; the snapshot is not a consistent
+         * cut across loggers but each individual count is exact.
+         * \sa spi::LoggerImpl::getEmittedEvents()
+         */
+        virtual std::vector<Statistics> getStatistics();
+
         /**
          * Is the LogLevel specified by <code>level</code> enabled?
          */
@@ -235,11 +304,107 @@ namespace log4cplus {
          */
         virtual void shutdown();
 
+        /**
+         * Deadline bounded variant of shutdown(). The \c budget is
+         * one deadline shared by all appenders, not a per appender
+         * allowance: each drain gets whatever is left of it. An
+         * appender that cannot finish within the remaining budget is
+         * closed anyway&mdash;an AsyncAppender then restricts its
+         * final drain to high severity events (see its
+         * <tt>ShutdownDrainThreshold</tt> property)&mdash;so a stuck
+         * sink delays process exit by roughly \c budget instead of
+         * hanging it. What was drained and what was dropped is
+         * reported through helpers::LogLog.
+         */
+        virtual void shutdown(std::chrono::milliseconds budget);
+
+        /**
+         * Returns the configuration epoch of this hierarchy. The
+         * epoch is bumped by clear(), resetConfiguration() and
+         * shutdown(); the call site caches behind
+         * LOG4CPLUS_STATIC_LOGGER() compare it against the epoch
+         * they were filled under to detect that their cached Logger
+         * may be stale.
+         */
+        unsigned getEpoch () const
+        {
+            return epoch.load (std::memory_order_relaxed);
+        }
+
+        /**
+         * RAII configuration transaction. While at least one
+         * transaction is open on a hierarchy, the O(number of
+         * loggers) rebuilds of the effective threshold table and of
+         * the flattened appender chains that every setLogLevel(),
+         * setAdditivity() or appender mutation triggers are merely
+         * noted, and configuration epoch bumps are held back.
+         * Closing the outermost transaction applies each pending
+         * rebuild once and publishes a single epoch bump, which
+         * shrinks both the duration of a configure pass and the
+         * window during which concurrent loggers observe
+         * half-applied state.
+         *
+         * Transactions may nest but must not be opened concurrently
+         * from several threads; configuration is expected to be
+         * serialized by the caller, as it is everywhere else in this
+         * class.
+         */
+        class LOG4CPLUS_EXPORT ConfigurationTransaction
+        {
+        public:
+            explicit ConfigurationTransaction (Hierarchy & hier);
+            ~ConfigurationTransaction ();
+
+        private:
+            Hierarchy & hierarchy;
+
+            ConfigurationTransaction (ConfigurationTransaction const &);
+            ConfigurationTransaction & operator = (
+                ConfigurationTransaction const &);
+        };
+
     private:
       // Types
+        /**
+         * Flat event routing table. Each logger's reachable appender
+         * set--the union of the appender lists along its flattened
+         * ancestor chain--is pre-resolved into a bitmask over a
+         * shared appender registry, so callAppenders() finds its
+         * fan-out with one array load instead of walking the chain.
+         * The table is immutable once published and rebuilt as a
+         * whole on every hierarchy mutation.
+         */
+        struct RoutingTable
+        {
+            /** Distinct appenders reachable from any logger, in the
+             *  ascending threshold order captured when the table was
+             *  built. */
+            std::vector<SharedAppenderPtr> appenders;
+
+            /** Bitmask over <code>appenders</code>, indexed by dense
+             *  logger id. <code>routingFallbackMask</code> sends the
+             *  logger down the chain walk instead; ids beyond the
+             *  vector belong to loggers created after the build and
+             *  fall back too. */
+            std::vector<std::uint64_t> masks;
+        };
+        typedef std::shared_ptr<RoutingTable const> RoutingTablePtr;
+
+        /** Mask value routing a logger through the flattened chain
+         *  walk; used for loggers whose fan-out the table cannot
+         *  reproduce (parallel fan-out in the chain). */
+        static constexpr std::uint64_t routingFallbackMask
+            = ~std::uint64_t (0);
+
+        /** Bit 63 is left to the fallback mask, so a table can route
+         *  at most 63 distinct appenders; with more the whole table
+         *  is dropped and every logger walks its chain. */
+        static constexpr std::size_t routingMaxAppenders = 63;
+
         typedef std::vector<Logger> ProvisionNode;
         typedef std::map<log4cplus::tstring, ProvisionNode, std::less<>> ProvisionNodeMap;
         typedef std::map<log4cplus::tstring, Logger, std::less<>> LoggerMap;
+        typedef std::shared_ptr<LoggerMap const> LoggerMapSnapshot;
 
       // Methods
         /**
@@ -296,17 +461,176 @@ namespace log4cplus {
         LOG4CPLUS_PRIVATE void updateChildren(ProvisionNode& pn,
             Logger const & logger);
 
+        /**
+         * Publishes a new read-only snapshot of <code>loggerPtrs</code>.
+         * NOTE: This method does not lock the <code>hashtable_mutex</code>;
+         * it must be called with the mutex held.
+         */
+        LOG4CPLUS_PRIVATE void publishSnapshot();
+
+        /**
+         * Hands out a slot in the effective threshold table for a
+         * newly created logger. Slot addresses are stable for the
+         * lifetime of the hierarchy. NOTE: Logger creation already
+         * serializes on <code>hashtable_mutex</code>; this method
+         * relies on that.
+         */
+        LOG4CPLUS_PRIVATE std::atomic<LogLevel> * allocateThresholdSlot();
+
+        /**
+         * Recomputes the effective threshold table slot of every
+         * logger in this hierarchy. Called after each LogLevel or
+         * disable value change.
+         */
+        LOG4CPLUS_PRIVATE void refreshThresholds();
+
+        /**
+         * Rebuilds the flattened ancestor chain of every logger in
+         * this hierarchy. Called after each mutation of parent links
+         * or an additivity flag. Also rebuilds the routing table,
+         * which flattens the same information further.
+         */
+        LOG4CPLUS_PRIVATE void refreshAppenderChains();
+
+        /**
+         * Hands out the next dense logger id. Ids index the routing
+         * table's mask vector and are never reused. NOTE: Logger
+         * creation already serializes on <code>hashtable_mutex</code>;
+         * this method relies on that.
+         */
+        LOG4CPLUS_PRIVATE std::size_t allocateLoggerId();
+
+        /**
+         * Rebuilds and publishes the event routing table from the
+         * current parent links, additivity flags and appender lists.
+         * Called after every mutation that can change any logger's
+         * reachable appender set.
+         */
+        LOG4CPLUS_PRIVATE void rebuildRoutingTable();
+
+        /**
+         * Returns the current routing table, or an empty pointer when
+         * no table is in effect and events must walk the flattened
+         * chains.
+         */
+        LOG4CPLUS_PRIVATE RoutingTablePtr getRoutingTable() const;
+
+        /**
+         * Advances the configuration epoch, or defers the bump when
+         * a configuration transaction is open.
+         */
+        LOG4CPLUS_PRIVATE void bumpEpoch();
+
+        //! Records \c name in loggerNameFilter. Called when a logger
+        //! is inserted into loggerPtrs.
+        LOG4CPLUS_PRIVATE void loggerNameFilterAdd (tstring_view name);
+
+        //! Returns false only when no logger named \c name has ever
+        //! been inserted; a true result is a possible hit that must
+        //! be confirmed against the logger map.
+        LOG4CPLUS_PRIVATE bool loggerNameFilterContains (
+            tstring_view name) const;
+
+        //! Returns the partition responsible for \c name, or null
+        //! when no registered prefix matches. Lock-free; reads the
+        //! published partition snapshot.
+        LOG4CPLUS_PRIVATE Hierarchy * findPartition (
+            tstring_view name) const;
+
      // Data
         thread::Mutex hashtable_mutex;
         std::unique_ptr<spi::LoggerFactory> defaultFactory;
         ProvisionNodeMap provisionNodes;
         LoggerMap loggerPtrs;
+
+        /**
+         * Read-mostly copy of <code>loggerPtrs</code>. It is replaced as
+         * a whole after each mutation, never modified in place, so that
+         * lookups of existing loggers can read it without taking
+         * <code>hashtable_mutex</code>.
+         */
+        LoggerMapSnapshot loggerPtrsSnapshot;
+
+        /**
+         * Bloom filter over the names of all loggers ever inserted
+         * into <code>loggerPtrs</code>. <code>exists()</code>
+         * consults it first so that the common negative probe
+         * finishes without touching the logger map at all. Bits are
+         * only ever set, never cleared, so resetting the hierarchy
+         * can at worst cause false positives (which fall through to
+         * the map lookup), never false negatives.
+         */
+        static std::size_t const loggerNameFilterWords = 64;
+        std::atomic<std::uint64_t> loggerNameFilter[loggerNameFilterWords] {};
+
+        /**
+         * Densely packed per-logger effective thresholds, read with a
+         * single relaxed load by LoggerImpl::isEnabledFor(). Each
+         * logger holds a stable pointer into these blocks; the vector
+         * itself is only mutated with <code>hashtable_mutex</code>
+         * held.
+         */
+        std::vector<std::unique_ptr<std::atomic<LogLevel>[]>> thresholdBlocks;
+        std::size_t thresholdCount = 0;
+
+        /**
+         * Current event routing table; replaced as a whole by
+         * rebuildRoutingTable() and read lock-free through
+         * std::atomic_load() by LoggerImpl::callAppenders(). Empty
+         * until the first rebuild and whenever the appender
+         * registry would overflow routingMaxAppenders.
+         */
+        RoutingTablePtr routingTable;
+
+        /** Next dense logger id, see allocateLoggerId(). */
+        std::size_t loggerIdCount = 0;
+
         Logger root;
 
         int disableValue;
 
+        /**
+         * Configuration epoch, see getEpoch(). Bumped through
+         * bumpEpoch() so that an open ConfigurationTransaction can
+         * coalesce the bumps of one configure pass.
+         */
+        std::atomic<unsigned> epoch {0};
+
+        /**
+         * Number of open configuration transactions and the rebuilds
+         * and epoch bumps they have deferred.
+         */
+        std::atomic<unsigned> transaction_depth {0};
+        std::atomic<bool> pending_thresholds {false};
+        std::atomic<bool> pending_appender_chains {false};
+        std::atomic<bool> pending_routing_table {false};
+        std::atomic<bool> pending_epoch {false};
+
         bool emittedNoAppenderWarning;
 
+        /**
+         * Prefix keyed child hierarchies owned by this hierarchy; see
+         * getPartition(). Mutated with <code>hashtable_mutex</code>
+         * held and published as a whole to
+         * <code>partitionSnapshot</code>. Declared after
+         * <code>root</code> so that partitions, whose root loggers
+         * link to it, are destroyed first.
+         */
+        std::vector<std::pair<tstring, std::unique_ptr<Hierarchy>>>
+            partitions;
+
+        typedef std::shared_ptr<
+            std::vector<std::pair<tstring, Hierarchy *>> const>
+            PartitionSnapshotPtr;
+
+        /**
+         * Read-only copy of the partition prefixes and pointers,
+         * replaced as a whole after each getPartition() insertion and
+         * read lock-free through std::atomic_load() by
+         * findPartition().
+         */
+        PartitionSnapshotPtr partitionSnapshot;
+
         // Disallow copying of instances of this class
         Hierarchy(const Hierarchy&);
         Hierarchy& operator=(const Hierarchy&);
@@ -314,6 +638,9 @@ namespace log4cplus {
      // Friends
         friend class log4cplus::spi::LoggerImpl;
         friend class log4cplus::HierarchyLocker;
+        // Appender::setThreshold() refreshes the effective threshold
+        // gates of the default hierarchy.
+        friend class log4cplus::Appender;
     };
 
 
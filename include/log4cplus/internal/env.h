@@ -67,6 +67,20 @@ bool split_path (std::vector<tstring> & components, std::size_t & special,
 //! Makes directories leading to file.
 void make_dirs (tstring const & file_path);
 
+//! Largest region lock_memory() is willing to pin, guarding against
+//! a misconfiguration pinning unbounded amounts of RAM.
+std::size_t const max_lockable_memory = 64 * 1024 * 1024;
+
+//! Pre-faults and pins \c size bytes at \c addr into RAM so that the
+//! pages cannot be reclaimed and major-fault back in on the logging
+//! path. Returns false, leaving the region unlocked, when the region
+//! exceeds max_lockable_memory, the platform does not support memory
+//! locking or the lock is denied (e.g. RLIMIT_MEMLOCK).
+bool lock_memory (void * addr, std::size_t size);
+
+//! Unpins a region previously locked with lock_memory().
+void unlock_memory (void * addr, std::size_t size);
+
 inline
 #if defined (_WIN32)
 DWORD
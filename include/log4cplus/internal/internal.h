@@ -47,6 +47,8 @@
 #  error "This header must not be be used outside log4cplus' implementation files."
 #endif
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <sstream>
@@ -108,6 +110,24 @@ struct appender_sratch_pad
 };
 
 
+//! Per thread log-scale histogram of cycles spent inside the logging
+//! macros, filled by detail::record_call_latency() when the
+//! application is compiled with LOG4CPLUS_CALL_LATENCY. The
+//! constructor registers the histogram with a process wide registry
+//! harvested by log4cplus::getCallLatencyHistogram(); the destructor
+//! folds the counts into the registry's retired sum. The buckets are
+//! written by the owning thread only and read concurrently by the
+//! harvest, hence the relaxed atomics.
+struct call_latency_histogram
+{
+    call_latency_histogram ();
+    ~call_latency_histogram ();
+
+    std::atomic<std::uint64_t> buckets[64];
+    std::atomic<std::uint64_t> count;
+};
+
+
 //! Per thread data.
 struct per_thread_data
 {
@@ -118,14 +138,47 @@ struct per_thread_data
     tostringstream macros_oss;
     tostringstream layout_oss;
     DiagnosticContextStack ndc_dcs;
-    MappedDiagnosticContextMap mdc_map;
-    log4cplus::tstring thread_name;
-    log4cplus::tstring thread_name2;
+    //! Recycled NDC nodes. NDC::pop() parks popped contexts here and
+    //! NDC::push() reuses them together with their string storage, so
+    //! push/pop pairs are allocation free in steady state.
+    DiagnosticContextStack ndc_dcs_pool;
+    //! The MDC of this thread. Modified copy-on-write by MDC so that
+    //! snapshots handed out to logging events stay immutable.
+    std::shared_ptr<MappedDiagnosticContextMap> mdc_map;
+    //! Bounded pool of map nodes extracted by ~MDCGuard(). A later
+    //! guard reuses a pooled node together with its string storage,
+    //! so repeated guards are allocation free in steady state.
+    MappedDiagnosticContextMap mdc_node_pool;
+    //! Interned thread names of this thread. Replaced wholesale by
+    //! thread::setCurrentThreadName() et al. so that handles held by
+    //! logging events stay immutable.
+    thread::ThreadNamePtr thread_name;
+    thread::ThreadNamePtr thread_name2;
     gft_scratch_pad gft_sp;
     appender_sratch_pad appender_sp;
     log4cplus::tstring faa_str;
+    log4cplus::tstring layout_str;
     log4cplus::tstring ll_str;
     spi::InternalLoggingEvent forced_log_ev;
+    //! High-water mark of message sizes seen by forced_log_ev and the
+    //! number of uses since the last capacity check. Together they
+    //! drive the periodic trim in LoggerImpl::forcedLog() that stops
+    //! a rare huge message from pinning capacity forever.
+    std::size_t forced_log_high_water;
+    unsigned forced_log_use_count;
+    //! Round robin index of this thread, assigned once when the
+    //! thread data is created. LoggerImpl uses it to pick a stripe
+    //! of its emitted events counter so that concurrent producers
+    //! do not contend on one atomic.
+    unsigned counter_stripe;
+    //! Sequence number stamped by the appender currently delivering
+    //! an event on this thread, or 0 when that appender does not
+    //! number its events. Read at format time by PatternLayout's
+    //! <b>%%#</b> converter and by BinaryLayout.
+    //! \sa the Appender <tt>SequenceNumbers</tt> property.
+    std::uint64_t appender_sequence;
+    //! Histogram of this thread's log call latencies.
+    call_latency_histogram call_latency;
     std::FILE * fnull;
     log4cplus::helpers::snprintf_buf snprintf_buf;
 };
@@ -196,16 +249,16 @@ get_ptd (bool alloc = true)
 
 
 inline
-tstring &
-get_thread_name_str ()
+thread::ThreadNamePtr &
+get_thread_name_ptr ()
 {
     return get_ptd ()->thread_name;
 }
 
 
 inline
-tstring &
-get_thread_name2_str ()
+thread::ThreadNamePtr &
+get_thread_name2_ptr ()
 {
     return get_ptd ()->thread_name2;
 }
@@ -227,6 +280,13 @@ get_appender_sp ()
 }
 
 
+//! Generation number of this process. atForkChild() increments it in
+//! the forked child, so caches of process identity - the pre-rendered
+//! %i process id and %h hostname in PatternLayout - can detect the
+//! fork and refresh themselves.
+LOG4CPLUS_EXPORT unsigned process_generation ();
+
+
 } // namespace internal {
 
 
@@ -0,0 +1,83 @@
+// -*- C++ -*-
+// Module:  Log4CPLUS
+// File:    tracepoints.h
+// Created: 8/2026
+//
+//
+// Copyright 2026 Tad E. Smith
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/** @file
+ * This header defines the LOG4CPLUS_TRACEPOINT* macros placing static
+ * tracepoints on the logging hot paths. They are compiled in only
+ * when the library is built with LOG4CPLUS_ENABLE_TRACEPOINTS and the
+ * platform provides SystemTap/USDT probes (<sys/sdt.h>); disarmed
+ * probes cost a single nop instruction, so production builds can keep
+ * them enabled and attach bpftrace/perf without rebuilding. On all
+ * other configurations the macros expand to nothing.
+ *
+ * All probes live under the `log4cplus` provider:
+ *
+ *   - `event_create(loglevel)` — logging event filled in.
+ *   - `queue_put(queue)` — producer enqueueing into an async queue.
+ *   - `queue_get(queue, count)` — consumer draining `count` events.
+ *   - `appender_append(name)` / `appender_append_done(name)` —
+ *     around a single event write; `name` is the appender's name.
+ *   - `appender_append_batch(name, count)` — batch write.
+ *   - `rollover(filename)` — log file rollover.
+ */
+
+#ifndef LOG4CPLUS_INTERNAL_TRACEPOINTS_HEADER_
+#define LOG4CPLUS_INTERNAL_TRACEPOINTS_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#if ! defined (INSIDE_LOG4CPLUS)
+#  error "This header must not be be used outside log4cplus' implementation files."
+#endif
+
+#if defined (LOG4CPLUS_ENABLE_TRACEPOINTS) && defined (__linux__) \
+    && defined (__has_include)
+#  if __has_include (<sys/sdt.h>)
+#    define LOG4CPLUS_USE_SDT_TRACEPOINTS 1
+#  endif
+#endif
+
+#if defined (LOG4CPLUS_USE_SDT_TRACEPOINTS)
+
+#include <sys/sdt.h>
+
+#define LOG4CPLUS_TRACEPOINT(name)                                      \
+    DTRACE_PROBE (log4cplus, name)
+#define LOG4CPLUS_TRACEPOINT1(name, arg1)                               \
+    DTRACE_PROBE1 (log4cplus, name, arg1)
+#define LOG4CPLUS_TRACEPOINT2(name, arg1, arg2)                         \
+    DTRACE_PROBE2 (log4cplus, name, arg1, arg2)
+#define LOG4CPLUS_TRACEPOINT3(name, arg1, arg2, arg3)                   \
+    DTRACE_PROBE3 (log4cplus, name, arg1, arg2, arg3)
+
+#else
+
+#define LOG4CPLUS_TRACEPOINT(name)                    ((void) 0)
+#define LOG4CPLUS_TRACEPOINT1(name, arg1)             ((void) 0)
+#define LOG4CPLUS_TRACEPOINT2(name, arg1, arg2)       ((void) 0)
+#define LOG4CPLUS_TRACEPOINT3(name, arg1, arg2, arg3) ((void) 0)
+
+#endif
+
+#endif // LOG4CPLUS_INTERNAL_TRACEPOINTS_HEADER_
@@ -35,6 +35,8 @@
 #include <log4cplus/tstring.h>
 #include <log4cplus/helpers/timehelper.h>
 
+#include <map>
+#include <optional>
 #include <vector>
 #include <memory>
 
@@ -80,10 +82,82 @@ namespace log4cplus {
         virtual void formatAndAppend(log4cplus::tostream& output,
             const log4cplus::spi::InternalLoggingEvent& event) = 0;
 
+        /**
+         * Format a whole batch of events into \c output in one
+         * call. The default implementation invokes formatAndAppend()
+         * for each event. Layouts can override it to amortize per
+         * event costs, e.g. virtual dispatch and cached conversions,
+         * when a batch of events is drained from a queue at once.
+         */
+        virtual void formatAndAppendBatch(log4cplus::tostream& output,
+            const log4cplus::spi::InternalLoggingEvent* events,
+            std::size_t count);
+
+        /**
+         * Returns a key identifying the output format of this layout,
+         * or 0 when its output must not be cached. Two layouts
+         * returning the same non-zero key must format any event into
+         * identical text; Appender::formatEvent() uses the key to
+         * reuse a line already formatted by an identically configured
+         * layout of another appender in the same fanout. The default
+         * implementation returns 0.
+         */
+        virtual std::size_t getFormatKey() const;
+
+        /**
+         * Returns the union of spi::EventField bits naming the
+         * thread specific event fields this layout's output
+         * references. Appenders report the value through
+         * spi::addNeededEventFields() when the layout is attached,
+         * so fields no configured layout uses are never captured.
+         * The default implementation conservatively returns
+         * spi::EventFieldAll; layouts that know their format
+         * override it.
+         */
+        virtual unsigned getNeededEventFields() const;
+
+        /**
+         * Returns the pre-rendered header text that file appenders
+         * write at the top of every freshly created log file. The
+         * text is rendered by renderHeader() on first use and the
+         * cached bytes are reused across rollovers, so metadata that
+         * is expensive to gather&mdash;hostname, process id and the
+         * like&mdash;is rendered exactly once per layout instance no
+         * matter how often the appender rolls its file. The default
+         * implementation renders an empty header.
+         */
+        tstring const & getHeader();
+
+        /**
+         * Returns the pre-rendered footer text that file appenders
+         * write before a log file is closed or rolled over. Cached
+         * the same way as getHeader().
+         */
+        tstring const & getFooter();
+
     protected:
+        /**
+         * Renders the header text returned by getHeader(). Called at
+         * most once per layout instance; the default implementation
+         * returns an empty string.
+         */
+        virtual tstring renderHeader();
+
+        //! Renders the footer text returned by getFooter(); see
+        //! renderHeader().
+        virtual tstring renderFooter();
+
         LogLevelManager& llmCache;
 
     private:
+        /** Cached output of renderHeader() and renderFooter(); valid
+         *  once the corresponding flag is set. Access is serialized
+         *  by the owning appender. */
+        tstring header;
+        tstring footer;
+        bool headerRendered = false;
+        bool footerRendered = false;
+
       // Disable copy
         Layout(const Layout&);
         Layout& operator=(Layout const &);
@@ -112,6 +186,8 @@ namespace log4cplus {
         virtual void formatAndAppend(log4cplus::tostream& output,
                                      const log4cplus::spi::InternalLoggingEvent& event);
 
+        virtual unsigned getNeededEventFields() const;
+
     private:
       // Disallow copying of instances of this class
         SimpleLayout(const SimpleLayout&);
@@ -174,6 +250,10 @@ namespace log4cplus {
         virtual void formatAndAppend(log4cplus::tostream& output,
                                      const log4cplus::spi::InternalLoggingEvent& event);
 
+        virtual void formatAndAppendBatch(log4cplus::tostream& output,
+            const log4cplus::spi::InternalLoggingEvent* events,
+            std::size_t count);
+
         bool getThreadPrinting() const;
         void setThreadPrinting(bool);
 
@@ -183,6 +263,8 @@ namespace log4cplus {
         bool getContextPrinting() const;
         void setContextPrinting(bool);
 
+        virtual unsigned getNeededEventFields() const;
+
     protected:
        log4cplus::tstring dateFormat;
        bool use_gmtime = false;
@@ -191,6 +273,20 @@ namespace log4cplus {
        bool context_printing = true;
 
     private:
+        /** Appends one formatted line for \c event to \c buf. The
+         *  TTCC field order is fixed, so the line is assembled by
+         *  direct string appends without any stream. */
+        void appendLine(log4cplus::tstring& buf,
+            const log4cplus::spi::InternalLoggingEvent& event);
+
+        /** Pre-compiled dateFormat; created on first use so that it
+         *  picks up a dateFormat assigned by a subclass after
+         *  construction. */
+        std::optional<helpers::CachedTimeFormatter> dateFormatter;
+
+        /** Scratch buffer for the relative timestamp digits. */
+        log4cplus::tstring formattedTime;
+
       // Disallow copying of instances of this class
         TTCCLayout(const TTCCLayout&);
         TTCCLayout& operator=(const TTCCLayout&);
@@ -200,6 +296,18 @@ namespace log4cplus {
     LOG4CPLUS_EXPORT helpers::Time const & getTTCCLayoutTimeBase ();
 
 
+    /**
+     * Makes every <b>%%E</b> conversion of every PatternLayout
+     * re-read its environment variable before formatting its next
+     * event. The <b>%%E</b> converters snapshot their variable when
+     * the layout is created and serve events from the snapshot; call
+     * this after setenv() when patterns should pick up the new value
+     * immediately instead of waiting for a <tt>refresh=</tt>
+     * interval.
+     */
+    LOG4CPLUS_EXPORT void refreshEnvConverters ();
+
+
     /**
      * A flexible layout configurable with pattern string.
      *
@@ -255,6 +363,17 @@ namespace log4cplus {
      * </tr>
      *
      * <tr>
+     *   <td align=center><b>#</b></td>
+     *
+     *   <td>Used to output the sequence number the delivering
+     *   appender stamped on the event, or 0 when that appender does
+     *   not number its events. Enable numbering with the appender's
+     *   <tt>SequenceNumbers</tt> property; a consumer tracking just
+     *   the last seen number then detects lost events as gaps in the
+     *   sequence.</td>
+     * </tr>
+     *
+     * <tr>
      *   <td align=center><b>b</b></td>
      *
      *   <td>Used to output file name component of path name.
@@ -341,6 +460,13 @@ namespace log4cplus {
      *
      *   For example, the pattern <b>%E{HOME}</b> will output the contents
      *   of the HOME environment variable.
+     *
+     *   <b>NOTE</b> The value is captured once when the layout is
+     *   created, not per event. Append a refresh interval, e.g.
+     *   <b>%E{HOME:refresh=30s}</b> (or <tt>500ms</tt>), to have the
+     *   variable re-read at most that often, or call
+     *   refreshEnvConverters() to re-read all cached variables at
+     *   once.
      * </td>
      * </tr>
      *
@@ -440,6 +566,18 @@ namespace log4cplus {
      * </tr>
      *
      * <tr>
+     *   <td align=center><b>R</b></td>
+     *   <td>Used to output the monotonic (steady clock) timestamp of
+     *   the logging event as microseconds since the steady clock's
+     *   epoch. Unlike the wall clock timestamp it never steps
+     *   backwards across NTP adjustments, so it orders the events of
+     *   one process reliably; the value is only meaningful within
+     *   the producing process. See the <tt>ClockSyncInterval</tt>
+     *   property for mapping these values onto the wall clock when
+     *   merging logs across hosts.</td>
+     * </tr>
+     *
+     * <tr>
      *   <td align=center><b>t</b></td>
      *
      *   <td>Used to output the thread ID of the thread that generated
@@ -504,7 +642,11 @@ namespace log4cplus {
      * either the left or the right until the minimum width is
      * reached. The default is to pad on the left (right justify) but you
      * can specify right padding with the left justification flag. The
-     * padding character is space. If the data item is larger than the
+     * padding character is space; writing the minimum field width
+     * with a leading zero (e.g. <code>%09r</code>) pads with zeros
+     * instead, which yields fixed width numeric fields. The zero flag
+     * is ignored together with left justification. If the data item
+     * is larger than the
      * minimum field width, the field is expanded to accommodate the
      * data. The value is never truncated.
      *
@@ -610,6 +752,47 @@ namespace log4cplus {
      *
      * <dt><tt>ConversionPattern</tt></dt>
      * <dd>This property specifies conversion pattern.</dd>
+     *
+     * <dt><tt>PrefixEmbeddedNewlines</tt></dt>
+     * <dd>When set to <tt>true</tt>, a message containing embedded
+     * newlines&mdash;typically a stack trace&mdash;is emitted as one
+     * formatted line per message line: the pattern's output before
+     * and after <b>%%m</b> is rendered once and replicated around
+     * every line. Consumers get a parseable prefix on each line at
+     * the cost of a single event instead of one event per line. The
+     * minimum/maximum width modifiers of <b>%%m</b> are not applied
+     * to the individual lines. Default is <tt>false</tt>.</dd>
+     *
+     * <dt><tt>ClockSyncInterval</tt></dt>
+     * <dd>When set to a nonzero number of seconds, a process-wide
+     * background thread periodically logs a record to the
+     * <tt>log4cplus.clock_sync</tt> logger pairing the steady clock
+     * value emitted by <b>%%R</b> with the wall clock
+     * (<tt>clock sync: steady_us=... wall_us=...</tt>). A cross-host
+     * log aggregator can use these records to map each host's
+     * monotonic timestamps onto a common time line instead of
+     * estimating clock skew from text timestamps. A single thread
+     * serves all layouts and runs at the shortest configured
+     * interval. Default is 0 (disabled).</dd>
+     *
+     * <dt><tt>HeaderPattern</tt></dt>
+     * <dd>A conversion pattern rendered once into the header that
+     * file appenders write at the top of every freshly created log
+     * file (see Layout::getHeader()). The rendered bytes are cached
+     * and reused across rollovers, so file metadata such as the
+     * hostname (<b>%%h</b>, <b>%%H</b>), the process id (<b>%%i</b>)
+     * or an environment variable (<b>%%E{...}</b>) is rendered
+     * exactly once and every file starts with a fixed cost,
+     * machine parseable preamble. Conversion specifiers referencing
+     * per event data are rendered from an empty synthetic event and
+     * reflect the render time; e.g. <b>%%d</b> yields the time the
+     * header was first needed. Remember the trailing <b>%%n</b>.
+     * Default is empty (no header).</dd>
+     *
+     * <dt><tt>FooterPattern</tt></dt>
+     * <dd>Like <tt>HeaderPattern</tt>, but rendered into the footer
+     * written before a log file is closed or rolled over. Default is
+     * empty (no footer).</dd>
      * </dl>
      *
      */
@@ -625,12 +808,76 @@ namespace log4cplus {
         virtual void formatAndAppend(log4cplus::tostream& output,
                                      const log4cplus::spi::InternalLoggingEvent& event);
 
+        virtual void formatAndAppendBatch(log4cplus::tostream& output,
+            const log4cplus::spi::InternalLoggingEvent* events,
+            std::size_t count);
+
+        virtual std::size_t getFormatKey() const;
+
+        virtual unsigned getNeededEventFields() const;
+
     protected:
         void init(const log4cplus::tstring& pattern, unsigned ndcMaxDepth = 0);
 
+        virtual log4cplus::tstring renderHeader();
+
+        virtual log4cplus::tstring renderFooter();
+
+        /** Renders \c bannerPattern once against an empty synthetic
+         *  event; backs renderHeader() and renderFooter(). */
+        LOG4CPLUS_PRIVATE log4cplus::tstring renderBanner(
+            const log4cplus::tstring& bannerPattern) const;
+
+        /** Appends \c event formatted once per message line, with the
+         *  pattern output surrounding <b>%%m</b> replicated around
+         *  each line. Used when <tt>PrefixEmbeddedNewlines</tt> is in
+         *  effect and the message contains a newline. */
+        LOG4CPLUS_PRIVATE void appendPerLine(log4cplus::tstring& buf,
+            const log4cplus::spi::InternalLoggingEvent& event);
+
       // Data
         log4cplus::tstring pattern;
-        std::vector<std::unique_ptr<pattern::PatternConverter> > parsedPattern;
+
+        /** Parsed converter chain. Identically configured layouts
+         *  share one immutable chain through a process wide cache
+         *  when every converter in it is immutable after
+         *  construction; chains containing converters with per
+         *  instance caches (e.g. the date converter's per second
+         *  cache) stay private to the layout. */
+        std::shared_ptr<
+            const std::vector<std::unique_ptr<pattern::PatternConverter> > >
+            parsedPattern;
+
+        /** Replicate the pattern's prefix and suffix around every
+         *  line of a multi-line message. Set by the
+         *  <tt>PrefixEmbeddedNewlines</tt> property. */
+        bool prefixEmbeddedNewlines = false;
+
+        /** Scratch strings holding the rendered output before and
+         *  after <b>%%m</b> while formatting a multi-line message;
+         *  reused across events. Access is serialized by the owning
+         *  appender. */
+        log4cplus::tstring mlPrefix;
+        log4cplus::tstring mlSuffix;
+
+        /** Non-zero hash of the pattern and options; equal values
+         *  imply identical output. See Layout::getFormatKey(). */
+        std::size_t formatKey = 0;
+
+        /** Union of the spi::EventField bits the parsed conversion
+         *  specifiers reference; computed by init(). */
+        unsigned neededEventFields = 0;
+
+        /** Seconds between clock synchronization records, or 0 when
+         *  none are emitted. Set by the <tt>ClockSyncInterval</tt>
+         *  property. */
+        unsigned clockSyncInterval = 0;
+
+        /** Patterns rendered once into the file header and footer.
+         *  Set by the <tt>HeaderPattern</tt> and
+         *  <tt>FooterPattern</tt> properties; empty means none. */
+        log4cplus::tstring headerPattern;
+        log4cplus::tstring footerPattern;
 
     private:
       // Disallow copying of instances of this class
@@ -639,6 +886,68 @@ namespace log4cplus {
     };
 
 
+    /**
+     * BinaryLayout serializes events into compact length prefixed
+     * binary records instead of formatting text, deferring all text
+     * formatting to read time on the consumer. Use the
+     * <tt>logdump</tt> tool to decode files written with this layout.
+     *
+     * Each byte of the record is written as one character of the
+     * output stream, so the appender's stream should be opened in
+     * binary mode (e.g. the <tt>TextMode=Binary</tt> property of file
+     * appenders) and no other layout should share the stream.
+     *
+     * The format is, with all integers encoded as LEB128 varints:
+     *
+     * - Once per layout instance, a header of the four magic bytes
+     *   <tt>L4CB</tt> followed by a format version byte (currently 1).
+     * - A logger definition record -- byte <tt>L</tt>, the interned
+     *   logger id, the byte length of the logger name and the name
+     *   itself in the narrow character encoding -- emitted before the
+     *   first event of each distinct logger.
+     * - An event record -- byte <tt>E</tt>, the interned logger id,
+     *   the log level, the zig-zag encoded difference in microseconds
+     *   between this event's timestamp and the previous record's (the
+     *   first record stores its full timestamp since epoch), the byte
+     *   length of the message and the message itself.
+     * - When the delivering appender has its <tt>SequenceNumbers</tt>
+     *   property enabled, a sequence record -- byte <tt>S</tt> and
+     *   the event's per appender sequence number -- immediately
+     *   precedes each event record. Gaps in the numbers tell the
+     *   consumer that events were lost.
+     */
+    class LOG4CPLUS_EXPORT BinaryLayout
+        : public Layout
+    {
+    public:
+      // Ctors and dtor
+        BinaryLayout();
+        BinaryLayout(const log4cplus::helpers::Properties& properties);
+        virtual ~BinaryLayout();
+
+        virtual void formatAndAppend(log4cplus::tostream& output,
+                                     const log4cplus::spi::InternalLoggingEvent& event);
+
+        virtual unsigned getNeededEventFields() const;
+
+    protected:
+      // Data
+        /** Logger name to interned id; ids are assigned on first use. */
+        std::map<log4cplus::tstring, std::size_t> loggerIds;
+
+        /** Timestamp of the previous record in microseconds since
+         *  epoch, the base of the next record's delta. */
+        long long lastTimestamp = 0;
+
+        /** True once the magic and version header has been written. */
+        bool headerWritten = false;
+
+    private:
+      // Disallow copying of instances of this class
+        BinaryLayout(const BinaryLayout&);
+        BinaryLayout& operator=(const BinaryLayout&);
+    };
+
 
 } // end namespace log4cplus
 
@@ -56,6 +56,19 @@ namespace log4cplus {
      * <dd>Boolean value specifying whether to use IPv6 (true) or IPv4
      * (false). Default value is false.</dd>
      *
+     * <dt><tt>MaxBatchDatagrams</tt></dt>
+     * <dd>Maximum number of datagrams coalesced into a single
+     * <tt>sendmmsg()</tt> call when a batch of events is delivered at
+     * once, e.g. through an AsyncAppender. Each event still travels
+     * in its own datagram; only the syscalls are batched. The value 1
+     * disables batching. Only effective on platforms with
+     * <tt>sendmmsg()</tt>. Default value is 64.</dd>
+     *
+     * <dt><tt>MaxBatchBytes</tt></dt>
+     * <dd>Byte budget of one <tt>sendmmsg()</tt> call; the batch is
+     * flushed early when the accumulated payloads exceed it. Default
+     * value is 65536.</dd>
+     *
      * </dl>
      */
     class LOG4CPLUS_EXPORT Log4jUdpAppender : public Appender {
@@ -74,14 +87,23 @@ namespace log4cplus {
     protected:
         void openSocket();
         virtual void append(const spi::InternalLoggingEvent& event);
+        virtual void appendBatch(const spi::InternalLoggingEvent* events,
+            std::size_t count);
 
       // Data
         log4cplus::helpers::Socket socket;
         log4cplus::tstring host;
         int port;
         bool ipv6 = false;
+        unsigned maxBatchDatagrams = 64;
+        unsigned maxBatchBytes = 65536;
 
     private:
+        //! Formats \c event into the per thread scratch pad and
+        //! returns the encoded payload.
+        LOG4CPLUS_PRIVATE std::string const & formatPayload(
+            const spi::InternalLoggingEvent& event);
+
       // Disallow copying of instances of this class
         Log4jUdpAppender(const Log4jUdpAppender&);
         Log4jUdpAppender& operator=(const Log4jUdpAppender&);
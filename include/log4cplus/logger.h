@@ -36,7 +36,13 @@
 #include <log4cplus/spi/appenderattachable.h>
 #include <log4cplus/spi/loggerfactory.h>
 
+#include <chrono>
+#include <type_traits>
+#include <utility>
 #include <vector>
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#include <log4cplus/helpers/snprintf.h>
+#endif
 
 
 namespace log4cplus
@@ -55,6 +61,18 @@ namespace log4cplus
 
     }
 
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+    namespace detail
+    {
+
+        // Defined in loggingmacros.cxx; also declared in
+        // loggingmacros.h.
+        LOG4CPLUS_EXPORT helpers::snprintf_buf &
+        get_macro_body_snprintf_buf ();
+
+    }
+#endif
+
 
     /** \typedef std::vector<Logger> LoggerList
      * This is a list of {@link Logger Loggers}. */
@@ -149,6 +167,15 @@ namespace log4cplus
          */
         static void shutdown();
 
+        /**
+         * Deadline bounded variant of shutdown(); see
+         * Hierarchy::shutdown(std::chrono::milliseconds). Use it when
+         * the process must exit within a known time even if a log
+         * sink is stuck, e.g. under a deployment system that kills
+         * slow pods.
+         */
+        static void shutdown(std::chrono::milliseconds budget);
+
       // Non-Static Methods
         /**
          * If <code>assertionVal</code> parameter is <code>false</code>, then
@@ -182,8 +209,68 @@ namespace log4cplus
             int line = LOG4CPLUS_CALLER_LINE (),
             const char* function = LOG4CPLUS_CALLER_FUNCTION ()) const;
 
+        /**
+         * Overload that moves \c message into the logging event
+         * instead of copying it.
+         */
+        void log(LogLevel ll, log4cplus::tstring&& message,
+            const char* file = LOG4CPLUS_CALLER_FILE (),
+            int line = LOG4CPLUS_CALLER_LINE (),
+            const char* function = LOG4CPLUS_CALLER_FUNCTION ()) const;
+
+        /**
+         * Overload for character pointers; it exists so that such
+         * callers do not face an ambiguity between the string view
+         * and the moving overloads.
+         */
+        void log(LogLevel ll, const log4cplus::tchar* message,
+            const char* file = LOG4CPLUS_CALLER_FILE (),
+            int line = LOG4CPLUS_CALLER_LINE (),
+            const char* function = LOG4CPLUS_CALLER_FUNCTION ()) const;
+
         void log(spi::InternalLoggingEvent const &) const;
 
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+        /**
+         * This form renders `fmt` with `args` through
+         * `std::format_to()` into a thread-local buffer before
+         * logging, bypassing the ostringstream machinery of the
+         * streaming macros.
+         */
+        template <typename... Args>
+        void log(LogLevel ll,
+            std::basic_format_string<tchar,
+                std::type_identity_t<Args>...> fmt,
+            Args &&... args) const
+        {
+            if (isEnabledFor (ll))
+                forcedLog (ll,
+                    detail::get_macro_body_snprintf_buf ().format (
+                        fmt, std::forward<Args> (args)...));
+        }
+#endif
+
+        /**
+         * Lazy form intended for messages that are expensive to
+         * render. \c message_callable is invoked to produce the
+         * message only when this logger is enabled for \c ll; it
+         * must return a string (or anything convertible to
+         * log4cplus::tstring_view). See also the LOG4CPLUS_LAZY()
+         * macro in loggingmacros.h.
+         */
+        template <typename Callable,
+            typename = std::enable_if_t<std::is_invocable_v<Callable>>>
+        void log(LogLevel ll, Callable && message_callable,
+            const char* file = LOG4CPLUS_CALLER_FILE (),
+            int line = LOG4CPLUS_CALLER_LINE (),
+            const char* function = LOG4CPLUS_CALLER_FUNCTION ()) const
+        {
+            if (isEnabledFor (ll))
+                forcedLog (ll,
+                    std::forward<Callable> (message_callable) (),
+                    file, line, function);
+        }
+
         /**
          * This method creates a new logging event and logs the event
          * without further checks.
@@ -193,6 +280,25 @@ namespace log4cplus
             int line = LOG4CPLUS_CALLER_LINE (),
             const char* function = LOG4CPLUS_CALLER_FUNCTION ()) const;
 
+        /**
+         * Overload that moves \c message into the logging event
+         * instead of copying it.
+         */
+        void forcedLog(LogLevel ll, log4cplus::tstring&& message,
+            const char* file = LOG4CPLUS_CALLER_FILE (),
+            int line = LOG4CPLUS_CALLER_LINE (),
+            const char* function = LOG4CPLUS_CALLER_FUNCTION ()) const;
+
+        /**
+         * Overload for character pointers; it exists so that such
+         * callers do not face an ambiguity between the string view
+         * and the moving overloads.
+         */
+        void forcedLog(LogLevel ll, const log4cplus::tchar* message,
+            const char* file = LOG4CPLUS_CALLER_FILE (),
+            int line = LOG4CPLUS_CALLER_LINE (),
+            const char* function = LOG4CPLUS_CALLER_FUNCTION ()) const;
+
         void forcedLog(spi::InternalLoggingEvent const &) const;
 
         /**
@@ -251,18 +357,48 @@ namespace log4cplus
          */
         void setAdditivity(bool additive);
 
+        /**
+         * Returns the maximum message size assigned to this Logger
+         * instance, 0 when the process wide default applies.
+         */
+        std::size_t getMaxMessageSize() const;
+
+        /**
+         * Sets the maximum message size for events logged through
+         * this Logger instance. Longer messages are truncated and
+         * marked with a "...[truncated]" suffix before the event is
+         * constructed, so oversized payloads never reach layouts,
+         * queues or socket buffers. 0 defers to the process wide
+         * default. Configurable with the
+         * <code>log4cplus.maxMessageSize.<i>logger</i></code>
+         * property.
+         */
+        void setMaxMessageSize(std::size_t limit);
+
+        /**
+         * Sets the process wide default maximum message size used by
+         * loggers without their own limit; 0--the initial
+         * value--disables the check. Configurable with the
+         * <code>log4cplus.maxMessageSize</code> property.
+         */
+        static void setDefaultMaxMessageSize(std::size_t limit);
+
+        //! \sa setDefaultMaxMessageSize()
+        static std::size_t getDefaultMaxMessageSize();
+
       // AppenderAttachable Methods
         virtual void addAppender(SharedAppenderPtr newAppender);
 
         virtual SharedAppenderPtrList getAllAppenders();
 
-        virtual SharedAppenderPtr getAppender(const log4cplus::tstring& name);
+        virtual SharedAppenderPtr getAppender(
+            const log4cplus::tstring_view& name);
 
         virtual void removeAllAppenders();
 
         virtual void removeAppender(SharedAppenderPtr appender);
 
-        virtual void removeAppender(const log4cplus::tstring& name);
+        virtual void removeAppender(const log4cplus::tstring_view& name);
 
         Logger () LOG4CPLUS_NOEXCEPT;
         Logger(const Logger& rhs) LOG4CPLUS_NOEXCEPT;
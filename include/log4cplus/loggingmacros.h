@@ -35,9 +35,18 @@
 #include <log4cplus/logger.h>
 #include <log4cplus/helpers/snprintf.h>
 #include <log4cplus/tracelogger.h>
+#include <atomic>
+#include <cstdint>
 #include <sstream>
 #include <utility>
 
+#if defined (LOG4CPLUS_CALL_LATENCY)
+#include <chrono>
+#if defined (_MSC_VER) && (defined (_M_IX86) || defined (_M_X64))
+#include <intrin.h>
+#endif
+#endif
+
 
 #if defined(_MSC_VER)
 #define LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()  \
@@ -129,17 +138,205 @@ LOG4CPLUS_EXPORT log4cplus::helpers::snprintf_buf & get_macro_body_snprintf_buf
 LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
     log4cplus::LogLevel, log4cplus::tstring_view const &, char const *, int,
     char const *);
+LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
+    log4cplus::LogLevel, log4cplus::tstring &&, char const *, int,
+    char const *);
 LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
     log4cplus::LogLevel, log4cplus::tchar const *, char const *, int,
     char const *);
 
 
+//! Descriptor of one logging macro site whose level has been compiled
+//! out with the LOG4CPLUS_DISABLE_* macros. When
+//! LOG4CPLUS_DORMANT_SITES is defined, such macros emit one static
+//! descriptor per call site that registers itself with a process wide
+//! registry the first time control passes its statement, and
+//! otherwise costs only one predicted-not-taken branch. The site can
+//! be switched on per call site at runtime with
+//! log4cplus::enableDormantLogSites().
+class LOG4CPLUS_EXPORT LogSite
+{
+public:
+    LogSite (char const * file, int line, char const * function,
+        LogLevel ll);
+
+    bool is_enabled () const
+    {
+        return enabled.load (std::memory_order_relaxed);
+    }
+
+    char const * const file;
+    char const * const function;
+    int const line;
+    LogLevel const ll;
+    std::atomic<bool> enabled;
+};
+
+
+//! Returns the configuration epoch of the hierarchy the logger
+//! belongs to. \sa Hierarchy::getEpoch()
+LOG4CPLUS_EXPORT unsigned hierarchy_epoch (Logger const & logger);
+
+
+//! Per call site, per thread Logger cache emitted by
+//! LOG4CPLUS_STATIC_LOGGER(). It keeps the Logger looked up under
+//! one hierarchy configuration epoch and repeats the lookup only
+//! when the epoch has moved on, so repeated use costs one relaxed
+//! epoch load instead of a mutex guarded map probe. The instance is
+//! thread local and therefore needs no synchronization of its own.
+class CachedLogger
+{
+public:
+    explicit CachedLogger (tstring_view const & name_)
+        : name (name_)
+        , logger (Logger::getInstance (name_))
+        , epoch (hierarchy_epoch (logger))
+    { }
+
+    Logger const &
+    get ()
+    {
+        unsigned const current = hierarchy_epoch (logger);
+        if (LOG4CPLUS_UNLIKELY (epoch != current))
+        {
+            logger = Logger::getInstance (name);
+            epoch = current;
+        }
+
+        return logger;
+    }
+
+private:
+    tstring const name;
+    Logger logger;
+    unsigned epoch;
+};
+
+
+//! Files one cycle count delta spent inside a logging macro into the
+//! calling thread's log-scale latency histogram.
+LOG4CPLUS_EXPORT void record_call_latency (std::uint64_t cycles);
+
+
+#if defined (LOG4CPLUS_CALL_LATENCY)
+
+//! Reads the CPU cycle counter. On targets without an accessible
+//! cycle counter it falls back to std::chrono::steady_clock ticks,
+//! so the histogram buckets then hold clock ticks instead of cycles.
+inline
+std::uint64_t
+call_latency_now ()
+{
+#if defined (_MSC_VER) && (defined (_M_IX86) || defined (_M_X64))
+    return __rdtsc ();
+#elif (defined (__GNUC__) || defined (__clang__)) \
+    && (defined (__i386__) || defined (__x86_64__))
+    return __builtin_ia32_rdtsc ();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::steady_clock::now ().time_since_epoch ().count ());
+#endif
+}
+
+
+//! Scope guard emitted into the logging macro bodies when
+//! LOG4CPLUS_CALL_LATENCY is defined. It brackets the whole macro
+//! body--including the level check and a suppressed call--with two
+//! cycle counter reads and files the delta through
+//! record_call_latency().
+class CallLatencyProbe
+{
+public:
+    CallLatencyProbe ()
+        : start (call_latency_now ())
+    { }
+
+    ~CallLatencyProbe ()
+    {
+        record_call_latency (call_latency_now () - start);
+    }
+
+private:
+    std::uint64_t const start;
+
+    CallLatencyProbe (CallLatencyProbe const &) = delete;
+    CallLatencyProbe & operator = (CallLatencyProbe const &) = delete;
+};
+
+#endif // LOG4CPLUS_CALL_LATENCY
+
 
 } // namespace detail
 
+
+/**
+ * Histogram of time spent inside the logging macros, harvested
+ * through getCallLatencyHistogram(). The histogram is only filled by
+ * code compiled with the LOG4CPLUS_CALL_LATENCY macro defined;
+ * without it the logging macros carry no instrumentation at all.
+ */
+struct CallLatencyHistogram
+{
+    //! Number of recorded macro invocations.
+    std::uint64_t count = 0;
+
+    //! Log-scale buckets of cycle counter deltas. <tt>buckets[i]</tt>
+    //! counts invocations whose delta <tt>d</tt> satisfies
+    //! <tt>2^i <= d < 2^(i+1)</tt>; bucket 0 also counts zero deltas.
+    std::uint64_t buckets[64] = { };
+};
+
+
+/**
+ * Returns the summed log call latency histograms of all threads,
+ * including threads that have already exited. The per thread buckets
+ * are maintained with relaxed atomics on the logging path; the sum is
+ * not a consistent cut across threads but each individual bucket
+ * value is exact.
+ * \sa CallLatencyHistogram
+ */
+LOG4CPLUS_EXPORT CallLatencyHistogram getCallLatencyHistogram ();
+
+
+/**
+ * Switches dormant logging macro sites on or off at runtime. A site
+ * matches when \c fileSubstring occurs in its source file name and,
+ * when \c line is not -1, its line number matches too. The rule is
+ * remembered and also applied to matching sites that register later.
+ *
+ * Dormant sites are emitted by the logging macros for levels disabled
+ * with the LOG4CPLUS_DISABLE_* macros when LOG4CPLUS_DORMANT_SITES is
+ * defined. An enabled site logs unconditionally, bypassing its
+ * logger's level threshold, like the kernel's dynamic debug facility.
+ *
+ * @return Number of already registered sites the rule switched.
+ */
+LOG4CPLUS_EXPORT std::size_t enableDormantLogSites (
+    tstring const & fileSubstring, int line = -1, bool enable = true);
+
+
 } // namespace log4cplus
 
 
+/**
+ * Yields a reference to a cached Logger named \c name. The Logger is
+ * cached per call site and per thread, so repeated executions of the
+ * same statement cost a thread-local read plus one relaxed epoch
+ * check instead of the mutex guarded map probe of
+ * Logger::getInstance(). The cache refreshes itself when the
+ * hierarchy's configuration epoch changes, i.e. after
+ * Hierarchy::shutdown(), Hierarchy::resetConfiguration() or
+ * Hierarchy::clear().
+ */
+#define LOG4CPLUS_STATIC_LOGGER(name)                                   \
+    ([] (log4cplus::tstring_view const & _log4cplus_logger_name)        \
+        -> log4cplus::Logger const & {                                  \
+        static thread_local log4cplus::detail::CachedLogger             \
+            _log4cplus_cached_logger (_log4cplus_logger_name);          \
+        return _log4cplus_cached_logger.get ();                         \
+    } (name))
+
+
 #undef LOG4CPLUS_MACRO_FUNCTION
 #define LOG4CPLUS_MACRO_FUNCTION() nullptr
 #if ! defined (LOG4CPLUS_DISABLE_FUNCTION_MACRO)
@@ -208,9 +405,37 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
 #endif
 
 
+// Extract the message text assembled in the macro body ostringstream.
+// With C++20's efficient access to the underlying std::stringbuf the
+// text is borrowed as a string view for the duration of the call
+// instead of being copied into a temporary string.
+// Also check for libstdc++ >= 11, which implements the view() members
+// in C++20 mode without advertising __cpp_lib_sstream_from_view.
+#if (defined (__cpp_lib_sstream_from_view)                              \
+        && __cpp_lib_sstream_from_view >= 202106L)                      \
+    || (__cplusplus >= 202002L && defined (_GLIBCXX_RELEASE)            \
+        && _GLIBCXX_RELEASE >= 11)
+#  define LOG4CPLUS_MACRO_OSS_STRING(buf) (buf).rdbuf ()->view ()
+#else
+#  define LOG4CPLUS_MACRO_OSS_STRING(buf) (buf).str ()
+#endif
+
+
+// Instrument the macro bodies with a cycle counting scope guard when
+// the application is compiled with LOG4CPLUS_CALL_LATENCY; otherwise
+// the probe compiles to nothing.
+#if defined (LOG4CPLUS_CALL_LATENCY)
+#define LOG4CPLUS_MACRO_LATENCY_PROBE()                                 \
+    log4cplus::detail::CallLatencyProbe _log4cplus_latency_probe
+#else
+#define LOG4CPLUS_MACRO_LATENCY_PROBE() static_cast<void>(0)
+#endif
+
+
 #define LOG4CPLUS_MACRO_BODY(logger, logEvent, logLevel)                \
     LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
     do {                                                                \
+        LOG4CPLUS_MACRO_LATENCY_PROBE ();                               \
         log4cplus::Logger const & _l                                    \
             = log4cplus::detail::macros_get_logger (logger);            \
         if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                             \
@@ -218,7 +443,8 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
             LOG4CPLUS_MACRO_INSTANTIATE_OSTRINGSTREAM (_log4cplus_buf); \
             _log4cplus_buf << logEvent;                                 \
             log4cplus::detail::macro_forced_log (_l,                    \
-                log4cplus::logLevel, _log4cplus_buf.str(),              \
+                log4cplus::logLevel,                                    \
+                LOG4CPLUS_MACRO_OSS_STRING (_log4cplus_buf),            \
                 LOG4CPLUS_MACRO_FILE (), __LINE__,                      \
                 LOG4CPLUS_MACRO_FUNCTION ());                           \
         }                                                               \
@@ -229,6 +455,7 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
 #define LOG4CPLUS_MACRO_STR_BODY(logger, logEvent, logLevel)            \
     LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
     do {                                                                \
+        LOG4CPLUS_MACRO_LATENCY_PROBE ();                               \
         log4cplus::Logger const & _l                                    \
             = log4cplus::detail::macros_get_logger (logger);            \
         if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                             \
@@ -244,13 +471,14 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
 #define LOG4CPLUS_MACRO_FMT_BODY(logger, logLevel, ...)                 \
     LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
     do {                                                                \
+        LOG4CPLUS_MACRO_LATENCY_PROBE ();                               \
         log4cplus::Logger const & _l                                    \
             = log4cplus::detail::macros_get_logger (logger);            \
         if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                             \
                 _l.isEnabledFor (log4cplus::logLevel), logLevel)) {     \
             LOG4CPLUS_MACRO_INSTANTIATE_SNPRINTF_BUF (_snpbuf);         \
-            log4cplus::tchar const * _logEvent                          \
-                = _snpbuf.print (__VA_ARGS__);                          \
+            log4cplus::tstring_view const _logEvent                     \
+                = _snpbuf.print_view (__VA_ARGS__);                     \
             log4cplus::detail::macro_forced_log (_l,                    \
                 log4cplus::logLevel, _logEvent,                         \
                 LOG4CPLUS_MACRO_FILE (), __LINE__,                      \
@@ -259,6 +487,107 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
     } while(0)                                                          \
     LOG4CPLUS_RESTORE_DOWHILE_WARNING()
 
+// Render the message with C++20 std::format_to() into the
+// thread-local snprintf_buf, skipping the ostringstream machinery
+// entirely. Only available when the standard library implements
+// std::format; see LOG4CPLUS_HAVE_STD_FORMAT in config.hxx.
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_MACRO_STDFMT_BODY(logger, logLevel, ...)              \
+    LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
+    do {                                                                \
+        LOG4CPLUS_MACRO_LATENCY_PROBE ();                               \
+        log4cplus::Logger const & _l                                    \
+            = log4cplus::detail::macros_get_logger (logger);            \
+        if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                             \
+                _l.isEnabledFor (log4cplus::logLevel), logLevel)) {     \
+            LOG4CPLUS_MACRO_INSTANTIATE_SNPRINTF_BUF (_snpbuf);         \
+            log4cplus::detail::macro_forced_log (_l,                    \
+                log4cplus::logLevel,                                    \
+                _snpbuf.format (__VA_ARGS__),                           \
+                LOG4CPLUS_MACRO_FILE (), __LINE__,                      \
+                LOG4CPLUS_MACRO_FUNCTION ());                           \
+        }                                                               \
+    } while(0)                                                          \
+    LOG4CPLUS_RESTORE_DOWHILE_WARNING()
+#endif
+
+// When LOG4CPLUS_DORMANT_SITES is defined, the macros for levels
+// disabled with LOG4CPLUS_DISABLE_* compile to a dormant site instead
+// of nothing: a static log4cplus::detail::LogSite descriptor plus one
+// predicted-not-taken branch. Switching the site on at runtime with
+// log4cplus::enableDormantLogSites() makes it log unconditionally.
+#define LOG4CPLUS_MACRO_DORMANT_SITE_PRED(logLevel)                     \
+        static log4cplus::detail::LogSite _log4cplus_site (             \
+            LOG4CPLUS_MACRO_FILE (), __LINE__,                          \
+            LOG4CPLUS_MACRO_FUNCTION (), log4cplus::logLevel);          \
+        if (LOG4CPLUS_UNLIKELY (_log4cplus_site.is_enabled ()))
+
+#define LOG4CPLUS_MACRO_DORMANT_BODY(logger, logEvent, logLevel)        \
+    LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
+    do {                                                                \
+        LOG4CPLUS_MACRO_DORMANT_SITE_PRED (logLevel) {                  \
+            log4cplus::Logger const & _l                                \
+                = log4cplus::detail::macros_get_logger (logger);        \
+            LOG4CPLUS_MACRO_INSTANTIATE_OSTRINGSTREAM (_log4cplus_buf); \
+            _log4cplus_buf << logEvent;                                 \
+            log4cplus::detail::macro_forced_log (_l,                    \
+                log4cplus::logLevel,                                    \
+                LOG4CPLUS_MACRO_OSS_STRING (_log4cplus_buf),            \
+                LOG4CPLUS_MACRO_FILE (), __LINE__,                      \
+                LOG4CPLUS_MACRO_FUNCTION ());                           \
+        }                                                               \
+    } while (0)                                                         \
+    LOG4CPLUS_RESTORE_DOWHILE_WARNING()
+
+#define LOG4CPLUS_MACRO_DORMANT_STR_BODY(logger, logEvent, logLevel)    \
+    LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
+    do {                                                                \
+        LOG4CPLUS_MACRO_DORMANT_SITE_PRED (logLevel) {                  \
+            log4cplus::Logger const & _l                                \
+                = log4cplus::detail::macros_get_logger (logger);        \
+            log4cplus::detail::macro_forced_log (_l,                    \
+                log4cplus::logLevel, logEvent,                          \
+                LOG4CPLUS_MACRO_FILE (), __LINE__,                      \
+                LOG4CPLUS_MACRO_FUNCTION ());                           \
+        }                                                               \
+    } while(0)                                                          \
+    LOG4CPLUS_RESTORE_DOWHILE_WARNING()
+
+#define LOG4CPLUS_MACRO_DORMANT_FMT_BODY(logger, logLevel, ...)         \
+    LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
+    do {                                                                \
+        LOG4CPLUS_MACRO_DORMANT_SITE_PRED (logLevel) {                  \
+            log4cplus::Logger const & _l                                \
+                = log4cplus::detail::macros_get_logger (logger);        \
+            LOG4CPLUS_MACRO_INSTANTIATE_SNPRINTF_BUF (_snpbuf);         \
+            log4cplus::tstring_view const _logEvent                     \
+                = _snpbuf.print_view (__VA_ARGS__);                     \
+            log4cplus::detail::macro_forced_log (_l,                    \
+                log4cplus::logLevel, _logEvent,                         \
+                LOG4CPLUS_MACRO_FILE (), __LINE__,                      \
+                LOG4CPLUS_MACRO_FUNCTION ());                           \
+        }                                                               \
+    } while(0)                                                          \
+    LOG4CPLUS_RESTORE_DOWHILE_WARNING()
+
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_MACRO_DORMANT_STDFMT_BODY(logger, logLevel, ...)      \
+    LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
+    do {                                                                \
+        LOG4CPLUS_MACRO_DORMANT_SITE_PRED (logLevel) {                  \
+            log4cplus::Logger const & _l                                \
+                = log4cplus::detail::macros_get_logger (logger);        \
+            LOG4CPLUS_MACRO_INSTANTIATE_SNPRINTF_BUF (_snpbuf);         \
+            log4cplus::detail::macro_forced_log (_l,                    \
+                log4cplus::logLevel,                                    \
+                _snpbuf.format (__VA_ARGS__),                           \
+                LOG4CPLUS_MACRO_FILE (), __LINE__,                      \
+                LOG4CPLUS_MACRO_FUNCTION ());                           \
+        }                                                               \
+    } while(0)                                                          \
+    LOG4CPLUS_RESTORE_DOWHILE_WARNING()
+#endif
+
 /**
  * @def LOG4CPLUS_TRACE(logger, logEvent) This macro creates a
  * TraceLogger to log a TRACE_LOG_LEVEL message to <code>logger</code>
@@ -276,12 +605,36 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
     LOG4CPLUS_MACRO_STR_BODY (logger, logEvent, TRACE_LOG_LEVEL)
 #define LOG4CPLUS_TRACE_FMT(logger, ...)                                \
     LOG4CPLUS_MACRO_FMT_BODY (logger, TRACE_LOG_LEVEL, __VA_ARGS__)
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_TRACE_STDFMT(logger, ...)                             \
+    LOG4CPLUS_MACRO_STDFMT_BODY (logger, TRACE_LOG_LEVEL, __VA_ARGS__)
+#endif
 
 #else
+// Method entry/exit tracing has no single forced-log site to park, so
+// it compiles out even with dormant sites enabled.
 #define LOG4CPLUS_TRACE_METHOD(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
+#if defined (LOG4CPLUS_DORMANT_SITES)
+#define LOG4CPLUS_TRACE(logger, logEvent)                               \
+    LOG4CPLUS_MACRO_DORMANT_BODY (logger, logEvent, TRACE_LOG_LEVEL)
+#define LOG4CPLUS_TRACE_STR(logger, logEvent)                           \
+    LOG4CPLUS_MACRO_DORMANT_STR_BODY (logger, logEvent, TRACE_LOG_LEVEL)
+#define LOG4CPLUS_TRACE_FMT(logger, ...)                                \
+    LOG4CPLUS_MACRO_DORMANT_FMT_BODY (logger, TRACE_LOG_LEVEL, __VA_ARGS__)
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_TRACE_STDFMT(logger, ...)                             \
+    LOG4CPLUS_MACRO_DORMANT_STDFMT_BODY (logger, TRACE_LOG_LEVEL,       \
+        __VA_ARGS__)
+#endif
+
+#else
 #define LOG4CPLUS_TRACE(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_TRACE_STR(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_TRACE_FMT(logger, logFmt, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_TRACE_STDFMT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+#endif
 
 #endif
 
@@ -297,11 +650,33 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
     LOG4CPLUS_MACRO_STR_BODY (logger, logEvent, DEBUG_LOG_LEVEL)
 #define LOG4CPLUS_DEBUG_FMT(logger, ...)                                \
     LOG4CPLUS_MACRO_FMT_BODY (logger, DEBUG_LOG_LEVEL, __VA_ARGS__)
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_DEBUG_STDFMT(logger, ...)                             \
+    LOG4CPLUS_MACRO_STDFMT_BODY (logger, DEBUG_LOG_LEVEL, __VA_ARGS__)
+#endif
+
+#else
+#if defined (LOG4CPLUS_DORMANT_SITES)
+#define LOG4CPLUS_DEBUG(logger, logEvent)                               \
+    LOG4CPLUS_MACRO_DORMANT_BODY (logger, logEvent, DEBUG_LOG_LEVEL)
+#define LOG4CPLUS_DEBUG_STR(logger, logEvent)                           \
+    LOG4CPLUS_MACRO_DORMANT_STR_BODY (logger, logEvent, DEBUG_LOG_LEVEL)
+#define LOG4CPLUS_DEBUG_FMT(logger, ...)                                \
+    LOG4CPLUS_MACRO_DORMANT_FMT_BODY (logger, DEBUG_LOG_LEVEL, __VA_ARGS__)
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_DEBUG_STDFMT(logger, ...)                             \
+    LOG4CPLUS_MACRO_DORMANT_STDFMT_BODY (logger, DEBUG_LOG_LEVEL,       \
+        __VA_ARGS__)
+#endif
 
 #else
 #define LOG4CPLUS_DEBUG(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_DEBUG_STR(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_DEBUG_FMT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_DEBUG_STDFMT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+#endif
 
 #endif
 
@@ -317,11 +692,33 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
     LOG4CPLUS_MACRO_STR_BODY (logger, logEvent, INFO_LOG_LEVEL)
 #define LOG4CPLUS_INFO_FMT(logger, ...)                                 \
     LOG4CPLUS_MACRO_FMT_BODY (logger, INFO_LOG_LEVEL, __VA_ARGS__)
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_INFO_STDFMT(logger, ...)                              \
+    LOG4CPLUS_MACRO_STDFMT_BODY (logger, INFO_LOG_LEVEL, __VA_ARGS__)
+#endif
+
+#else
+#if defined (LOG4CPLUS_DORMANT_SITES)
+#define LOG4CPLUS_INFO(logger, logEvent)                                \
+    LOG4CPLUS_MACRO_DORMANT_BODY (logger, logEvent, INFO_LOG_LEVEL)
+#define LOG4CPLUS_INFO_STR(logger, logEvent)                            \
+    LOG4CPLUS_MACRO_DORMANT_STR_BODY (logger, logEvent, INFO_LOG_LEVEL)
+#define LOG4CPLUS_INFO_FMT(logger, ...)                                 \
+    LOG4CPLUS_MACRO_DORMANT_FMT_BODY (logger, INFO_LOG_LEVEL, __VA_ARGS__)
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_INFO_STDFMT(logger, ...)                              \
+    LOG4CPLUS_MACRO_DORMANT_STDFMT_BODY (logger, INFO_LOG_LEVEL,        \
+        __VA_ARGS__)
+#endif
 
 #else
 #define LOG4CPLUS_INFO(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_INFO_STR(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_INFO_FMT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_INFO_STDFMT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+#endif
 
 #endif
 
@@ -337,11 +734,33 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
     LOG4CPLUS_MACRO_STR_BODY (logger, logEvent, WARN_LOG_LEVEL)
 #define LOG4CPLUS_WARN_FMT(logger, ...)                                 \
     LOG4CPLUS_MACRO_FMT_BODY (logger, WARN_LOG_LEVEL, __VA_ARGS__)
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_WARN_STDFMT(logger, ...)                              \
+    LOG4CPLUS_MACRO_STDFMT_BODY (logger, WARN_LOG_LEVEL, __VA_ARGS__)
+#endif
+
+#else
+#if defined (LOG4CPLUS_DORMANT_SITES)
+#define LOG4CPLUS_WARN(logger, logEvent)                                \
+    LOG4CPLUS_MACRO_DORMANT_BODY (logger, logEvent, WARN_LOG_LEVEL)
+#define LOG4CPLUS_WARN_STR(logger, logEvent)                            \
+    LOG4CPLUS_MACRO_DORMANT_STR_BODY (logger, logEvent, WARN_LOG_LEVEL)
+#define LOG4CPLUS_WARN_FMT(logger, ...)                                 \
+    LOG4CPLUS_MACRO_DORMANT_FMT_BODY (logger, WARN_LOG_LEVEL, __VA_ARGS__)
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_WARN_STDFMT(logger, ...)                              \
+    LOG4CPLUS_MACRO_DORMANT_STDFMT_BODY (logger, WARN_LOG_LEVEL,        \
+        __VA_ARGS__)
+#endif
 
 #else
 #define LOG4CPLUS_WARN(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_WARN_STR(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_WARN_FMT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_WARN_STDFMT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+#endif
 
 #endif
 
@@ -357,11 +776,33 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
     LOG4CPLUS_MACRO_STR_BODY (logger, logEvent, ERROR_LOG_LEVEL)
 #define LOG4CPLUS_ERROR_FMT(logger, ...)                                \
     LOG4CPLUS_MACRO_FMT_BODY (logger, ERROR_LOG_LEVEL, __VA_ARGS__)
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_ERROR_STDFMT(logger, ...)                             \
+    LOG4CPLUS_MACRO_STDFMT_BODY (logger, ERROR_LOG_LEVEL, __VA_ARGS__)
+#endif
+
+#else
+#if defined (LOG4CPLUS_DORMANT_SITES)
+#define LOG4CPLUS_ERROR(logger, logEvent)                               \
+    LOG4CPLUS_MACRO_DORMANT_BODY (logger, logEvent, ERROR_LOG_LEVEL)
+#define LOG4CPLUS_ERROR_STR(logger, logEvent)                           \
+    LOG4CPLUS_MACRO_DORMANT_STR_BODY (logger, logEvent, ERROR_LOG_LEVEL)
+#define LOG4CPLUS_ERROR_FMT(logger, ...)                                \
+    LOG4CPLUS_MACRO_DORMANT_FMT_BODY (logger, ERROR_LOG_LEVEL, __VA_ARGS__)
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_ERROR_STDFMT(logger, ...)                             \
+    LOG4CPLUS_MACRO_DORMANT_STDFMT_BODY (logger, ERROR_LOG_LEVEL,       \
+        __VA_ARGS__)
+#endif
 
 #else
 #define LOG4CPLUS_ERROR(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_ERROR_STR(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_ERROR_FMT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_ERROR_STDFMT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+#endif
 
 #endif
 
@@ -377,14 +818,63 @@ LOG4CPLUS_EXPORT void macro_forced_log (log4cplus::Logger const &,
     LOG4CPLUS_MACRO_STR_BODY (logger, logEvent, FATAL_LOG_LEVEL)
 #define LOG4CPLUS_FATAL_FMT(logger, ...)                                \
     LOG4CPLUS_MACRO_FMT_BODY (logger, FATAL_LOG_LEVEL, __VA_ARGS__)
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_FATAL_STDFMT(logger, ...)                             \
+    LOG4CPLUS_MACRO_STDFMT_BODY (logger, FATAL_LOG_LEVEL, __VA_ARGS__)
+#endif
+
+#else
+#if defined (LOG4CPLUS_DORMANT_SITES)
+#define LOG4CPLUS_FATAL(logger, logEvent)                               \
+    LOG4CPLUS_MACRO_DORMANT_BODY (logger, logEvent, FATAL_LOG_LEVEL)
+#define LOG4CPLUS_FATAL_STR(logger, logEvent)                           \
+    LOG4CPLUS_MACRO_DORMANT_STR_BODY (logger, logEvent, FATAL_LOG_LEVEL)
+#define LOG4CPLUS_FATAL_FMT(logger, ...)                                \
+    LOG4CPLUS_MACRO_DORMANT_FMT_BODY (logger, FATAL_LOG_LEVEL, __VA_ARGS__)
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_FATAL_STDFMT(logger, ...)                             \
+    LOG4CPLUS_MACRO_DORMANT_STDFMT_BODY (logger, FATAL_LOG_LEVEL,       \
+        __VA_ARGS__)
+#endif
 
 #else
 #define LOG4CPLUS_FATAL(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_FATAL_STR(logger, logEvent) LOG4CPLUS_DOWHILE_NOTHING()
 #define LOG4CPLUS_FATAL_FMT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#if defined (LOG4CPLUS_HAVE_STD_FORMAT)
+#define LOG4CPLUS_FATAL_STDFMT(logger, ...) LOG4CPLUS_DOWHILE_NOTHING()
+#endif
+#endif
 
 #endif
 
+/**
+ * @def LOG4CPLUS_LAZY(logger, logLevel, messageCallable) This macro
+ * invokes <code>messageCallable</code> to render the message only
+ * when <code>logger</code> is enabled for <code>logLevel</code>,
+ * which must be one of the bare <code>*_LOG_LEVEL</code> tokens
+ * (e.g., <code>DEBUG_LOG_LEVEL</code>). The callable must take no
+ * arguments and return a string or anything else convertible to
+ * <code>log4cplus::tstring_view</code>. Use it when producing the
+ * message is expensive (serialization, dumps) relative to the level
+ * check.
+ */
+#define LOG4CPLUS_LAZY(logger, logLevel, messageCallable)               \
+    LOG4CPLUS_SUPPRESS_DOWHILE_WARNING()                                \
+    do {                                                                \
+        log4cplus::Logger const & _l                                    \
+            = log4cplus::detail::macros_get_logger (logger);            \
+        if (LOG4CPLUS_MACRO_LOGLEVEL_PRED (                             \
+                _l.isEnabledFor (log4cplus::logLevel), logLevel)) {     \
+            log4cplus::detail::macro_forced_log (_l,                    \
+                log4cplus::logLevel, (messageCallable) (),              \
+                LOG4CPLUS_MACRO_FILE (), __LINE__,                      \
+                LOG4CPLUS_MACRO_FUNCTION ());                           \
+        }                                                               \
+    } while (0)                                                         \
+    LOG4CPLUS_RESTORE_DOWHILE_WARNING()
+
+
 //! Helper macro for LOG4CPLUS_ASSERT() macro.
 #define LOG4CPLUS_ASSERT_STRINGIFY(X) #X
 
@@ -32,6 +32,8 @@
 #pragma once
 #endif
 
+#include <array>
+#include <atomic>
 #include <vector>
 #include <memory>
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
@@ -148,8 +150,11 @@ namespace log4cplus {
          * This method is called by all Layout classes to convert a LogLevel
          * into a string.
          *
-         * Note: It traverses the list of <code>LogLevelToStringMethod</code>
-         *       to do this, so all "derived" LogLevels are recognized as well.
+         * Note: Levels registered through pushLogLevel() resolve via
+         *       a frozen lookup table; only translators registered
+         *       through pushLogLevelTranslator() are traversed, as a
+         *       fallback, so all "derived" LogLevels are recognized
+         *       as well.
          */
         log4cplus::tstring const & toString(LogLevel ll) const;
 
@@ -157,8 +162,11 @@ namespace log4cplus {
          * This method is called by all classes internally to log4cplus to
          * convert a string into a LogLevel.
          *
-         * Note: It traverses the list of <code>StringToLogLevelMethod</code>
-         *       to do this, so all "derived" LogLevels are recognized as well.
+         * Note: Levels registered through pushLogLevel() resolve via
+         *       a frozen lookup table; only translators registered
+         *       through pushLogLevelTranslator() are traversed, as a
+         *       fallback, so all "derived" LogLevels are recognized
+         *       as well.
          */
         LogLevel fromString(const log4cplus::tstring_view& arg) const;
 
@@ -167,6 +175,15 @@ namespace log4cplus {
 
         void pushLogLevelTranslator(SharedLogLevelTranslatorPtr);
 
+        /**
+         * Invalidates the dense level name cache maintained by
+         * toString(). Registration methods call it automatically;
+         * a translator whose mapping can change after it has been
+         * registered (e.g. the C API's custom log level manager)
+         * must call it whenever its mapping changes.
+         */
+        void invalidateNameCache();
+
     private:
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
         mutable std::shared_mutex mtx;
@@ -175,6 +192,40 @@ namespace log4cplus {
         typedef std::vector<SharedLogLevelTranslatorPtr> LogLevelTranslatorList;
         LogLevelTranslatorList translator_list;
 
+        struct LevelTableEntry;
+
+        /** Frozen lookup table of all levels whose mapping is known
+         *  at registration time - the standard levels and everything
+         *  registered through pushLogLevel(). Entries are heap
+         *  allocated so that references handed out by toString() stay
+         *  valid when the table grows; both orderings are rebuilt on
+         *  registration, which is rare, and binary searched on
+         *  lookup, so neither direction iterates translators for
+         *  these levels. Only translators registered through
+         *  pushLogLevelTranslator() - whose mappings cannot be
+         *  enumerated - are still walked, as a fallback. */
+        std::vector<std::unique_ptr<LevelTableEntry>> level_table;
+
+        /** The same entries ordered by numeric value, for
+         *  toString(). */
+        std::vector<LevelTableEntry const *> level_table_by_value;
+
+        LOG4CPLUS_PRIVATE void addLevelTableEntry (LogLevel ll,
+            tstring name, bool visible_to_fromstring = true);
+
+        /** Number of name_cache slots; covers levels up to
+         *  OFF_LOG_LEVEL with room to spare. */
+        static std::size_t const name_cache_size = 64;
+
+        /** Dense cache of resolved level names, indexed by
+         *  <code>LogLevel / 1000</code> for levels that are multiples
+         *  of 1000 (all standard and typical custom levels). Slots
+         *  are filled lazily from the translator walk and cleared by
+         *  invalidateNameCache(), so the per event toString() path is
+         *  a single indexed pointer load. */
+        mutable std::array<std::atomic<tstring const *>, name_cache_size>
+            name_cache;
+
         // Disable Copy
         LogLevelManager(const LogLevelManager&);
         LogLevelManager& operator=(const LogLevelManager&);
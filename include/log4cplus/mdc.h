@@ -34,13 +34,20 @@
 #include <log4cplus/tstring.h>
 
 #include <map>
+#include <memory>
 
 
 namespace log4cplus
 {
 
 
-typedef std::map<tstring, tstring> MappedDiagnosticContextMap;
+// The transparent comparator allows lookups with tstring_view keys
+// without materializing a tstring.
+typedef std::map<tstring, tstring, std::less<>> MappedDiagnosticContextMap;
+
+//! Immutable, reference counted snapshot of the MDC of a thread.
+typedef std::shared_ptr<MappedDiagnosticContextMap const>
+    MappedDiagnosticContextMapPtr;
 
 
 class LOG4CPLUS_EXPORT MDC
@@ -49,28 +56,89 @@ public:
     /**
      * Clear any nested diagnostic information if any. This method is
      * useful in cases where the same thread can be potentially used
-     * over and over in different unrelated contexts.
+     * over and over in different unrelated contexts. When the
+     * thread's map is not shared with any event snapshot, it is
+     * emptied in place so its allocation is reused by later put()
+     * calls.
      */
     void clear();
 
     void put (tstring const & key, tstring const & value);
-    bool get (tstring * value, tstring const & key) const;
-    void remove (tstring const & key);
+    //! Move overloads; they move the strings into the map instead of
+    //! copying them, e.g. for the per request
+    //! <code>put (LOG4CPLUS_TEXT ("rid"), std::move (requestId))</code>
+    //! pattern.
+    void put (tstring const & key, tstring && value);
+    void put (tstring && key, tstring && value);
+    bool get (tstring * value, tstring_view key) const;
+    void remove (tstring_view key);
 
     MappedDiagnosticContextMap const & getContext () const;
 
+    /**
+     * Returns a reference counted snapshot of the context of the
+     * current thread. The snapshot is immutable; later put(),
+     * remove() or clear() calls replace the thread's map instead of
+     * mutating it (copy-on-write), so capturing the context into a
+     * logging event costs a reference count bump instead of a map
+     * copy. The returned pointer is never null.
+     */
+    MappedDiagnosticContextMapPtr getContextSnapshot () const;
+
     // Public ctor and dtor but only to be used by internal::DefaultContext.
     MDC ();
     virtual ~MDC ();
 
 private:
-    LOG4CPLUS_PRIVATE static MappedDiagnosticContextMap * getPtr ();
+    friend class MDCGuard;
+
+    LOG4CPLUS_PRIVATE static std::shared_ptr<MappedDiagnosticContextMap> &
+        getStorage ();
 };
 
 
 LOG4CPLUS_EXPORT MDC & getMDC ();
 
 
+/**
+ * This class puts a key/value pair into the MDC of the current
+ * thread for the duration of a scope and removes it again--or
+ * restores the value it shadowed--when the scope is left, even in
+ * the face of exceptions. It is the MDC counterpart of
+ * NDCContextCreator.
+ *
+ * Only a view of \c key is stored in the guard; the caller's key
+ * storage must outlive the guard, which the usual declaration order
+ * of a per request handler gives for free (the guard is destroyed,
+ * and the key removed from the map, before the storage it views).
+ * The characters of both strings are copied into the map itself,
+ * because context snapshots captured by logging events may outlive
+ * the scope. The map node released by the destructor is recycled
+ * through a bounded per thread pool together with its string
+ * storage, so repeated guards--e.g. one per served request--are
+ * allocation free in steady state as long as no snapshot pins the
+ * map.
+ */
+class LOG4CPLUS_EXPORT MDCGuard
+{
+public:
+    MDCGuard (tstring_view key, tstring_view value);
+
+    MDCGuard () = delete;
+    MDCGuard (MDCGuard const &) = delete;
+    MDCGuard (MDCGuard &&) = delete;
+    MDCGuard & operator= (MDCGuard const &) = delete;
+    MDCGuard & operator= (MDCGuard &&) = delete;
+
+    ~MDCGuard ();
+
+private:
+    tstring_view key;
+    tstring oldValue;
+    bool hadOldValue;
+};
+
+
 } // namespace log4cplus
 
 
@@ -205,6 +205,10 @@ namespace log4cplus {
          */
         void push(const log4cplus::tstring& message);
         void push(tchar const * message);
+        //! View overload; the characters are copied into recycled
+        //! per thread storage, so no temporary tstring is created
+        //! and push/pop pairs stay allocation free in steady state.
+        void push(log4cplus::tstring_view message);
 
         /**
          * Remove the diagnostic context for this thread.
@@ -262,6 +266,14 @@ namespace log4cplus {
       // Methods
         LOG4CPLUS_PRIVATE static DiagnosticContextStack* getPtr();
 
+        /**
+         * Moves the top of <code>stack</code> into the per thread
+         * pool of recycled contexts (up to a bounded depth) so that a
+         * later push() can reuse its string storage.
+         */
+        LOG4CPLUS_PRIVATE static void recycle_back (
+            DiagnosticContextStack & stack);
+
         template <typename StringType>
         LOG4CPLUS_PRIVATE
         void push_worker (StringType const &);
@@ -284,6 +296,7 @@ namespace log4cplus {
     struct LOG4CPLUS_EXPORT DiagnosticContext
     {
       // Ctors
+        DiagnosticContext() = default;
         DiagnosticContext(const log4cplus::tstring& message,
             DiagnosticContext const * parent);
         DiagnosticContext(tchar const * message,
@@ -300,6 +313,13 @@ namespace log4cplus {
       // Data
         log4cplus::tstring message; /*!< The message at this context level. */
         log4cplus::tstring fullMessage; /*!< The entire message stack. */
+
+        /** True when fullMessage is up to date with the parent
+         *  chain. NDC::push() leaves contexts invalid and NDC::get()
+         *  builds the concatenation on first demand, so pushes on
+         *  paths that never render the full context stay cheap.
+         */
+        bool fullMessageValid = true;
     };
 
 
@@ -312,6 +332,10 @@ namespace log4cplus {
         /** Pushes <code>msg</code> onto the NDC stack. */
         explicit NDCContextCreator(const log4cplus::tstring& msg);
         explicit NDCContextCreator(tchar const * msg);
+        /** View overload; <code>msg</code> is copied into recycled
+         *  per thread storage, so a guard built from caller-owned
+         *  characters does not allocate in steady state. */
+        explicit NDCContextCreator(log4cplus::tstring_view msg);
 
         NDCContextCreator() = delete;
         NDCContextCreator(NDCContextCreator const &) = delete;
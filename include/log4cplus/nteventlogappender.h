@@ -38,7 +38,14 @@
 namespace log4cplus {
 
     /**
-     * Appends log events to NT EventLog. 
+     * Appends log events to NT EventLog.
+     *
+     * Batches delivered through <code>doAppendBatch()</code> are
+     * coalesced into one <code>ReportEvent()</code> call per run of
+     * events mapping onto the same event type and category, carrying
+     * one string per event, so a drain cycle (e.g. behind an
+     * AsyncAppender or with <tt>AsyncAppend</tt>) pays the RPC round
+     * trip once per run instead of once per event.
      */
     class LOG4CPLUS_EXPORT NTEventLogAppender : public Appender {
     public:
@@ -56,6 +63,13 @@ namespace log4cplus {
 
     protected:
         virtual void append(const spi::InternalLoggingEvent& event);
+
+        /** Reports runs of events with equal event type and category
+         *  through a single ReportEvent() call with multiple
+         *  strings. */
+        virtual void appendBatch(const spi::InternalLoggingEvent* events,
+            std::size_t count);
+
         virtual WORD getEventType(const spi::InternalLoggingEvent& event);
         virtual WORD getEventCategory(const spi::InternalLoggingEvent& event);
         void init();
@@ -30,18 +30,51 @@
 #pragma once
 #endif
 
+#include <vector>
+
 #include <log4cplus/appender.h>
 
 
 namespace log4cplus {
 
     /**
-     * Appends log events to a file. 
+     * Discards every log event. Besides silencing a logger, this is
+     * the calibration appender for performance triage: by choosing
+     * how much of the append pipeline runs before the event is
+     * thrown away, the cost of each stage of a real appender falls
+     * out by subtraction (see tests/performance_test).
+     *
+     * <h3>Properties</h3>
+     * <dl>
+     * <dt><tt>CalibrationMode</tt></dt>
+     * <dd>How much work to do per event before discarding it:
+     * <tt>"Discard"</tt> skips the layout entirely and measures bare
+     * appender dispatch, <tt>"Format"</tt> runs the configured
+     * layout and discards the formatted line, and
+     * <tt>"FormatAndCopy"</tt> additionally copies the line into a
+     * throwaway buffer, approximating an appender that formats and
+     * hands the bytes off without doing I/O. Default value is
+     * <tt>"Discard"</tt>.</dd>
+     * </dl>
      */
     class LOG4CPLUS_EXPORT NullAppender : public Appender {
     public:
+        //! Pipeline stage after which an event is discarded, from
+        //! the CalibrationMode property.
+        enum CalibrationMode
+        {
+            //! Discard immediately; the layout never runs.
+            Discard,
+            //! Format the event, then discard the line.
+            Format,
+            //! Format the event and copy the line into a throwaway
+            //! buffer, then discard both.
+            FormatAndCopy
+        };
+
       // Ctors
         NullAppender();
+        explicit NullAppender(CalibrationMode mode);
         NullAppender(const log4cplus::helpers::Properties&);
 
       // Dtor
@@ -53,6 +86,13 @@ namespace log4cplus {
     protected:
         virtual void append(const log4cplus::spi::InternalLoggingEvent& event);
 
+        CalibrationMode calibrationMode = Discard;
+
+        //! Throwaway destination of the FormatAndCopy mode, reused
+        //! across events so the copy is measured without the
+        //! allocation.
+        std::vector<tchar> scratch;
+
     private:
       // Disallow copying of instances of this class
         NullAppender(const NullAppender&);
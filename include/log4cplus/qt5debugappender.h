@@ -88,6 +88,13 @@ public:
 protected:
     virtual void append (spi::InternalLoggingEvent const &);
 
+    /** Emits each run of events with the same severity class as one
+     *  newline joined Qt logging call, so bursts drained through
+     *  doAppendBatch() cost one handler invocation per run instead
+     *  of one per event. */
+    virtual void appendBatch (spi::InternalLoggingEvent const * events,
+        std::size_t count);
+
 private:
     Qt5DebugAppender (Qt5DebugAppender const &);
     Qt5DebugAppender & operator = (Qt5DebugAppender const &);
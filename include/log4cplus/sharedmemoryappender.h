@@ -0,0 +1,146 @@
+// -*- C++ -*-
+// Module:  LOG4CPLUS
+// File:    sharedmemoryappender.h
+// Created: 8/2026
+// Author:  Vaclav Zeman
+//
+//
+//  Copyright (C) 2026, Vaclav Zeman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** @file */
+
+#ifndef LOG4CPLUS_SHARED_MEMORY_APPENDER_HEADER_
+#define LOG4CPLUS_SHARED_MEMORY_APPENDER_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#if defined (LOG4CPLUS_HAVE_SYS_MMAN_H) && ! defined (_WIN32)
+
+#include <log4cplus/appender.h>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+
+namespace log4cplus {
+
+    /**
+     * Appends framed, formatted log events to a named POSIX shared
+     * memory ring buffer so that many processes on one host can share
+     * a single log file writer. The write path is lock-free: an event
+     * is reserved in the ring with one atomic compare-and-swap, copied
+     * in and then published, so processes never block each other and a
+     * process crashing mid-append cannot wedge the others. When the
+     * ring is full events are dropped and counted instead of blocking
+     * the logging process.
+     *
+     * A single companion drainer process attaches to the same ring
+     * with SharedMemoryAppender::Drainer and writes the merged stream
+     * to a file, collapsing per-host log I/O to one writer.
+     *
+     * <h3>Properties</h3>
+     * <dl>
+     * <dt><tt>MemoryName</tt></dt>
+     * <dd>Mandatory name of the POSIX shared memory object, e.g.
+     * <tt>/log4cplus-ring</tt>. All producers and the drainer must
+     * use the same name.</dd>
+     *
+     * <dt><tt>MemorySize</tt></dt>
+     * <dd>Size in bytes of the ring data area; rounded up to a power
+     * of two. It is fixed by whoever creates the shared memory object
+     * first. The default is 4 MiB.</dd>
+     * </dl>
+     */
+    class LOG4CPLUS_EXPORT SharedMemoryAppender : public Appender {
+    public:
+      // Ctors
+        SharedMemoryAppender(const log4cplus::tstring& memoryName,
+            std::size_t memorySize = 4 * 1024 * 1024);
+        SharedMemoryAppender(const log4cplus::helpers::Properties & properties);
+
+      // Dtor
+        ~SharedMemoryAppender();
+
+      // Methods
+        virtual void close();
+
+        /**
+         * Consumes framed events from a shared memory ring written by
+         * SharedMemoryAppender producers. Intended for the single
+         * companion drainer process; it is not safe to run more than
+         * one drainer against the same ring.
+         */
+        class LOG4CPLUS_EXPORT Drainer {
+        public:
+            Drainer (const log4cplus::tstring& memoryName);
+            ~Drainer ();
+
+            /**
+             * Writes all currently published events to \c out and
+             * returns the number of bytes written. A producer that
+             * crashed mid-append is skipped after the unfinished
+             * frame has been seen at the head of the ring for
+             * \c stallLimit consecutive calls.
+             */
+            std::size_t drainOnce (std::ostream & out,
+                unsigned stallLimit = 100);
+
+            //! Number of events producers have dropped so far because
+            //! the ring was full.
+            std::size_t getDroppedCount () const;
+
+        private:
+            struct Data;
+            std::unique_ptr<Data> data;
+
+            Drainer (const Drainer &);
+            Drainer & operator= (const Drainer &);
+        };
+
+    protected:
+        virtual void append(const spi::InternalLoggingEvent& event);
+
+      // Data
+        log4cplus::tstring memoryName;
+        std::size_t memorySize;
+
+        struct Ring;
+        std::unique_ptr<Ring> ring;
+
+    private:
+        LOG4CPLUS_PRIVATE void init();
+
+      // Disallow copying of instances of this class
+        SharedMemoryAppender(const SharedMemoryAppender&);
+        SharedMemoryAppender& operator=(const SharedMemoryAppender&);
+    };
+
+} // end namespace log4cplus
+
+#endif // LOG4CPLUS_HAVE_SYS_MMAN_H && ! _WIN32
+
+#endif // LOG4CPLUS_SHARED_MEMORY_APPENDER_HEADER_
@@ -30,8 +30,13 @@
 #pragma once
 #endif
 
+#include <memory>
+#include <vector>
+
 #include <log4cplus/appender.h>
+#include <log4cplus/helpers/compressor.h>
 #include <log4cplus/helpers/socket.h>
+#include <log4cplus/helpers/queue.h>
 #include <log4cplus/thread/syncprims.h>
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/helpers/connectorthread.h>
@@ -46,6 +51,27 @@ namespace log4cplus
     std::size_t const LOG4CPLUS_MAX_MESSAGE_SIZE = 2*8*1024;
 #endif
 
+    //! Version byte of single event frames produced by
+    //! helpers::convertToBuffer().
+    extern LOG4CPLUS_EXPORT int const LOG4CPLUS_MESSAGE_VERSION;
+
+    //! Version byte of batch frames produced by
+    //! helpers::convertBatchToBuffer(). Receivers distinguish the two
+    //! framings by the first payload byte.
+    extern LOG4CPLUS_EXPORT int const LOG4CPLUS_BATCH_MESSAGE_VERSION;
+
+    //! Version byte of the one byte heartbeat frame sent by
+    //! SocketAppender when <tt>HeartbeatInterval</tt> is set.
+    //! Receivers discard these frames; their only purpose is to make
+    //! a dead connection fail fast.
+    extern LOG4CPLUS_EXPORT int const LOG4CPLUS_HEARTBEAT_MESSAGE_VERSION;
+
+    //! Version byte of a compressed envelope frame sent by
+    //! SocketAppender when <tt>Compress</tt> is set. The payload is
+    //! the version byte, the 32 bit uncompressed size and a deflate
+    //! stream that inflates to a concatenation of ordinary frames.
+    extern LOG4CPLUS_EXPORT int const LOG4CPLUS_COMPRESSED_MESSAGE_VERSION;
+
 
     /**
      * Sends {@link spi::InternalLoggingEvent} objects to a remote a log server.
@@ -93,6 +119,21 @@ namespace log4cplus
      * <dt><tt>port</tt></dt>
      * <dd>Port on remote host to send events to.</dd>
      *
+     * <dt><tt>Hosts</tt></dt>
+     * <dd>Comma separated list of <tt>host:port</tt> destinations,
+     * e.g. <tt>"agg1:9998,agg2:9998"</tt>, for shipping every event
+     * to several aggregation servers at once. The first entry
+     * becomes the primary destination, overriding <tt>host</tt> and
+     * <tt>port</tt>; each event is serialized once and the same
+     * buffer is written to every destination, instead of attaching
+     * one appender per destination and paying the serialization per
+     * copy. Every destination keeps its own connection health and
+     * reconnects independently through a connector thread, so one
+     * dead aggregation cluster does not stop shipping to the others.
+     * An entry without <tt>:port</tt> uses the <tt>port</tt>
+     * property. Destinations beyond the first are ignored in single
+     * threaded builds.</dd>
+     *
      * <dt><tt>ServerName</tt></dt>
      * <dd>Host name of event's origin prepended to each event.</dd>
      *
@@ -100,6 +141,129 @@ namespace log4cplus
      * <dd>Boolean value specifying whether to use IPv6 (true) or IPv4
      * (false). Default value is false.</dd>
      *
+     * <dt><tt>AsyncSend</tt></dt>
+     * <dd>Boolean value. When true, events are enqueued into an
+     * internal bounded queue and written to the network by a
+     * dedicated sender thread, so that logging threads never block on
+     * TCP backpressure. Default value is false. The property is
+     * ignored in single threaded builds.</dd>
+     *
+     * <dt><tt>QueueLimit</tt></dt>
+     * <dd>Maximum number of events that can be queued up for the
+     * sender thread. Producers block when the queue is full. Only
+     * used together with <tt>AsyncSend</tt>. Default value is
+     * 100.</dd>
+     *
+     * <dt><tt>ConnectionPoolSize</tt></dt>
+     * <dd>Number of pooled connections the sender thread round-robins
+     * batches over, so that throughput can scale past a single TCP
+     * stream's bandwidth-delay product. Only used together with
+     * <tt>AsyncSend</tt>. Default value is 1.</dd>
+     *
+     * <dt><tt>BatchFraming</tt></dt>
+     * <dd>Boolean value. When true, batches of events are sent as a
+     * single batch frame that carries a shared dictionary for
+     * repeated logger names, thread ids, files and functions, instead
+     * of one frame per event, which substantially reduces bandwidth.
+     * The bundled loggingserver accepts both framings; leave this off
+     * when sending to receivers that only understand single event
+     * frames. Default value is false.</dd>
+     *
+     * <dt><tt>TCPKeepAlive</tt></dt>
+     * <dd>Boolean value. When true, TCP keepalive probing is enabled
+     * on the connection so that peers that died without closing the
+     * connection (e.g. behind NAT) are detected by the kernel.
+     * Default value is false.</dd>
+     *
+     * <dt><tt>TCPKeepAliveIdle</tt></dt>
+     * <dd>Seconds of idle time before the first keepalive probe is
+     * sent. Zero keeps the system default. Only used together with
+     * <tt>TCPKeepAlive</tt>.</dd>
+     *
+     * <dt><tt>TCPKeepAliveInterval</tt></dt>
+     * <dd>Seconds between keepalive probes. Zero keeps the system
+     * default. Only used together with <tt>TCPKeepAlive</tt>.</dd>
+     *
+     * <dt><tt>TCPKeepAliveCount</tt></dt>
+     * <dd>Number of unanswered keepalive probes after which the
+     * connection is dropped. Zero keeps the system default. Only used
+     * together with <tt>TCPKeepAlive</tt>.</dd>
+     *
+     * <dt><tt>TCPUserTimeout</tt></dt>
+     * <dd>Milliseconds transmitted data may stay unacknowledged
+     * before the connection is forcibly closed, where the platform
+     * supports it (TCP_USER_TIMEOUT). This bounds how long a write
+     * into a dead connection can stall. Default value is 0 (system
+     * default).</dd>
+     *
+     * <dt><tt>ConnectTimeout</tt></dt>
+     * <dd>Milliseconds a connection attempt may take before it is
+     * abandoned. A black-holed endpoint (e.g. a dropped route) can
+     * otherwise block a blocking connect() for the operating
+     * system's TCP timeout, which is minutes on common systems.
+     * Default value is 0 (system default).</dd>
+     *
+     * <dt><tt>DeferConnect</tt></dt>
+     * <dd>When true, the constructor does not connect; the connector
+     * thread establishes the connection in the background instead.
+     * The appender is usable immediately but events logged before
+     * the connection is up are dropped, exactly as after a broken
+     * connection. Useful when slow DNS or an unreachable server must
+     * not delay configuration. Default value is false. Ignored in
+     * single threaded builds.</dd>
+     *
+     * <dt><tt>HeartbeatInterval</tt></dt>
+     * <dd>Seconds between heartbeat frames sent over an otherwise
+     * idle connection by the connector thread. A failed heartbeat
+     * write marks the connection broken and reconnects immediately,
+     * so dead peers are detected within roughly one interval even
+     * when nothing is being logged. The bundled loggingserver
+     * discards heartbeat frames; leave this at the default of 0
+     * (disabled) when sending to receivers that do not understand
+     * them. Ignored in single threaded builds.</dd>
+     *
+     * <dt><tt>Compress</tt></dt>
+     * <dd>Boolean value. When true, batched writes -- appendBatch()
+     * output, the sender thread's drains and the elastic send
+     * buffer's chunks -- are sent as deflate compressed envelope
+     * frames, which text logs typically shrink several fold. The
+     * bundled loggingserver inflates them transparently; leave this
+     * off when sending to receivers that do not understand the
+     * envelope framing. Frames written one at a time by append() are
+     * not compressed; they are too small to gain anything. Requires
+     * a build with zlib support (<tt>WITH_ZLIB</tt>), otherwise the
+     * property is ignored with a warning. Default value is
+     * false.</dd>
+     *
+     * <dt><tt>SendBufferSize</tt></dt>
+     * <dd>Size in bytes of an internal elastic send buffer, acting
+     * as its high watermark. When non zero, append() copies each
+     * serialized frame into the buffer and returns, and a dedicated
+     * flusher thread drains the buffer to the server with large
+     * writes over its own connection, so that event rate spikes are
+     * absorbed by memory instead of blocking logging threads on TCP
+     * backpressure. When the buffer reaches the high watermark the
+     * <tt>SendBufferOverflowPolicy</tt> applies. Default value is 0
+     * (disabled). Ignored together with <tt>AsyncSend</tt>, which
+     * subsumes it, and in single threaded builds.</dd>
+     *
+     * <dt><tt>SendBufferLowWatermark</tt></dt>
+     * <dd>Number of buffered bytes at which the flusher thread is
+     * woken, so that under load each write to the network carries at
+     * least this much data. Smaller amounts are flushed after a
+     * short interval anyway; the watermark only batches writes, it
+     * never delays events indefinitely. Default value is half of
+     * <tt>SendBufferSize</tt>. Only used together with
+     * <tt>SendBufferSize</tt>.</dd>
+     *
+     * <dt><tt>SendBufferOverflowPolicy</tt></dt>
+     * <dd>What happens to an event when the send buffer is at its
+     * high watermark: <tt>"Block"</tt> makes the logging thread wait
+     * until the flusher has freed space, <tt>"DropNewest"</tt>
+     * discards the incoming event. Default value is
+     * <tt>"Block"</tt>. Only used together with
+     * <tt>SendBufferSize</tt>.</dd>
+     *
      * </dl>
      */
     class LOG4CPLUS_EXPORT SocketAppender
@@ -124,7 +288,31 @@ namespace log4cplus
     protected:
         void openSocket();
         void initConnector ();
+        //! Applies the configured keepalive and user timeout options
+        //! to a freshly connected socket.
+        LOG4CPLUS_PRIVATE void applySocketOptions (helpers::Socket & sock);
         virtual void append(const spi::InternalLoggingEvent& event);
+        virtual void appendBatch(const spi::InternalLoggingEvent* events,
+            std::size_t count);
+        //! Serializes the batch once and writes it to \c sock; with
+        //! \c replicate also to every connected replica destination,
+        //! reusing the serialized buffers. The return value reflects
+        //! the write to \c sock only.
+        LOG4CPLUS_PRIVATE bool writeBatch(helpers::Socket & sock,
+            const spi::InternalLoggingEvent* events, std::size_t count,
+            bool replicate = false);
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+        //! Concatenates the already serialized frame buffers,
+        //! compresses them and writes the result to \c sock as one
+        //! envelope frame; with \c replicate also to every connected
+        //! replica destination. Falls back to writing the buffers
+        //! uncompressed when compression fails.
+        LOG4CPLUS_PRIVATE bool writeCompressed(helpers::Socket & sock,
+            std::size_t bufferCount,
+            helpers::SocketBuffer const * const * buffers,
+            bool replicate);
+#endif
 
       // Data
         log4cplus::helpers::Socket socket;
@@ -132,15 +320,106 @@ namespace log4cplus
         unsigned int port;
         log4cplus::tstring serverName;
         bool ipv6 = false;
+        bool batchFraming = false;
+        bool tcpKeepAlive = false;
+        unsigned tcpKeepAliveIdle = 0;
+        unsigned tcpKeepAliveInterval = 0;
+        unsigned tcpKeepAliveCount = 0;
+        unsigned tcpUserTimeout = 0;
+        unsigned connectTimeout = 0;
+        unsigned heartbeatInterval = 0;
+        bool compressStream = false;
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+        //! Reusable compression context and buffers of the Compress
+        //! option. Used only by writeCompressed(), whose callers are
+        //! serialized: either logging threads under access_mutex, or
+        //! a single sender or flusher thread that owns the write
+        //! path while it is running.
+        helpers::FrameCompressor compressor;
+        std::vector<char> compress_in;
+        std::vector<char> compress_out;
+#endif
+
+        //! Serialization buffers reused by append() across events so
+        //! that each logged event does not heap allocate them anew.
+        //! Access is serialized by the appender's access_mutex like
+        //! the rest of the append path.
+        helpers::SocketBuffer msgBuffer {0};
+        helpers::SocketBuffer sizeBuffer {sizeof (unsigned int)};
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
         virtual thread::Mutex const & ctcGetAccessMutex () const;
         virtual helpers::Socket & ctcGetSocket ();
         virtual helpers::Socket ctcConnect ();
         virtual void ctcSetConnected ();
+        virtual void ctcHeartbeat ();
+
+        class SenderThread;
+
+        LOG4CPLUS_PRIVATE void initSender (unsigned queue_len);
+        LOG4CPLUS_PRIVATE void sendBatch (
+            const spi::InternalLoggingEvent* events, std::size_t count);
+        LOG4CPLUS_PRIVATE helpers::Socket * pickSocket ();
+
+        //! One replicated destination beyond the primary host,
+        //! with its own socket, health flag and connector thread.
+        struct Endpoint;
+
+        LOG4CPLUS_PRIVATE void initReplicas (
+            std::vector<std::pair<tstring, unsigned> > const & destinations);
+        //! Writes the already serialized buffers to every connected
+        //! replica, marking failed ones broken and triggering their
+        //! reconnection.
+        LOG4CPLUS_PRIVATE void replicateBuffers (std::size_t bufferCount,
+            helpers::SocketBuffer const * const * buffers);
+
+        class FlusherThread;
+
+        //! Starts the flusher thread draining the elastic send
+        //! buffer enabled by the SendBufferSize property.
+        LOG4CPLUS_PRIVATE void initSendBuffer ();
+        //! Copies the already serialized frame buffers into the send
+        //! buffer, applying the overflow policy when the buffer is at
+        //! its high watermark. Runs in logging threads under the
+        //! appender's access_mutex.
+        LOG4CPLUS_PRIVATE void bufferFrames (std::size_t bufferCount,
+            helpers::SocketBuffer const * const * buffers);
 
         volatile bool connected;
         helpers::SharedObjectPtr<helpers::ConnectorThread> connector;
+
+        bool asyncSend = false;
+        unsigned connectionPoolSize = 1;
+
+        //! Pooled connections, touched only by the sender thread.
+        std::vector<helpers::Socket> socketPool;
+        std::size_t nextSocket = 0;
+
+        //! Replicated destinations beyond the primary host, from the
+        //! Hosts property.
+        std::vector<std::unique_ptr<Endpoint> > replicas;
+
+        thread::QueuePtr queue;
+        thread::AbstractThreadPtr sender_thread;
+
+        //! Elastic send buffer state, from the SendBuffer*
+        //! properties. send_buffer_mutex is separate from the
+        //! appender's access_mutex so that the flusher swapping the
+        //! buffer out never waits behind a logging thread and vice
+        //! versa.
+        std::size_t sendBufferSize = 0;
+        std::size_t sendBufferLowWatermark = 0;
+        bool sendBufferDrop = false;
+        thread::Mutex send_buffer_mutex;
+        thread::ManualResetEvent send_buffer_data {false};
+        thread::ManualResetEvent send_buffer_space {false};
+        std::vector<char> send_buffer;
+        bool send_buffer_exit = false;
+        //! Frames discarded by the DropNewest overflow policy;
+        //! touched only under the appender's access_mutex.
+        std::size_t droppedFrames = 0;
+        thread::AbstractThreadPtr flusher_thread;
 #endif
 
     private:
@@ -157,6 +436,22 @@ namespace log4cplus
 
         LOG4CPLUS_EXPORT
         log4cplus::spi::InternalLoggingEvent readFromBuffer(SocketBuffer& buffer);
+
+        //! Serializes the whole batch into a single batch frame
+        //! (LOG4CPLUS_BATCH_MESSAGE_VERSION) with a shared string
+        //! dictionary for repeated logger names, thread ids, files and
+        //! functions. The returned buffer is sized exactly for the
+        //! batch.
+        LOG4CPLUS_EXPORT
+        std::unique_ptr<SocketBuffer> convertBatchToBuffer (
+            const log4cplus::spi::InternalLoggingEvent* events,
+            std::size_t count, const log4cplus::tstring& serverName);
+
+        //! Parses a batch frame produced by convertBatchToBuffer() and
+        //! appends the contained events to <code>events</code>.
+        LOG4CPLUS_EXPORT
+        void readBatchFromBuffer(SocketBuffer& buffer,
+            std::vector<log4cplus::spi::InternalLoggingEvent>& events);
     } // end namespace helpers
 
 } // end namespace log4cplus
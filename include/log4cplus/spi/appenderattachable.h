@@ -60,7 +60,8 @@ namespace log4cplus {
             /**
              * Get an appender by name.
              */
-            virtual SharedAppenderPtr getAppender(const log4cplus::tstring& name) = 0;
+            virtual SharedAppenderPtr getAppender(
+                const log4cplus::tstring_view& name) = 0;
 
             /**
              * Remove all previously added appenders.
@@ -76,7 +77,8 @@ namespace log4cplus {
              * Remove the appender with the name passed as parameter from the
              * list of appenders.
              */
-            virtual void removeAppender(const log4cplus::tstring& name) = 0;
+            virtual void removeAppender(
+                const log4cplus::tstring_view& name) = 0;
 
           // Dtor
             virtual ~AppenderAttachable() = 0;
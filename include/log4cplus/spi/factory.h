@@ -41,6 +41,9 @@
 
 
 namespace log4cplus {
+
+    class RolloverStrategy;
+
     namespace spi {
 
         /**
@@ -116,6 +119,25 @@ namespace log4cplus {
         };
 
 
+        /**
+         * This abstract class defines the "Factory" interface to create
+         * "RolloverStrategy" objects.
+         */
+        class LOG4CPLUS_EXPORT RolloverStrategyFactory : public BaseFactory {
+        public:
+            typedef RolloverStrategy ProductType;
+            typedef helpers::SharedObjectPtr<RolloverStrategy> ProductPtr;
+
+            RolloverStrategyFactory();
+            virtual ~RolloverStrategyFactory() = 0;
+
+            /**
+             * Create a "RolloverStrategy" object.
+             */
+            virtual ProductPtr createObject(const log4cplus::helpers::Properties& props) = 0;
+        };
+
+
         /**
          * This abstract class defines the "Factory" interface to
          * create std::locale instances.
@@ -171,7 +193,7 @@ namespace log4cplus {
              * Used to retrieve an object from the registry.  (The registry
              * owns the returned pointer.)
              */
-            T* get(const log4cplus::tstring& name) const {
+            T* get(tstring_view name) const {
                 return static_cast<T*>(getVal(name));
             }
 
@@ -185,6 +207,8 @@ namespace log4cplus {
         typedef FactoryRegistry<AppenderFactory> AppenderFactoryRegistry;
         typedef FactoryRegistry<LayoutFactory> LayoutFactoryRegistry;
         typedef FactoryRegistry<FilterFactory> FilterFactoryRegistry;
+        typedef FactoryRegistry<RolloverStrategyFactory>
+            RolloverStrategyFactoryRegistry;
         typedef FactoryRegistry<LocaleFactory> LocaleFactoryRegistry;
 
 
@@ -203,6 +227,12 @@ namespace log4cplus {
          */
         LOG4CPLUS_EXPORT FilterFactoryRegistry& getFilterFactoryRegistry();
 
+        /**
+         * Returns the "singleton" <code>RolloverStrategyFactoryRegistry</code>.
+         */
+        LOG4CPLUS_EXPORT RolloverStrategyFactoryRegistry&
+            getRolloverStrategyFactoryRegistry();
+
         /**
          * Returns the "singleton" <code>LocaleFactoryRegistry</code>.
          */
@@ -265,6 +295,10 @@ namespace log4cplus {
         LOG4CPLUS_REG_PRODUCT (reg, "log4cplus::spi::", filtername, log4cplus::spi::, \
             log4cplus::spi::FilterFactory)
 
+        #define LOG4CPLUS_REG_ROLLOVER_STRATEGY(reg, strategyname)            \
+        LOG4CPLUS_REG_PRODUCT (reg, "log4cplus::", strategyname, log4cplus::, \
+            log4cplus::spi::RolloverStrategyFactory)
+
         #define LOG4CPLUS_REG_LOCALE(reg, name, factory)            \
             reg.put (std::unique_ptr<log4cplus::spi::LocaleFactory> ( \
                     new factory (name)))
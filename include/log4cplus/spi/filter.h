@@ -32,9 +32,14 @@
 #endif
 
 #include <functional>
+#include <map>
+#include <memory>
+#include <optional>
 
 #include <log4cplus/helpers/pointer.h>
 #include <log4cplus/loglevel.h>
+#include <log4cplus/tstring.h>
+#include <log4cplus/thread/syncprims.h>
 
 
 namespace log4cplus {
@@ -77,6 +82,25 @@ namespace log4cplus {
         typedef helpers::SharedObjectPtr<Filter> FilterPtr;
 
 
+        /**
+         * Compiles a filter chain into a single flat predicate.
+         *
+         * When every link of <code>chain</code> is one of the stock
+         * filters ({@link DenyAllFilter}, {@link LogLevelMatchFilter},
+         * {@link LogLevelRangeFilter}, {@link StringMatchFilter}), the
+         * chain is replaced by one filter holding a flat array of
+         * decision steps that is evaluated without a virtual call per
+         * link. The compiled filter returns exactly what walking the
+         * original chain would return. Chains containing any other
+         * filter type are returned unchanged, as are empty chains.
+         *
+         * This is called at configuration time; it must not be used on
+         * a chain that will be mutated afterwards through
+         * {@link Filter#appendFilter}.
+         */
+        LOG4CPLUS_EXPORT FilterPtr compileFilterChain (FilterPtr const & chain);
+
+
         /**
          * Users should extend this class to implement customized logging
          * event filtering. Note that the {@link Logger} and {@link
@@ -189,6 +213,8 @@ namespace log4cplus {
             virtual FilterResult decide(const InternalLoggingEvent& event) const;
 
         private:
+            friend FilterPtr compileFilterChain (FilterPtr const &);
+
           // Methods
             LOG4CPLUS_PRIVATE void init();
 
@@ -237,6 +263,8 @@ namespace log4cplus {
             virtual FilterResult decide(const InternalLoggingEvent& event) const;
 
         private:
+            friend FilterPtr compileFilterChain (FilterPtr const &);
+
           // Methods
             LOG4CPLUS_PRIVATE void init();
 
@@ -272,6 +300,8 @@ namespace log4cplus {
             virtual FilterResult decide(const InternalLoggingEvent& event) const;
 
         private:
+            friend FilterPtr compileFilterChain (FilterPtr const &);
+
           // Methods
             LOG4CPLUS_PRIVATE void init();
 
@@ -279,6 +309,10 @@ namespace log4cplus {
             /** Do we return ACCEPT when a match occurs. Default is <code>true</code>. */
             bool acceptOnMatch;
             log4cplus::tstring stringToMatch;
+            /** Boyer-Moore-Horspool tables precomputed from
+             *  stringToMatch, so that each event pays only the scan. */
+            std::optional<std::boyer_moore_horspool_searcher<
+                log4cplus::tstring::const_iterator>> searcher;
         };
 
         /**
@@ -398,6 +432,73 @@ namespace log4cplus {
                 log4cplus::tstring mdcValueToMatch;
         };
 
+        /**
+         * This filter sheds excess logging events per logger using a
+         * token bucket and optional 1-in-N sampling, so that floods
+         * of low importance events are dropped before any layout or
+         * formatting cost is paid.
+         *
+         * The filter admits four options <b>LogLevelMax</b>,
+         * <b>RatePerSecond</b>, <b>BurstSize</b> and
+         * <b>SampleEvery</b>.
+         *
+         * Events with a LogLevel above <b>LogLevelMax</b> are never
+         * shed; {@link #NEUTRAL} is returned for them without
+         * touching the bucket. When <b>LogLevelMax</b> is not set,
+         * all events are subject to shedding.
+         *
+         * When <b>SampleEvery</b> is N greater than 1, only every Nth
+         * event of each logger is kept; the rest are denied.
+         *
+         * When <b>RatePerSecond</b> is non-zero, each logger gets a
+         * token bucket holding at most <b>BurstSize</b> tokens
+         * (default <b>RatePerSecond</b>) refilled at
+         * <b>RatePerSecond</b> tokens per second. An event that finds
+         * the bucket empty is denied. Events that pass both checks
+         * get {@link #NEUTRAL} so that later filters are still
+         * consulted.
+         *
+         * The per logger counters are atomic; the shedding decision
+         * itself does not take any lock.
+         */
+        class LOG4CPLUS_EXPORT RateLimitFilter : public Filter {
+        public:
+          // ctors and dtor
+            RateLimitFilter();
+            RateLimitFilter(const log4cplus::helpers::Properties& p);
+            virtual ~RateLimitFilter();
+
+            /**
+             * Returns {@link #DENY} for events shed by sampling or by
+             * an empty token bucket, {@link #NEUTRAL} otherwise.
+             */
+            virtual FilterResult decide(const InternalLoggingEvent& event) const;
+
+        private:
+          // Types
+            //! Per logger token bucket and sampling counter.
+            struct LoggerState;
+
+          // Methods
+            LOG4CPLUS_PRIVATE void init();
+            LOG4CPLUS_PRIVATE LoggerState & getLoggerState (
+                tstring const & logger) const;
+
+          // Data
+            /** Events above this LogLevel are never shed. */
+            LogLevel logLevelMax;
+            /** Token bucket refill rate; 0 disables rate limiting. */
+            unsigned ratePerSecond;
+            /** Token bucket capacity. */
+            unsigned burstSize;
+            /** Keep one event in this many; 1 disables sampling. */
+            unsigned sampleEvery;
+
+            mutable std::map<tstring, std::unique_ptr<LoggerState>>
+                loggerStates;
+            mutable thread::Mutex mutex;
+        };
+
     } // end namespace spi
 } // end namespace log4cplus
 
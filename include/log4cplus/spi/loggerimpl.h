@@ -34,6 +34,8 @@
 #include <log4cplus/helpers/appenderattachableimpl.h>
 #include <log4cplus/helpers/pointer.h>
 #include <log4cplus/spi/loggerfactory.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -91,6 +93,14 @@ namespace log4cplus {
                              const char* file=nullptr, int line=-1,
                              const char* function=nullptr);
 
+            /**
+             * Overload that moves \c message into the logging event
+             * instead of copying it.
+             */
+            virtual void log(LogLevel ll, log4cplus::tstring&& message,
+                             const char* file=nullptr, int line=-1,
+                             const char* function=nullptr);
+
             virtual void log(spi::InternalLoggingEvent const &);
 
             /**
@@ -111,9 +121,10 @@ namespace log4cplus {
             LogLevel getLogLevel() const { return this->ll; }
 
             /**
-             * Set the LogLevel of this Logger.
+             * Set the LogLevel of this Logger. This invalidates the
+             * cached effective LogLevel of all loggers in the hierarchy.
              */
-            void setLogLevel(LogLevel _ll) { this->ll = _ll; }
+            void setLogLevel(LogLevel _ll);
 
             /**
              * Return the the {@link Hierarchy} where this <code>Logger</code>
@@ -124,7 +135,25 @@ namespace log4cplus {
             /**
              * Return the logger name.
              */
-            log4cplus::tstring const & getName() const { return name; }
+            log4cplus::tstring const & getName() const { return *name; }
+
+            /**
+             * Return the logger name as its interned reference counted
+             * handle. Events produced through this logger share it, so
+             * capturing the name costs a reference count bump instead
+             * of a string copy.
+             */
+            LoggerNamePtr const & getNamePtr() const { return name; }
+
+            /**
+             * Returns the number of events emitted through this
+             * logger's forced log path since it was created. The
+             * count is maintained in per thread stripes with relaxed
+             * atomics; reading it sums the stripes, so the result is
+             * exact but not a consistent cut with other loggers.
+             * \sa Hierarchy::getStatistics()
+             */
+            unsigned long long getEmittedEvents() const;
 
             /**
              * Get the additivity flag for this Logger instance.
@@ -136,6 +165,33 @@ namespace log4cplus {
              */
             void setAdditivity(bool additive);
 
+            /**
+             * Returns the maximum message size assigned to this
+             * logger, 0 when the process wide default applies.
+             */
+            std::size_t getMaxMessageSize() const
+            {
+                return maxMessageSize.load (std::memory_order_relaxed);
+            }
+
+            /**
+             * Sets the maximum message size for events logged through
+             * this logger. Longer messages are truncated and marked
+             * with a "...[truncated]" suffix before the event is
+             * constructed. 0 defers to the process wide default.
+             */
+            void setMaxMessageSize(std::size_t limit);
+
+            /**
+             * Sets the process wide default maximum message size used
+             * by loggers without their own limit; 0--the initial
+             * value--disables the check.
+             */
+            static void setDefaultMaxMessageSize(std::size_t limit);
+
+            //! \sa setDefaultMaxMessageSize()
+            static std::size_t getDefaultMaxMessageSize();
+
             virtual ~LoggerImpl();
 
         protected:
@@ -164,12 +220,27 @@ namespace log4cplus {
                                    int line,
                                    const char* function);
 
+            /**
+             * Overload that moves \c message into the logging event
+             * instead of copying it.
+             */
+            virtual void forcedLog(LogLevel ll,
+                                   log4cplus::tstring&& message,
+                                   const char* file,
+                                   int line,
+                                   const char* function);
+
             virtual void forcedLog(spi::InternalLoggingEvent const & ev);
 
 
           // Data
-            /** The name of this logger */
-            log4cplus::tstring name;
+            /** The name of this logger, interned as one immutable
+             *  reference counted string per logger. The Hierarchy
+             *  guarantees a single LoggerImpl per name, so this handle
+             *  acts as the process wide intern pool entry shared with
+             *  every event the logger produces.
+             */
+            LoggerNamePtr name;
 
             /**
              * The assigned LogLevel of this logger.
@@ -193,11 +264,100 @@ namespace log4cplus {
              */
             bool additive;
 
+            /**
+             * Maximum message size for this logger, 0 when the
+             * process wide default applies. \sa setMaxMessageSize()
+             */
+            std::atomic<std::size_t> maxMessageSize;
+
         private:
           // Data
             /** Loggers need to know what Hierarchy they are in. */
             Hierarchy& hierarchy;
 
+            /**
+             * Dense per-hierarchy logger id; indexes this logger's
+             * bitmask in the hierarchy's event routing table. Ids are
+             * assigned at creation and never reused.
+             */
+            std::size_t loggerId;
+
+            /**
+             * Points at this logger's slot in the hierarchy wide
+             * effective threshold table. The slot combines the chained
+             * LogLevel with the hierarchy's disable value, so
+             * isEnabledFor() is a single relaxed load. The table is
+             * kept up to date eagerly on every configuration change.
+             */
+            std::atomic<LogLevel> * effectiveThreshold;
+
+            typedef std::vector<LoggerImpl *> AppenderChain;
+            typedef std::shared_ptr<AppenderChain const> AppenderChainPtr;
+
+            /**
+             * Flattened ancestor chain: this logger followed by the
+             * ancestors its events reach, with additivity already
+             * honored. The hierarchy rebuilds it eagerly on every
+             * mutation of parent links or additivity flags;
+             * callAppenders() reads it lock-free through
+             * std::atomic_load(). The raw pointers stay valid because
+             * every element is kept alive by the parent chain of this
+             * logger.
+             */
+            AppenderChainPtr appenderChain;
+
+            /** One stripe of the emitted events counter. Stripes are
+             *  padded out to separate cache lines so that threads
+             *  incrementing different stripes do not false share. */
+            struct EventCounterStripe
+            {
+                std::atomic<unsigned long long> count {0};
+                char pad[56];
+            };
+
+            static std::size_t const eventCounterStripeCount = 8;
+
+            /**
+             * Count of events emitted through forcedLog(), striped by
+             * the calling thread's round robin index so that the log
+             * path is a single relaxed fetch_add with no cross thread
+             * contention. getEmittedEvents() sums the stripes.
+             */
+            EventCounterStripe emittedEvents[eventCounterStripeCount];
+
+          // Methods
+            /**
+             * Accounts one emitted event into the calling thread's
+             * counter stripe.
+             */
+            LOG4CPLUS_PRIVATE void countEmittedEvent();
+
+            /**
+             * Returns this logger's maximum message size, falling
+             * back to the process wide default when it is unset.
+             */
+            LOG4CPLUS_PRIVATE std::size_t effectiveMaxMessageSize() const;
+
+            /**
+             * Recomputes this logger's effective threshold table slot
+             * from the parent chain and the hierarchy's disable value.
+             */
+            LOG4CPLUS_PRIVATE void refreshThreshold();
+
+            /**
+             * Rebuilds and publishes this logger's flattened ancestor
+             * chain from the parent links and additivity flags.
+             */
+            LOG4CPLUS_PRIVATE void refreshAppenderChain();
+
+            /**
+             * Attached appender thresholds feed the effective
+             * threshold table and descendants may inherit this
+             * logger's appenders through additivity, so recompute the
+             * whole table whenever the appender set changes.
+             */
+            virtual void appenderListChanged();
+
           // Disallow copying of instances of this class
             LoggerImpl(const LoggerImpl&) = delete;
             LoggerImpl& operator=(const LoggerImpl&) = delete;
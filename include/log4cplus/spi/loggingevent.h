@@ -40,6 +40,65 @@
 
 namespace log4cplus {
     namespace spi {
+
+        //! Immutable reference counted logger name shared between
+        //! a logger and every event it produces.
+        typedef std::shared_ptr<log4cplus::tstring const> LoggerNamePtr;
+
+        //! One distinct logging call site. Interned once per (file,
+        //! line, function) triple; every event from that site shares
+        //! the entry, so events carry a pointer instead of owning
+        //! file and function strings.
+        struct SourceSite
+        {
+            log4cplus::tstring file;
+            log4cplus::tstring function;
+            int line = 0;
+        };
+
+        typedef std::shared_ptr<SourceSite const> SourceSitePtr;
+
+        //! Returns the shared SourceSite for the given call site,
+        //! interning it on first use. Call sites are told apart by
+        //! the addresses of the passed pointers, which is exact for
+        //! the string literals produced by the logging macros.
+        LOG4CPLUS_EXPORT SourceSitePtr internSourceSite (
+            const char * file, int line, const char * function);
+
+        //! Bit flags naming the thread specific fields of an event
+        //! that are captured from thread local state on first access.
+        //! See getNeededEventFields().
+        enum EventField : unsigned
+        {
+            EventFieldNDC     = 1U << 0,
+            EventFieldMDC     = 1U << 1,
+            EventFieldThread  = 1U << 2,
+            EventFieldThread2 = 1U << 3,
+            EventFieldAll     = EventFieldNDC | EventFieldMDC
+                | EventFieldThread | EventFieldThread2
+        };
+
+        /** Returns the union of the EventField bits some configured
+         *  consumer may read. gatherThreadSpecificData() resolves
+         *  only these fields before an event leaves its originating
+         *  thread, so a configuration whose layouts reference none of
+         *  NDC, MDC or the thread names skips those captures
+         *  entirely.
+         */
+        LOG4CPLUS_EXPORT unsigned getNeededEventFields ();
+
+        /** Adds \c fields to the set returned by
+         *  getNeededEventFields(). The set only ever grows. Layouts
+         *  report the fields their format references when they are
+         *  attached to an appender and components that read event
+         *  fields directly report in their constructors; a custom
+         *  component that reads e.g. getNDC() of events it receives
+         *  asynchronously must register the fields it reads, or they
+         *  may be resolved on the delivering thread instead of the
+         *  originating one.
+         */
+        LOG4CPLUS_EXPORT void addNeededEventFields (unsigned fields);
+
         /**
          * The internal representation of logging events. When an affirmative
          * decision is made to log then a <code>InternalLoggingEvent</code>
@@ -67,6 +126,21 @@ namespace log4cplus {
                 LogLevel loglevel, const log4cplus::tstring_view& message,
                 const char* filename, int line, const char * function = nullptr);
 
+            /** Overload that adopts the storage of \c message instead
+             *  of copying its characters.
+             */
+            InternalLoggingEvent(const log4cplus::tstring_view& logger,
+                LogLevel loglevel, log4cplus::tstring&& message,
+                const char* filename, int line, const char * function = nullptr);
+
+            /** Overload for character pointers; it exists so that such
+             *  callers do not face an ambiguity between the string
+             *  view and the moving overloads.
+             */
+            InternalLoggingEvent(const log4cplus::tstring_view& logger,
+                LogLevel loglevel, const log4cplus::tchar* message,
+                const char* filename, int line, const char * function = nullptr);
+
             InternalLoggingEvent(const log4cplus::tstring_view& logger,
                 LogLevel loglevel, const log4cplus::tstring_view& ndc,
                 MappedDiagnosticContextMap const & mdc,
@@ -93,6 +167,13 @@ namespace log4cplus {
             InternalLoggingEvent(
                 const log4cplus::spi::InternalLoggingEvent& rhs);
 
+            /** Move construction takes over the storage of \c rhs.
+             *  Like the copy constructor it first resolves the lazily
+             *  captured thread specific members of \c rhs so that they
+             *  are gathered on the originating thread.
+             */
+            InternalLoggingEvent(log4cplus::spi::InternalLoggingEvent&& rhs);
+
             virtual ~InternalLoggingEvent();
 
             void setLoggingEvent (const log4cplus::tstring_view & logger,
@@ -100,9 +181,68 @@ namespace log4cplus {
                 const char * filename, int line,
                 const char * function = nullptr);
 
+            /** Overload that adopts the storage of \c message instead
+             *  of copying its characters.
+             */
+            void setLoggingEvent (const log4cplus::tstring_view & logger,
+                LogLevel ll, log4cplus::tstring && message,
+                const char * filename, int line,
+                const char * function = nullptr);
+
+            /** Overload for character pointers; it exists so that such
+             *  callers do not face an ambiguity between the string
+             *  view and the moving overloads.
+             */
+            void setLoggingEvent (const log4cplus::tstring_view & logger,
+                LogLevel ll, const log4cplus::tchar * message,
+                const char * filename, int line,
+                const char * function = nullptr);
+
+            /** Overload capturing the logger name as an interned
+             *  reference counted string instead of copying its
+             *  characters. Used by LoggerImpl::forcedLog() where the
+             *  logger already owns such a handle.
+             */
+            void setLoggingEvent (LoggerNamePtr const & logger,
+                LogLevel ll, const log4cplus::tstring_view & message,
+                const char * filename, int line,
+                const char * function = nullptr);
+
+            /** Overload combining the interned logger name capture
+             *  with adoption of the message's storage.
+             */
+            void setLoggingEvent (LoggerNamePtr const & logger,
+                LogLevel ll, log4cplus::tstring && message,
+                const char * filename, int line,
+                const char * function = nullptr);
+
+            /** Overload for character pointers; it exists so that such
+             *  callers do not face an ambiguity between the string
+             *  view and the moving overloads.
+             */
+            void setLoggingEvent (LoggerNamePtr const & logger,
+                LogLevel ll, const log4cplus::tchar * message,
+                const char * filename, int line,
+                const char * function = nullptr);
+
             void setFunction (char const * func);
             void setFunction (log4cplus::tstring_view const &);
 
+            /** Member-wise copy from \c rhs that, unlike the
+             *  copy-and-swap based assignment operator, reuses the
+             *  existing string storage of this instance. Useful for
+             *  pools of recycled events.
+             */
+            void assign (const log4cplus::spi::InternalLoggingEvent & rhs);
+
+            /** Shrinks the retained string storage of this event when
+             *  it greatly exceeds \c high_water, the largest recently
+             *  observed message size. Recycled events keep their
+             *  capacity between uses; this hook stops a rare huge
+             *  message from pinning that capacity forever.
+             */
+            void trimCapacity (std::size_t high_water);
+
 
           // public virtual methods
             /** The application supplied message of logging event. */
@@ -126,9 +266,22 @@ namespace log4cplus {
              */
             const log4cplus::tstring& getLoggerName() const
             {
+                if (loggerNamePtr)
+                    return *loggerNamePtr;
                 return loggerName;
             }
 
+            /** The logger name as a stable reference counted handle
+             *  interned by the logger that produced the event, or null
+             *  when the event was constructed from a plain string.
+             *  Copying it into another event costs a reference count
+             *  bump instead of a string copy.
+             */
+            LoggerNamePtr getLoggerNamePtr () const
+            {
+                return loggerNamePtr;
+            }
+
             /** LogLevel of logging event. */
             LogLevel getLogLevel() const
             {
@@ -146,40 +299,35 @@ namespace log4cplus {
                 return ndc;
             }
 
-            MappedDiagnosticContextMap const & getMDCCopy () const
-            {
-                if (!mdcCached)
-                {
-                    mdc = log4cplus::getMDC().getContext ();
-                    mdcCached = true;
-                }
-                return mdc;
-            }
+            /** The mapped diagnostic context (MDC) captured for this
+             *  event, by const reference. Despite the historical
+             *  name, no map is copied; the returned reference points
+             *  into the shared snapshot taken on first access.
+             */
+            MappedDiagnosticContextMap const & getMDCCopy () const;
+
+            /** The mapped diagnostic context (MDC) of logging event
+             *  as an immutable reference counted snapshot. Capturing
+             *  it into another event costs a reference count bump
+             *  instead of a map copy.
+             */
+            MappedDiagnosticContextMapPtr getMDCSnapshot () const;
 
             tstring const & getMDC (tstring const & key) const;
 
             /** The name of thread in which this logging event was generated. */
-            const log4cplus::tstring& getThread() const
-            {
-                if (! threadCached)
-                {
-                    thread = thread::getCurrentThreadName ();
-                    threadCached = true;
-                }
-                return thread;
-            }
+            const log4cplus::tstring& getThread() const;
 
             //! The alternative name of thread in which this logging event
             //! was generated.
-            const log4cplus::tstring& getThread2() const
-            {
-                if (! thread2Cached)
-                {
-                    thread2 = thread::getCurrentThreadName2 ();
-                    thread2Cached = true;
-                }
-                return thread2;
-            }
+            const log4cplus::tstring& getThread2() const;
+
+            /** The thread names as stable reference counted handles.
+             *  Copying them into another event costs a reference
+             *  count bump instead of a string copy.
+             */
+            thread::ThreadNamePtr getThreadPtr () const;
+            thread::ThreadNamePtr getThread2Ptr () const;
 
 
             /** Time stamp when the event was created. */
@@ -188,28 +336,74 @@ namespace log4cplus {
                 return timestamp;
             }
 
-            /** The is the file where this log statement was written */
-            const log4cplus::tstring& getFile() const
+            /** Monotonic (steady clock) timestamp captured together
+             *  with the wall clock timestamp when the event was
+             *  created. Unlike getTimestamp() it never steps
+             *  backwards across NTP adjustments, so it orders events
+             *  of one process reliably without re-sorting. The value
+             *  is only meaningful within the producing process.
+             */
+            const log4cplus::helpers::SteadyTime& getSteadyTimestamp() const
             {
-                return file;
+                return steadyTimestamp;
             }
 
+            /** The is the file where this log statement was written */
+            const log4cplus::tstring& getFile() const;
+
             /** The is the line where this log statement was written */
-            int getLine() const { return line; }
+            int getLine() const { return site ? site->line : 0; }
 
-            log4cplus::tstring const & getFunction () const
-            {
-                return function;
-            }
+            log4cplus::tstring const & getFunction () const;
 
+            /** Resolves the lazily captured thread specific fields
+             *  of this event on the calling thread, so that the
+             *  event can be handed to another thread. Only the
+             *  fields in getNeededEventFields() are resolved; the
+             *  others stay untouched because no configured consumer
+             *  reads them.
+             */
             void gatherThreadSpecificData () const;
 
+            /** Returns the formatted line cached under \c key by
+             *  cacheFormattedLine(), or null when the cache holds no
+             *  line for that key. \c key identifies the format of the
+             *  producing layout; see Layout::getFormatKey().
+             */
+            log4cplus::tstring const *
+            getCachedFormattedLine (std::size_t key) const;
+
+            /** Caches \c line as the result of formatting this event
+             *  with a layout whose format key is \c key, replacing
+             *  any previously cached line. The cache has a single
+             *  slot; it pays off when one event fans out to several
+             *  appenders whose layouts share the same format.
+             */
+            void cacheFormattedLine (std::size_t key,
+                log4cplus::tstring_view line) const;
+
+            /** Enables or disables the one slot formatted line
+             *  cache of this event. The cache is not synchronized;
+             *  parallel fan-out disables it while several appenders
+             *  format this event concurrently and re-enables it
+             *  afterwards. Enabled by default.
+             */
+            void enableFormattedLineCache (bool enable) const;
+
             void swap (InternalLoggingEvent &);
 
           // public operators
             log4cplus::spi::InternalLoggingEvent&
             operator=(const log4cplus::spi::InternalLoggingEvent& rhs);
 
+            /** Swap based move assignment; the storage of this
+             *  instance ends up in \c rhs, which makes it suitable for
+             *  moving events into recycled slots without discarding
+             *  their reusable string capacity.
+             */
+            log4cplus::spi::InternalLoggingEvent&
+            operator=(log4cplus::spi::InternalLoggingEvent&& rhs);
+
           // static methods
             static unsigned int getDefaultType();
 
@@ -217,15 +411,19 @@ namespace log4cplus {
           // Data
             log4cplus::tstring message;
             log4cplus::tstring loggerName;
+            LoggerNamePtr loggerNamePtr;
             LogLevel ll;
             mutable log4cplus::tstring ndc;
-            mutable MappedDiagnosticContextMap mdc;
-            mutable log4cplus::tstring thread;
-            mutable log4cplus::tstring thread2;
+            mutable MappedDiagnosticContextMapPtr mdc;
+            mutable thread::ThreadNamePtr thread;
+            mutable thread::ThreadNamePtr thread2;
             log4cplus::helpers::Time timestamp;
-            log4cplus::tstring file;
-            log4cplus::tstring function;
-            int line;
+            /** Monotonic companion of <code>timestamp</code>. See
+             *  getSteadyTimestamp(). */
+            log4cplus::helpers::SteadyTime steadyTimestamp;
+            /** The call site of this event, shared with every other
+             *  event from the same site. See internSourceSite(). */
+            SourceSitePtr site;
             /** Indicates whether or not the Threadname has been retrieved. */
             mutable bool threadCached;
             mutable bool thread2Cached;
@@ -233,6 +431,13 @@ namespace log4cplus {
             mutable bool ndcCached;
             /** Indicates whether or not the MDC has been retrieved. */
             mutable bool mdcCached;
+            /** One slot cache of a formatted line, keyed by the
+             *  format key of the layout that produced it; 0 means the
+             *  cache is empty. */
+            mutable log4cplus::tstring formattedLine;
+            mutable std::size_t formattedLineKey = 0;
+            /** See enableFormattedLineCache(). */
+            mutable bool formattedLineCacheEnabled = true;
         };
 
     } // end namespace spi
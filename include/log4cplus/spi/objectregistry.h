@@ -32,7 +32,6 @@
 
 #include <log4cplus/tstring.h>
 #include <log4cplus/thread/syncprims.h>
-#include <map>
 #include <memory>
 #include <vector>
 
@@ -51,7 +50,7 @@ namespace log4cplus {
              * Tests to see whether or not an object is bound in the
              * registry as <code>name</code>.
              */
-            bool exists(const log4cplus::tstring& name) const;
+            bool exists(tstring_view name) const;
 
             /**
              * Returns the names of all registered objects.
@@ -77,9 +76,10 @@ namespace log4cplus {
 
             /**
              * Used to retrieve an object from the registry.  (The registry
-             * owns the returned pointer.)
+             * owns the returned pointer.) Lookup is lock-free and
+             * accepts any string-like name without conversion.
              */
-            void* getVal(const log4cplus::tstring& name) const;
+            void* getVal(tstring_view name) const;
 
             /**
              * Deletes <code>object</code>.
@@ -92,16 +92,46 @@ namespace log4cplus {
             virtual void clear();
 
           // Types
-            typedef std::map<log4cplus::tstring, void*> ObjectMap;
+            /**
+             * One slot of the open addressing hash table holding the
+             * registry contents. Vacant slots have a null object
+             * pointer; null objects therefore cannot be registered.
+             */
+            struct NameValue
+            {
+                log4cplus::tstring name;
+                void * object = nullptr;
+            };
+
+            /**
+             * Linear probing hash table sized to a power of two and
+             * kept at most half full. It is published as an immutable
+             * snapshot through std::atomic_load()/atomic_store() so
+             * that lookups during configuration are lock-free;
+             * registration is rare, happens mostly at initialization,
+             * and rebuilds the table under the mutex.
+             */
+            typedef std::vector<NameValue> ObjectMap;
+            typedef std::shared_ptr<ObjectMap const> ObjectMapSnapshot;
 
           // Data
             thread::Mutex mutex;
-            ObjectMap data;
+            ObjectMapSnapshot data;
 
         private:
+            /**
+             * Returns the slot holding <code>name</code> or the
+             * vacant slot where it would be inserted.
+             */
+            LOG4CPLUS_PRIVATE static NameValue * findSlot (
+                ObjectMap & table, tstring_view name);
+            LOG4CPLUS_PRIVATE static NameValue const * findSlot (
+                ObjectMap const & table, tstring_view name);
+
             ObjectRegistryBase (ObjectRegistryBase const &);
             ObjectRegistryBase & operator = (ObjectRegistryBase const &);
 
+            std::size_t count;
             bool volatile locking;
         };
 
@@ -0,0 +1,476 @@
+// -*- C++ -*-
+// Module:  Log4CPLUS
+// File:    staticpatternlayout.h
+// Created: 8/2026
+//
+// Copyright 2026 Tad E. Smith
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/** @file
+ * This header defines StaticPatternLayout, a header only, compile time
+ * parsed variant of PatternLayout. It requires C++20 class type
+ * non-type template parameters and is compiled away entirely when the
+ * compiler does not support them.
+ */
+
+#ifndef LOG4CPLUS_STATICPATTERNLAYOUT_HEADER_
+#define LOG4CPLUS_STATICPATTERNLAYOUT_HEADER_
+
+#include <log4cplus/config.hxx>
+
+#if defined (LOG4CPLUS_HAVE_PRAGMA_ONCE)
+#pragma once
+#endif
+
+#if defined (__cpp_nontype_template_args) \
+    && __cpp_nontype_template_args >= 201911L
+
+#include <log4cplus/layout.h>
+#include <log4cplus/loglevel.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/helpers/timehelper.h>
+
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+
+namespace log4cplus {
+
+    namespace pattern {
+
+        //! Structural string wrapper usable as a non-type template
+        //! parameter, e.g. <tt>StaticPatternLayout<"%-5p %c - %m%n"></tt>.
+        template <std::size_t N>
+        struct StaticPatternString
+        {
+            tchar value[N] {};
+
+            constexpr
+            StaticPatternString (tchar const (&str)[N])
+            {
+                for (std::size_t i = 0; i != N; ++i)
+                    value[i] = str[i];
+            }
+        };
+
+
+        //! One parsed segment of a static pattern.
+        struct StaticPatternToken
+        {
+            enum Type
+            {
+                LITERAL,
+                BASENAME,
+                LOGGER,
+                DATE,
+                FILENAME,
+                LINE,
+                MESSAGE,
+                FUNCTION,
+                NEWLINE,
+                LOGLEVEL,
+                THREAD,
+                THREAD2,
+                NDC_FIELD
+            };
+
+            Type type = LITERAL;
+            //! Offset and length into the pattern; holds the literal
+            //! text for LITERAL tokens and the format option for DATE
+            //! tokens.
+            std::size_t begin = 0;
+            std::size_t len = 0;
+            int minLen = 0;
+            std::size_t maxLen = (std::numeric_limits<std::size_t>::max) ();
+            bool leftAlign = false;
+            bool trimStart = true;
+            //! DATE tokens only: format in UTC (%d) vs. local time (%D).
+            bool useGmtime = true;
+        };
+
+
+        //! Result of the compile time parse; at most one token per
+        //! pattern character can be produced.
+        template <std::size_t N>
+        struct ParsedStaticPattern
+        {
+            StaticPatternToken tokens[N] {};
+            std::size_t count = 0;
+        };
+
+
+        //! Parse \c Pattern at compile time. Unsupported conversion
+        //! characters make the surrounding constant expression ill
+        //! formed and therefore fail the build.
+        template <StaticPatternString Pattern>
+        constexpr auto
+        parseStaticPattern ()
+        {
+            constexpr std::size_t N
+                = sizeof (Pattern.value) / sizeof (tchar);
+            ParsedStaticPattern<N> result;
+
+            std::size_t i = 0;
+            while (Pattern.value[i] != tchar (0))
+            {
+                if (Pattern.value[i] != LOG4CPLUS_TEXT ('%'))
+                {
+                    // Gather a literal run.
+                    std::size_t const begin = i;
+                    while (Pattern.value[i] != tchar (0)
+                        && Pattern.value[i] != LOG4CPLUS_TEXT ('%'))
+                        ++i;
+
+                    StaticPatternToken tok;
+                    tok.type = StaticPatternToken::LITERAL;
+                    tok.begin = begin;
+                    tok.len = i - begin;
+                    result.tokens[result.count++] = tok;
+                    continue;
+                }
+
+                // Conversion specifier.
+                ++i;
+                StaticPatternToken tok;
+
+                if (Pattern.value[i] == LOG4CPLUS_TEXT ('-'))
+                {
+                    tok.leftAlign = true;
+                    ++i;
+                }
+
+                while (Pattern.value[i] >= LOG4CPLUS_TEXT ('0')
+                    && Pattern.value[i] <= LOG4CPLUS_TEXT ('9'))
+                {
+                    tok.minLen = tok.minLen * 10
+                        + (Pattern.value[i] - LOG4CPLUS_TEXT ('0'));
+                    ++i;
+                }
+
+                if (Pattern.value[i] == LOG4CPLUS_TEXT ('.'))
+                {
+                    ++i;
+                    if (Pattern.value[i] == LOG4CPLUS_TEXT ('-'))
+                    {
+                        tok.trimStart = false;
+                        ++i;
+                    }
+
+                    tok.maxLen = 0;
+                    while (Pattern.value[i] >= LOG4CPLUS_TEXT ('0')
+                        && Pattern.value[i] <= LOG4CPLUS_TEXT ('9'))
+                    {
+                        tok.maxLen = tok.maxLen * 10
+                            + (Pattern.value[i] - LOG4CPLUS_TEXT ('0'));
+                        ++i;
+                    }
+                }
+
+                tchar const c = Pattern.value[i];
+                ++i;
+                switch (c)
+                {
+                case LOG4CPLUS_TEXT ('b'):
+                    tok.type = StaticPatternToken::BASENAME;
+                    break;
+
+                case LOG4CPLUS_TEXT ('c'):
+                    tok.type = StaticPatternToken::LOGGER;
+                    if (Pattern.value[i] == LOG4CPLUS_TEXT ('{'))
+                        // The %c precision option is not supported
+                        // here; fail the build instead of emitting the
+                        // option text literally.
+                        throw "%c precision option is not supported"
+                            " by StaticPatternLayout";
+                    break;
+
+                case LOG4CPLUS_TEXT ('d'):
+                case LOG4CPLUS_TEXT ('D'):
+                    tok.type = StaticPatternToken::DATE;
+                    tok.useGmtime = c == LOG4CPLUS_TEXT ('d');
+                    if (Pattern.value[i] == LOG4CPLUS_TEXT ('{'))
+                    {
+                        ++i;
+                        tok.begin = i;
+                        while (Pattern.value[i] != tchar (0)
+                            && Pattern.value[i] != LOG4CPLUS_TEXT ('}'))
+                            ++i;
+                        tok.len = i - tok.begin;
+                        if (Pattern.value[i] == LOG4CPLUS_TEXT ('}'))
+                            ++i;
+                    }
+                    break;
+
+                case LOG4CPLUS_TEXT ('F'):
+                    tok.type = StaticPatternToken::FILENAME;
+                    break;
+
+                case LOG4CPLUS_TEXT ('L'):
+                    tok.type = StaticPatternToken::LINE;
+                    break;
+
+                case LOG4CPLUS_TEXT ('m'):
+                    tok.type = StaticPatternToken::MESSAGE;
+                    break;
+
+                case LOG4CPLUS_TEXT ('M'):
+                    tok.type = StaticPatternToken::FUNCTION;
+                    break;
+
+                case LOG4CPLUS_TEXT ('n'):
+                    tok.type = StaticPatternToken::NEWLINE;
+                    break;
+
+                case LOG4CPLUS_TEXT ('p'):
+                    tok.type = StaticPatternToken::LOGLEVEL;
+                    break;
+
+                case LOG4CPLUS_TEXT ('t'):
+                    tok.type = StaticPatternToken::THREAD;
+                    break;
+
+                case LOG4CPLUS_TEXT ('T'):
+                    tok.type = StaticPatternToken::THREAD2;
+                    break;
+
+                case LOG4CPLUS_TEXT ('x'):
+                    tok.type = StaticPatternToken::NDC_FIELD;
+                    break;
+
+                case LOG4CPLUS_TEXT ('%'):
+                    tok.type = StaticPatternToken::LITERAL;
+                    tok.begin = i - 1;
+                    tok.len = 1;
+                    break;
+
+                default:
+                    // Unsupported conversion character; fail the
+                    // constant evaluation and thereby the build.
+                    throw "unsupported conversion character"
+                        " in StaticPatternLayout pattern";
+                }
+
+                result.tokens[result.count++] = tok;
+            }
+
+            return result;
+        }
+
+
+        //! Append \c text to \c buf honoring the min/max length
+        //! formatting modifiers, mirroring the semantics of
+        //! PatternConverter::formatAndAppend().
+        inline
+        void
+        staticPatternAppend (tstring & buf, tstring_view text,
+            int minLen, std::size_t maxLen, bool leftAlign, bool trimStart)
+        {
+            std::size_t const len = text.length ();
+
+            if (len > maxLen)
+            {
+                if (trimStart)
+                    buf.append (text.data () + (len - maxLen), maxLen);
+                else
+                    buf.append (text.data (), maxLen);
+            }
+            else if (static_cast<int>(len) < minLen)
+            {
+                std::size_t const padding = std::size_t (minLen) - len;
+                if (leftAlign)
+                {
+                    buf.append (text.data (), len);
+                    buf.append (padding, LOG4CPLUS_TEXT (' '));
+                }
+                else
+                {
+                    buf.append (padding, LOG4CPLUS_TEXT (' '));
+                    buf.append (text.data (), len);
+                }
+            }
+            else
+                buf.append (text.data (), len);
+        }
+
+    } // namespace pattern
+
+
+    /**
+     * Header only variant of PatternLayout whose conversion pattern is
+     * parsed at compile time into a fused formatting function with no
+     * virtual dispatch per conversion and no tostream insertion per
+     * field. The formatted line is assembled in a thread local string
+     * and written to the output stream in a single write.
+     *
+     * Example:
+     * ~~~~{.cpp}
+     * appender->setLayout (
+     *     std::make_unique<
+     *         StaticPatternLayout<LOG4CPLUS_TEXT ("%-5p %c - %m%n")>> ());
+     * ~~~~
+     *
+     * The supported conversion characters are <tt>b c d D F L m M n p t
+     * T x %%</tt> together with the usual min/max width modifiers. The
+     * <tt>%%c</tt> precision option is not supported. An unsupported
+     * conversion character fails the build.
+     */
+    template <pattern::StaticPatternString Pattern>
+    class StaticPatternLayout
+        : public Layout
+    {
+    public:
+        StaticPatternLayout () = default;
+        ~StaticPatternLayout () override = default;
+
+        void
+        formatAndAppend (tostream & output,
+            const spi::InternalLoggingEvent & event) override
+        {
+            tstring & buf = formatBuffer ();
+            buf.clear ();
+            format (buf, event);
+            output.write (buf.data (),
+                static_cast<std::streamsize>(buf.size ()));
+        }
+
+        void
+        formatAndAppendBatch (tostream & output,
+            const spi::InternalLoggingEvent * events,
+            std::size_t count) override
+        {
+            tstring & buf = formatBuffer ();
+            buf.clear ();
+            for (std::size_t i = 0; i != count; ++i)
+                format (buf, events[i]);
+            output.write (buf.data (),
+                static_cast<std::streamsize>(buf.size ()));
+        }
+
+        //! Format \c event according to the compile time parsed
+        //! pattern, appending the result to \c buf.
+        static
+        void
+        format (tstring & buf, const spi::InternalLoggingEvent & event)
+        {
+            formatImpl (buf, event,
+                std::make_index_sequence<parsedPattern.count> ());
+        }
+
+    private:
+        static constexpr auto parsedPattern
+            = pattern::parseStaticPattern<Pattern> ();
+
+        static
+        tstring &
+        formatBuffer ()
+        {
+            thread_local tstring buf;
+            return buf;
+        }
+
+        template <std::size_t... Indices>
+        static
+        void
+        formatImpl (tstring & buf, const spi::InternalLoggingEvent & event,
+            std::index_sequence<Indices...>)
+        {
+            (appendToken<Indices> (buf, event), ...);
+        }
+
+        template <std::size_t I>
+        static
+        void
+        appendToken (tstring & buf, const spi::InternalLoggingEvent & event)
+        {
+            using pattern::StaticPatternToken;
+
+            constexpr StaticPatternToken tok = parsedPattern.tokens[I];
+
+            if constexpr (tok.type == StaticPatternToken::LITERAL)
+                buf.append (Pattern.value + tok.begin, tok.len);
+            else if constexpr (tok.type == StaticPatternToken::NEWLINE)
+                buf.append (1, LOG4CPLUS_TEXT ('\n'));
+            else if constexpr (tok.type == StaticPatternToken::MESSAGE)
+                appendField (buf, event.getMessage (), tok);
+            else if constexpr (tok.type == StaticPatternToken::LOGGER)
+                appendField (buf, event.getLoggerName (), tok);
+            else if constexpr (tok.type == StaticPatternToken::LOGLEVEL)
+                appendField (buf,
+                    getLogLevelManager ().toString (event.getLogLevel ()),
+                    tok);
+            else if constexpr (tok.type == StaticPatternToken::THREAD)
+                appendField (buf, event.getThread (), tok);
+            else if constexpr (tok.type == StaticPatternToken::THREAD2)
+                appendField (buf, event.getThread2 (), tok);
+            else if constexpr (tok.type == StaticPatternToken::NDC_FIELD)
+                appendField (buf, event.getNDC (), tok);
+            else if constexpr (tok.type == StaticPatternToken::FILENAME)
+                appendField (buf, event.getFile (), tok);
+            else if constexpr (tok.type == StaticPatternToken::BASENAME)
+            {
+                tstring const & file = event.getFile ();
+                tstring::size_type const pos
+                    = file.find_last_of (LOG4CPLUS_TEXT ("/\\"));
+                if (pos == tstring::npos)
+                    appendField (buf, file, tok);
+                else
+                    appendField (buf,
+                        tstring_view (file).substr (pos + 1), tok);
+            }
+            else if constexpr (tok.type == StaticPatternToken::LINE)
+            {
+                if (event.getLine () != -1)
+                    appendField (buf,
+                        helpers::convertIntegerToString (event.getLine ()),
+                        tok);
+                else
+                    appendField (buf, tstring_view (), tok);
+            }
+            else if constexpr (tok.type == StaticPatternToken::FUNCTION)
+                appendField (buf, event.getFunction (), tok);
+            else if constexpr (tok.type == StaticPatternToken::DATE)
+            {
+                static tstring const fmt (
+                    tok.len != 0
+                    ? tstring (Pattern.value + tok.begin, tok.len)
+                    : tstring (LOG4CPLUS_TEXT ("%Y-%m-%d %H:%M:%S")));
+                appendField (buf,
+                    helpers::getFormattedTime (fmt, event.getTimestamp (),
+                        tok.useGmtime),
+                    tok);
+            }
+        }
+
+        static
+        void
+        appendField (tstring & buf, tstring_view text,
+            pattern::StaticPatternToken const & tok)
+        {
+            pattern::staticPatternAppend (buf, text, tok.minLen, tok.maxLen,
+                tok.leftAlign, tok.trimStart);
+        }
+
+        StaticPatternLayout (const StaticPatternLayout &) = delete;
+        StaticPatternLayout & operator = (const StaticPatternLayout &)
+            = delete;
+    };
+
+
+} // namespace log4cplus
+
+#endif // __cpp_nontype_template_args >= 201911L
+
+#endif // LOG4CPLUS_STATICPATTERNLAYOUT_HEADER_
@@ -33,6 +33,7 @@
 #include <log4cplus/appender.h>
 #include <log4cplus/helpers/socket.h>
 #include <log4cplus/helpers/connectorthread.h>
+#include <log4cplus/helpers/timehelper.h>
 
 
 namespace log4cplus
@@ -116,6 +117,13 @@ namespace log4cplus
         //! Remote syslog worker function.
         void appendRemote(const spi::InternalLoggingEvent& event);
 
+        //! Batch worker function. Remote TCP syslog coalesces the
+        //! whole batch of octet counted frames (RFC6587) into a
+        //! single socket write; other configurations fall back to one
+        //! append() call per event.
+        virtual void appendBatch (const spi::InternalLoggingEvent* events,
+            std::size_t count);
+
       // Data
         tstring ident;
         int facility;
@@ -150,8 +158,25 @@ namespace log4cplus
         SysLogAppender(const SysLogAppender&);
         SysLogAppender& operator=(const SysLogAppender&);
 
+        //! Formats the RFC5424 header and the laid out message for
+        //! \c event into the per thread scratch pad stream.
+        void formatRemoteEvent (const spi::InternalLoggingEvent& event);
+
+        //! Returns true when the remote connection is usable,
+        //! attempting to (re)establish it first when it is not.
+        bool ensureConnected ();
+
         std::string identStr;
         tstring hostname;
+
+        // Cached pieces of the RFC5424 header built by
+        // formatRemoteEvent(). The HOSTNAME, APP-NAME and PROCID
+        // fields never change during the appender's lifetime and the
+        // seconds part of the TIMESTAMP field changes at most once
+        // per second, so neither is reformatted per event.
+        tstring staticHeaderFields;
+        helpers::Time cachedSecond;
+        tstring cachedSecondStr;
     };
 
 } // end namespace log4cplus
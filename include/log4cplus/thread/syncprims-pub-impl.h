@@ -33,6 +33,10 @@
 
 #include <algorithm>
 
+#if defined (_MSC_VER) && (defined (_M_IX86) || defined (_M_X64))
+#include <intrin.h>
+#endif
+
 #if (defined (LOG4CPLUS_INLINES_ARE_EXPORTED)           \
     && defined (LOG4CPLUS_BUILD_DLL))                   \
     || defined (LOG4CPLUS_ENABLE_SYNCPRIMS_PUB_IMPL)
@@ -55,6 +59,31 @@ LOG4CPLUS_EXPORT void LOG4CPLUS_ATTRIBUTE_NORETURN
     syncprims_throw_exception(char const * const msg,
     char const * const file, int line);
 
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+//! CPU pause/yield hint for spin loops.
+inline
+void
+pause_cpu ()
+{
+#if defined (_MSC_VER) && (defined (_M_IX86) || defined (_M_X64))
+    _mm_pause ();
+#elif defined (__i386__) || defined (__x86_64__)
+    __builtin_ia32_pause ();
+#elif defined (__aarch64__) || defined (__arm__)
+    __asm__ __volatile__ ("yield");
+#endif
+}
+
+
+//! How many times a waiter polls the signaled flag before parking on
+//! the condition variable. Tuned so that a consumer keeping up with
+//! its producers rarely goes through the kernel at all.
+unsigned const event_spin_count = 500;
+
+#endif
+
 }
 
 //
@@ -98,6 +127,7 @@ Semaphore::Semaphore (unsigned LOG4CPLUS_THREADED (max),
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     : max_ (max)
     , val ((std::min) (max_, initial))
+    , waiters (0)
 #endif
 { }
 
@@ -112,13 +142,23 @@ void
 Semaphore::unlock () const
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    std::lock_guard<std::mutex> guard (mtx);
+    bool notify;
 
-    if (val >= max_)
-        LOG4CPLUS_THROW_RTE ("Semaphore::unlock(): val >= max");
+    {
+        std::lock_guard<std::mutex> guard (mtx);
 
-    ++val;
-    cv.notify_all ();
+        if (val >= max_)
+            LOG4CPLUS_THROW_RTE ("Semaphore::unlock(): val >= max");
+
+        ++val;
+        notify = waiters != 0;
+    }
+
+    // Notifying after unlocking avoids waking a thread just to have
+    // it block on mtx, and skipping the notification when nobody
+    // waits elides the wakeup syscall in steady state.
+    if (notify)
+        cv.notify_all ();
 #endif
 }
 
@@ -134,7 +174,11 @@ Semaphore::lock () const
         LOG4CPLUS_THROW_RTE ("Semaphore::unlock(): val > max");
 
     while (val == 0)
+    {
+        ++waiters;
         cv.wait (guard);
+        --waiters;
+    }
 
     --val;
 
@@ -153,6 +197,7 @@ ManualResetEvent::ManualResetEvent (bool LOG4CPLUS_THREADED (sig))
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     : signaled (sig)
     , sigcount (0)
+    , waiters (0)
 #endif
 { }
 
@@ -167,10 +212,19 @@ void
 ManualResetEvent::signal () const
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    std::unique_lock<std::mutex> guard (mtx);
+    // The store and the load must both be sequentially consistent so
+    // that either this thread sees the registered waiter or the
+    // waiter's recheck of the flag sees the store; see wait().
+    signaled.store (true, std::memory_order_seq_cst);
+    if (waiters.load (std::memory_order_seq_cst) == 0)
+        // The consumer is awake (spinning or busy); it will observe
+        // the flag without a wakeup syscall.
+        return;
 
-    signaled = true;
-    sigcount += 1;
+    {
+        std::lock_guard<std::mutex> guard (mtx);
+        sigcount += 1;
+    }
     cv.notify_all ();
 #endif
 }
@@ -181,9 +235,20 @@ void
 ManualResetEvent::wait () const
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // Spin briefly before parking; a producer signaling in that
+    // window is observed here without any syscall on either side.
+    for (unsigned i = 0; i != impl::event_spin_count; ++i)
+    {
+        if (signaled.load (std::memory_order_acquire))
+            return;
+
+        impl::pause_cpu ();
+    }
+
     std::unique_lock<std::mutex> guard (mtx);
 
-    if (! signaled)
+    waiters.fetch_add (1, std::memory_order_seq_cst);
+    if (! signaled.load (std::memory_order_seq_cst))
     {
         unsigned prev_count = sigcount;
         do
@@ -192,6 +257,7 @@ ManualResetEvent::wait () const
         }
         while (prev_count == sigcount);
     }
+    waiters.fetch_sub (1, std::memory_order_relaxed);
 #endif
 }
 
@@ -204,9 +270,19 @@ ManualResetEvent::timed_wait (unsigned long LOG4CPLUS_THREADED (msec)) const
     return true;
 
 #else
+    // See wait() for the spin rationale.
+    for (unsigned i = 0; i != impl::event_spin_count; ++i)
+    {
+        if (signaled.load (std::memory_order_acquire))
+            return true;
+
+        impl::pause_cpu ();
+    }
+
     std::unique_lock<std::mutex> guard (mtx);
 
-    if (! signaled)
+    waiters.fetch_add (1, std::memory_order_seq_cst);
+    if (! signaled.load (std::memory_order_seq_cst))
     {
         unsigned prev_count = sigcount;
 
@@ -224,9 +300,11 @@ ManualResetEvent::timed_wait (unsigned long LOG4CPLUS_THREADED (msec)) const
                 break;
 
             case static_cast<int>(std::cv_status::timeout):
+                waiters.fetch_sub (1, std::memory_order_relaxed);
                 return false;
 
             default:
+                waiters.fetch_sub (1, std::memory_order_relaxed);
                 guard.unlock ();
                 guard.release ();
                 LOG4CPLUS_THROW_RTE ("ManualResetEvent::timed_wait");
@@ -234,6 +312,7 @@ ManualResetEvent::timed_wait (unsigned long LOG4CPLUS_THREADED (msec)) const
         }
         while (prev_count == sigcount);
     }
+    waiters.fetch_sub (1, std::memory_order_relaxed);
 
     return true;
 #endif
@@ -247,7 +326,7 @@ ManualResetEvent::reset () const
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     std::lock_guard<std::mutex> guard (mtx);
 
-    signaled = false;
+    signaled.store (false, std::memory_order_relaxed);
 #endif
 }
 
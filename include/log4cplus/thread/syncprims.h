@@ -31,6 +31,7 @@
 #pragma once
 #endif
 
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 
@@ -96,6 +97,9 @@ private:
     mutable std::condition_variable cv;
     mutable unsigned max_;
     mutable unsigned val;
+    //! Number of threads blocked in lock(); lets unlock() skip the
+    //! notification when nobody listens. Only accessed under mtx.
+    mutable unsigned waiters;
 #endif
 };
 
@@ -120,8 +124,13 @@ private:
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     mutable std::mutex mtx;
     mutable std::condition_variable cv;
-    mutable bool signaled;
+    //! Atomic so that signal() and spinning waiters can check it
+    //! without taking mtx.
+    mutable std::atomic<bool> signaled;
     mutable unsigned sigcount;
+    //! Number of threads parked on cv; lets signal() skip the mutex
+    //! and the wakeup syscall entirely when the consumer is awake.
+    mutable std::atomic<unsigned> waiters;
 #endif
 };
 
@@ -32,16 +32,31 @@
 
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include <log4cplus/tstring.h>
 #include <log4cplus/helpers/pointer.h>
 
 
+namespace log4cplus { namespace helpers {
+
+class Properties;
+
+} } // namespace log4cplus { namespace helpers {
+
+
 namespace log4cplus { namespace thread {
 
 
+//! Stable, reference counted thread name. Logging events store this
+//! handle instead of copying the name string; the name is resolved
+//! at format time.
+typedef std::shared_ptr<log4cplus::tstring const> ThreadNamePtr;
+
 LOG4CPLUS_EXPORT log4cplus::tstring const & getCurrentThreadName();
 LOG4CPLUS_EXPORT log4cplus::tstring const & getCurrentThreadName2();
+LOG4CPLUS_EXPORT ThreadNamePtr const & getCurrentThreadNamePtr();
+LOG4CPLUS_EXPORT ThreadNamePtr const & getCurrentThreadName2Ptr();
 LOG4CPLUS_EXPORT void setCurrentThreadName(const log4cplus::tstring & name);
 LOG4CPLUS_EXPORT void setCurrentThreadName2(const log4cplus::tstring & name);
 LOG4CPLUS_EXPORT void yield();
@@ -86,6 +101,50 @@ public:
     void join () const;
     virtual void run() = 0;
 
+    /**
+     * Scheduling controls applied to the thread as it starts. The
+     * defaults leave the platform settings untouched.
+     */
+    struct SchedulingOptions
+    {
+        //! Symbolic thread priority.
+        enum Priority
+        {
+            DEFAULT,
+            LOWEST,
+            BELOW_NORMAL,
+            NORMAL,
+            ABOVE_NORMAL,
+            HIGHEST
+        };
+
+        //! CPUs the thread may be scheduled on; empty means no
+        //! pinning.
+        std::vector<unsigned> affinity;
+
+        //! Priority applied to the thread. On Windows it maps onto
+        //! SetThreadPriority(); on Linux it is translated into a nice
+        //! value when \c nice_value is 0.
+        Priority priority = DEFAULT;
+
+        //! Nice value given to the thread; 0 leaves it unchanged.
+        //! Only effective on Linux, where threads have their own nice
+        //! value.
+        int nice_value = 0;
+    };
+
+    //! Parses the <tt>ThreadAffinity</tt> (comma separated CPU
+    //! indexes), <tt>ThreadPriority</tt> (<tt>LOWEST</tt>,
+    //! <tt>BELOW_NORMAL</tt>, <tt>NORMAL</tt>, <tt>ABOVE_NORMAL</tt>,
+    //! <tt>HIGHEST</tt>) and <tt>ThreadNiceValue</tt> properties of
+    //! \c props.
+    static SchedulingOptions schedulingOptionsFromProperties (
+        helpers::Properties const & props);
+
+    //! Sets scheduling options applied as the thread starts. It must
+    //! be called before start().
+    void setSchedulingOptions (SchedulingOptions options);
+
 protected:
     // Force objects to be constructed on the heap
     virtual ~AbstractThread();
@@ -97,8 +156,11 @@ private:
         fJOINED = 2
     };
 
+    LOG4CPLUS_PRIVATE void applySchedulingOptions () const;
+
     std::unique_ptr<std::thread> thread;
     mutable std::atomic<int> flags;
+    SchedulingOptions sched_options;
 };
 
 typedef helpers::SharedObjectPtr<AbstractThread> AbstractThreadPtr;
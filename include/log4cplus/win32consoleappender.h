@@ -42,6 +42,12 @@ namespace log4cplus
    /**
     * Prints events to Win32 console.
     *
+    * Batches delivered through <code>doAppendBatch()</code> are
+    * formatted into one buffer and written with a single console
+    * call, so a drain cycle (e.g. behind an AsyncAppender or with
+    * <tt>AsyncAppend</tt>) costs one console round trip instead of
+    * one per event.
+    *
     * <h3>Properties</h3>
     * <dl>
     * <dt><tt>AllocConsole</tt></dt>
@@ -74,6 +80,17 @@ namespace log4cplus
     protected:
         virtual void append (spi::InternalLoggingEvent const &);
 
+        /** Formats the whole batch into one buffer and hands it to
+         *  the console (or redirected handle) in a single write
+         *  instead of one write per event. */
+        virtual void appendBatch (spi::InternalLoggingEvent const * events,
+            std::size_t count);
+
+        /** Resolves the output handle and whether it is a real
+         *  console. Returns null and reports through LogLog when the
+         *  handle cannot be obtained. */
+        void * get_output_handle (bool & is_console);
+
         void write_handle (void *, tchar const *, std::size_t);
         void write_console (void *, tchar const *, std::size_t);
 
@@ -81,6 +98,10 @@ namespace log4cplus
         bool log_to_std_err;
         unsigned int text_color;
 
+        /** Reused concatenation buffer of appendBatch(). Only
+         *  touched with the appender lock held. */
+        tstring batch_buffer;
+
     private:
         Win32ConsoleAppender (Win32ConsoleAppender const &);
         Win32ConsoleAppender & operator = (Win32ConsoleAppender const &);
@@ -0,0 +1,223 @@
+// Module:  LOG4CPLUS
+// File:    logdump.cxx
+// Created: 8/2026
+//
+// Copyright 2026 Tad E. Smith
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//! Decoder for log files written with log4cplus::BinaryLayout. Reads
+//! the binary records and prints one formatted text line per event,
+//! so all text formatting cost is paid here instead of in the
+//! producing process.
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <log4cplus/initializer.h>
+#include <log4cplus/loglevel.h>
+#include <log4cplus/streams.h>
+#include <log4cplus/tstring.h>
+#include <log4cplus/helpers/timehelper.h>
+
+
+namespace
+{
+
+bool
+get_byte (std::istream & input, unsigned char & byte)
+{
+    int const ch = input.get ();
+    if (ch == std::char_traits<char>::eof ())
+        return false;
+
+    byte = static_cast<unsigned char>(ch);
+    return true;
+}
+
+
+bool
+get_varint (std::istream & input, unsigned long long & value)
+{
+    value = 0;
+    unsigned shift = 0;
+    unsigned char byte;
+    do
+    {
+        if (! get_byte (input, byte) || shift > 63)
+            return false;
+
+        value |= static_cast<unsigned long long>(byte & 0x7F) << shift;
+        shift += 7;
+    }
+    while ((byte & 0x80) != 0);
+
+    return true;
+}
+
+
+long long
+zigzag_decode (unsigned long long value)
+{
+    return static_cast<long long>(value >> 1)
+        ^ -static_cast<long long>(value & 1);
+}
+
+
+bool
+get_string (std::istream & input, std::string & str)
+{
+    unsigned long long size;
+    if (! get_varint (input, size))
+        return false;
+
+    str.resize (static_cast<std::size_t>(size));
+    input.read (&str[0], static_cast<std::streamsize>(size));
+    return static_cast<unsigned long long>(input.gcount ()) == size;
+}
+
+
+int
+truncated ()
+{
+    std::cerr << "logdump: truncated or corrupt input\n";
+    return EXIT_FAILURE;
+}
+
+} // namespace
+
+
+int
+main (int argc, char * argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: logdump FILE\n"
+            "Decode a log file written with log4cplus BinaryLayout.\n";
+        return EXIT_FAILURE;
+    }
+
+    log4cplus::Initializer initializer;
+
+    std::ifstream input (argv[1], std::ios_base::in | std::ios_base::binary);
+    if (! input.good ())
+    {
+        std::cerr << "logdump: cannot open " << argv[1] << "\n";
+        return EXIT_FAILURE;
+    }
+
+    char magic[5];
+    input.read (magic, sizeof (magic));
+    if (input.gcount () != sizeof (magic)
+        || magic[0] != 'L' || magic[1] != '4' || magic[2] != 'C'
+        || magic[3] != 'B')
+    {
+        std::cerr << "logdump: " << argv[1]
+            << " is not a BinaryLayout file\n";
+        return EXIT_FAILURE;
+    }
+    if (magic[4] != 1)
+    {
+        std::cerr << "logdump: unsupported format version "
+            << static_cast<int>(magic[4]) << "\n";
+        return EXIT_FAILURE;
+    }
+
+    log4cplus::LogLevelManager & llm = log4cplus::getLogLevelManager ();
+    log4cplus::tstring const time_format (
+        LOG4CPLUS_TEXT ("%Y-%m-%d %H:%M:%S.%q"));
+
+    std::map<unsigned long long, log4cplus::tstring> loggers;
+    long long last_timestamp = 0;
+    unsigned long long pending_sequence = 0;
+    unsigned long long last_sequence = 0;
+
+    unsigned char tag;
+    while (get_byte (input, tag))
+    {
+        if (tag == 'L')
+        {
+            unsigned long long logger_id;
+            std::string logger_name;
+            if (! get_varint (input, logger_id)
+                || ! get_string (input, logger_name))
+                return truncated ();
+
+            loggers[logger_id]
+                = LOG4CPLUS_STRING_TO_TSTRING (logger_name);
+        }
+        else if (tag == 'S')
+        {
+            // Sequence number of the next event record, stamped by
+            // appenders with the SequenceNumbers property enabled.
+            if (! get_varint (input, pending_sequence))
+                return truncated ();
+        }
+        else if (tag == 'E')
+        {
+            unsigned long long logger_id;
+            unsigned long long log_level;
+            unsigned long long timestamp_delta;
+            std::string message;
+            if (! get_varint (input, logger_id)
+                || ! get_varint (input, log_level)
+                || ! get_varint (input, timestamp_delta)
+                || ! get_string (input, message))
+                return truncated ();
+
+            long long const timestamp
+                = last_timestamp + zigzag_decode (timestamp_delta);
+            last_timestamp = timestamp;
+
+            log4cplus::helpers::Time const event_time {
+                log4cplus::helpers::Time::duration (timestamp)};
+
+            if (pending_sequence != 0)
+            {
+                if (last_sequence != 0
+                    && pending_sequence > last_sequence + 1)
+                    std::cerr << "logdump: sequence gap: "
+                        << pending_sequence - last_sequence - 1
+                        << " event(s) missing before #"
+                        << pending_sequence << "\n";
+                last_sequence = pending_sequence;
+
+                log4cplus::tcout << LOG4CPLUS_TEXT ("#")
+                    << pending_sequence << LOG4CPLUS_TEXT (" ");
+                pending_sequence = 0;
+            }
+
+            log4cplus::tcout
+                << log4cplus::helpers::getFormattedTime (time_format,
+                    event_time, true)
+                << LOG4CPLUS_TEXT (" ")
+                << llm.toString (
+                    static_cast<log4cplus::LogLevel>(log_level))
+                << LOG4CPLUS_TEXT (" ")
+                << loggers[logger_id]
+                << LOG4CPLUS_TEXT (" - ")
+                << LOG4CPLUS_STRING_TO_TSTRING (message)
+                << LOG4CPLUS_TEXT ("\n");
+        }
+        else
+        {
+            std::cerr << "logdump: unknown record tag "
+                << static_cast<int>(tag) << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
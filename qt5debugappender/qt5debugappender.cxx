@@ -95,6 +95,75 @@ Qt5DebugAppender::append (spi::InternalLoggingEvent const & ev)
 }
 
 
+namespace
+{
+
+//! Severity bucket an event maps onto; events in the same bucket go
+//! through the same Qt logging function and can share one call.
+static
+int
+qt_severity_bucket (LogLevel ll)
+{
+    if (ll >= ERROR_LOG_LEVEL)
+        return 2;
+    else if (ll >= WARN_LOG_LEVEL)
+        return 1;
+    else
+        return 0;
+}
+
+} // namespace
+
+
+void
+Qt5DebugAppender::appendBatch (spi::InternalLoggingEvent const * events,
+    std::size_t count)
+{
+    // Join each run of events sharing a severity bucket into a
+    // single Qt logging call. If the installed message handler
+    // marshals into the GUI thread, a burst then costs one queued
+    // hop per run instead of one per event. Call site metadata is
+    // taken from the first event of the run; the layout keeps the
+    // per event detail inside the joined text.
+    std::size_t i = 0;
+    while (i != count)
+    {
+        LogLevel const ll = events[i].getLogLevel ();
+        int const bucket = qt_severity_bucket (ll);
+
+        tostringstream oss;
+        std::size_t j = i;
+        for (; j != count && qt_severity_bucket (events[j].getLogLevel ())
+                 == bucket; ++j)
+            layout->formatAndAppend (oss, events[j]);
+
+        spi::InternalLoggingEvent const & first = events[i];
+        std::string const & file
+            = LOG4CPLUS_TSTRING_TO_STRING (first.getFile ());
+        std::string const & func
+            = LOG4CPLUS_TSTRING_TO_STRING (first.getFunction ());
+        std::string const & logger
+            = LOG4CPLUS_TSTRING_TO_STRING (first.getLoggerName ());
+
+        QMessageLogger qlogger (file.c_str (), first.getLine (),
+            func.c_str (), logger.c_str ());
+        void (QMessageLogger:: * log_func) (const char *, ...) const = 0;
+
+        if (ll >= ERROR_LOG_LEVEL)
+            log_func = &QMessageLogger::critical;
+        else if (ll >= WARN_LOG_LEVEL)
+            log_func = &QMessageLogger::warning;
+        else
+            log_func = &QMessageLogger::debug;
+
+        (qlogger.*log_func) ("%s",
+            LOG4CPLUS_TSTRING_TO_STRING (oss.str ()).c_str ());
+
+        i = j;
+    }
+}
+
+
 void
 Qt5DebugAppender::registerAppender ()
 {
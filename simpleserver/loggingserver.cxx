@@ -18,22 +18,265 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <list>
 #include <iostream>
+#include <memory>
+#include <vector>
 #include <log4cplus/configurator.h>
 #include <log4cplus/socketappender.h>
+#include <log4cplus/helpers/compressor.h>
 #include <log4cplus/helpers/socket.h>
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/thread/syncprims.h>
 #include <log4cplus/log4cplus.h>
 
+#if defined (__linux__) && defined (LOG4CPLUS_HAVE_SYS_EPOLL_H) \
+    && ! defined (LOG4CPLUS_SINGLE_THREADED)
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define LOGGINGSERVER_USE_EPOLL 1
+#endif
+
 
 namespace loggingserver
 {
 
 
+//! Bounded reorder stage. Events from all client connections are
+//! buffered in a timestamp keyed min-heap for a short window and
+//! appended in timestamp order, so the aggregated file comes out
+//! sorted without an external sort downstream. An event arriving
+//! more than the window late is appended immediately, out of order.
+class ReorderBuffer
+{
+public:
+    explicit ReorderBuffer (unsigned long window_ms_)
+        : window_ms (window_ms_)
+        , stop (false)
+    {
+        flusher_thread
+            = log4cplus::thread::AbstractThreadPtr (new FlusherThread (*this));
+        flusher_thread->start ();
+    }
+
+    ~ReorderBuffer ()
+    {
+        {
+            log4cplus::thread::MutexGuard guard (mtx);
+            stop = true;
+        }
+        ev.signal ();
+        flusher_thread->join ();
+
+        // Deliver whatever is still buffered.
+        flush (true);
+    }
+
+    //! Puts \c event into the reorder heap. The event is consumed.
+    void enqueue (log4cplus::spi::InternalLoggingEvent & event)
+    {
+        log4cplus::thread::MutexGuard guard (mtx);
+        heap.emplace_back ();
+        heap.back ().swap (event);
+        std::push_heap (heap.begin (), heap.end (), TimestampAfter ());
+    }
+
+private:
+    //! Orders the heap so that the event with the smallest timestamp
+    //! is on top.
+    struct TimestampAfter
+    {
+        bool operator() (log4cplus::spi::InternalLoggingEvent const & lhs,
+            log4cplus::spi::InternalLoggingEvent const & rhs) const
+        {
+            return lhs.getTimestamp () > rhs.getTimestamp ();
+        }
+    };
+
+    class FlusherThread
+        : public log4cplus::thread::AbstractThread
+    {
+    public:
+        explicit FlusherThread (ReorderBuffer & buf_)
+            : buf (buf_)
+        { }
+
+        virtual void run ()
+        {
+            unsigned long const sleep_ms
+                = (std::max) (buf.window_ms / 2, 1ul);
+
+            while (true)
+            {
+                buf.ev.timed_wait (sleep_ms);
+
+                {
+                    log4cplus::thread::MutexGuard guard (buf.mtx);
+                    if (buf.stop)
+                        return;
+                }
+
+                buf.flush (false);
+            }
+        }
+
+    private:
+        ReorderBuffer & buf;
+    };
+
+    //! Pops events that have aged past the reorder window (or all of
+    //! them) off the heap and appends them in timestamp order.
+    void flush (bool all)
+    {
+        log4cplus::helpers::Time const limit = log4cplus::helpers::now ()
+            - std::chrono::milliseconds (window_ms);
+
+        while (true)
+        {
+            log4cplus::spi::InternalLoggingEvent event;
+
+            {
+                log4cplus::thread::MutexGuard guard (mtx);
+                if (heap.empty ()
+                    || (! all && heap.front ().getTimestamp () > limit))
+                    return;
+
+                std::pop_heap (heap.begin (), heap.end (),
+                    TimestampAfter ());
+                event.swap (heap.back ());
+                heap.pop_back ();
+            }
+
+            // Append outside the lock so that receiving threads are
+            // not blocked on downstream appenders.
+            log4cplus::Logger logger
+                = log4cplus::Logger::getInstance (event.getLoggerName ());
+            logger.callAppenders (event);
+        }
+    }
+
+    unsigned long window_ms;
+    log4cplus::thread::Mutex mtx;
+    log4cplus::thread::ManualResetEvent ev;
+    bool stop;
+    std::vector<log4cplus::spi::InternalLoggingEvent> heap;
+    log4cplus::thread::AbstractThreadPtr flusher_thread;
+};
+
+
+//! Reorder stage shared by all receiving threads; null when
+//! reordering is disabled.
+static ReorderBuffer * reorder_stage = nullptr;
+
+
+//! Appends one event, either through the reorder stage or directly.
+static
+void
+deliverEvent (log4cplus::spi::InternalLoggingEvent & event)
+{
+    if (reorder_stage)
+        reorder_stage->enqueue (event);
+    else
+    {
+        log4cplus::Logger logger
+            = log4cplus::Logger::getInstance (event.getLoggerName ());
+        logger.callAppenders (event);
+    }
+}
+
+
+//! Dispatches one frame on its version byte: either a single event
+//! frame or a batch frame with the shared string dictionary.
+static
+void
+deliverFrame (log4cplus::helpers::SocketBuffer & buffer)
+{
+    if (buffer.getMaxSize () != 0
+        && static_cast<unsigned char>(buffer.getBuffer ()[0])
+        == static_cast<unsigned char>(
+            log4cplus::LOG4CPLUS_HEARTBEAT_MESSAGE_VERSION))
+        // Liveness probe from a SocketAppender; nothing to deliver.
+        return;
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+    if (buffer.getMaxSize () != 0
+        && static_cast<unsigned char>(buffer.getBuffer ()[0])
+        == static_cast<unsigned char>(
+            log4cplus::LOG4CPLUS_COMPRESSED_MESSAGE_VERSION))
+    {
+        // Context and buffer are reused per receiving thread; each
+        // envelope inflates independently of the previous ones.
+        static thread_local log4cplus::helpers::FrameDecompressor
+            decompressor;
+        static thread_local std::vector<char> inflated;
+
+        buffer.readByte ();
+        unsigned int const uncompressed_size = buffer.readInt ();
+        if (! decompressor.decompress (inflated,
+                buffer.getBuffer () + buffer.getPos (),
+                buffer.getMaxSize () - buffer.getPos (),
+                uncompressed_size))
+        {
+            std::cerr << "Could not decompress received frame."
+                      << std::endl;
+            return;
+        }
+
+        // The inflated bytes are a concatenation of ordinary size
+        // prefixed frames; deliver each one.
+        std::size_t offset = 0;
+        while (inflated.size () - offset >= sizeof (unsigned int))
+        {
+            log4cplus::helpers::SocketBuffer sizeBuffer (
+                inflated.data () + offset, sizeof (unsigned int));
+            unsigned int const frameSize = sizeBuffer.readInt ();
+            offset += sizeof (unsigned int);
+
+            if (inflated.size () - offset < frameSize)
+                break;
+
+            log4cplus::helpers::SocketBuffer frame (
+                inflated.data () + offset, frameSize);
+            deliverFrame (frame);
+            offset += frameSize;
+        }
+        return;
+    }
+#endif // LOG4CPLUS_WITH_ZLIB
+
+    if (buffer.getMaxSize () != 0
+        && static_cast<unsigned char>(buffer.getBuffer ()[0])
+        == static_cast<unsigned char>(log4cplus::LOG4CPLUS_BATCH_MESSAGE_VERSION))
+    {
+        std::vector<log4cplus::spi::InternalLoggingEvent> events;
+        log4cplus::helpers::readBatchFromBuffer (buffer, events);
+        for (log4cplus::spi::InternalLoggingEvent & event : events)
+            deliverEvent (event);
+    }
+    else
+    {
+        log4cplus::spi::InternalLoggingEvent event
+            = log4cplus::helpers::readFromBuffer (buffer);
+        deliverEvent (event);
+    }
+}
+
+
+#if ! defined (LOGGINGSERVER_USE_EPOLL)
+
 typedef std::list<log4cplus::thread::AbstractThreadPtr> ThreadQueueType;
 
 
@@ -190,26 +433,28 @@ loggingserver::ClientThread::run()
 {
     try
     {
+        // Both buffers are reused across messages; reserve() keeps
+        // the largest storage seen, so steady state receiving does
+        // not allocate.
+        log4cplus::helpers::SocketBuffer msgSizeBuffer(sizeof(unsigned int));
+        log4cplus::helpers::SocketBuffer buffer(0);
+
         while (1)
         {
             if (!clientsock.isOpen())
                 break;
 
-            log4cplus::helpers::SocketBuffer msgSizeBuffer(sizeof(unsigned int));
+            msgSizeBuffer.reserve(sizeof(unsigned int));
             if (!clientsock.read(msgSizeBuffer))
                 break;
 
             unsigned int msgSize = msgSizeBuffer.readInt();
 
-            log4cplus::helpers::SocketBuffer buffer(msgSize);
+            buffer.reserve(msgSize);
             if (!clientsock.read(buffer))
                 break;
 
-            log4cplus::spi::InternalLoggingEvent event
-                = log4cplus::helpers::readFromBuffer(buffer);
-            log4cplus::Logger logger
-                = log4cplus::Logger::getInstance(event.getLoggerName());
-            logger.callAppenders(event);
+            deliverFrame (buffer);
         }
     }
     catch (...)
@@ -221,6 +466,256 @@ loggingserver::ClientThread::run()
     reaper.visit (std::move (self_reference));
 }
 
+#else // LOGGINGSERVER_USE_EPOLL
+
+//! Socket subclass whose only purpose is exposing the raw descriptor
+//! needed by epoll and recv().
+class EventSocket
+    : public log4cplus::helpers::Socket
+{
+public:
+    explicit EventSocket (log4cplus::helpers::Socket && other)
+        : Socket (std::move (other))
+    { }
+
+    int getFd () const
+    {
+        return static_cast<int>(sock);
+    }
+};
+
+
+//! Per connection state: the nonblocking socket and bytes received so
+//! far that do not yet form a complete frame.
+struct Connection
+{
+    explicit Connection (log4cplus::helpers::Socket && sock_)
+        : sock (std::move (sock_))
+    { }
+
+    EventSocket sock;
+    std::vector<char> buffer;
+};
+
+
+//! One worker of the event loop pool. Each worker owns an epoll
+//! instance and all connections assigned to it, so connections never
+//! migrate between threads and need no per frame locking.
+class EventLoopWorker
+    : public log4cplus::thread::AbstractThread
+{
+public:
+    EventLoopWorker ()
+        : epoll_fd (epoll_create1 (EPOLL_CLOEXEC))
+    { }
+
+    virtual
+    ~EventLoopWorker ()
+    {
+        if (epoll_fd != -1)
+            ::close (epoll_fd);
+    }
+
+    bool isUsable () const
+    {
+        return epoll_fd != -1;
+    }
+
+    //! Called by the acceptor thread to hand over a new connection.
+    void addConnection (log4cplus::helpers::Socket && clientsock)
+    {
+        std::unique_ptr<Connection> conn (
+            new Connection (std::move (clientsock)));
+        int const fd = conn->sock.getFd ();
+
+        int fl = fcntl (fd, F_GETFL);
+        if (fl != -1)
+            fcntl (fd, F_SETFL, fl | O_NONBLOCK);
+
+        epoll_event ev;
+        std::memset (&ev, 0, sizeof (ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = conn.get ();
+
+        {
+            log4cplus::thread::MutexGuard guard (mtx);
+            connections[fd] = std::move (conn);
+        }
+
+        if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1)
+        {
+            std::cerr << "epoll_ctl(EPOLL_CTL_ADD) failed: "
+                      << std::strerror (errno) << std::endl;
+            log4cplus::thread::MutexGuard guard (mtx);
+            connections.erase (fd);
+        }
+    }
+
+    virtual void run ();
+
+private:
+    void serviceConnection (Connection & conn);
+    void deliverFrames (Connection & conn);
+    void closeConnection (Connection & conn);
+
+    int epoll_fd;
+
+    //! Protects connections against concurrent insertion by the
+    //! acceptor thread. Connection objects themselves are only ever
+    //! touched by this worker.
+    log4cplus::thread::Mutex mtx;
+    std::map<int, std::unique_ptr<Connection> > connections;
+};
+
+
+typedef log4cplus::helpers::SharedObjectPtr<EventLoopWorker>
+    EventLoopWorkerPtr;
+
+
+void
+EventLoopWorker::run ()
+{
+    std::vector<epoll_event> events (64);
+
+    while (true)
+    {
+        int const n = epoll_wait (epoll_fd, &events[0],
+            static_cast<int>(events.size ()), -1);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            std::cerr << "epoll_wait() failed: " << std::strerror (errno)
+                      << std::endl;
+            return;
+        }
+
+        for (int i = 0; i != n; ++i)
+            serviceConnection (
+                *static_cast<Connection *>(events[i].data.ptr));
+    }
+}
+
+
+void
+EventLoopWorker::serviceConnection (Connection & conn)
+{
+    char chunk[8192];
+
+    while (true)
+    {
+        long const res = ::recv (conn.sock.getFd (), chunk, sizeof (chunk),
+            0);
+        if (res > 0)
+            conn.buffer.insert (conn.buffer.end (), chunk, chunk + res);
+        else if (res == 0)
+        {
+            // Orderly shutdown by the client; deliver what is complete
+            // and drop the rest.
+            deliverFrames (conn);
+            closeConnection (conn);
+            return;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        else if (errno == EINTR)
+            continue;
+        else
+        {
+            closeConnection (conn);
+            return;
+        }
+    }
+
+    deliverFrames (conn);
+}
+
+
+//! Parses all complete size-prefixed frames accumulated in the
+//! connection's buffer and appends the contained events.
+void
+EventLoopWorker::deliverFrames (Connection & conn)
+{
+    std::size_t offset = 0;
+
+    while (conn.buffer.size () - offset >= sizeof (unsigned int))
+    {
+        unsigned int msgSize;
+        std::memcpy (&msgSize, &conn.buffer[offset], sizeof (msgSize));
+        msgSize = ntohl (msgSize);
+
+        if (conn.buffer.size () - offset - sizeof (unsigned int) < msgSize)
+            break;
+
+        // Wrap the frame bytes in place instead of copying them into
+        // a freshly allocated buffer; the frame is fully contained in
+        // conn.buffer which stays untouched until after delivery.
+        log4cplus::helpers::SocketBuffer buffer (
+            conn.buffer.data () + offset + sizeof (unsigned int), msgSize);
+
+        deliverFrame (buffer);
+
+        offset += sizeof (unsigned int) + msgSize;
+    }
+
+    if (offset != 0)
+        conn.buffer.erase (conn.buffer.begin (),
+            conn.buffer.begin () + static_cast<std::ptrdiff_t>(offset));
+}
+
+
+void
+EventLoopWorker::closeConnection (Connection & conn)
+{
+    int const fd = conn.sock.getFd ();
+    epoll_ctl (epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    std::cout << "Client connection closed." << std::endl;
+
+    log4cplus::thread::MutexGuard guard (mtx);
+    connections.erase (fd);
+}
+
+
+//! One accept loop of the multi-acceptor mode. Each acceptor owns a
+//! SO_REUSEPORT listener and a disjoint slice of the event loop
+//! workers, so both the kernel side accept queues and the user side
+//! connection hand-off scale with the number of acceptors instead of
+//! funnelling through one listener.
+class AcceptorThread
+    : public log4cplus::thread::AbstractThread
+{
+public:
+    AcceptorThread (log4cplus::helpers::ServerSocket && serverSocket_,
+        std::vector<EventLoopWorkerPtr> workers_)
+        : serverSocket (std::move (serverSocket_))
+        , workers (std::move (workers_))
+    { }
+
+    virtual void run ()
+    {
+        for (std::size_t next = 0; ; ++next)
+        {
+            log4cplus::helpers::Socket clientsock = serverSocket.accept ();
+            if (! clientsock.isOpen ())
+                continue;
+
+            std::cout << "Received a client connection!!!!" << std::endl;
+            workers[next % workers.size ()]->addConnection (
+                std::move (clientsock));
+        }
+    }
+
+private:
+    log4cplus::helpers::ServerSocket serverSocket;
+    std::vector<EventLoopWorkerPtr> workers;
+};
+
+
+typedef log4cplus::helpers::SharedObjectPtr<AcceptorThread> AcceptorThreadPtr;
+
+#endif // LOGGINGSERVER_USE_EPOLL
+
 } // namespace loggingserver
 
 
@@ -232,26 +727,125 @@ main(int argc, char** argv)
     log4cplus::Initializer initializer;
 
     if(argc < 4) {
-        std::cout << "Usage: host port config_file [<IP version>]\n"
+        std::cout << "Usage: host port config_file [<IP version>"
+            " [<reorder window> [<acceptors>]]]\n"
             << "<IP version> either 0 for IPv4 (default) or 1 for IPv6\n"
+            << "<reorder window> milliseconds events are buffered and"
+            " merged by timestamp before being appended;"
+            " 0 disables reordering (default 200)\n"
+            << "<acceptors> number of accept threads, each with its own"
+            " SO_REUSEPORT listener and its own share of the receiving"
+            " workers. When the argument is given, several server"
+            " processes may also share the port; each process appends"
+            " through its own configuration and the per-process outputs"
+            " are merged on read by timestamp. Default 1, without port"
+            " sharing.\n"
             << std::flush;
         return 1;
     }
     int const port = std::atoi(argv[2]);
     bool const ipv6 = argc >= 5 ? !!std::atoi(argv[4]) : false;
+    unsigned long const reorder_window_ms
+        = argc >= 6 ? std::strtoul(argv[5], nullptr, 10) : 200;
+    std::size_t num_acceptors
+        = argc >= 7 ? std::strtoul(argv[6], nullptr, 10) : 1;
+    if (num_acceptors == 0)
+        num_acceptors = 1;
+    // Any explicit <acceptors> argument opts into SO_REUSEPORT, so a
+    // single acceptor process can still share the port with others.
+    bool const reuse_port = argc >= 7;
     const log4cplus::tstring configFile = LOG4CPLUS_C_STR_TO_TSTRING(argv[3]);
 
+#if ! defined (LOGGINGSERVER_USE_EPOLL)
+    if (num_acceptors > 1)
+    {
+        std::cout << "Multiple acceptors are only supported in the"
+            " epoll build; continuing with one." << std::endl;
+        num_acceptors = 1;
+    }
+#endif
+
     log4cplus::PropertyConfigurator config(configFile);
     config.configure();
 
+    std::unique_ptr<loggingserver::ReorderBuffer> reorder_buffer;
+    if (reorder_window_ms != 0)
+    {
+        reorder_buffer.reset (
+            new loggingserver::ReorderBuffer (reorder_window_ms));
+        loggingserver::reorder_stage = reorder_buffer.get ();
+    }
+
     log4cplus::helpers::ServerSocket serverSocket(port, false, ipv6,
-        LOG4CPLUS_C_STR_TO_TSTRING(argv[1]));
+        LOG4CPLUS_C_STR_TO_TSTRING(argv[1]), reuse_port);
     if (!serverSocket.isOpen()) {
         std::cerr << "Could not open server socket, maybe port "
             << port << " is already in use." << std::endl;
         return 2;
     }
 
+#if defined (LOGGINGSERVER_USE_EPOLL)
+    // Event-driven mode: a small pool of epoll workers services all
+    // connections, instead of one thread per connection.
+    std::size_t const num_workers = (std::max) (num_acceptors,
+        (std::size_t)(std::max) (1u,
+            (std::min) (std::thread::hardware_concurrency (), 8u)));
+    std::vector<loggingserver::EventLoopWorkerPtr> workers;
+    for (std::size_t i = 0; i != num_workers; ++i)
+    {
+        loggingserver::EventLoopWorkerPtr worker (
+            new loggingserver::EventLoopWorker);
+        if (! worker->isUsable ())
+        {
+            std::cerr << "Could not create epoll instance." << std::endl;
+            return 3;
+        }
+        worker->start ();
+        workers.push_back (std::move (worker));
+    }
+
+    // Each acceptor hands connections only to its own disjoint slice
+    // of the workers, so acceptors never contend on the hand-off.
+    std::vector<std::vector<loggingserver::EventLoopWorkerPtr>> slices (
+        num_acceptors);
+    for (std::size_t i = 0; i != num_workers; ++i)
+        slices[i % num_acceptors].push_back (workers[i]);
+
+    std::cout << "Serving connections with " << num_workers
+              << " event loop workers and " << num_acceptors
+              << " acceptor(s)." << std::endl;
+
+    std::vector<loggingserver::AcceptorThreadPtr> acceptors;
+    for (std::size_t i = 1; i < num_acceptors; ++i)
+    {
+        log4cplus::helpers::ServerSocket extraSocket (port, false, ipv6,
+            LOG4CPLUS_C_STR_TO_TSTRING(argv[1]), true);
+        if (! extraSocket.isOpen ())
+        {
+            std::cerr << "Could not open SO_REUSEPORT listener "
+                << i << "." << std::endl;
+            return 2;
+        }
+        loggingserver::AcceptorThreadPtr acceptor (
+            new loggingserver::AcceptorThread (std::move (extraSocket),
+                std::move (slices[i])));
+        acceptor->start ();
+        acceptors.push_back (std::move (acceptor));
+    }
+
+    // The first acceptor loop runs on this thread.
+    for (std::size_t next = 0; ; ++next)
+    {
+        log4cplus::helpers::Socket clientsock = serverSocket.accept ();
+        if (! clientsock.isOpen ())
+            continue;
+
+        std::cout << "Received a client connection!!!!" << std::endl;
+        slices[0][next % slices[0].size ()]->addConnection (
+            std::move (clientsock));
+    }
+
+#else
     loggingserver::Reaper reaper;
 
     for (;;)
@@ -261,5 +855,7 @@ main(int argc, char** argv)
         thr->start();
     }
 
+#endif
+
     return 0;
 }
@@ -21,15 +21,23 @@
 #include <log4cplus/appender.h>
 #include <log4cplus/layout.h>
 #include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/memorybudget.h>
 #include <log4cplus/helpers/pointer.h>
 #include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/helpers/property.h>
 #include <log4cplus/spi/factory.h>
 #include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/logger.h>
+#include <log4cplus/hierarchy.h>
 #include <log4cplus/internal/internal.h>
+#include <log4cplus/internal/tracepoints.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <chrono>
 #include <memory>
+#include <set>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 
 namespace log4cplus
@@ -78,6 +86,42 @@ OnlyOnceErrorHandler::reset()
 
 
 
+namespace
+{
+
+
+//! Decorates the user supplied error handler so that every
+//! invocation is accounted in the owning appender's statistics.
+class CountingErrorHandler
+    : public ErrorHandler
+{
+public:
+    CountingErrorHandler (std::unique_ptr<ErrorHandler> wrapped_,
+        std::atomic<unsigned long long> * counter_)
+        : wrapped (std::move (wrapped_))
+        , counter (counter_)
+    { }
+
+    void error (const log4cplus::tstring & err) override
+    {
+        counter->fetch_add (1, std::memory_order_relaxed);
+        wrapped->error (err);
+    }
+
+    void reset () override
+    {
+        wrapped->reset ();
+    }
+
+private:
+    std::unique_ptr<ErrorHandler> wrapped;
+    std::atomic<unsigned long long> * counter;
+};
+
+
+} // namespace
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // log4cplus::Appender ctors
 ///////////////////////////////////////////////////////////////////////////////
@@ -88,12 +132,15 @@ Appender::Appender()
    threshold(NOT_SET_LOG_LEVEL),
    errorHandler(new OnlyOnceErrorHandler),
    useLockFile(false),
+   useLockFileMutex(false),
    async(false),
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
    in_flight(0),
 #endif
    closed(false)
 {
+    errorHandler = std::make_unique<CountingErrorHandler> (
+        std::move (errorHandler), &stats.errorHandlerInvocations);
 }
 
 
@@ -103,12 +150,16 @@ Appender::Appender(const log4cplus::helpers::Properties & properties)
     , threshold(NOT_SET_LOG_LEVEL)
     , errorHandler(new OnlyOnceErrorHandler)
     , useLockFile(false)
+    , useLockFileMutex(false)
     , async(false)
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     , in_flight(0)
 #endif
     , closed(false)
 {
+    errorHandler = std::make_unique<CountingErrorHandler> (
+        std::move (errorHandler), &stats.errorHandlerInvocations);
+
     if(properties.exists( LOG4CPLUS_TEXT("layout") ))
     {
         log4cplus::tstring const & factoryName
@@ -133,6 +184,7 @@ Appender::Appender(const log4cplus::helpers::Properties & properties)
             }
             else {
                 layout = std::move(newLayout);
+                spi::addNeededEventFields (layout->getNeededEventFields ());
             }
         }
         catch(std::exception const & e) {
@@ -179,8 +231,15 @@ Appender::Appender(const log4cplus::helpers::Properties & properties)
         addFilter (std::move (tmpFilter));
     }
 
+    // The chain is complete now; fuse chains of stock filters into a
+    // single flat predicate so that per event evaluation does not pay
+    // a virtual call per link.
+    if (filterCount > 1)
+        setFilter (spi::compileFilterChain (getFilter ()));
+
     // Deal with file locking settings.
     properties.getBool (useLockFile, LOG4CPLUS_TEXT("UseLockFile"));
+    properties.getBool (useLockFileMutex, LOG4CPLUS_TEXT("LockFileMutex"));
     if (useLockFile)
     {
         tstring const & lockFileName
@@ -189,7 +248,8 @@ Appender::Appender(const log4cplus::helpers::Properties & properties)
         {
             try
             {
-                lockFile = std::make_unique<helpers::LockFile> (lockFileName);
+                lockFile = std::make_unique<helpers::LockFile> (lockFileName,
+                    false, useLockFileMutex);
             }
             catch (std::runtime_error const &)
             {
@@ -206,6 +266,21 @@ Appender::Appender(const log4cplus::helpers::Properties & properties)
 
     // Deal with asynchronous append flag.
     properties.getBool (async, LOG4CPLUS_TEXT("AsyncAppend"));
+
+    // Deal with append latency sampling flag.
+    bool collect = false;
+    properties.getBool (collect, LOG4CPLUS_TEXT("CollectStatistics"));
+    collectStatistics.store (collect, std::memory_order_relaxed);
+
+    // Deal with duplicate event collapsing.
+    properties.getBool (collapseRepeats, LOG4CPLUS_TEXT("CollapseRepeats"));
+    unsigned collapseWindowSeconds = 30;
+    properties.getUInt (collapseWindowSeconds,
+        LOG4CPLUS_TEXT("CollapseRepeatsWindowSeconds"));
+    collapseWindow = std::chrono::seconds (collapseWindowSeconds);
+
+    // Deal with sequence numbering.
+    properties.getBool (sequenceNumbers, LOG4CPLUS_TEXT("SequenceNumbers"));
 }
 
 
@@ -241,8 +316,53 @@ Appender::waitToFinishAsyncLogging()
             [&] { return this->in_flight == 0; });
     }
 #endif
+
+    if (collapseRepeats)
+    {
+        // Settle the collapse stage as well: emit the summary of a
+        // run that is still open. Hierarchy::shutdown() calls this
+        // function before closing appenders, so the count of a
+        // trailing run is not lost at shutdown.
+        thread::MutexGuard guard (access_mutex);
+        if (! closed)
+            emitRepeatSummary ();
+    }
+}
+
+
+bool
+Appender::waitToFinishAsyncLogging(std::chrono::milliseconds budget)
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (async)
+    {
+        std::unique_lock<std::mutex> lock (in_flight_mutex);
+        if (! in_flight_condition.wait_for (lock, budget,
+            [&] { return this->in_flight == 0; }))
+        {
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("Appender ") + getName ()
+                + LOG4CPLUS_TEXT (" - shutdown budget exhausted with ")
+                + helpers::convertIntegerToString (in_flight.load ())
+                + LOG4CPLUS_TEXT (" event(s) still in flight."));
+            return false;
+        }
+    }
+#else
+    (void) budget;
+#endif
+
+    if (collapseRepeats)
+    {
+        thread::MutexGuard guard (access_mutex);
+        if (! closed)
+            emitRepeatSummary ();
+    }
+
+    return true;
 }
 
+
 void
 Appender::destructorImpl()
 {
@@ -342,25 +462,29 @@ Appender::asyncDoAppend(const log4cplus::spi::InternalLoggingEvent& event)
 void
 Appender::syncDoAppend(const log4cplus::spi::InternalLoggingEvent& event)
 {
-    thread::MutexGuard guard (access_mutex);
+    // Check appender's threshold logging level.
 
-    if(closed) {
-        helpers::getLogLog().error(
-            LOG4CPLUS_TEXT("Attempted to append to closed appender named [")
-            + name
-            + LOG4CPLUS_TEXT("]."));
+    if (! isAsSevereAsThreshold(event.getLogLevel()))
         return;
-    }
 
-    // Check appender's threshold logging level.
+    // Evaluate filters attached to this appender. This happens
+    // against an immutable snapshot of the chain, before taking
+    // access_mutex, so that rejected events never contend on the
+    // appender lock.
 
-    if (! isAsSevereAsThreshold(event.getLogLevel()))
+    spi::FilterPtr const filter_chain (getFilterSnapshot());
+    if (checkFilter(filter_chain.get(), event) == spi::DENY)
+    {
+        stats.filterRejections.fetch_add (1, std::memory_order_relaxed);
         return;
+    }
 
-    // Evaluate filters attached to this appender.
+    thread::MutexGuard guard (access_mutex);
 
-    if (checkFilter(filter.get(), event) == spi::DENY)
+    if (LOG4CPLUS_UNLIKELY (closed)) {
+        reportClosedAppender ();
         return;
+    }
 
     // Lock system wide lock.
 
@@ -377,9 +501,142 @@ Appender::syncDoAppend(const log4cplus::spi::InternalLoggingEvent& event)
         }
     }
 
+    // Collapse runs of identical events into "last message repeated
+    // N times" summaries. A suppressed event costs one hash of its
+    // identity; it never reaches the layout.
+
+    if (collapseRepeats && collapseDuplicate (event))
+        return;
+
+    // Stamp the event's sequence number into the per thread slot the
+    // layout reads at format time. Clearing the slot when numbering
+    // is off keeps a stamp left behind by another appender delivering
+    // on this thread out of this appender's output.
+    internal::get_ptd ()->appender_sequence = sequenceNumbers
+        ? sequenceNumber.fetch_add (1, std::memory_order_relaxed) + 1
+        : 0;
+
     // Finally append given event.
 
-    append(event);
+    LOG4CPLUS_TRACEPOINT1 (appender_append, name.c_str ());
+    if (collectStatistics.load (std::memory_order_relaxed))
+    {
+        auto const start = std::chrono::steady_clock::now ();
+        append(event);
+        recordAppendLatency (std::chrono::steady_clock::now () - start, 1);
+    }
+    else
+        append(event);
+
+    LOG4CPLUS_TRACEPOINT1 (appender_append_done, name.c_str ());
+    stats.eventsAppended.fetch_add (1, std::memory_order_relaxed);
+}
+
+
+void
+Appender::doAppendBatch(const log4cplus::spi::InternalLoggingEvent* events,
+    std::size_t count)
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (async)
+    {
+        // Asynchronous appenders enqueue events individually into the
+        // thread pool; there is no batch to preserve there.
+        for (std::size_t i = 0; i != count; ++i)
+            doAppend (events[i]);
+        return;
+    }
+#endif
+
+    if (collapseRepeats || sequenceNumbers)
+    {
+        // The collapse stage is stateful and order dependent, and
+        // sequence numbering must pair each event with its own stamp
+        // before the layout runs -- batch formatting would render the
+        // whole run after a single stamp. Deliver such batches
+        // through the per event path.
+        for (std::size_t i = 0; i != count; ++i)
+            syncDoAppend (events[i]);
+        return;
+    }
+
+    // Find maximal runs of events passing the threshold and filter
+    // checks before taking access_mutex, so that filter evaluation
+    // does not run under the appender lock.
+    spi::FilterPtr const filter_chain (getFilterSnapshot());
+    std::vector<std::pair<std::size_t, std::size_t>> runs;
+    std::size_t run_begin = 0;
+    std::size_t i = 0;
+    for (; i != count; ++i)
+    {
+        spi::InternalLoggingEvent const & event = events[i];
+        if (isAsSevereAsThreshold(event.getLogLevel()))
+        {
+            if (checkFilter(filter_chain.get(), event) != spi::DENY)
+                continue;
+
+            stats.filterRejections.fetch_add (1, std::memory_order_relaxed);
+        }
+
+        if (run_begin != i)
+            runs.emplace_back (run_begin, i - run_begin);
+        run_begin = i + 1;
+    }
+
+    if (run_begin != i)
+        runs.emplace_back (run_begin, i - run_begin);
+
+    if (runs.empty ())
+        return;
+
+    thread::MutexGuard guard (access_mutex);
+
+    if (LOG4CPLUS_UNLIKELY (closed))
+    {
+        reportClosedAppender ();
+        return;
+    }
+
+    helpers::LockFileGuard lfguard;
+    if (useLockFile && lockFile.get ())
+    {
+        try
+        {
+            lfguard.attach_and_lock (*lockFile);
+        }
+        catch (std::runtime_error const &)
+        {
+            return;
+        }
+    }
+
+    bool const collect = collectStatistics.load (std::memory_order_relaxed);
+    for (auto const & run : runs)
+    {
+        LOG4CPLUS_TRACEPOINT2 (appender_append_batch, name.c_str (),
+            run.second);
+        if (collect)
+        {
+            auto const start = std::chrono::steady_clock::now ();
+            appendBatch (events + run.first, run.second);
+            recordAppendLatency (std::chrono::steady_clock::now () - start,
+                run.second);
+        }
+        else
+            appendBatch (events + run.first, run.second);
+
+        stats.eventsAppended.fetch_add (run.second,
+            std::memory_order_relaxed);
+    }
+}
+
+
+void
+Appender::appendBatch(const log4cplus::spi::InternalLoggingEvent* events,
+    std::size_t count)
+{
+    for (std::size_t i = 0; i != count; ++i)
+        append (events[i]);
 }
 
 
@@ -387,13 +644,47 @@ tstring &
 Appender::formatEvent (const spi::InternalLoggingEvent& event) const
 {
     internal::appender_sratch_pad & appender_sp = internal::get_appender_sp ();
+    std::size_t const format_key = layout->getFormatKey ();
+    if (format_key != 0)
+    {
+        // Reuse the line formatted by an identically configured
+        // layout of another appender in the same fanout, if any. It
+        // is copied into the scratch pad because callers may modify
+        // the returned string.
+        if (tstring const * const cached
+            = event.getCachedFormattedLine (format_key))
+        {
+            appender_sp.str = *cached;
+            countBytesWritten (appender_sp.str.size ());
+            return appender_sp.str;
+        }
+    }
+
     detail::clear_tostringstream (appender_sp.oss);
     layout->formatAndAppend(appender_sp.oss, event);
     appender_sp.str = appender_sp.oss.str();
+    if (format_key != 0)
+        event.cacheFormattedLine (format_key, appender_sp.str);
+    countBytesWritten (appender_sp.str.size ());
     return appender_sp.str;
 }
 
 
+void
+Appender::countBytesWritten (std::size_t count) const
+{
+    stats.bytesWritten.fetch_add (count * sizeof (tchar),
+        std::memory_order_relaxed);
+}
+
+
+unsigned long long
+Appender::getBytesWrittenStat () const
+{
+    return stats.bytesWritten.load (std::memory_order_relaxed);
+}
+
+
 log4cplus::tstring
 Appender::getName()
 {
@@ -409,6 +700,20 @@ Appender::setName(const log4cplus::tstring& n)
 }
 
 
+void
+Appender::setThreshold(LogLevel th)
+{
+    threshold = th;
+
+    // Attached appender thresholds are folded into the logger side
+    // effective threshold gates. There is no back link from an
+    // appender to its attachers, so refresh the default hierarchy's
+    // gates; custom hierarchies recompute them on their next
+    // configuration change.
+    getDefaultHierarchy ().refreshThresholds ();
+}
+
+
 ErrorHandler*
 Appender::getErrorHandler()
 {
@@ -431,7 +736,8 @@ Appender::setErrorHandler(std::unique_ptr<ErrorHandler> eh)
 
     thread::MutexGuard guard (access_mutex);
 
-    this->errorHandler = std::move(eh);
+    this->errorHandler = std::make_unique<CountingErrorHandler> (
+        std::move (eh), &stats.errorHandlerInvocations);
 }
 
 
@@ -442,6 +748,8 @@ Appender::setLayout(std::unique_ptr<Layout> lo)
     thread::MutexGuard guard (access_mutex);
 
     this->layout = std::move(lo);
+    if (this->layout)
+        spi::addNeededEventFields (this->layout->getNeededEventFields ());
 }
 
 
@@ -461,15 +769,15 @@ Appender::setFilter(log4cplus::spi::FilterPtr f)
     thread::MutexGuard guard (access_mutex);
 
     filter = std::move (f);
+    std::atomic_store (&filterSnapshot,
+        std::make_shared<spi::FilterPtr const> (filter));
 }
 
 
 log4cplus::spi::FilterPtr
 Appender::getFilter() const
 {
-    thread::MutexGuard guard (access_mutex);
-
-    return filter;
+    return getFilterSnapshot ();
 }
 
 
@@ -497,4 +805,274 @@ Appender::addFilter (std::function<
 }
 
 
+namespace
+{
+
+
+//! Estimates the q-th quantile in microseconds from a base 2
+//! histogram of nanosecond latencies, interpolating linearly within
+//! the bucket holding the requested rank.
+static
+double
+histogram_quantile (unsigned long long const (& histogram)[64],
+    unsigned long long total, double q)
+{
+    double const rank = q * static_cast<double>(total);
+    unsigned long long cumulative = 0;
+    for (std::size_t i = 0; i != 64; ++i)
+    {
+        if (histogram[i] == 0)
+            continue;
+
+        cumulative += histogram[i];
+        if (static_cast<double>(cumulative) >= rank)
+        {
+            // Bucket i covers [2^i, 2^(i+1)) nanoseconds, with bucket
+            // 0 also holding the sub 2 ns samples.
+            double const lo = i == 0
+                ? 0.0
+                : static_cast<double>(1ull << i);
+            double const hi = i == 63
+                ? 2.0 * static_cast<double>(1ull << 63)
+                : static_cast<double>(1ull << (i + 1));
+            double const fraction
+                = (rank - static_cast<double>(cumulative - histogram[i]))
+                / static_cast<double>(histogram[i]);
+            return (lo + fraction * (hi - lo)) / 1000.0;
+        }
+    }
+
+    return 0.0;
+}
+
+
+//! Hashes the identity (logger, level, message) of an event for the
+//! duplicate collapse stage.
+static
+std::size_t
+event_dedup_hash (spi::InternalLoggingEvent const & event)
+{
+    std::hash<tstring> const hasher;
+    std::size_t h = hasher (event.getMessage ());
+    h ^= hasher (event.getLoggerName ())
+        + 0x9e3779b9u + (h << 6) + (h >> 2);
+    h ^= static_cast<std::size_t>(event.getLogLevel ())
+        + 0x9e3779b9u + (h << 6) + (h >> 2);
+    return h;
+}
+
+
+} // namespace
+
+
+Appender::Statistics
+Appender::getStatistics () const
+{
+    Statistics result;
+    result.name = name;
+    result.eventsAppended
+        = stats.eventsAppended.load (std::memory_order_relaxed);
+    result.bytesWritten
+        = stats.bytesWritten.load (std::memory_order_relaxed);
+    result.filterRejections
+        = stats.filterRejections.load (std::memory_order_relaxed);
+    result.eventsCollapsed
+        = stats.eventsCollapsed.load (std::memory_order_relaxed);
+    result.errorHandlerInvocations
+        = stats.errorHandlerInvocations.load (std::memory_order_relaxed);
+
+    unsigned long long histogram[64];
+    unsigned long long total = 0;
+    for (std::size_t i = 0; i != 64; ++i)
+    {
+        histogram[i] = stats.latencyHistogram[i].load (
+            std::memory_order_relaxed);
+        total += histogram[i];
+    }
+
+    if (total != 0)
+    {
+        result.appendLatencyP50Usec
+            = histogram_quantile (histogram, total, 0.50);
+        result.appendLatencyP99Usec
+            = histogram_quantile (histogram, total, 0.99);
+    }
+
+    return result;
+}
+
+
+void
+Appender::setCollectStatistics (bool enable)
+{
+    collectStatistics.store (enable, std::memory_order_relaxed);
+}
+
+
+bool
+Appender::getCollectStatistics () const
+{
+    return collectStatistics.load (std::memory_order_relaxed);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// log4cplus::Appender private methods
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+Appender::collapseDuplicate (const spi::InternalLoggingEvent & event)
+{
+    std::size_t const hash = event_dedup_hash (event);
+    auto const now = std::chrono::steady_clock::now ();
+
+    if (haveLastEvent && hash == lastEventHash
+        && now - runStart <= collapseWindow)
+    {
+        ++repeatCount;
+        stats.eventsCollapsed.fetch_add (1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Either a different event or a run older than the window;
+    // summarize the finished run and let this event through as the
+    // start of a new one.
+    emitRepeatSummary ();
+
+    haveLastEvent = true;
+    lastEventHash = hash;
+    lastEventLogLevel = event.getLogLevel ();
+    lastEventLoggerName = event.getLoggerName ();
+    runStart = now;
+    return false;
+}
+
+
+void
+Appender::emitRepeatSummary ()
+{
+    if (repeatCount == 0)
+        return;
+
+    tostringstream oss;
+    oss << LOG4CPLUS_TEXT ("last message repeated ") << repeatCount
+        << LOG4CPLUS_TEXT (" times");
+    spi::InternalLoggingEvent summary (lastEventLoggerName,
+        lastEventLogLevel, oss.str (), nullptr, 0);
+    // The summary reaches the output like any other event, so it
+    // consumes a sequence number of its own.
+    internal::get_ptd ()->appender_sequence = sequenceNumbers
+        ? sequenceNumber.fetch_add (1, std::memory_order_relaxed) + 1
+        : 0;
+    append (summary);
+    stats.eventsAppended.fetch_add (1, std::memory_order_relaxed);
+    repeatCount = 0;
+}
+
+
+void
+Appender::reportClosedAppender () const
+{
+    helpers::getLogLog().error(
+        LOG4CPLUS_TEXT("Attempted to append to closed appender named [")
+        + name
+        + LOG4CPLUS_TEXT("]."));
+}
+
+
+void
+Appender::recordAppendLatency (std::chrono::steady_clock::duration duration,
+    std::size_t count)
+{
+    if (count == 0)
+        return;
+
+    // Batches record the mean per event latency, once per event.
+    long long ns = std::chrono::duration_cast<std::chrono::nanoseconds> (
+        duration).count () / static_cast<long long>(count);
+    if (ns < 0)
+        ns = 0;
+
+    std::size_t bucket = 0;
+    while (ns > 1 && bucket != 63)
+    {
+        ns >>= 1;
+        ++bucket;
+    }
+
+    stats.latencyHistogram[bucket].fetch_add (count,
+        std::memory_order_relaxed);
+}
+
+log4cplus::spi::FilterPtr
+Appender::getFilterSnapshot() const
+{
+    std::shared_ptr<spi::FilterPtr const> const snapshot (
+        std::atomic_load (&filterSnapshot));
+    return snapshot ? *snapshot : spi::FilterPtr ();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Appender statistics surface
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<Appender::Statistics>
+statistics ()
+{
+    std::vector<Appender::Statistics> result;
+    std::set<Appender const *> seen;
+
+    auto const collect = [&result, &seen] (Logger logger)
+    {
+        for (SharedAppenderPtr const & appender : logger.getAllAppenders ())
+        {
+            // An appender can be attached to several loggers; report
+            // it only once.
+            if (seen.insert (appender.get ()).second)
+                result.push_back (appender->getStatistics ());
+        }
+    };
+
+    Hierarchy & h = Logger::getDefaultHierarchy ();
+    collect (h.getRoot ());
+    for (Logger & logger : h.getCurrentLoggers ())
+        collect (logger);
+
+    return result;
+}
+
+
+void
+dumpStatistics ()
+{
+    helpers::LogLog & loglog = helpers::getLogLog ();
+    for (Appender::Statistics const & s : statistics ())
+    {
+        tostringstream oss;
+        oss << LOG4CPLUS_TEXT ("Appender [") << s.name
+            << LOG4CPLUS_TEXT ("]: events=") << s.eventsAppended
+            << LOG4CPLUS_TEXT (" bytes=") << s.bytesWritten
+            << LOG4CPLUS_TEXT (" filtered=") << s.filterRejections
+            << LOG4CPLUS_TEXT (" collapsed=") << s.eventsCollapsed
+            << LOG4CPLUS_TEXT (" errors=") << s.errorHandlerInvocations
+            << LOG4CPLUS_TEXT (" p50=") << s.appendLatencyP50Usec
+            << LOG4CPLUS_TEXT ("us p99=") << s.appendLatencyP99Usec
+            << LOG4CPLUS_TEXT ("us");
+        loglog.debug (oss.str ());
+    }
+
+    helpers::MemoryBudget & budget = helpers::MemoryBudget::instance ();
+    if (budget.getLimit () != 0 || budget.getUsage () != 0)
+    {
+        tostringstream oss;
+        oss << LOG4CPLUS_TEXT ("MemoryBudget: usage=")
+            << budget.getUsage ()
+            << LOG4CPLUS_TEXT (" limit=") << budget.getLimit ()
+            << LOG4CPLUS_TEXT (" shed=") << budget.getShedCount ();
+        loglog.debug (oss.str ());
+    }
+}
+
+
 } // namespace log4cplus
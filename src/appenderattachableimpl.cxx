@@ -26,12 +26,23 @@
 #include <log4cplus/thread/syncprims-pub-impl.h>
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 
 
 namespace log4cplus
 {
 
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+// from global-init.cxx
+void enqueueThreadPoolTask (std::function<void ()> task);
+#endif
+
+
 namespace spi
 {
 
@@ -70,13 +81,22 @@ AppenderAttachableImpl::addAppender(SharedAppenderPtr newAppender)
         return;
     }
 
-    thread::MutexGuard guard (appender_list_mutex);
-
-    auto it = std::find(appenderList.begin(), appenderList.end(), newAppender);
-    if (it == appenderList.end())
+    bool changed = false;
     {
-        appenderList.push_back(newAppender);
+        thread::MutexGuard guard (appender_list_mutex);
+
+        auto it = std::find(appenderList.begin(), appenderList.end(),
+            newAppender);
+        if (it == appenderList.end())
+        {
+            appenderList.push_back(newAppender);
+            appenderListStale.store (true, std::memory_order_release);
+            changed = true;
+        }
     }
+
+    if (changed)
+        appenderListChanged();
 }
 
 
@@ -84,22 +104,23 @@ AppenderAttachableImpl::addAppender(SharedAppenderPtr newAppender)
 AppenderAttachableImpl::ListType
 AppenderAttachableImpl::getAllAppenders()
 {
-    thread::MutexGuard guard (appender_list_mutex);
-
-    return appenderList;
+    std::shared_ptr<ListType const> const snapshot (getAppenderListSnapshot());
+    return snapshot ? *snapshot : ListType ();
 }
 
 
 
 SharedAppenderPtr
-AppenderAttachableImpl::getAppender(const log4cplus::tstring& name)
+AppenderAttachableImpl::getAppender(const log4cplus::tstring_view& name)
 {
-    thread::MutexGuard guard (appender_list_mutex);
-
-    for (SharedAppenderPtr & ptr : appenderList)
+    std::shared_ptr<ListType const> const snapshot (getAppenderListSnapshot());
+    if (snapshot)
     {
-        if (ptr->getName() == name)
-            return ptr;
+        for (SharedAppenderPtr const & ptr : *snapshot)
+        {
+            if (ptr->getName() == name)
+                return ptr;
+        }
     }
 
     return SharedAppenderPtr ();
@@ -110,16 +131,32 @@ AppenderAttachableImpl::getAppender(const log4cplus::tstring& name)
 void
 AppenderAttachableImpl::removeAllAppenders()
 {
-    thread::MutexGuard guard (appender_list_mutex);
-
-    // Clear appenders in specific order because the order of destruction of
-    // std::vector elements is surprisingly unspecified and it breaks our
-    // tests' expectations.
-
-    for (auto & app : appenderList)
-        app = SharedAppenderPtr ();
+    {
+        thread::MutexGuard guard (appender_list_mutex);
+
+        // Unpublish the snapshots before tearing the list down. The
+        // appenderList references keep the appenders alive here, so
+        // dropping the snapshots cannot be what destroys them and the
+        // ordered clearing below stays in control.
+        std::atomic_store (&appenderListSnapshot,
+            std::shared_ptr<ListType const> ());
+        std::atomic_store (&appenderListByThreshold,
+            std::shared_ptr<ListType const> ());
+
+        // Clear appenders in specific order because the order of destruction of
+        // std::vector elements is surprisingly unspecified and it breaks our
+        // tests' expectations.
+
+        for (auto & app : appenderList)
+            app = SharedAppenderPtr ();
+
+        appenderList.clear ();
+        // The null snapshots already describe the empty list; there
+        // is nothing left to republish.
+        appenderListStale.store (false, std::memory_order_release);
+    }
 
-    appenderList.clear ();
+    appenderListChanged();
 }
 
 
@@ -133,19 +170,28 @@ AppenderAttachableImpl::removeAppender(SharedAppenderPtr appender)
         return;
     }
 
-    thread::MutexGuard guard (appender_list_mutex);
-
-    auto it = std::find(appenderList.begin(), appenderList.end(), appender);
-    if (it != appenderList.end())
+    bool changed = false;
     {
-        appenderList.erase(it);
+        thread::MutexGuard guard (appender_list_mutex);
+
+        auto it = std::find(appenderList.begin(), appenderList.end(),
+            appender);
+        if (it != appenderList.end())
+        {
+            appenderList.erase(it);
+            appenderListStale.store (true, std::memory_order_release);
+            changed = true;
+        }
     }
+
+    if (changed)
+        appenderListChanged();
 }
 
 
 
 void
-AppenderAttachableImpl::removeAppender(const log4cplus::tstring& name)
+AppenderAttachableImpl::removeAppender(const log4cplus::tstring_view& name)
 {
     removeAppender(getAppender(name));
 }
@@ -155,17 +201,207 @@ AppenderAttachableImpl::removeAppender(const log4cplus::tstring& name)
 int
 AppenderAttachableImpl::appendLoopOnAppenders(const spi::InternalLoggingEvent& event) const
 {
-    int count = 0;
+    std::shared_ptr<ListType const> const snapshot (
+        getAppenderListByThreshold());
+    if (! snapshot)
+        return 0;
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (snapshot->size () > 1
+        && parallelFanout.load (std::memory_order_relaxed))
+        return appendLoopOnAppendersParallel (*snapshot, &event, 1);
+#endif
+
+    LogLevel const ll = event.getLogLevel ();
+    for (SharedAppenderPtr const & appender : *snapshot)
+    {
+        // The snapshot is sorted by ascending threshold only as of its
+        // publication; Appender::setThreshold() can change a threshold
+        // at run time without republishing the list, so every
+        // appender's live threshold has to be checked individually.
+        if (appender->getThreshold () <= ll)
+            appender->doAppend(event);
+    }
 
-    thread::MutexGuard guard (appender_list_mutex);
+    // Appenders whose threshold rejects the event are skipped here
+    // exactly as a doAppend() call would reject it; callers use the
+    // count only to detect a logger without any appenders.
+    return static_cast<int>(snapshot->size ());
+}
+
+
+int
+AppenderAttachableImpl::appendLoopOnAppenders(
+    const spi::InternalLoggingEvent* events, std::size_t count) const
+{
+    int appender_count = 0;
+
+    std::shared_ptr<ListType const> const snapshot (getAppenderListSnapshot());
+    if (! snapshot)
+        return appender_count;
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (snapshot->size () > 1 && count != 0
+        && parallelFanout.load (std::memory_order_relaxed))
+        return appendLoopOnAppendersParallel (*snapshot, events, count);
+#endif
+
+    for (SharedAppenderPtr const & appender : *snapshot)
+    {
+        ++appender_count;
+        appender->doAppendBatch(events, count);
+    }
+
+    return appender_count;
+}
+
+
+void
+AppenderAttachableImpl::setParallelFanout (bool enable)
+{
+    parallelFanout.store (enable, std::memory_order_relaxed);
+    // The hierarchy's routing table routes around loggers with
+    // parallel fan-out; let it re-resolve the masks.
+    appenderListChanged ();
+}
+
+
+bool
+AppenderAttachableImpl::getParallelFanout () const
+{
+    return parallelFanout.load (std::memory_order_relaxed);
+}
+
+
+bool
+AppenderAttachableImpl::getAppenderThresholdFloor (LogLevel & floor) const
+{
+    std::shared_ptr<ListType const> const snapshot (getAppenderListSnapshot());
+    if (! snapshot || snapshot->empty ())
+        return false;
 
-    for (auto & appender : appenderList)
+    LogLevel result = (*snapshot)[0]->getThreshold ();
+    for (SharedAppenderPtr const & appender : *snapshot)
+        result = (std::min) (result, appender->getThreshold ());
+
+    floor = result;
+    return true;
+}
+
+
+void
+AppenderAttachableImpl::appenderListChanged ()
+{ }
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+int
+AppenderAttachableImpl::appendLoopOnAppendersParallel (
+    ListType const & appenders, const spi::InternalLoggingEvent * events,
+    std::size_t count) const
+{
+    // Resolve the lazily captured thread specific members here; the
+    // workers run on foreign threads. The one slot formatted line
+    // cache of an event is not synchronized, so bypass it while the
+    // workers format concurrently. Each worker formats into its own
+    // per thread scratch buffers.
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        events[i].gatherThreadSpecificData ();
+        events[i].enableFormattedLineCache (false);
+    }
+
+    std::atomic<std::size_t> remaining {appenders.size ()};
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    for (SharedAppenderPtr const & appender : appenders)
     {
-        ++count;
-        appender->doAppend(event);
+        enqueueThreadPoolTask (
+            [&, appender] ()
+            {
+                appender->doAppendBatch (events, count);
+                if (remaining.fetch_sub (1, std::memory_order_acq_rel) == 1)
+                {
+                    std::lock_guard<std::mutex> guard (mtx);
+                    cv.notify_all ();
+                }
+            });
     }
 
-    return count;
+    std::unique_lock<std::mutex> lock (mtx);
+    cv.wait (lock,
+        [&] {
+            return remaining.load (std::memory_order_acquire) == 0;
+        });
+    lock.unlock ();
+
+    for (std::size_t i = 0; i != count; ++i)
+        events[i].enableFormattedLineCache (true);
+
+    return static_cast<int>(appenders.size ());
+}
+
+#endif // ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+
+///////////////////////////////////////////////////////////////////////////////
+// log4cplus::helpers::AppenderAttachableImpl private methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+AppenderAttachableImpl::publishAppenderList() const
+{
+    std::atomic_store (&appenderListSnapshot,
+        std::shared_ptr<ListType const> (
+            std::make_shared<ListType> (appenderList)));
+
+    auto sorted = std::make_shared<ListType> (appenderList);
+    std::stable_sort (sorted->begin (), sorted->end (),
+        [] (SharedAppenderPtr const & lhs, SharedAppenderPtr const & rhs)
+        {
+            return lhs->getThreshold () < rhs->getThreshold ();
+        });
+    std::atomic_store (&appenderListByThreshold,
+        std::shared_ptr<ListType const> (std::move (sorted)));
+}
+
+
+void
+AppenderAttachableImpl::refreshAppenderListSnapshot() const
+{
+    thread::MutexGuard guard (appender_list_mutex);
+
+    // Another reader may have republished while this one was waiting
+    // for the mutex.
+    if (! appenderListStale.load (std::memory_order_relaxed))
+        return;
+
+    publishAppenderList ();
+    appenderListStale.store (false, std::memory_order_release);
+}
+
+
+std::shared_ptr<AppenderAttachableImpl::ListType const>
+AppenderAttachableImpl::getAppenderListSnapshot() const
+{
+    if (LOG4CPLUS_UNLIKELY (
+            appenderListStale.load (std::memory_order_acquire)))
+        refreshAppenderListSnapshot ();
+
+    return std::atomic_load (&appenderListSnapshot);
+}
+
+
+std::shared_ptr<AppenderAttachableImpl::ListType const>
+AppenderAttachableImpl::getAppenderListByThreshold() const
+{
+    if (LOG4CPLUS_UNLIKELY (
+            appenderListStale.load (std::memory_order_acquire)))
+        refreshAppenderListSnapshot ();
+
+    return std::atomic_load (&appenderListByThreshold);
 }
 
 
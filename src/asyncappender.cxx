@@ -26,9 +26,17 @@
 
 #include <log4cplus/asyncappender.h>
 #include <log4cplus/spi/factory.h>
+#include <log4cplus/helpers/eventspill.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <log4cplus/internal/env.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <thread>
 
 
 namespace log4cplus
@@ -39,6 +47,21 @@ namespace
 {
 
 
+//! Number of spilled events replayed per spillMaintenance() call, so
+//! that the replay interleaves with draining fresh events instead of
+//! monopolizing the consumer.
+std::size_t const spill_replay_batch = 256;
+
+//! Chunk size used by deliverBatch() when a spill store is
+//! configured; between chunks the parked overflow is flushed to disk.
+std::size_t const spill_delivery_chunk = 64;
+
+//! Chunk size used for bulk batches when the fast lane is enabled;
+//! between chunks the fast lane is drained, which bounds how long a
+//! large bulk batch can delay a high severity event.
+std::size_t const fast_lane_chunk = 64;
+
+
 class QueueThread
     : public thread::AbstractThread
 {
@@ -65,17 +88,71 @@ QueueThread::run()
     using ev_buf_type = log4cplus::thread::Queue::queue_storage_type;
     ev_buf_type ev_buf;
 
-    while (true)
+    if (appenders->hasFastLane ())
     {
-        unsigned qflags = queue->get_events (&ev_buf);
-        if (qflags & thread::Queue::EVENT)
+        // Fast lane consumer: both lanes are polled, the high
+        // severity lane first, and the thread parks on the shared
+        // lane_wakeup event instead of the bulk queue, because it
+        // must wake up for events in either lane.
+        while (true)
         {
-            auto const ev_buf_end = ev_buf.end ();
-            for (auto it = ev_buf.begin ();
-                it != ev_buf_end; ++it)
-                appenders->appendLoopOnAppenders (*it);
+            bool const fast = appenders->drainFastLane ();
+
+            unsigned const qflags = queue->try_get_events (&ev_buf);
+            if (qflags & thread::Queue::EVENT)
+            {
+                // Deliver the bulk batch in chunks with the fast
+                // lane drained in between, so that even a batch of
+                // queue-limit size cannot delay a severe event by
+                // more than one chunk of bulk deliveries.
+                std::size_t const total = ev_buf.size ();
+                for (std::size_t offset = 0; offset != total; )
+                {
+                    std::size_t const chunk
+                        = (std::min) (total - offset, fast_lane_chunk);
+                    appenders->deliverBatch (ev_buf.data () + offset,
+                        chunk);
+                    offset += chunk;
+                    if (offset != total)
+                        appenders->drainFastLane ();
+                }
+            }
+
+            bool const spilled = appenders->spillMaintenance ();
+
+            if ((thread::Queue::EXIT & qflags)
+                && ! (thread::Queue::EVENT & qflags)
+                && ! fast && ! spilled)
+                break;
+
+            if (! fast && ! (thread::Queue::EVENT & qflags) && ! spilled)
+                appenders->laneWait (100);
         }
 
+        // Severe events raced in while the loop was exiting.
+        appenders->drainFastLane ();
+        appenders->spillDrain ();
+        return;
+    }
+
+    while (true)
+    {
+        unsigned qflags;
+        if (appenders->hasSpillBacklog ())
+            // Poll instead of parking on the queue so that spilled
+            // events keep being replayed even while no fresh events
+            // arrive.
+            qflags = queue->try_get_events (&ev_buf);
+        else
+            qflags = queue->get_events (&ev_buf);
+
+        if (qflags & thread::Queue::EVENT)
+            // Deliver the whole dequeued batch in one call so that
+            // appenders and layouts can amortize per event costs.
+            appenders->deliverBatch (ev_buf.data (), ev_buf.size ());
+
+        appenders->spillMaintenance ();
+
         if (((thread::Queue::EXIT | thread::Queue::DRAIN
                 | thread::Queue::EVENT) & qflags)
             == (thread::Queue::EXIT | thread::Queue::DRAIN
@@ -84,12 +161,250 @@ QueueThread::run()
         else if (thread::Queue::EXIT & qflags)
             break;
     }
+
+    appenders->spillDrain ();
+}
+
+
+//! Process-wide registry of named dispatchers.
+struct DispatcherRegistry
+{
+    thread::Mutex mutex;
+    std::map<tstring, AsyncDispatcherPtr> dispatchers;
+};
+
+
+DispatcherRegistry &
+get_dispatcher_registry ()
+{
+    static DispatcherRegistry registry;
+    return registry;
 }
 
 
 } // namespace
 
 
+//
+// AsyncDispatcher
+//
+
+struct AsyncDispatcher::Entry
+{
+    Entry (thread::QueuePtr const & q, AsyncAppenderPtr const & a)
+        : queue (q)
+        , appender (a)
+        , busy (false)
+    { }
+
+    thread::QueuePtr queue;
+    AsyncAppenderPtr appender;
+
+    //! Claimed by a worker for the duration of one drain and
+    //! delivery; keeps each queue single consumer.
+    std::atomic<bool> busy;
+};
+
+
+class AsyncDispatcher::Worker
+    : public thread::AbstractThread
+{
+public:
+    Worker (AsyncDispatcherPtr disp, std::size_t offset_)
+        : dispatcher (std::move (disp))
+        , offset (offset_)
+    { }
+
+    void run () override;
+
+private:
+    AsyncDispatcherPtr dispatcher;
+
+    //! Scan start offset; staggers the workers over the queues so
+    //! that they do not all contend for the same one.
+    std::size_t offset;
+};
+
+
+void
+AsyncDispatcher::Worker::run ()
+{
+    thread::Queue::queue_storage_type ev_buf;
+
+    while (! dispatcher->workers_exit.load (std::memory_order_acquire))
+    {
+        if (! dispatcher->serviceQueues (offset, ev_buf))
+        {
+            dispatcher->wakeup.timed_wait (100);
+            if (dispatcher->workers_exit.load (std::memory_order_acquire))
+                break;
+            // Reset before the next scan; events enqueued after the
+            // scan above re-signal the event, so none can be missed.
+            dispatcher->wakeup.reset ();
+        }
+    }
+}
+
+
+AsyncDispatcherPtr
+AsyncDispatcher::get (tstring const & name, unsigned worker_count)
+{
+    DispatcherRegistry & registry = get_dispatcher_registry ();
+    thread::MutexGuard guard (registry.mutex);
+
+    auto it = registry.dispatchers.find (name);
+    if (it != registry.dispatchers.end ())
+        return it->second;
+
+    AsyncDispatcherPtr dispatcher (
+        new AsyncDispatcher (name, worker_count));
+    registry.dispatchers.emplace (name, dispatcher);
+    return dispatcher;
+}
+
+
+AsyncDispatcher::AsyncDispatcher (tstring const & name_,
+    unsigned worker_count)
+    : name (name_)
+    , workers_exit (false)
+{
+    worker_count = (std::max) (worker_count, 1u);
+    workers.reserve (worker_count);
+    for (unsigned i = 0; i != worker_count; ++i)
+    {
+        thread::AbstractThreadPtr worker (
+            new Worker (AsyncDispatcherPtr (this), i));
+        worker->start ();
+        workers.push_back (std::move (worker));
+    }
+    helpers::getLogLog ().debug (
+        LOG4CPLUS_TEXT ("Dispatcher worker threads started."));
+}
+
+
+AsyncDispatcher::~AsyncDispatcher ()
+{ }
+
+
+void
+AsyncDispatcher::addQueue (thread::QueuePtr const & q,
+    AsyncAppenderPtr const & appender)
+{
+    thread::MutexGuard guard (entries_mutex);
+    entries.push_back (std::make_shared<Entry> (q, appender));
+}
+
+
+void
+AsyncDispatcher::removeQueue (thread::QueuePtr const & q)
+{
+    std::shared_ptr<Entry> entry;
+    bool last = false;
+    {
+        thread::MutexGuard guard (entries_mutex);
+        for (auto it = entries.begin (); it != entries.end (); ++it)
+        {
+            if ((*it)->queue == q)
+            {
+                entry = *it;
+                entries.erase (it);
+                break;
+            }
+        }
+        last = entries.empty ();
+    }
+
+    if (entry)
+    {
+        // Wait for a worker that may be draining the queue right now
+        // and then deliver the remaining events synchronously.
+        while (entry->busy.exchange (true, std::memory_order_acquire))
+            std::this_thread::yield ();
+
+        thread::Queue::queue_storage_type ev_buf;
+        while (entry->queue->try_get_events (&ev_buf)
+            & thread::Queue::EVENT)
+            entry->appender->deliverBatch (ev_buf.data (),
+                ev_buf.size ());
+        entry->appender->spillDrain ();
+
+        entry->busy.store (false, std::memory_order_release);
+    }
+
+    if (last)
+    {
+        // The last registered appender is gone. Deregister first so
+        // that a later configuration round gets a fresh dispatcher,
+        // then stop the worker threads.
+        DispatcherRegistry & registry = get_dispatcher_registry ();
+        {
+            thread::MutexGuard guard (registry.mutex);
+            registry.dispatchers.erase (name);
+        }
+        shutdownWorkers ();
+    }
+}
+
+
+void
+AsyncDispatcher::notify ()
+{
+    wakeup.signal ();
+}
+
+
+bool
+AsyncDispatcher::serviceQueues (std::size_t start,
+    thread::Queue::queue_storage_type & buf)
+{
+    std::vector<std::shared_ptr<Entry> > snapshot;
+    {
+        thread::MutexGuard guard (entries_mutex);
+        snapshot = entries;
+    }
+
+    std::size_t const count = snapshot.size ();
+    bool delivered = false;
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        Entry & entry = *snapshot[(start + i) % count];
+
+        // Claim the queue; one already claimed by another worker is
+        // being serviced and can simply be skipped.
+        if (entry.busy.exchange (true, std::memory_order_acquire))
+            continue;
+
+        unsigned const qflags = entry.queue->try_get_events (&buf);
+        if (qflags & thread::Queue::EVENT)
+        {
+            // Deliver the whole dequeued batch in one call so that
+            // appenders and layouts can amortize per event costs.
+            entry.appender->deliverBatch (buf.data (), buf.size ());
+            delivered = true;
+        }
+
+        if (entry.appender->spillMaintenance ())
+            delivered = true;
+
+        entry.busy.store (false, std::memory_order_release);
+    }
+
+    return delivered;
+}
+
+
+void
+AsyncDispatcher::shutdownWorkers ()
+{
+    workers_exit.store (true, std::memory_order_release);
+    wakeup.signal ();
+    for (thread::AbstractThreadPtr & worker : workers)
+        if (worker->isRunning ())
+            worker->join ();
+    workers.clear ();
+}
+
+
 AsyncAppender::AsyncAppender (SharedAppenderPtr const & app,
     unsigned queue_len)
 {
@@ -128,7 +443,126 @@ AsyncAppender::AsyncAppender (helpers::Properties const & props)
     unsigned queue_len = 100;
     props.getUInt (queue_len, LOG4CPLUS_TEXT ("QueueLimit"));
 
-    init_queue_thread (queue_len);
+    tstring const & queue_type (
+        props.getProperty (LOG4CPLUS_TEXT ("QueueType")));
+
+    tstring overflow_policy (
+        props.getProperty (LOG4CPLUS_TEXT ("OverflowPolicy")));
+    if (overflow_policy == LOG4CPLUS_TEXT ("SpillToDisk"))
+    {
+        tstring const & spill_file (
+            props.getProperty (LOG4CPLUS_TEXT ("SpillFile")));
+        unsigned spill_limit_mb = 100;
+        props.getUInt (spill_limit_mb, LOG4CPLUS_TEXT ("SpillLimitMB"));
+        if (! spill_file.empty ())
+            spill.reset (new helpers::EventSpill (spill_file,
+                static_cast<std::size_t>(spill_limit_mb) * 1024 * 1024));
+        if (! spill || ! spill->is_open ())
+        {
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("AsyncAppender::AsyncAppender()")
+                LOG4CPLUS_TEXT (" - SpillToDisk requires a usable")
+                LOG4CPLUS_TEXT (" SpillFile, falling back to Block."));
+            spill.reset ();
+            overflow_policy.clear ();
+        }
+    }
+
+    tstring const & dispatcher_name (
+        props.getProperty (LOG4CPLUS_TEXT ("Dispatcher")));
+
+    unsigned dispatcher_workers = 2;
+    props.getUInt (dispatcher_workers,
+        LOG4CPLUS_TEXT ("DispatcherWorkers"));
+
+    sched_options
+        = thread::AbstractThread::schedulingOptionsFromProperties (props);
+
+    bool parallel_fanout = false;
+    props.getBool (parallel_fanout, LOG4CPLUS_TEXT ("ParallelFanout"));
+    setParallelFanout (parallel_fanout);
+
+    bool lock_queue_memory = false;
+    props.getBool (lock_queue_memory, LOG4CPLUS_TEXT ("LockQueueMemory"));
+
+    tstring const & fast_lane_str (
+        props.getProperty (LOG4CPLUS_TEXT ("FastLaneThreshold")));
+    if (! fast_lane_str.empty ())
+    {
+        LogLevel const threshold
+            = getLogLevelManager ().fromString (fast_lane_str);
+        if (threshold == NOT_SET_LOG_LEVEL)
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("AsyncAppender::AsyncAppender()")
+                LOG4CPLUS_TEXT (" - Unknown FastLaneThreshold: ")
+                + fast_lane_str);
+        else if (! dispatcher_name.empty ())
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("AsyncAppender::AsyncAppender()")
+                LOG4CPLUS_TEXT (" - FastLaneThreshold is ignored")
+                LOG4CPLUS_TEXT (" together with Dispatcher."));
+        else
+        {
+            unsigned fast_len = 100;
+            props.getUInt (fast_len, LOG4CPLUS_TEXT ("FastLaneLimit"));
+            fast_lane_threshold = threshold;
+            fast_queue = new thread::Queue (fast_len);
+        }
+    }
+
+    tstring const & adaptive_str (
+        props.getProperty (LOG4CPLUS_TEXT ("AdaptiveThreshold")));
+    if (! adaptive_str.empty ())
+    {
+        LogLevel const threshold
+            = getLogLevelManager ().fromString (adaptive_str);
+        if (threshold == NOT_SET_LOG_LEVEL)
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("AsyncAppender::AsyncAppender()")
+                LOG4CPLUS_TEXT (" - Unknown AdaptiveThreshold: ")
+                + adaptive_str);
+        else
+        {
+            unsigned high_percent = 80;
+            unsigned low_percent = 50;
+            props.getUInt (high_percent,
+                LOG4CPLUS_TEXT ("AdaptiveHighWatermarkPercent"));
+            props.getUInt (low_percent,
+                LOG4CPLUS_TEXT ("AdaptiveLowWatermarkPercent"));
+            if (low_percent > high_percent)
+            {
+                helpers::getLogLog ().warn (
+                    LOG4CPLUS_TEXT ("AsyncAppender::AsyncAppender()")
+                    LOG4CPLUS_TEXT (" - AdaptiveLowWatermarkPercent")
+                    LOG4CPLUS_TEXT (" exceeds the high watermark,")
+                    LOG4CPLUS_TEXT (" using the high watermark."));
+                low_percent = high_percent;
+            }
+            adaptive_threshold = threshold;
+            adaptive_high_mark = (std::max) (std::size_t (1),
+                static_cast<std::size_t>(queue_len) * high_percent / 100);
+            adaptive_low_mark
+                = static_cast<std::size_t>(queue_len) * low_percent / 100;
+        }
+    }
+
+    tstring const & drain_str (
+        props.getProperty (LOG4CPLUS_TEXT ("ShutdownDrainThreshold")));
+    if (! drain_str.empty ())
+    {
+        LogLevel const threshold
+            = getLogLevelManager ().fromString (drain_str);
+        if (threshold == NOT_SET_LOG_LEVEL)
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("AsyncAppender::AsyncAppender()")
+                LOG4CPLUS_TEXT (" - Unknown ShutdownDrainThreshold: ")
+                + drain_str);
+        else
+            shutdown_drain_threshold = threshold;
+    }
+
+    init_queue_thread (queue_len, queue_type, overflow_policy,
+        dispatcher_name, dispatcher_workers, lock_queue_memory);
 }
 
 
@@ -138,13 +572,329 @@ AsyncAppender::~AsyncAppender ()
 }
 
 
+bool
+AsyncAppender::waitToFinishAsyncLogging (std::chrono::milliseconds budget)
+{
+    auto const deadline = std::chrono::steady_clock::now () + budget;
+    std::size_t remaining = 0;
+
+    if (queue)
+    {
+        std::size_t const queued_at_entry = queue->get_occupancy ();
+        std::size_t const dropped_at_entry = queue->get_dropped_count ();
+
+        // Arm the drain deadline first so that the consumer starts
+        // checking it even for a batch it has already taken out of
+        // the queue.
+        drain_deadline_us.store (
+            (helpers::steady_now () + budget).time_since_epoch ().count (),
+            std::memory_order_relaxed);
+
+        // Give the consumer the whole budget to drain the queue at
+        // full fidelity.
+        while ((remaining = queue->get_occupancy ()) != 0
+            && std::chrono::steady_clock::now () < deadline)
+            std::this_thread::sleep_for (std::chrono::milliseconds (1));
+
+        if (remaining != 0)
+            // The sink could not keep up within the budget. The
+            // armed deadline restricts the rest of the drain to high
+            // severity events, so the tail that matters still gets
+            // out before the process is killed.
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("AsyncAppender ") + getName ()
+                + LOG4CPLUS_TEXT (" - shutdown budget exhausted with ")
+                + helpers::convertIntegerToString (remaining)
+                + LOG4CPLUS_TEXT (" event(s) queued; dropping events")
+                LOG4CPLUS_TEXT (" below the ShutdownDrainThreshold."));
+
+        helpers::getLogLog ().debug (
+            LOG4CPLUS_TEXT ("AsyncAppender ") + getName ()
+            + LOG4CPLUS_TEXT (" - shutdown drain: ")
+            + helpers::convertIntegerToString (
+                queued_at_entry - (std::min) (remaining, queued_at_entry))
+            + LOG4CPLUS_TEXT (" event(s) left the queue, ")
+            + helpers::convertIntegerToString (
+                queue->get_dropped_count () - dropped_at_entry)
+            + LOG4CPLUS_TEXT (" dropped so far."));
+    }
+
+    auto const now = std::chrono::steady_clock::now ();
+    auto const leftover = now < deadline
+        ? std::chrono::duration_cast<std::chrono::milliseconds> (
+            deadline - now)
+        : std::chrono::milliseconds (0);
+    return Appender::waitToFinishAsyncLogging (leftover) && remaining == 0;
+}
+
+
+std::size_t
+AsyncAppender::getDroppedCount () const
+{
+    if (queue)
+        return queue->get_dropped_count ();
+    else
+        return 0;
+}
+
+
+std::size_t
+AsyncAppender::getQueueOccupancy () const
+{
+    if (queue)
+        return queue->get_occupancy ();
+    else
+        return 0;
+}
+
+
+bool
+AsyncAppender::hasFastLane () const
+{
+    return static_cast<bool>(fast_queue);
+}
+
+
+bool
+AsyncAppender::drainFastLane ()
+{
+    unsigned const qflags = fast_queue->try_get_events (&fast_buf);
+    if (! (qflags & thread::Queue::EVENT))
+        return false;
+
+    deliverBatch (fast_buf.data (), fast_buf.size ());
+    return true;
+}
+
+
+void
+AsyncAppender::laneWait (unsigned long millis)
+{
+    lane_wakeup.timed_wait (millis);
+    // Reset before the next scan; events enqueued after the scan
+    // above re-signal the event, so none can be missed.
+    lane_wakeup.reset ();
+}
+
+
+bool
+AsyncAppender::hasSpillBacklog ()
+{
+    return spill
+        && (! spill->empty () || queue->has_spill_pending ());
+}
+
+
+void
+AsyncAppender::deliverBatch (spi::InternalLoggingEvent const * events,
+    std::size_t count)
+{
+    long long const deadline_us
+        = drain_deadline_us.load (std::memory_order_relaxed);
+    if (LOG4CPLUS_UNLIKELY (deadline_us != 0))
+    {
+        // A budgeted shutdown is in progress. Deliver in chunks and
+        // re-check the deadline in between, so that the cutoff also
+        // engages in the middle of a batch taken out of the queue
+        // before the budget ran out. The spill chunking is skipped
+        // here; producers are gone by now and speed is what the
+        // remaining budget needs.
+        std::size_t const chunk_size = 256;
+        std::size_t offset = 0;
+        while (offset != count
+            && helpers::steady_now ().time_since_epoch ().count ()
+                < deadline_us)
+        {
+            std::size_t const chunk
+                = (std::min) (count - offset, chunk_size);
+            appendLoopOnAppenders (events + offset, chunk);
+            offset += chunk;
+        }
+
+        // Past the deadline: only the high severity tail still gets
+        // out, as contiguous runs; the rest is counted as dropped.
+        std::size_t dropped_here = 0;
+        std::size_t run_begin = offset;
+        for (std::size_t i = offset; i != count; ++i)
+        {
+            if (events[i].getLogLevel () < shutdown_drain_threshold)
+            {
+                if (i != run_begin)
+                    appendLoopOnAppenders (events + run_begin,
+                        i - run_begin);
+                run_begin = i + 1;
+                ++dropped_here;
+            }
+        }
+        if (count != run_begin)
+            appendLoopOnAppenders (events + run_begin, count - run_begin);
+        if (dropped_here != 0 && queue)
+            queue->add_dropped (dropped_here);
+        return;
+    }
+
+    if (! spill)
+    {
+        appendLoopOnAppenders (events, count);
+        return;
+    }
+
+    // Deliver in chunks and flush the parked overflow to disk in
+    // between, so that a batch crawling through a slow sink does not
+    // keep the spill writer away from the parking buffer.
+    for (std::size_t offset = 0; offset != count; )
+    {
+        std::size_t const chunk
+            = (std::min) (count - offset, spill_delivery_chunk);
+        appendLoopOnAppenders (events + offset, chunk);
+        offset += chunk;
+        if (offset != count)
+            spillWritePending ();
+    }
+}
+
+
+bool
+AsyncAppender::spillWritePending ()
+{
+    spill_buf.clear ();
+    if (! queue->take_spill_pending (spill_buf))
+        return false;
+
+    // One large sequential write per taken batch.
+    std::size_t const discarded
+        = spill->write (spill_buf.data (), spill_buf.size ());
+    if (discarded != 0)
+        queue->add_dropped (discarded);
+    return true;
+}
+
+
+bool
+AsyncAppender::spillMaintenance ()
+{
+    if (! spill)
+        return false;
+
+    if (spillWritePending ())
+        return true;
+
+    if (! spill->empty ())
+    {
+        // No fresh overflow, so the sink is keeping up again; replay
+        // a bounded batch of spilled events.
+        replay_buf.clear ();
+        if (spill->read (replay_buf, spill_replay_batch) != 0)
+        {
+            deliverBatch (replay_buf.data (), replay_buf.size ());
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
 void
-AsyncAppender::init_queue_thread (unsigned queue_len)
+AsyncAppender::spillDrain ()
 {
-    queue = new thread::Queue (queue_len);
-    queue_thread = new QueueThread (AsyncAppenderPtr (this), queue);
-    queue_thread->start ();
-    helpers::getLogLog ().debug (LOG4CPLUS_TEXT("Queue thread started."));
+    if (! spill)
+        return;
+
+    spill_buf.clear ();
+    if (queue && queue->take_spill_pending (spill_buf))
+    {
+        std::size_t const discarded
+            = spill->write (spill_buf.data (), spill_buf.size ());
+        if (discarded != 0)
+            queue->add_dropped (discarded);
+    }
+
+    while (! spill->empty ())
+    {
+        replay_buf.clear ();
+        if (spill->read (replay_buf, spill_replay_batch) == 0)
+            break;
+        deliverBatch (replay_buf.data (), replay_buf.size ());
+    }
+}
+
+
+void
+AsyncAppender::init_queue_thread (unsigned queue_len,
+    tstring const & queue_type, tstring const & overflow_policy,
+    tstring const & dispatcher_name, unsigned dispatcher_workers,
+    bool lock_queue_memory)
+{
+    if (queue_type.empty ()
+        || queue_type == LOG4CPLUS_TEXT ("deque"))
+        queue = new thread::Queue (queue_len);
+    else if (queue_type == LOG4CPLUS_TEXT ("ring"))
+        queue = new thread::RingQueue (queue_len);
+    else if (queue_type == LOG4CPLUS_TEXT ("doublebuffer"))
+        queue = new thread::DoubleBufferQueue (queue_len);
+    else
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("AsyncAppender::init_queue_thread()")
+            LOG4CPLUS_TEXT (" - Unknown QueueType: ")
+            + queue_type);
+        queue = new thread::Queue (queue_len);
+    }
+
+    if (! overflow_policy.empty ()
+        && overflow_policy != LOG4CPLUS_TEXT ("Block"))
+    {
+        if (overflow_policy == LOG4CPLUS_TEXT ("DropOldest"))
+            queue->set_overflow_policy (thread::Queue::DROP_OLDEST);
+        else if (overflow_policy == LOG4CPLUS_TEXT ("DropNewest"))
+            queue->set_overflow_policy (thread::Queue::DROP_NEWEST);
+        else if (overflow_policy == LOG4CPLUS_TEXT ("SpillToDisk"))
+            queue->set_overflow_policy (thread::Queue::SPILL_TO_DISK);
+        else if (overflow_policy.compare (0, 14,
+                LOG4CPLUS_TEXT ("DropBelowLevel")) == 0)
+        {
+            LogLevel drop_below = WARN_LOG_LEVEL;
+            tstring::size_type const eq_pos = overflow_policy.find (
+                LOG4CPLUS_TEXT ('='));
+            if (eq_pos != tstring::npos)
+                drop_below = getLogLevelManager ().fromString (
+                    overflow_policy.substr (eq_pos + 1));
+            queue->set_overflow_policy (thread::Queue::DROP_BELOW_LEVEL,
+                drop_below);
+        }
+        else
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("AsyncAppender::init_queue_thread()")
+                LOG4CPLUS_TEXT (" - Unknown OverflowPolicy: ")
+                + overflow_policy);
+    }
+
+    // The lock must be taken before the consumer thread touches the
+    // queue; lock_storage() is not synchronized.
+    if (lock_queue_memory && ! queue->lock_storage ())
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("AsyncAppender::init_queue_thread()")
+            LOG4CPLUS_TEXT (" - Could not lock queue memory,")
+            LOG4CPLUS_TEXT (" continuing with unlocked storage."));
+
+    if (! dispatcher_name.empty ())
+    {
+        dispatcher = AsyncDispatcher::get (dispatcher_name,
+            dispatcher_workers);
+        dispatcher->addQueue (queue, AsyncAppenderPtr (this));
+        helpers::getLogLog ().debug (
+            LOG4CPLUS_TEXT ("Queue registered with dispatcher ")
+            + dispatcher_name + LOG4CPLUS_TEXT ("."));
+    }
+    else
+    {
+        queue_thread = new QueueThread (AsyncAppenderPtr (this), queue);
+        queue_thread->setSchedulingOptions (sched_options);
+        queue_thread->start ();
+        helpers::getLogLog ().debug (
+            LOG4CPLUS_TEXT("Queue thread started."));
+    }
 }
 
 
@@ -159,22 +909,105 @@ AsyncAppender::close ()
                 LOG4CPLUS_TEXT ("Error in AsyncAppender::close"));
     }
 
+    if (fast_queue)
+    {
+        // Unblock producers waiting on a full fast lane; the consumer
+        // drains the lane once more before it exits.
+        fast_queue->signal_exit ();
+        lane_wakeup.signal ();
+    }
+
+    if (dispatcher)
+    {
+        // Unregistering drains the events still held in the queue.
+        dispatcher->removeQueue (queue);
+        dispatcher = nullptr;
+    }
+
     if (queue_thread && queue_thread->isRunning ())
         queue_thread->join ();
 
+    if (queue
+        && drain_deadline_us.load (std::memory_order_relaxed) != 0)
+        // Budgeted shutdown: the consumer is done, report what the
+        // whole drain cost.
+        helpers::getLogLog ().debug (
+            LOG4CPLUS_TEXT ("AsyncAppender ") + getName ()
+            + LOG4CPLUS_TEXT (" - budgeted shutdown complete, ")
+            + helpers::convertIntegerToString (queue->get_dropped_count ())
+            + LOG4CPLUS_TEXT (" event(s) dropped in total."));
+
     removeAllAppenders();
 
     queue_thread = nullptr;
     queue = nullptr;
+    // The consumer has drained and replayed everything by now; this
+    // also removes the emptied spill file.
+    spill.reset ();
 }
 
 
 void
 AsyncAppender::append (spi::InternalLoggingEvent const & ev)
 {
-    if (queue_thread && queue_thread->isRunning ())
+    if (adaptive_threshold != NOT_SET_LOG_LEVEL && queue)
     {
+        // Adaptive verbosity: while the queue is congested, events
+        // below the adaptive threshold are shed here, before they
+        // cost an enqueue. The watermark hysteresis keeps the
+        // threshold from flapping around a single boundary.
+        std::size_t const occupancy = queue->get_occupancy ();
+        bool engaged = adaptive_engaged.load (std::memory_order_relaxed);
+        if (engaged && occupancy <= adaptive_low_mark)
+        {
+            engaged = false;
+            adaptive_engaged.store (false, std::memory_order_relaxed);
+            helpers::getLogLog ().debug (
+                LOG4CPLUS_TEXT ("AsyncAppender::append()")
+                LOG4CPLUS_TEXT (" - queue drained, restoring full")
+                LOG4CPLUS_TEXT (" verbosity."));
+        }
+        else if (! engaged && occupancy >= adaptive_high_mark)
+        {
+            engaged = true;
+            adaptive_engaged.store (true, std::memory_order_relaxed);
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("AsyncAppender::append()")
+                LOG4CPLUS_TEXT (" - queue congested, shedding events")
+                LOG4CPLUS_TEXT (" below the adaptive threshold."));
+        }
+
+        if (engaged && ev.getLogLevel () < adaptive_threshold)
+        {
+            queue->add_dropped (1);
+            return;
+        }
+    }
+
+    if (dispatcher)
+    {
+        unsigned ret = queue->put_event (ev);
+        dispatcher->notify ();
+        if (ret & (thread::Queue::ERROR_BIT | thread::Queue::ERROR_AFTER))
+            getErrorHandler ()->error (
+                LOG4CPLUS_TEXT ("Error in AsyncAppender::append."));
+    }
+    else if (queue_thread && queue_thread->isRunning ())
+    {
+        if (fast_queue && ev.getLogLevel () >= fast_lane_threshold)
+        {
+            unsigned const ret = fast_queue->put_event (ev);
+            lane_wakeup.signal ();
+            if (ret & (thread::Queue::ERROR_BIT | thread::Queue::ERROR_AFTER))
+                getErrorHandler ()->error (
+                    LOG4CPLUS_TEXT ("Error in AsyncAppender::append,")
+                    LOG4CPLUS_TEXT (" fast lane put failed."));
+            return;
+        }
+
         unsigned ret = queue->put_event (ev);
+        if (fast_queue)
+            lane_wakeup.signal ();
         if (ret & (thread::Queue::ERROR_BIT | thread::Queue::ERROR_AFTER))
         {
             getErrorHandler ()->error (
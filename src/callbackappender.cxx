@@ -39,7 +39,22 @@ CallbackAppender::CallbackAppender(log4cplus_log_event_callback_t callback_,
     void * cookie_)
     : callback (callback_)
     , cookie (cookie_)
-{ }
+{
+    // The callback signatures expose the thread names regardless of
+    // any layout.
+    spi::addNeededEventFields (spi::EventFieldThread
+        | spi::EventFieldThread2);
+}
+
+
+CallbackAppender::CallbackAppender(
+    log4cplus_log_event_callback_v2_t callback_, void * cookie_)
+    : callback_v2 (callback_)
+    , cookie (cookie_)
+{
+    spi::addNeededEventFields (spi::EventFieldThread
+        | spi::EventFieldThread2);
+}
 
 
 CallbackAppender::CallbackAppender(const helpers::Properties& properties)
@@ -59,10 +74,64 @@ CallbackAppender::close()
 }
 
 
+void
+CallbackAppender::setCookie(void * cookie_)
+{
+    cookie = cookie_;
+}
+
+
+void
+CallbackAppender::setCallback(log4cplus_log_event_callback_t callback_)
+{
+    callback = callback_;
+    spi::addNeededEventFields (spi::EventFieldThread
+        | spi::EventFieldThread2);
+}
+
+
+void
+CallbackAppender::setCallbackV2(log4cplus_log_event_callback_v2_t callback_)
+{
+    callback_v2 = callback_;
+    spi::addNeededEventFields (spi::EventFieldThread
+        | spi::EventFieldThread2);
+}
+
+
 void
 CallbackAppender::append(const spi::InternalLoggingEvent& ev)
 {
-    if (callback)
+    if (callback_v2)
+    {
+        helpers::Time const & t = ev.getTimestamp();
+
+        // The view borrows the event's own storage; nothing is
+        // copied and the struct lives on the stack for the duration
+        // of the callback only.
+        log4cplus_log_event_view_t view;
+        view.message = ev.getMessage().c_str();
+        view.message_len = ev.getMessage().size();
+        view.logger_name = ev.getLoggerName().c_str();
+        view.logger_name_len = ev.getLoggerName().size();
+        view.ll = ev.getLogLevel();
+        view.thread = ev.getThread().c_str();
+        view.thread_len = ev.getThread().size();
+        view.thread2 = ev.getThread2().c_str();
+        view.thread2_len = ev.getThread2().size();
+        view.timestamp_secs
+            = static_cast<unsigned long long>(helpers::to_time_t(t));
+        view.timestamp_usecs
+            = static_cast<unsigned long>(helpers::microseconds_part(t));
+        view.file = ev.getFile().c_str();
+        view.file_len = ev.getFile().size();
+        view.function_name = ev.getFunction().c_str();
+        view.function_name_len = ev.getFunction().size();
+        view.line = ev.getLine();
+
+        callback_v2(cookie, &view);
+    }
+    else if (callback)
     {
         helpers::Time const & t = ev.getTimestamp();
         callback(cookie, ev.getMessage().c_str(),
@@ -35,6 +35,7 @@
 #include <sstream>
 #include <iomanip>
 #include <cstring>
+#include <vector>
 #include <log4cplus/config/windowsh-inc.h>
 #include <clfsw32.h>
 #include <clfsmgmtw32.h>
@@ -72,7 +73,7 @@ struct CLFSAppender::Data
     Data ()
         : log_handle (INVALID_HANDLE_VALUE)
         , buffer_size (0)
-    = default;
+    { }
 
     tstring log_name;
     HANDLE log_handle;
@@ -168,6 +169,19 @@ CLFSAppender::init (tstring const & logname, unsigned long logsize,
                 LOG4CPLUS_TEXT ("InstallLogPolicy(ClfsMgmtPolicyNewContainerSize)"));
             goto error;
         }
+
+        // Preallocate the minimum working set of containers up front
+        // so the first appends do not stall on container creation.
+        // CLFS requires at least two containers per log; the policy
+        // makes SetLogFileSizeWithPolicy() below allocate them now.
+        log_policy.PolicyType = ClfsMgmtPolicyMinimumSize;
+        log_policy.PolicyParameters.MinimumSize.Containers = 2;
+        if (! InstallLogPolicy (data->log_handle, &log_policy))
+        {
+            loglog_win32_error (
+                LOG4CPLUS_TEXT ("InstallLogPolicy(ClfsMgmtPolicyMinimumSize)"));
+            goto error;
+        }
     }
 
     desired_size = 0;
@@ -258,6 +272,62 @@ CLFSAppender::append (spi::InternalLoggingEvent const & ev)
 }
 
 
+void
+CLFSAppender::appendBatch (spi::InternalLoggingEvent const * events,
+    std::size_t count)
+{
+    if (data->log_handle == INVALID_HANDLE_VALUE)
+        return;
+
+    std::vector<tstring> lines;
+    lines.reserve (count);
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        tostringstream oss;
+        layout->formatAndAppend (oss, events[i]);
+
+        lines.push_back (oss.str ());
+        if ((lines.back ().size () + 1) * sizeof (tchar) > data->buffer_size)
+            lines.back ().resize (data->buffer_size / sizeof (tchar));
+    }
+
+    // Reserve space for as many records as fit into the marshaling
+    // area at once and append them contiguously through one
+    // ReserveAndAppendLog() call per run. The records stay buffered
+    // in the marshaling area and are forced out once at the end,
+    // instead of paying a forced append per record.
+    std::vector<CLFS_WRITE_ENTRY> write_entries;
+
+    std::size_t i = 0;
+    while (i != lines.size ())
+    {
+        write_entries.clear ();
+        ULONG run_bytes = 0;
+        for (; i != lines.size (); ++i)
+        {
+            ULONG const byte_length = static_cast<ULONG>(
+                (lines[i].size () + 1) * sizeof (tchar));
+            if (! write_entries.empty ()
+                && run_bytes + byte_length > data->buffer_size)
+                break;
+
+            CLFS_WRITE_ENTRY entry;
+            entry.Buffer = const_cast<tchar *>(lines[i].c_str ());
+            entry.ByteLength = byte_length;
+            write_entries.push_back (entry);
+            run_bytes += byte_length;
+        }
+
+        if (! ReserveAndAppendLog (data->buffer, write_entries.data (),
+            static_cast<ULONG>(write_entries.size ()), 0, 0, 0, 0, 0, 0, 0))
+            loglog_win32_error (LOG4CPLUS_TEXT ("ReserveAndAppendLog"));
+    }
+
+    if (! FlushLogBuffers (data->buffer, 0))
+        loglog_win32_error (LOG4CPLUS_TEXT ("FlushLogBuffers"));
+}
+
+
 void
 CLFSAppender::registerAppender ()
 {
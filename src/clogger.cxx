@@ -228,6 +228,27 @@ log4cplus_add_callback_appender(const log4cplus_char_t * logger_name,
 }
 
 
+LOG4CPLUS_EXPORT int
+log4cplus_add_callback_appender_v2(const log4cplus_char_t * logger_name,
+    log4cplus_log_event_callback_v2_t callback, void * cookie)
+{
+    try
+    {
+        Logger logger = logger_name
+            ? Logger::getInstance(logger_name)
+            : Logger::getRoot();
+        SharedAppenderPtr appender(new CallbackAppender(callback, cookie));
+        logger.addAppender(appender);
+    }
+    catch (std::exception const &)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+
 LOG4CPLUS_EXPORT int
 log4cplus_logger_exists(const log4cplus_char_t *name)
 {
@@ -382,6 +403,173 @@ log4cplus_logger_force_log_str(const log4cplus_char_t *name, loglevel_t ll,
 }
 
 
+LOG4CPLUS_EXPORT log4cplus_logger_handle_t
+log4cplus_logger_get(const log4cplus_char_t *name)
+{
+    try
+    {
+        return new Logger(
+            name ? Logger::getInstance(name) : Logger::getRoot());
+    }
+    catch (std::exception const &)
+    {
+        return nullptr;
+    }
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_logger_release(log4cplus_logger_handle_t logger)
+{
+    if (!logger)
+        return EINVAL;
+
+    delete static_cast<Logger *>(logger);
+    return 0;
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_hlogger_is_enabled_for(log4cplus_logger_handle_t logger,
+    loglevel_t ll)
+{
+    if (!logger)
+        return false;
+
+    return static_cast<Logger *>(logger)->isEnabledFor(ll);
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_hlogger_log(log4cplus_logger_handle_t logger_, loglevel_t ll,
+    const log4cplus_char_t *msgfmt, ...)
+{
+    int retval = -1;
+
+    if (!logger_)
+        return EINVAL;
+
+    try
+    {
+        Logger & logger = *static_cast<Logger *>(logger_);
+
+        if( logger.isEnabledFor(ll) )
+        {
+            const tchar * msg = nullptr;
+            snprintf_buf buf;
+            std::va_list ap;
+
+            do
+            {
+                va_start(ap, msgfmt);
+                retval = buf.print_va_list(msg, msgfmt, ap);
+                va_end(ap);
+            }
+            while (retval == -1);
+
+            logger.forcedLog(ll, msg, nullptr, -1);
+        }
+
+        retval = 0;
+    }
+    catch(std::exception const &)
+    {
+        // Fall through.
+    }
+
+    return retval;
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_hlogger_log_str(log4cplus_logger_handle_t logger_,
+    log4cplus_loglevel_t ll, const log4cplus_char_t *msg)
+{
+    int retval = -1;
+
+    if (!logger_)
+        return EINVAL;
+
+    try
+    {
+        Logger & logger = *static_cast<Logger *>(logger_);
+
+        if (logger.isEnabledFor(ll))
+        {
+            logger.forcedLog(ll, msg, nullptr, -1);
+        }
+
+        retval = 0;
+    }
+    catch (std::exception const &)
+    {
+        // Fall through.
+    }
+
+    return retval;
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_hlogger_force_log(log4cplus_logger_handle_t logger_, loglevel_t ll,
+    const log4cplus_char_t *msgfmt, ...)
+{
+    int retval = -1;
+
+    if (!logger_)
+        return EINVAL;
+
+    try
+    {
+        Logger & logger = *static_cast<Logger *>(logger_);
+        const tchar * msg = nullptr;
+        snprintf_buf buf;
+        std::va_list ap;
+
+        do
+        {
+            va_start(ap, msgfmt);
+            retval = buf.print_va_list(msg, msgfmt, ap);
+            va_end(ap);
+        }
+        while (retval == -1);
+
+        logger.forcedLog(ll, msg, nullptr, -1);
+
+        retval = 0;
+    }
+    catch(std::exception const &)
+    {
+        // Fall through.
+    }
+
+    return retval;
+}
+
+
+LOG4CPLUS_EXPORT int
+log4cplus_hlogger_force_log_str(log4cplus_logger_handle_t logger_,
+    loglevel_t ll, const log4cplus_char_t *msg)
+{
+    int retval = -1;
+
+    if (!logger_)
+        return EINVAL;
+
+    try
+    {
+        static_cast<Logger *>(logger_)->forcedLog(ll, msg, nullptr, -1);
+        retval = 0;
+    }
+    catch (std::exception const &)
+    {
+        // Fall through.
+    }
+
+    return retval;
+}
+
+
 namespace log4cplus::internal {
 
 CustomLogLevelManager::CustomLogLevelManager ()
@@ -482,7 +670,12 @@ log4cplus_add_log_level(unsigned int ll, const log4cplus_char_t *ll_name)
 
     tstring nm(ll_name);
     if( log4cplus::internal::getCustomLogLevelManager ().add(ll, nm) == true )
+    {
+        // Invalidate here, outside the custom manager's lock, to
+        // keep the manager-then-translator lock order of toString().
+        log4cplus::getLogLevelManager ().invalidateNameCache ();
         return 0;
+    }
 
     return -1;
 }
@@ -495,7 +688,12 @@ log4cplus_remove_log_level(unsigned int ll, const log4cplus_char_t *ll_name)
 
     tstring nm(ll_name);
     if( log4cplus::internal::getCustomLogLevelManager ().remove(ll, nm) == true )
+    {
+        // The cache may still point at the removed name's storage;
+        // drop it before the erased map node can be reused.
+        log4cplus::getLogLevelManager ().invalidateNameCache ();
         return 0;
+    }
 
     return -1;
 }
@@ -0,0 +1,141 @@
+//  Copyright (C) 2009-2017, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/helpers/compressor.h>
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+
+#include <zlib.h>
+
+
+namespace log4cplus {
+
+namespace helpers {
+
+
+FrameCompressor::FrameCompressor ()
+    : stream (nullptr)
+{
+    z_stream * const zs = new z_stream ();
+    if (deflateInit (zs, Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+        delete zs;
+        return;
+    }
+
+    stream = zs;
+}
+
+
+FrameCompressor::~FrameCompressor ()
+{
+    if (stream)
+    {
+        z_stream * const zs = static_cast<z_stream *>(stream);
+        deflateEnd (zs);
+        delete zs;
+    }
+}
+
+
+bool
+FrameCompressor::compress (std::vector<char> & out, char const * data,
+    std::size_t size)
+{
+    if (! stream)
+        return false;
+
+    z_stream * const zs = static_cast<z_stream *>(stream);
+    if (deflateReset (zs) != Z_OK)
+        return false;
+
+    out.resize (deflateBound (zs, static_cast<uLong>(size)));
+
+    zs->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    zs->avail_in = static_cast<uInt>(size);
+    zs->next_out = reinterpret_cast<Bytef *>(out.data ());
+    zs->avail_out = static_cast<uInt>(out.size ());
+
+    // The output buffer is sized by deflateBound(), so a single
+    // Z_FINISH pass always completes.
+    if (deflate (zs, Z_FINISH) != Z_STREAM_END)
+        return false;
+
+    out.resize (out.size () - zs->avail_out);
+    return true;
+}
+
+
+FrameDecompressor::FrameDecompressor ()
+    : stream (nullptr)
+{
+    z_stream * const zs = new z_stream ();
+    if (inflateInit (zs) != Z_OK)
+    {
+        delete zs;
+        return;
+    }
+
+    stream = zs;
+}
+
+
+FrameDecompressor::~FrameDecompressor ()
+{
+    if (stream)
+    {
+        z_stream * const zs = static_cast<z_stream *>(stream);
+        inflateEnd (zs);
+        delete zs;
+    }
+}
+
+
+bool
+FrameDecompressor::decompress (std::vector<char> & out, char const * data,
+    std::size_t size, std::size_t decompressed_size)
+{
+    if (! stream)
+        return false;
+
+    z_stream * const zs = static_cast<z_stream *>(stream);
+    if (inflateReset (zs) != Z_OK)
+        return false;
+
+    out.resize (decompressed_size);
+
+    zs->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    zs->avail_in = static_cast<uInt>(size);
+    zs->next_out = reinterpret_cast<Bytef *>(out.data ());
+    zs->avail_out = static_cast<uInt>(out.size ());
+
+    return inflate (zs, Z_FINISH) == Z_STREAM_END && zs->avail_out == 0;
+}
+
+
+} // namespace helpers
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_WITH_ZLIB
@@ -19,9 +19,11 @@
 // limitations under the License.
 
 #include <log4cplus/configurator.h>
+#include <log4cplus/fstreams.h>
 #include <log4cplus/hierarchylocker.h>
 #include <log4cplus/hierarchy.h>
 #include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/memorybudget.h>
 #include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/helpers/property.h>
 #include <log4cplus/helpers/timehelper.h>
@@ -46,10 +48,35 @@
 #include <tchar.h>
 #endif
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED) \
+    && defined (LOG4CPLUS_HAVE_SYS_INOTIFY_H) \
+    && defined (LOG4CPLUS_HAVE_POLL_H) \
+    && defined (LOG4CPLUS_HAVE_UNISTD_H) \
+    && defined (LOG4CPLUS_HAVE_FCNTL_H)
+#define LOG4CPLUS_USE_INOTIFY_WATCH 1
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#endif
+
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iterator>
+#include <memory>
 #include <sstream>
+#include <vector>
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#endif
 
 
 namespace log4cplus
@@ -58,6 +85,10 @@ namespace log4cplus
 
 void initializeLog4cplus();
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+void enqueueThreadPoolTask (std::function<void ()> task);
+#endif
+
 
 namespace
 {
@@ -201,6 +232,189 @@ namespace
         }
     }
 
+    //! Compares two property containers for equal keys and values.
+    static
+    bool
+    properties_equal (helpers::Properties const & lhs,
+        helpers::Properties const & rhs)
+    {
+        if (lhs.size () != rhs.size ())
+            return false;
+
+        for (tstring const & key : lhs.propertyNames ())
+        {
+            if (! rhs.exists (key)
+                || lhs.getProperty (key) != rhs.getProperty (key))
+                return false;
+        }
+
+        return true;
+    }
+
+
+    // Binary configuration cache sidecar. The sidecar stores the
+    // parsed key/value pairs of a configuration file, before
+    // environment variable substitution, together with the source
+    // file's mtime and size. Loading it replaces the text parse
+    // (including any `include` directives) with a few binary reads.
+    // The format is host local: raw tchar bytes in native byte
+    // order, guarded by the tchar width recorded in the header.
+
+    std::uint32_t const config_cache_version = 1;
+    char const config_cache_magic[8]
+        = { 'l', '4', 'c', 'p', 'c', 'f', 'g', 'c' };
+
+    struct ConfigCacheHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t tchar_size;
+        std::int64_t source_mtime_usec;
+        std::int64_t source_size;
+        std::uint64_t entry_count;
+    };
+
+
+    static
+    tstring
+    config_cache_name (tstring const & propertyFile)
+    {
+        return propertyFile + LOG4CPLUS_TEXT (".l4ccache");
+    }
+
+
+    static
+    bool
+    read_cached_string (std::istream & file, tstring & str)
+    {
+        // Cap the length so that a corrupted sidecar cannot drive a
+        // huge allocation; real configuration values are tiny.
+        std::uint32_t const max_length = 16 * 1024 * 1024;
+
+        std::uint32_t length = 0;
+        file.read (reinterpret_cast<char *>(&length), sizeof (length));
+        if (! file || length > max_length)
+            return false;
+
+        str.resize (length);
+        file.read (reinterpret_cast<char *>(&str[0]),
+            static_cast<std::streamsize>(length * sizeof (tchar)));
+        return ! file.fail ();
+    }
+
+
+    static
+    void
+    write_cached_string (std::ostream & file, tstring const & str)
+    {
+        std::uint32_t const length = static_cast<std::uint32_t>(str.size ());
+        file.write (reinterpret_cast<char const *>(&length), sizeof (length));
+        file.write (reinterpret_cast<char const *>(str.data ()),
+            static_cast<std::streamsize>(length * sizeof (tchar)));
+    }
+
+
+    static
+    bool
+    load_config_cache (tstring const & propertyFile,
+        helpers::Properties & props)
+    {
+        helpers::FileInfo fi;
+        if (helpers::getFileInfo (&fi, propertyFile) != 0)
+            return false;
+
+        std::ifstream file (
+            LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (
+                config_cache_name (propertyFile)).c_str (),
+            std::ios_base::binary);
+        if (! file)
+            return false;
+
+        ConfigCacheHeader header;
+        file.read (reinterpret_cast<char *>(&header), sizeof (header));
+        if (! file
+            || std::memcmp (header.magic, config_cache_magic,
+                sizeof (config_cache_magic)) != 0
+            || header.version != config_cache_version
+            || header.tchar_size != sizeof (tchar)
+            || header.source_mtime_usec
+                != fi.mtime.time_since_epoch ().count ()
+            || header.source_size != static_cast<std::int64_t>(fi.size))
+            return false;
+
+        helpers::Properties result;
+        tstring key;
+        tstring value;
+        for (std::uint64_t i = 0; i != header.entry_count; ++i)
+        {
+            if (! read_cached_string (file, key)
+                || ! read_cached_string (file, value))
+                return false;
+            result.setProperty (key, value);
+        }
+
+        props = std::move (result);
+        return true;
+    }
+
+
+    static
+    void
+    store_config_cache (tstring const & propertyFile,
+        helpers::Properties const & props)
+    {
+        helpers::FileInfo fi;
+        if (helpers::getFileInfo (&fi, propertyFile) != 0)
+            return;
+
+        // Best effort: a failed or torn write leaves a sidecar that
+        // fails validation on the next start and is rewritten then.
+        std::ofstream file (
+            LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (
+                config_cache_name (propertyFile)).c_str (),
+            std::ios_base::binary | std::ios_base::trunc);
+        if (! file)
+            return;
+
+        std::vector<tstring> const names (props.propertyNames ());
+
+        ConfigCacheHeader header;
+        std::memcpy (header.magic, config_cache_magic,
+            sizeof (config_cache_magic));
+        header.version = config_cache_version;
+        header.tchar_size = sizeof (tchar);
+        header.source_mtime_usec = fi.mtime.time_since_epoch ().count ();
+        header.source_size = static_cast<std::int64_t>(fi.size);
+        header.entry_count = names.size ();
+        file.write (reinterpret_cast<char const *>(&header),
+            sizeof (header));
+
+        for (tstring const & name : names)
+        {
+            write_cached_string (file, name);
+            write_cached_string (file, props.getProperty (name));
+        }
+    }
+
+
+    static
+    helpers::Properties
+    load_or_parse_properties (tstring const & propertyFile, unsigned flags)
+    {
+        if (! (flags & PropertyConfigurator::fUseConfigCache))
+            return helpers::Properties (propertyFile,
+                pcflag_to_pflags_encoding (flags));
+
+        helpers::Properties props;
+        if (load_config_cache (propertyFile, props))
+            return props;
+
+        props = helpers::Properties (propertyFile,
+            pcflag_to_pflags_encoding (flags));
+        store_config_cache (propertyFile, props);
+        return props;
+    }
+
 } // namespace
 
 
@@ -213,7 +427,7 @@ PropertyConfigurator::PropertyConfigurator(const tstring& propertyFile,
     Hierarchy& hier, unsigned f)
     : h(hier)
     , propertyFilename(propertyFile)
-    , properties(propertyFile, pcflag_to_pflags_encoding (f))
+    , properties(load_or_parse_properties (propertyFile, f))
     , flags (f)
 {
     init();
@@ -247,6 +461,10 @@ PropertyConfigurator::init()
 {
     replaceEnvironVariables();
     properties = properties.getPropertySubset( LOG4CPLUS_TEXT("log4cplus.") );
+    // The properties have changed; the compiled appender definitions
+    // no longer describe them.
+    compiledAppenderDefs.clear ();
+    compiledAppenderDefsValid = false;
 }
 
 
@@ -297,12 +515,70 @@ PropertyConfigurator::configure()
 
     setThreadPoolSize (thread_pool_size);
 
-    configureAppenders();
-    configureLoggers();
-    configureAdditivity();
+    unsigned int coarse_ts_granularity;
+    if (properties.getUInt (coarse_ts_granularity,
+            LOG4CPLUS_TEXT ("coarseTimestampGranularityMillis")))
+        helpers::setCoarseTimestampGranularity (
+            (std::min) (coarse_ts_granularity, 1000U));
+
+    unsigned int lt_offset_cache_secs;
+    if (properties.getUInt (lt_offset_cache_secs,
+            LOG4CPLUS_TEXT ("localTimeOffsetCacheSeconds")))
+        helpers::setLocalTimeOffsetCacheSeconds (
+            (std::min) (lt_offset_cache_secs, 3600U));
+
+    tstring memory_budget_str = helpers::toUpper (
+        properties.getProperty (LOG4CPLUS_TEXT ("memoryBudget")));
+    if (! memory_budget_str.empty ())
+    {
+        std::size_t multiplier = 1;
+        if (memory_budget_str.size () > 2)
+        {
+            tstring::size_type const len = memory_budget_str.length ();
+            if (memory_budget_str.compare (len - 2, 2,
+                    LOG4CPLUS_TEXT ("MB")) == 0)
+                multiplier = 1024 * 1024;
+            else if (memory_budget_str.compare (len - 2, 2,
+                    LOG4CPLUS_TEXT ("KB")) == 0)
+                multiplier = 1024;
+        }
 
-    if (disable_override)
-        h.disable (Hierarchy::DISABLE_OVERRIDE);
+        helpers::MemoryBudget::instance ().setLimit (
+            multiplier * std::atol (
+                LOG4CPLUS_TSTRING_TO_STRING (memory_budget_str).c_str ()));
+    }
+
+    tstring const & shed_below_str = properties.getProperty (
+        LOG4CPLUS_TEXT ("memoryBudgetShedBelowLevel"));
+    if (! shed_below_str.empty ())
+    {
+        LogLevel const shed_below
+            = getLogLevelManager ().fromString (shed_below_str);
+        if (shed_below != NOT_SET_LOG_LEVEL)
+            helpers::MemoryBudget::instance ().setShedBelowLevel (
+                shed_below);
+    }
+
+    unsigned int max_message_size;
+    if (properties.getUInt (max_message_size,
+            LOG4CPLUS_TEXT ("maxMessageSize")))
+        Logger::setDefaultMaxMessageSize (max_message_size);
+
+    {
+        // Batch the whole configure pass; the per logger
+        // setLogLevel() and setAdditivity() calls then trigger one
+        // threshold and appender chain rebuild at the end of the
+        // transaction instead of one rebuild per logger.
+        Hierarchy::ConfigurationTransaction transaction (h);
+
+        configureAppenders();
+        configureLoggers();
+        configureAdditivity();
+        configureMaxMessageSizes();
+
+        if (disable_override)
+            h.disable (Hierarchy::DISABLE_OVERRIDE);
+    }
 
 
 
@@ -338,6 +614,79 @@ PropertyConfigurator::reconfigure()
 }
 
 
+void
+PropertyConfigurator::reconfigureIncrementally()
+{
+    helpers::Properties const oldProperties (properties);
+    properties = helpers::Properties(propertyFilename,
+        pcflag_to_pflags_encoding (flags));
+    init();
+
+    // Nothing changed after variable expansion; leave the hierarchy
+    // completely untouched.
+    if (properties_equal (properties, oldProperties))
+        return;
+
+    // Gather the live appender instances of the applied configuration
+    // by name. configure() drops its references once done, so the
+    // loggers are the only place still holding them.
+    AppenderMap live;
+    Logger root = h.getRoot();
+    LoggerList loggers = h.getCurrentLoggers();
+    for (SharedAppenderPtr & appender : root.getAllAppenders())
+        live.emplace (appender->getName (), appender);
+    for (Logger & logger : loggers)
+        for (SharedAppenderPtr & appender : logger.getAllAppenders())
+            live.emplace (appender->getName (), appender);
+
+    // Retain instances whose definition is unchanged; they are handed
+    // to configureAppenders() pre-created so their streams and
+    // connections survive the reconfiguration.
+    appenders.clear ();
+    for (auto const & kv : live)
+    {
+        tstring const factoryKey
+            = LOG4CPLUS_TEXT("appender.") + kv.first;
+        tstring const subsetPrefix = factoryKey + LOG4CPLUS_TEXT(".");
+        if (properties.exists (factoryKey)
+            && properties.getProperty (factoryKey)
+                == oldProperties.getProperty (factoryKey)
+            && properties_equal (
+                properties.getPropertySubset (subsetPrefix),
+                oldProperties.getPropertySubset (subsetPrefix)))
+            appenders[kv.first] = kv.second;
+    }
+
+    // Detach all appenders and reset logger levels and additivity the
+    // way Hierarchy::resetConfiguration() does, but without closing
+    // the retained instances.
+    root.setLogLevel (DEBUG_LOG_LEVEL);
+    root.removeAllAppenders ();
+    for (Logger & logger : loggers)
+    {
+        logger.setLogLevel (NOT_SET_LOG_LEVEL);
+        logger.setAdditivity (true);
+        logger.setMaxMessageSize (0);
+        logger.removeAllAppenders ();
+    }
+    h.enableAll ();
+
+    // Close only the stale instances.
+    for (auto const & kv : live)
+    {
+        if (appenders.find (kv.first) != appenders.end ())
+            continue;
+
+        Appender & appender = *kv.second;
+        appender.waitToFinishAsyncLogging ();
+        if (! appender.isClosed ())
+            appender.close ();
+    }
+
+    configure();
+}
+
+
 void
 PropertyConfigurator::replaceEnvironVariables()
 {
@@ -452,17 +801,76 @@ PropertyConfigurator::configureLogger(Logger logger, const tstring& config)
 
 
 
+namespace
+{
+
+//! One appender definition to instantiate; the factory lookup has
+//! already succeeded. The properties are borrowed from the compiled
+//! definition, which outlives the work item.
+struct AppenderWorkItem
+{
+    tstring name;
+    spi::AppenderFactory * factory;
+    helpers::Properties const * props;
+    SharedAppenderPtr appender;
+};
+
+
+//! Instantiates one appender definition. Runs on a thread pool
+//! worker when several appenders are configured, hence no access to
+//! any configurator state.
+void
+createConfiguredAppender (AppenderWorkItem & item)
+{
+    try
+    {
+        SharedAppenderPtr appender
+            = item.factory->createObject(*item.props);
+        if (! appender)
+        {
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("PropertyConfigurator::")
+                LOG4CPLUS_TEXT("configureAppenders()")
+                LOG4CPLUS_TEXT("- Failed to create Appender: ")
+                + item.name);
+        }
+        else
+        {
+            appender->setName(item.name);
+            item.appender = appender;
+        }
+    }
+    catch(std::exception const & e)
+    {
+        helpers::getLogLog().error(
+            LOG4CPLUS_TEXT("PropertyConfigurator::")
+            LOG4CPLUS_TEXT("configureAppenders()")
+            LOG4CPLUS_TEXT("- Error while creating Appender: ")
+            + LOG4CPLUS_C_STR_TO_TSTRING(e.what()));
+    }
+}
+
+} // namespace
+
+
 void
 PropertyConfigurator::configureAppenders()
 {
-    helpers::Properties appenderProperties =
-        properties.getPropertySubset(LOG4CPLUS_TEXT("appender."));
-    std::vector<tstring> appendersProps = appenderProperties.propertyNames();
-    tstring factoryName;
-    for (tstring & appenderName : appendersProps)
+    if (! compiledAppenderDefsValid)
     {
-        if (appenderName.find (LOG4CPLUS_TEXT('.')) == tstring::npos)
+        // Resolve each definition's factory and extract its property
+        // subset once; later configure passes over the same
+        // properties reuse the compiled definitions directly.
+        helpers::Properties appenderProperties =
+            properties.getPropertySubset(LOG4CPLUS_TEXT("appender."));
+        std::vector<tstring> appendersProps
+            = appenderProperties.propertyNames();
+        tstring factoryName;
+        for (tstring & appenderName : appendersProps)
         {
+            if (appenderName.find (LOG4CPLUS_TEXT('.')) != tstring::npos)
+                continue;
+
             factoryName = appenderProperties.getProperty(appenderName);
             spi::AppenderFactory* factory
                 = spi::getAppenderFactoryRegistry().get(factoryName);
@@ -478,34 +886,70 @@ PropertyConfigurator::configureAppenders()
             helpers::Properties props_subset
                 = appenderProperties.getPropertySubset(appenderName
                 + LOG4CPLUS_TEXT("."));
-            try
-            {
-                SharedAppenderPtr appender
-                    = factory->createObject(props_subset);
-                if (! appender)
-                {
-                    helpers::getLogLog().error(
-                        LOG4CPLUS_TEXT("PropertyConfigurator::")
-                        LOG4CPLUS_TEXT("configureAppenders()")
-                        LOG4CPLUS_TEXT("- Failed to create Appender: ")
-                        + appenderName);
-                }
-                else
+            compiledAppenderDefs.push_back (CompiledAppenderDef {
+                std::move (appenderName), factory,
+                std::move (props_subset)});
+        }
+        compiledAppenderDefsValid = true;
+    }
+
+    std::vector<AppenderWorkItem> work;
+    for (CompiledAppenderDef const & def : compiledAppenderDefs)
+    {
+        // An instance retained by reconfigureIncrementally(); its
+        // definition has not changed, keep it as is.
+        if (appenders.find (def.name) != appenders.end ())
+            continue;
+
+        work.push_back (AppenderWorkItem {def.name, def.factory,
+            &def.props, SharedAppenderPtr ()});
+    }
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (work.size () > 1)
+    {
+        // Instantiate independent appenders concurrently so that one
+        // slow constructor - a FileAppender on slow storage, a
+        // SocketAppender resolving an unresponsive DNS entry - does
+        // not delay every appender configured after it.
+        std::atomic<std::size_t> remaining {work.size ()};
+        std::mutex mtx;
+        std::condition_variable cv;
+
+        for (AppenderWorkItem & item : work)
+        {
+            AppenderWorkItem * const item_ptr = &item;
+            enqueueThreadPoolTask (
+                [&, item_ptr] ()
                 {
-                    appender->setName(appenderName);
-                    appenders[std::move (appenderName)] = appender;
-                }
-            }
-            catch(std::exception const & e)
-            {
-                helpers::getLogLog().error(
-                    LOG4CPLUS_TEXT("PropertyConfigurator::")
-                    LOG4CPLUS_TEXT("configureAppenders()")
-                    LOG4CPLUS_TEXT("- Error while creating Appender: ")
-                    + LOG4CPLUS_C_STR_TO_TSTRING(e.what()));
-            }
+                    createConfiguredAppender (*item_ptr);
+                    if (remaining.fetch_sub (1, std::memory_order_acq_rel)
+                        == 1)
+                    {
+                        std::lock_guard<std::mutex> guard (mtx);
+                        cv.notify_all ();
+                    }
+                });
         }
-    } // end for loop
+
+        std::unique_lock<std::mutex> lock (mtx);
+        cv.wait (lock,
+            [&] {
+                return remaining.load (std::memory_order_acquire) == 0;
+            });
+    }
+    else
+#endif
+    {
+        for (AppenderWorkItem & item : work)
+            createConfiguredAppender (item);
+    }
+
+    for (AppenderWorkItem & item : work)
+    {
+        if (item.appender)
+            appenders[std::move (item.name)] = std::move (item.appender);
+    }
 }
 
 
@@ -527,6 +971,23 @@ PropertyConfigurator::configureAdditivity()
 }
 
 
+void
+PropertyConfigurator::configureMaxMessageSizes()
+{
+    helpers::Properties maxMessageSizeProperties =
+        properties.getPropertySubset(LOG4CPLUS_TEXT("maxMessageSize."));
+
+    for (tstring const & loggerName
+        : maxMessageSizeProperties.propertyNames())
+    {
+        Logger logger = getLogger(loggerName);
+        unsigned int limit;
+        if (maxMessageSizeProperties.getUInt (limit, loggerName))
+            logger.setMaxMessageSize (limit);
+    }
+}
+
+
 
 Logger
 PropertyConfigurator::getLogger(const tstring& name)
@@ -582,6 +1043,181 @@ BasicConfigurator::doConfigure(Hierarchy& h, bool logToStdErr)
 
 #if !defined(LOG4CPLUS_SINGLE_THREADED)
 
+#if defined (LOG4CPLUS_USE_INOTIFY_WATCH)
+
+namespace
+{
+
+//! Kernel change notification backend for
+//! ConfigurationWatchDogThread. The watch is placed on the directory
+//! containing the configuration file so that the write-then-rename
+//! pattern used by most configuration management tools is caught as
+//! well as in-place edits. A self pipe lets terminate() interrupt a
+//! pending wait immediately.
+class ConfigurationFileWatcher
+{
+public:
+    explicit ConfigurationFileWatcher (tstring const & file);
+    ~ConfigurationFileWatcher ();
+
+    //! Returns true when the kernel watch could be established. When
+    //! it could not, the caller should fall back to periodic polling.
+    bool good () const { return inotify_fd != -1; }
+
+    //! Blocks until the watched directory changes, interrupt() is
+    //! called or <code>millis</code> milliseconds elapse.
+    void wait (unsigned int millis);
+
+    //! Wakes up a pending wait().
+    void interrupt ();
+
+private:
+    ConfigurationFileWatcher (ConfigurationFileWatcher const &) = delete;
+    ConfigurationFileWatcher & operator = (
+        ConfigurationFileWatcher const &) = delete;
+
+    int inotify_fd = -1;
+    int wake_pipe[2] {-1, -1};
+};
+
+
+ConfigurationFileWatcher::ConfigurationFileWatcher (tstring const & file)
+{
+    if (pipe (wake_pipe) != 0)
+    {
+        wake_pipe[0] = wake_pipe[1] = -1;
+        return;
+    }
+
+    // Both ends non-blocking so that wait() can drain without
+    // stalling and interrupt() never blocks on a full pipe.
+    fcntl (wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl (wake_pipe[1], F_SETFL, O_NONBLOCK);
+
+    inotify_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd == -1)
+        return;
+
+    std::string const path (LOG4CPLUS_TSTRING_TO_STRING (file));
+    std::string::size_type const slash = path.rfind ('/');
+    std::string const dir (slash == std::string::npos
+        ? std::string (1, '.')
+        : path.substr (0, (std::max) (slash,
+            static_cast<std::string::size_type>(1))));
+
+    if (inotify_add_watch (inotify_fd, dir.c_str (),
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE
+            | IN_DELETE | IN_ATTRIB | IN_MODIFY) == -1)
+    {
+        close (inotify_fd);
+        inotify_fd = -1;
+    }
+}
+
+
+ConfigurationFileWatcher::~ConfigurationFileWatcher ()
+{
+    if (inotify_fd != -1)
+        close (inotify_fd);
+    if (wake_pipe[0] != -1)
+    {
+        close (wake_pipe[0]);
+        close (wake_pipe[1]);
+    }
+}
+
+
+void
+ConfigurationFileWatcher::wait (unsigned int millis)
+{
+    pollfd fds[2];
+    fds[0].fd = inotify_fd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = wake_pipe[0];
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+
+    int ret;
+    do
+    {
+        ret = poll (fds, 2, static_cast<int>(millis));
+    }
+    while (ret == -1 && errno == EINTR);
+
+    if (ret <= 0)
+        return;
+
+    // Drain whatever woke us up; the caller re-checks the file
+    // itself, the event payload is irrelevant.
+    char buf[4096];
+    if ((fds[0].revents & POLLIN) != 0)
+        while (read (inotify_fd, buf, sizeof (buf)) > 0)
+            continue;
+    if ((fds[1].revents & POLLIN) != 0)
+        while (read (wake_pipe[0], buf, sizeof (buf)) > 0)
+            continue;
+}
+
+
+void
+ConfigurationFileWatcher::interrupt ()
+{
+    char const ch = 'I';
+    int ret;
+
+    do
+    {
+        ret = static_cast<int>(write (wake_pipe[1], &ch, 1));
+    }
+    while (ret == -1 && errno == EINTR);
+}
+
+} // namespace
+
+#endif // LOG4CPLUS_USE_INOTIFY_WATCH
+
+
+namespace
+{
+
+//! FNV-1a hash of the configuration file's bytes. Cheap enough to
+//! run on every metadata change and collision-safe enough to tell a
+//! byte-identical rewrite from a real edit. Returns false when the
+//! file cannot be read.
+static
+bool
+config_file_digest (tstring const & file, std::uint64_t & digest)
+{
+    std::ifstream in (LOG4CPLUS_TSTRING_TO_STRING (file).c_str (),
+        std::ios_base::binary);
+    if (! in.good ())
+        return false;
+
+    std::uint64_t d = 14695981039346656037ULL;
+    char buf[4096];
+    do
+    {
+        in.read (buf, sizeof (buf));
+        std::streamsize const count = in.gcount ();
+        for (std::streamsize i = 0; i != count; ++i)
+        {
+            d ^= static_cast<unsigned char>(buf[i]);
+            d *= 1099511628211ULL;
+        }
+    }
+    while (in.good ());
+
+    if (in.bad ())
+        return false;
+
+    digest = d;
+    return true;
+}
+
+} // namespace
+
+
 //////////////////////////////////////////////////////////////////////////////
 // ConfigurationWatchDogThread implementation
 //////////////////////////////////////////////////////////////////////////////
@@ -602,6 +1238,16 @@ public:
         lastFileInfo.is_link = false;
 
         updateLastModInfo();
+        lastDigestValid
+            = config_file_digest (propertyFilename, lastDigest);
+
+#if defined (LOG4CPLUS_USE_INOTIFY_WATCH)
+        watcher.reset (new ConfigurationFileWatcher (file));
+        if (! watcher->good ())
+            // Could not establish the kernel watch; fall back to
+            // periodic polling.
+            watcher.reset ();
+#endif
     }
 
     ~ConfigurationWatchDogThread () override = default;
@@ -609,6 +1255,10 @@ public:
     void terminate ()
     {
         shouldTerminate.signal ();
+#if defined (LOG4CPLUS_USE_INOTIFY_WATCH)
+        if (watcher)
+            watcher->interrupt ();
+#endif
         join ();
     }
 
@@ -617,6 +1267,7 @@ protected:
     Logger getLogger(const tstring& name) override;
     void addAppender(Logger &logger, SharedAppenderPtr& appender) override;
 
+    void checkAndReconfigure();
     bool checkForFileModification();
     void updateLastModInfo();
 
@@ -628,29 +1279,61 @@ private:
     unsigned int const waitMillis;
     thread::ManualResetEvent shouldTerminate;
     helpers::FileInfo lastFileInfo;
+
+    //! Content hash of the last applied configuration file; filters
+    //! out touch and byte-identical rewrites that change the metadata
+    //! without changing the content.
+    std::uint64_t lastDigest = 0;
+    bool lastDigestValid = false;
+
     HierarchyLocker* lock;
+#if defined (LOG4CPLUS_USE_INOTIFY_WATCH)
+    std::unique_ptr<ConfigurationFileWatcher> watcher;
+#endif
 };
 
 
 void
 ConfigurationWatchDogThread::run()
 {
-    while (! shouldTerminate.timed_wait (waitMillis))
+#if defined (LOG4CPLUS_USE_INOTIFY_WATCH)
+    if (watcher)
     {
-        bool modified = checkForFileModification();
-        if(modified) {
-            // Lock the Hierarchy
-            HierarchyLocker theLock(h);
-            lock = &theLock;
+        // With a kernel watch in place there are no periodic wake
+        // ups; the thread blocks until the directory changes and the
+        // interval only bounds how long a missed event could go
+        // unnoticed.
+        while (! shouldTerminate.timed_wait (0))
+        {
+            watcher->wait (waitMillis);
+            checkAndReconfigure ();
+        }
+        return;
+    }
+#endif
 
-            // reconfigure the Hierarchy
-            theLock.resetConfiguration();
-            reconfigure();
-            updateLastModInfo();
+    while (! shouldTerminate.timed_wait (waitMillis))
+        checkAndReconfigure ();
+}
 
-            // release the lock
-            lock = nullptr;
-        }
+
+void
+ConfigurationWatchDogThread::checkAndReconfigure()
+{
+    bool modified = checkForFileModification();
+    if(modified) {
+        // Lock the Hierarchy
+        HierarchyLocker theLock(h);
+        lock = &theLock;
+
+        // Reconfigure the Hierarchy, retaining appenders whose
+        // definitions did not change so that their streams and
+        // connections stay open across the configuration push.
+        reconfigureIncrementally();
+        updateLastModInfo();
+
+        // release the lock
+        lock = nullptr;
     }
 }
 
@@ -700,6 +1383,25 @@ ConfigurationWatchDogThread::checkForFileModification()
     }
 #endif
 
+    if (modified)
+    {
+        // The metadata changed, but a touch or a byte-identical rewrite
+        // (e.g. a configuration management tool re-depositing the same
+        // file) does not warrant a reconfiguration. Hash the content
+        // and skip the reload when it matches the last applied digest.
+        std::uint64_t digest;
+        bool const digest_ok
+            = config_file_digest (propertyFilename, digest);
+        if (digest_ok && lastDigestValid && digest == lastDigest)
+        {
+            lastFileInfo = fi;
+            return false;
+        }
+
+        lastDigest = digest;
+        lastDigestValid = digest_ok;
+    }
+
     return modified;
 }
 
@@ -24,6 +24,10 @@
 #include <log4cplus/helpers/connectorthread.h>
 #include <log4cplus/helpers/loglog.h>
 
+#include <algorithm>
+#include <chrono>
+#include <random>
+
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 
@@ -32,13 +36,19 @@ namespace log4cplus::helpers {
 
 IConnectorThreadClient::~IConnectorThreadClient () = default;
 
+
+void
+IConnectorThreadClient::ctcHeartbeat ()
+{ }
+
 //
 //
 //
 
 ConnectorThread::ConnectorThread (
-    IConnectorThreadClient & client)
+    IConnectorThreadClient & client, unsigned wait_millis_)
     : ctc (client)
+    , wait_millis (wait_millis_)
     , exit_flag (false)
 { }
 
@@ -51,7 +61,7 @@ ConnectorThread::run ()
 {
     while (true)
     {
-        trigger_ev.timed_wait (30 * 1000);
+        trigger_ev.timed_wait (wait_millis);
 
         helpers::getLogLog().debug (
             LOG4CPLUS_TEXT("ConnectorThread::run()- running..."));
@@ -65,40 +75,86 @@ ConnectorThread::run ()
             trigger_ev.reset ();
         }
 
+        // Keep the DNS cache warm while we are awake anyway, so that
+        // a later reconnect does not wait on a resolver.
+        helpers::refreshStaleAddresses ();
+
         // Do not try to re-open already open socket.
 
         helpers::Socket & client_socket = ctc.ctcGetSocket ();
         thread::Mutex const & client_access_mutex = ctc.ctcGetAccessMutex ();
+        bool socket_open;
         {
             thread::MutexGuard guard (client_access_mutex);
-            if (client_socket.isOpen ())
-                continue;
+            socket_open = client_socket.isOpen ();
         }
 
-        // The socket is not open, try to reconnect.
+        if (socket_open)
+        {
+            // Probe the open connection so that a dead peer is
+            // noticed within one wait interval instead of by a
+            // blocked write on the logging path. The client may
+            // trigger() us again when the probe fails.
+            ctc.ctcHeartbeat ();
+            continue;
+        }
+
+        // The socket is not open, try to reconnect. Failed attempts
+        // back off exponentially with jitter so that many instances
+        // losing the same server do not hammer it in lockstep when it
+        // comes back.
 
-        helpers::Socket new_socket (ctc.ctcConnect ());
-        if (! new_socket.isOpen ())
+        unsigned backoff_millis = 0;
+        while (true)
         {
+            helpers::Socket new_socket (ctc.ctcConnect ());
+            if (new_socket.isOpen ())
+            {
+                // Connection was successful, move the socket into
+                // client.
+                thread::MutexGuard guard (client_access_mutex);
+                client_socket = std::move (new_socket);
+                ctc.ctcSetConnected ();
+                break;
+            }
+
             helpers::getLogLog().error(
                 LOG4CPLUS_TEXT("ConnectorThread::run()")
                 LOG4CPLUS_TEXT("- Cannot connect to server"));
 
-            // Sleep for a short while after unsuccessful connection attempt
-            // so that we do not try to reconnect after each logging attempt
-            // which could be many times per second.
-            std::this_thread::sleep_for (std::chrono::seconds (5));
-
-            continue;
+            backoff_millis = backoff_millis == 0
+                ? 1000 : (std::min) (backoff_millis * 2, 60u * 1000);
+            std::uniform_int_distribution<unsigned> jitter (
+                backoff_millis / 2, backoff_millis);
+            if (! backoffWait (jitter (backoff_rng)))
+                return;
         }
+    }
+}
 
-        // Connection was successful, move the socket into client.
 
-        {
-            thread::MutexGuard guard (client_access_mutex);
-            client_socket = std::move (new_socket);
-            ctc.ctcSetConnected ();
-        }
+bool
+ConnectorThread::backoffWait (unsigned millis)
+{
+    // Unlike the periodic wait at the top of run(), this wait is not
+    // cut short by trigger(); logging attempts may signal many times
+    // per second and would otherwise void the backoff.
+    auto const deadline = std::chrono::steady_clock::now ()
+        + std::chrono::milliseconds (millis);
+    while (true)
+    {
+        auto const now = std::chrono::steady_clock::now ();
+        if (now >= deadline)
+            return true;
+
+        trigger_ev.timed_wait (static_cast<unsigned long>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - now).count ()));
+
+        thread::MutexGuard guard (access_mutex);
+        if (exit_flag)
+            return false;
+        trigger_ev.reset ();
     }
 }
 
@@ -26,6 +26,9 @@
 #include <log4cplus/helpers/property.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <log4cplus/internal/internal.h>
+#include <algorithm>
+#include <iostream>
 #include <ostream>
 
 
@@ -48,6 +51,64 @@ ConsoleAppender::getOutputMutex ()
 }
 
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+//! Flushes the console stream off the logging threads on the same
+//! adaptive timer as FileAppenderBase::FlusherThread: the interval
+//! shortens while events arrive in bursts and backs off to the
+//! configured value when the appender is idle.
+class ConsoleAppender::FlusherThread
+    : public thread::AbstractThread
+{
+public:
+    explicit FlusherThread (
+        helpers::SharedObjectPtr<ConsoleAppender> appender_)
+        : appender (std::move (appender_))
+    { }
+
+    void run() override
+    {
+        // Number of events per interval considered a burst.
+        unsigned long const burst_threshold = 64;
+        unsigned long const max_interval
+            = appender->asyncFlushIntervalMillis;
+        unsigned long const min_interval
+            = (std::max) (1ul, max_interval / 8);
+        unsigned long interval = max_interval;
+
+        while (true)
+        {
+            appender->flusher_wakeup.timed_wait (interval);
+            if (appender->flusher_exit.load (std::memory_order_acquire))
+                break;
+
+            unsigned long const pending
+                = appender->appends_since_flush.exchange (0,
+                    std::memory_order_relaxed);
+            if (pending != 0)
+            {
+                thread::MutexGuard guard (getOutputMutex ());
+                if (appender->utf8Output)
+                    (appender->logToStdErr
+                        ? std::cerr : std::cout).flush ();
+                else
+                    (appender->logToStdErr ? tcerr : tcout).flush ();
+            }
+
+            if (pending >= burst_threshold)
+                interval = (std::max) (min_interval, interval / 2);
+            else if (pending == 0)
+                interval = (std::min) (max_interval, interval * 2);
+        }
+    }
+
+private:
+    helpers::SharedObjectPtr<ConsoleAppender> appender;
+};
+
+#endif
+
+
 //////////////////////////////////////////////////////////////////////////////
 // ConsoleAppender ctors and dtor
 //////////////////////////////////////////////////////////////////////////////
@@ -68,9 +129,50 @@ ConsoleAppender::ConsoleAppender(const helpers::Properties & properties)
 {
     properties.getBool (logToStdErr, LOG4CPLUS_TEXT("logToStdErr"));
     properties.getBool (immediateFlush, LOG4CPLUS_TEXT("ImmediateFlush"));
+
+    tstring const & encoding
+        = properties.getProperty (LOG4CPLUS_TEXT("OutputEncoding"));
+    if (! encoding.empty ())
+    {
+        tstring const enc = helpers::toLower (encoding);
+        if (enc == LOG4CPLUS_TEXT("utf-8") || enc == LOG4CPLUS_TEXT("utf8"))
+            utf8Output = true;
+        else if (enc != LOG4CPLUS_TEXT("locale"))
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT("Unsupported OutputEncoding value: ")
+                + encoding);
+    }
+    properties.getULong (asyncFlushIntervalMillis,
+        LOG4CPLUS_TEXT("AsyncFlushIntervalMillis"));
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (asyncFlushIntervalMillis != 0)
+        initFlusher ();
+#endif
 }
 
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+void
+ConsoleAppender::initFlusher ()
+{
+    if (immediateFlush)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("AsyncFlushIntervalMillis is ignored")
+            LOG4CPLUS_TEXT (" because ImmediateFlush is in effect."));
+        return;
+    }
+
+    flusher_thread = new FlusherThread (
+        helpers::SharedObjectPtr<ConsoleAppender> (this));
+    flusher_thread->start ();
+}
+
+#endif
+
+
 
 ConsoleAppender::~ConsoleAppender()
 {
@@ -88,6 +190,20 @@ ConsoleAppender::close()
 {
     helpers::getLogLog().debug(
         LOG4CPLUS_TEXT("Entering ConsoleAppender::close().."));
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // Stop the flusher thread first; it takes the console output
+    // mutex for each flush.
+    if (flusher_thread)
+    {
+        flusher_exit.store (true, std::memory_order_release);
+        flusher_wakeup.signal ();
+        if (flusher_thread->isRunning ())
+            flusher_thread->join ();
+        flusher_thread = nullptr;
+    }
+#endif
+
     closed = true;
 }
 
@@ -100,6 +216,30 @@ ConsoleAppender::close()
 void
 ConsoleAppender::append(const spi::InternalLoggingEvent& event)
 {
+    if (utf8Output)
+    {
+        // Format and convert outside the console lock so that only
+        // the byte write is serialized between appenders.
+        internal::appender_sratch_pad & appender_sp
+            = internal::get_appender_sp ();
+        detail::clear_tostringstream (appender_sp.oss);
+        layout->formatAndAppend (appender_sp.oss, event);
+        appender_sp.chstr
+            = LOG4CPLUS_TSTRING_TO_STRING (appender_sp.oss.str ());
+
+        thread::MutexGuard guard (getOutputMutex ());
+        std::ostream & output = (logToStdErr ? std::cerr : std::cout);
+        output.write (appender_sp.chstr.data (),
+            static_cast<std::streamsize>(appender_sp.chstr.size ()));
+        if (immediateFlush)
+            output.flush ();
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        else if (flusher_thread)
+            appends_since_flush.fetch_add (1, std::memory_order_relaxed);
+#endif
+        return;
+    }
+
     thread::MutexGuard guard (getOutputMutex ());
 
     tostream& output = (logToStdErr ? tcerr : tcout);
@@ -107,6 +247,10 @@ ConsoleAppender::append(const spi::InternalLoggingEvent& event)
     if(immediateFlush) {
         output.flush();
     }
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    else if (flusher_thread)
+        appends_since_flush.fetch_add (1, std::memory_order_relaxed);
+#endif
 }
 
 
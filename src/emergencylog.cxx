@@ -0,0 +1,276 @@
+//  Copyright (C) 2009-2017, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/emergencylog.h>
+#include <log4cplus/helpers/timehelper.h>
+#include <log4cplus/spi/loggingevent.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#if defined (_WIN32)
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#if defined (LOG4CPLUS_HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#endif
+#endif
+
+
+namespace log4cplus
+{
+
+namespace
+{
+
+
+std::size_t const slot_count = 128;
+std::size_t const slot_text_size = 232;
+
+
+//! One pre-allocated ring entry. The sequence number doubles as the
+//! slot's state: a writer that claimed ticket t stores 2t+1 before
+//! filling the slot and 2t+2 when done, so readers can tell an entry
+//! that is complete from one that is mid-write or has been claimed
+//! again after the ring wrapped.
+struct emergency_slot
+{
+    std::atomic<std::uint64_t> seq {0};
+    LogLevel level;
+    std::time_t timestamp;
+    std::size_t text_len;
+    char text[slot_text_size];
+};
+
+
+//! The ring and its ticket counter live in static storage so that no
+//! allocation is ever needed; initializeEmergencyLog() locks them
+//! into memory so that a crashing process does not page fault while
+//! recording.
+emergency_slot emergency_ring[slot_count];
+std::atomic<std::uint64_t> emergency_head {0};
+
+//! Next ticket emergency_log_drain() has not delivered yet. Only
+//! drain, which is not async-signal-safe anyway, moves it.
+std::atomic<std::uint64_t> emergency_read_cursor {0};
+
+
+//! Async-signal-safe log level name; the LogLevelManager is off
+//! limits here because it can run user registered callbacks.
+char const *
+emergency_level_name (LogLevel ll)
+{
+    if (ll >= FATAL_LOG_LEVEL)
+        return "FATAL";
+    else if (ll >= ERROR_LOG_LEVEL)
+        return "ERROR";
+    else if (ll >= WARN_LOG_LEVEL)
+        return "WARN";
+    else if (ll >= INFO_LOG_LEVEL)
+        return "INFO";
+    else if (ll >= DEBUG_LOG_LEVEL)
+        return "DEBUG";
+    else
+        return "TRACE";
+}
+
+
+//! Copies the completed entry for \c ticket into \c slot_copy. The
+//! seqlock style re-check of the sequence number after the copy
+//! rejects entries that were being overwritten while we read them.
+bool
+read_slot (std::uint64_t ticket, emergency_slot & slot_copy)
+{
+    emergency_slot & slot = emergency_ring[ticket % slot_count];
+    if (slot.seq.load (std::memory_order_acquire) != 2 * ticket + 2)
+        return false;
+
+    slot_copy.level = slot.level;
+    slot_copy.timestamp = slot.timestamp;
+    slot_copy.text_len = slot.text_len;
+    if (slot_copy.text_len > slot_text_size)
+        return false;
+
+    std::memcpy (slot_copy.text, slot.text, slot_copy.text_len);
+    return slot.seq.load (std::memory_order_acquire) == 2 * ticket + 2;
+}
+
+
+//! write() wrapper that tolerates short writes and EINTR; raw system
+//! calls only, this runs inside crash handlers.
+void
+emergency_write (int fd, char const * buf, std::size_t size)
+{
+    while (size != 0)
+    {
+#if defined (_WIN32)
+        int const ret = _write (fd, buf, static_cast<unsigned>(size));
+#else
+        ssize_t const ret = ::write (fd, buf, size);
+#endif
+        if (ret <= 0)
+        {
+#if ! defined (_WIN32)
+            if (ret == -1 && errno == EINTR)
+                continue;
+#endif
+            return;
+        }
+
+        buf += ret;
+        size -= static_cast<std::size_t>(ret);
+    }
+}
+
+
+//! Renders \c value into \c buf backwards; returns the length. Used
+//! instead of snprintf, which is not async-signal-safe.
+std::size_t
+format_unsigned (std::uint64_t value, char (& buf)[24])
+{
+    std::size_t pos = sizeof (buf);
+    do
+    {
+        buf[--pos] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    std::memmove (buf, buf + pos, sizeof (buf) - pos);
+    return sizeof (buf) - pos;
+}
+
+
+} // namespace
+
+
+//! Called from initializeLog4cplus(). Touches and locks the ring
+//! into memory so that emergency_log() cannot page fault at crash
+//! time.
+void
+initializeEmergencyLog ()
+{
+#if defined (_WIN32)
+    VirtualLock (emergency_ring, sizeof (emergency_ring));
+#elif defined (LOG4CPLUS_HAVE_SYS_MMAN_H)
+    // Failure, e.g. due to RLIMIT_MEMLOCK, is not fatal; the ring
+    // still works, it just may fault on first touch.
+    mlock (emergency_ring, sizeof (emergency_ring));
+#endif
+}
+
+
+void
+emergency_log (LogLevel ll, char const * msg) LOG4CPLUS_NOEXCEPT
+{
+    std::uint64_t const ticket
+        = emergency_head.fetch_add (1, std::memory_order_relaxed);
+    emergency_slot & slot = emergency_ring[ticket % slot_count];
+
+    slot.seq.store (2 * ticket + 1, std::memory_order_release);
+    slot.level = ll;
+    slot.timestamp = std::time (nullptr);
+
+    // strlen() capped at the slot size without reading past short
+    // strings' terminators.
+    std::size_t len = 0;
+    while (len != slot_text_size && msg[len] != '\0')
+        ++len;
+    slot.text_len = len;
+    std::memcpy (slot.text, msg, len);
+
+    slot.seq.store (2 * ticket + 2, std::memory_order_release);
+}
+
+
+std::size_t
+emergency_log_dump (int fd) LOG4CPLUS_NOEXCEPT
+{
+    std::uint64_t const end
+        = emergency_head.load (std::memory_order_acquire);
+    std::uint64_t ticket = end > slot_count ? end - slot_count : 0;
+
+    std::size_t written = 0;
+    for (; ticket != end; ++ticket)
+    {
+        emergency_slot slot_copy;
+        if (! read_slot (ticket, slot_copy))
+            continue;
+
+        char number[24];
+        emergency_write (fd, number,
+            format_unsigned (
+                static_cast<std::uint64_t>(slot_copy.timestamp), number));
+        emergency_write (fd, " ", 1);
+
+        char const * const level = emergency_level_name (slot_copy.level);
+        emergency_write (fd, level, std::strlen (level));
+        emergency_write (fd, " ", 1);
+
+        emergency_write (fd, slot_copy.text, slot_copy.text_len);
+        emergency_write (fd, "\n", 1);
+        ++written;
+    }
+
+    return written;
+}
+
+
+std::size_t
+emergency_log_drain (Logger logger)
+{
+    std::uint64_t const end
+        = emergency_head.load (std::memory_order_acquire);
+    std::uint64_t ticket
+        = emergency_read_cursor.load (std::memory_order_relaxed);
+    if (end > slot_count && ticket < end - slot_count)
+        ticket = end - slot_count;
+
+    std::size_t delivered = 0;
+    for (; ticket != end; ++ticket)
+    {
+        emergency_slot slot_copy;
+        if (! read_slot (ticket, slot_copy))
+            continue;
+
+        std::string const narrow (slot_copy.text, slot_copy.text_len);
+        spi::InternalLoggingEvent ev (logger.getName (), slot_copy.level,
+            tstring_view (), MappedDiagnosticContextMap (),
+            LOG4CPLUS_STRING_TO_TSTRING (narrow), tstring_view (),
+            tstring_view (),
+            helpers::from_time_t (slot_copy.timestamp),
+            tstring_view (), -1);
+        logger.forcedLog (ev);
+        ++delivered;
+    }
+
+    emergency_read_cursor.store (end, std::memory_order_relaxed);
+    return delivered;
+}
+
+
+} // namespace log4cplus
@@ -47,6 +47,10 @@
 #include <direct.h>
 #endif
 
+#ifdef LOG4CPLUS_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
@@ -669,4 +673,56 @@ make_dirs (tstring const & file_path)
 }
 
 
+bool
+lock_memory (void * addr, std::size_t size)
+{
+    if (size == 0 || size > max_lockable_memory)
+        return false;
+
+    // Touch one byte per page so that the locking call does not have
+    // to fault the whole region in one by one under memory pressure.
+    // The pages are only read, not written, because the region may
+    // already hold live objects.
+
+    std::size_t const page_size = 4096;
+    volatile char const * const bytes
+        = static_cast<volatile char const *>(addr);
+    char sink = 0;
+    for (std::size_t offset = 0; offset < size; offset += page_size)
+        sink ^= bytes[offset];
+    sink ^= bytes[size - 1];
+    static_cast<void>(sink);
+
+#if defined (_WIN32)
+    return VirtualLock (addr, size) != 0;
+
+#elif defined (LOG4CPLUS_HAVE_SYS_MMAN_H)
+    return mlock (addr, size) == 0;
+
+#else
+    return false;
+
+#endif
+}
+
+
+void
+unlock_memory (void * addr, std::size_t size)
+{
+    if (size == 0)
+        return;
+
+#if defined (_WIN32)
+    VirtualUnlock (addr, size);
+
+#elif defined (LOG4CPLUS_HAVE_SYS_MMAN_H)
+    munlock (addr, size);
+
+#else
+    static_cast<void>(addr);
+
+#endif
+}
+
+
 } // namespace log4cplus::internal
@@ -0,0 +1,250 @@
+//  Copyright (C) 2009-2017, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/helpers/eventspill.h>
+
+#ifndef LOG4CPLUS_SINGLE_THREADED
+
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/socketbuffer.h>
+#include <log4cplus/socketappender.h>
+#include <log4cplus/fstreams.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+
+namespace log4cplus { namespace helpers {
+
+
+namespace
+{
+
+//! Each record is its payload size followed by the
+//! convertToBuffer() serialization of one event.
+std::size_t const record_header_size = sizeof (std::uint32_t);
+
+} // namespace
+
+
+EventSpill::EventSpill (tstring const & path_, std::size_t max_bytes_)
+    : path (path_)
+    // At least one maximally sized record must fit within the bound.
+    , max_bytes ((std::max) (max_bytes_,
+        record_header_size + LOG4CPLUS_MAX_MESSAGE_SIZE))
+    , read_offset (0)
+    , write_size (0)
+{
+    // Truncate any stale spill left over from a previous run; replay
+    // does not span process restarts.
+    file.open (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (path).c_str (),
+        std::ios_base::in | std::ios_base::out | std::ios_base::trunc
+        | std::ios_base::binary);
+    if (! file.good ())
+        getLogLog ().error (
+            LOG4CPLUS_TEXT ("EventSpill: could not open spill file ")
+            + path);
+}
+
+
+EventSpill::~EventSpill ()
+{
+    bool const remove_file = file.is_open () && empty ();
+    file.close ();
+    if (remove_file)
+        std::remove (LOG4CPLUS_TSTRING_TO_STRING (path).c_str ());
+}
+
+
+bool
+EventSpill::is_open () const
+{
+    return file.is_open ();
+}
+
+
+std::size_t
+EventSpill::write (spi::InternalLoggingEvent const * events,
+    std::size_t count)
+{
+    if (! file.is_open ())
+        return count;
+
+    io_buf.clear ();
+    SocketBuffer buffer (LOG4CPLUS_MAX_MESSAGE_SIZE);
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        buffer.reserve (LOG4CPLUS_MAX_MESSAGE_SIZE);
+        convertToBuffer (buffer, events[i], tstring ());
+
+        std::uint32_t const len
+            = static_cast<std::uint32_t>(buffer.getSize ());
+        std::size_t const pos = io_buf.size ();
+        io_buf.resize (pos + record_header_size + len);
+        std::memcpy (&io_buf[pos], &len, record_header_size);
+        std::memcpy (&io_buf[pos + record_header_size],
+            buffer.getBuffer (), len);
+    }
+
+    // Evict the oldest pending records until the batch fits within
+    // the bound. A batch larger than the whole bound is still written;
+    // the overshoot is bounded by the batch size.
+    std::size_t discarded = 0;
+    while (! empty ()
+        && pending_bytes () + io_buf.size () > max_bytes)
+    {
+        if (! drop_oldest_record ())
+        {
+            truncate ();
+            break;
+        }
+        ++discarded;
+    }
+
+    file.clear ();
+    file.seekp (static_cast<std::streamoff>(write_size));
+    file.write (io_buf.data (),
+        static_cast<std::streamsize>(io_buf.size ()));
+    file.flush ();
+    if (! file.good ())
+    {
+        getLogLog ().error (
+            LOG4CPLUS_TEXT ("EventSpill: write to spill file failed: ")
+            + path);
+        file.clear ();
+        return discarded + count;
+    }
+
+    write_size += io_buf.size ();
+    return discarded;
+}
+
+
+std::size_t
+EventSpill::read (std::vector<spi::InternalLoggingEvent> & out,
+    std::size_t max_events)
+{
+    if (! file.is_open () || empty ())
+        return 0;
+
+    file.clear ();
+    file.seekg (static_cast<std::streamoff>(read_offset));
+
+    std::size_t read_count = 0;
+    while (read_count != max_events && read_offset != write_size)
+    {
+        std::uint32_t len = 0;
+        file.read (reinterpret_cast<char *>(&len), record_header_size);
+        if (file.good ()
+            && record_header_size + len <= pending_bytes ())
+        {
+            io_buf.resize (len);
+            file.read (io_buf.data (), static_cast<std::streamsize>(len));
+        }
+        if (! file.good ()
+            || record_header_size + len > pending_bytes ())
+        {
+            // A short or damaged record; nothing after it can be
+            // trusted either, give the remainder up.
+            getLogLog ().error (
+                LOG4CPLUS_TEXT ("EventSpill: damaged spill file: ")
+                + path);
+            truncate ();
+            break;
+        }
+
+        SocketBuffer buffer (io_buf.data (), len);
+        out.push_back (readFromBuffer (buffer));
+        read_offset += record_header_size + len;
+        ++read_count;
+    }
+
+    if (empty ())
+        truncate ();
+    else if (read_offset > max_bytes)
+        compact ();
+
+    return read_count;
+}
+
+
+bool
+EventSpill::drop_oldest_record ()
+{
+    file.clear ();
+    file.seekg (static_cast<std::streamoff>(read_offset));
+
+    std::uint32_t len = 0;
+    file.read (reinterpret_cast<char *>(&len), record_header_size);
+    if (! file.good ()
+        || record_header_size + len > pending_bytes ())
+        return false;
+
+    read_offset += record_header_size + len;
+    return true;
+}
+
+
+void
+EventSpill::compact ()
+{
+    std::vector<char> pending (pending_bytes ());
+
+    file.clear ();
+    file.seekg (static_cast<std::streamoff>(read_offset));
+    file.read (pending.data (),
+        static_cast<std::streamsize>(pending.size ()));
+    if (! file.good ())
+    {
+        truncate ();
+        return;
+    }
+
+    truncate ();
+    file.write (pending.data (),
+        static_cast<std::streamsize>(pending.size ()));
+    file.flush ();
+    if (file.good ())
+        write_size = pending.size ();
+    else
+        truncate ();
+}
+
+
+void
+EventSpill::truncate ()
+{
+    file.close ();
+    file.open (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (path).c_str (),
+        std::ios_base::in | std::ios_base::out | std::ios_base::trunc
+        | std::ios_base::binary);
+    read_offset = 0;
+    write_size = 0;
+}
+
+
+} } // namespace log4cplus { namespace helpers {
+
+
+#endif // LOG4CPLUS_SINGLE_THREADED
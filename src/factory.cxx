@@ -33,6 +33,7 @@
 #include <log4cplus/win32debugappender.h>
 #include <log4cplus/win32consoleappender.h>
 #include <log4cplus/log4judpappender.h>
+#include <log4cplus/sharedmemoryappender.h>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -61,6 +62,11 @@ FilterFactory::FilterFactory() = default;
 FilterFactory::~FilterFactory() = default;
 
 
+RolloverStrategyFactory::RolloverStrategyFactory() = default;
+
+RolloverStrategyFactory::~RolloverStrategyFactory() = default;
+
+
 LocaleFactory::LocaleFactory() = default;
 
 LocaleFactory::~LocaleFactory() = default;
@@ -167,6 +173,7 @@ void initializeFactoryRegistry()
     LOG4CPLUS_REG_APPENDER (reg, RollingFileAppender);
     LOG4CPLUS_REG_APPENDER (reg, DailyRollingFileAppender);
     LOG4CPLUS_REG_APPENDER (reg, TimeBasedRollingFileAppender);
+    LOG4CPLUS_REG_APPENDER (reg, ChunkedFileAppender);
     LOG4CPLUS_REG_APPENDER (reg, SocketAppender);
 #if defined(_WIN32)
 #  if defined(LOG4CPLUS_HAVE_NT_EVENT_LOG)
@@ -182,12 +189,16 @@ void initializeFactoryRegistry()
     LOG4CPLUS_REG_APPENDER (reg, AsyncAppender);
 #endif
     LOG4CPLUS_REG_APPENDER (reg, Log4jUdpAppender);
+#if defined (LOG4CPLUS_HAVE_SYS_MMAN_H) && ! defined (_WIN32)
+    LOG4CPLUS_REG_APPENDER (reg, SharedMemoryAppender);
+#endif
 
     spi::LayoutFactoryRegistry& reg2 = spi::getLayoutFactoryRegistry();
     DisableFactoryLocking<spi::LayoutFactoryRegistry> dfl_reg2 (reg2);
     LOG4CPLUS_REG_LAYOUT (reg2, SimpleLayout);
     LOG4CPLUS_REG_LAYOUT (reg2, TTCCLayout);
     LOG4CPLUS_REG_LAYOUT (reg2, PatternLayout);
+    LOG4CPLUS_REG_LAYOUT (reg2, BinaryLayout);
 
     spi::FilterFactoryRegistry& reg3 = spi::getFilterFactoryRegistry();
     DisableFactoryLocking<spi::FilterFactoryRegistry> dfl_reg3 (reg3);
@@ -197,6 +208,12 @@ void initializeFactoryRegistry()
     LOG4CPLUS_REG_FILTER (reg3, StringMatchFilter);
     LOG4CPLUS_REG_FILTER (reg3, NDCMatchFilter);
     LOG4CPLUS_REG_FILTER (reg3, MDCMatchFilter);
+    LOG4CPLUS_REG_FILTER (reg3, RateLimitFilter);
+
+    spi::RolloverStrategyFactoryRegistry& reg5
+        = spi::getRolloverStrategyFactoryRegistry();
+    DisableFactoryLocking<spi::RolloverStrategyFactoryRegistry> dfl_reg5 (reg5);
+    LOG4CPLUS_REG_ROLLOVER_STRATEGY (reg5, SizeOrTimeRolloverStrategy);
 
     spi::LocaleFactoryRegistry& reg4 = spi::getLocaleFactoryRegistry();
     DisableFactoryLocking<spi::LocaleFactoryRegistry> dfl_reg4 (reg4);
@@ -22,6 +22,7 @@
 #include <log4cplus/layout.h>
 #include <log4cplus/streams.h>
 #include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/memorybudget.h>
 #include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/helpers/property.h>
@@ -31,13 +32,24 @@
 #include <log4cplus/thread/syncprims-pub-impl.h>
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/internal/env.h>
+#include <log4cplus/internal/tracepoints.h>
 #include <algorithm>
+#include <filesystem>
+#include <map>
 #include <memory>
 #include <sstream>
+#include <vector>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <functional>
 #include <stdexcept>
 #include <cmath> // std::fmod
 
+#if defined (__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
 // For _wrename() and _wremove() on Windows.
 #include <stdio.h>
 #include <cerrno>
@@ -45,6 +57,48 @@
 #include <errno.h>
 #endif
 
+#if defined (LOG4CPLUS_HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#elif ! defined (_WIN32)
+// For the getFileDescriptor() side descriptor.
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined (__linux__) && defined (LOG4CPLUS_HAVE_LINUX_IO_URING_H) \
+    && defined (LOG4CPLUS_HAVE_SYS_MMAN_H) \
+    && defined (LOG4CPLUS_HAVE_SYS_SYSCALL_H)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <cstdint>
+#include <vector>
+#define LOG4CPLUS_USE_IO_URING 1
+#endif
+
+// O_DIRECT is visible in <fcntl.h>, included above, when _GNU_SOURCE
+// is defined, which g++ does by default.
+#if defined (__linux__) && defined (LOG4CPLUS_HAVE_SYS_MMAN_H) \
+    && defined (O_DIRECT)
+#include <cstdlib>
+#define LOG4CPLUS_USE_O_DIRECT 1
+#endif
+
+// FALLOC_FL_KEEP_SIZE is visible in <fcntl.h>, included above, when
+// _GNU_SOURCE is defined.
+#if defined (__linux__) && defined (LOG4CPLUS_HAVE_SYS_MMAN_H) \
+    && defined (FALLOC_FL_KEEP_SIZE)
+#define LOG4CPLUS_USE_FALLOCATE 1
+#endif
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+#include <zlib.h>
+#endif
+
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 #include <catch.hpp>
 #endif
@@ -56,9 +110,15 @@ namespace log4cplus
 using helpers::Properties;
 using helpers::Time;
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+// from global-init.cxx
+void enqueueThreadPoolTask (std::function<void ()> task);
+#endif
+
 
 const long DEFAULT_ROLLING_LOG_SIZE = 10 * 1024 * 1024L;
 const long MINIMUM_ROLLING_LOG_SIZE = 200*1024L;
+const long DEFAULT_CHUNK_SIZE = 256 * 1024 * 1024L;
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -92,6 +152,84 @@ file_rename (tstring const & src, tstring const & target)
 }
 
 
+#if ! defined (__SSE4_2__)
+//! Byte-wise lookup table for the CRC32C (Castagnoli) polynomial.
+static
+std::uint32_t const *
+crc32c_table ()
+{
+    static std::uint32_t table[256];
+    static bool const initialized = [] {
+        for (std::uint32_t i = 0; i != 256; ++i)
+        {
+            std::uint32_t value = i;
+            for (int j = 0; j != 8; ++j)
+                value = (value >> 1)
+                    ^ (0x82F63B78u & (0u - (value & 1u)));
+            table[i] = value;
+        }
+        return true;
+    } ();
+    static_cast<void>(initialized);
+    return table;
+}
+#endif
+
+
+//! CRC32C (Castagnoli) checksum, using the SSE4.2 CRC32 instruction
+//! when the build targets it and a table driven loop otherwise.
+static
+std::uint32_t
+crc32c (void const * data, std::size_t size)
+{
+    unsigned char const * bytes
+        = static_cast<unsigned char const *>(data);
+    std::uint32_t crc = 0xFFFFFFFFu;
+
+#if defined (__SSE4_2__)
+    while (size >= sizeof (std::uint64_t))
+    {
+        std::uint64_t chunk;
+        std::memcpy (&chunk, bytes, sizeof (chunk));
+        crc = static_cast<std::uint32_t>(
+            _mm_crc32_u64 (crc, chunk));
+        bytes += sizeof (chunk);
+        size -= sizeof (chunk);
+    }
+    while (size != 0)
+    {
+        crc = _mm_crc32_u8 (crc, *bytes);
+        ++bytes;
+        --size;
+    }
+
+#else
+    std::uint32_t const * const table = crc32c_table ();
+    for (; size != 0; ++bytes, --size)
+        crc = (crc >> 8) ^ table[(crc ^ *bytes) & 0xFFu];
+
+#endif
+
+    return crc ^ 0xFFFFFFFFu;
+}
+
+
+//! Writes \c value as eight lower case hexadecimal digits.
+static
+void
+append_hex32 (tostream & os, std::uint32_t value)
+{
+    static tchar const digits[] = LOG4CPLUS_TEXT ("0123456789abcdef");
+    tchar buf[8];
+    for (int i = 7; i >= 0; --i)
+    {
+        buf[i] = digits[value & 0xFu];
+        value >>= 4;
+    }
+    os.write (buf, 8);
+}
+
+
 static
 long
 file_remove (tstring const & src)
@@ -214,9 +352,216 @@ catch (std::runtime_error const &)
     return std::locale ();
 }}
 
+
+//! Pool of stream buffers shared by all file appenders using
+//! adaptive buffering. Buffers released by one appender shrinking
+//! after a burst are handed to the next appender growing, instead of
+//! each appender pinning its own maximal buffer.
+class BufferPool
+{
+public:
+    std::unique_ptr<tchar[]>
+    acquire (std::size_t size)
+    {
+        {
+            thread::MutexGuard guard (mutex);
+            auto it = buffers.find (size);
+            if (it != buffers.end () && ! it->second.empty ())
+            {
+                std::unique_ptr<tchar[]> buf
+                    = std::move (it->second.back ());
+                it->second.pop_back ();
+                pooledBytes -= size * sizeof (tchar);
+                return buf;
+            }
+        }
+
+        // Freshly allocated buffers are charged against the process
+        // wide memory budget; pooled buffers stay charged while idle
+        // because the pool still holds their memory.
+        helpers::MemoryBudget::instance ().charge (size * sizeof (tchar));
+        return std::unique_ptr<tchar[]> (new tchar[size]);
+    }
+
+    void
+    release (std::unique_ptr<tchar[]> buf, std::size_t size)
+    {
+        thread::MutexGuard guard (mutex);
+        if (pooledBytes + size * sizeof (tchar) <= MAX_POOLED_BYTES)
+        {
+            buffers[size].push_back (std::move (buf));
+            pooledBytes += size * sizeof (tchar);
+        }
+        else
+            helpers::MemoryBudget::instance ().release (
+                size * sizeof (tchar));
+    }
+
+    static
+    BufferPool &
+    instance ()
+    {
+        // Deliberately leaked so that appenders torn down during
+        // static destruction can still return their buffers.
+        static BufferPool * const pool = new BufferPool;
+        return *pool;
+    }
+
+private:
+    static std::size_t const MAX_POOLED_BYTES = 8 * 1024 * 1024;
+
+    thread::Mutex mutex;
+    std::size_t pooledBytes = 0;
+    std::map<std::size_t, std::vector<std::unique_ptr<tchar[]>>> buffers;
+};
+
+
+//! Smallest adaptive buffer; also the starting size when BufferSize
+//! is not set.
+std::size_t const ADAPTIVE_BUFFER_MIN_SIZE = 8 * 1024;
+
+//! Default cap for the adaptive buffer.
+std::size_t const ADAPTIVE_BUFFER_DEFAULT_MAX_SIZE = 1024 * 1024;
+
 } // namespace
 
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+//! Flushes the output stream off the logging threads on an adaptive
+//! timer: the interval shortens while events arrive in bursts and
+//! backs off to the configured value when the appender is idle.
+class FileAppenderBase::FlusherThread
+    : public thread::AbstractThread
+{
+public:
+    explicit FlusherThread (
+        helpers::SharedObjectPtr<FileAppenderBase> appender_)
+        : appender (std::move (appender_))
+    { }
+
+    void run() override
+    {
+        // Number of events per interval considered a burst.
+        unsigned long const burst_threshold = 64;
+        unsigned long max_interval
+            = appender->asyncFlushIntervalMillis;
+        // The group commit deadline caps the wait so an interval
+        // based SyncPolicy is honored even between flushes.
+        if (appender->syncIntervalMillis != 0
+            && (max_interval == 0
+                || appender->syncIntervalMillis < max_interval))
+            max_interval = appender->syncIntervalMillis;
+        unsigned long const min_interval
+            = (std::max) (1ul, max_interval / 8);
+        unsigned long interval = max_interval;
+
+        while (true)
+        {
+            appender->flusher_wakeup.timed_wait (interval);
+            if (appender->flusher_exit.load (std::memory_order_acquire))
+                break;
+
+            unsigned long const pending
+                = appender->appends_since_flush.exchange (0,
+                    std::memory_order_relaxed);
+            if (pending != 0)
+            {
+                thread::MutexGuard guard (appender->access_mutex);
+                if (appender->out.good ())
+                    appender->out.flush ();
+            }
+
+            if (appender->syncIntervalMillis != 0)
+            {
+                thread::MutexGuard guard (appender->access_mutex);
+                appender->syncIfDue ();
+            }
+
+            if (pending >= burst_threshold)
+                interval = (std::max) (min_interval, interval / 2);
+            else if (pending == 0)
+                interval = (std::min) (max_interval, interval * 2);
+        }
+    }
+
+private:
+    helpers::SharedObjectPtr<FileAppenderBase> appender;
+};
+
+
+//! Keeps the next rollover target pre-created, pre-allocated where
+//! supported, and pre-opened, off the logging path, so that rollover
+//! in the appender renames the spare file into place and swaps
+//! streams instead of waiting for the filesystem while access_mutex
+//! is held.
+class FileAppenderBase::SpareFileThread
+    : public thread::AbstractThread
+{
+public:
+    explicit SpareFileThread (
+        helpers::SharedObjectPtr<FileAppenderBase> appender_)
+        : appender (std::move (appender_))
+    { }
+
+    void run() override
+    {
+        while (true)
+        {
+            appender->spare_wakeup.timed_wait (1000);
+            appender->spare_wakeup.reset ();
+
+            if (appender->spare_exit.load (std::memory_order_acquire))
+                break;
+
+            if (appender->spare_requested.exchange (false,
+                    std::memory_order_relaxed))
+                prepare ();
+        }
+    }
+
+private:
+    void prepare ()
+    {
+        tstring const path = appender->spareFileName ();
+
+        tofstream file;
+        file.open (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (path).c_str (),
+            std::ios_base::out | std::ios_base::trunc
+            | (appender->fileOpenMode & std::ios_base::binary));
+        file.imbue (get_locale_by_name (appender->localeName));
+
+#if defined (LOG4CPLUS_USE_FALLOCATE)
+        if (appender->spare_prealloc_size > 0)
+        {
+            // FALLOC_FL_KEEP_SIZE reserves the blocks without
+            // changing the file size, so appends into the adopted
+            // file still land at offset zero. Done after the
+            // truncating open above; truncation would discard the
+            // reservation.
+            int const fd = ::open (
+                LOG4CPLUS_TSTRING_TO_STRING (path).c_str (),
+                O_WRONLY, 0644);
+            if (fd != -1)
+            {
+                (void) ::fallocate (fd, FALLOC_FL_KEEP_SIZE, 0,
+                    static_cast<off_t>(appender->spare_prealloc_size));
+                ::close (fd);
+            }
+        }
+#endif
+
+        thread::MutexGuard guard (appender->spare_mutex);
+        appender->spare_out = std::move (file);
+        appender->spare_ready = appender->spare_out.good ();
+    }
+
+    helpers::SharedObjectPtr<FileAppenderBase> appender;
+};
+
+#endif
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // FileAppenderBase ctors and dtor
 ///////////////////////////////////////////////////////////////////////////////
@@ -251,6 +596,52 @@ FileAppenderBase::FileAppenderBase(const Properties& props,
     props.getBool (createDirs, LOG4CPLUS_TEXT("CreateDirs"));
     props.getInt (reopenDelay, LOG4CPLUS_TEXT("ReopenDelay"));
     props.getULong (bufferSize, LOG4CPLUS_TEXT("BufferSize"));
+    props.getBool (adaptiveBuffering, LOG4CPLUS_TEXT("AdaptiveBuffering"));
+    props.getULong (adaptiveBufferMaxSize,
+        LOG4CPLUS_TEXT("AdaptiveBufferMaxSize"));
+    props.getULong (asyncFlushIntervalMillis,
+        LOG4CPLUS_TEXT("AsyncFlushIntervalMillis"));
+    props.getBool (preOpenRolloverFile, LOG4CPLUS_TEXT("PreOpenRolloverFile"));
+
+    tstring const syncPolicy = helpers::toLower (
+        props.getProperty (LOG4CPLUS_TEXT ("SyncPolicy")));
+    if (! syncPolicy.empty ()
+        && syncPolicy != LOG4CPLUS_TEXT ("none"))
+    {
+        static tchar const interval_prefix[] = LOG4CPLUS_TEXT ("interval:");
+        static tchar const group_prefix[] = LOG4CPLUS_TEXT ("group:");
+        std::size_t const interval_prefix_len
+            = sizeof (interval_prefix) / sizeof (tchar) - 1;
+        std::size_t const group_prefix_len
+            = sizeof (group_prefix) / sizeof (tchar) - 1;
+        if (syncPolicy.compare (0, interval_prefix_len,
+                interval_prefix) == 0)
+            syncIntervalMillis = std::strtoul (
+                LOG4CPLUS_TSTRING_TO_STRING (
+                    syncPolicy.substr (interval_prefix_len)).c_str (),
+                nullptr, 10);
+        else if (syncPolicy.compare (0, group_prefix_len,
+                group_prefix) == 0)
+            syncGroupSize = std::strtoul (
+                LOG4CPLUS_TSTRING_TO_STRING (
+                    syncPolicy.substr (group_prefix_len)).c_str (),
+                nullptr, 10);
+        if (syncIntervalMillis == 0 && syncGroupSize == 0)
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("FileAppenderBase- Invalid SyncPolicy: ")
+                + syncPolicy);
+    }
+
+#if defined (_WIN32)
+    if (syncIntervalMillis != 0 || syncGroupSize != 0)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("SyncPolicy is not supported")
+            LOG4CPLUS_TEXT (" on this platform."));
+        syncIntervalMillis = 0;
+        syncGroupSize = 0;
+    }
+#endif
 
     bool app = (mode_ & (std::ios_base::app | std::ios_base::ate)) != 0;
     props.getBool (app, LOG4CPLUS_TEXT("Append"));
@@ -259,6 +650,23 @@ FileAppenderBase::FileAppenderBase(const Properties& props,
     if (props.getProperty(LOG4CPLUS_TEXT("TextMode"), LOG4CPLUS_TEXT("Text"))
         == LOG4CPLUS_TEXT("Binary"))
         fileOpenMode |= std::ios_base::binary;
+
+    props.getBool (recordFraming, LOG4CPLUS_TEXT("RecordFraming"));
+    props.getBool (lockBuffer, LOG4CPLUS_TEXT("LockBuffer"));
+
+    tstring const reopenMode = helpers::toLower (
+        props.getProperty (LOG4CPLUS_TEXT ("ReopenMode")));
+    if (reopenMode == LOG4CPLUS_TEXT ("atomic"))
+    {
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        atomicReopen = true;
+#endif
+    }
+    else if (! reopenMode.empty ()
+        && reopenMode != LOG4CPLUS_TEXT ("inline"))
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("FileAppenderBase- Unknown ReopenMode: ")
+            + reopenMode);
 }
 
 
@@ -278,10 +686,47 @@ FileAppenderBase::init()
         lockFileName += LOG4CPLUS_TEXT(".lock");
     }
 
-    if (bufferSize != 0)
+    if (lockBuffer && adaptiveBuffering)
+    {
+        // Locked pages must not cycle through the shared buffer
+        // pool, so a locked buffer is always fixed size.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("LockBuffer disables AdaptiveBuffering;")
+            LOG4CPLUS_TEXT (" using a fixed size buffer."));
+        adaptiveBuffering = false;
+    }
+
+    if (adaptiveBuffering)
+    {
+        if (adaptiveBufferMaxSize == 0)
+            adaptiveBufferMaxSize = ADAPTIVE_BUFFER_DEFAULT_MAX_SIZE;
+
+        currentBufferSize = (std::min) (
+            bufferSize != 0
+                ? static_cast<std::size_t>(bufferSize)
+                : ADAPTIVE_BUFFER_MIN_SIZE,
+            static_cast<std::size_t>(adaptiveBufferMaxSize));
+        buffer = BufferPool::instance ().acquire (currentBufferSize);
+        out.rdbuf ()->pubsetbuf (buffer.get (), currentBufferSize);
+        lastBufferAdjust = helpers::now ();
+    }
+    else if (bufferSize != 0)
     {
         buffer.reset (new tchar[bufferSize]);
+        helpers::MemoryBudget::instance ().charge (
+            bufferSize * sizeof (tchar));
         out.rdbuf ()->pubsetbuf (buffer.get (), bufferSize);
+        if (lockBuffer)
+        {
+            if (internal::lock_memory (buffer.get (),
+                    bufferSize * sizeof (tchar)))
+                lockedBufferBytes = bufferSize * sizeof (tchar);
+            else
+                helpers::getLogLog ().warn (
+                    LOG4CPLUS_TEXT ("Could not lock stream buffer")
+                    LOG4CPLUS_TEXT (" memory, continuing with an")
+                    LOG4CPLUS_TEXT (" unlocked buffer."));
+        }
     }
 
     helpers::LockFileGuard guard;
@@ -292,7 +737,8 @@ FileAppenderBase::init()
 
         try
         {
-            lockFile = std::make_unique<helpers::LockFile> (lockFileName);
+            lockFile = std::make_unique<helpers::LockFile> (lockFileName,
+                false, useLockFileMutex);
             guard.attach_and_lock (*lockFile);
         }
         catch (std::runtime_error const &)
@@ -305,8 +751,129 @@ FileAppenderBase::init()
 
     open(fileOpenMode);
     imbue (get_locale_by_name (localeName));
+
+    lastSyncTime = std::chrono::steady_clock::now ();
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // The flusher thread also drives the interval based group
+    // commits, so an idle appender still meets its durability bound.
+    if (asyncFlushIntervalMillis != 0 || syncIntervalMillis != 0)
+        initFlusher ();
+#endif
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+void
+FileAppenderBase::initFlusher ()
+{
+    if (immediateFlush && asyncFlushIntervalMillis != 0)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("AsyncFlushIntervalMillis is ignored")
+            LOG4CPLUS_TEXT (" because ImmediateFlush is in effect."));
+        // The thread is still needed for interval based group
+        // commits; with SyncPolicy unset there is nothing left for
+        // it to do.
+        if (syncIntervalMillis == 0)
+            return;
+    }
+
+    flusher_thread = new FlusherThread (
+        helpers::SharedObjectPtr<FileAppenderBase> (this));
+    flusher_thread->start ();
+}
+
+
+void
+FileAppenderBase::initSpareFile (long preallocateSize)
+{
+    if (filename.empty ())
+        return;
+
+    if (useLockFile)
+    {
+        // Another process may roll the shared file at any time;
+        // renaming a locally prepared spare into place would race it.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("PreOpenRolloverFile is not compatible")
+            LOG4CPLUS_TEXT (" with UseLockFile; ignoring."));
+        return;
+    }
+
+    spare_prealloc_size = preallocateSize;
+    spare_thread = new SpareFileThread (
+        helpers::SharedObjectPtr<FileAppenderBase> (this));
+    spare_thread->start ();
+
+    // Get the first spare ready before the first rollover.
+    requestSpareFile ();
+}
+
+
+tstring
+FileAppenderBase::spareFileName () const
+{
+    return filename + LOG4CPLUS_TEXT (".new");
 }
 
+
+//! Moves the pre-created spare file into place and swaps the
+//! pre-opened stream in as the new output stream; the open stream
+//! keeps writing to the file across the rename. Returns false when no
+//! spare is ready or the rename fails, in which case the caller falls
+//! back to a plain open(). Called from rollover with access_mutex
+//! held and the previous file already closed and renamed away.
+bool
+FileAppenderBase::adoptSpareFile ()
+{
+    thread::MutexGuard guard (spare_mutex);
+
+    if (! spare_ready)
+        return false;
+    spare_ready = false;
+
+    long const ret = file_rename (spareFileName (), filename);
+    if (ret != 0)
+    {
+        spare_out.close ();
+        spare_out.clear ();
+        return false;
+    }
+
+    out.swap (spare_out);
+    spare_out.close ();
+    spare_out.clear ();
+
+    // Re-attach the configured stream buffer to the adopted stream.
+    if (buffer)
+        out.rdbuf ()->pubsetbuf (buffer.get (),
+            adaptiveBuffering ? currentBufferSize : bufferSize);
+
+    helpers::getLogLog ().debug (
+        LOG4CPLUS_TEXT ("Adopted pre-opened file as: ") + filename);
+
+    // The spare file was created empty; it gets the same preamble
+    // open() would have written.
+    writeHeader ();
+
+    return out.good ();
+}
+
+
+void
+FileAppenderBase::requestSpareFile ()
+{
+    if (! spare_thread)
+        return;
+
+    spare_requested.store (true, std::memory_order_relaxed);
+    spare_wakeup.signal ();
+}
+
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // FileAppenderBase public methods
 ///////////////////////////////////////////////////////////////////////////////
@@ -314,9 +881,66 @@ FileAppenderBase::init()
 void
 FileAppenderBase::close()
 {
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // Stop the flusher thread before taking access_mutex; it takes
+    // the same mutex for each flush.
+    if (flusher_thread)
+    {
+        flusher_exit.store (true, std::memory_order_release);
+        flusher_wakeup.signal ();
+        if (flusher_thread->isRunning ())
+            flusher_thread->join ();
+        flusher_thread = nullptr;
+    }
+
+    if (spare_thread)
+    {
+        spare_exit.store (true, std::memory_order_release);
+        spare_wakeup.signal ();
+        if (spare_thread->isRunning ())
+            spare_thread->join ();
+        spare_thread = nullptr;
+
+        thread::MutexGuard spare_guard (spare_mutex);
+        if (spare_ready)
+        {
+            spare_ready = false;
+            spare_out.close ();
+            spare_out.clear ();
+            file_remove (spareFileName ());
+        }
+    }
+#endif
+
     thread::MutexGuard guard (access_mutex);
 
+    writeFooter ();
+
+    // Commit the last, possibly partial, group before the stream and
+    // the descriptor go away.
+    if ((syncGroupSize != 0 || syncIntervalMillis != 0)
+        && appendsSinceSync != 0)
+        syncFile ();
+
     out.close();
+#if ! defined (_WIN32)
+    if (dump_fd != -1)
+    {
+        ::close (dump_fd);
+        dump_fd = -1;
+    }
+#endif
+    if (adaptiveBuffering && buffer)
+        BufferPool::instance ().release (std::move (buffer),
+            currentBufferSize);
+    else if (buffer)
+        helpers::MemoryBudget::instance ().release (
+            bufferSize * sizeof (tchar));
+    if (lockedBufferBytes != 0 && buffer)
+    {
+        internal::unlock_memory (buffer.get (), lockedBufferBytes);
+        lockedBufferBytes = 0;
+    }
     buffer.reset ();
     closed = true;
 }
@@ -329,6 +953,13 @@ FileAppenderBase::imbue(std::locale const& loc)
 }
 
 
+int
+FileAppenderBase::getFileDescriptor () const
+{
+    return dump_fd;
+}
+
+
 std::locale
 FileAppenderBase::getloc () const
 {
@@ -340,55 +971,256 @@ FileAppenderBase::getloc () const
 // FileAppenderBase protected methods
 ///////////////////////////////////////////////////////////////////////////////
 
+bool
+FileAppenderBase::recoverStream()
+{
+    if(!reopen()) {
+        getErrorHandler()->error(  LOG4CPLUS_TEXT("file is not open: ")
+                                 + filename);
+        return false;
+    }
+
+    // Resets the error handler to make it
+    // ready to handle a future append error.
+    getErrorHandler()->reset();
+    return true;
+}
+
+
 // This method does not need to be locked since it is called by
 // doAppend() which performs the locking
 void
 FileAppenderBase::append(const spi::InternalLoggingEvent& event)
 {
-    if(!out.good()) {
-        if(!reopen()) {
-            getErrorHandler()->error(  LOG4CPLUS_TEXT("file is not open: ")
-                                     + filename);
-            return;
-        }
-        // Resets the error handler to make it
-        // ready to handle a future append error.
-        else
-            getErrorHandler()->reset();
-    }
+    if (LOG4CPLUS_UNLIKELY (
+            reopen_requested.load (std::memory_order_relaxed)))
+        performRequestedReopen ();
+
+    if (LOG4CPLUS_UNLIKELY (!out.good()) && !recoverStream())
+        return;
 
     if (useLockFile)
         out.seekp (0, std::ios_base::end);
 
-    layout->formatAndAppend(out, event);
+    auto const before = out.tellp ();
+    if (recordFraming)
+        appendFramed (event);
+    else
+        layout->formatAndAppend(out, event);
+    auto const after = out.tellp ();
+    if (before != -1 && after != -1)
+    {
+        std::size_t const written
+            = static_cast<std::size_t>(after - before);
+        countBytesWritten (written);
+        if (adaptiveBuffering)
+            adjustBuffer (written);
+    }
 
     if(immediateFlush || useLockFile)
         out.flush();
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    else if (flusher_thread)
+        appends_since_flush.fetch_add (1, std::memory_order_relaxed);
+#endif
+    if (LOG4CPLUS_UNLIKELY (syncGroupSize != 0 || syncIntervalMillis != 0))
+        accountEventsForSync (1);
 }
 
+// This method does not need to be locked since it is called by
+// doAppendBatch() which performs the locking
 void
-FileAppenderBase::open(std::ios_base::openmode mode)
+FileAppenderBase::appendBatch(const spi::InternalLoggingEvent* events,
+    std::size_t count)
 {
-    if (createDirs)
-        internal::make_dirs (filename);
-
-    out.open(LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME(filename).c_str(), mode);
+    if (LOG4CPLUS_UNLIKELY (
+            reopen_requested.load (std::memory_order_relaxed)))
+        performRequestedReopen ();
 
-    if(!out.good()) {
-        getErrorHandler()->error(LOG4CPLUS_TEXT("Unable to open file: ") + filename);
+    if (LOG4CPLUS_UNLIKELY (!out.good()) && !recoverStream())
         return;
+
+    if (useLockFile)
+        out.seekp (0, std::ios_base::end);
+
+    // Format the whole batch in one layout call and flush once at
+    // the end instead of after each event. Framing needs the
+    // boundaries of each record, so it formats event by event.
+    auto const before = out.tellp ();
+    if (recordFraming)
+    {
+        for (std::size_t i = 0; i != count; ++i)
+            appendFramed (events[i]);
     }
-    helpers::getLogLog().debug(LOG4CPLUS_TEXT("Just opened file: ") + filename);
+    else
+        layout->formatAndAppendBatch(out, events, count);
+    auto const after = out.tellp ();
+    if (before != -1 && after != -1)
+    {
+        std::size_t const written
+            = static_cast<std::size_t>(after - before);
+        countBytesWritten (written);
+        if (adaptiveBuffering)
+            adjustBuffer (written);
+    }
+
+    if(immediateFlush || useLockFile)
+        out.flush();
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    else if (flusher_thread)
+        appends_since_flush.fetch_add (count, std::memory_order_relaxed);
+#endif
+    if (LOG4CPLUS_UNLIKELY (syncGroupSize != 0 || syncIntervalMillis != 0))
+        accountEventsForSync (count);
 }
 
-bool
-FileAppenderBase::reopen()
+
+// Writes one formatted event as a `length SP crc SP payload NL`
+// record. The length counts payload characters and the CRC32C covers
+// the payload bytes; a reader that finds a header that does not
+// parse, a payload shorter than the length says, or a checksum
+// mismatch is looking at a torn tail and can stop right there.
+std::size_t
+FileAppenderBase::appendFramed (const spi::InternalLoggingEvent& event)
 {
-    // When append never failed and the file re-open attempt must
-    // be delayed, set the time when reopen should take place.
-    if (reopen_time == log4cplus::helpers::Time () && reopenDelay != 0)
-        reopen_time = log4cplus::helpers::now ()
-            + helpers::chrono::seconds (reopenDelay);
+    framing_oss.clear ();
+    framing_oss.str (internal::empty_str);
+    layout->formatAndAppend (framing_oss, event);
+
+    tstring const payload = framing_oss.str ();
+    append_hex32 (out, static_cast<std::uint32_t>(payload.size ()));
+    out.put (LOG4CPLUS_TEXT (' '));
+    append_hex32 (out,
+        crc32c (payload.data (), payload.size () * sizeof (tchar)));
+    out.put (LOG4CPLUS_TEXT (' '));
+    out.write (payload.data (), payload.size ());
+    out.put (LOG4CPLUS_TEXT ('\n'));
+
+    // Two 8 digit fields, their separators and the terminating
+    // newline surround the payload.
+    return payload.size () + 19;
+}
+
+void
+FileAppenderBase::adjustBuffer (std::size_t bytes_written)
+{
+    bytesSinceAdjust += bytes_written;
+
+    helpers::Time const now_ = helpers::now ();
+    if (now_ - lastBufferAdjust < helpers::chrono::seconds (1))
+        return;
+
+    // Double the buffer when the last second wrote several times its
+    // size, halve it when the buffer went mostly unused.
+    std::size_t new_size = currentBufferSize;
+    if (bytesSinceAdjust > 4 * currentBufferSize)
+        new_size = (std::min) (currentBufferSize * 2,
+            static_cast<std::size_t>(adaptiveBufferMaxSize));
+    else if (bytesSinceAdjust < currentBufferSize / 4)
+        new_size = (std::max) (currentBufferSize / 2,
+            ADAPTIVE_BUFFER_MIN_SIZE);
+
+    if (new_size != currentBufferSize)
+    {
+        // Flush so that the stream buffer is empty; common
+        // implementations allow pubsetbuf() on an open file stream
+        // only in that state.
+        out.flush ();
+        if (out.good ())
+        {
+            std::unique_ptr<tchar[]> new_buffer
+                = BufferPool::instance ().acquire (new_size);
+            out.rdbuf ()->pubsetbuf (new_buffer.get (), new_size);
+            BufferPool::instance ().release (std::move (buffer),
+                currentBufferSize);
+            buffer = std::move (new_buffer);
+            currentBufferSize = new_size;
+        }
+    }
+
+    bytesSinceAdjust = 0;
+    lastBufferAdjust = now_;
+}
+
+
+void
+FileAppenderBase::open(std::ios_base::openmode mode)
+{
+    if (createDirs)
+        internal::make_dirs (filename);
+
+#if ! defined (_WIN32)
+    if (dump_fd != -1)
+    {
+        ::close (dump_fd);
+        dump_fd = -1;
+    }
+#endif
+
+    out.open(LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME(filename).c_str(), mode);
+
+    if(!out.good()) {
+        getErrorHandler()->error(LOG4CPLUS_TEXT("Unable to open file: ") + filename);
+        return;
+    }
+
+#if ! defined (_WIN32)
+    // Side descriptor for crash time emergency dumps; O_APPEND so
+    // that raw writes land after whatever the stream has flushed.
+    dump_fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (filename).c_str (),
+        O_WRONLY | O_APPEND);
+#endif
+
+    helpers::getLogLog().debug(LOG4CPLUS_TEXT("Just opened file: ") + filename);
+
+    writeHeader ();
+}
+
+
+void
+FileAppenderBase::writeHeader ()
+{
+    if (! layout)
+        return;
+
+    tstring const & header = layout->getHeader ();
+    if (header.empty () || ! out.good ())
+        return;
+
+    // Only a fresh (or truncated) file gets the preamble; reopening
+    // an already written file in append mode must not inject a
+    // second header into its middle.
+    out.seekp (0, std::ios_base::end);
+    if (out.tellp () != std::streampos (0))
+        return;
+
+    out.write (header.data (),
+        static_cast<std::streamsize>(header.size ()));
+}
+
+
+void
+FileAppenderBase::writeFooter ()
+{
+    if (! layout)
+        return;
+
+    tstring const & footer = layout->getFooter ();
+    if (footer.empty () || ! out.good ())
+        return;
+
+    out.write (footer.data (),
+        static_cast<std::streamsize>(footer.size ()));
+}
+
+bool
+FileAppenderBase::reopen()
+{
+    // When append never failed and the file re-open attempt must
+    // be delayed, set the time when reopen should take place.
+    if (reopen_time == log4cplus::helpers::Time () && reopenDelay != 0)
+        reopen_time = log4cplus::helpers::now ()
+            + helpers::chrono::seconds (reopenDelay);
     else
     {
         // Otherwise, check for end of the delay (or absence of delay)
@@ -396,108 +1228,1291 @@ FileAppenderBase::reopen()
         if (reopen_time <= log4cplus::helpers::now ()
             || reopenDelay == 0)
         {
-            // Close the current file
-            out.close();
-            // reset flags since the C++ standard specified that all
-            // the flags should remain unchanged on a close
-            out.clear();
+            // Close the current file
+            out.close();
+            // reset flags since the C++ standard specified that all
+            // the flags should remain unchanged on a close
+            out.clear();
+
+            // Re-open the file.
+            open(std::ios_base::out | std::ios_base::ate | std::ios_base::app);
+
+            // Reset last fail time.
+            reopen_time = log4cplus::helpers::Time ();
+
+            // Succeed if no errors are found.
+            if(out.good())
+                return true;
+        }
+    }
+    return false;
+}
+
+
+void
+FileAppenderBase::requestReopen ()
+{
+    if (reopen_requested.exchange (true, std::memory_order_relaxed))
+        // A reopen is already pending; the prepared stream will pick
+        // up the latest rename anyway.
+        return;
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (atomicReopen)
+    {
+        // Prepare the replacement stream off the logging path; the
+        // append path swaps it in once it is ready. The shared
+        // pointer keeps the appender alive until the task has run.
+        SharedAppenderPtr appender (this);
+        enqueueThreadPoolTask (
+            [this, appender] ()
+            {
+                if (createDirs)
+                    internal::make_dirs (filename);
+
+                pending_out.open (
+                    LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (filename).c_str (),
+                    std::ios_base::out | std::ios_base::ate
+                    | std::ios_base::app
+                    | (fileOpenMode & std::ios_base::binary));
+                pending_out.imbue (get_locale_by_name (localeName));
+                if (pending_out.good ())
+                    pending_stream_ready.store (true,
+                        std::memory_order_release);
+                else
+                {
+                    helpers::getLogLog ().error (
+                        LOG4CPLUS_TEXT ("FileAppenderBase- Unable to")
+                        LOG4CPLUS_TEXT (" prepare replacement file: ")
+                        + filename);
+                    pending_out.close ();
+                    pending_out.clear ();
+                    reopen_requested.store (false,
+                        std::memory_order_relaxed);
+                }
+            });
+    }
+#endif
+}
+
+
+// Runs on the append path, under the appender mutex held by
+// doAppend().
+void
+FileAppenderBase::performRequestedReopen ()
+{
+    if (atomicReopen)
+    {
+        if (! pending_stream_ready.load (std::memory_order_acquire))
+            // The replacement is still being prepared; keep writing
+            // to the renamed file until it is ready.
+            return;
+
+        out.swap (pending_out);
+        // Flush the buffered tail to the renamed file; nothing may
+        // land there after this point.
+        pending_out.close ();
+        pending_out.clear ();
+
+        // Re-attach the configured stream buffer to the new stream.
+        if (buffer)
+            out.rdbuf ()->pubsetbuf (buffer.get (),
+                adaptiveBuffering ? currentBufferSize : bufferSize);
+
+        pending_stream_ready.store (false, std::memory_order_relaxed);
+    }
+    else
+    {
+        out.close ();
+        out.clear ();
+        open (std::ios_base::out | std::ios_base::ate | std::ios_base::app
+            | (fileOpenMode & std::ios_base::binary));
+    }
+
+#if ! defined (_WIN32)
+    if (atomicReopen)
+    {
+        // open() refreshes the emergency dump descriptor itself on
+        // the inline path; the swap path has to do it here.
+        if (dump_fd != -1)
+            ::close (dump_fd);
+        dump_fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (filename).c_str (),
+            O_WRONLY | O_APPEND);
+    }
+#endif
+
+    reopen_requested.store (false, std::memory_order_relaxed);
+
+    helpers::getLogLog ().debug (
+        LOG4CPLUS_TEXT ("Reopened file after rotation: ") + filename);
+}
+
+
+// Flushes the stream and forces the data down to stable storage.
+// The caller holds access_mutex.
+void
+FileAppenderBase::syncFile ()
+{
+    if (out.good ())
+        out.flush ();
+#if ! defined (_WIN32)
+    if (dump_fd != -1)
+        ::fsync (dump_fd);
+#endif
+    appendsSinceSync = 0;
+    lastSyncTime = std::chrono::steady_clock::now ();
+}
+
+
+// Cold path of the append hook; counts the appended events against
+// the configured SyncPolicy and commits the group when either bound
+// is reached. The caller holds access_mutex.
+void
+FileAppenderBase::accountEventsForSync (std::size_t count)
+{
+    appendsSinceSync += count;
+    if ((syncGroupSize != 0 && appendsSinceSync >= syncGroupSize)
+        || (syncIntervalMillis != 0
+            && std::chrono::steady_clock::now () - lastSyncTime
+                >= std::chrono::milliseconds (syncIntervalMillis)))
+        syncFile ();
+}
+
+
+// Interval check run by the flusher thread so an appender that has
+// gone idle still gets its pending group committed within the bound.
+// The caller holds access_mutex.
+void
+FileAppenderBase::syncIfDue ()
+{
+    if (appendsSinceSync != 0
+        && std::chrono::steady_clock::now () - lastSyncTime
+            >= std::chrono::milliseconds (syncIntervalMillis))
+        syncFile ();
+}
+
+
+void
+FileAppenderBase::logAndSync (const spi::InternalLoggingEvent& event)
+{
+    doAppend (event);
+
+    thread::MutexGuard guard (access_mutex);
+    syncFile ();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FileAppender ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+//! Memory mapped view of the tail of the log file. Appends are plain
+//! memory copies into the mapping; the file is extended and remapped
+//! extent by extent and writeback is left to the kernel.
+struct FileAppender::MemoryMappedFile
+{
+#if defined (LOG4CPLUS_HAVE_SYS_MMAN_H)
+    int fd = -1;
+    char * base = nullptr;
+    std::size_t extent = 0;
+    std::size_t pos = 0;
+    off_t map_offset = 0;
+
+    ~MemoryMappedFile ()
+    {
+        close_file ();
+    }
+
+    bool
+    open_file (tstring const & fname, std::size_t extent_size)
+    {
+        fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (fname).c_str (),
+            O_RDWR | O_CREAT, 0644);
+        if (fd == -1)
+            return false;
+
+        long const page = ::sysconf (_SC_PAGESIZE);
+        extent = (extent_size + page - 1) / page * page;
+        if (extent == 0)
+            extent = static_cast<std::size_t>(page);
+
+        off_t const size = ::lseek (fd, 0, SEEK_END);
+        if (size == -1)
+        {
+            close_file ();
+            return false;
+        }
+
+        // Align the mapping on a page boundary at or before the
+        // current end of file and continue appending from there.
+        map_offset = size / page * page;
+        pos = static_cast<std::size_t>(size - map_offset);
+
+        if (! map_extent ())
+        {
+            close_file ();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool
+    map_extent ()
+    {
+        if (::ftruncate (fd, map_offset + static_cast<off_t>(extent)) == -1)
+            return false;
+
+        void * const p = ::mmap (nullptr, extent, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, map_offset);
+        if (p == MAP_FAILED)
+            return false;
+
+        base = static_cast<char *>(p);
+        return true;
+    }
+
+    bool
+    write (char const * data, std::size_t size)
+    {
+        while (size != 0)
+        {
+            if (pos == extent)
+            {
+                ::munmap (base, extent);
+                base = nullptr;
+                map_offset += static_cast<off_t>(extent);
+                pos = 0;
+                if (! map_extent ())
+                    return false;
+            }
+
+            std::size_t const chunk = (std::min) (size, extent - pos);
+            std::memcpy (base + pos, data, chunk);
+            pos += chunk;
+            data += chunk;
+            size -= chunk;
+        }
+
+        return true;
+    }
+
+    void
+    close_file ()
+    {
+        if (base)
+        {
+            ::munmap (base, extent);
+            base = nullptr;
+        }
+
+        if (fd != -1)
+        {
+            // Trim the zero filled tail of the last extent.
+            ::ftruncate (fd, map_offset + static_cast<off_t>(pos));
+            ::close (fd);
+            fd = -1;
+        }
+    }
+#endif // LOG4CPLUS_HAVE_SYS_MMAN_H
+};
+
+
+//! Asynchronous writer backed by an io_uring instance. Formatted
+//! buffers are copied into per slot storage, submitted as
+//! IORING_OP_WRITE requests with explicit file offsets and completed
+//! by the kernel without further involvement of the logging thread.
+//! Completions are reaped opportunistically; the writer blocks only
+//! when all submission slots are in flight.
+struct FileAppender::IOUringWriter
+{
+#if defined (LOG4CPLUS_USE_IO_URING)
+    int fd = -1;
+    int ring_fd = -1;
+    off_t next_offset = 0;
+
+    // Submission queue ring.
+    void * sq_ring = nullptr;
+    std::size_t sq_ring_size = 0;
+    unsigned * sq_head = nullptr;
+    unsigned * sq_tail = nullptr;
+    unsigned * sq_mask = nullptr;
+    unsigned * sq_array = nullptr;
+    io_uring_sqe * sqes = nullptr;
+    std::size_t sqes_size = 0;
+
+    // Completion queue ring.
+    void * cq_ring = nullptr;
+    std::size_t cq_ring_size = 0;
+    unsigned * cq_head = nullptr;
+    unsigned * cq_tail = nullptr;
+    unsigned * cq_mask = nullptr;
+    io_uring_cqe * cqes = nullptr;
+
+    // One preallocated buffer per submission slot. A slot number
+    // travels through user_data and returns to free_slots when its
+    // completion is reaped.
+    std::vector<std::string> buffers;
+    std::vector<unsigned> free_slots;
+    unsigned in_flight = 0;
+    bool failed = false;
+
+    ~IOUringWriter ()
+    {
+        close_file ();
+    }
+
+    static int
+    sys_setup (unsigned entries, io_uring_params * params)
+    {
+        return static_cast<int>(
+            ::syscall (SYS_io_uring_setup, entries, params));
+    }
+
+    int
+    sys_enter (unsigned to_submit, unsigned min_complete, unsigned flags)
+    {
+        return static_cast<int>(
+            ::syscall (SYS_io_uring_enter, ring_fd, to_submit, min_complete,
+                flags, nullptr, 0));
+    }
+
+    bool
+    open_file (tstring const & fname, unsigned depth)
+    {
+        fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (fname).c_str (),
+            O_WRONLY | O_CREAT, 0644);
+        if (fd == -1)
+            return false;
+
+        // Each request carries its own offset so completion order does
+        // not affect on disk order.
+        off_t const size = ::lseek (fd, 0, SEEK_END);
+        if (size == -1)
+        {
+            close_file ();
+            return false;
+        }
+
+        next_offset = size;
+
+        io_uring_params params;
+        std::memset (&params, 0, sizeof (params));
+        depth = (std::min) ((std::max) (depth, 1u), 4096u);
+        ring_fd = sys_setup (depth, &params);
+        if (ring_fd == -1)
+        {
+            close_file ();
+            return false;
+        }
+
+        sq_ring_size = params.sq_off.array
+            + params.sq_entries * sizeof (unsigned);
+        cq_ring_size = params.cq_off.cqes
+            + params.cq_entries * sizeof (io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            sq_ring_size = cq_ring_size
+                = (std::max) (sq_ring_size, cq_ring_size);
+
+        sq_ring = ::mmap (nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ring == MAP_FAILED)
+        {
+            sq_ring = nullptr;
+            close_file ();
+            return false;
+        }
+
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            cq_ring = sq_ring;
+        else
+        {
+            cq_ring = ::mmap (nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+            if (cq_ring == MAP_FAILED)
+            {
+                cq_ring = nullptr;
+                close_file ();
+                return false;
+            }
+        }
+
+        sqes_size = params.sq_entries * sizeof (io_uring_sqe);
+        void * const p = ::mmap (nullptr, sqes_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+        if (p == MAP_FAILED)
+        {
+            close_file ();
+            return false;
+        }
+
+        sqes = static_cast<io_uring_sqe *>(p);
+
+        char * const sqr = static_cast<char *>(sq_ring);
+        sq_head = reinterpret_cast<unsigned *>(sqr + params.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned *>(sqr + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned *>(sqr + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(sqr + params.sq_off.array);
+
+        char * const cqr = static_cast<char *>(cq_ring);
+        cq_head = reinterpret_cast<unsigned *>(cqr + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cqr + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned *>(cqr + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cqr + params.cq_off.cqes);
+
+        buffers.resize (params.sq_entries);
+        free_slots.reserve (params.sq_entries);
+        for (unsigned i = 0; i != params.sq_entries; ++i)
+            free_slots.push_back (i);
+
+        return true;
+    }
+
+    //! Collect available completions without blocking.
+    void
+    reap ()
+    {
+        unsigned head = *cq_head;
+        unsigned const tail = __atomic_load_n (cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head)
+        {
+            io_uring_cqe const & cqe = cqes[head & *cq_mask];
+            unsigned const slot = static_cast<unsigned>(cqe.user_data);
+            if (cqe.res < 0
+                || static_cast<std::size_t>(cqe.res)
+                    != buffers[slot].size ())
+                failed = true;
+            free_slots.push_back (slot);
+            --in_flight;
+        }
+
+        __atomic_store_n (cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    //! Block until all submitted writes have completed.
+    bool
+    drain ()
+    {
+        while (in_flight != 0)
+        {
+            if (sys_enter (0, 1, IORING_ENTER_GETEVENTS) == -1
+                && errno != EINTR)
+            {
+                failed = true;
+                return false;
+            }
+
+            reap ();
+        }
+
+        return ! failed;
+    }
+
+    bool
+    write (char const * data, std::size_t size)
+    {
+        if (failed)
+            return false;
+
+        reap ();
+        while (free_slots.empty ())
+        {
+            if (sys_enter (0, 1, IORING_ENTER_GETEVENTS) == -1
+                && errno != EINTR)
+            {
+                failed = true;
+                return false;
+            }
+
+            reap ();
+            if (failed)
+                return false;
+        }
+
+        unsigned const slot = free_slots.back ();
+        free_slots.pop_back ();
+        buffers[slot].assign (data, size);
+
+        unsigned const tail = *sq_tail;
+        unsigned const index = tail & *sq_mask;
+        io_uring_sqe & sqe = sqes[index];
+        std::memset (&sqe, 0, sizeof (sqe));
+        sqe.opcode = IORING_OP_WRITE;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<std::uintptr_t>(buffers[slot].data ());
+        sqe.len = static_cast<unsigned>(buffers[slot].size ());
+        sqe.off = static_cast<std::uint64_t>(next_offset);
+        sqe.user_data = slot;
+        sq_array[index] = index;
+        __atomic_store_n (sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        if (sys_enter (1, 0, 0) == -1)
+        {
+            failed = true;
+            free_slots.push_back (slot);
+            return false;
+        }
+
+        next_offset += static_cast<off_t>(size);
+        ++in_flight;
+        return true;
+    }
+
+    void
+    close_file ()
+    {
+        if (ring_fd != -1)
+        {
+            drain ();
+
+            if (sqes)
+            {
+                ::munmap (sqes, sqes_size);
+                sqes = nullptr;
+            }
+
+            if (cq_ring && cq_ring != sq_ring)
+                ::munmap (cq_ring, cq_ring_size);
+            cq_ring = nullptr;
+
+            if (sq_ring)
+            {
+                ::munmap (sq_ring, sq_ring_size);
+                sq_ring = nullptr;
+            }
+
+            ::close (ring_fd);
+            ring_fd = -1;
+        }
+
+        if (fd != -1)
+        {
+            ::close (fd);
+            fd = -1;
+        }
+    }
+#endif // LOG4CPLUS_USE_IO_URING
+};
+
+
+//! Accumulates formatted output in an aligned buffer and writes it
+//! with O_DIRECT, bypassing the page cache. Full buffers are written
+//! at aligned offsets; the unaligned tail is written padded on close
+//! and the file is then trimmed back to its logical size.
+struct FileAppender::DirectFileWriter
+{
+#if defined (LOG4CPLUS_USE_O_DIRECT)
+    int fd = -1;
+    char * buf = nullptr;
+    std::size_t buf_size = 0;
+    std::size_t alignment = 0;
+    std::size_t pos = 0;
+    off_t buf_offset = 0;
+
+    ~DirectFileWriter ()
+    {
+        close_file ();
+    }
+
+    bool
+    open_file (tstring const & fname, std::size_t requested_size)
+    {
+        fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (fname).c_str (),
+            O_RDWR | O_CREAT | O_DIRECT, 0644);
+        if (fd == -1)
+            return false;
+
+        // The logical block size would do but the page size satisfies
+        // the O_DIRECT alignment requirements of any Linux filesystem.
+        alignment = static_cast<std::size_t>(::sysconf (_SC_PAGESIZE));
+        buf_size = (std::max) (requested_size, alignment)
+            / alignment * alignment;
+
+        void * p = nullptr;
+        if (::posix_memalign (&p, alignment, buf_size) != 0)
+        {
+            close_file ();
+            return false;
+        }
+
+        buf = static_cast<char *>(p);
+
+        off_t const size = ::lseek (fd, 0, SEEK_END);
+        if (size == -1)
+        {
+            close_file ();
+            return false;
+        }
+
+        // Continue from the aligned offset at or before the current
+        // end of file; the unaligned tail is preloaded into the
+        // buffer so that it is rewritten together with new output.
+        buf_offset = size / static_cast<off_t>(alignment)
+            * static_cast<off_t>(alignment);
+        pos = static_cast<std::size_t>(size - buf_offset);
+        if (pos != 0
+            && ::pread (fd, buf, alignment, buf_offset)
+                != static_cast<ssize_t>(pos))
+        {
+            close_file ();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool
+    write (char const * data, std::size_t size)
+    {
+        while (size != 0)
+        {
+            std::size_t const chunk = (std::min) (size, buf_size - pos);
+            std::memcpy (buf + pos, data, chunk);
+            pos += chunk;
+            data += chunk;
+            size -= chunk;
+
+            if (pos == buf_size)
+            {
+                if (::pwrite (fd, buf, buf_size, buf_offset)
+                    != static_cast<ssize_t>(buf_size))
+                    return false;
+
+                buf_offset += static_cast<off_t>(buf_size);
+                pos = 0;
+            }
+        }
+
+        return true;
+    }
+
+    void
+    close_file ()
+    {
+        if (fd != -1)
+        {
+            if (buf && pos != 0)
+            {
+                // Write the tail padded to the alignment, then trim
+                // the zero filled padding off.
+                std::size_t const padded
+                    = (pos + alignment - 1) / alignment * alignment;
+                std::memset (buf + pos, 0, padded - pos);
+                if (::pwrite (fd, buf, padded, buf_offset)
+                    == static_cast<ssize_t>(padded))
+                    ::ftruncate (fd, buf_offset + static_cast<off_t>(pos));
+            }
+
+            ::close (fd);
+            fd = -1;
+        }
+
+        std::free (buf);
+        buf = nullptr;
+    }
+#endif // LOG4CPLUS_USE_O_DIRECT
+};
+
+
+FileAppender::FileAppender(
+    const tstring& filename_,
+    std::ios_base::openmode mode_,
+    bool immediateFlush_,
+    bool createDirs_)
+    : FileAppenderBase(filename_, mode_, immediateFlush_, createDirs_)
+{
+    init();
+}
+
+
+FileAppender::FileAppender(
+    const Properties& props,
+    std::ios_base::openmode mode_)
+    : FileAppenderBase(props, mode_)
+{
+    props.getBool (useMemoryMappedIO, LOG4CPLUS_TEXT ("UseMemoryMappedIO"));
+    props.getULong (memoryMapExtent, LOG4CPLUS_TEXT ("MemoryMapExtent"));
+    props.getBool (useIOUring, LOG4CPLUS_TEXT ("UseIOUring"));
+    props.getULong (ioUringQueueDepth, LOG4CPLUS_TEXT ("IOUringQueueDepth"));
+    props.getBool (useDirectIO, LOG4CPLUS_TEXT ("UseDirectIO"));
+    props.getULong (directIOBufferSize,
+        LOG4CPLUS_TEXT ("DirectIOBufferSize"));
+
+    props.getBool (timestampIndex, LOG4CPLUS_TEXT ("TimestampIndex"));
+    tstring tmp (
+        helpers::toUpper (
+            props.getProperty (LOG4CPLUS_TEXT ("TimestampIndexByteInterval"))));
+    if (! tmp.empty ())
+    {
+        long interval = std::atoi(LOG4CPLUS_TSTRING_TO_STRING(tmp).c_str());
+        if (interval != 0)
+        {
+            tstring::size_type const len = tmp.length();
+            if (len > 2
+                && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("MB")) == 0)
+                interval *= (1024 * 1024); // convert to megabytes
+            else if (len > 2
+                && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("KB")) == 0)
+                interval *= 1024; // convert to kilobytes
+            tsIndexByteInterval = interval;
+        }
+    }
+    props.getULong (tsIndexTimeInterval,
+        LOG4CPLUS_TEXT ("TimestampIndexTimeInterval"));
+
+    init();
+}
+
+FileAppender::~FileAppender()
+{
+    destructorImpl();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// FileAppender protected methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+FileAppender::init()
+{
+    if (filename.empty())
+    {
+        getErrorHandler()->error( LOG4CPLUS_TEXT("Invalid filename") );
+        return;
+    }
+
+    FileAppenderBase::init();
+
+    if (useMemoryMappedIO)
+    {
+#if defined (LOG4CPLUS_HAVE_SYS_MMAN_H)
+        // The stream open above has already handled truncation vs.
+        // append; the mapping always continues at the current end of
+        // the file.
+        auto mapped = std::make_unique<MemoryMappedFile> ();
+        if (mapped->open_file (filename, memoryMapExtent))
+            mmap_out = std::move (mapped);
+        else
+            getErrorHandler()->error(
+                LOG4CPLUS_TEXT("Unable to memory map file: ") + filename);
+#else
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("UseMemoryMappedIO is not supported")
+            LOG4CPLUS_TEXT (" on this platform."));
+#endif
+    }
+
+    if (useIOUring)
+    {
+        if (mmap_out)
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("UseIOUring is ignored because")
+                LOG4CPLUS_TEXT (" UseMemoryMappedIO is in effect."));
+        else
+        {
+#if defined (LOG4CPLUS_USE_IO_URING)
+            auto writer = std::make_unique<IOUringWriter> ();
+            if (writer->open_file (filename,
+                    static_cast<unsigned>(ioUringQueueDepth)))
+                uring_out = std::move (writer);
+            else
+                // E.g. io_uring can be disabled by seccomp in
+                // containers; keep using the stream based path.
+                getErrorHandler()->error(
+                    LOG4CPLUS_TEXT("Unable to set up io_uring for file: ")
+                    + filename);
+#else
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("UseIOUring is not supported")
+                LOG4CPLUS_TEXT (" on this platform."));
+#endif
+        }
+    }
+
+    if (useDirectIO)
+    {
+        if (mmap_out || uring_out)
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("UseDirectIO is ignored because")
+                LOG4CPLUS_TEXT (" another output mode is in effect."));
+        else
+        {
+#if defined (LOG4CPLUS_USE_O_DIRECT)
+            auto writer = std::make_unique<DirectFileWriter> ();
+            if (writer->open_file (filename,
+                    static_cast<std::size_t>(directIOBufferSize)))
+            {
+                direct_out = std::move (writer);
+                if (immediateFlush)
+                    helpers::getLogLog ().warn (
+                        LOG4CPLUS_TEXT ("ImmediateFlush is ignored")
+                        LOG4CPLUS_TEXT (" when UseDirectIO is in effect."));
+            }
+            else
+                // E.g. the filesystem may not support O_DIRECT; keep
+                // using the stream based path.
+                getErrorHandler()->error(
+                    LOG4CPLUS_TEXT("Unable to open file for direct I/O: ")
+                    + filename);
+#else
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("UseDirectIO is not supported")
+                LOG4CPLUS_TEXT (" on this platform."));
+#endif
+        }
+    }
 
-            // Re-open the file.
-            open(std::ios_base::out | std::ios_base::ate | std::ios_base::app);
+    if (timestampIndex && (mmap_out || uring_out || direct_out))
+    {
+        // The index records stream positions, which the alternative
+        // output modes do not maintain.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("TimestampIndex is ignored because")
+            LOG4CPLUS_TEXT (" another output mode is in effect."));
+        timestampIndex = false;
+    }
 
-            // Reset last fail time.
-            reopen_time = log4cplus::helpers::Time ();
+    if (recordFraming && (mmap_out || uring_out || direct_out))
+    {
+        // The alternative output modes write pre-formatted chunks
+        // without per record boundaries.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("RecordFraming is ignored because")
+            LOG4CPLUS_TEXT (" another output mode is in effect."));
+        recordFraming = false;
+    }
 
-            // Succeed if no errors are found.
-            if(out.good())
-                return true;
-        }
+    if (atomicReopen && (mmap_out || uring_out || direct_out))
+    {
+        // The alternative output modes bypass the stream the atomic
+        // reopen machinery swaps.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("ReopenMode=atomic is ignored because")
+            LOG4CPLUS_TEXT (" another output mode is in effect."));
+        atomicReopen = false;
+    }
+
+    if ((syncIntervalMillis != 0 || syncGroupSize != 0)
+        && (mmap_out || uring_out || direct_out))
+    {
+        // The alternative output modes write past the stream and the
+        // emergency dump descriptor the group commit syncs.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("SyncPolicy is ignored because")
+            LOG4CPLUS_TEXT (" another output mode is in effect."));
+        syncIntervalMillis = 0;
+        syncGroupSize = 0;
     }
-    return false;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// FileAppender ctors and dtor
-///////////////////////////////////////////////////////////////////////////////
 
-FileAppender::FileAppender(
-    const tstring& filename_,
-    std::ios_base::openmode mode_,
-    bool immediateFlush_,
-    bool createDirs_)
-    : FileAppenderBase(filename_, mode_, immediateFlush_, createDirs_)
+void
+FileAppender::close()
 {
-    init();
+    {
+        thread::MutexGuard guard (access_mutex);
+        mmap_out.reset ();
+        // Destroying the writer drains all in flight writes.
+        uring_out.reset ();
+        // Destroying the writer flushes the buffered tail.
+        direct_out.reset ();
+        ts_index_out.close ();
+    }
+    FileAppenderBase::close();
 }
 
 
-FileAppender::FileAppender(
-    const Properties& props,
-    std::ios_base::openmode mode_)
-    : FileAppenderBase(props, mode_)
+void
+FileAppender::append(const spi::InternalLoggingEvent& event)
 {
-    init();
+    if (mmap_out || uring_out || direct_out)
+    {
+        directWrite (formatEvent (event));
+        return;
+    }
+
+    if (timestampIndex)
+        maybeIndexTimestamp (event.getTimestamp ());
+
+    FileAppenderBase::append (event);
 }
 
-FileAppender::~FileAppender()
+
+//! Appends a `<microseconds since epoch> <byte offset>` line to the
+//! sidecar index when the log has grown enough or the last entry is
+//! old enough. The byte trigger rides the bytesWritten statistic, so
+//! the hot path costs a relaxed load and two comparisons; the stream
+//! position is only queried when an entry is actually written.
+//! Called with access_mutex held, before the event is appended, so
+//! the recorded offset is where the event starts.
+void
+FileAppender::maybeIndexTimestamp (helpers::Time timestamp)
 {
-    destructorImpl();
+    unsigned long long const written = getBytesWrittenStat ();
+    if (written - ts_index_last_bytes
+            < static_cast<unsigned long long>(tsIndexByteInterval)
+        && timestamp - ts_index_last_time
+            < helpers::chrono::seconds (tsIndexTimeInterval))
+        return;
+
+    if (! out.good ())
+        return;
+
+    auto const offset = out.tellp ();
+    if (offset == -1)
+        return;
+
+    if (! ts_index_out.is_open ())
+    {
+        // Opened lazily so that the sidecar only appears once there
+        // is an entry to write. Truncated or appended to along with
+        // the log file itself.
+        tstring const index_name = filename + LOG4CPLUS_TEXT (".tsidx");
+        ts_index_out.open (
+            LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (index_name).c_str (),
+            std::ios_base::out
+            | ((fileOpenMode & std::ios_base::app) != 0
+                ? std::ios_base::app : std::ios_base::trunc));
+        if (! ts_index_out.good ())
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("Unable to open timestamp index: ")
+                + index_name);
+    }
+
+    if (ts_index_out.good ())
+    {
+        ts_index_out
+            << std::chrono::duration_cast<std::chrono::microseconds> (
+                timestamp.time_since_epoch ()).count ()
+            << LOG4CPLUS_TEXT (' ')
+            << static_cast<long long>(offset)
+            << LOG4CPLUS_TEXT ('\n');
+        ts_index_out.flush ();
+    }
+
+    ts_index_last_bytes = written;
+    ts_index_last_time = timestamp;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// FileAppender protected methods
-///////////////////////////////////////////////////////////////////////////////
 
 void
-FileAppender::init()
+FileAppender::appendBatch(const spi::InternalLoggingEvent* events,
+    std::size_t count)
 {
-    if (filename.empty())
+    if (mmap_out || uring_out || direct_out)
     {
-        getErrorHandler()->error( LOG4CPLUS_TEXT("Invalid filename") );
+        internal::appender_sratch_pad & appender_sp
+            = internal::get_appender_sp ();
+        detail::clear_tostringstream (appender_sp.oss);
+        layout->formatAndAppendBatch (appender_sp.oss, events, count);
+        appender_sp.str = appender_sp.oss.str ();
+        countBytesWritten (appender_sp.str.size ());
+        directWrite (appender_sp.str);
         return;
     }
 
-    FileAppenderBase::init();
+    if (timestampIndex && count > 0)
+        maybeIndexTimestamp (events[0].getTimestamp ());
+
+    FileAppenderBase::appendBatch (events, count);
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// RollingFileAppender ctors and dtor
-///////////////////////////////////////////////////////////////////////////////
 
-RollingFileAppender::RollingFileAppender(const tstring& filename_,
-    long maxFileSize_, int maxBackupIndex_, bool immediateFlush_,
-    bool createDirs_)
-    : FileAppender(filename_, std::ios_base::app, immediateFlush_, createDirs_)
+void
+FileAppender::mmapWrite (char const * data, std::size_t size)
 {
-    init(maxFileSize_, maxBackupIndex_);
+#if defined (LOG4CPLUS_HAVE_SYS_MMAN_H)
+    if (! mmap_out->write (data, size))
+    {
+        // Fall back to the stream based path for subsequent events.
+        getErrorHandler()->error(
+            LOG4CPLUS_TEXT("Failed to append to memory mapped file: ")
+            + filename);
+        mmap_out.reset ();
+    }
+#else
+    (void) data;
+    (void) size;
+#endif
 }
 
 
-RollingFileAppender::RollingFileAppender(const Properties& properties)
-    : FileAppender(properties, std::ios_base::app)
+void
+FileAppender::uringWrite (char const * data, std::size_t size)
 {
-    long tmpMaxFileSize = DEFAULT_ROLLING_LOG_SIZE;
-    int tmpMaxBackupIndex = 1;
+#if defined (LOG4CPLUS_USE_IO_URING)
+    if (! uring_out->write (data, size))
+    {
+        // Fall back to the stream based path for subsequent events.
+        getErrorHandler()->error(
+            LOG4CPLUS_TEXT("io_uring write failed for file: ")
+            + filename);
+        uring_out.reset ();
+    }
+#else
+    (void) data;
+    (void) size;
+#endif
+}
+
+
+void
+FileAppender::directIOWrite (char const * data, std::size_t size)
+{
+#if defined (LOG4CPLUS_USE_O_DIRECT)
+    if (! direct_out->write (data, size))
+    {
+        // Fall back to the stream based path for subsequent events.
+        getErrorHandler()->error(
+            LOG4CPLUS_TEXT("Direct I/O write failed for file: ")
+            + filename);
+        direct_out.reset ();
+    }
+#else
+    (void) data;
+    (void) size;
+#endif
+}
+
+
+void
+FileAppender::directWrite (tstring const & str)
+{
+#if defined (UNICODE)
+    std::string const chars (LOG4CPLUS_TSTRING_TO_STRING (str));
+    char const * const data = chars.c_str ();
+    std::size_t const size = chars.size ();
+#else
+    char const * const data = str.c_str ();
+    std::size_t const size = str.size ();
+#endif
+    if (mmap_out)
+        mmapWrite (data, size);
+    else if (uring_out)
+        uringWrite (data, size);
+    else
+        directIOWrite (data, size);
+}
+
+#if defined (LOG4CPLUS_WITH_ZLIB) && ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+//! Compresses just rotated backup files off the logging path. The
+//! queue is drained once more after the exit flag is raised so that
+//! close() does not lose pending work.
+class RollingFileAppender::CompressorThread
+    : public thread::AbstractThread
+{
+public:
+    explicit CompressorThread (
+        helpers::SharedObjectPtr<RollingFileAppender> appender_)
+        : appender (std::move (appender_))
+    { }
+
+    void run() override
+    {
+        while (true)
+        {
+            appender->compressor_wakeup.timed_wait (1000);
+            // Reset before draining: a file queued after the drain
+            // signals the event again and is seen next round.
+            appender->compressor_wakeup.reset ();
+
+            bool const exiting
+                = appender->compressor_exit.load (std::memory_order_acquire);
+
+            std::vector<tstring> batch;
+            {
+                thread::MutexGuard guard (appender->compress_queue_mutex);
+                batch.swap (appender->compress_queue);
+            }
+
+            for (tstring const & path : batch)
+                compress (path);
+
+            if (exiting)
+                break;
+        }
+    }
+
+private:
+    static void compress (tstring const & path)
+    {
+        helpers::LogLog & loglog = helpers::getLogLog ();
+        std::string const src (LOG4CPLUS_TSTRING_TO_STRING (path));
+        std::string const dst (src + ".gz");
+
+        std::ifstream in (src.c_str (),
+            std::ios_base::in | std::ios_base::binary);
+        if (! in.good ())
+        {
+            loglog.error (
+                LOG4CPLUS_TEXT ("Failed to open backup for compression: ")
+                + path);
+            return;
+        }
+
+        gzFile gz_out = gzopen (dst.c_str (), "wb");
+        if (! gz_out)
+        {
+            loglog.error (
+                LOG4CPLUS_TEXT ("Failed to create compressed backup: ")
+                + LOG4CPLUS_STRING_TO_TSTRING (dst));
+            return;
+        }
+
+        std::vector<char> buf (64 * 1024);
+        bool ok = true;
+        while (in)
+        {
+            in.read (buf.data (), static_cast<std::streamsize> (buf.size ()));
+            std::streamsize const n = in.gcount ();
+            if (n > 0
+                && gzwrite (gz_out, buf.data (),
+                    static_cast<unsigned> (n)) != n)
+            {
+                ok = false;
+                break;
+            }
+        }
+        if (gzclose (gz_out) != Z_OK)
+            ok = false;
+        in.close ();
+
+        if (ok)
+            file_remove (path);
+        else
+        {
+            loglog.error (
+                LOG4CPLUS_TEXT ("Failed compressing backup ") + path);
+            std::remove (dst.c_str ());
+        }
+    }
+
+    helpers::SharedObjectPtr<RollingFileAppender> appender;
+};
+
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RollingFileAppender ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+static
+long
+parse_max_file_size (helpers::Properties const & properties,
+    long default_value)
+{
+    long result = default_value;
     tstring tmp (
         helpers::toUpper (
             properties.getProperty (LOG4CPLUS_TEXT ("MaxFileSize"))));
     if (! tmp.empty ())
     {
-        tmpMaxFileSize = std::atoi(LOG4CPLUS_TSTRING_TO_STRING(tmp).c_str());
-        if (tmpMaxFileSize != 0)
+        result = std::atoi(LOG4CPLUS_TSTRING_TO_STRING(tmp).c_str());
+        if (result != 0)
         {
             tstring::size_type const len = tmp.length();
             if (len > 2
                 && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("MB")) == 0)
-                tmpMaxFileSize *= (1024 * 1024); // convert to megabytes
+                result *= (1024 * 1024); // convert to megabytes
             else if (len > 2
                 && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("KB")) == 0)
-                tmpMaxFileSize *= 1024; // convert to kilobytes
+                result *= 1024; // convert to kilobytes
         }
     }
+    return result;
+}
+
+
+RollingFileAppender::RollingFileAppender(const tstring& filename_,
+    long maxFileSize_, int maxBackupIndex_, bool immediateFlush_,
+    bool createDirs_)
+    : FileAppender(filename_, std::ios_base::app, immediateFlush_, createDirs_)
+{
+    init(maxFileSize_, maxBackupIndex_);
+}
+
+
+RollingFileAppender::RollingFileAppender(const Properties& properties)
+    : FileAppender(properties, std::ios_base::app)
+{
+    long tmpMaxFileSize
+        = parse_max_file_size (properties, DEFAULT_ROLLING_LOG_SIZE);
+    int tmpMaxBackupIndex = 1;
 
     properties.getInt (tmpMaxBackupIndex, LOG4CPLUS_TEXT("MaxBackupIndex"));
 
+    tstring const naming (
+        properties.getProperty (LOG4CPLUS_TEXT ("RolloverNaming")));
+    if (naming == LOG4CPLUS_TEXT ("Monotonic"))
+        monotonicNaming = true;
+    else if (! naming.empty () && naming != LOG4CPLUS_TEXT ("Shift"))
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("RollingFileAppender")
+            LOG4CPLUS_TEXT (" - Unknown RolloverNaming: ")
+            + naming);
+
+    tstring const compression (
+        helpers::toLower (
+            properties.getProperty (LOG4CPLUS_TEXT ("CompressBackups"))));
+    if (compression == LOG4CPLUS_TEXT ("gzip"))
+    {
+#if defined (LOG4CPLUS_WITH_ZLIB) && ! defined (LOG4CPLUS_SINGLE_THREADED)
+        if (monotonicNaming)
+            compressBackups = true;
+        else
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("CompressBackups requires")
+                LOG4CPLUS_TEXT (" RolloverNaming=Monotonic; ignoring."));
+#else
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("CompressBackups=gzip is not available")
+            LOG4CPLUS_TEXT (" in this build; ignoring."));
+#endif
+    }
+    else if (! compression.empty ()
+        && compression != LOG4CPLUS_TEXT ("none"))
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("RollingFileAppender")
+            LOG4CPLUS_TEXT (" - Unknown CompressBackups: ")
+            + compression);
+
+    if (properties.exists (LOG4CPLUS_TEXT ("RolloverStrategy")))
+    {
+        tstring const & factoryName
+            = properties.getProperty (LOG4CPLUS_TEXT ("RolloverStrategy"));
+        spi::RolloverStrategyFactory * factory
+            = spi::getRolloverStrategyFactoryRegistry ().get (factoryName);
+        if (factory == nullptr)
+        {
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("Cannot find RolloverStrategyFactory: \"")
+                + factoryName
+                + LOG4CPLUS_TEXT ("\""), true);
+        }
+
+        helpers::Properties const strategyProperties
+            = properties.getPropertySubset (
+                LOG4CPLUS_TEXT ("RolloverStrategy."));
+        try
+        {
+            rolloverStrategy = factory->createObject (strategyProperties);
+            if (! rolloverStrategy)
+            {
+                helpers::getLogLog ().error (
+                    LOG4CPLUS_TEXT ("Failed to create RolloverStrategy: ")
+                    + factoryName, true);
+            }
+        }
+        catch (std::exception const & e)
+        {
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("Error while creating RolloverStrategy: ")
+                + LOG4CPLUS_C_STR_TO_TSTRING (e.what ()), true);
+        }
+    }
+
     init(tmpMaxFileSize, tmpMaxBackupIndex);
 }
 
@@ -517,12 +2532,166 @@ RollingFileAppender::init(long maxFileSize_, int maxBackupIndex_)
 
     maxFileSize = maxFileSize_;
     maxBackupIndex = (std::max)(maxBackupIndex_, 1);
+
+    if (useMemoryMappedIO)
+    {
+        // Size based rollover relies on the output stream position and
+        // cannot see memory mapped appends.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("UseMemoryMappedIO is not supported by")
+            LOG4CPLUS_TEXT (" RollingFileAppender; ignoring."));
+        useMemoryMappedIO = false;
+        mmap_out.reset ();
+    }
+
+    if (useIOUring)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("UseIOUring is not supported by")
+            LOG4CPLUS_TEXT (" RollingFileAppender; ignoring."));
+        useIOUring = false;
+        uring_out.reset ();
+    }
+
+    if (timestampIndex)
+    {
+        // Rollover renames the file, invalidating recorded offsets.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("TimestampIndex is not supported by")
+            LOG4CPLUS_TEXT (" RollingFileAppender; ignoring."));
+        timestampIndex = false;
+    }
+
+    if (rolloverStrategy && (monotonicNaming || compressBackups))
+    {
+        // The strategy owns trigger, naming and cleanup; the built in
+        // backup machinery never runs.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("RolloverNaming and CompressBackups are")
+            LOG4CPLUS_TEXT (" ignored when a RolloverStrategy is")
+            LOG4CPLUS_TEXT (" configured."));
+        monotonicNaming = false;
+        compressBackups = false;
+    }
+
+    if (monotonicNaming)
+        scanMonotonicBackups ();
+
+    // Seed the running size counter from the freshly opened file.
+    out.seekp (0, std::ios_base::end);
+    currentFileSize = out.tellp ();
+
+#if defined (LOG4CPLUS_WITH_ZLIB) && ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (compressBackups)
+        initCompressor ();
+#endif
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (preOpenRolloverFile)
+        initSpareFile (maxFileSize);
+#endif
+}
+
+
+#if defined (LOG4CPLUS_WITH_ZLIB) && ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+void
+RollingFileAppender::initCompressor ()
+{
+    compressor_thread = new CompressorThread (
+        helpers::SharedObjectPtr<RollingFileAppender> (this));
+    compressor_thread->start ();
+}
+
+#endif
+
+
+//! Finds the highest index among existing backup files so that
+//! monotonic rollover continues the sequence after a restart. Since
+//! indices grow without bound, the surviving backups may sit
+//! arbitrarily far from 1; a directory listing is the only way to
+//! locate them without probing every index.
+void
+RollingFileAppender::scanMonotonicBackups()
+{
+    namespace fs = std::filesystem;
+
+    fs::path const log_path (filename);
+    fs::path dir = log_path.parent_path ();
+    if (dir.empty ())
+        dir = LOG4CPLUS_TEXT (".");
+
+    tstring const prefix
+        = log_path.filename ().string<tchar> () + LOG4CPLUS_TEXT (".");
+
+    long last_hit = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it (dir, ec), end;
+        ! ec && it != end; it.increment (ec))
+    {
+        tstring name = it->path ().filename ().string<tchar> ();
+        if (name.size () <= prefix.size ()
+            || name.compare (0, prefix.size (), prefix) != 0)
+            continue;
+
+        // Compressed backups keep their index in front of the
+        // compression suffix.
+        tstring const gz_suffix (LOG4CPLUS_TEXT (".gz"));
+        if (name.size () > gz_suffix.size ()
+            && name.compare (name.size () - gz_suffix.size (),
+                gz_suffix.size (), gz_suffix) == 0)
+            name.erase (name.size () - gz_suffix.size ());
+
+        // Only purely numeric suffixes belong to the rollover
+        // sequence; anything else (e.g. a date suffix) is someone
+        // else's file.
+        long index = 0;
+        bool numeric = true;
+        for (std::size_t i = prefix.size (); i != name.size (); ++i)
+        {
+            tchar const ch = name[i];
+            if (ch < LOG4CPLUS_TEXT ('0') || ch > LOG4CPLUS_TEXT ('9'))
+            {
+                numeric = false;
+                break;
+            }
+            index = index * 10 + (ch - LOG4CPLUS_TEXT ('0'));
+        }
+        if (numeric && index > last_hit)
+            last_hit = index;
+    }
+
+    nextRolloverIndex = last_hit + 1;
 }
 
 
 RollingFileAppender::~RollingFileAppender()
 {
-    destructorImpl();
+    destructorImpl();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RollingFileAppender public methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+RollingFileAppender::close()
+{
+#if defined (LOG4CPLUS_WITH_ZLIB) && ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // Let the compressor drain pending backups before the appender
+    // goes away; it holds a reference to this appender until then.
+    if (compressor_thread)
+    {
+        compressor_exit.store (true, std::memory_order_release);
+        compressor_wakeup.signal ();
+        if (compressor_thread->isRunning ())
+            compressor_thread->join ();
+        compressor_thread = nullptr;
+    }
+#endif
+
+    FileAppender::close();
 }
 
 
@@ -535,30 +2704,94 @@ RollingFileAppender::~RollingFileAppender()
 void
 RollingFileAppender::append(const spi::InternalLoggingEvent& event)
 {
-    // Seek to the end of log file so that tellp() below returns the
-    // right size.
+    if(!out.good()) {
+        if(!reopen()) {
+            getErrorHandler()->error(  LOG4CPLUS_TEXT("file is not open: ")
+                                     + filename);
+            return;
+        }
+        // Resets the error handler to make it
+        // ready to handle a future append error.
+        else
+        {
+            getErrorHandler()->reset();
+            out.seekp (0, std::ios_base::end);
+            currentFileSize = out.tellp ();
+        }
+    }
+
+    // Other processes may append to the shared file; reconcile the
+    // counter with the real size.
     if (useLockFile)
+    {
         out.seekp (0, std::ios_base::end);
+        currentFileSize = out.tellp ();
+    }
 
     // Rotate log file if needed before appending to it.
-    if (out.tellp() > maxFileSize)
+    if (shouldRollover (event))
         rollover(true);
 
-    FileAppender::append(event);
+    if (recordFraming)
+        currentFileSize += static_cast<long long> (appendFramed (event));
+    else
+    {
+        // Format into the per-thread scratch buffer first so that the
+        // number of characters written is known without querying the
+        // stream position, which can cost an lseek() per event on some
+        // standard library and file system combinations.
+        tstring const & str = formatEvent (event);
+        out.write (str.data (), static_cast<std::streamsize> (str.size ()));
+        currentFileSize += static_cast<long long> (str.size ());
+    }
+
+    if(immediateFlush || useLockFile)
+        out.flush();
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    else if (flusher_thread)
+        appends_since_flush.fetch_add (1, std::memory_order_relaxed);
+#endif
+    if (LOG4CPLUS_UNLIKELY (syncGroupSize != 0 || syncIntervalMillis != 0))
+        accountEventsForSync (1);
 
     // Rotate log file if needed after appending to it.
-    if (out.tellp() > maxFileSize)
+    if (shouldRollover (event))
         rollover(true);
 }
 
 
+bool
+RollingFileAppender::shouldRollover (const spi::InternalLoggingEvent& event)
+{
+    if (rolloverStrategy)
+        return rolloverStrategy->shouldRollover (
+            RolloverStrategy::Status {filename, currentFileSize,
+                event.getTimestamp ()});
+
+    return currentFileSize > maxFileSize;
+}
+
+
+void
+RollingFileAppender::appendBatch(const spi::InternalLoggingEvent* events,
+    std::size_t count)
+{
+    // Deliver events one by one so that the rollover size checks keep
+    // their per event granularity.
+    Appender::appendBatch(events, count);
+}
+
+
 void
 RollingFileAppender::rollover(bool alreadyLocked)
 {
+    LOG4CPLUS_TRACEPOINT1 (rollover, filename.c_str ());
+
     helpers::LogLog & loglog = helpers::getLogLog();
     helpers::LockFileGuard guard;
 
-    // Close the current file
+    // Finish and close the current file
+    writeFooter ();
     out.close();
     // Reset flags since the C++ standard specified that all the flags
     // should remain unchanged on a close.
@@ -579,11 +2812,14 @@ RollingFileAppender::rollover(bool alreadyLocked)
         }
 
         // Recheck the condition as there is a window where another
-        // process can rollover the file before us.
+        // process can rollover the file before us. A configured
+        // strategy's trigger may be unrelated to size, so the recheck
+        // only applies to the built in size trigger.
 
         helpers::FileInfo fi;
-        if (getFileInfo (&fi, filename) == -1
-            || fi.size < maxFileSize)
+        if (! rolloverStrategy
+            && (getFileInfo (&fi, filename) == -1
+                || fi.size < maxFileSize))
         {
             // The file has already been rolled by another
             // process. Just reopen with the new file.
@@ -591,13 +2827,88 @@ RollingFileAppender::rollover(bool alreadyLocked)
             // Open it up again.
             open (std::ios_base::out | std::ios_base::ate | std::ios_base::app);
             loglog_opening_result (loglog, out, filename);
+            out.seekp (0, std::ios_base::end);
+            currentFileSize = out.tellp ();
 
             return;
         }
     }
 
+    if (rolloverStrategy)
+    {
+        // The strategy names the archive and prunes what this
+        // rollover made obsolete; the appender only performs the
+        // rename.
+        RolloverStrategy::Status const status {filename, currentFileSize,
+            helpers::now ()};
+        tstring const target (rolloverStrategy->archiveFilename (status));
+
+        long ret;
+
+#if defined (_WIN32)
+        // Try to remove the target first. It seems it is not
+        // possible to rename over existing file.
+        ret = file_remove (target);
+#endif
+
+        loglog.debug (
+            LOG4CPLUS_TEXT("Renaming file ")
+            + filename
+            + LOG4CPLUS_TEXT(" to ")
+            + target);
+        ret = file_rename (filename, target);
+        loglog_renaming_result (loglog, filename, target, ret);
+
+        rolloverStrategy->cleanup (status);
+    }
     // If maxBackups <= 0, then there is no file renaming to be done.
-    if (maxBackupIndex > 0)
+    else if (maxBackupIndex > 0 && monotonicNaming)
+    {
+        // A single rename plus at most one removal keeps the lock
+        // hold time constant regardless of maxBackupIndex.
+        tostringstream target_oss;
+        target_oss << filename << LOG4CPLUS_TEXT(".") << nextRolloverIndex;
+        tstring const target (target_oss.str ());
+
+        long ret;
+
+#if defined (_WIN32)
+        // Try to remove the target first. It seems it is not
+        // possible to rename over existing file.
+        ret = file_remove (target);
+#endif
+
+        loglog.debug (
+            LOG4CPLUS_TEXT("Renaming file ")
+            + filename
+            + LOG4CPLUS_TEXT(" to ")
+            + target);
+        ret = file_rename (filename, target);
+        loglog_renaming_result (loglog, filename, target, ret);
+
+        long const obsolete = nextRolloverIndex - maxBackupIndex;
+        ++nextRolloverIndex;
+        if (obsolete >= 1)
+        {
+            tostringstream obsolete_oss;
+            obsolete_oss << filename << LOG4CPLUS_TEXT(".") << obsolete;
+            // The obsolete backup may sit either plain or compressed.
+            file_remove (obsolete_oss.str ());
+            file_remove (obsolete_oss.str () + LOG4CPLUS_TEXT (".gz"));
+        }
+
+#if defined (LOG4CPLUS_WITH_ZLIB) && ! defined (LOG4CPLUS_SINGLE_THREADED)
+        if (compressor_thread)
+        {
+            {
+                thread::MutexGuard guard (compress_queue_mutex);
+                compress_queue.push_back (target);
+            }
+            compressor_wakeup.signal ();
+        }
+#endif
+    }
+    else if (maxBackupIndex > 0)
     {
         rolloverFiles(filename, maxBackupIndex);
 
@@ -625,9 +2936,20 @@ RollingFileAppender::rollover(bool alreadyLocked)
         loglog.debug (filename + LOG4CPLUS_TEXT(" has no backups specified"));
     }
 
-    // Open it up again in truncation mode
-    open(std::ios::out | std::ios::trunc);
-    loglog_opening_result (loglog, out, filename);
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // A pre-opened spare file masks open() latency on slow
+    // filesystems; fall back to a plain open() when none is ready.
+    if (! adoptSpareFile ())
+#endif
+    {
+        // Open it up again in truncation mode
+        open(std::ios::out | std::ios::trunc);
+        loglog_opening_result (loglog, out, filename);
+    }
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    requestSpareFile ();
+#endif
+    currentFileSize = 0;
 }
 
 
@@ -745,6 +3067,34 @@ DailyRollingFileAppender::init(DailyRollingFileSchedule sch)
     Time now = helpers::truncate_fractions (helpers::now ());
     scheduledFilename = getFilename(now);
     nextRolloverTime = calculateNextRolloverTime(now);
+
+    if (useMemoryMappedIO)
+    {
+        // Rollover re-opens the output stream underneath the mapping.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("UseMemoryMappedIO is not supported by")
+            LOG4CPLUS_TEXT (" DailyRollingFileAppender; ignoring."));
+        useMemoryMappedIO = false;
+        mmap_out.reset ();
+    }
+
+    if (useIOUring)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("UseIOUring is not supported by")
+            LOG4CPLUS_TEXT (" DailyRollingFileAppender; ignoring."));
+        useIOUring = false;
+        uring_out.reset ();
+    }
+
+    if (timestampIndex)
+    {
+        // Rollover renames the file, invalidating recorded offsets.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("TimestampIndex is not supported by")
+            LOG4CPLUS_TEXT (" DailyRollingFileAppender; ignoring."));
+        timestampIndex = false;
+    }
 }
 
 
@@ -788,10 +3138,39 @@ DailyRollingFileAppender::append(const spi::InternalLoggingEvent& event)
 }
 
 
+void
+DailyRollingFileAppender::appendBatch(const spi::InternalLoggingEvent* events,
+    std::size_t count)
+{
+    // The cached rollover instant makes the rollover check a single
+    // comparison, so scan the batch first: when no event reaches
+    // nextRolloverTime, the whole batch can be formatted and written
+    // in one call.
+    bool crosses = false;
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        if (events[i].getTimestamp () >= nextRolloverTime)
+        {
+            crosses = true;
+            break;
+        }
+    }
+
+    if (crosses)
+        // Deliver events one by one so that the rollover time checks
+        // keep their per event granularity.
+        Appender::appendBatch(events, count);
+    else
+        FileAppender::appendBatch(events, count);
+}
+
+
 
 void
 DailyRollingFileAppender::rollover(bool alreadyLocked)
 {
+    LOG4CPLUS_TRACEPOINT1 (rollover, filename.c_str ());
+
     helpers::LockFileGuard guard;
 
     if (useLockFile && ! alreadyLocked)
@@ -806,7 +3185,8 @@ DailyRollingFileAppender::rollover(bool alreadyLocked)
         }
     }
 
-    // Close the current file
+    // Finish and close the current file
+    writeFooter ();
     out.close();
     // reset flags since the C++ standard specified that all the flags
     // should remain unchanged on a close
@@ -1037,47 +3417,45 @@ DailyRollingFileAppender::calculateNextRolloverTime(const Time& t) const
 }
 
 
-tstring
-DailyRollingFileAppender::getFilename(const Time& t) const
+static
+tchar const *
+schedule_date_pattern (DailyRollingFileSchedule schedule)
 {
-    tchar const * pattern = nullptr;
-    if (datePattern.empty())
+    switch (schedule)
     {
-        switch (schedule)
-        {
-        case MONTHLY:
-            pattern = LOG4CPLUS_TEXT("%Y-%m");
-            break;
+    case MONTHLY:
+        return LOG4CPLUS_TEXT("%Y-%m");
 
-        case WEEKLY:
-            pattern = LOG4CPLUS_TEXT("%Y-%W");
-            break;
+    case WEEKLY:
+        return LOG4CPLUS_TEXT("%Y-%W");
 
-        default:
-            helpers::getLogLog ().error (
-                LOG4CPLUS_TEXT ("DailyRollingFileAppender::getFilename()-")
-                LOG4CPLUS_TEXT (" invalid schedule value"));
-            [[fallthrough]];
+    default:
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("schedule_date_pattern()-")
+            LOG4CPLUS_TEXT (" invalid schedule value"));
+        [[fallthrough]];
 
-        case DAILY:
-            pattern = LOG4CPLUS_TEXT("%Y-%m-%d");
-            break;
+    case DAILY:
+        return LOG4CPLUS_TEXT("%Y-%m-%d");
 
-        case TWICE_DAILY:
-            pattern = LOG4CPLUS_TEXT("%Y-%m-%d-%p");
-            break;
+    case TWICE_DAILY:
+        return LOG4CPLUS_TEXT("%Y-%m-%d-%p");
 
-        case HOURLY:
-            pattern = LOG4CPLUS_TEXT("%Y-%m-%d-%H");
-            break;
+    case HOURLY:
+        return LOG4CPLUS_TEXT("%Y-%m-%d-%H");
 
-        case MINUTELY:
-            pattern = LOG4CPLUS_TEXT("%Y-%m-%d-%H-%M");
-            break;
-        };
-    }
-    else
-        pattern = datePattern.c_str();
+    case MINUTELY:
+        return LOG4CPLUS_TEXT("%Y-%m-%d-%H-%M");
+    };
+}
+
+
+tstring
+DailyRollingFileAppender::getFilename(const Time& t) const
+{
+    tchar const * const pattern = datePattern.empty()
+        ? schedule_date_pattern (schedule)
+        : datePattern.c_str();
 
     tstring result (filename);
     result += LOG4CPLUS_TEXT(".");
@@ -1085,6 +3463,191 @@ DailyRollingFileAppender::getFilename(const Time& t) const
     return result;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// RolloverStrategy ctor and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+RolloverStrategy::RolloverStrategy () = default;
+
+RolloverStrategy::~RolloverStrategy () = default;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SizeOrTimeRolloverStrategy ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+static
+Time::duration
+rollover_period_duration (DailyRollingFileSchedule schedule)
+{
+    switch (schedule)
+    {
+    case MONTHLY:
+        return std::chrono::hours{31*24};
+    case WEEKLY:
+        return std::chrono::hours{7*24};
+    default:
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("rollover_period_duration()-")
+            LOG4CPLUS_TEXT (" invalid schedule value"));
+        [[fallthrough]];
+    case DAILY:
+        return std::chrono::hours{24};
+    case TWICE_DAILY:
+        return std::chrono::hours{12};
+    case HOURLY:
+        return std::chrono::hours{1};
+    case MINUTELY:
+        return std::chrono::minutes{1};
+    }
+}
+
+
+SizeOrTimeRolloverStrategy::SizeOrTimeRolloverStrategy (
+    const helpers::Properties& properties)
+    : maxFileSize (parse_max_file_size (properties, DEFAULT_ROLLING_LOG_SIZE))
+    , schedule (WEEKLY)
+    , maxHistory (10)
+{
+    if (maxFileSize < MINIMUM_ROLLING_LOG_SIZE)
+    {
+        tostringstream oss;
+        oss << LOG4CPLUS_TEXT ("SizeOrTimeRolloverStrategy: MaxFileSize")
+            LOG4CPLUS_TEXT (" property value is too small. Resetting to ")
+            << MINIMUM_ROLLING_LOG_SIZE << ".";
+        helpers::getLogLog ().warn (oss.str ());
+        maxFileSize = MINIMUM_ROLLING_LOG_SIZE;
+    }
+
+    tstring const scheduleStr (helpers::toUpper (
+        properties.getProperty (LOG4CPLUS_TEXT ("Schedule"))));
+
+    if (scheduleStr.empty ()
+        || scheduleStr == LOG4CPLUS_TEXT("WEEKLY"))
+        schedule = WEEKLY;
+    else if (scheduleStr == LOG4CPLUS_TEXT("MONTHLY"))
+        schedule = MONTHLY;
+    else if (scheduleStr == LOG4CPLUS_TEXT("DAILY"))
+        schedule = DAILY;
+    else if (scheduleStr == LOG4CPLUS_TEXT("TWICE_DAILY"))
+        schedule = TWICE_DAILY;
+    else if (scheduleStr == LOG4CPLUS_TEXT("HOURLY"))
+        schedule = HOURLY;
+    else if (scheduleStr == LOG4CPLUS_TEXT("MINUTELY"))
+        schedule = MINUTELY;
+    else
+    {
+        helpers::getLogLog().warn(
+            LOG4CPLUS_TEXT("SizeOrTimeRolloverStrategy::ctor()")
+            LOG4CPLUS_TEXT("- \"Schedule\" not valid: ")
+            + properties.getProperty(LOG4CPLUS_TEXT("Schedule")));
+        schedule = WEEKLY;
+    }
+
+    properties.getInt (maxHistory, LOG4CPLUS_TEXT ("MaxHistory"));
+
+    nextRolloverTime = helpers::truncate_fractions (
+        log4cplus::calculateNextRolloverTime (helpers::now (), schedule));
+}
+
+
+SizeOrTimeRolloverStrategy::~SizeOrTimeRolloverStrategy () = default;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SizeOrTimeRolloverStrategy public methods
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+SizeOrTimeRolloverStrategy::shouldRollover (const Status& status)
+{
+    return status.fileSize > maxFileSize
+        || status.time >= nextRolloverTime;
+}
+
+
+tstring
+SizeOrTimeRolloverStrategy::archiveFilename (const Status& status)
+{
+    tstring stem (status.filename);
+    stem += LOG4CPLUS_TEXT(".");
+    stem += helpers::getFormattedTime (schedule_date_pattern (schedule),
+        status.time, false);
+
+    if (stem != periodStem)
+    {
+        // Entering a new schedule period. Never overwrite archives
+        // left by a previous run; resume the index past them.
+        periodStem = stem;
+        nextIndexInPeriod = 1;
+        helpers::FileInfo fi;
+        for (;;)
+        {
+            tostringstream oss;
+            oss << periodStem << LOG4CPLUS_TEXT(".") << nextIndexInPeriod;
+            if (getFileInfo (&fi, oss.str ()) == -1)
+                break;
+            ++nextIndexInPeriod;
+        }
+    }
+
+    // Advance the time trigger when this rollover crossed it; a size
+    // triggered rollover leaves it in place.
+    if (status.time >= nextRolloverTime)
+        nextRolloverTime = helpers::truncate_fractions (
+            log4cplus::calculateNextRolloverTime (status.time, schedule));
+
+    tostringstream oss;
+    oss << periodStem << LOG4CPLUS_TEXT(".") << nextIndexInPeriod;
+    ++nextIndexInPeriod;
+    return oss.str ();
+}
+
+
+void
+SizeOrTimeRolloverStrategy::cleanup (const Status& status)
+{
+    if (maxHistory <= 0)
+        return;
+
+    // One schedule period falls out of the retention window per
+    // elapsed period, so sweep the periods elapsed since the last
+    // cleanup; the first cleanup sweeps a generous backlog instead.
+    // The fixed per period duration is an approximation, which is
+    // good enough to reconstruct the stems of expired periods.
+    Time::duration const period = rollover_period_duration (schedule);
+    long periods;
+    if (lastCleanupTime == Time ())
+        periods = 32;
+    else
+        periods = static_cast<long>(
+            (status.time - lastCleanupTime).count () / period.count ()) + 1;
+    lastCleanupTime = status.time;
+
+    helpers::LogLog & loglog = helpers::getLogLog ();
+    for (long p = 0; p != periods; ++p)
+    {
+        Time const expired
+            = status.time - (maxHistory + 1 + p) * period;
+        tstring stem (status.filename);
+        stem += LOG4CPLUS_TEXT(".");
+        stem += helpers::getFormattedTime (schedule_date_pattern (schedule),
+            expired, false);
+
+        for (long i = 1; ; ++i)
+        {
+            tostringstream oss;
+            oss << stem << LOG4CPLUS_TEXT(".") << i;
+            tstring const victim (oss.str ());
+            if (file_remove (victim) != 0)
+                break;
+            loglog.debug (
+                LOG4CPLUS_TEXT ("Removed obsolete archive ") + victim);
+        }
+    }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // TimeBasedRollingFileAppender utility functions
 ///////////////////////////////////////////////////////////////////////////////
@@ -1262,8 +3825,55 @@ preprocessFilenamePattern(const tstring_view& pattern, DailyRollingFileSchedule&
         }
     }
 
-    return result.str();
-}
+    return result.str();
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+//! Removes obsolete archive files off the logging path. The queue is
+//! drained once more after the exit flag is raised so that close()
+//! does not lose pending work.
+class TimeBasedRollingFileAppender::CleanerThread
+    : public thread::AbstractThread
+{
+public:
+    explicit CleanerThread (
+        helpers::SharedObjectPtr<TimeBasedRollingFileAppender> appender_)
+        : appender (std::move (appender_))
+    { }
+
+    void run() override
+    {
+        while (true)
+        {
+            appender->cleaner_wakeup.timed_wait (1000);
+            // Reset before draining: a file queued after the drain
+            // signals the event again and is seen next round.
+            appender->cleaner_wakeup.reset ();
+
+            bool const exiting
+                = appender->cleaner_exit.load (std::memory_order_acquire);
+
+            std::vector<tstring> batch;
+            {
+                thread::MutexGuard guard (appender->clean_queue_mutex);
+                batch.swap (appender->clean_queue);
+            }
+
+            for (tstring const & path : batch)
+                file_remove (path);
+
+            if (exiting)
+                break;
+        }
+    }
+
+private:
+    helpers::SharedObjectPtr<TimeBasedRollingFileAppender> appender;
+};
+
+#endif
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1336,6 +3946,11 @@ TimeBasedRollingFileAppender::init()
     }
 
     lastHeartBeat = now;
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (preOpenRolloverFile)
+        initSpareFile (0);
+#endif
 }
 
 void
@@ -1348,6 +3963,33 @@ TimeBasedRollingFileAppender::append(const spi::InternalLoggingEvent& event)
     FileAppenderBase::append(event);
 }
 
+
+void
+TimeBasedRollingFileAppender::appendBatch(
+    const spi::InternalLoggingEvent* events, std::size_t count)
+{
+    // The cached rollover instant makes the rollover check a single
+    // comparison, so scan the batch first: when no event reaches
+    // nextRolloverTime, the whole batch can be formatted and written
+    // in one call.
+    bool crosses = false;
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        if (events[i].getTimestamp () >= nextRolloverTime)
+        {
+            crosses = true;
+            break;
+        }
+    }
+
+    if (crosses)
+        // Deliver events one by one so that the rollover time checks
+        // keep their per event granularity.
+        Appender::appendBatch(events, count);
+    else
+        FileAppenderBase::appendBatch(events, count);
+}
+
 void
 TimeBasedRollingFileAppender::open(std::ios_base::openmode mode)
 {
@@ -1371,12 +4013,28 @@ TimeBasedRollingFileAppender::close()
 {
     if (rollOnClose)
         rollover();
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // Let the cleaner drain pending removals before the appender goes
+    // away; it holds a reference to this appender until then.
+    if (cleaner_thread)
+    {
+        cleaner_exit.store (true, std::memory_order_release);
+        cleaner_wakeup.signal ();
+        if (cleaner_thread->isRunning ())
+            cleaner_thread->join ();
+        cleaner_thread = nullptr;
+    }
+#endif
+
     FileAppenderBase::close();
 }
 
 void
 TimeBasedRollingFileAppender::rollover(bool alreadyLocked)
 {
+    LOG4CPLUS_TRACEPOINT1 (rollover, filename.c_str ());
+
     helpers::LockFileGuard guard;
 
     if (useLockFile && ! alreadyLocked)
@@ -1391,7 +4049,8 @@ TimeBasedRollingFileAppender::rollover(bool alreadyLocked)
         }
     }
 
-    // Close the current file
+    // Finish and close the current file
+    writeFooter ();
     out.close();
     // reset flags since the C++ standard specified that all the flags
     // should remain unchanged on a close
@@ -1420,7 +4079,18 @@ TimeBasedRollingFileAppender::rollover(bool alreadyLocked)
     Time now = helpers::now();
     clean(now);
 
-    open(std::ios::out | std::ios::trunc);
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // A pre-opened spare file masks open() latency on slow
+    // filesystems; fall back to a plain open() when none is ready.
+    if (adoptSpareFile ())
+        scheduledFilename
+            = helpers::getFormattedTime(filenamePattern, now, false);
+    else
+#endif
+        open(std::ios::out | std::ios::trunc);
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    requestSpareFile ();
+#endif
 
     nextRolloverTime = calculateNextRolloverTime(now);
 }
@@ -1437,40 +4107,44 @@ TimeBasedRollingFileAppender::clean(Time time)
     Time::duration period = getRolloverPeriodDuration();
     long periods = long(interval.count () / period.count ());
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    // The cleaner thread is started lazily so that appenders that
+    // never roll over do not pay for it.
+    if (periods > 0 && ! cleaner_thread)
+        initCleaner ();
+#endif
+
     helpers::LogLog & loglog = helpers::getLogLog();
     for (long i = 0; i < periods; i++)
     {
         long periodToRemove = (-maxHistory - 1) - i;
         Time timeToRemove = time + periodToRemove * period;
         tstring filenameToRemove = helpers::getFormattedTime(filenamePattern, timeToRemove, false);
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        loglog.debug(LOG4CPLUS_TEXT("Queuing file for removal: ")
+            + filenameToRemove);
+        {
+            thread::MutexGuard guard (clean_queue_mutex);
+            clean_queue.push_back (std::move (filenameToRemove));
+        }
+#else
         loglog.debug(LOG4CPLUS_TEXT("Removing file ") + filenameToRemove);
         file_remove(filenameToRemove);
+#endif
     }
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (periods > 0)
+        cleaner_wakeup.signal ();
+#endif
+
     lastHeartBeat = time;
 }
 
 Time::duration
 TimeBasedRollingFileAppender::getRolloverPeriodDuration() const
 {
-    switch (schedule)
-    {
-    case MONTHLY:
-        return std::chrono::hours{31*24};
-    case WEEKLY:
-        return std::chrono::hours{7*24};
-    default:
-        helpers::getLogLog ().error (
-            LOG4CPLUS_TEXT ("TimeBasedRollingFileAppender::getRolloverPeriodDuration()-")
-            LOG4CPLUS_TEXT (" invalid schedule value"));
-        [[fallthrough]];
-    case DAILY:
-        return std::chrono::hours{24};
-    case HOURLY:
-        return std::chrono::hours{1};
-    case MINUTELY:
-        return std::chrono::minutes{1};
-    }
+    return rollover_period_duration (schedule);
 }
 
 Time
@@ -1481,6 +4155,424 @@ TimeBasedRollingFileAppender::calculateNextRolloverTime(const Time& t) const
 }
 
 
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+void
+TimeBasedRollingFileAppender::initCleaner ()
+{
+    cleaner_thread = new CleanerThread (
+        helpers::SharedObjectPtr<TimeBasedRollingFileAppender> (this));
+    cleaner_thread->start ();
+}
+
+#endif
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+//! Creates the next chunk file ahead of rollover and, where the
+//! platform supports it, reserves its blocks up front, so that
+//! switching chunks on the logging path is just an open() of an
+//! already existing file.
+class ChunkedFileAppender::PreallocThread
+    : public thread::AbstractThread
+{
+public:
+    explicit PreallocThread (
+        helpers::SharedObjectPtr<ChunkedFileAppender> appender_)
+        : appender (std::move (appender_))
+    { }
+
+    void run() override
+    {
+        while (true)
+        {
+            appender->prealloc_wakeup.timed_wait (1000);
+            appender->prealloc_wakeup.reset ();
+
+            if (appender->prealloc_exit.load (std::memory_order_acquire))
+                break;
+
+            long const index = appender->prealloc_index.exchange (0,
+                std::memory_order_relaxed);
+            if (index != 0)
+                preallocate (appender->chunkFilename (index),
+                    appender->maxChunkSize);
+        }
+    }
+
+private:
+    static void preallocate (tstring const & path, long size);
+
+    helpers::SharedObjectPtr<ChunkedFileAppender> appender;
+};
+
+
+void
+ChunkedFileAppender::PreallocThread::preallocate (tstring const & path,
+    long size)
+{
+#if defined (LOG4CPLUS_USE_FALLOCATE)
+    // FALLOC_FL_KEEP_SIZE reserves the blocks without changing the
+    // file size, so appends into the chunk still land at offset zero.
+    int const fd = ::open (LOG4CPLUS_TSTRING_TO_STRING (path).c_str (),
+        O_WRONLY | O_CREAT, 0644);
+    if (fd == -1)
+        return;
+
+    // Not all file systems support fallocate(); the pre-created
+    // empty file is still useful on those that do not.
+    (void) ::fallocate (fd, FALLOC_FL_KEEP_SIZE, 0,
+        static_cast<off_t>(size));
+    ::close (fd);
+#else
+    // Just pre-create the file so that rollover's open() does not
+    // have to.
+    (void) size;
+    tofstream touch (LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME (path).c_str (),
+        std::ios_base::out | std::ios_base::app);
+#endif
+}
+
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ChunkedFileAppender ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+ChunkedFileAppender::ChunkedFileAppender(const tstring& filename_,
+    long maxChunkSize_, bool immediateFlush_, bool createDirs_)
+    : FileAppenderBase(filename_, std::ios_base::app, immediateFlush_,
+        createDirs_)
+{
+    init(maxChunkSize_);
+}
+
+
+ChunkedFileAppender::ChunkedFileAppender(const Properties& properties)
+    : FileAppenderBase(properties, std::ios_base::app)
+{
+    long tmpMaxChunkSize = DEFAULT_CHUNK_SIZE;
+    tstring tmp (
+        helpers::toUpper (
+            properties.getProperty (LOG4CPLUS_TEXT ("MaxChunkSize"))));
+    if (! tmp.empty ())
+    {
+        tmpMaxChunkSize = std::atoi(LOG4CPLUS_TSTRING_TO_STRING(tmp).c_str());
+        if (tmpMaxChunkSize != 0)
+        {
+            tstring::size_type const len = tmp.length();
+            if (len > 2
+                && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("MB")) == 0)
+                tmpMaxChunkSize *= (1024 * 1024); // convert to megabytes
+            else if (len > 2
+                && tmp.compare (len - 2, 2, LOG4CPLUS_TEXT("KB")) == 0)
+                tmpMaxChunkSize *= 1024; // convert to kilobytes
+        }
+    }
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    properties.getBool (preallocateNextChunk,
+        LOG4CPLUS_TEXT("PreallocateNextChunk"));
+#else
+    bool prealloc = false;
+    properties.getBool (prealloc, LOG4CPLUS_TEXT("PreallocateNextChunk"));
+    if (prealloc)
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("PreallocateNextChunk is ignored")
+            LOG4CPLUS_TEXT (" in single threaded builds."));
+#endif
+
+    init(tmpMaxChunkSize);
+}
+
+
+void
+ChunkedFileAppender::init(long maxChunkSize_)
+{
+    if (maxChunkSize_ < MINIMUM_ROLLING_LOG_SIZE)
+    {
+        tostringstream oss;
+        oss << LOG4CPLUS_TEXT ("ChunkedFileAppender: MaxChunkSize property")
+            LOG4CPLUS_TEXT (" value is too small. Resetting to ")
+            << MINIMUM_ROLLING_LOG_SIZE << ".";
+        helpers::getLogLog ().warn (oss.str ());
+        maxChunkSize_ = MINIMUM_ROLLING_LOG_SIZE;
+    }
+
+    maxChunkSize = maxChunkSize_;
+
+    if (useLockFile)
+    {
+        // The chunk index is process local state; two processes
+        // sharing the sequence would race each other to the same
+        // index.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("UseLockFile is not supported by")
+            LOG4CPLUS_TEXT (" ChunkedFileAppender; ignoring."));
+        useLockFile = false;
+    }
+
+    // Continue the sequence after the highest existing chunk, so
+    // that finished chunks and their footers are never touched
+    // again.
+    scanExistingChunks ();
+
+    FileAppenderBase::init ();
+
+    out.seekp (0, std::ios_base::end);
+    currentChunkSize = out.tellp ();
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (preallocateNextChunk)
+        initPrealloc ();
+#endif
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+void
+ChunkedFileAppender::initPrealloc ()
+{
+    prealloc_thread = new PreallocThread (
+        helpers::SharedObjectPtr<ChunkedFileAppender> (this));
+    prealloc_thread->start ();
+
+    // Get a head start on the chunk following the current one.
+    prealloc_index.store (currentChunkIndex + 1, std::memory_order_relaxed);
+    prealloc_wakeup.signal ();
+}
+
+#endif
+
+
+tstring
+ChunkedFileAppender::chunkFilename(long index) const
+{
+    tostringstream oss;
+    oss << filename << LOG4CPLUS_TEXT(".") << index;
+    return oss.str ();
+}
+
+
+//! Finds the highest index among existing chunk files so that the
+//! sequence continues after a restart. Since indices grow without
+//! bound, a directory listing is the only way to locate the tail of
+//! the sequence without probing every index.
+void
+ChunkedFileAppender::scanExistingChunks()
+{
+    namespace fs = std::filesystem;
+
+    fs::path const log_path (filename);
+    fs::path dir = log_path.parent_path ();
+    if (dir.empty ())
+        dir = LOG4CPLUS_TEXT (".");
+
+    tstring const prefix
+        = log_path.filename ().string<tchar> () + LOG4CPLUS_TEXT (".");
+
+    long last_hit = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it (dir, ec), end;
+        ! ec && it != end; it.increment (ec))
+    {
+        tstring const name = it->path ().filename ().string<tchar> ();
+        if (name.size () <= prefix.size ()
+            || name.compare (0, prefix.size (), prefix) != 0)
+            continue;
+
+        // Only purely numeric suffixes belong to the chunk sequence;
+        // anything else is someone else's file.
+        long index = 0;
+        bool numeric = true;
+        for (std::size_t i = prefix.size (); i != name.size (); ++i)
+        {
+            tchar const ch = name[i];
+            if (ch < LOG4CPLUS_TEXT ('0') || ch > LOG4CPLUS_TEXT ('9'))
+            {
+                numeric = false;
+                break;
+            }
+            index = index * 10 + (ch - LOG4CPLUS_TEXT ('0'));
+        }
+        if (numeric && index > last_hit)
+            last_hit = index;
+    }
+
+    currentChunkIndex = last_hit + 1;
+}
+
+
+ChunkedFileAppender::~ChunkedFileAppender()
+{
+    destructorImpl();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ChunkedFileAppender public methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+ChunkedFileAppender::close()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (prealloc_thread)
+    {
+        prealloc_exit.store (true, std::memory_order_release);
+        prealloc_wakeup.signal ();
+        if (prealloc_thread->isRunning ())
+            prealloc_thread->join ();
+        prealloc_thread = nullptr;
+    }
+#endif
+
+    {
+        thread::MutexGuard guard (access_mutex);
+        // The chunk being written is complete once the appender
+        // closes; give it its footer.
+        finishChunk ();
+    }
+
+    FileAppenderBase::close();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ChunkedFileAppender protected methods
+///////////////////////////////////////////////////////////////////////////////
+
+// This method does not need to be locked since it is called by
+// doAppend() which performs the locking
+void
+ChunkedFileAppender::append(const spi::InternalLoggingEvent& event)
+{
+    if(!out.good()) {
+        if(!reopen()) {
+            getErrorHandler()->error(  LOG4CPLUS_TEXT("file is not open: ")
+                                     + chunkFilename (currentChunkIndex));
+            return;
+        }
+        // Resets the error handler to make it
+        // ready to handle a future append error.
+        else
+        {
+            getErrorHandler()->reset();
+            out.seekp (0, std::ios_base::end);
+            currentChunkSize = out.tellp ();
+        }
+    }
+
+    if (recordFraming)
+        currentChunkSize += static_cast<long long> (appendFramed (event));
+    else
+    {
+        // Format into the per-thread scratch buffer first so that the
+        // number of characters written is known without querying the
+        // stream position.
+        tstring const & str = formatEvent (event);
+        out.write (str.data (), static_cast<std::streamsize> (str.size ()));
+        currentChunkSize += static_cast<long long> (str.size ());
+    }
+    ++currentChunkEvents;
+
+    if(immediateFlush)
+        out.flush();
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    else if (flusher_thread)
+        appends_since_flush.fetch_add (1, std::memory_order_relaxed);
+#endif
+    if (LOG4CPLUS_UNLIKELY (syncGroupSize != 0 || syncIntervalMillis != 0))
+        accountEventsForSync (1);
+
+    // Move on to the next chunk once this one has reached its size.
+    if (currentChunkSize >= maxChunkSize)
+        rollover();
+}
+
+
+void
+ChunkedFileAppender::appendBatch(const spi::InternalLoggingEvent* events,
+    std::size_t count)
+{
+    // Deliver events one by one so that the chunk size check keeps
+    // its per event granularity.
+    Appender::appendBatch(events, count);
+}
+
+
+void
+ChunkedFileAppender::open(std::ios_base::openmode mode)
+{
+    tstring const chunk = chunkFilename (currentChunkIndex);
+
+    if (createDirs)
+        internal::make_dirs (chunk);
+
+    out.open(LOG4CPLUS_FSTREAM_PREFERED_FILE_NAME(chunk).c_str(), mode);
+
+    if(!out.good()) {
+        getErrorHandler()->error(LOG4CPLUS_TEXT("Unable to open file: ")
+            + chunk);
+        return;
+    }
+    helpers::getLogLog().debug(LOG4CPLUS_TEXT("Just opened file: ") + chunk);
+}
+
+
+//! Appends the index footer line to the chunk being written and
+//! closes it. A chunk carrying a footer is complete and is never
+//! touched again.
+void
+ChunkedFileAppender::finishChunk()
+{
+    if (out.good ())
+    {
+        out << LOG4CPLUS_TEXT ("#chunk-footer events=") << currentChunkEvents
+            << LOG4CPLUS_TEXT (" bytes=") << currentChunkSize
+            << LOG4CPLUS_TEXT ("\n");
+        out.flush ();
+    }
+
+    out.close ();
+    // Reset flags since the C++ standard specified that all the flags
+    // should remain unchanged on a close.
+    out.clear ();
+}
+
+
+void
+ChunkedFileAppender::rollover()
+{
+    LOG4CPLUS_TRACEPOINT1 (rollover, filename.c_str ());
+
+    helpers::LogLog & loglog = helpers::getLogLog();
+
+    finishChunk ();
+
+    ++currentChunkIndex;
+    currentChunkSize = 0;
+    currentChunkEvents = 0;
+
+    // The next chunk may already sit pre-created and pre-allocated on
+    // disk; appending to it keeps the reserved blocks.
+    open (std::ios_base::out | std::ios_base::app);
+    loglog_opening_result (loglog, out, chunkFilename (currentChunkIndex));
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (prealloc_thread)
+    {
+        prealloc_index.store (currentChunkIndex + 1,
+            std::memory_order_relaxed);
+        prealloc_wakeup.signal ();
+    }
+#endif
+}
+
+
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 CATCH_TEST_CASE ("TimeBasedRollingFileAppender", "[appender]")
 {
@@ -22,8 +22,12 @@
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
 
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 #include <log4cplus/logger.h>
@@ -56,6 +60,213 @@ checkFilter(const Filter* filter, const InternalLoggingEvent& event)
 }
 
 
+namespace
+{
+
+//! One link of a compiled filter chain, flattened into plain data.
+struct FilterStep
+{
+    enum Kind { DenyAll, LevelMatch, LevelRange, StringMatch };
+
+    Kind kind;
+    bool acceptOnMatch = true;
+    //! LevelMatch: the level to match. LevelRange: the lower bound.
+    LogLevel levelMin = NOT_SET_LOG_LEVEL;
+    //! LevelRange: the upper bound.
+    LogLevel levelMax = NOT_SET_LOG_LEVEL;
+    tstring stringToMatch;
+    //! Boyer-Moore-Horspool tables for stringToMatch. Built only once
+    //! the step is in its final location, because the tables hold
+    //! iterators into stringToMatch.
+    std::optional<std::boyer_moore_horspool_searcher<
+        tstring::const_iterator>> searcher;
+    //! Pre-filter probe: the character of stringToMatch least likely
+    //! to appear in typical log text. A message that does not contain
+    //! it cannot match, and char_traits::find() compiles down to a
+    //! vectorized memchr()/wmemchr() scan, so reject heavy
+    //! configurations skip the full search almost always. 0 when the
+    //! pattern is empty.
+    tchar probeChar = 0;
+};
+
+
+//! Ranks how unlikely \c c is to appear in typical log text, so that
+//! the probe scan rejects as many messages as possible. Punctuation
+//! beats upper case beats digits beats the lower case letters and
+//! spaces prose consists of.
+static unsigned
+probe_rarity (tchar c)
+{
+    if ((c >= LOG4CPLUS_TEXT ('a') && c <= LOG4CPLUS_TEXT ('z'))
+        || c == LOG4CPLUS_TEXT (' '))
+        return 0;
+    if (c >= LOG4CPLUS_TEXT ('0') && c <= LOG4CPLUS_TEXT ('9'))
+        return 1;
+    if (c >= LOG4CPLUS_TEXT ('A') && c <= LOG4CPLUS_TEXT ('Z'))
+        return 2;
+    return 3;
+}
+
+
+//! Replacement for a chain of stock filters. The steps are evaluated
+//! in chain order in a single loop, without a virtual call and
+//! pointer chase per link.
+class CompiledFilter
+    : public Filter
+{
+public:
+    explicit
+    CompiledFilter (std::vector<FilterStep> steps_)
+        : steps (std::move (steps_))
+    {
+        for (FilterStep & step : steps)
+        {
+            if (step.kind != FilterStep::StringMatch)
+                continue;
+
+            step.searcher.emplace (step.stringToMatch.begin (),
+                step.stringToMatch.end ());
+
+            // Of equally rare characters the last one wins, so the
+            // probe also approximates a last-byte check.
+            for (tchar const c : step.stringToMatch)
+                if (step.probeChar == 0
+                    || probe_rarity (c) >= probe_rarity (step.probeChar))
+                    step.probeChar = c;
+        }
+    }
+
+    FilterResult
+    decide (const InternalLoggingEvent & event) const override
+    {
+        for (FilterStep const & step : steps)
+        {
+            switch (step.kind)
+            {
+            case FilterStep::DenyAll:
+                return DENY;
+
+            case FilterStep::LevelMatch:
+                if (event.getLogLevel () == step.levelMin)
+                    return step.acceptOnMatch ? ACCEPT : DENY;
+                break;
+
+            case FilterStep::LevelRange:
+            {
+                LogLevel const eventLogLevel = event.getLogLevel ();
+                if (step.levelMin != NOT_SET_LOG_LEVEL
+                    && eventLogLevel < step.levelMin)
+                    return DENY;
+                if (step.levelMax != NOT_SET_LOG_LEVEL
+                    && eventLogLevel > step.levelMax)
+                    return DENY;
+                if (step.acceptOnMatch)
+                    return ACCEPT;
+                break;
+            }
+
+            case FilterStep::StringMatch:
+            {
+                // An empty message cannot contain the non-empty
+                // stringToMatch, so the empty-message check of
+                // StringMatchFilter::decide() folds into the search.
+                tstring const & message = event.getMessage ();
+
+                // Cheap pre-predicates first: a message shorter than
+                // the pattern or missing its rarest character cannot
+                // match; the scan is a vectorized memchr().
+                if (message.size () < step.stringToMatch.size ())
+                    break;
+                if (step.probeChar != 0
+                    && std::char_traits<tchar>::find (message.data (),
+                        message.size (), step.probeChar) == nullptr)
+                    break;
+
+                if (std::search (message.begin (), message.end (),
+                        *step.searcher)
+                    != message.end ())
+                    return step.acceptOnMatch ? ACCEPT : DENY;
+                break;
+            }
+            }
+        }
+
+        return NEUTRAL;
+    }
+
+private:
+    std::vector<FilterStep> steps;
+};
+
+} // namespace
+
+
+FilterPtr
+compileFilterChain (FilterPtr const & chain)
+{
+    if (! chain)
+        return chain;
+
+    std::vector<FilterStep> steps;
+    for (Filter const * f = chain.get (); f; f = f->next.get ())
+    {
+        FilterStep step;
+        if (dynamic_cast<DenyAllFilter const *> (f))
+        {
+            step.kind = FilterStep::DenyAll;
+            steps.push_back (std::move (step));
+            // Later links can never be consulted.
+            break;
+        }
+        else if (auto const * lm
+            = dynamic_cast<LogLevelMatchFilter const *> (f))
+        {
+            if (lm->logLevelToMatch == NOT_SET_LOG_LEVEL)
+                // Unconditionally NEUTRAL; drop the link.
+                continue;
+
+            step.kind = FilterStep::LevelMatch;
+            step.acceptOnMatch = lm->acceptOnMatch;
+            step.levelMin = lm->logLevelToMatch;
+            steps.push_back (std::move (step));
+        }
+        else if (auto const * lr
+            = dynamic_cast<LogLevelRangeFilter const *> (f))
+        {
+            if (lr->logLevelMin == NOT_SET_LOG_LEVEL
+                && lr->logLevelMax == NOT_SET_LOG_LEVEL
+                && ! lr->acceptOnMatch)
+                // Unconditionally NEUTRAL; drop the link.
+                continue;
+
+            step.kind = FilterStep::LevelRange;
+            step.acceptOnMatch = lr->acceptOnMatch;
+            step.levelMin = lr->logLevelMin;
+            step.levelMax = lr->logLevelMax;
+            steps.push_back (std::move (step));
+        }
+        else if (auto const * sm
+            = dynamic_cast<StringMatchFilter const *> (f))
+        {
+            if (sm->stringToMatch.empty ())
+                // Unconditionally NEUTRAL; drop the link.
+                continue;
+
+            step.kind = FilterStep::StringMatch;
+            step.acceptOnMatch = sm->acceptOnMatch;
+            step.stringToMatch = sm->stringToMatch;
+            steps.push_back (std::move (step));
+        }
+        else
+            // The chain contains a filter we cannot represent;
+            // leave it to the virtual walk.
+            return chain;
+    }
+
+    return FilterPtr (new CompiledFilter (std::move (steps)));
+}
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Filter implementation
@@ -227,6 +438,8 @@ StringMatchFilter::StringMatchFilter(const helpers::Properties& properties)
 
     properties.getBool (acceptOnMatch, LOG4CPLUS_TEXT("AcceptOnMatch"));
     stringToMatch = properties.getProperty( LOG4CPLUS_TEXT("StringToMatch") );
+    if (! stringToMatch.empty ())
+        searcher.emplace (stringToMatch.begin (), stringToMatch.end ());
 }
 
 
@@ -246,7 +459,8 @@ StringMatchFilter::decide(const InternalLoggingEvent& event) const
         return NEUTRAL;
     }
 
-    if(message.find(stringToMatch) == tstring::npos) {
+    if(std::search(message.begin(), message.end(), *searcher)
+        == message.end()) {
         return NEUTRAL;
     }
     else {  // we've got a match
@@ -292,6 +506,8 @@ void NDCMatchFilter::init()
 {
     acceptOnMatch = true;
     neutralOnEmpty = true;
+    // decide() reads the event's NDC regardless of any layout.
+    addNeededEventFields (EventFieldNDC);
 }
 
 
@@ -333,6 +549,8 @@ void MDCMatchFilter::init()
 {
     acceptOnMatch = true;
     neutralOnEmpty = true;
+    // decide() reads the event's MDC regardless of any layout.
+    addNeededEventFields (EventFieldMDC);
 }
 
 
@@ -352,6 +570,138 @@ FilterResult MDCMatchFilter::decide(const InternalLoggingEvent& event) const
     return (acceptOnMatch ? DENY : ACCEPT);
 }
 
+//
+// Rate limit filter
+//
+
+namespace
+{
+
+// Token bucket counters are kept in microtokens so that refills
+// computed from microsecond timestamps need no division.
+long long const MICRO = 1000 * 1000;
+
+} // namespace
+
+
+struct RateLimitFilter::LoggerState
+{
+    LoggerState (long long initial_tokens, long long refill_time)
+        : microTokens (initial_tokens)
+        , lastRefill (refill_time)
+        , sampleCounter (0)
+    { }
+
+    //! Available tokens, scaled by MICRO.
+    std::atomic<long long> microTokens;
+    //! Timestamp of the last refill in microseconds since epoch.
+    std::atomic<long long> lastRefill;
+    //! Running event count used for 1-in-N sampling.
+    std::atomic<unsigned long> sampleCounter;
+};
+
+
+RateLimitFilter::RateLimitFilter()
+{
+    init();
+}
+
+
+RateLimitFilter::RateLimitFilter(const helpers::Properties& properties)
+{
+    init();
+
+    tstring const & log_level_max
+        = properties.getProperty( LOG4CPLUS_TEXT("LogLevelMax") );
+    logLevelMax = getLogLevelManager().fromString(log_level_max);
+
+    properties.getUInt (ratePerSecond, LOG4CPLUS_TEXT("RatePerSecond"));
+    burstSize = ratePerSecond;
+    properties.getUInt (burstSize, LOG4CPLUS_TEXT("BurstSize"));
+    properties.getUInt (sampleEvery, LOG4CPLUS_TEXT("SampleEvery"));
+}
+
+
+RateLimitFilter::~RateLimitFilter() = default;
+
+
+void
+RateLimitFilter::init()
+{
+    logLevelMax = NOT_SET_LOG_LEVEL;
+    ratePerSecond = 0;
+    burstSize = 0;
+    sampleEvery = 1;
+}
+
+
+RateLimitFilter::LoggerState &
+RateLimitFilter::getLoggerState (tstring const & logger) const
+{
+    thread::MutexGuard guard (mutex);
+
+    std::unique_ptr<LoggerState> & state = loggerStates[logger];
+    if (! state)
+        state.reset (new LoggerState (
+            static_cast<long long>(burstSize) * MICRO,
+            helpers::now ().time_since_epoch ().count ()));
+
+    return *state;
+}
+
+
+FilterResult
+RateLimitFilter::decide(const InternalLoggingEvent& event) const
+{
+    if(logLevelMax != NOT_SET_LOG_LEVEL
+        && event.getLogLevel() > logLevelMax) {
+        // The event is too important to be shed.
+        return NEUTRAL;
+    }
+
+    LoggerState & state = getLoggerState (event.getLoggerName ());
+
+    if(sampleEvery > 1
+        && state.sampleCounter.fetch_add (1, std::memory_order_relaxed)
+            % sampleEvery != 0) {
+        return DENY;
+    }
+
+    if(ratePerSecond == 0) {
+        return NEUTRAL;
+    }
+
+    // Refill the bucket for the time elapsed since the last refill.
+    // Only the thread that wins the CAS on lastRefill adds tokens, so
+    // elapsed time is never credited twice.
+    long long const now
+        = event.getTimestamp ().time_since_epoch ().count ();
+    long long last = state.lastRefill.load (std::memory_order_relaxed);
+    if(now > last
+        && state.lastRefill.compare_exchange_strong (last, now,
+            std::memory_order_relaxed)) {
+        long long const refill = (now - last) * ratePerSecond;
+        long long const capacity = static_cast<long long>(burstSize) * MICRO;
+        long long tokens
+            = state.microTokens.load (std::memory_order_relaxed);
+        while(! state.microTokens.compare_exchange_weak (tokens,
+                (std::min) (tokens + refill, capacity),
+                std::memory_order_relaxed))
+            ;
+    }
+
+    // Consume one token; deny when the bucket is empty.
+    long long tokens = state.microTokens.load (std::memory_order_relaxed);
+    do {
+        if(tokens < MICRO) {
+            return DENY;
+        }
+    } while(! state.microTokens.compare_exchange_weak (tokens,
+        tokens - MICRO, std::memory_order_relaxed));
+
+    return NEUTRAL;
+}
+
 
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 CATCH_TEST_CASE ("Filter", "[filter]")
@@ -484,6 +834,98 @@ CATCH_TEST_CASE ("Filter", "[filter]")
         }
     }
 
+    CATCH_SECTION ("compiled filter chain")
+    {
+        CATCH_SECTION ("stock chain matches virtual walk")
+        {
+            // WARN..ERROR accepted, events mentioning "info" denied,
+            // everything else denied by the trailing DenyAllFilter.
+            helpers::Properties range_props;
+            range_props.setProperty (LOG4CPLUS_TEXT ("LogLevelMin"),
+                LOG4CPLUS_TEXT ("WARN"));
+            range_props.setProperty (LOG4CPLUS_TEXT ("LogLevelMax"),
+                LOG4CPLUS_TEXT ("ERROR"));
+            helpers::Properties string_props;
+            string_props.setProperty (LOG4CPLUS_TEXT ("StringToMatch"),
+                LOG4CPLUS_TEXT ("info"));
+            string_props.setProperty (LOG4CPLUS_TEXT ("AcceptOnMatch"),
+                LOG4CPLUS_TEXT ("false"));
+
+            filter = new LogLevelRangeFilter (range_props);
+            filter->appendFilter (
+                FilterPtr (new StringMatchFilter (string_props)));
+            filter->appendFilter (FilterPtr (new DenyAllFilter));
+
+            FilterPtr compiled = compileFilterChain (filter);
+            CATCH_REQUIRE (compiled.get () != filter.get ());
+            for (auto const * ev : { &debug_ev, &info_ev, &empty_ev,
+                     &warn_ev, &error_ev, &fatal_ev })
+                CATCH_REQUIRE (checkFilter (compiled.get (), *ev)
+                    == checkFilter (filter.get (), *ev));
+        }
+
+        CATCH_SECTION ("all neutral links compile to neutral")
+        {
+            // LogLevelToMatch and StringToMatch left unset; both links
+            // are unconditionally NEUTRAL and compile away.
+            filter = new LogLevelMatchFilter;
+            filter->appendFilter (FilterPtr (new StringMatchFilter));
+
+            FilterPtr compiled = compileFilterChain (filter);
+            CATCH_REQUIRE (compiled.get () != filter.get ());
+            CATCH_REQUIRE (compiled->decide (info_ev) == NEUTRAL);
+            CATCH_REQUIRE (checkFilter (compiled.get (), info_ev) == ACCEPT);
+        }
+
+        CATCH_SECTION ("foreign filter falls back to the virtual walk")
+        {
+            filter = new LogLevelMatchFilter;
+            filter->appendFilter (FilterPtr (new FunctionFilter (
+                [](InternalLoggingEvent const &) -> FilterResult {
+                    return NEUTRAL;
+                })));
+            CATCH_REQUIRE (compileFilterChain (filter).get ()
+                == filter.get ());
+        }
+
+        CATCH_SECTION ("empty chain stays empty")
+        {
+            CATCH_REQUIRE (! compileFilterChain (FilterPtr ()));
+        }
+
+        CATCH_SECTION ("pre-predicates agree with the full search")
+        {
+            // The pattern's rarest character, '#', is absent from the
+            // stock messages, and "info log message" is shorter than
+            // the long pattern; both pre-filter rejections must be
+            // indistinguishable from a failed search.
+            helpers::Properties string_props;
+            string_props.setProperty (LOG4CPLUS_TEXT ("StringToMatch"),
+                LOG4CPLUS_TEXT ("marker#42"));
+            filter = new StringMatchFilter (string_props);
+            filter->appendFilter (FilterPtr (new DenyAllFilter));
+
+            FilterPtr compiled = compileFilterChain (filter);
+            static InternalLoggingEvent const marked_ev (log.getName (),
+                INFO_LOG_LEVEL,
+                LOG4CPLUS_TEXT ("event carrying marker#42 inside"),
+                __FILE__, __LINE__);
+            for (auto const * ev : { &debug_ev, &info_ev, &empty_ev,
+                     &marked_ev })
+                CATCH_REQUIRE (checkFilter (compiled.get (), *ev)
+                    == checkFilter (filter.get (), *ev));
+            CATCH_REQUIRE (compiled->decide (marked_ev) == ACCEPT);
+            CATCH_REQUIRE (compiled->decide (info_ev) == DENY);
+
+            helpers::Properties long_props;
+            long_props.setProperty (LOG4CPLUS_TEXT ("StringToMatch"),
+                LOG4CPLUS_TEXT ("info log message but much longer"));
+            filter = new StringMatchFilter (long_props);
+            compiled = compileFilterChain (filter);
+            CATCH_REQUIRE (compiled->decide (info_ev) == NEUTRAL);
+        }
+    }
+
     CATCH_SECTION ("function filter")
     {
         filter = new FunctionFilter (
@@ -602,6 +1044,59 @@ CATCH_TEST_CASE ("Filter", "[filter]")
         }
     }
 
+    CATCH_SECTION ("rate limit filter")
+    {
+        CATCH_SECTION ("no limits configured is neutral")
+        {
+            filter = new RateLimitFilter;
+            CATCH_REQUIRE (filter->decide (debug_ev) == NEUTRAL);
+            CATCH_REQUIRE (filter->decide (debug_ev) == NEUTRAL);
+        }
+
+        CATCH_SECTION ("token bucket denies beyond burst")
+        {
+            helpers::Properties props;
+            props.setProperty (LOG4CPLUS_TEXT ("RatePerSecond"),
+                LOG4CPLUS_TEXT ("1"));
+            props.setProperty (LOG4CPLUS_TEXT ("BurstSize"),
+                LOG4CPLUS_TEXT ("2"));
+            filter = new RateLimitFilter (props);
+            // The events share one timestamp, so no refill happens
+            // in between and only the burst is let through.
+            CATCH_REQUIRE (filter->decide (debug_ev) == NEUTRAL);
+            CATCH_REQUIRE (filter->decide (debug_ev) == NEUTRAL);
+            CATCH_REQUIRE (filter->decide (debug_ev) == DENY);
+        }
+
+        CATCH_SECTION ("severity gate passes important events")
+        {
+            helpers::Properties props;
+            props.setProperty (LOG4CPLUS_TEXT ("LogLevelMax"),
+                LOG4CPLUS_TEXT ("INFO"));
+            props.setProperty (LOG4CPLUS_TEXT ("RatePerSecond"),
+                LOG4CPLUS_TEXT ("1"));
+            props.setProperty (LOG4CPLUS_TEXT ("BurstSize"),
+                LOG4CPLUS_TEXT ("1"));
+            filter = new RateLimitFilter (props);
+            CATCH_REQUIRE (filter->decide (debug_ev) == NEUTRAL);
+            CATCH_REQUIRE (filter->decide (debug_ev) == DENY);
+            CATCH_REQUIRE (filter->decide (error_ev) == NEUTRAL);
+            CATCH_REQUIRE (filter->decide (error_ev) == NEUTRAL);
+        }
+
+        CATCH_SECTION ("sampling keeps one event in N")
+        {
+            helpers::Properties props;
+            props.setProperty (LOG4CPLUS_TEXT ("SampleEvery"),
+                LOG4CPLUS_TEXT ("3"));
+            filter = new RateLimitFilter (props);
+            CATCH_REQUIRE (filter->decide (debug_ev) == NEUTRAL);
+            CATCH_REQUIRE (filter->decide (debug_ev) == DENY);
+            CATCH_REQUIRE (filter->decide (debug_ev) == DENY);
+            CATCH_REQUIRE (filter->decide (debug_ev) == NEUTRAL);
+        }
+    }
+
     CATCH_SECTION ("mdc match filter")
     {
         InternalLoggingEvent  mdc_error_ev (log.getName (), ERROR_LOG_LEVEL,
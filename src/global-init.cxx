@@ -29,6 +29,7 @@
 
 #include <log4cplus/initializer.h>
 #include <log4cplus/config/windowsh-inc.h>
+#include <log4cplus/executor.h>
 #include <log4cplus/logger.h>
 #include <log4cplus/ndc.h>
 #include <log4cplus/mdc.h>
@@ -38,12 +39,16 @@
 #include <log4cplus/thread/impl/tls.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
 #include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/spi/factory.h>
 #include <log4cplus/hierarchy.h>
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 #include "ThreadPool.h"
 #endif
+#include <atomic>
 #include <cstdio>
+#include <mutex>
+#include <new>
 #include <iostream>
 #include <stdexcept>
 
@@ -149,15 +154,37 @@ struct DefaultContext
     helpers::LogLog loglog;
     LogLevelManager log_level_manager;
     internal::CustomLogLevelManager custom_log_level_manager;
-    helpers::Time TTCCLayout_time_base;
+    helpers::Time TTCCLayout_time_base {helpers::now ()};
     NDC ndc;
     MDC mdc;
     spi::AppenderFactoryRegistry appender_factory_registry;
     spi::LayoutFactoryRegistry layout_factory_registry;
     spi::FilterFactoryRegistry filter_factory_registry;
+    spi::RolloverStrategyFactoryRegistry rollover_strategy_factory_registry;
     spi::LocaleFactoryRegistry locale_factory_registry;
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    std::unique_ptr<progschj::ThreadPool> thread_pool {instantiate_thread_pool ()};
+    //! The worker threads are spawned on first use instead of when
+    //! the context is allocated, so that processes that never use
+    //! asynchronous appenders do not pay for them. Guarded by a plain
+    //! mutex instead of std::once_flag so that atForkChild() can
+    //! discard a forked-dead pool and have it lazily rebuilt. Use
+    //! get_thread_pool() instead of reading the member directly.
+    std::mutex thread_pool_mtx;
+    std::unique_ptr<progschj::ThreadPool> thread_pool;
+
+    //! Executor injected through setExecutor(), read with
+    //! std::atomic_load. Empty means the built-in pool above
+    //! schedules the background tasks.
+    std::shared_ptr<Executor> executor;
+
+    progschj::ThreadPool *
+    get_thread_pool ()
+    {
+        std::lock_guard<std::mutex> guard (thread_pool_mtx);
+        if (! thread_pool)
+            thread_pool = instantiate_thread_pool ();
+        return thread_pool.get ();
+    }
 #endif
     Hierarchy hierarchy;
 };
@@ -305,12 +332,47 @@ getMDC ()
 }
 
 
+Executor::~Executor () = default;
+
+
+void
+setExecutor (std::shared_ptr<Executor> LOG4CPLUS_THREADED (executor))
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    std::atomic_store (&get_dc ()->executor, std::move (executor));
+#endif
+}
+
+
+std::shared_ptr<Executor>
+getExecutor ()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    return std::atomic_load (&get_dc ()->executor);
+#else
+    return std::shared_ptr<Executor> ();
+#endif
+}
+
+
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
+void
+enqueueThreadPoolTask (std::function<void ()> task)
+{
+    DefaultContext * const dc = get_dc ();
+    std::shared_ptr<Executor> const exec = std::atomic_load (&dc->executor);
+    if (exec)
+        exec->execute (std::move (task));
+    else
+        dc->get_thread_pool ()->enqueue (std::move (task));
+}
+
+
 void
 enqueueAsyncDoAppend (SharedAppenderPtr const & appender,
     spi::InternalLoggingEvent const & event)
 {
-    get_dc ()->thread_pool->enqueue (
+    enqueueThreadPoolTask (
         [=] ()
         {
             appender->asyncDoAppend (event);
@@ -324,8 +386,9 @@ shutdownThreadPool ()
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     DefaultContext * const dc = get_dc (false);
-    if (dc && dc->thread_pool)
+    if (dc)
     {
+        std::lock_guard<std::mutex> guard (dc->thread_pool_mtx);
         dc->thread_pool.reset ();
     }
 #endif
@@ -337,7 +400,17 @@ waitUntilEmptyThreadPoolQueue ()
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     DefaultContext * const dc = get_dc (false);
-    if (dc && dc->thread_pool)
+    if (! dc)
+        return;
+
+    std::shared_ptr<Executor> const exec = std::atomic_load (&dc->executor);
+    if (exec)
+    {
+        exec->drain ();
+        return;
+    }
+
+    if (dc->thread_pool)
     {
         dc->thread_pool->wait_until_empty ();
         dc->thread_pool->wait_until_nothing_in_flight ();
@@ -346,6 +419,50 @@ waitUntilEmptyThreadPoolQueue ()
 }
 
 
+// Forward declaration. Defined in factory.cxx.
+void initializeFactoryRegistry ();
+
+// Forward declaration. Defined in emergencylog.cxx.
+void initializeEmergencyLog ();
+
+
+namespace
+{
+
+//! Populates the factory registries on first use of any of them, so
+//! that processes that never parse a configuration do not pay for
+//! registering every bundled appender, layout and filter factory.
+//! initializeFactoryRegistry() itself obtains the registries through
+//! the public getters, so the guard must let the registering thread
+//! back in; std::call_once would deadlock on such re-entry.
+static
+void
+ensure_factory_registry ()
+{
+    enum EnsureState { uninitialized, initializing, initialized };
+    static std::atomic<int> state {uninitialized};
+
+    if (LOG4CPLUS_LIKELY (
+            state.load (std::memory_order_acquire) == initialized))
+        return;
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    static std::recursive_mutex mtx;
+    std::lock_guard<std::recursive_mutex> guard (mtx);
+#endif
+    if (state.load (std::memory_order_relaxed) != uninitialized)
+        // Either already populated or re-entered from
+        // initializeFactoryRegistry().
+        return;
+
+    state.store (initializing, std::memory_order_relaxed);
+    initializeFactoryRegistry ();
+    state.store (initialized, std::memory_order_release);
+}
+
+} // namespace
+
+
 namespace spi
 {
 
@@ -353,6 +470,7 @@ namespace spi
 AppenderFactoryRegistry &
 getAppenderFactoryRegistry ()
 {
+    ensure_factory_registry ();
     return get_dc ()->appender_factory_registry;
 }
 
@@ -360,6 +478,7 @@ getAppenderFactoryRegistry ()
 LayoutFactoryRegistry &
 getLayoutFactoryRegistry ()
 {
+    ensure_factory_registry ();
     return get_dc ()->layout_factory_registry;
 }
 
@@ -367,13 +486,23 @@ getLayoutFactoryRegistry ()
 FilterFactoryRegistry &
 getFilterFactoryRegistry ()
 {
+    ensure_factory_registry ();
     return get_dc ()->filter_factory_registry;
 }
 
 
+RolloverStrategyFactoryRegistry &
+getRolloverStrategyFactoryRegistry ()
+{
+    ensure_factory_registry ();
+    return get_dc ()->rollover_strategy_factory_registry;
+}
+
+
 LocaleFactoryRegistry &
 getLocaleFactoryRegistry()
 {
+    ensure_factory_registry ();
     return get_dc ()->locale_factory_registry;
 }
 
@@ -401,8 +530,19 @@ appender_sratch_pad::appender_sratch_pad () = default;
 appender_sratch_pad::~appender_sratch_pad () = default;
 
 
+//! Source of per_thread_data::counter_stripe values. A plain round
+//! robin assignment spreads threads evenly over the counter stripes
+//! without any per increment hashing.
+static std::atomic<unsigned> next_counter_stripe {0};
+
+
 per_thread_data::per_thread_data ()
-    : fnull (nullptr)
+    : forced_log_high_water (0)
+    , forced_log_use_count (0)
+    , counter_stripe (
+        next_counter_stripe.fetch_add (1, std::memory_order_relaxed))
+    , appender_sequence (0)
+    , fnull (nullptr)
 { }
 
 
@@ -452,9 +592,6 @@ alloc_ptd ()
 } // namespace internal
 
 
-void initializeFactoryRegistry ();
-
-
 //! Thread local storage clean up function for POSIX threads.
 #if defined (LOG4CPLUS_USE_WIN32_THREADS)
 static
@@ -524,11 +661,10 @@ initializeLog4cplus()
 
     internal::tls_storage_key = thread::impl::tls_init (ptd_cleanup_func);
     threadSetup ();
+    initializeEmergencyLog ();
 
-    DefaultContext * dc = get_dc (true);
-    dc->TTCCLayout_time_base = helpers::now ();
+    get_dc (true);
     Logger::getRoot();
-    initializeFactoryRegistry();
 
     initialized = true;
 }
@@ -541,9 +677,77 @@ initialize ()
 }
 
 
+void
+preinitialize ()
+{
+    initializeLog4cplus ();
+    ensure_factory_registry ();
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    get_dc ()->get_thread_pool ();
+#endif
+}
+
+
+namespace internal
+{
+
+//! Bumped by atForkChild(); see process_generation().
+static std::atomic<unsigned> process_gen {0};
+
+
+unsigned
+process_generation ()
+{
+    return process_gen.load (std::memory_order_relaxed);
+}
+
+} // namespace internal
+
+
+void
+atForkChild ()
+{
+    // The forked child inherits the configured hierarchy, appenders
+    // and log levels, but none of the parent's threads. Discard state
+    // that refers to them so that logging can resume without a full
+    // re-configuration.
+
+    // Invalidate caches of process identity, e.g. the pre-rendered
+    // process id in PatternLayout instances.
+    internal::process_gen.fetch_add (1, std::memory_order_relaxed);
+
+    internal::per_thread_data * const ptd = internal::get_ptd (false);
+    if (ptd)
+    {
+        // The cached thread names carry the parent's thread id.
+        ptd->thread_name.reset ();
+        ptd->thread_name2.reset ();
+    }
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    DefaultContext * const dc = get_dc (false);
+    if (dc)
+    {
+        // Re-arm the guard mutex first; a parent thread may have held
+        // it at the point of fork, which leaves the copy inherited by
+        // the child in an undefined state.
+        new (&dc->thread_pool_mtx) std::mutex;
+
+        // The pool's worker threads do not exist in this process; the
+        // pool's destructor would wait for them forever. Abandon the
+        // object and let the next asynchronous append build a fresh
+        // pool lazily.
+        dc->thread_pool.release ();
+    }
+#endif
+}
+
+
 void
 deinitialize ()
 {
+    helpers::setCoarseTimestampGranularity (0);
+    helpers::setLocalTimeOffsetCacheSeconds (0);
     shutdownThreadPool();
     Logger::shutdown ();
 }
@@ -592,7 +796,7 @@ void
 setThreadPoolSize (std::size_t LOG4CPLUS_THREADED (pool_size))
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    get_dc ()->thread_pool->set_pool_size (pool_size);
+    get_dc ()->get_thread_pool ()->set_pool_size (pool_size);
 #endif
 }
 
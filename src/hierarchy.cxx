@@ -23,8 +23,11 @@
 #include <log4cplus/spi/loggerimpl.h>
 #include <log4cplus/spi/rootlogger.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <iterator>
 #include <utility>
 #include <limits>
+#include <memory>
 
 
 namespace log4cplus
@@ -73,6 +76,8 @@ Hierarchy::Hierarchy()
   , emittedNoAppenderWarning(false)
 {
     root = Logger( new spi::RootLogger(*this, DEBUG_LOG_LEVEL) );
+    root.value->refreshThreshold();
+    root.value->refreshAppenderChain();
 }
 
 
@@ -94,6 +99,8 @@ Hierarchy::clear()
 
     provisionNodes.erase(provisionNodes.begin(), provisionNodes.end());
     loggerPtrs.erase(loggerPtrs.begin(), loggerPtrs.end());
+    publishSnapshot();
+    bumpEpoch();
 }
 
 
@@ -104,10 +111,19 @@ Hierarchy::exists(const tstring_view& name)
     if (name.empty ())
         return true;
 
-    thread::MutexGuard guard (hashtable_mutex);
+    if (Hierarchy * const part = findPartition (name))
+        return part->exists (name);
+
+    // The Bloom filter answers the common negative probe without
+    // touching the logger map; only possible hits pay for the
+    // snapshot lookup.
+    if (! loggerNameFilterContains (name))
+        return false;
 
-    auto it = loggerPtrs.find(name);
-    return it != loggerPtrs.end();
+    LoggerMapSnapshot const snapshot
+        = std::atomic_load_explicit (&loggerPtrsSnapshot,
+            std::memory_order_acquire);
+    return snapshot && snapshot->find(name) != snapshot->end();
 }
 
 
@@ -116,6 +132,7 @@ Hierarchy::disable(const tstring_view& loglevelStr)
 {
     if(disableValue != DISABLE_OVERRIDE) {
         disableValue = getLogLevelManager().fromString(loglevelStr);
+        refreshThresholds();
     }
 }
 
@@ -125,6 +142,7 @@ Hierarchy::disable(LogLevel ll)
 {
     if(disableValue != DISABLE_OVERRIDE) {
         disableValue = ll;
+        refreshThresholds();
     }
 }
 
@@ -154,6 +172,7 @@ void
 Hierarchy::enableAll()
 {
     disableValue = DISABLE_OFF;
+    refreshThresholds();
 }
 
 
@@ -167,26 +186,163 @@ Hierarchy::getInstance(const tstring_view& name)
 Logger
 Hierarchy::getInstance(const tstring_view& name, spi::LoggerFactory& factory)
 {
+    // Names under a partition prefix are served by the partition and
+    // its own locks; see getPartition().
+    if (Hierarchy * const part = findPartition (name))
+        return part->getInstance (name, factory);
+
+    // Fast path: look the name up in the current snapshot without
+    // taking hashtable_mutex. Only the first request for a given
+    // logger falls through to the locked slow path.
+    if (! name.empty ())
+    {
+        LoggerMapSnapshot const snapshot
+            = std::atomic_load_explicit (&loggerPtrsSnapshot,
+                std::memory_order_acquire);
+        if (snapshot)
+        {
+            auto it = snapshot->find(name);
+            if (it != snapshot->end())
+                return it->second;
+        }
+    }
+
     thread::MutexGuard guard (hashtable_mutex);
 
     return getInstanceImpl(name, factory);
 }
 
 
+Hierarchy &
+Hierarchy::getPartition (const tstring & prefix)
+{
+    if (prefix.empty ())
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("Hierarchy::getPartition()")
+            LOG4CPLUS_TEXT (" - empty prefix"), true);
+
+    thread::MutexGuard guard (hashtable_mutex);
+
+    for (auto & part : partitions)
+    {
+        if (part.first == prefix)
+            return *part.second;
+    }
+
+    std::unique_ptr<Hierarchy> part (new Hierarchy);
+    // Cross partition fallthrough: the partition's root logger links
+    // to this hierarchy's root, so events that stay additive at the
+    // partition's root continue into the appenders configured here.
+    part->root.value->parent = root.value;
+    part->refreshThresholds ();
+    part->refreshAppenderChains ();
+
+    Hierarchy & ref = *part;
+    partitions.emplace_back (prefix, std::move (part));
+
+    auto snapshot = std::make_shared<
+        std::vector<std::pair<tstring, Hierarchy *>>> ();
+    snapshot->reserve (partitions.size ());
+    for (auto & p : partitions)
+        snapshot->emplace_back (p.first, p.second.get ());
+    std::atomic_store_explicit (&partitionSnapshot,
+        PartitionSnapshotPtr (std::move (snapshot)),
+        std::memory_order_release);
+
+    return ref;
+}
+
+
+Hierarchy *
+Hierarchy::findPartition (tstring_view name) const
+{
+    PartitionSnapshotPtr const snapshot = std::atomic_load_explicit (
+        &partitionSnapshot, std::memory_order_acquire);
+    if (! snapshot)
+        return nullptr;
+
+    // Longest matching prefix wins, so nested partitions behave like
+    // nested loggers.
+    Hierarchy * best = nullptr;
+    std::size_t best_len = 0;
+    for (auto const & part : *snapshot)
+    {
+        tstring const & prefix = part.first;
+        if (name.size () < prefix.size ()
+            || name.compare (0, prefix.size (), prefix) != 0
+            || (name.size () > prefix.size ()
+                && name[prefix.size ()] != LOG4CPLUS_TEXT ('.')))
+            continue;
+
+        if (prefix.size () >= best_len)
+        {
+            best = part.second;
+            best_len = prefix.size ();
+        }
+    }
+
+    return best;
+}
+
+
 LoggerList
 Hierarchy::getCurrentLoggers()
 {
     LoggerList ret;
 
+    // Copy from the read-only snapshot instead of the live map so
+    // that periodic pollers do not block logger creation on
+    // hashtable_mutex.
+    LoggerMapSnapshot const snapshot
+        = std::atomic_load_explicit (&loggerPtrsSnapshot,
+            std::memory_order_acquire);
+    if (snapshot)
     {
-        thread::MutexGuard guard (hashtable_mutex);
-        initializeLoggerList(ret);
+        ret.reserve (snapshot->size ());
+        for (auto const & kv : *snapshot)
+            ret.push_back (kv.second);
     }
 
     return ret;
 }
 
 
+void
+Hierarchy::forEachLogger (std::function<void (Logger const &)> const & visit)
+{
+    LoggerMapSnapshot const snapshot
+        = std::atomic_load_explicit (&loggerPtrsSnapshot,
+            std::memory_order_acquire);
+    if (! snapshot)
+        return;
+
+    // The snapshot keeps the visited loggers alive; no copy of the
+    // list is needed and the visitor may create new loggers without
+    // deadlocking.
+    for (auto const & kv : *snapshot)
+        visit (kv.second);
+}
+
+
+std::vector<Hierarchy::Statistics>
+Hierarchy::getStatistics()
+{
+    std::vector<Statistics> ret;
+
+    thread::MutexGuard guard (hashtable_mutex);
+
+    ret.reserve (loggerPtrs.size () + 1);
+    ret.push_back (
+        Statistics {root.value->getName (),
+            root.value->getEmittedEvents ()});
+    for (auto const & kv : loggerPtrs)
+        ret.push_back (
+            Statistics {kv.first, kv.second.value->getEmittedEvents ()});
+
+    return ret;
+}
+
+
 bool
 Hierarchy::isDisabled(LogLevel level)
 {
@@ -206,6 +362,7 @@ Hierarchy::resetConfiguration()
 {
     getRoot().setLogLevel(DEBUG_LOG_LEVEL);
     disableValue = DISABLE_OFF;
+    refreshThresholds();
 
     shutdown();
 
@@ -214,8 +371,10 @@ Hierarchy::resetConfiguration()
     {
         logger.setLogLevel(NOT_SET_LOG_LEVEL);
         logger.setAdditivity(true);
+        logger.setMaxMessageSize(0);
     }
 
+    bumpEpoch();
 }
 
 
@@ -239,6 +398,19 @@ void waitUntilEmptyThreadPoolQueue ();
 void
 Hierarchy::shutdown()
 {
+    // Close partitions first, while the appenders their events fall
+    // through to are still open.
+    {
+        std::vector<Hierarchy *> parts;
+        {
+            thread::MutexGuard guard (hashtable_mutex);
+            for (auto & part : partitions)
+                parts.push_back (part.second.get ());
+        }
+        for (Hierarchy * part : parts)
+            part->shutdown ();
+    }
+
     waitUntilEmptyThreadPoolQueue ();
 
     LoggerList loggers;
@@ -266,6 +438,67 @@ Hierarchy::shutdown()
         logger.closeNestedAppenders();
         logger.removeAllAppenders();
     }
+
+    bumpEpoch();
+}
+
+
+void
+Hierarchy::shutdown(std::chrono::milliseconds budget)
+{
+    auto const deadline = std::chrono::steady_clock::now () + budget;
+    auto const remaining = [&] () -> std::chrono::milliseconds
+    {
+        auto const now = std::chrono::steady_clock::now ();
+        return now < deadline
+            ? std::chrono::duration_cast<std::chrono::milliseconds> (
+                deadline - now)
+            : std::chrono::milliseconds (0);
+    };
+
+    // Close partitions first, while the appenders their events fall
+    // through to are still open; each gets whatever is left of the
+    // shared budget.
+    {
+        std::vector<Hierarchy *> parts;
+        {
+            thread::MutexGuard guard (hashtable_mutex);
+            for (auto & part : partitions)
+                parts.push_back (part.second.get ());
+        }
+        for (Hierarchy * part : parts)
+            part->shutdown (remaining ());
+    }
+
+    // Unlike the unbounded shutdown(), the thread pool queue is not
+    // drained up front here; each appender's timed wait below covers
+    // its own in-flight events, and a stuck pool task must not be
+    // able to consume the whole budget before any appender gets a
+    // turn.
+
+    LoggerList loggers;
+    initializeLoggerList (loggers);
+
+    for (auto & appenderPtr : root.getAllAppenders())
+    {
+        Appender & appender = *appenderPtr;
+        appender.waitToFinishAsyncLogging (remaining ());
+    }
+    root.closeNestedAppenders();
+    root.removeAllAppenders();
+
+    for (auto & logger : loggers)
+    {
+        for (auto & appenderPtr : logger.getAllAppenders())
+        {
+            Appender & appender = *appenderPtr;
+            appender.waitToFinishAsyncLogging (remaining ());
+        }
+        logger.closeNestedAppenders();
+        logger.removeAllAppenders();
+    }
+
+    bumpEpoch();
 }
 
 
@@ -281,6 +514,12 @@ Hierarchy::getInstanceImpl(const tstring_view& name,
     Logger logger;
     LoggerMap::iterator lm_it;
 
+    // Callers holding this hierarchy locked, e.g. HierarchyLocker,
+    // enter here directly; keep partition names out of this
+    // hierarchy's map on that path too.
+    if (Hierarchy * const part = findPartition (name))
+        return part->getInstance (name, factory);
+
     if (name.empty ())
         logger = root;
     else if ((lm_it = loggerPtrs.find(name)) != loggerPtrs.end())
@@ -290,6 +529,7 @@ Hierarchy::getInstanceImpl(const tstring_view& name,
         // Need to create a new logger
         logger = factory.makeNewLoggerInstance(name, *this);
         bool inserted = loggerPtrs.emplace (name, logger).second;
+        loggerNameFilterAdd (name);
         if (! inserted)
         {
             helpers::getLogLog().error(
@@ -304,6 +544,23 @@ Hierarchy::getInstanceImpl(const tstring_view& name,
             provisionNodes.erase(pnm_it);
         }
         updateParents(logger);
+
+        // The effective threshold can only be computed once the
+        // parent chain is linked. Re-parented children keep their
+        // thresholds: a freshly created logger never has an assigned
+        // LogLevel, so inserting it into a chain changes nothing.
+        logger.value->refreshThreshold();
+
+        // updateChildren() may have spliced this logger into the
+        // parent links of existing descendants, invalidating their
+        // flattened ancestor chains; rebuild them all. Logger
+        // creation is rare and already O(n) from publishSnapshot().
+        refreshAppenderChains();
+
+        // Publish only after the new logger has been linked into the
+        // hierarchy so that lock-free lookups never see it half
+        // constructed.
+        publishSnapshot();
     }
 
     return logger;
@@ -365,6 +622,306 @@ Hierarchy::updateParents(Logger const & logger)
 }
 
 
+std::atomic<LogLevel> *
+Hierarchy::allocateThresholdSlot()
+{
+    // Slots are handed out from fixed size blocks so that addresses
+    // stay stable while consecutively created loggers still share
+    // cache lines.
+    std::size_t const block_size = 256;
+
+    if (thresholdCount % block_size == 0)
+        thresholdBlocks.emplace_back (
+            new std::atomic<LogLevel>[block_size]);
+
+    std::atomic<LogLevel> & slot
+        = thresholdBlocks.back ()[thresholdCount % block_size];
+    ++ thresholdCount;
+
+    // Everything is enabled until the logger is linked into the
+    // hierarchy and refreshThreshold() computes the real value.
+    slot.store (NOT_SET_LOG_LEVEL, std::memory_order_relaxed);
+    return &slot;
+}
+
+
+void
+Hierarchy::refreshThresholds()
+{
+    if (transaction_depth.load (std::memory_order_relaxed) > 0)
+    {
+        pending_thresholds.store (true, std::memory_order_relaxed);
+        return;
+    }
+
+    thread::MutexGuard guard (hashtable_mutex);
+
+    // The root logger sets its LogLevel during Hierarchy
+    // construction, before the root member is assigned; its slot is
+    // refreshed explicitly by the Hierarchy constructor afterwards.
+    if (! root.value)
+        return;
+
+    root.value->refreshThreshold();
+    for (auto & kv : loggerPtrs)
+        kv.second.value->refreshThreshold();
+
+    // Partition loggers inherit through the fallthrough link to this
+    // hierarchy's root; keep their slots in step.
+    for (auto & part : partitions)
+        part.second->refreshThresholds ();
+}
+
+
+void
+Hierarchy::refreshAppenderChains()
+{
+    if (transaction_depth.load (std::memory_order_relaxed) > 0)
+    {
+        pending_appender_chains.store (true, std::memory_order_relaxed);
+        return;
+    }
+
+    thread::MutexGuard guard (hashtable_mutex);
+
+    // See the comment in refreshThresholds() about the root member
+    // during Hierarchy construction.
+    if (! root.value)
+        return;
+
+    root.value->refreshAppenderChain();
+    for (auto & kv : loggerPtrs)
+        kv.second.value->refreshAppenderChain();
+
+    // The routing table flattens the same parent links and
+    // additivity flags one step further; rebuild it from the fresh
+    // chains.
+    rebuildRoutingTable();
+}
+
+
+std::size_t
+Hierarchy::allocateLoggerId()
+{
+    return loggerIdCount++;
+}
+
+
+void
+Hierarchy::rebuildRoutingTable()
+{
+    if (transaction_depth.load (std::memory_order_relaxed) > 0)
+    {
+        pending_routing_table.store (true, std::memory_order_relaxed);
+        return;
+    }
+
+    thread::MutexGuard guard (hashtable_mutex);
+
+    // See the comment in refreshThresholds() about the root member
+    // during Hierarchy construction.
+    if (! root.value)
+        return;
+
+    // First pass: gather each logger's reachable appender set along
+    // its ancestor chain and intern every distinct appender into the
+    // registry. Loggers whose fan-out the bitmask walk cannot
+    // reproduce keep the fallback mask and walk their chain.
+    std::vector<SharedAppenderPtr> registry;
+    std::vector<std::pair<std::size_t, SharedAppenderPtrList>> routed;
+    routed.reserve (loggerPtrs.size () + 1);
+    bool overflow = false;
+
+    auto const collect = [&](spi::LoggerImpl * logger)
+    {
+        SharedAppenderPtrList reachable;
+        for (spi::LoggerImpl * c = logger; c != nullptr;
+            c = c->parent.get ())
+        {
+            if (c->getParallelFanout ())
+                // Parallel fan-out delivers through the chain
+                // logger's own appender list; keep the fallback mask.
+                return;
+
+            SharedAppenderPtrList appenders = c->getAllAppenders ();
+            reachable.insert (reachable.end (),
+                std::make_move_iterator (appenders.begin ()),
+                std::make_move_iterator (appenders.end ()));
+            if (! c->additive)
+                break;
+        }
+
+        for (SharedAppenderPtr const & appender : reachable)
+        {
+            if (std::find (registry.begin (), registry.end (), appender)
+                != registry.end ())
+                continue;
+            if (registry.size () == routingMaxAppenders)
+            {
+                overflow = true;
+                return;
+            }
+            registry.push_back (appender);
+        }
+
+        routed.emplace_back (logger->loggerId, std::move (reachable));
+    };
+
+    collect (root.value);
+    for (auto & kv : loggerPtrs)
+    {
+        if (overflow)
+            break;
+        collect (kv.second.value);
+    }
+
+    if (overflow)
+    {
+        // More distinct appenders than mask bits; drop the table and
+        // let every logger walk its flattened chain.
+        std::atomic_store_explicit (&routingTable, RoutingTablePtr (),
+            std::memory_order_release);
+        return;
+    }
+
+    // Order the registry by ascending threshold as of this rebuild.
+    // The mask walk still checks each appender's live threshold,
+    // because Appender::setThreshold() can change thresholds without
+    // triggering a rebuild; the order only keeps the appenders most
+    // likely to accept an event at the front of the walk.
+    std::stable_sort (registry.begin (), registry.end (),
+        [](SharedAppenderPtr const & lhs, SharedAppenderPtr const & rhs)
+        {
+            return lhs->getThreshold () < rhs->getThreshold ();
+        });
+
+    // Second pass: resolve each reachable set into a bitmask over
+    // the sorted registry.
+    auto table = std::make_shared<RoutingTable> ();
+    table->masks.assign (loggerIdCount, routingFallbackMask);
+    for (auto & entry : routed)
+    {
+        std::uint64_t mask = 0;
+        for (SharedAppenderPtr const & appender : entry.second)
+            mask |= std::uint64_t (1)
+                << (std::find (registry.begin (), registry.end (),
+                        appender)
+                    - registry.begin ());
+        table->masks[entry.first] = mask;
+    }
+    table->appenders = std::move (registry);
+
+    std::atomic_store_explicit (&routingTable,
+        RoutingTablePtr (std::move (table)), std::memory_order_release);
+
+    // Partition routing tables resolve this hierarchy's root
+    // appenders through the fallthrough link; rebuild them against
+    // the new state.
+    for (auto & part : partitions)
+        part.second->rebuildRoutingTable ();
+}
+
+
+Hierarchy::RoutingTablePtr
+Hierarchy::getRoutingTable() const
+{
+    return std::atomic_load_explicit (&routingTable,
+        std::memory_order_acquire);
+}
+
+
+void
+Hierarchy::bumpEpoch()
+{
+    if (transaction_depth.load (std::memory_order_relaxed) > 0)
+    {
+        pending_epoch.store (true, std::memory_order_relaxed);
+        return;
+    }
+
+    epoch.fetch_add (1, std::memory_order_relaxed);
+}
+
+
+Hierarchy::ConfigurationTransaction::ConfigurationTransaction (
+    Hierarchy & hier)
+    : hierarchy (hier)
+{
+    hierarchy.transaction_depth.fetch_add (1, std::memory_order_relaxed);
+}
+
+
+Hierarchy::ConfigurationTransaction::~ConfigurationTransaction ()
+{
+    if (hierarchy.transaction_depth.fetch_sub (1,
+            std::memory_order_acq_rel) != 1)
+        return;
+
+    // Outermost transaction closed; apply each deferred rebuild once
+    // and publish one epoch bump.
+    if (hierarchy.pending_thresholds.exchange (false,
+            std::memory_order_relaxed))
+        hierarchy.refreshThresholds ();
+    if (hierarchy.pending_appender_chains.exchange (false,
+            std::memory_order_relaxed))
+        hierarchy.refreshAppenderChains ();
+    if (hierarchy.pending_routing_table.exchange (false,
+            std::memory_order_relaxed))
+        hierarchy.rebuildRoutingTable ();
+    if (hierarchy.pending_epoch.exchange (false,
+            std::memory_order_relaxed))
+        hierarchy.epoch.fetch_add (1, std::memory_order_relaxed);
+}
+
+
+void
+Hierarchy::loggerNameFilterAdd (tstring_view name)
+{
+    // Two probes derived from one hash, double hashing style. The
+    // relaxed stores are ordered before readers can see the logger:
+    // the snapshot holding it is published with a release store.
+    std::size_t const h = std::hash<tstring_view> () (name);
+    std::uint64_t const h2 = (h >> 32) | 1;
+    for (unsigned i = 0; i != 2; ++i)
+    {
+        std::size_t const bit
+            = (h + i * h2) % (loggerNameFilterWords * 64);
+        loggerNameFilter[bit / 64].fetch_or (
+            std::uint64_t (1) << (bit % 64), std::memory_order_relaxed);
+    }
+}
+
+
+bool
+Hierarchy::loggerNameFilterContains (tstring_view name) const
+{
+    std::size_t const h = std::hash<tstring_view> () (name);
+    std::uint64_t const h2 = (h >> 32) | 1;
+    for (unsigned i = 0; i != 2; ++i)
+    {
+        std::size_t const bit
+            = (h + i * h2) % (loggerNameFilterWords * 64);
+        if (! (loggerNameFilter[bit / 64].load (std::memory_order_relaxed)
+                & (std::uint64_t (1) << (bit % 64))))
+            return false;
+    }
+
+    return true;
+}
+
+
+void
+Hierarchy::publishSnapshot()
+{
+    // Copying the whole map makes insertion of a new logger O(n) but
+    // keeps lookups of existing loggers entirely lock-free. Logger
+    // creation is rare compared to retrieval.
+    std::atomic_store_explicit (&loggerPtrsSnapshot,
+        LoggerMapSnapshot (std::make_shared<LoggerMap const> (loggerPtrs)),
+        std::memory_order_release);
+}
+
+
 void
 Hierarchy::updateChildren(ProvisionNode& pn, Logger const & logger)
 {
@@ -60,6 +60,68 @@ Layout::Layout (const log4cplus::helpers::Properties&)
 Layout::~Layout() = default;
 
 
+std::size_t
+Layout::getFormatKey () const
+{
+    return 0;
+}
+
+
+unsigned
+Layout::getNeededEventFields () const
+{
+    // A layout of unknown format may reference any field.
+    return spi::EventFieldAll;
+}
+
+
+void
+Layout::formatAndAppendBatch (log4cplus::tostream& output,
+    const log4cplus::spi::InternalLoggingEvent* events, std::size_t count)
+{
+    for (std::size_t i = 0; i != count; ++i)
+        formatAndAppend (output, events[i]);
+}
+
+
+tstring const &
+Layout::getHeader ()
+{
+    if (! headerRendered)
+    {
+        header = renderHeader ();
+        headerRendered = true;
+    }
+    return header;
+}
+
+
+tstring const &
+Layout::getFooter ()
+{
+    if (! footerRendered)
+    {
+        footer = renderFooter ();
+        footerRendered = true;
+    }
+    return footer;
+}
+
+
+tstring
+Layout::renderHeader ()
+{
+    return tstring ();
+}
+
+
+tstring
+Layout::renderFooter ()
+{
+    return tstring ();
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // log4cplus::SimpleLayout public methods
 ///////////////////////////////////////////////////////////////////////////////
@@ -86,6 +148,13 @@ SimpleLayout::formatAndAppend(log4cplus::tostream& output,
 }
 
 
+unsigned
+SimpleLayout::getNeededEventFields () const
+{
+    return 0;
+}
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // log4cplus::TTCCLayout ctors and dtor
@@ -122,37 +191,82 @@ TTCCLayout::~TTCCLayout() = default;
 ///////////////////////////////////////////////////////////////////////////////
 
 void
-TTCCLayout::formatAndAppend(log4cplus::tostream& output,
-                            const log4cplus::spi::InternalLoggingEvent& event)
+TTCCLayout::appendLine(log4cplus::tstring& buf,
+                       const log4cplus::spi::InternalLoggingEvent& event)
 {
-     if (dateFormat.empty ())
-         formatRelativeTimestamp (output, event);
-     else
-         output << helpers::getFormattedTime(dateFormat, event.getTimestamp(),
-             use_gmtime);
-
-     if (getThreadPrinting ())
-         output << LOG4CPLUS_TEXT(" [")
-                << event.getThread()
-                << LOG4CPLUS_TEXT("] ");
-     else
-         output << LOG4CPLUS_TEXT(' ');
+    if (dateFormat.empty ())
+    {
+        auto const duration
+            = event.getTimestamp () - getTTCCLayoutTimeBase ();
+        helpers::convertIntegerToString (formattedTime,
+            helpers::chrono::duration_cast<
+                helpers::chrono::duration<long long, std::milli>>(
+                    duration).count ());
+        buf.append (formattedTime);
+    }
+    else
+    {
+        if (! dateFormatter)
+            dateFormatter.emplace (dateFormat, use_gmtime);
+        dateFormatter->format (buf, event.getTimestamp ());
+    }
+
+    if (thread_printing)
+    {
+        buf.append (LOG4CPLUS_TEXT(" ["));
+        buf.append (event.getThread());
+        buf.append (LOG4CPLUS_TEXT("] "));
+    }
+    else
+        buf.push_back (LOG4CPLUS_TEXT(' '));
+
+    buf.append (llmCache.toString(event.getLogLevel()));
+    buf.push_back (LOG4CPLUS_TEXT(' '));
+
+    if (category_prefixing)
+    {
+        buf.append (event.getLoggerName());
+        buf.push_back (LOG4CPLUS_TEXT(' '));
+    }
+
+    if (context_printing)
+    {
+        buf.push_back (LOG4CPLUS_TEXT('<'));
+        buf.append (event.getNDC());
+        buf.append (LOG4CPLUS_TEXT("> "));
+    }
+
+    buf.append (LOG4CPLUS_TEXT("- "));
+    buf.append (event.getMessage());
+    buf.push_back (LOG4CPLUS_TEXT('\n'));
+}
 
-     output << llmCache.toString(event.getLogLevel())
-            << LOG4CPLUS_TEXT(' ');
 
-     if (getCategoryPrefixing ())
-         output << event.getLoggerName()
-                << LOG4CPLUS_TEXT(' ');
+void
+TTCCLayout::formatAndAppend(log4cplus::tostream& output,
+                            const log4cplus::spi::InternalLoggingEvent& event)
+{
+    // Assemble the whole line in a reusable per-thread string buffer
+    // and hand it to the stream in a single write, paying the stream
+    // sentry cost once per event rather than once per field.
+    tstring & buf = internal::get_ptd ()->layout_str;
+    buf.clear ();
+    appendLine (buf, event);
+    output.write (buf.data (), static_cast<std::streamsize>(buf.size ()));
+}
 
-     if (getContextPrinting ())
-         output << LOG4CPLUS_TEXT("<")
-                << event.getNDC()
-                << LOG4CPLUS_TEXT("> ");
 
-     output << LOG4CPLUS_TEXT("- ")
-            << event.getMessage()
-            << LOG4CPLUS_TEXT("\n");
+void
+TTCCLayout::formatAndAppendBatch(log4cplus::tostream& output,
+    const log4cplus::spi::InternalLoggingEvent* events, std::size_t count)
+{
+    // Assemble the whole batch in the per-thread buffer and write it
+    // out in one go.
+    tstring & buf = internal::get_ptd ()->layout_str;
+    buf.clear ();
+    for (std::size_t i = 0; i != count; ++i)
+        appendLine (buf, events[i]);
+    output.write (buf.data (), static_cast<std::streamsize>(buf.size ()));
 }
 
 
@@ -198,4 +312,141 @@ TTCCLayout::setContextPrinting(bool context_printing_)
 }
 
 
+unsigned
+TTCCLayout::getNeededEventFields () const
+{
+    // Thread and context printing can be toggled after the layout
+    // has been attached, so both fields are claimed regardless of
+    // the current flags.
+    return spi::EventFieldThread | spi::EventFieldNDC;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// log4cplus::BinaryLayout ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+static
+void
+put_byte (log4cplus::tostream & output, unsigned char byte)
+{
+    output.put (static_cast<tchar>(byte));
+}
+
+
+static
+void
+put_varint (log4cplus::tostream & output, unsigned long long value)
+{
+    while (value >= 0x80)
+    {
+        put_byte (output,
+            static_cast<unsigned char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    put_byte (output, static_cast<unsigned char>(value));
+}
+
+
+static
+unsigned long long
+zigzag_encode (long long value)
+{
+    return (static_cast<unsigned long long>(value) << 1)
+        ^ static_cast<unsigned long long>(value >> 63);
+}
+
+
+static
+void
+put_bytes (log4cplus::tostream & output, std::string const & bytes)
+{
+    for (char ch : bytes)
+        put_byte (output, static_cast<unsigned char>(ch));
+}
+
+} // namespace
+
+
+BinaryLayout::BinaryLayout () = default;
+
+
+BinaryLayout::BinaryLayout (const helpers::Properties& properties)
+    : Layout (properties)
+{ }
+
+
+BinaryLayout::~BinaryLayout() = default;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// log4cplus::BinaryLayout public methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+BinaryLayout::formatAndAppend(log4cplus::tostream& output,
+                              const log4cplus::spi::InternalLoggingEvent& event)
+{
+    if (! headerWritten)
+    {
+        put_byte (output, 'L');
+        put_byte (output, '4');
+        put_byte (output, 'C');
+        put_byte (output, 'B');
+        put_byte (output, 1);
+        headerWritten = true;
+    }
+
+    auto const inserted = loggerIds.emplace (event.getLoggerName (),
+        loggerIds.size () + 1);
+    std::size_t const logger_id = inserted.first->second;
+    if (inserted.second)
+    {
+        std::string const logger_name
+            = LOG4CPLUS_TSTRING_TO_STRING (event.getLoggerName ());
+        put_byte (output, 'L');
+        put_varint (output, logger_id);
+        put_varint (output, logger_name.size ());
+        put_bytes (output, logger_name);
+    }
+
+    long long const timestamp
+        = event.getTimestamp ().time_since_epoch ().count ();
+    std::string const message
+        = LOG4CPLUS_TSTRING_TO_STRING (event.getMessage ());
+
+    // The delivering appender may have stamped a sequence number on
+    // the event; see the Appender SequenceNumbers property.
+    std::uint64_t const sequence
+        = internal::get_ptd ()->appender_sequence;
+    if (sequence != 0)
+    {
+        put_byte (output, 'S');
+        put_varint (output, sequence);
+    }
+
+    put_byte (output, 'E');
+    put_varint (output, logger_id);
+    put_varint (output, static_cast<unsigned long long>(
+        event.getLogLevel ()));
+    put_varint (output, zigzag_encode (timestamp - lastTimestamp));
+    put_varint (output, message.size ());
+    put_bytes (output, message);
+
+    lastTimestamp = timestamp;
+}
+
+
+unsigned
+BinaryLayout::getNeededEventFields () const
+{
+    // The records carry only the logger, level, timestamp and
+    // message.
+    return 0;
+}
+
+
 } // namespace log4cplus
@@ -81,6 +81,16 @@
 #error "no usable file locking"
 #endif
 
+// The shared mutex fast path needs process shared robust mutexes;
+// glibc implements them on top of futexes, so an uncontended
+// lock/unlock pair stays entirely in user space.
+#if defined (__linux__) && defined (LOG4CPLUS_USE_POSIX_LOCKING)
+#  define LOG4CPLUS_USE_SHARED_MUTEX
+#  include <pthread.h>
+#  include <sys/mman.h>
+#  include <cstdint>
+#endif
+
 namespace log4cplus::helpers {
 
 
@@ -167,6 +177,83 @@ trySetCloseOnExec (int fd)
 }
 
 
+#if defined (LOG4CPLUS_USE_SHARED_MUTEX)
+
+namespace
+{
+
+//! Contents of the mutex sidecar file, mapped into every
+//! participating process.
+struct SharedMutexData
+{
+    pthread_mutex_t mtx;
+    std::uint32_t initialized;
+};
+
+std::uint32_t const shared_mutex_magic = 0x4c344d58; // "L4MX"
+
+
+//! Maps the mutex sidecar file of \c lock_file_name and initializes
+//! the robust mutex in it on first use. The caller holds the file
+//! lock, which serializes the one-time initialization between
+//! processes. Returns nullptr on failure; the caller then keeps
+//! using file locking.
+static
+SharedMutexData *
+attach_shared_mutex (tstring const & lock_file_name)
+{
+    std::string const path
+        = LOG4CPLUS_TSTRING_TO_STRING (lock_file_name) + ".mtx";
+    int fd = ::open (path.c_str (), OPEN_FLAGS, OPEN_MODE);
+    if (fd == -1)
+    {
+        getLogLog ().warn (
+            tstring (LOG4CPLUS_TEXT ("could not open or create file "))
+            + LOG4CPLUS_STRING_TO_TSTRING (path));
+        return nullptr;
+    }
+
+    SharedMutexData * shm = nullptr;
+    if (ftruncate (fd, sizeof (SharedMutexData)) == 0)
+    {
+        void * mem = mmap (nullptr, sizeof (SharedMutexData),
+            PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mem != MAP_FAILED)
+            shm = static_cast<SharedMutexData *>(mem);
+    }
+
+    // The mapping keeps the file alive; the descriptor is not needed
+    // any more.
+    ::close (fd);
+
+    if (! shm)
+    {
+        getLogLog ().warn (
+            tstring (LOG4CPLUS_TEXT ("could not map mutex file "))
+            + LOG4CPLUS_STRING_TO_TSTRING (path)
+            + LOG4CPLUS_TEXT (", falling back to file locking"));
+        return nullptr;
+    }
+
+    if (shm->initialized != shared_mutex_magic)
+    {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init (&attr);
+        pthread_mutexattr_setpshared (&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust (&attr, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init (&shm->mtx, &attr);
+        pthread_mutexattr_destroy (&attr);
+        shm->initialized = shared_mutex_magic;
+    }
+
+    return shm;
+}
+
+} // namespace
+
+#endif // LOG4CPLUS_USE_SHARED_MUTEX
+
+
 //
 //
 //
@@ -177,6 +264,10 @@ struct LockFile::Impl
     || defined (_WIN32)
     int fd;
 
+#endif
+#if defined (LOG4CPLUS_USE_SHARED_MUTEX)
+    SharedMutexData * shm = nullptr;
+
 #endif
 };
 
@@ -185,7 +276,8 @@ struct LockFile::Impl
 //
 //
 
-LockFile::LockFile (tstring const & lf, bool create_dirs_)
+LockFile::LockFile (tstring const & lf, bool create_dirs_,
+    bool use_shared_mutex)
     : lock_file_name (lf)
     , data (new LockFile::Impl)
     , create_dirs (create_dirs_)
@@ -196,6 +288,25 @@ LockFile::LockFile (tstring const & lf, bool create_dirs_)
 #else
     open (OPEN_FLAGS);
 
+#endif
+
+#if defined (LOG4CPLUS_USE_SHARED_MUTEX)
+    if (use_shared_mutex)
+    {
+        // Serialize the one-time mutex initialization between
+        // processes through the file lock. data->shm is published
+        // only after the unlock so that both lock() and unlock()
+        // still take the syscall path here.
+        lock ();
+        SharedMutexData * const shm
+            = attach_shared_mutex (lock_file_name);
+        unlock ();
+        data->shm = shm;
+    }
+
+#else
+    (void) use_shared_mutex;
+
 #endif
 }
 
@@ -203,6 +314,11 @@ LockFile::LockFile (tstring const & lf, bool create_dirs_)
 LockFile::~LockFile ()
 {
     close ();
+#if defined (LOG4CPLUS_USE_SHARED_MUTEX)
+    if (data->shm)
+        munmap (data->shm, sizeof (SharedMutexData));
+
+#endif
     delete data;
 }
 
@@ -274,6 +390,29 @@ LockFile::lock () const
     (void) loglog;
     (void) ret;
 
+#if defined (LOG4CPLUS_USE_SHARED_MUTEX)
+    if (data->shm)
+    {
+        ret = pthread_mutex_lock (&data->shm->mtx);
+        if (ret == EOWNERDEAD)
+        {
+            // A lock holder died; the mutex is handed to us marked
+            // inconsistent. The protected log file is append only, so
+            // making the mutex consistent again is all the recovery
+            // needed.
+            pthread_mutex_consistent (&data->shm->mtx);
+            loglog.warn (
+                LOG4CPLUS_TEXT ("shared mutex holder died,")
+                LOG4CPLUS_TEXT (" recovered the mutex"));
+        }
+        else if (ret != 0)
+            loglog.error (
+                tstring (LOG4CPLUS_TEXT ("pthread_mutex_lock() failed: "))
+                + convertIntegerToString (ret), true);
+        return;
+    }
+
+#endif
 #if defined (LOG4CPLUS_USE_WIN32_LOCKFILEEX)
     HANDLE fh = get_os_HANDLE (data->fd);
 
@@ -334,6 +473,18 @@ void LockFile::unlock () const
 {
     int ret = 0;
 
+#if defined (LOG4CPLUS_USE_SHARED_MUTEX)
+    if (data->shm)
+    {
+        ret = pthread_mutex_unlock (&data->shm->mtx);
+        if (ret != 0)
+            getLogLog ().error (
+                tstring (LOG4CPLUS_TEXT ("pthread_mutex_unlock() failed: "))
+                + convertIntegerToString (ret), true);
+        return;
+    }
+
+#endif
 #if defined (LOG4CPLUS_USE_WIN32_LOCKFILEEX)
     HANDLE fh = get_os_HANDLE (data->fd);
 
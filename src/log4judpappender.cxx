@@ -34,6 +34,14 @@
 #include <cctype>
 #endif
 #include <memory>
+#include <vector>
+
+#if defined (__linux__)
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#define LOG4CPLUS_USE_SENDMMSG 1
+#endif
 
 
 namespace log4cplus
@@ -126,6 +134,63 @@ operator << (tostream & os, outputXMLEscaped const & x)
 }
 
 
+#if defined (LOG4CPLUS_USE_SENDMMSG)
+
+//! Socket subclass whose only purpose is exposing the raw descriptor
+//! needed by sendmmsg().
+class UdpSocket
+    : public helpers::Socket
+{
+public:
+    explicit UdpSocket (helpers::Socket && other)
+        : Socket (std::move (other))
+    { }
+
+    int getFd () const
+    {
+        return static_cast<int>(sock);
+    }
+};
+
+
+//! Sends each payload as its own datagram, batching the syscalls with
+//! sendmmsg().
+static
+bool
+send_datagrams (int fd, std::vector<std::string> const & payloads)
+{
+    std::vector<struct mmsghdr> msgs (payloads.size ());
+    std::vector<struct iovec> iovs (payloads.size ());
+    for (std::size_t i = 0; i != payloads.size (); ++i)
+    {
+        std::memset (&msgs[i], 0, sizeof (msgs[i]));
+        iovs[i].iov_base = const_cast<char *>(payloads[i].data ());
+        iovs[i].iov_len = payloads[i].size ();
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    std::size_t sent = 0;
+    while (sent != msgs.size ())
+    {
+        int const res = sendmmsg (fd, &msgs[sent],
+            static_cast<unsigned>(msgs.size () - sent), 0);
+        if (res == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return false;
+        }
+
+        sent += static_cast<std::size_t>(res);
+    }
+
+    return true;
+}
+
+#endif // LOG4CPLUS_USE_SENDMMSG
+
 } // namespace
 
 
@@ -138,6 +203,9 @@ Log4jUdpAppender::Log4jUdpAppender(const tstring& host_, int port_, bool ipv6_)
     , port(port_)
     , ipv6(ipv6_)
 {
+    // The XML elements carry the NDC and thread name regardless of
+    // the layout, which only renders the message.
+    spi::addNeededEventFields (spi::EventFieldNDC | spi::EventFieldThread);
     layout = std::make_unique<PatternLayout> (LOG4CPLUS_TEXT ("%m"));
     openSocket();
 }
@@ -148,10 +216,14 @@ Log4jUdpAppender::Log4jUdpAppender(const helpers::Properties & properties)
     : Appender(properties)
     , port(5000)
 {
+    spi::addNeededEventFields (spi::EventFieldNDC | spi::EventFieldThread);
     host = properties.getProperty( LOG4CPLUS_TEXT("host"),
         LOG4CPLUS_TEXT ("localhost") );
     properties.getInt (port, LOG4CPLUS_TEXT ("port"));
     properties.getBool (ipv6, LOG4CPLUS_TEXT ("IPv6"));
+    properties.getUInt (maxBatchDatagrams,
+        LOG4CPLUS_TEXT ("MaxBatchDatagrams"));
+    properties.getUInt (maxBatchBytes, LOG4CPLUS_TEXT ("MaxBatchBytes"));
 
     openSocket();
 }
@@ -193,19 +265,9 @@ Log4jUdpAppender::openSocket()
     }
 }
 
-void
-Log4jUdpAppender::append(const spi::InternalLoggingEvent& event)
+std::string const &
+Log4jUdpAppender::formatPayload(const spi::InternalLoggingEvent& event)
 {
-    if(!socket.isOpen()) {
-        openSocket();
-        if(!socket.isOpen()) {
-            helpers::getLogLog().error(
-                LOG4CPLUS_TEXT("Log4jUdpAppender::append()")
-                LOG4CPLUS_TEXT("- Cannot connect to server"));
-            return;
-        }
-    }
-
     tstring & str = formatEvent (event);
 
     internal::appender_sratch_pad & appender_sp
@@ -246,8 +308,23 @@ Log4jUdpAppender::append(const spi::InternalLoggingEvent& event)
            << LOG4CPLUS_TEXT("</log4j:event>");
 
     appender_sp.chstr = LOG4CPLUS_TSTRING_TO_STRING (buffer.str ());
+    return appender_sp.chstr;
+}
+
+void
+Log4jUdpAppender::append(const spi::InternalLoggingEvent& event)
+{
+    if(!socket.isOpen()) {
+        openSocket();
+        if(!socket.isOpen()) {
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("Log4jUdpAppender::append()")
+                LOG4CPLUS_TEXT("- Cannot connect to server"));
+            return;
+        }
+    }
 
-    bool ret = socket.write(appender_sp.chstr);
+    bool ret = socket.write(formatPayload (event));
     if (!ret)
     {
         helpers::getLogLog().error(
@@ -256,4 +333,67 @@ Log4jUdpAppender::append(const spi::InternalLoggingEvent& event)
     }
 }
 
+void
+Log4jUdpAppender::appendBatch(const spi::InternalLoggingEvent* events,
+    std::size_t count)
+{
+#if defined (LOG4CPLUS_USE_SENDMMSG)
+    if (count <= 1 || maxBatchDatagrams <= 1)
+    {
+        Appender::appendBatch (events, count);
+        return;
+    }
+
+    if(!socket.isOpen()) {
+        openSocket();
+        if(!socket.isOpen()) {
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("Log4jUdpAppender::appendBatch()")
+                LOG4CPLUS_TEXT("- Cannot connect to server"));
+            return;
+        }
+    }
+
+    // Borrow the raw descriptor for the duration of the batch.
+    UdpSocket usock (std::move (socket));
+
+    // Each event becomes its own datagram; the payloads of up to
+    // MaxBatchDatagrams events (or MaxBatchBytes bytes) are handed to
+    // the kernel with a single sendmmsg() call.
+    std::vector<std::string> payloads;
+    payloads.reserve ((std::min) (count,
+        static_cast<std::size_t>(maxBatchDatagrams)));
+    std::size_t batch_bytes = 0;
+    bool ok = true;
+
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        std::string const & payload = formatPayload (events[i]);
+        batch_bytes += payload.size ();
+        payloads.push_back (payload);
+
+        if (payloads.size () == maxBatchDatagrams
+            || batch_bytes >= maxBatchBytes)
+        {
+            ok = send_datagrams (usock.getFd (), payloads) && ok;
+            payloads.clear ();
+            batch_bytes = 0;
+        }
+    }
+
+    if (! payloads.empty ())
+        ok = send_datagrams (usock.getFd (), payloads) && ok;
+
+    socket = std::move (usock);
+
+    if (! ok)
+        helpers::getLogLog().error(
+            LOG4CPLUS_TEXT(
+                "Log4jUdpAppender::appendBatch()- Cannot write to server"));
+
+#else
+    Appender::appendBatch (events, count);
+#endif
+}
+
 } // namespace log4cplus
@@ -100,6 +100,13 @@ Logger::shutdown ()
 }
 
 
+void
+Logger::shutdown (std::chrono::milliseconds budget)
+{
+    getDefaultHierarchy ().shutdown (budget);
+}
+
+
 //////////////////////////////////////////////////////////////////////////////
 // Logger ctors and dtor
 //////////////////////////////////////////////////////////////////////////////
@@ -196,7 +203,7 @@ Logger::getAllAppenders ()
 
 
 SharedAppenderPtr
-Logger::getAppender (const log4cplus::tstring& name)
+Logger::getAppender (const log4cplus::tstring_view& name)
 {
     return value->getAppender (name);
 }
@@ -217,7 +224,7 @@ Logger::removeAppender (SharedAppenderPtr appender)
 
 
 void
-Logger::removeAppender (const log4cplus::tstring& name)
+Logger::removeAppender (const log4cplus::tstring_view& name)
 {
     value->removeAppender (name);
 }
@@ -253,6 +260,24 @@ Logger::log (LogLevel ll, const log4cplus::tstring_view& message,
 }
 
 
+void
+Logger::log (LogLevel ll, log4cplus::tstring&& message,
+    const char* file, int line, const char* function) const
+{
+    value->log (ll, std::move (message), file, line,
+        function ? function : "");
+}
+
+
+void
+Logger::log (LogLevel ll, const log4cplus::tchar* message,
+    const char* file, int line, const char* function) const
+{
+    value->log (ll, log4cplus::tstring_view (message), file, line,
+        function ? function : "");
+}
+
+
 void
 Logger::log (spi::InternalLoggingEvent const & ev) const
 {
@@ -268,6 +293,24 @@ Logger::forcedLog (LogLevel ll, const log4cplus::tstring_view& message,
 }
 
 
+void
+Logger::forcedLog (LogLevel ll, log4cplus::tstring&& message,
+    const char* file, int line, const char* function) const
+{
+    value->forcedLog (ll, std::move (message), file, line,
+        function ? function : "");
+}
+
+
+void
+Logger::forcedLog (LogLevel ll, const log4cplus::tchar* message,
+    const char* file, int line, const char* function) const
+{
+    value->forcedLog (ll, log4cplus::tstring_view (message), file, line,
+        function ? function : "");
+}
+
+
 void
 Logger::forcedLog (spi::InternalLoggingEvent const & ev) const
 {
@@ -331,4 +374,32 @@ Logger::setAdditivity (bool additive)
 }
 
 
+std::size_t
+Logger::getMaxMessageSize () const
+{
+    return value->getMaxMessageSize ();
+}
+
+
+void
+Logger::setMaxMessageSize (std::size_t limit)
+{
+    value->setMaxMessageSize (limit);
+}
+
+
+void
+Logger::setDefaultMaxMessageSize (std::size_t limit)
+{
+    spi::LoggerImpl::setDefaultMaxMessageSize (limit);
+}
+
+
+std::size_t
+Logger::getDefaultMaxMessageSize ()
+{
+    return spi::LoggerImpl::getDefaultMaxMessageSize ();
+}
+
+
 } // namespace log4cplus
@@ -26,19 +26,37 @@
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/spi/rootlogger.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <memory>
+#include <utility>
 
 
 namespace log4cplus::spi {
 
+namespace
+{
+
+//! Process wide default maximum message size; 0 disables the check.
+static std::atomic<std::size_t> default_max_message_size (0);
+
+//! Marker appended to messages cut down to the maximum message size.
+static tchar const truncation_suffix[] = LOG4CPLUS_TEXT ("...[truncated]");
+
+} // namespace
+
+
 //////////////////////////////////////////////////////////////////////////////
 // Logger Constructors and Destructor
 //////////////////////////////////////////////////////////////////////////////
 LoggerImpl::LoggerImpl(const log4cplus::tstring_view& name_, Hierarchy& h)
-  : name(name_),
+  : name(std::make_shared<log4cplus::tstring const>(name_)),
     ll(NOT_SET_LOG_LEVEL),
     parent(nullptr),
     additive(true),
-    hierarchy(h)
+    maxMessageSize(0),
+    hierarchy(h),
+    loggerId(h.allocateLoggerId()),
+    effectiveThreshold(h.allocateThresholdSlot())
 {
 }
 
@@ -54,10 +72,55 @@ void
 LoggerImpl::callAppenders(const InternalLoggingEvent& event)
 {
     int writes = 0;
-    for(const LoggerImpl* c = this; c != nullptr; c=c->parent.get()) {
-        writes += c->appendLoopOnAppenders(event);
-        if(!c->additive) {
-            break;
+
+    // The routing table pre-resolves this logger's whole fan-out
+    // into one bitmask over the hierarchy's appender registry, so
+    // the common case is a single array load and a walk of the set
+    // bits.
+    Hierarchy::RoutingTablePtr const table = hierarchy.getRoutingTable ();
+    std::uint64_t mask;
+    if (table && loggerId < table->masks.size ()
+        && (mask = table->masks[loggerId])
+            != Hierarchy::routingFallbackMask)
+    {
+        LogLevel const ll = event.getLogLevel ();
+        for (std::size_t i = 0; mask != 0; ++i, mask >>= 1)
+        {
+            if (! (mask & 1))
+                continue;
+            ++writes;
+            // Bit order is ascending threshold order only as of the
+            // last table rebuild; Appender::setThreshold() can change
+            // thresholds without one, so check each appender's live
+            // threshold. Rejected appenders still count against the
+            // "no appenders" warning, as a doAppend() call would.
+            if (table->appenders[i]->getThreshold () <= ll)
+                table->appenders[i]->doAppend (event);
+        }
+    }
+    else
+    {
+        // The flattened ancestor chain lets an event visit its appender
+        // attachable loggers by iterating a contiguous array instead of
+        // chasing parent pointers and re-checking additivity per level.
+        AppenderChainPtr const chain = std::atomic_load_explicit (
+            &appenderChain, std::memory_order_acquire);
+        if (chain)
+        {
+            for (LoggerImpl * c : *chain)
+                writes += c->appendLoopOnAppenders(event);
+        }
+        else
+        {
+            // The chain is only published once this logger has been
+            // linked into the hierarchy; until then walk the parent
+            // links directly.
+            for(const LoggerImpl* c = this; c != nullptr; c=c->parent.get()) {
+                writes += c->appendLoopOnAppenders(event);
+                if(!c->additive) {
+                    break;
+                }
+            }
         }
     }
 
@@ -90,10 +153,11 @@ LoggerImpl::closeNestedAppenders()
 bool
 LoggerImpl::isEnabledFor(LogLevel loglevel) const
 {
-    if(hierarchy.disableValue >= loglevel) {
-        return false;
-    }
-    return loglevel >= getChainedLogLevel();
+    // The slot already combines the chained LogLevel with the
+    // hierarchy's disable value; it is recomputed eagerly on every
+    // configuration change, so one relaxed load decides.
+    return loglevel
+        >= effectiveThreshold->load (std::memory_order_relaxed);
 }
 
 
@@ -110,6 +174,20 @@ LoggerImpl::log(LogLevel loglevel,
 }
 
 
+void
+LoggerImpl::log(LogLevel loglevel,
+                log4cplus::tstring&& message,
+                const char* file,
+                int line,
+                const char* function)
+{
+    if(isEnabledFor(loglevel)) {
+        forcedLog(loglevel, std::move (message), file, line,
+            function ? function : "");
+    }
+}
+
+
 void
 LoggerImpl::log(spi::InternalLoggingEvent const & ev)
 {
@@ -134,6 +212,51 @@ LoggerImpl::getChainedLogLevel() const
 }
 
 
+void
+LoggerImpl::setLogLevel(LogLevel _ll)
+{
+    ll = _ll;
+    // Descendants may chain to this logger's LogLevel; recompute the
+    // whole effective threshold table.
+    hierarchy.refreshThresholds ();
+}
+
+
+void
+LoggerImpl::refreshThreshold()
+{
+    // Events are suppressed both below the chained LogLevel and at or
+    // below the hierarchy's disable value; fold both into one
+    // threshold.
+    LogLevel threshold
+        = (std::max) (getChainedLogLevel (), hierarchy.disableValue + 1);
+
+    // Also fold in the aggregate appender threshold: events that every
+    // appender reachable through the additivity chain would reject on
+    // its Threshold are suppressed before they are even constructed.
+    // A chain without any appenders keeps the plain threshold so the
+    // "no appenders" warning in callAppenders() still fires.
+    LogLevel chainFloor = NOT_SET_LOG_LEVEL;
+    bool haveAppenders = false;
+    for (const LoggerImpl * c = this; c != nullptr; c = c->parent.get ())
+    {
+        LogLevel floor;
+        if (c->getAppenderThresholdFloor (floor))
+        {
+            chainFloor
+                = haveAppenders ? (std::min) (chainFloor, floor) : floor;
+            haveAppenders = true;
+        }
+        if (! c->additive)
+            break;
+    }
+    if (haveAppenders)
+        threshold = (std::max) (threshold, chainFloor);
+
+    effectiveThreshold->store (threshold, std::memory_order_relaxed);
+}
+
+
 Hierarchy&
 LoggerImpl::getHierarchy() const
 {
@@ -141,6 +264,38 @@ LoggerImpl::getHierarchy() const
 }
 
 
+void
+LoggerImpl::appenderListChanged()
+{
+    hierarchy.refreshThresholds ();
+    // Descendants may reach the changed appender set through
+    // additivity; re-resolve every logger's routing mask.
+    hierarchy.rebuildRoutingTable ();
+}
+
+
+void
+LoggerImpl::countEmittedEvent()
+{
+    // The stripe is picked by the thread's round robin index, so
+    // concurrent producers increment disjoint cache lines and the
+    // log path stays wait-free.
+    std::size_t const stripe
+        = internal::get_ptd ()->counter_stripe % eventCounterStripeCount;
+    emittedEvents[stripe].count.fetch_add (1, std::memory_order_relaxed);
+}
+
+
+unsigned long long
+LoggerImpl::getEmittedEvents() const
+{
+    unsigned long long total = 0;
+    for (EventCounterStripe const & stripe : emittedEvents)
+        total += stripe.count.load (std::memory_order_relaxed);
+    return total;
+}
+
+
 bool
 LoggerImpl::getAdditivity() const
 {
@@ -152,6 +307,55 @@ void
 LoggerImpl::setAdditivity(bool additive_)
 {
     additive = additive_;
+    // Descendants may route their events through this logger;
+    // recompute the flattened ancestor chains.
+    hierarchy.refreshAppenderChains ();
+}
+
+
+void
+LoggerImpl::setMaxMessageSize (std::size_t limit)
+{
+    maxMessageSize.store (limit, std::memory_order_relaxed);
+}
+
+
+void
+LoggerImpl::setDefaultMaxMessageSize (std::size_t limit)
+{
+    default_max_message_size.store (limit, std::memory_order_relaxed);
+}
+
+
+std::size_t
+LoggerImpl::getDefaultMaxMessageSize ()
+{
+    return default_max_message_size.load (std::memory_order_relaxed);
+}
+
+
+std::size_t
+LoggerImpl::effectiveMaxMessageSize () const
+{
+    std::size_t const limit
+        = maxMessageSize.load (std::memory_order_relaxed);
+    return limit != 0 ? limit : getDefaultMaxMessageSize ();
+}
+
+
+void
+LoggerImpl::refreshAppenderChain()
+{
+    auto chain = std::make_shared<AppenderChain> ();
+    for (LoggerImpl * c = this; c != nullptr; c = c->parent.get ())
+    {
+        chain->push_back (c);
+        if (! c->additive)
+            break;
+    }
+
+    std::atomic_store_explicit (&appenderChain,
+        AppenderChainPtr (std::move (chain)), std::memory_order_release);
 }
 
 
@@ -162,11 +366,77 @@ LoggerImpl::forcedLog(LogLevel loglevel,
                       int line,
                       const char* function)
 {
-    spi::InternalLoggingEvent & ev = internal::get_ptd ()->forced_log_ev;
+    std::size_t const limit = effectiveMaxMessageSize ();
+    if (LOG4CPLUS_UNLIKELY (limit != 0 && message.size () > limit))
+    {
+        // Cut the message down before the event is constructed so
+        // the oversized payload never reaches layouts, queues or
+        // socket buffers.
+        tstring truncated;
+        truncated.reserve (
+            limit + sizeof (truncation_suffix) / sizeof (tchar));
+        truncated.append (message.data (), limit);
+        truncated.append (truncation_suffix);
+        forcedLog (loglevel, std::move (truncated), file, line, function);
+        return;
+    }
+
+    internal::per_thread_data * const ptd = internal::get_ptd ();
+    spi::InternalLoggingEvent & ev = ptd->forced_log_ev;
     assert (function);
-    ev.setLoggingEvent (this->getName(), loglevel, message, file, line,
+    ev.setLoggingEvent (this->name, loglevel, message, file, line,
         function);
     callAppenders(ev);
+    countEmittedEvent ();
+
+    // Track the largest recent message and periodically give the
+    // recycled event a chance to release storage pinned by an
+    // exceptionally large one.
+    ptd->forced_log_high_water
+        = (std::max) (ptd->forced_log_high_water, message.size ());
+    if (LOG4CPLUS_UNLIKELY (++ptd->forced_log_use_count == 1024))
+    {
+        ev.trimCapacity (ptd->forced_log_high_water);
+        ptd->forced_log_high_water = 0;
+        ptd->forced_log_use_count = 0;
+    }
+}
+
+
+void
+LoggerImpl::forcedLog(LogLevel loglevel,
+                      log4cplus::tstring&& message,
+                      const char* file,
+                      int line,
+                      const char* function)
+{
+    std::size_t const limit = effectiveMaxMessageSize ();
+    if (LOG4CPLUS_UNLIKELY (limit != 0 && message.size () > limit))
+    {
+        message.resize (limit);
+        message.append (truncation_suffix);
+    }
+
+    internal::per_thread_data * const ptd = internal::get_ptd ();
+    spi::InternalLoggingEvent & ev = ptd->forced_log_ev;
+    assert (function);
+    std::size_t const message_size = message.size ();
+    ev.setLoggingEvent (this->name, loglevel, std::move (message), file,
+        line, function);
+    callAppenders(ev);
+    countEmittedEvent ();
+
+    // Track the largest recent message and periodically give the
+    // recycled event a chance to release storage pinned by an
+    // exceptionally large one.
+    ptd->forced_log_high_water
+        = (std::max) (ptd->forced_log_high_water, message_size);
+    if (LOG4CPLUS_UNLIKELY (++ptd->forced_log_use_count == 1024))
+    {
+        ev.trimCapacity (ptd->forced_log_high_water);
+        ptd->forced_log_high_water = 0;
+        ptd->forced_log_use_count = 0;
+    }
 }
 
 
@@ -174,6 +444,7 @@ void
 LoggerImpl::forcedLog(spi::InternalLoggingEvent const & ev)
 {
     callAppenders(ev);
+    countEmittedEvent ();
 }
 
 
@@ -20,7 +20,13 @@
 
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/internal/internal.h>
+#include <log4cplus/internal/tracepoints.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <utility>
 
 
 namespace log4cplus::spi {
@@ -29,6 +35,106 @@ namespace log4cplus::spi {
 static const int LOG4CPLUS_DEFAULT_TYPE = 1;
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Call site interning
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+//! Key of one call site in the interning registry. The logging
+//! macros pass string literals, so the addresses themselves identify
+//! the site; identical literals in different translation units may
+//! produce duplicate entries, which only costs a little memory.
+struct SourceSiteKey
+{
+    char const * file;
+    char const * function;
+    int line;
+
+    bool
+    operator < (SourceSiteKey const & rhs) const
+    {
+        if (file != rhs.file)
+            return std::less<char const *> () (file, rhs.file);
+        if (function != rhs.function)
+            return std::less<char const *> () (function, rhs.function);
+        return line < rhs.line;
+    }
+};
+
+} // namespace
+
+
+SourceSitePtr
+internSourceSite (char const * file, int line, char const * function)
+{
+    // Per thread memo of the last interned site. Hot paths log from
+    // one site repeatedly and skip the registry lock entirely.
+    thread_local SourceSiteKey last_key {nullptr, nullptr, 0};
+    thread_local SourceSitePtr last_site;
+
+    if (last_site && last_key.file == file
+        && last_key.function == function && last_key.line == line)
+        return last_site;
+
+    static thread::Mutex registry_mutex;
+    static std::map<SourceSiteKey, SourceSitePtr> registry;
+
+    SourceSitePtr site;
+    {
+        thread::MutexGuard guard (registry_mutex);
+        SourceSitePtr & entry
+            = registry[SourceSiteKey {file, function, line}];
+        if (! entry)
+        {
+            auto new_site = std::make_shared<SourceSite> ();
+            if (file)
+                new_site->file = LOG4CPLUS_C_STR_TO_TSTRING (file);
+            if (function)
+                new_site->function = LOG4CPLUS_C_STR_TO_TSTRING (function);
+            new_site->line = line;
+            entry = std::move (new_site);
+        }
+        site = entry;
+    }
+
+    last_key = SourceSiteKey {file, function, line};
+    last_site = site;
+    return site;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Needed event fields
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+//! Union of the EventField bits some configured consumer may read.
+//! Grows monotonically as layouts, appenders and filters report
+//! their needs; it never shrinks, so a snapshot taken while the
+//! configuration changes errs towards capturing too much.
+std::atomic<unsigned> needed_event_fields {0};
+
+} // namespace
+
+
+unsigned
+getNeededEventFields ()
+{
+    return needed_event_fields.load (std::memory_order_relaxed);
+}
+
+
+void
+addNeededEventFields (unsigned fields)
+{
+    needed_event_fields.fetch_or (fields, std::memory_order_relaxed);
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // InternalLoggingEvent ctors and dtor
 ///////////////////////////////////////////////////////////////////////////////
@@ -41,17 +147,42 @@ InternalLoggingEvent::InternalLoggingEvent(
     , loggerName(logger)
     , ll(loglevel)
     , timestamp(log4cplus::helpers::now ())
-    , file(filename
-        ? LOG4CPLUS_C_STR_TO_TSTRING(filename)
-        : log4cplus::tstring())
-    , function (function_
-        ? LOG4CPLUS_C_STR_TO_TSTRING(function_)
-        : log4cplus::tstring())
-    , line(line_)
+    , steadyTimestamp(log4cplus::helpers::steady_now ())
+    , site(internSourceSite (filename, line_, function_))
+    , threadCached(false)
+    , thread2Cached(false)
+    , ndcCached(false)
+    , mdcCached(false)
+{
+    LOG4CPLUS_TRACEPOINT1 (event_create, ll);
+}
+
+
+InternalLoggingEvent::InternalLoggingEvent(
+    const log4cplus::tstring_view& logger,
+    LogLevel loglevel, log4cplus::tstring&& message_,
+    const char* filename, int line_, const char * function_)
+    : message(std::move (message_))
+    , loggerName(logger)
+    , ll(loglevel)
+    , timestamp(log4cplus::helpers::now ())
+    , steadyTimestamp(log4cplus::helpers::steady_now ())
+    , site(internSourceSite (filename, line_, function_))
     , threadCached(false)
     , thread2Cached(false)
     , ndcCached(false)
     , mdcCached(false)
+{
+    LOG4CPLUS_TRACEPOINT1 (event_create, ll);
+}
+
+
+InternalLoggingEvent::InternalLoggingEvent(
+    const log4cplus::tstring_view& logger,
+    LogLevel loglevel, const log4cplus::tchar* message_,
+    const char* filename, int line_, const char * function_)
+    : InternalLoggingEvent(logger, loglevel,
+        log4cplus::tstring_view (message_), filename, line_, function_)
 {
 }
 
@@ -69,14 +200,16 @@ InternalLoggingEvent::InternalLoggingEvent(
     , loggerName(logger)
     , ll(loglevel)
     , ndc(ndc_)
-    , mdc(mdc_)
-    , thread(thread_)
+    , mdc(std::make_shared<MappedDiagnosticContextMap> (mdc_))
+    , thread(std::make_shared<log4cplus::tstring const> (thread_))
     , timestamp(time)
-    , file(file_)
-    , function (function_.data ()
-        ? function_
-        : log4cplus::tstring())
-    , line(line_)
+    , steadyTimestamp(log4cplus::helpers::steady_now ())
+    , site(std::make_shared<SourceSite> (SourceSite {
+          log4cplus::tstring (file_),
+          function_.data ()
+              ? log4cplus::tstring (function_)
+              : log4cplus::tstring (),
+          line_}))
     , threadCached(true)
     , thread2Cached(true)
     , ndcCached(true)
@@ -99,15 +232,17 @@ InternalLoggingEvent::InternalLoggingEvent(
     , loggerName(logger)
     , ll(loglevel)
     , ndc(ndc_)
-    , mdc(mdc_)
-    , thread(thread_)
-    , thread2(thread2_)
+    , mdc(std::make_shared<MappedDiagnosticContextMap> (mdc_))
+    , thread(std::make_shared<log4cplus::tstring const> (thread_))
+    , thread2(std::make_shared<log4cplus::tstring const> (thread2_))
     , timestamp(time)
-    , file(file_)
-    , function (function_.data ()
-        ? function_
-        : log4cplus::tstring())
-    , line(line_)
+    , steadyTimestamp(log4cplus::helpers::steady_now ())
+    , site(std::make_shared<SourceSite> (SourceSite {
+          log4cplus::tstring (file_),
+          function_.data ()
+              ? log4cplus::tstring (function_)
+              : log4cplus::tstring (),
+          line_}))
     , threadCached(true)
     , thread2Cached(true)
     , ndcCached(true)
@@ -118,7 +253,6 @@ InternalLoggingEvent::InternalLoggingEvent(
 
 InternalLoggingEvent::InternalLoggingEvent ()
     : ll (NOT_SET_LOG_LEVEL)
-    , line (0)
     , threadCached(false)
     , thread2Cached(false)
     , ndcCached(false)
@@ -129,21 +263,43 @@ InternalLoggingEvent::InternalLoggingEvent ()
 InternalLoggingEvent::InternalLoggingEvent(
     const log4cplus::spi::InternalLoggingEvent& rhs)
     : message(rhs.getMessage())
-    , loggerName(rhs.getLoggerName())
+    , loggerName(rhs.loggerName)
+    , loggerNamePtr(rhs.loggerNamePtr)
     , ll(rhs.getLogLevel())
-    , ndc(rhs.getNDC())
-    , mdc(rhs.getMDCCopy())
-    , thread(rhs.getThread())
-    , thread2(rhs.getThread2())
     , timestamp(rhs.getTimestamp())
-    , file(rhs.getFile())
-    , function(rhs.getFunction())
-    , line(rhs.getLine())
-    , threadCached(true)
-    , thread2Cached(true)
-    , ndcCached(true)
-    , mdcCached(true)
+    , steadyTimestamp(rhs.getSteadyTimestamp())
+    , site(rhs.site)
+    , threadCached(false)
+    , thread2Cached(false)
+    , ndcCached(false)
+    , mdcCached(false)
+    , formattedLine(rhs.formattedLine)
+    , formattedLineKey(rhs.formattedLineKey)
+{
+    // Resolve only the thread specific fields some configured
+    // consumer may read; see gatherThreadSpecificData(). The fields
+    // rhs has already captured are copied either way.
+    rhs.gatherThreadSpecificData ();
+    ndc = rhs.ndc;
+    mdc = rhs.mdc;
+    thread = rhs.thread;
+    thread2 = rhs.thread2;
+    ndcCached = rhs.ndcCached;
+    mdcCached = rhs.mdcCached;
+    threadCached = rhs.threadCached;
+    thread2Cached = rhs.thread2Cached;
+}
+
+
+InternalLoggingEvent::InternalLoggingEvent(
+    log4cplus::spi::InternalLoggingEvent&& rhs)
+    : InternalLoggingEvent ()
 {
+    // Resolve the lazy thread specific members while still on the
+    // originating thread, mirroring the copy constructor, before
+    // taking over the storage.
+    rhs.gatherThreadSpecificData ();
+    swap (rhs);
 }
 
 
@@ -180,45 +336,159 @@ InternalLoggingEvent::setLoggingEvent (const log4cplus::tstring_view & logger,
     // of InternalLoggingEvent to avoid memory allocation.
 
     loggerName = logger;
+    loggerNamePtr.reset ();
     ll = loglevel;
     message = msg;
     timestamp = helpers::now ();
+    steadyTimestamp = helpers::steady_now ();
 
-    if (filename)
-        file = LOG4CPLUS_C_STR_TO_TSTRING (filename);
-    else
-        file.clear ();
-
-    if (function_)
-        function = LOG4CPLUS_C_STR_TO_TSTRING (function_);
-    else
-        function.clear ();
+    // Interning makes capturing the call site a reference count bump
+    // instead of two string assignments.
+    site = internSourceSite (filename, fline, function_);
 
-    line = fline;
     threadCached = false;
     thread2Cached = false;
     ndcCached = false;
     mdcCached = false;
+    // Drop the MDC snapshot of the previous use so that it does not
+    // force a needless copy-on-write in its originating thread.
+    mdc.reset ();
+    // Invalidate the formatted line cached for the previous use.
+    formattedLineKey = 0;
+
+    LOG4CPLUS_TRACEPOINT1 (event_create, ll);
+}
+
+
+void
+InternalLoggingEvent::setLoggingEvent (const log4cplus::tstring_view & logger,
+    LogLevel loglevel, log4cplus::tstring && msg,
+    const char * filename, int fline, const char * function_)
+{
+    setLoggingEvent (logger, loglevel, log4cplus::tstring_view (), filename,
+        fline, function_);
+
+    // Adopt the storage of the supplied message instead of copying
+    // its characters.
+    message = std::move (msg);
+}
+
+
+void
+InternalLoggingEvent::setLoggingEvent (const log4cplus::tstring_view & logger,
+    LogLevel loglevel, const log4cplus::tchar * msg,
+    const char * filename, int fline, const char * function_)
+{
+    setLoggingEvent (logger, loglevel, log4cplus::tstring_view (msg),
+        filename, fline, function_);
+}
+
+
+void
+InternalLoggingEvent::setLoggingEvent (LoggerNamePtr const & logger,
+    LogLevel loglevel, const log4cplus::tstring_view & msg,
+    const char * filename, int fline, const char * function_)
+{
+    setLoggingEvent (log4cplus::tstring_view (), loglevel, msg, filename,
+        fline, function_);
+
+    // Retain the interned name instead of copying its characters.
+    loggerNamePtr = logger;
+}
+
+
+void
+InternalLoggingEvent::setLoggingEvent (LoggerNamePtr const & logger,
+    LogLevel loglevel, log4cplus::tstring && msg,
+    const char * filename, int fline, const char * function_)
+{
+    setLoggingEvent (logger, loglevel, log4cplus::tstring_view (), filename,
+        fline, function_);
+
+    // Adopt the storage of the supplied message instead of copying
+    // its characters.
+    message = std::move (msg);
+}
+
+
+void
+InternalLoggingEvent::setLoggingEvent (LoggerNamePtr const & logger,
+    LogLevel loglevel, const log4cplus::tchar * msg,
+    const char * filename, int fline, const char * function_)
+{
+    setLoggingEvent (logger, loglevel, log4cplus::tstring_view (msg),
+        filename, fline, function_);
+}
+
+
+void
+InternalLoggingEvent::assign (const InternalLoggingEvent & rhs)
+{
+    // Assign each member instead of using the swap idiom so that
+    // string storage already owned by this instance is reused. This
+    // keeps recycled events (e.g., slots of thread::RingQueue)
+    // allocation-free in steady state.
+
+    message = rhs.message;
+    loggerName = rhs.loggerName;
+    loggerNamePtr = rhs.loggerNamePtr;
+    ll = rhs.ll;
+    ndc = rhs.ndc;
+    mdc = rhs.mdc;
+    thread = rhs.thread;
+    thread2 = rhs.thread2;
+    timestamp = rhs.timestamp;
+    steadyTimestamp = rhs.steadyTimestamp;
+    site = rhs.site;
+    threadCached = rhs.threadCached;
+    thread2Cached = rhs.thread2Cached;
+    ndcCached = rhs.ndcCached;
+    mdcCached = rhs.mdcCached;
+    formattedLine = rhs.formattedLine;
+    formattedLineKey = rhs.formattedLineKey;
 }
 
 
 void
 InternalLoggingEvent::setFunction (char const * func)
 {
-    if (func)
-        function = LOG4CPLUS_C_STR_TO_TSTRING (func);
-    else
-        function.clear ();
+    setFunction (func
+        ? log4cplus::tstring_view (LOG4CPLUS_C_STR_TO_TSTRING (func))
+        : log4cplus::tstring_view ());
 }
 
 
 void
 InternalLoggingEvent::setFunction (log4cplus::tstring_view const & func)
 {
+    // The site is shared with every other event from the same call
+    // site; give this event its own modified copy instead of
+    // mutating the interned entry.
+    auto new_site = site
+        ? std::make_shared<SourceSite> (*site)
+        : std::make_shared<SourceSite> ();
     if (func.data ())
-        function = func;
+        new_site->function = func;
     else
-        function.clear ();
+        new_site->function.clear ();
+    site = std::move (new_site);
+}
+
+
+void
+InternalLoggingEvent::trimCapacity (std::size_t high_water)
+{
+    std::size_t const min_retained = 1024;
+
+    // Leave buffers within an order of magnitude of the recent
+    // high-water mark alone; steady bursts should keep their storage.
+    if (message.capacity () <= min_retained
+        || message.capacity () / 2 <= high_water)
+        return;
+
+    message.clear ();
+    message.shrink_to_fit ();
+    message.reserve (high_water);
 }
 
 
@@ -229,6 +499,20 @@ InternalLoggingEvent::getMessage() const
 }
 
 
+const log4cplus::tstring&
+InternalLoggingEvent::getFile() const
+{
+    return site ? site->file : internal::empty_str;
+}
+
+
+log4cplus::tstring const &
+InternalLoggingEvent::getFunction () const
+{
+    return site ? site->function : internal::empty_str;
+}
+
+
 unsigned int
 InternalLoggingEvent::getType() const
 {
@@ -245,6 +529,66 @@ InternalLoggingEvent::clone() const
 }
 
 
+log4cplus::tstring const &
+InternalLoggingEvent::getThread () const
+{
+    if (! threadCached)
+    {
+        thread = thread::getCurrentThreadNamePtr ();
+        threadCached = true;
+    }
+    return *thread;
+}
+
+
+log4cplus::tstring const &
+InternalLoggingEvent::getThread2 () const
+{
+    if (! thread2Cached)
+    {
+        thread2 = thread::getCurrentThreadName2Ptr ();
+        thread2Cached = true;
+    }
+    return *thread2;
+}
+
+
+thread::ThreadNamePtr
+InternalLoggingEvent::getThreadPtr () const
+{
+    getThread ();
+    return thread;
+}
+
+
+thread::ThreadNamePtr
+InternalLoggingEvent::getThread2Ptr () const
+{
+    getThread2 ();
+    return thread2;
+}
+
+
+MappedDiagnosticContextMap const &
+InternalLoggingEvent::getMDCCopy () const
+{
+    if (! mdcCached)
+    {
+        mdc = log4cplus::getMDC ().getContextSnapshot ();
+        mdcCached = true;
+    }
+    return *mdc;
+}
+
+
+MappedDiagnosticContextMapPtr
+InternalLoggingEvent::getMDCSnapshot () const
+{
+    getMDCCopy ();
+    return mdc;
+}
+
+
 tstring const &
 InternalLoggingEvent::getMDC (tstring const & key) const
 {
@@ -266,13 +610,56 @@ InternalLoggingEvent::operator = (const InternalLoggingEvent& rhs)
 }
 
 
+InternalLoggingEvent &
+InternalLoggingEvent::operator = (InternalLoggingEvent&& rhs)
+{
+    rhs.gatherThreadSpecificData ();
+    swap (rhs);
+    return *this;
+}
+
+
+log4cplus::tstring const *
+InternalLoggingEvent::getCachedFormattedLine (std::size_t key) const
+{
+    if (formattedLineCacheEnabled && key != 0 && key == formattedLineKey)
+        return &formattedLine;
+
+    return nullptr;
+}
+
+
+void
+InternalLoggingEvent::cacheFormattedLine (std::size_t key,
+    log4cplus::tstring_view line) const
+{
+    if (! formattedLineCacheEnabled)
+        return;
+
+    formattedLine = line;
+    formattedLineKey = key;
+}
+
+
+void
+InternalLoggingEvent::enableFormattedLineCache (bool enable) const
+{
+    formattedLineCacheEnabled = enable;
+}
+
+
 void
 InternalLoggingEvent::gatherThreadSpecificData () const
 {
-    getNDC ();
-    getMDCCopy ();
-    getThread ();
-    getThread2 ();
+    unsigned const needed = getNeededEventFields ();
+    if (needed & EventFieldNDC)
+        getNDC ();
+    if (needed & EventFieldMDC)
+        getMDCCopy ();
+    if (needed & EventFieldThread)
+        getThread ();
+    if (needed & EventFieldThread2)
+        getThread2 ();
 }
 
 
@@ -283,18 +670,22 @@ InternalLoggingEvent::swap (InternalLoggingEvent & other)
 
     swap (message, other.message);
     swap (loggerName, other.loggerName);
+    swap (loggerNamePtr, other.loggerNamePtr);
     swap (ll, other.ll);
     swap (ndc, other.ndc);
     swap (mdc, other.mdc);
     swap (thread, other.thread);
     swap (thread2, other.thread2);
     swap (timestamp, other.timestamp);
-    swap (file, other.file);
-    swap (function, other.function);
-    swap (line, other.line);
+    swap (steadyTimestamp, other.steadyTimestamp);
+    swap (site, other.site);
     swap (threadCached, other.threadCached);
     swap (thread2Cached, other.thread2Cached);
     swap (ndcCached, other.ndcCached);
+    swap (mdcCached, other.mdcCached);
+    swap (formattedLine, other.formattedLine);
+    swap (formattedLineKey, other.formattedLineKey);
+    swap (formattedLineCacheEnabled, other.formattedLineCacheEnabled);
 }
 
 
@@ -21,13 +21,181 @@
 /** @file
  * This file implements support function for loggingmacros.h file. */
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
 #include <log4cplus/internal/internal.h>
+#include <log4cplus/hierarchy.h>
 #include <log4cplus/loggingmacros.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+
+
+namespace
+{
+
+//! One enableDormantLogSites() call, remembered so that it also
+//! applies to sites registering later.
+struct SiteRule
+{
+    std::string file_substring;
+    int line;
+    bool enable;
+};
+
+
+struct SiteRegistry
+{
+    log4cplus::thread::Mutex mutex;
+    std::vector<log4cplus::detail::LogSite *> sites;
+    std::vector<SiteRule> rules;
+};
+
+
+static
+SiteRegistry &
+get_site_registry ()
+{
+    static SiteRegistry registry;
+    return registry;
+}
+
+
+static
+bool
+site_matches (log4cplus::detail::LogSite const & site, SiteRule const & rule)
+{
+    if (rule.line != -1 && rule.line != site.line)
+        return false;
+
+    // Sites compiled with LOG4CPLUS_DISABLE_FILE_MACRO carry no file
+    // name and can never match.
+    return site.file
+        && std::strstr (site.file, rule.file_substring.c_str ());
+}
+
+
+//! Registry of the live per thread latency histograms plus the summed
+//! buckets of threads that have already exited, so that their counts
+//! survive the thread.
+struct LatencyRegistry
+{
+    log4cplus::thread::Mutex mutex;
+    std::vector<log4cplus::internal::call_latency_histogram *> histograms;
+    std::uint64_t retired_buckets[64] = { };
+    std::uint64_t retired_count = 0;
+};
+
+
+static
+LatencyRegistry &
+get_latency_registry ()
+{
+    static LatencyRegistry registry;
+    return registry;
+}
+
+
+//! Index of the highest set bit of \c cycles; 0 for a zero delta.
+static
+unsigned
+latency_bucket (std::uint64_t cycles)
+{
+#if defined (__GNUC__) || defined (__clang__)
+    return cycles == 0
+        ? 0
+        : static_cast<unsigned>(63 - __builtin_clzll (cycles));
+#else
+    unsigned index = 0;
+    while (cycles >>= 1)
+        ++index;
+    return index;
+#endif
+}
+
+} // namespace
+
+
+namespace log4cplus::internal {
+
+
+call_latency_histogram::call_latency_histogram ()
+{
+    for (auto & bucket : buckets)
+        bucket.store (0, std::memory_order_relaxed);
+    count.store (0, std::memory_order_relaxed);
+
+    LatencyRegistry & registry = get_latency_registry ();
+    thread::MutexGuard guard (registry.mutex);
+    registry.histograms.push_back (this);
+}
+
+
+call_latency_histogram::~call_latency_histogram ()
+{
+    LatencyRegistry & registry = get_latency_registry ();
+    thread::MutexGuard guard (registry.mutex);
+
+    registry.histograms.erase (
+        std::remove (registry.histograms.begin (),
+            registry.histograms.end (), this),
+        registry.histograms.end ());
+
+    for (std::size_t i = 0; i != 64; ++i)
+        registry.retired_buckets[i]
+            += buckets[i].load (std::memory_order_relaxed);
+    registry.retired_count += count.load (std::memory_order_relaxed);
+}
+
+
+} // namespace log4cplus::internal
 
 
 namespace log4cplus::detail {
 
 
+unsigned
+hierarchy_epoch (Logger const & logger)
+{
+    return logger.getHierarchy ().getEpoch ();
+}
+
+
+//! The buckets are written by the owning thread only, so a relaxed
+//! load/store pair is enough and cheaper than an atomic increment.
+void
+record_call_latency (std::uint64_t cycles)
+{
+    internal::call_latency_histogram & histogram
+        = internal::get_ptd ()->call_latency;
+
+    auto & bucket = histogram.buckets[latency_bucket (cycles)];
+    bucket.store (bucket.load (std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+    histogram.count.store (
+        histogram.count.load (std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+}
+
+
+LogSite::LogSite (char const * file_, int line_, char const * function_,
+    LogLevel ll_)
+    : file (file_)
+    , function (function_)
+    , line (line_)
+    , ll (ll_)
+    , enabled (false)
+{
+    SiteRegistry & registry = get_site_registry ();
+    thread::MutexGuard guard (registry.mutex);
+    registry.sites.push_back (this);
+    for (SiteRule const & rule : registry.rules)
+        if (site_matches (*this, rule))
+            enabled.store (rule.enable, std::memory_order_relaxed);
+}
+
+
 //! Helper stream to get the defaults from.
 static tostringstream const macros_oss_defaults;
 
@@ -89,12 +257,79 @@ macro_forced_log (log4cplus::Logger const & logger,
     log4cplus::LogLevel log_level, log4cplus::tstring_view const & msg,
     char const * filename, int line, char const * func)
 {
-    log4cplus::spi::InternalLoggingEvent & ev
-        = internal::get_ptd ()->forced_log_ev;
-    ev.setLoggingEvent (logger.getName (), log_level, msg, filename, line,
-        func);
-    logger.forcedLog (ev);
+    // Let LoggerImpl::forcedLog() fill the recycled per thread event;
+    // it captures the interned logger name by reference count bump
+    // instead of copying its characters.
+    logger.forcedLog (log_level, msg, filename, line, func);
+}
+
+
+void
+macro_forced_log (log4cplus::Logger const & logger,
+    log4cplus::LogLevel log_level, log4cplus::tstring && msg,
+    char const * filename, int line, char const * func)
+{
+    // Without C++20's stringbuf::view() the macro body hands over the
+    // string returned by str(); move its storage into the event
+    // instead of copying the characters a second time.
+    logger.forcedLog (log_level, std::move (msg), filename, line, func);
 }
 
 
 } // namespace log4cplus::detail
+
+
+namespace log4cplus {
+
+
+CallLatencyHistogram
+getCallLatencyHistogram ()
+{
+    CallLatencyHistogram result;
+
+    LatencyRegistry & registry = get_latency_registry ();
+    thread::MutexGuard guard (registry.mutex);
+
+    for (std::size_t i = 0; i != 64; ++i)
+        result.buckets[i] = registry.retired_buckets[i];
+    result.count = registry.retired_count;
+
+    for (internal::call_latency_histogram const * histogram
+        : registry.histograms)
+    {
+        for (std::size_t i = 0; i != 64; ++i)
+            result.buckets[i]
+                += histogram->buckets[i].load (std::memory_order_relaxed);
+        result.count += histogram->count.load (std::memory_order_relaxed);
+    }
+
+    return result;
+}
+
+
+std::size_t
+enableDormantLogSites (tstring const & fileSubstring, int line,
+    bool enable)
+{
+    SiteRule const rule {
+        LOG4CPLUS_TSTRING_TO_STRING (fileSubstring), line, enable };
+
+    SiteRegistry & registry = get_site_registry ();
+    thread::MutexGuard guard (registry.mutex);
+
+    std::size_t switched = 0;
+    for (detail::LogSite * site : registry.sites)
+    {
+        if (site_matches (*site, rule))
+        {
+            site->enabled.store (enable, std::memory_order_relaxed);
+            ++switched;
+        }
+    }
+
+    registry.rules.push_back (rule);
+    return switched;
+}
+
+
+} // namespace log4cplus
@@ -40,112 +40,25 @@ LogLevelTranslator::~LogLevelTranslator () = default;
 namespace
 {
 
-static tstring const ALL_STRING (LOG4CPLUS_TEXT("ALL"));
-static tstring const TRACE_STRING (LOG4CPLUS_TEXT("TRACE"));
-static tstring const DEBUG_STRING (LOG4CPLUS_TEXT("DEBUG"));
-static tstring const INFO_STRING (LOG4CPLUS_TEXT("INFO"));
-static tstring const WARN_STRING (LOG4CPLUS_TEXT("WARN"));
-static tstring const ERROR_STRING (LOG4CPLUS_TEXT("ERROR"));
-static tstring const FATAL_STRING (LOG4CPLUS_TEXT("FATAL"));
-static tstring const OFF_STRING (LOG4CPLUS_TEXT("OFF"));
-static tstring const NOTSET_STRING (LOG4CPLUS_TEXT("NOTSET"));
 static tstring const UNKNOWN_STRING (LOG4CPLUS_TEXT("UNKNOWN"));
 
 
-class LOG4CPLUS_PRIVATE DefaultLogLevelTranslator
-    : virtual public LogLevelTranslator
-{
-public:
-    DefaultLogLevelTranslator () = default;
-
-    ~DefaultLogLevelTranslator () override = default;
-
-    log4cplus::tstring const &
-    toString (LogLevel ll) const override
-    {
-        switch(ll) {
-        case OFF_LOG_LEVEL:     return OFF_STRING;
-        case FATAL_LOG_LEVEL:   return FATAL_STRING;
-        case ERROR_LOG_LEVEL:   return ERROR_STRING;
-        case WARN_LOG_LEVEL:    return WARN_STRING;
-        case INFO_LOG_LEVEL:    return INFO_STRING;
-        case DEBUG_LOG_LEVEL:   return DEBUG_STRING;
-        case TRACE_LOG_LEVEL:   return TRACE_STRING;
-        //case ALL_LOG_LEVEL:     return ALL_STRING;
-        case NOT_SET_LOG_LEVEL: return NOTSET_STRING;
-        }
-
-        return internal::empty_str;
-    }
-
-    LogLevel
-    fromString (const log4cplus::tstring_view& s) const override
-    {
-        // Since C++11, accessing str[0] is always safe as it returns '\0' for
-        // empty string.
-
-        switch (s[0])
-        {
-#define DEF_LLMATCH(_chr, _logLevel)                 \
-        case LOG4CPLUS_TEXT (_chr):                  \
-            if (s == _logLevel ## _STRING)           \
-                return _logLevel ## _LOG_LEVEL;      \
-            else                                     \
-                break;
-
-            DEF_LLMATCH ('O', OFF);
-            DEF_LLMATCH ('F', FATAL);
-            DEF_LLMATCH ('E', ERROR);
-            DEF_LLMATCH ('W', WARN);
-            DEF_LLMATCH ('I', INFO);
-            DEF_LLMATCH ('D', DEBUG);
-            DEF_LLMATCH ('T', TRACE);
-            DEF_LLMATCH ('A', ALL);
-
-#undef DEF_LLMATCH
-        }
-
-        return NOT_SET_LOG_LEVEL;
-    }
-};
+} // namespace
 
 
-class LOG4CPLUS_PRIVATE SingleLogLevelTranslator
-    : virtual public LogLevelTranslator
+//! One frozen level definition; both orderings of the table point at
+//! the same heap allocated entries, so the names referenced by
+//! toString() callers and the name cache stay put when the table is
+//! rebuilt.
+struct LogLevelManager::LevelTableEntry
 {
-public:
-    SingleLogLevelTranslator (LogLevel ll, const log4cplus::tstring_view & name_)
-        : log_level (ll)
-        , name (name_)
-    { }
-
-    ~SingleLogLevelTranslator () override = default;
-
-    log4cplus::tstring const &
-    toString (LogLevel ll) const override
-    {
-        if (ll == log_level)
-            return name;
-        else
-            return internal::empty_str;
-    }
-
-    LogLevel
-    fromString (const log4cplus::tstring_view& s) const override
-    {
-        if (s == name)
-            return log_level;
-        else
-            return NOT_SET_LOG_LEVEL;
-    }
-
-protected:
-    LogLevel log_level;
-    log4cplus::tstring name;
+    tstring name;
+    LogLevel value;
+    //! NOTSET has a printable name but, matching the historic
+    //! behavior, is not recognized by fromString().
+    bool visible_to_fromstring;
 };
 
-} // namespace
-
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -154,7 +67,24 @@ protected:
 
 LogLevelManager::LogLevelManager()
 {
-    pushLogLevelTranslator (SharedLogLevelTranslatorPtr (new DefaultLogLevelTranslator ()));
+    for (auto & slot : name_cache)
+        slot.store (nullptr, std::memory_order_relaxed);
+
+    // Seed the frozen table with the standard levels, from literals:
+    // the singleton can be constructed during static initialization
+    // of another translation unit, before this file's tstring
+    // constants exist. Order matters for aliases: TRACE is inserted
+    // before ALL, so toString() of their shared value yields TRACE.
+    addLevelTableEntry (OFF_LOG_LEVEL, LOG4CPLUS_TEXT ("OFF"));
+    addLevelTableEntry (FATAL_LOG_LEVEL, LOG4CPLUS_TEXT ("FATAL"));
+    addLevelTableEntry (ERROR_LOG_LEVEL, LOG4CPLUS_TEXT ("ERROR"));
+    addLevelTableEntry (WARN_LOG_LEVEL, LOG4CPLUS_TEXT ("WARN"));
+    addLevelTableEntry (INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("INFO"));
+    addLevelTableEntry (DEBUG_LOG_LEVEL, LOG4CPLUS_TEXT ("DEBUG"));
+    addLevelTableEntry (TRACE_LOG_LEVEL, LOG4CPLUS_TEXT ("TRACE"));
+    addLevelTableEntry (ALL_LOG_LEVEL, LOG4CPLUS_TEXT ("ALL"));
+    addLevelTableEntry (NOT_SET_LOG_LEVEL, LOG4CPLUS_TEXT ("NOTSET"),
+        false);
 }
 
 
@@ -169,15 +99,54 @@ LogLevelManager::~LogLevelManager() = default;
 tstring const &
 LogLevelManager::toString(LogLevel ll) const
 {
+    // toString() runs for every formatted event, so levels that are
+    // multiples of 1000 -- all standard levels and typical custom
+    // ones -- resolve through the dense name cache with a single
+    // indexed pointer load instead of the translator walk.
+    std::size_t const slot = static_cast<std::size_t>(ll) / 1000;
+    bool const cacheable = ll >= 0 && ll % 1000 == 0
+        && slot < name_cache_size;
+    if (cacheable)
+    {
+        tstring const * const cached
+            = name_cache[slot].load (std::memory_order_acquire);
+        if (LOG4CPLUS_LIKELY (cached != nullptr))
+            return *cached;
+    }
+
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     std::shared_lock guard (mtx);
 #endif
 
+    // All levels with a registration time mapping resolve through a
+    // binary search of the frozen table; only translators with
+    // dynamic mappings are walked.
+    auto const it = std::lower_bound (level_table_by_value.begin (),
+        level_table_by_value.end (), ll,
+        [] (LevelTableEntry const * entry, LogLevel value)
+        {
+            return entry->value < value;
+        });
+    if (it != level_table_by_value.end () && (*it)->value == ll)
+    {
+        // Publish the resolved name while still holding the shared
+        // lock, so the store cannot interleave with
+        // invalidateNameCache() clearing the slots under the
+        // exclusive lock.
+        if (cacheable)
+            name_cache[slot].store (&(*it)->name, std::memory_order_release);
+        return (*it)->name;
+    }
+
     for (auto & ptr : translator_list)
     {
         tstring const & ret = ptr->toString (ll);
         if (! ret.empty ())
+        {
+            if (cacheable)
+                name_cache[slot].store (&ret, std::memory_order_release);
             return ret;
+        }
     }
 
     return UNKNOWN_STRING;
@@ -193,6 +162,17 @@ LogLevelManager::fromString(const tstring_view& arg) const
     std::shared_lock guard (mtx);
 #endif
 
+    auto const it = std::lower_bound (level_table.begin (),
+        level_table.end (), s,
+        [] (std::unique_ptr<LevelTableEntry> const & entry,
+            tstring const & name)
+        {
+            return entry->name < name;
+        });
+    if (it != level_table.end () && (*it)->name == s
+        && (*it)->visible_to_fromstring)
+        return (*it)->value;
+
     for (auto & ptr : translator_list)
     {
         LogLevel ret = ptr->fromString (s);
@@ -217,7 +197,50 @@ LogLevelManager::pushLogLevel(LogLevel ll, const log4cplus::tstring_view & name)
     if (name.empty ())
         helpers::getLogLog ().error (LOG4CPLUS_TEXT ("Log level name cannot be empty"), true);
 
-    pushLogLevelTranslator (SharedLogLevelTranslatorPtr (new SingleLogLevelTranslator (ll, name)));
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    std::unique_lock guard (mtx);
+#endif
+
+    addLevelTableEntry (ll, tstring (name));
+
+    for (auto & slot : name_cache)
+        slot.store (nullptr, std::memory_order_release);
+}
+
+
+//! Inserts one definition into both orderings of the frozen table.
+//! Matching the former translator walk, the first registration of a
+//! name or of a value wins; later duplicates do not displace it.
+//! Callers serialize access; lookups binary search the rebuilt
+//! vectors under the shared lock.
+void
+LogLevelManager::addLevelTableEntry (LogLevel ll, tstring name,
+    bool visible_to_fromstring)
+{
+    auto const name_it = std::lower_bound (level_table.begin (),
+        level_table.end (), name,
+        [] (std::unique_ptr<LevelTableEntry> const & entry,
+            tstring const & name_)
+        {
+            return entry->name < name_;
+        });
+    if (name_it != level_table.end () && (*name_it)->name == name)
+        return;
+
+    auto entry = std::make_unique<LevelTableEntry> (
+        LevelTableEntry {std::move (name), ll, visible_to_fromstring});
+
+    auto const value_it = std::lower_bound (level_table_by_value.begin (),
+        level_table_by_value.end (), ll,
+        [] (LevelTableEntry const * entry_, LogLevel value)
+        {
+            return entry_->value < value;
+        });
+    if (value_it == level_table_by_value.end ()
+        || (*value_it)->value != ll)
+        level_table_by_value.insert (value_it, entry.get ());
+
+    level_table.insert (name_it, std::move (entry));
 }
 
 
@@ -234,6 +257,21 @@ LogLevelManager::pushLogLevelTranslator(SharedLogLevelTranslatorPtr translator)
 #endif
 
     translator_list.push_back (std::move (translator));
+
+    for (auto & slot : name_cache)
+        slot.store (nullptr, std::memory_order_release);
+}
+
+
+void
+LogLevelManager::invalidateNameCache()
+{
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    std::unique_lock guard (mtx);
+#endif
+
+    for (auto & slot : name_cache)
+        slot.store (nullptr, std::memory_order_release);
 }
 
 
@@ -40,6 +40,14 @@ static tchar const ERR_PREFIX[] = LOG4CPLUS_TEXT("log4cplus:ERROR ");
 } // namespace
 
 
+struct LogLog::PendingLine
+{
+    tostream * os;
+    tstring text;
+    PendingLine * next;
+};
+
+
 LogLog *
 LogLog::getLogLog()
 {
@@ -50,27 +58,37 @@ LogLog::getLogLog()
 LogLog::LogLog()
     : debugEnabled(TriUndef)
     , quietMode(TriUndef)
+    , pending(nullptr)
+    , draining(false)
 { }
 
 
-LogLog::~LogLog() = default;
+LogLog::~LogLog()
+{
+    PendingLine * line
+        = pending.exchange (nullptr, std::memory_order_acquire);
+    while (line)
+    {
+        PendingLine * next = line->next;
+        delete line;
+        line = next;
+    }
+}
 
 
 void
 LogLog::setInternalDebugging(bool enabled)
 {
-    thread::MutexGuard guard (mutex);
-
-    debugEnabled = enabled ? TriTrue : TriFalse;
+    debugEnabled.store (enabled ? TriTrue : TriFalse,
+        std::memory_order_relaxed);
 }
 
 
 void
 LogLog::setQuietMode(bool quietModeVal)
 {
-    thread::MutexGuard guard (mutex);
-
-    quietMode = quietModeVal ? TriTrue : TriFalse;
+    quietMode.store (quietModeVal ? TriTrue : TriFalse,
+        std::memory_order_relaxed);
 }
 
 
@@ -121,11 +139,12 @@ LogLog::error(tchar const * msg, bool throw_flag) const
 bool
 LogLog::get_quiet_mode () const
 {
-    if (LOG4CPLUS_UNLIKELY (quietMode == TriUndef))
+    if (LOG4CPLUS_UNLIKELY (
+            quietMode.load (std::memory_order_relaxed) == TriUndef))
         set_tristate_from_env (&quietMode,
             LOG4CPLUS_TEXT ("LOG4CPLUS_LOGLOG_QUIETMODE"));
 
-    return quietMode == TriTrue;
+    return quietMode.load (std::memory_order_relaxed) == TriTrue;
 }
 
 
@@ -139,24 +158,27 @@ LogLog::get_not_quiet_mode () const
 bool
 LogLog::get_debug_mode () const
 {
-    if (LOG4CPLUS_UNLIKELY (debugEnabled == TriUndef))
+    if (LOG4CPLUS_UNLIKELY (
+            debugEnabled.load (std::memory_order_relaxed) == TriUndef))
         set_tristate_from_env (&debugEnabled,
             LOG4CPLUS_TEXT ("LOG4CPLUS_LOGLOG_DEBUGENABLED"));
 
-    return debugEnabled && ! get_quiet_mode ();
+    return debugEnabled.load (std::memory_order_relaxed) == TriTrue
+        && ! get_quiet_mode ();
 }
 
 
 void
-LogLog::set_tristate_from_env (TriState * result, tchar const * envvar_name)
+LogLog::set_tristate_from_env (std::atomic<TriState> * result,
+    tchar const * envvar_name)
 {
     tstring envvar_value;
     bool exists = internal::get_env_var (envvar_value, envvar_name);
     bool value = false;
     if (exists && internal::parse_bool (value, envvar_value) && value)
-        *result = TriTrue;
+        result->store (TriTrue, std::memory_order_relaxed);
     else
-        *result = TriFalse;
+        result->store (TriFalse, std::memory_order_relaxed);
 }
 
 
@@ -165,18 +187,15 @@ void
 LogLog::logging_worker (tostream & os, bool (LogLog:: * cond) () const,
     tchar const * prefix, StringType const & msg, bool throw_flag) const
 {
-    bool output;
+    if (LOG4CPLUS_UNLIKELY ((this->*cond) ()))
     {
-        thread::MutexGuard guard (mutex);
-        output = (this->*cond) ();
-    }
-
-    if (LOG4CPLUS_UNLIKELY (output))
-    {
-        // XXX This is potential recursive lock of
-        // ConsoleAppender::outputMutex.
-        thread::MutexGuard outputGuard (ConsoleAppender::getOutputMutex ());
-        os << prefix << msg << std::endl;
+        // Format the whole line into a per thread buffer first so
+        // that the stream is touched only while draining and each
+        // line goes out in one piece.
+        thread_local tstring buffer;
+        buffer.assign (prefix);
+        buffer.append (msg);
+        publish_line (os, buffer);
     }
 
     if (LOG4CPLUS_UNLIKELY (throw_flag))
@@ -184,4 +203,57 @@ LogLog::logging_worker (tostream & os, bool (LogLog:: * cond) () const,
 }
 
 
+void
+LogLog::publish_line (tostream & os, tstring & text) const
+{
+    // Push the line onto the pending stack. This never blocks, so
+    // threads hitting internal errors at a high rate only pay for the
+    // enqueue while a single thread does the writing.
+    PendingLine * line = new PendingLine {&os, tstring (), nullptr};
+    line->text.swap (text);
+    line->next = pending.load (std::memory_order_relaxed);
+    while (! pending.compare_exchange_weak (line->next, line,
+            std::memory_order_release, std::memory_order_relaxed))
+        ;
+
+    while (pending.load (std::memory_order_relaxed)
+        && ! draining.exchange (true, std::memory_order_acquire))
+    {
+        PendingLine * list
+            = pending.exchange (nullptr, std::memory_order_acquire);
+
+        // Reverse the stack so that lines are written in the order
+        // they were queued.
+        PendingLine * head = nullptr;
+        while (list)
+        {
+            PendingLine * next = list->next;
+            list->next = head;
+            head = list;
+            list = next;
+        }
+
+        if (head)
+        {
+            // XXX This is potential recursive lock of
+            // ConsoleAppender::outputMutex.
+            thread::MutexGuard outputGuard (
+                ConsoleAppender::getOutputMutex ());
+            while (head)
+            {
+                PendingLine * next = head->next;
+                *head->os << head->text << std::endl;
+                delete head;
+                head = next;
+            }
+        }
+
+        draining.store (false, std::memory_order_release);
+        // Re-check the pending stack after dropping the draining flag
+        // so that a line queued while we were releasing it is not
+        // stranded until the next diagnostic.
+    }
+}
+
+
 } // namespace log4cplus::helpers
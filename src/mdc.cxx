@@ -24,6 +24,8 @@
 #include <log4cplus/mdc.h>
 #include <log4cplus/internal/internal.h>
 
+#include <utility>
+
 #if defined (LOG4CPLUS_WITH_UNIT_TESTS)
 #include <catch.hpp>
 #endif
@@ -39,35 +41,89 @@ MDC::MDC () = default;
 MDC::~MDC () = default;
 
 
-MappedDiagnosticContextMap *
-MDC::getPtr ()
+std::shared_ptr<MappedDiagnosticContextMap> &
+MDC::getStorage ()
+{
+    return internal::get_ptd ()->mdc_map;
+}
+
+
+namespace
+{
+
+//! Makes the thread's map safe to mutate. When snapshots of the
+//! current map are still referenced by logging events, the map is
+//! cloned first so that those snapshots stay unchanged.
+static
+MappedDiagnosticContextMap &
+get_writable_map (std::shared_ptr<MappedDiagnosticContextMap> & dc)
+{
+    if (! dc)
+        dc = std::make_shared<MappedDiagnosticContextMap> ();
+    else if (dc.use_count () > 1)
+        dc = std::make_shared<MappedDiagnosticContextMap> (*dc);
+
+    return *dc;
+}
+
+
+static
+MappedDiagnosticContextMapPtr const &
+get_empty_map_snapshot ()
 {
-    return &internal::get_ptd ()->mdc_map;
+    static MappedDiagnosticContextMapPtr const empty_map (
+        std::make_shared<MappedDiagnosticContextMap> ());
+    return empty_map;
 }
 
+} // namespace
+
 
 void
 MDC::clear()
 {
-    MappedDiagnosticContextMap * const dc = getPtr ();
-    MappedDiagnosticContextMap ().swap (*dc);
+    std::shared_ptr<MappedDiagnosticContextMap> & dc = getStorage ();
+    if (dc && dc.use_count () == 1)
+        // Nobody else references the map; empty it in place so the
+        // allocation is reused instead of being rebuilt on the next
+        // put().
+        dc->clear ();
+    else
+        dc.reset ();
 }
 
 
 void
 MDC::put (tstring const & key, tstring const & value)
 {
-    MappedDiagnosticContextMap * const dc = getPtr ();
-    (*dc)[key] = value;
+    get_writable_map (getStorage ())[key] = value;
+}
+
+
+void
+MDC::put (tstring const & key, tstring && value)
+{
+    get_writable_map (getStorage ())[key] = std::move (value);
+}
+
+
+void
+MDC::put (tstring && key, tstring && value)
+{
+    get_writable_map (getStorage ()).insert_or_assign (std::move (key),
+        std::move (value));
 }
 
 
 bool
-MDC::get (tstring * value, tstring const & key) const
+MDC::get (tstring * value, tstring_view key) const
 {
     assert (value);
 
-    MappedDiagnosticContextMap * const dc = getPtr ();
+    std::shared_ptr<MappedDiagnosticContextMap> const & dc = getStorage ();
+    if (! dc)
+        return false;
+
     auto it = dc->find (key);
     if (it != dc->end ())
     {
@@ -80,17 +136,102 @@ MDC::get (tstring * value, tstring const & key) const
 
 
 void
-MDC::remove (tstring const & key)
+MDC::remove (tstring_view key)
 {
-    MappedDiagnosticContextMap * const dc = getPtr ();
-    dc->erase (key);
+    std::shared_ptr<MappedDiagnosticContextMap> & dc = getStorage ();
+    if (! dc || dc->find (key) == dc->end ())
+        return;
+
+    MappedDiagnosticContextMap & map = get_writable_map (dc);
+    map.erase (map.find (key));
 }
 
 
 MappedDiagnosticContextMap const &
 MDC::getContext () const
 {
-    return *getPtr ();
+    std::shared_ptr<MappedDiagnosticContextMap> const & dc = getStorage ();
+    if (dc)
+        return *dc;
+    else
+        return *get_empty_map_snapshot ();
+}
+
+
+MappedDiagnosticContextMapPtr
+MDC::getContextSnapshot () const
+{
+    std::shared_ptr<MappedDiagnosticContextMap> const & dc = getStorage ();
+    if (dc)
+        return dc;
+    else
+        return get_empty_map_snapshot ();
+}
+
+
+//
+//
+//
+
+MDCGuard::MDCGuard (tstring_view key_, tstring_view value)
+    : key (key_)
+    , hadOldValue (false)
+{
+    MappedDiagnosticContextMap & map = get_writable_map (MDC::getStorage ());
+    auto it = map.find (key);
+    if (it != map.end ())
+    {
+        // Shadow the existing value; the destructor swaps it back.
+        hadOldValue = true;
+        oldValue.swap (it->second);
+        it->second = value;
+        return;
+    }
+
+    // Reuse a node recycled by an earlier guard together with its
+    // string storage instead of allocating a fresh one.
+    MappedDiagnosticContextMap & pool = internal::get_ptd ()->mdc_node_pool;
+    if (pool.empty ())
+        map.emplace (key, value);
+    else
+    {
+        auto node = pool.extract (pool.begin ());
+        node.key ().assign (key.data (), key.size ());
+        node.mapped () = value;
+        map.insert (std::move (node));
+    }
+}
+
+
+MDCGuard::~MDCGuard ()
+{
+    std::shared_ptr<MappedDiagnosticContextMap> & dc = MDC::getStorage ();
+    if (! dc)
+        return;
+
+    auto it = dc->find (key);
+    if (it == dc->end ())
+        // The key was removed or the whole map cleared under us;
+        // there is nothing left to undo.
+        return;
+
+    MappedDiagnosticContextMap & map = get_writable_map (dc);
+    it = map.find (key);
+    if (hadOldValue)
+    {
+        it->second.swap (oldValue);
+        return;
+    }
+
+    // Bound how much string storage the recycled nodes can pin in
+    // the per thread pool.
+    std::size_t const max_pooled = 16;
+
+    MappedDiagnosticContextMap & pool = internal::get_ptd ()->mdc_node_pool;
+    if (pool.size () < max_pooled)
+        pool.insert (map.extract (it));
+    else
+        map.erase (it);
 }
 
 
@@ -125,6 +266,100 @@ CATCH_TEST_CASE ("MDC", "[MDC]")
         CATCH_REQUIRE (! mdc.get (&str, LOG4CPLUS_TEXT ("key1")));
         CATCH_REQUIRE (! mdc.get (&str, LOG4CPLUS_TEXT ("key2")));
     }
+
+    CATCH_SECTION ("move put")
+    {
+        tstring key (LOG4CPLUS_TEXT ("key3"));
+        tstring value (LOG4CPLUS_TEXT ("value3"));
+        mdc.put (std::move (key), std::move (value));
+        CATCH_REQUIRE (mdc.get (&str, LOG4CPLUS_TEXT ("key3")));
+        CATCH_REQUIRE (str == LOG4CPLUS_TEXT ("value3"));
+
+        tstring value2 (LOG4CPLUS_TEXT ("value4"));
+        mdc.put (LOG4CPLUS_TEXT ("key1"), std::move (value2));
+        CATCH_REQUIRE (mdc.get (&str, LOG4CPLUS_TEXT ("key1")));
+        CATCH_REQUIRE (str == LOG4CPLUS_TEXT ("value4"));
+    }
+
+    CATCH_SECTION ("view lookup")
+    {
+        tstring_view const key1 (LOG4CPLUS_TEXT ("key1"));
+        CATCH_REQUIRE (mdc.get (&str, key1));
+        CATCH_REQUIRE (str == LOG4CPLUS_TEXT ("value1"));
+        mdc.remove (key1);
+        CATCH_REQUIRE (! mdc.get (&str, key1));
+    }
+
+    CATCH_SECTION ("guard")
+    {
+        tstring const key (LOG4CPLUS_TEXT ("rid"));
+        {
+            MDCGuard guard (key, LOG4CPLUS_TEXT ("42"));
+            CATCH_REQUIRE (mdc.get (&str, key));
+            CATCH_REQUIRE (str == LOG4CPLUS_TEXT ("42"));
+        }
+        CATCH_REQUIRE (! mdc.get (&str, key));
+    }
+
+    CATCH_SECTION ("guard restores shadowed value")
+    {
+        {
+            MDCGuard guard (LOG4CPLUS_TEXT ("key1"),
+                LOG4CPLUS_TEXT ("shadow"));
+            CATCH_REQUIRE (mdc.get (&str, LOG4CPLUS_TEXT ("key1")));
+            CATCH_REQUIRE (str == LOG4CPLUS_TEXT ("shadow"));
+        }
+        CATCH_REQUIRE (mdc.get (&str, LOG4CPLUS_TEXT ("key1")));
+        CATCH_REQUIRE (str == LOG4CPLUS_TEXT ("value1"));
+    }
+
+    CATCH_SECTION ("guard reuses recycled node")
+    {
+        {
+            MDCGuard guard (LOG4CPLUS_TEXT ("rid"), LOG4CPLUS_TEXT ("1"));
+        }
+        MappedDiagnosticContextMap const * before = &mdc.getContext ();
+        {
+            // The second guard recycles the node released by the
+            // first one; the map object itself stays put.
+            MDCGuard guard (LOG4CPLUS_TEXT ("rid"), LOG4CPLUS_TEXT ("2"));
+            CATCH_REQUIRE (&mdc.getContext () == before);
+            CATCH_REQUIRE (mdc.get (&str, LOG4CPLUS_TEXT ("rid")));
+            CATCH_REQUIRE (str == LOG4CPLUS_TEXT ("2"));
+        }
+        CATCH_REQUIRE (! mdc.get (&str, LOG4CPLUS_TEXT ("rid")));
+    }
+
+    CATCH_SECTION ("clear retains unshared map")
+    {
+        MappedDiagnosticContextMap const * before = &mdc.getContext ();
+        mdc.clear ();
+        CATCH_REQUIRE (! mdc.get (&str, LOG4CPLUS_TEXT ("key1")));
+        mdc.put (LOG4CPLUS_TEXT ("key1"), LOG4CPLUS_TEXT ("value1"));
+        // Without outstanding snapshots the map object survives clear().
+        CATCH_REQUIRE (&mdc.getContext () == before);
+    }
+
+    CATCH_SECTION ("snapshot")
+    {
+        MappedDiagnosticContextMapPtr snapshot = mdc.getContextSnapshot ();
+        mdc.put (LOG4CPLUS_TEXT ("key1"), LOG4CPLUS_TEXT ("other"));
+        mdc.remove (LOG4CPLUS_TEXT ("key2"));
+
+        // The snapshot is unaffected by later modifications.
+        CATCH_REQUIRE (snapshot->at (LOG4CPLUS_TEXT ("key1"))
+            == LOG4CPLUS_TEXT ("value1"));
+        CATCH_REQUIRE (snapshot->count (LOG4CPLUS_TEXT ("key2")) == 1);
+        CATCH_REQUIRE (mdc.get (&str, LOG4CPLUS_TEXT ("key1")));
+        CATCH_REQUIRE (str == LOG4CPLUS_TEXT ("other"));
+        CATCH_REQUIRE (! mdc.get (&str, LOG4CPLUS_TEXT ("key2")));
+
+        // Without outstanding snapshots the map is modified in place.
+        MappedDiagnosticContextMap const * before = &mdc.getContext ();
+        snapshot.reset ();
+        mdc.put (LOG4CPLUS_TEXT ("key3"), LOG4CPLUS_TEXT ("value3"));
+        CATCH_REQUIRE (&mdc.getContext () == before);
+    }
 }
 
 #endif
@@ -107,6 +107,7 @@ DiagnosticContext & DiagnosticContext::operator = (
 DiagnosticContext::DiagnosticContext (DiagnosticContext && other)
     : message (std::move (other.message))
     , fullMessage (std::move (other.fullMessage))
+    , fullMessageValid (other.fullMessageValid)
 { }
 
 
@@ -124,6 +125,7 @@ DiagnosticContext::swap (DiagnosticContext & other)
     using std::swap;
     swap (message, other.message);
     swap (fullMessage, other.fullMessage);
+    swap (fullMessageValid, other.fullMessageValid);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -179,7 +181,26 @@ NDC::get() const
 {
     DiagnosticContextStack* ptr = getPtr();
     if(!ptr->empty())
+    {
+        // push() leaves contexts with an invalid fullMessage so that
+        // the concatenation is only built when it is actually
+        // rendered. Walk down to the deepest valid cache and fill in
+        // the rest; caches of contexts below the top never go stale
+        // because their ancestors are immutable while stacked.
+        std::size_t i = ptr->size ();
+        while (i > 0 && ! (*ptr)[i - 1].fullMessageValid)
+            --i;
+
+        for (; i < ptr->size (); ++i)
+        {
+            DiagnosticContext & dc = (*ptr)[i];
+            init_full_message (dc.fullMessage, dc.message,
+                i > 0 ? &(*ptr)[i - 1] : nullptr);
+            dc.fullMessageValid = true;
+        }
+
         return ptr->back().fullMessage;
+    }
     else
         return internal::empty_str;
 }
@@ -201,7 +222,7 @@ NDC::pop()
     {
         tstring message;
         message.swap (ptr->back ().message);
-        ptr->pop_back();
+        recycle_back (*ptr);
         return message;
     }
     else
@@ -214,7 +235,7 @@ NDC::pop_void ()
 {
     DiagnosticContextStack* ptr = getPtr ();
     if (! ptr->empty ())
-        ptr->pop_back ();
+        recycle_back (*ptr);
 }
 
 
@@ -243,18 +264,49 @@ NDC::push(tchar const * message)
 }
 
 
+void
+NDC::push(tstring_view message)
+{
+    push_worker (message);
+}
+
+
 template <typename StringType>
 void
 NDC::push_worker (StringType const & message)
 {
-    DiagnosticContextStack* ptr = getPtr();
-    if (ptr->empty())
-        ptr->push_back( DiagnosticContext(message, nullptr) );
+    internal::per_thread_data * const ptd = internal::get_ptd ();
+    DiagnosticContextStack & stack = ptd->ndc_dcs;
+    DiagnosticContextStack & pool = ptd->ndc_dcs_pool;
+
+    // Reuse a recycled context and its string storage when one is
+    // available; push/pop pairs are then allocation free.
+    if (pool.empty ())
+        stack.emplace_back ();
     else
     {
-        DiagnosticContext const & dc = ptr->back();
-        ptr->push_back( DiagnosticContext(message, &dc) );
+        stack.push_back (std::move (pool.back ()));
+        pool.pop_back ();
     }
+
+    DiagnosticContext & dc = stack.back ();
+    dc.message = message;
+    // The concatenated message is built on demand by get().
+    dc.fullMessageValid = false;
+}
+
+
+void
+NDC::recycle_back (DiagnosticContextStack & stack)
+{
+    // Bound how much string storage an occasional deep stack can pin
+    // in the per thread pool.
+    std::size_t const max_pooled = 64;
+
+    DiagnosticContextStack & pool = internal::get_ptd ()->ndc_dcs_pool;
+    if (pool.size () < max_pooled)
+        pool.push_back (std::move (stack.back ()));
+    stack.pop_back ();
 }
 
 
@@ -290,6 +342,12 @@ NDCContextCreator::NDCContextCreator(tchar const * msg)
 }
 
 
+NDCContextCreator::NDCContextCreator(tstring_view msg)
+{
+    getNDC().push(msg);
+}
+
+
 NDCContextCreator::~NDCContextCreator()
 {
     getNDC().pop_void();
@@ -348,6 +406,19 @@ CATCH_TEST_CASE ("NDC", "[NDC]")
         CATCH_REQUIRE (ndc.peek ().empty ());
         CATCH_REQUIRE (ndc.getDepth () == 0);
     }
+
+    CATCH_SECTION ("view push")
+    {
+        tstring const storage (CONTEXT1);
+        NDCContextCreator c1 (tstring_view (storage));
+        CATCH_REQUIRE (ndc.peek () == CONTEXT1);
+        CATCH_REQUIRE (ndc.getDepth () == 1);
+
+        ndc.push (tstring_view (CONTEXT2));
+        CATCH_REQUIRE (ndc.peek () == CONTEXT2);
+        CATCH_REQUIRE (ndc.get () == C1C2);
+        ndc.pop_void ();
+    }
 }
 
 #endif
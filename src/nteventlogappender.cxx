@@ -25,11 +25,13 @@
 #include <log4cplus/streams.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
 #include <sstream>
 #include <cstdlib>
+#include <vector>
 
 
 namespace log4cplus
@@ -254,8 +256,17 @@ NTEventLogAppender::append(const spi::InternalLoggingEvent& event)
     if (str.size () > 31839)
         str.resize (31839);
 
+#if defined (LOG4CPLUS_UTF8_NATIVE)
+    // The event log stores UTF-16; convert at the sink and report
+    // through the wide call so the UTF-8 bytes are not interpreted in
+    // the ANSI code page.
+    std::wstring const wstr (helpers::towstring (str));
+    const wchar_t * s = wstr.c_str ();
+    BOOL bSuccess = ::ReportEventW(hEventLog,
+#else
     const tchar * s = str.c_str ();
     BOOL bSuccess = ::ReportEvent(hEventLog,
+#endif
                                   getEventType(event),
                                   getEventCategory(event),
                                   0x1000,
@@ -272,6 +283,90 @@ NTEventLogAppender::append(const spi::InternalLoggingEvent& event)
 }
 
 
+void
+NTEventLogAppender::appendBatch(const spi::InternalLoggingEvent* events,
+    std::size_t count)
+{
+    if(hEventLog == NULL) {
+        helpers::getLogLog().warn(LOG4CPLUS_TEXT("NT EventLog not opened."));
+        return;
+    }
+
+    // Keep runs well below the ReportEvent() limit of 65535 strings;
+    // the rendered message shows the first string and viewers list
+    // the rest, so huge runs only hurt readability.
+    std::size_t const max_run = 64;
+
+    // Coalesce runs of events mapping onto the same event type and
+    // category into one ReportEvent() call carrying one string per
+    // event. The call's RPC round trip, not the formatting, is what
+    // caps this appender's throughput.
+    std::vector<tstring> lines;
+#if defined (LOG4CPLUS_UTF8_NATIVE)
+    // Converted per run at the sink; see append().
+    std::vector<std::wstring> wlines;
+    std::vector<wchar_t const *> strings;
+#else
+    std::vector<tchar const *> strings;
+#endif
+
+    std::size_t i = 0;
+    while (i != count)
+    {
+        WORD const type = getEventType(events[i]);
+        WORD const category = getEventCategory(events[i]);
+
+        lines.clear();
+        std::size_t j = i;
+        for (; j != count && j - i != max_run
+                 && getEventType(events[j]) == type
+                 && getEventCategory(events[j]) == category;
+             ++j)
+        {
+            lines.push_back(formatEvent(events[j]));
+
+            // From MSDN documentation for ReportEvent():
+            // Each string is limited to 31,839 characters.
+            if (lines.back().size() > 31839)
+                lines.back().resize(31839);
+        }
+
+        // Collect the pointers only after the run is complete;
+        // growing `lines` above may move its strings.
+        strings.clear();
+#if defined (LOG4CPLUS_UTF8_NATIVE)
+        wlines.clear();
+        for (tstring const & line : lines)
+            wlines.push_back(helpers::towstring(line));
+        for (std::wstring const & wline : wlines)
+            strings.push_back(wline.c_str());
+
+        BOOL bSuccess = ::ReportEventW(hEventLog,
+#else
+        for (tstring const & line : lines)
+            strings.push_back(line.c_str());
+
+        BOOL bSuccess = ::ReportEvent(hEventLog,
+#endif
+                                      type,
+                                      category,
+                                      0x1000,
+                                      pCurrentUserSID,
+                                      static_cast<WORD>(strings.size()),
+                                      0,
+                                      strings.data(),
+                                      NULL);
+
+        if(!bSuccess) {
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("Cannot report event in NT EventLog."));
+        }
+
+        i = j;
+    }
+}
+
+
 
 
 WORD
@@ -18,7 +18,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
+
 #include <log4cplus/nullappender.h>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
 
 
@@ -33,9 +37,28 @@ namespace log4cplus
 NullAppender::NullAppender() = default;
 
 
+NullAppender::NullAppender(CalibrationMode mode)
+: calibrationMode(mode)
+{
+}
+
+
 NullAppender::NullAppender(const helpers::Properties& properties)
 : Appender(properties)
 {
+    tstring const mode = properties.getProperty (
+        LOG4CPLUS_TEXT ("CalibrationMode"));
+    if (! mode.empty () && mode != LOG4CPLUS_TEXT ("Discard"))
+    {
+        if (mode == LOG4CPLUS_TEXT ("Format"))
+            calibrationMode = Format;
+        else if (mode == LOG4CPLUS_TEXT ("FormatAndCopy"))
+            calibrationMode = FormatAndCopy;
+        else
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("NullAppender- Unknown CalibrationMode: ")
+                + mode);
+    }
 }
 
 
@@ -65,8 +88,18 @@ NullAppender::close()
 // This method does not need to be locked since it is called by
 // doAppend() which performs the locking
 void
-NullAppender::append(const spi::InternalLoggingEvent&)
+NullAppender::append(const spi::InternalLoggingEvent& event)
 {
+    if (calibrationMode == Discard)
+        return;
+
+    tstring const & line = formatEvent (event);
+    if (calibrationMode == FormatAndCopy && ! line.empty ())
+    {
+        scratch.resize (line.size ());
+        std::memcpy (scratch.data (), line.data (),
+            line.size () * sizeof (tchar));
+    }
 }
 
 
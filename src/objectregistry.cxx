@@ -21,6 +21,7 @@
 #include <log4cplus/spi/objectregistry.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
 #include <log4cplus/thread/threads.h>
+#include <functional>
 
 
 namespace log4cplus::spi {
@@ -31,7 +32,8 @@ namespace log4cplus::spi {
 ///////////////////////////////////////////////////////////////////////////////
 
 ObjectRegistryBase::ObjectRegistryBase()
-    : locking (true)
+    : count (0)
+    , locking (true)
 { }
 
 
@@ -44,11 +46,9 @@ ObjectRegistryBase::~ObjectRegistryBase() = default;
 ///////////////////////////////////////////////////////////////////////////////
 
 bool
-ObjectRegistryBase::exists(const tstring& name) const
+ObjectRegistryBase::exists(tstring_view name) const
 {
-    thread::MutexGuard guard (mutex);
-
-    return data.find(name) != data.end();
+    return getVal (name) != nullptr;
 }
 
 
@@ -57,11 +57,14 @@ ObjectRegistryBase::getAllNames() const
 {
     std::vector<tstring> tmp;
 
+    ObjectMapSnapshot const snapshot
+        = std::atomic_load_explicit (&data, std::memory_order_acquire);
+    if (snapshot)
     {
-        thread::MutexGuard guard (mutex);
-        tmp.reserve (data.size ());
-        for (auto const & kv : data)
-            tmp.emplace_back(kv.first);
+        tmp.reserve (snapshot->size ());
+        for (NameValue const & slot : *snapshot)
+            if (slot.object)
+                tmp.emplace_back (slot.name);
     }
 
     return tmp;
@@ -76,37 +79,90 @@ ObjectRegistryBase::getAllNames() const
 bool
 ObjectRegistryBase::putVal(const tstring& name, void* object)
 {
-    ObjectMap::value_type value(name, object);
-    std::pair<ObjectMap::iterator, bool> ret;
+    // A null object pointer marks a vacant hash table slot and can
+    // therefore not be registered.
+    if (! object)
+        return false;
+
+    bool inserted = false;
 
     {
         thread::MutexGuard guard;
         if (locking)
             guard.attach_and_lock (mutex);
 
-        ret = data.insert(std::move (value));
+        ObjectMapSnapshot const snapshot
+            = std::atomic_load_explicit (&data, std::memory_order_acquire);
+        if (! snapshot || ! findSlot (*snapshot, name)->object)
+        {
+            // Rebuild the table sized to a power of two at least
+            // twice the element count so that linear probe chains
+            // stay short and a vacant slot always exists.
+            std::size_t capacity = 16;
+            while (capacity < 2 * (count + 1))
+                capacity *= 2;
+
+            auto table = std::make_shared<ObjectMap> (capacity);
+            if (snapshot)
+            {
+                for (NameValue const & slot : *snapshot)
+                    if (slot.object)
+                        *findSlot (*table, slot.name) = slot;
+            }
+
+            NameValue & slot = *findSlot (*table, name);
+            slot.name = name;
+            slot.object = object;
+            ++ count;
+
+            std::atomic_store_explicit (&data,
+                ObjectMapSnapshot (std::move (table)),
+                std::memory_order_release);
+            inserted = true;
+        }
     }
 
-    if (! ret.second)
-        deleteObject( value.second );
+    if (! inserted)
+        deleteObject (object);
 
-    return ret.second;
+    return inserted;
 }
 
 
 void*
-ObjectRegistryBase::getVal(const tstring& name) const
+ObjectRegistryBase::getVal(tstring_view name) const
 {
-    thread::MutexGuard guard (mutex);
-
-    auto it (data.find (name));
-    if (it != data.end ())
-        return it->second;
-    else
+    ObjectMapSnapshot const snapshot
+        = std::atomic_load_explicit (&data, std::memory_order_acquire);
+    if (! snapshot)
         return nullptr;
+
+    // A vacant slot carries a null object pointer.
+    return findSlot (*snapshot, name)->object;
 }
 
 
+ObjectRegistryBase::NameValue *
+ObjectRegistryBase::findSlot (ObjectMap & table, tstring_view name)
+{
+    // The table is a power of two in size and never full, so the
+    // probe always terminates.
+    std::size_t const mask = table.size () - 1;
+    for (std::size_t i = std::hash<tstring_view> () (name) & mask;;
+        i = (i + 1) & mask)
+    {
+        NameValue & slot = table[i];
+        if (! slot.object || slot.name == name)
+            return &slot;
+    }
+}
+
+
+ObjectRegistryBase::NameValue const *
+ObjectRegistryBase::findSlot (ObjectMap const & table, tstring_view name)
+{
+    return findSlot (const_cast<ObjectMap &>(table), name);
+}
 
 
 void
@@ -114,8 +170,14 @@ ObjectRegistryBase::clear()
 {
     thread::MutexGuard guard (mutex);
 
-    for (auto const & kv : data)
-        deleteObject (kv.second);
+    ObjectMapSnapshot const snapshot
+        = std::atomic_load_explicit (&data, std::memory_order_acquire);
+    if (! snapshot)
+        return;
+
+    for (NameValue const & slot : *snapshot)
+        if (slot.object)
+            deleteObject (slot.object);
 }
 
 
@@ -27,7 +27,15 @@
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/internal/env.h>
+#include <log4cplus/logger.h>
+#include <log4cplus/thread/threads.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <functional>
 #include <limits>
+#include <map>
 #include <cstdlib>
 #include <memory>
 
@@ -62,9 +70,6 @@ namespace log4cplus
 
 static tchar const ESCAPE_CHAR = LOG4CPLUS_TEXT('%');
 
-extern void formatRelativeTimestamp (log4cplus::tostream & output,
-    log4cplus::spi::InternalLoggingEvent const & event);
-
 
 namespace pattern
 {
@@ -79,6 +84,7 @@ struct FormattingInfo {
     std::size_t maxLen;
     bool leftAlign : 1;
     bool trimStart : 1;
+    bool zeroPad : 1;
     FormattingInfo() { reset(); }
 
     void reset();
@@ -98,17 +104,64 @@ class PatternConverter
 public:
     explicit PatternConverter(const FormattingInfo& info);
     virtual ~PatternConverter() = default;
-    void formatAndAppend(tostream& output,
+    virtual void formatAndAppend(tostream& output,
+        const spi::InternalLoggingEvent& event);
+
+    //! Format the event directly into \c buf, bypassing the stream
+    //! and its per-insertion locale and sentry costs.
+    virtual void append(tstring & buf,
         const spi::InternalLoggingEvent& event);
 
     virtual void convert(tstring & result,
         const spi::InternalLoggingEvent& event) = 0;
 
+    //! Returns true when the converter produces the same output for
+    //! every event for the lifetime of the process. The parser folds
+    //! such converters, already formatted, into adjacent literal text
+    //! so that the per event chain only contains converters whose
+    //! output actually varies.
+    virtual bool isProcessConstant() const;
+
+    //! Returns true when the converter emits the event's message
+    //! (%m). PatternLayout uses it to locate the split point for
+    //! per-line prefixing of multi-line messages.
+    virtual bool emitsMessage() const;
+
+    //! Returns the spi::EventField bits naming the thread specific
+    //! event fields this converter reads. PatternLayout::init()
+    //! aggregates the bits over the whole pattern.
+    virtual unsigned neededEventFields() const;
+
+    //! Returns true when the converter's output depends on which
+    //! appender is delivering the event, such as %# reading the
+    //! delivering appender's sequence stamp. Lines formatted from
+    //! such patterns must not be shared between appenders, so
+    //! PatternLayout::init() withholds the format key.
+    virtual bool perAppenderOutput() const;
+
+    //! Returns true when the converter is immutable after
+    //! construction, so that one instance can format events for
+    //! several appenders concurrently. Chains made entirely of such
+    //! converters are shared between identically configured layouts
+    //! through a process wide cache; converters carrying a per
+    //! instance cache serialized by the owning appender (e.g. the
+    //! date converter's per second cache) return false, the default,
+    //! and keep their chain private to the layout.
+    virtual bool isShareable() const;
+
+protected:
+    //! Applies the pattern's trimming and padding modifiers to \c s
+    //! and appends the result to \c buf. Converters whose output
+    //! comes from a fixed set of values use this to pre-pad each
+    //! value once instead of re-running the width logic per event.
+    void padAndAppend(tstring & buf, const tstring& s) const;
+
 private:
     int minLen;
     std::size_t maxLen;
     bool leftAlign : 1;
     bool trimStart : 1;
+    bool zeroPad : 1;
 };
 
 
@@ -129,11 +182,40 @@ public:
         result = str;
     }
 
+    bool isProcessConstant() const override;
+    bool isShareable() const override;
+
 private:
     tstring str;
 };
 
 
+/**
+ * This PatternConverter holds a run of process-constant converters
+ * folded by the parser and serves their output from a pre-rendered
+ * string. The cached text is re-rendered when the process generation
+ * changes, so %i and %h stay correct in a forked child once
+ * atForkChild() has run. The re-render is guarded by a mutex and
+ * published through the generation so that the converter is safe to
+ * share between appenders; the steady state path costs one atomic
+ * load.
+ */
+class ProcessConstantPatternConverter : public PatternConverter
+{
+public:
+    explicit ProcessConstantPatternConverter(PatternConverterList parts);
+    void convert(tstring & result,
+        const spi::InternalLoggingEvent& event) override;
+    bool isShareable() const override;
+
+private:
+    PatternConverterList parts;
+    tstring rendered;
+    std::atomic<unsigned> generation;
+    std::mutex render_mutex;
+};
+
+
 /**
  * This PatternConverter is used to format most of the "simple" fields
  * found in the InternalLoggingEvent object.
@@ -145,7 +227,6 @@ public:
     enum Type { THREAD_CONVERTER,
                 THREAD2_CONVERTER,
                 PROCESS_CONVERTER,
-                LOGLEVEL_CONVERTER,
                 NDC_CONVERTER,
                 MESSAGE_CONVERTER,
                 NEWLINE_CONVERTER,
@@ -157,17 +238,50 @@ public:
     BasicPatternConverter(const FormattingInfo& info, Type type);
     void convert(tstring & result,
         const spi::InternalLoggingEvent& event) override;
+    bool isProcessConstant() const override;
+    bool emitsMessage() const override;
+    unsigned neededEventFields() const override;
+    bool isShareable() const override;
 
 private:
   // Disable copy
     BasicPatternConverter(const BasicPatternConverter&) = delete;
     BasicPatternConverter& operator=(BasicPatternConverter&) = delete;
 
-    LogLevelManager& llmCache;
     Type type;
 };
 
 
+/**
+ * This PatternConverter formats the LogLevel field. Level names come
+ * from a small fixed set, so instead of re-running the trimming and
+ * padding logic for every event the converter caches each name with
+ * the pattern's width modifiers already applied and serves events
+ * straight from that cache. The cache is built for the standard
+ * levels at construction, making the converter immutable afterwards
+ * and therefore shareable between appenders; custom levels are
+ * padded in place on the formatting path.
+ */
+class LogLevelPatternConverter : public PatternConverter {
+public:
+    explicit LogLevelPatternConverter(const FormattingInfo& info);
+    void formatAndAppend(tostream& output,
+        const spi::InternalLoggingEvent& event) override;
+    void append(tstring & buf,
+        const spi::InternalLoggingEvent& event) override;
+    void convert(tstring & result,
+        const spi::InternalLoggingEvent& event) override;
+    bool isShareable() const override;
+
+private:
+    const tstring * findPadded(LogLevel ll) const;
+
+    LogLevelManager& llmCache;
+    //! Pre-padded level names keyed by LogLevel. A process logs a
+    //! handful of distinct levels, so a linear scan beats hashing.
+    std::vector<std::pair<LogLevel, tstring> > levelCache;
+};
+
 
 /**
  * This PatternConverter is used to format the Logger field found in
@@ -178,6 +292,7 @@ public:
     LoggerPatternConverter(const FormattingInfo& info, int precision);
     void convert(tstring & result,
         const spi::InternalLoggingEvent& event) override;
+    bool isShareable() const override;
 
 private:
     int precision;
@@ -199,23 +314,37 @@ public:
         const spi::InternalLoggingEvent& event) override;
 
 private:
-    bool use_gmtime;
-    tstring format;
+    //! Pre-compiled format; caches the strftime output per second
+    //! and renders sub-second fields by direct digit writing.
+    helpers::CachedTimeFormatter formatter;
 };
 
 
 /**
- * This PatternConverter is used to format an environment variable
+ * This PatternConverter is used to format an environment variable.
+ * The variable is read once at construction and events are served
+ * from the snapshot, since getenv() is neither free nor safe against
+ * a concurrent setenv(). The snapshot is re-read when the optional
+ * <tt>refresh=</tt> interval of the conversion expires or when
+ * refreshEnvConverters() bumps the global generation.
  */
 class EnvPatternConverter : public PatternConverter {
 public:
     EnvPatternConverter(const FormattingInfo& info,
-                        const log4cplus::tstring& env);
+                        const log4cplus::tstring& option);
     void convert(tstring & result,
         const spi::InternalLoggingEvent& event) override;
 
 private:
+    //! Re-reads envValue and schedules the next timed refresh.
+    void snapshot();
+
     log4cplus::tstring envKey;
+    log4cplus::tstring envValue;
+    //! Zero when the snapshot never expires on its own.
+    std::chrono::steady_clock::duration refreshInterval {};
+    std::chrono::steady_clock::time_point nextRefresh;
+    unsigned envGeneration;
 };
 
 
@@ -225,6 +354,37 @@ public:
     explicit RelativeTimestampConverter(const FormattingInfo& info);
     void convert(tstring & result,
         const spi::InternalLoggingEvent& event) override;
+    bool isShareable() const override;
+
+private:
+    //! Process start time, captured once at construction instead of
+    //! being fetched again for every event.
+    helpers::Time const timeBase;
+};
+
+
+//! This pattern is used to format the event's monotonic (steady
+//! clock) timestamp as microseconds since the steady clock's epoch.
+class SteadyTimestampConverter: public PatternConverter {
+public:
+    explicit SteadyTimestampConverter(const FormattingInfo& info);
+    void convert(tstring & result,
+        const spi::InternalLoggingEvent& event) override;
+    bool isShareable() const override;
+};
+
+
+//! This pattern is used to format the sequence number the delivering
+//! appender stamped on the event, or 0 when that appender does not
+//! number its events.
+//! \sa the Appender <tt>SequenceNumbers</tt> property.
+class SequencePatternConverter: public PatternConverter {
+public:
+    explicit SequencePatternConverter(const FormattingInfo& info);
+    void convert(tstring & result,
+        const spi::InternalLoggingEvent& event) override;
+    bool perAppenderOutput() const override;
+    bool isShareable() const override;
 };
 
 
@@ -236,9 +396,12 @@ public:
     HostnamePatternConverter(const FormattingInfo& info, bool fqdn);
     void convert(tstring & result,
         const spi::InternalLoggingEvent& event) override;
+    bool isProcessConstant() const override;
 
 private:
     tstring hostname_;
+    bool fqdn_;
+    unsigned generation_;
 };
 
 
@@ -254,6 +417,8 @@ public:
     MDCPatternConverter(const FormattingInfo& info, tstring const & k);
     void convert(tstring & result,
         const spi::InternalLoggingEvent& event) override;
+    unsigned neededEventFields() const override;
+    bool isShareable() const override;
 
 private:
     tstring key;
@@ -270,6 +435,8 @@ public:
     NDCPatternConverter(const FormattingInfo& info, int precision);
     void convert(tstring & result,
         const spi::InternalLoggingEvent& event) override;
+    unsigned neededEventFields() const override;
+    bool isShareable() const override;
 
 private:
     int precision;
@@ -323,6 +490,7 @@ FormattingInfo::reset() {
     maxLen = std::numeric_limits<std::size_t>::max ();
     leftAlign = false;
     trimStart = true;
+    zeroPad = false;
 }
 
 
@@ -332,7 +500,8 @@ FormattingInfo::dump(helpers::LogLog& loglog) {
     buf << LOG4CPLUS_TEXT("min=") << minLen
         << LOG4CPLUS_TEXT(", max=") << maxLen
         << LOG4CPLUS_TEXT(", leftAlign=") << std::boolalpha << leftAlign
-        << LOG4CPLUS_TEXT(", trimStart=") << std::boolalpha << trimStart;
+        << LOG4CPLUS_TEXT(", trimStart=") << std::boolalpha << trimStart
+        << LOG4CPLUS_TEXT(", zeroPad=") << std::boolalpha << zeroPad;
     loglog.debug(buf.str());
 }
 
@@ -349,6 +518,7 @@ PatternConverter::PatternConverter(const FormattingInfo& i)
     maxLen = i.maxLen;
     leftAlign = i.leftAlign;
     trimStart = i.trimStart;
+    zeroPad = i.zeroPad;
 }
 
 
@@ -371,7 +541,8 @@ PatternConverter::formatAndAppend(
     else if (static_cast<int>(len) < minLen)
     {
         std::ios_base::fmtflags const original_flags = output.flags ();
-        tchar const fill = output.fill (LOG4CPLUS_TEXT(' '));
+        tchar const fill = output.fill (zeroPad && ! leftAlign
+            ? LOG4CPLUS_TEXT('0') : LOG4CPLUS_TEXT(' '));
         output.setf (leftAlign ? std::ios_base::left : std::ios_base::right,
             std::ios_base::adjustfield);
         output.width (minLen);
@@ -384,6 +555,83 @@ PatternConverter::formatAndAppend(
 }
 
 
+void
+PatternConverter::append(
+    tstring & buf, const spi::InternalLoggingEvent& event)
+{
+    tstring & s = internal::get_ptd ()->faa_str;
+    convert (s, event);
+    padAndAppend (buf, s);
+}
+
+
+void
+PatternConverter::padAndAppend(tstring & buf, const tstring& s) const
+{
+    std::size_t const len = s.length();
+
+    if (len > maxLen)
+    {
+        if (trimStart)
+            buf.append (s, len - maxLen, maxLen);
+        else
+            buf.append (s, 0, maxLen);
+    }
+    else if (static_cast<int>(len) < minLen)
+    {
+        std::size_t const padding = std::size_t (minLen) - len;
+        if (leftAlign)
+        {
+            buf.append (s);
+            buf.append (padding, LOG4CPLUS_TEXT (' '));
+        }
+        else
+        {
+            buf.append (padding,
+                zeroPad ? LOG4CPLUS_TEXT ('0') : LOG4CPLUS_TEXT (' '));
+            buf.append (s);
+        }
+    }
+    else
+        buf.append (s);
+}
+
+
+bool
+PatternConverter::isProcessConstant() const
+{
+    return false;
+}
+
+
+bool
+PatternConverter::emitsMessage() const
+{
+    return false;
+}
+
+
+unsigned
+PatternConverter::neededEventFields() const
+{
+    return 0;
+}
+
+
+bool
+PatternConverter::perAppenderOutput() const
+{
+    return false;
+}
+
+
+bool
+PatternConverter::isShareable() const
+{
+    return false;
+}
+
+
 
 ////////////////////////////////////////////////
 // LiteralPatternConverter methods:
@@ -402,6 +650,74 @@ LiteralPatternConverter::LiteralPatternConverter(
 }
 
 
+bool
+LiteralPatternConverter::isProcessConstant() const
+{
+    return true;
+}
+
+
+bool
+LiteralPatternConverter::isShareable() const
+{
+    return true;
+}
+
+
+
+////////////////////////////////////////////////
+// ProcessConstantPatternConverter methods:
+////////////////////////////////////////////////
+
+ProcessConstantPatternConverter::ProcessConstantPatternConverter (
+    PatternConverterList parts_)
+    : PatternConverter(FormattingInfo())
+    , parts (std::move (parts_))
+    , generation (internal::process_generation ())
+{
+    spi::InternalLoggingEvent const dummy_event;
+    for (auto & pc : parts)
+        pc->append (rendered, dummy_event);
+}
+
+
+void
+ProcessConstantPatternConverter::convert (
+    tstring & result, const spi::InternalLoggingEvent& event)
+{
+    unsigned const gen = internal::process_generation ();
+    if (gen == generation.load (std::memory_order_acquire))
+    {
+        // The release store below orders the rendered text before
+        // the generation, so a matching load guarantees the text is
+        // complete and will not change until the next fork.
+        result = rendered;
+        return;
+    }
+
+    // First event after fork: re-render so that the cached text
+    // picks up the child's process id and hostname. The converter
+    // may be shared between appenders, so the re-render itself is
+    // serialized here instead of relying on one appender's mutex.
+    std::unique_lock<std::mutex> guard (render_mutex);
+    if (gen != generation.load (std::memory_order_relaxed))
+    {
+        rendered.clear ();
+        for (auto & pc : parts)
+            pc->append (rendered, event);
+        generation.store (gen, std::memory_order_release);
+    }
+    result = rendered;
+}
+
+
+bool
+ProcessConstantPatternConverter::isShareable () const
+{
+    return true;
+}
+
+
 
 ////////////////////////////////////////////////
 // BasicPatternConverter methods:
@@ -410,7 +726,6 @@ LiteralPatternConverter::LiteralPatternConverter(
 BasicPatternConverter::BasicPatternConverter(
     const FormattingInfo& info, Type type_)
     : PatternConverter(info)
-    , llmCache(getLogLevelManager())
     , type(type_)
 {
 }
@@ -423,10 +738,6 @@ BasicPatternConverter::convert(tstring & result,
 {
     switch(type)
     {
-    case LOGLEVEL_CONVERTER:
-        result = llmCache.toString(event.getLogLevel());
-        return;
-
     case BASENAME_CONVERTER:
         result = get_basename(event.getFile());
         return;
@@ -491,6 +802,131 @@ BasicPatternConverter::convert(tstring & result,
 }
 
 
+bool
+BasicPatternConverter::isProcessConstant() const
+{
+    // The process id and the line terminator do not change for the
+    // lifetime of the process; all other fields depend on the event.
+    return type == PROCESS_CONVERTER || type == NEWLINE_CONVERTER;
+}
+
+
+bool
+BasicPatternConverter::emitsMessage() const
+{
+    return type == MESSAGE_CONVERTER;
+}
+
+
+unsigned
+BasicPatternConverter::neededEventFields() const
+{
+    switch (type)
+    {
+    case THREAD_CONVERTER:
+        return spi::EventFieldThread;
+    case THREAD2_CONVERTER:
+        return spi::EventFieldThread2;
+    case NDC_CONVERTER:
+        return spi::EventFieldNDC;
+    default:
+        return 0;
+    }
+}
+
+
+bool
+BasicPatternConverter::isShareable() const
+{
+    return true;
+}
+
+
+
+////////////////////////////////////////////////
+// LogLevelPatternConverter methods:
+////////////////////////////////////////////////
+
+LogLevelPatternConverter::LogLevelPatternConverter(
+    const FormattingInfo& info)
+    : PatternConverter(info)
+    , llmCache(getLogLevelManager())
+{
+    // Pre-pad the standard level names so that the converter is
+    // immutable after construction; events carrying a custom level
+    // are padded in place on the formatting path instead.
+    static LogLevel const standard_levels[] = {
+        FATAL_LOG_LEVEL, ERROR_LOG_LEVEL, WARN_LOG_LEVEL,
+        INFO_LOG_LEVEL, DEBUG_LOG_LEVEL, TRACE_LOG_LEVEL };
+    for (LogLevel ll : standard_levels)
+    {
+        tstring padded;
+        padAndAppend (padded, llmCache.toString (ll));
+        levelCache.emplace_back (ll, std::move (padded));
+    }
+}
+
+
+const tstring *
+LogLevelPatternConverter::findPadded(LogLevel ll) const
+{
+    for (auto const & entry : levelCache)
+    {
+        if (entry.first == ll)
+            return &entry.second;
+    }
+
+    return nullptr;
+}
+
+
+void
+LogLevelPatternConverter::formatAndAppend(tostream& output,
+    const spi::InternalLoggingEvent& event)
+{
+    if (tstring const * padded = findPadded (event.getLogLevel ()))
+        output << *padded;
+    else
+    {
+        tstring & s = internal::get_ptd ()->faa_str;
+        s.clear ();
+        padAndAppend (s, llmCache.toString (event.getLogLevel ()));
+        output << s;
+    }
+}
+
+
+void
+LogLevelPatternConverter::append(tstring & buf,
+    const spi::InternalLoggingEvent& event)
+{
+    if (tstring const * padded = findPadded (event.getLogLevel ()))
+        buf.append (*padded);
+    else
+        padAndAppend (buf, llmCache.toString (event.getLogLevel ()));
+}
+
+
+void
+LogLevelPatternConverter::convert(tstring & result,
+    const spi::InternalLoggingEvent& event)
+{
+    if (tstring const * padded = findPadded (event.getLogLevel ()))
+        result = *padded;
+    else
+    {
+        result.clear ();
+        padAndAppend (result, llmCache.toString (event.getLogLevel ()));
+    }
+}
+
+
+bool
+LogLevelPatternConverter::isShareable() const
+{
+    return true;
+}
+
 
 ////////////////////////////////////////////////
 // LoggerPatternConverter methods:
@@ -533,6 +969,13 @@ LoggerPatternConverter::convert(tstring & result,
 }
 
 
+bool
+LoggerPatternConverter::isShareable() const
+{
+    return true;
+}
+
+
 
 ////////////////////////////////////////////////
 // DatePatternConverter methods:
@@ -543,8 +986,7 @@ DatePatternConverter::DatePatternConverter(
     const FormattingInfo& info, const tstring& pattern,
     bool use_gmtime_)
     : PatternConverter(info)
-    , use_gmtime(use_gmtime_)
-    , format(pattern)
+    , formatter(pattern, use_gmtime_)
 {
 }
 
@@ -554,8 +996,8 @@ void
 DatePatternConverter::convert(tstring & result,
     const spi::InternalLoggingEvent& event)
 {
-    result = helpers::getFormattedTime(format, event.getTimestamp(),
-        use_gmtime);
+    result.clear ();
+    formatter.format (result, event.getTimestamp ());
 }
 
 
@@ -564,22 +1006,90 @@ DatePatternConverter::convert(tstring & result,
 ////////////////////////////////////////////////
 
 
+namespace
+{
+
+//! Bumped by refreshEnvConverters(); converters re-read their
+//! variable when their recorded generation falls behind.
+std::atomic<unsigned> env_converter_generation {0};
+
+} // namespace
+
+
 EnvPatternConverter::EnvPatternConverter(
-    const FormattingInfo& info, const tstring& env)
+    const FormattingInfo& info, const tstring& option)
     : PatternConverter(info)
-    , envKey(env)
-{ }
+    , envKey(option)
+    , envGeneration(env_converter_generation.load (
+        std::memory_order_relaxed))
+{
+    // The option is either just a variable name or
+    // "NAME:refresh=30s" (also "500ms"); without the suffix the
+    // snapshot is only refreshed by refreshEnvConverters().
+    static tchar const refresh_opt[] = LOG4CPLUS_TEXT (":refresh=");
+    tstring::size_type const pos = option.rfind (refresh_opt);
+    if (pos != tstring::npos)
+    {
+        envKey.resize (pos);
+        tstring spec = option.substr (
+            pos + sizeof (refresh_opt) / sizeof (tchar) - 1);
+        long multiplier = 1000;
+        tstring::size_type const len = spec.length ();
+        if (len > 2
+            && spec.compare (len - 2, 2, LOG4CPLUS_TEXT ("ms")) == 0)
+        {
+            multiplier = 1;
+            spec.resize (len - 2);
+        }
+        else if (len > 1
+            && spec.compare (len - 1, 1, LOG4CPLUS_TEXT ("s")) == 0)
+            spec.resize (len - 1);
+
+        long const value
+            = std::atol (LOG4CPLUS_TSTRING_TO_STRING (spec).c_str ());
+        if (value > 0)
+            refreshInterval
+                = std::chrono::milliseconds (value * multiplier);
+        else
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("Invalid refresh interval in %E{")
+                + option + LOG4CPLUS_TEXT ("}"));
+    }
+
+    snapshot ();
+}
+
+
+void
+EnvPatternConverter::snapshot()
+{
+    if (! internal::get_env_var (envValue, envKey))
+        // Variable doesn't exist, use empty string.
+        envValue.clear ();
+
+    if (refreshInterval != std::chrono::steady_clock::duration ())
+        nextRefresh = std::chrono::steady_clock::now ()
+            + refreshInterval;
+}
 
 
 void
 EnvPatternConverter::convert(tstring & result,
     const spi::InternalLoggingEvent&)
 {
-    if (! internal::get_env_var (result, envKey))
+    // Access to the layout is serialized by the owning appender's
+    // mutex; only the generation counter is shared between threads.
+    unsigned const gen
+        = env_converter_generation.load (std::memory_order_relaxed);
+    if (LOG4CPLUS_UNLIKELY (gen != envGeneration
+        || (refreshInterval != std::chrono::steady_clock::duration ()
+            && std::chrono::steady_clock::now () >= nextRefresh)))
     {
-        // Variable doesn't exist, return empty string.
-        result.clear ();
+        snapshot ();
+        envGeneration = gen;
     }
+
+    result = envValue;
 }
 
 
@@ -589,6 +1099,7 @@ EnvPatternConverter::convert(tstring & result,
 
 RelativeTimestampConverter::RelativeTimestampConverter (FormattingInfo const & info)
     : PatternConverter (info)
+    , timeBase (getTTCCLayoutTimeBase ())
 { }
 
 
@@ -596,10 +1107,86 @@ void
 RelativeTimestampConverter::convert (tstring & result,
     spi::InternalLoggingEvent const & event)
 {
-    tostringstream & oss = internal::get_ptd ()->layout_oss;
-    detail::clear_tostringstream (oss);
-    log4cplus::formatRelativeTimestamp (oss, event);
-    result = oss.str ();
+    // Emit the digits directly instead of going through a stream,
+    // avoiding the per event locale aware numeric insertion. Width
+    // padding is applied by the caller through FormattingInfo; with
+    // the zero padding flag (e.g. %09r) the offset comes out at a
+    // fixed width so downstream parsers can rely on fixed offsets.
+    auto const duration = event.getTimestamp () - timeBase;
+    helpers::convertIntegerToString (result,
+        helpers::chrono::duration_cast<
+            helpers::chrono::duration<long long, std::milli>>(
+                duration).count ());
+}
+
+
+bool
+RelativeTimestampConverter::isShareable () const
+{
+    return true;
+}
+
+
+//
+//
+//
+
+SteadyTimestampConverter::SteadyTimestampConverter (FormattingInfo const & info)
+    : PatternConverter (info)
+{ }
+
+
+void
+SteadyTimestampConverter::convert (tstring & result,
+    spi::InternalLoggingEvent const & event)
+{
+    // The steady clock never steps backwards, so the emitted value
+    // orders this process' events without re-sorting. It is already
+    // kept in microseconds; emit the raw tick count.
+    helpers::convertIntegerToString (result,
+        event.getSteadyTimestamp ().time_since_epoch ().count ());
+}
+
+
+bool
+SteadyTimestampConverter::isShareable () const
+{
+    return true;
+}
+
+
+////////////////////////////////////////////////
+// SequencePatternConverter methods:
+////////////////////////////////////////////////
+
+SequencePatternConverter::SequencePatternConverter (
+    FormattingInfo const & info)
+    : PatternConverter (info)
+{ }
+
+
+void
+SequencePatternConverter::convert (tstring & result,
+    spi::InternalLoggingEvent const &)
+{
+    // The delivering appender stamps the number into the per thread
+    // slot right before it hands the event to the layout.
+    helpers::convertIntegerToString (result,
+        internal::get_ptd ()->appender_sequence);
+}
+
+
+bool
+SequencePatternConverter::perAppenderOutput () const
+{
+    return true;
+}
+
+
+bool
+SequencePatternConverter::isShareable () const
+{
+    return true;
 }
 
 
@@ -611,6 +1198,8 @@ HostnamePatternConverter::HostnamePatternConverter (
     const FormattingInfo& info, bool fqdn)
     : PatternConverter(info)
     , hostname_ (helpers::getHostname (fqdn))
+    , fqdn_ (fqdn)
+    , generation_ (internal::process_generation ())
 { }
 
 
@@ -618,10 +1207,23 @@ void
 HostnamePatternConverter::convert (
     tstring & result, const spi::InternalLoggingEvent&)
 {
+    unsigned const gen = internal::process_generation ();
+    if (gen != generation_)
+    {
+        hostname_ = helpers::getHostname (fqdn_);
+        generation_ = gen;
+    }
     result = hostname_;
 }
 
 
+bool
+HostnamePatternConverter::isProcessConstant() const
+{
+    return true;
+}
+
+
 
 ////////////////////////////////////////////////
 // MDCPatternConverter methods:
@@ -663,6 +1265,20 @@ log4cplus::pattern::MDCPatternConverter::convert (tstring & result,
 }
 
 
+unsigned
+log4cplus::pattern::MDCPatternConverter::neededEventFields () const
+{
+    return spi::EventFieldMDC;
+}
+
+
+bool
+log4cplus::pattern::MDCPatternConverter::isShareable () const
+{
+    return true;
+}
+
+
 ////////////////////////////////////////////////
 // NDCPatternConverter methods:
 ////////////////////////////////////////////////
@@ -692,6 +1308,20 @@ log4cplus::pattern::NDCPatternConverter::convert (tstring & result,
 }
 
 
+unsigned
+log4cplus::pattern::NDCPatternConverter::neededEventFields () const
+{
+    return spi::EventFieldNDC;
+}
+
+
+bool
+log4cplus::pattern::NDCPatternConverter::isShareable () const
+{
+    return true;
+}
+
+
 
 ////////////////////////////////////////////////
 // PatternParser methods:
@@ -799,6 +1429,10 @@ PatternParser::parse()
                 break;
             default:
                 if(c >= LOG4CPLUS_TEXT('0') && c <= LOG4CPLUS_TEXT('9')) {
+                    // A leading zero requests zero padding, printf
+                    // style; it is not part of the width itself.
+                    if (c == LOG4CPLUS_TEXT('0'))
+                        formattingInfo.zeroPad = true;
                     formattingInfo.minLen = c - LOG4CPLUS_TEXT('0');
                     state = MIN_STATE;
                 }
@@ -860,6 +1494,38 @@ PatternParser::parse()
       //getLogLog().debug("Parsed LITERAL converter: \""+currentLiteral+"\".");
     }
 
+    // Fold runs of process-constant converters--literals, hostname,
+    // process id, newline--into single pre-rendered converters, so
+    // that the per event chain only contains converters whose output
+    // actually varies. The pre-rendered text carries a process
+    // generation stamp and is re-rendered after fork, so %i and %h
+    // do not go stale in the child. The date converter needs no
+    // folding: it caches its strftime() output per second internally.
+    PatternConverterList folded;
+    folded.reserve (list.size ());
+    PatternConverterList run;
+    auto const flush_run = [&folded, &run] ()
+    {
+        if (run.empty ())
+            return;
+
+        folded.push_back (std::unique_ptr<PatternConverter>(
+            new ProcessConstantPatternConverter (std::move (run))));
+        run.clear ();
+    };
+    for (auto & pc : list)
+    {
+        if (pc && pc->isProcessConstant ())
+            run.push_back (std::move (pc));
+        else
+        {
+            flush_run ();
+            folded.push_back (std::move (pc));
+        }
+    }
+    flush_run ();
+    list.swap (folded);
+
     return std::move (list);
 }
 
@@ -870,6 +1536,10 @@ PatternParser::finalizeConverter(tchar c)
 {
     PatternConverter* pc = nullptr;
     switch (c) {
+        case LOG4CPLUS_TEXT('#'):
+            pc = new SequencePatternConverter (formattingInfo);
+            break;
+
         case LOG4CPLUS_TEXT('b'):
             pc = new BasicPatternConverter
                           (formattingInfo,
@@ -976,9 +1646,7 @@ PatternParser::finalizeConverter(tchar c)
             break;
 
         case LOG4CPLUS_TEXT('p'):
-            pc = new BasicPatternConverter
-                          (formattingInfo,
-                           BasicPatternConverter::LOGLEVEL_CONVERTER);
+            pc = new LogLevelPatternConverter (formattingInfo);
             //getLogLog().debug("LOGLEVEL converter.");
             //formattingInfo.dump(getLogLog());
             break;
@@ -989,6 +1657,10 @@ PatternParser::finalizeConverter(tchar c)
             //formattingInfo.dump(getLogLog());
             break;
 
+        case LOG4CPLUS_TEXT('R'):
+            pc = new SteadyTimestampConverter (formattingInfo);
+            break;
+
         case LOG4CPLUS_TEXT('t'):
             pc = new BasicPatternConverter
                           (formattingInfo,
@@ -1036,9 +1708,149 @@ PatternParser::finalizeConverter(tchar c)
 } // namespace pattern
 
 
+void
+refreshEnvConverters ()
+{
+    pattern::env_converter_generation.fetch_add (1,
+        std::memory_order_relaxed);
+}
+
+
 using PatternConverterList = pattern::PatternConverterList;
 
 
+#ifndef LOG4CPLUS_SINGLE_THREADED
+
+namespace
+{
+
+//! Background thread behind the ClockSyncInterval property. It
+//! periodically logs a record pairing the steady clock domain used
+//! by the %R conversion specifier with the wall clock, so that a
+//! cross-host log aggregator can map each host's monotonic
+//! timestamps onto a common time line instead of estimating clock
+//! skew from text timestamps.
+class ClockSyncThread
+    : public thread::AbstractThread
+{
+public:
+    explicit ClockSyncThread (unsigned intervalSeconds)
+        : interval (intervalSeconds)
+    { }
+
+    void signalExit ()
+    {
+        shouldTerminate.signal ();
+    }
+
+    //! Lowers the emission period to \c intervalSeconds if it is
+    //! shorter than the current one.
+    void lowerInterval (unsigned intervalSeconds)
+    {
+        unsigned current = interval.load (std::memory_order_relaxed);
+        while (intervalSeconds < current
+            && ! interval.compare_exchange_weak (current, intervalSeconds,
+                std::memory_order_relaxed))
+            ;
+    }
+
+protected:
+    void run () override
+    {
+        Logger logger
+            = Logger::getInstance (LOG4CPLUS_TEXT ("log4cplus.clock_sync"));
+        while (! shouldTerminate.timed_wait (
+            interval.load (std::memory_order_relaxed) * 1000ul))
+        {
+            // Sample the two clocks back to back so that the pair's
+            // skew is dominated by the clocks themselves rather than
+            // by this thread getting preempted between the samples.
+            helpers::SteadyTime const steady = helpers::steady_now ();
+            // Bypass the coarse timestamp cache; the sync record is
+            // only as good as its wall clock sample.
+            helpers::Time const wall
+                = helpers::time_cast (helpers::Clock::now ());
+
+            tostringstream oss;
+            oss << LOG4CPLUS_TEXT ("clock sync: steady_us=")
+                << steady.time_since_epoch ().count ()
+                << LOG4CPLUS_TEXT (" wall_us=")
+                << wall.time_since_epoch ().count ();
+            logger.log (INFO_LOG_LEVEL, oss.str ());
+        }
+    }
+
+private:
+    std::atomic<unsigned> interval;
+    thread::ManualResetEvent shouldTerminate;
+};
+
+
+std::mutex clockSyncMutex;
+unsigned clockSyncRefs = 0;
+helpers::SharedObjectPtr<ClockSyncThread> clockSyncThread;
+
+
+//! Starts the process-wide sync emitter or lowers its period; one
+//! thread serves every layout that sets ClockSyncInterval.
+void
+clockSyncAddReference (unsigned intervalSeconds)
+{
+    std::unique_lock<std::mutex> guard (clockSyncMutex);
+    ++clockSyncRefs;
+    if (! clockSyncThread)
+    {
+        clockSyncThread = helpers::SharedObjectPtr<ClockSyncThread> (
+            new ClockSyncThread (intervalSeconds));
+        clockSyncThread->start ();
+    }
+    else
+        clockSyncThread->lowerInterval (intervalSeconds);
+}
+
+
+void
+clockSyncRemoveReference ()
+{
+    helpers::SharedObjectPtr<ClockSyncThread> threadToJoin;
+    {
+        std::unique_lock<std::mutex> guard (clockSyncMutex);
+        if (--clockSyncRefs == 0)
+            threadToJoin.swap (clockSyncThread);
+    }
+    if (threadToJoin)
+    {
+        threadToJoin->signalExit ();
+        threadToJoin->join ();
+    }
+}
+
+} // namespace
+
+#endif // ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+
+namespace
+{
+
+using SharedPatternChain
+    = std::shared_ptr<pattern::PatternConverterList const>;
+
+std::mutex parse_cache_mutex;
+
+//! Process wide cache of parsed converter chains, keyed by the
+//! pattern and the NDC depth limit. Configurations routinely attach
+//! the same few patterns to many appenders; identically configured
+//! layouts then share one immutable chain instead of each running
+//! the parser and allocating its own converters. Only chains whose
+//! converters all report PatternConverter::isShareable() are
+//! entered, since a shared chain may format events for several
+//! appenders concurrently.
+std::map<std::pair<tstring, unsigned>, SharedPatternChain> parse_cache;
+
+} // namespace
+
+
 ////////////////////////////////////////////////
 // PatternLayout methods:
 ////////////////////////////////////////////////
@@ -1076,6 +1888,30 @@ PatternLayout::PatternLayout(const helpers::Properties& properties)
             true);
     }
 
+    properties.getString (headerPattern, LOG4CPLUS_TEXT ("HeaderPattern"));
+    properties.getString (footerPattern, LOG4CPLUS_TEXT ("FooterPattern"));
+
+    properties.getBool (prefixEmbeddedNewlines,
+        LOG4CPLUS_TEXT ("PrefixEmbeddedNewlines"));
+    if (prefixEmbeddedNewlines && formatKey != 0)
+        // Distinguish the format key from an identically patterned
+        // layout without per line prefixing; see getFormatKey().
+        formatKey = (formatKey ^ 0x517cc1b7u) | 1;
+
+    properties.getUInt (clockSyncInterval,
+        LOG4CPLUS_TEXT ("ClockSyncInterval"));
+#ifndef LOG4CPLUS_SINGLE_THREADED
+    if (clockSyncInterval != 0)
+        clockSyncAddReference (clockSyncInterval);
+#else
+    if (clockSyncInterval != 0)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("PatternLayout- ClockSyncInterval is ignored")
+            LOG4CPLUS_TEXT (" in single threaded builds."));
+        clockSyncInterval = 0;
+    }
+#endif
 }
 
 
@@ -1083,35 +1919,124 @@ void
 PatternLayout::init(const tstring& pattern_, unsigned ndcMaxDepth)
 {
     pattern = pattern_;
-    parsedPattern = pattern::PatternParser(pattern, ndcMaxDepth).parse();
 
-    // Let's validate that our parser didn't give us any NULLs.  If it did,
-    // we will convert them to a valid PatternConverter that does nothing so
-    // at least we don't core.
-    for (auto & pc : parsedPattern)
+    std::pair<tstring, unsigned> const cacheKey (pattern, ndcMaxDepth);
     {
-        if (! pc)
+        std::unique_lock<std::mutex> guard (parse_cache_mutex);
+        auto it = parse_cache.find (cacheKey);
+        if (it != parse_cache.end ())
+            parsedPattern = it->second;
+    }
+
+    if (! parsedPattern)
+    {
+        pattern::PatternConverterList chain
+            = pattern::PatternParser(pattern, ndcMaxDepth).parse();
+
+        // Let's validate that our parser didn't give us any NULLs.  If it
+        // did, we will convert them to a valid PatternConverter that does
+        // nothing so at least we don't core.
+        for (auto & pc : chain)
         {
-            helpers::getLogLog().error(
-                LOG4CPLUS_TEXT("Parsed Pattern created a NULL PatternConverter"));
-            pc = std::make_unique<pattern::LiteralPatternConverter> ();
+            if (! pc)
+            {
+                helpers::getLogLog().error(
+                    LOG4CPLUS_TEXT("Parsed Pattern created a NULL PatternConverter"));
+                pc = std::make_unique<pattern::LiteralPatternConverter> ();
+            }
+        }
+
+        if(chain.empty ())
+        {
+            helpers::getLogLog().warn(
+                LOG4CPLUS_TEXT("PatternLayout pattern is empty.  Using default..."));
+            chain.push_back (
+                std::unique_ptr<pattern::PatternConverter>(
+                    new pattern::BasicPatternConverter(pattern::FormattingInfo(),
+                        pattern::BasicPatternConverter::MESSAGE_CONVERTER)));
+        }
+
+        bool shareable = true;
+        for (auto const & pc : chain)
+            shareable = shareable && pc->isShareable ();
+
+        parsedPattern = std::make_shared<pattern::PatternConverterList> (
+            std::move (chain));
+
+        if (shareable)
+        {
+            std::unique_lock<std::mutex> guard (parse_cache_mutex);
+            // Another thread may have parsed the same pattern in the
+            // meantime; everybody keeps whichever chain got in first.
+            parsedPattern = parse_cache.emplace (cacheKey,
+                parsedPattern).first->second;
         }
     }
 
-    if(parsedPattern.empty ())
+    // The formatted output is a pure function of the pattern and the
+    // NDC depth limit, so identically configured instances share a
+    // format key and their output can be reused across appenders.
+    std::size_t key = std::hash<tstring> () (pattern);
+    key ^= static_cast<std::size_t>(ndcMaxDepth) + 0x9e3779b9u
+        + (key << 6) + (key >> 2);
+    formatKey = key | 1;
+
+    neededEventFields = 0;
+    for (auto const & pc : *parsedPattern)
     {
-        helpers::getLogLog().warn(
-            LOG4CPLUS_TEXT("PatternLayout pattern is empty.  Using default..."));
-        parsedPattern.push_back (
-            std::unique_ptr<pattern::PatternConverter>(
-                new pattern::BasicPatternConverter(pattern::FormattingInfo(),
-                    pattern::BasicPatternConverter::MESSAGE_CONVERTER)));
+        neededEventFields |= pc->neededEventFields ();
+        // The output of such patterns differs between appenders
+        // delivering the same event, so formatted lines must not be
+        // reused through the format key cache.
+        if (pc->perAppenderOutput ())
+            formatKey = 0;
     }
 }
 
 
 
-PatternLayout::~PatternLayout() = default;
+PatternLayout::~PatternLayout()
+{
+#ifndef LOG4CPLUS_SINGLE_THREADED
+    if (clockSyncInterval != 0)
+        clockSyncRemoveReference ();
+#endif
+}
+
+
+tstring
+PatternLayout::renderHeader ()
+{
+    return renderBanner (headerPattern);
+}
+
+
+tstring
+PatternLayout::renderFooter ()
+{
+    return renderBanner (footerPattern);
+}
+
+
+tstring
+PatternLayout::renderBanner (const tstring & bannerPattern) const
+{
+    tstring result;
+    if (bannerPattern.empty ())
+        return result;
+
+    // The banner is rendered once and the caller caches it, so the
+    // useful ingredients are literal text and the process constant
+    // conversions (%h, %H, %i, %E). Per event conversions render
+    // against this empty synthetic event and merely reflect the
+    // render time.
+    spi::InternalLoggingEvent event (tstring (), NOT_SET_LOG_LEVEL,
+        tstring (), nullptr, 0);
+    for (auto const & pc
+        : pattern::PatternParser (bannerPattern, 0).parse ())
+        pc->append (result, event);
+    return result;
+}
 
 
 
@@ -1119,10 +2044,108 @@ void
 PatternLayout::formatAndAppend(tostream& output,
                                const spi::InternalLoggingEvent& event)
 {
-    for (auto const & pc : parsedPattern)
+    // Assemble the whole line in a reusable per-thread string buffer
+    // and hand it to the stream in a single write, paying the stream
+    // sentry cost once per event rather than once per converter.
+    tstring & buf = internal::get_ptd ()->layout_str;
+    buf.clear ();
+    if (prefixEmbeddedNewlines
+        && event.getMessage ().find (LOG4CPLUS_TEXT ('\n')) != tstring::npos)
+        appendPerLine (buf, event);
+    else
+        for (auto const & pc : *parsedPattern)
+        {
+            pc->append(buf, event);
+        }
+    output.write (buf.data (), static_cast<std::streamsize>(buf.size ()));
+}
+
+
+void
+PatternLayout::appendPerLine (tstring & buf,
+    const spi::InternalLoggingEvent& event)
+{
+    // Render the output before and after %m once; the per line loop
+    // below only copies the pre-rendered pieces around each message
+    // line.
+    mlPrefix.clear ();
+    mlSuffix.clear ();
+    tstring * part = &mlPrefix;
+    for (auto const & pc : *parsedPattern)
     {
-        pc->formatAndAppend(output, event);
+        if (part == &mlPrefix && pc->emitsMessage ())
+            part = &mlSuffix;
+        else
+            pc->append (*part, event);
+    }
+
+    if (part == &mlPrefix)
+    {
+        // The pattern does not contain %m; there is nothing to
+        // replicate per line.
+        buf += mlPrefix;
+        return;
+    }
+
+    tstring const & message = event.getMessage ();
+    tstring::size_type line_begin = 0;
+    while (true)
+    {
+        tstring::size_type const nl = message.find (LOG4CPLUS_TEXT ('\n'),
+            line_begin);
+        tstring::size_type const line_end
+            = nl == tstring::npos ? message.size () : nl;
+        buf += mlPrefix;
+        buf.append (message, line_begin, line_end - line_begin);
+        buf += mlSuffix;
+        if (nl == tstring::npos)
+            break;
+        line_begin = nl + 1;
+        // A trailing newline does not produce an empty extra line.
+        if (line_begin == message.size ())
+            break;
+    }
+}
+
+
+std::size_t
+PatternLayout::getFormatKey () const
+{
+    return formatKey;
+}
+
+
+unsigned
+PatternLayout::getNeededEventFields () const
+{
+    return neededEventFields;
+}
+
+
+void
+PatternLayout::formatAndAppendBatch(tostream& output,
+    const spi::InternalLoggingEvent* events, std::size_t count)
+{
+    // Assemble the whole batch in the per-thread buffer and write it
+    // out in one go.
+    tstring & buf = internal::get_ptd ()->layout_str;
+    buf.clear ();
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        if (prefixEmbeddedNewlines
+            && events[i].getMessage ().find (LOG4CPLUS_TEXT ('\n'))
+                != tstring::npos)
+        {
+            appendPerLine (buf, events[i]);
+            continue;
+        }
+
+        for (auto const & pc : *parsedPattern)
+        {
+            pc->append(buf, events[i]);
+        }
     }
+    output.write (buf.data (), static_cast<std::streamsize>(buf.size ()));
 }
 
 
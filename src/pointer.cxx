@@ -23,18 +23,55 @@
 #include <log4cplus/thread/threads.h>
 #include <log4cplus/thread/impl/syncprims-impl.h>
 #include <cassert>
+#if defined (LOG4CPLUS_DEBUG_SHARED_OBJECT_REF_COUNT)
+#include <cstdio>
+#include <cstdlib>
+#endif
 
 
 namespace log4cplus::helpers {
 
 
+#if defined (LOG4CPLUS_DEBUG_SHARED_OBJECT_REF_COUNT)
+namespace
+{
+
+// Poison value stored into the counter just before deletion so that a
+// stray addReference() or removeReference() racing with or following
+// destruction is caught instead of silently resurrecting or double
+// deleting the object. No reachable real count gets anywhere near it.
+unsigned const poisoned_count = 0xDEADBEEFu;
+
+
+[[noreturn]] void
+ref_count_violation (char const * what)
+{
+    // LogLog cannot be used here; it is itself reference counted and
+    // the violation may concern its own instance.
+    std::fprintf (stderr,
+        "log4cplus: SharedObject reference count violation: %s\n", what);
+    std::abort ();
+}
+
+} // namespace
+#endif
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // log4cplus::helpers::SharedObject dtor
 ///////////////////////////////////////////////////////////////////////////////
 
 SharedObject::~SharedObject()
 {
+#if defined (LOG4CPLUS_DEBUG_SHARED_OBJECT_REF_COUNT)
+    // Objects destroyed through removeReference() carry the poison
+    // value here; objects destroyed directly (members, stack or
+    // static instances) must never have been referenced.
+    if (count__ != 0 && count__ != poisoned_count)
+        ref_count_violation ("destroyed with live references");
+#else
     assert(count__ == 0);
+#endif
 }
 
 
@@ -47,8 +84,18 @@ void
 SharedObject::addReference() const LOG4CPLUS_NOEXCEPT
 {
 #if defined (LOG4CPLUS_SINGLE_THREADED)
+#if defined (LOG4CPLUS_DEBUG_SHARED_OBJECT_REF_COUNT)
+    if (count__ >= poisoned_count)
+        ref_count_violation ("addReference() on destroyed object");
+#endif
     ++count__;
 
+#elif defined (LOG4CPLUS_DEBUG_SHARED_OBJECT_REF_COUNT)
+    unsigned const previous = std::atomic_fetch_add_explicit (&count__, 1U,
+        std::memory_order_relaxed);
+    if (previous >= poisoned_count)
+        ref_count_violation ("addReference() on destroyed object");
+
 #else
     std::atomic_fetch_add_explicit (&count__, 1U,
         std::memory_order_relaxed);
@@ -64,13 +111,34 @@ SharedObject::removeReference() const
     bool destroy;
 
 #if defined (LOG4CPLUS_SINGLE_THREADED)
+#if defined (LOG4CPLUS_DEBUG_SHARED_OBJECT_REF_COUNT)
+    if (count__ == 0 || count__ >= poisoned_count)
+        ref_count_violation (
+            "removeReference() underflow or on destroyed object");
+#endif
     destroy = --count__ == 0;
+#if defined (LOG4CPLUS_DEBUG_SHARED_OBJECT_REF_COUNT)
+    if (destroy)
+        count__ = poisoned_count;
+#endif
 
 #else
-    destroy = std::atomic_fetch_sub_explicit (&count__, 1U,
-        std::memory_order_release) == 1;
+    unsigned const previous = std::atomic_fetch_sub_explicit (&count__, 1U,
+        std::memory_order_release);
+#if defined (LOG4CPLUS_DEBUG_SHARED_OBJECT_REF_COUNT)
+    if (previous == 0 || previous >= poisoned_count)
+        ref_count_violation (
+            "removeReference() underflow or on destroyed object");
+#endif
+    destroy = previous == 1;
     if (LOG4CPLUS_UNLIKELY (destroy))
+    {
         std::atomic_thread_fence (std::memory_order_acquire);
+#if defined (LOG4CPLUS_DEBUG_SHARED_OBJECT_REF_COUNT)
+        std::atomic_store_explicit (&count__, poisoned_count,
+            std::memory_order_relaxed);
+#endif
+    }
 
 #endif
     if (LOG4CPLUS_UNLIKELY (destroy))
@@ -70,39 +70,32 @@ is_space (tchar ch)
 
 
 static
-void
-trim_leading_ws (tstring & str)
+tstring_view
+trim_leading_ws (tstring_view str)
 {
-    tstring::iterator it = str.begin ();
-    for (; it != str.end (); ++it)
-    {
-        if (! is_space (*it))
-            break;
-    }
-    str.erase (str.begin (), it);
+    while (! str.empty () && is_space (str.front ()))
+        str.remove_prefix (1);
+
+    return str;
 }
 
 
 static
-void
-trim_trailing_ws (tstring & str)
+tstring_view
+trim_trailing_ws (tstring_view str)
 {
-    tstring::reverse_iterator rit = str.rbegin ();
-    for (; rit != str.rend (); ++rit)
-    {
-        if (! is_space (*rit))
-            break;
-    }
-    str.erase (rit.base (), str.end ());
+    while (! str.empty () && is_space (str.back ()))
+        str.remove_suffix (1);
+
+    return str;
 }
 
 
 static
-void
-trim_ws (tstring & str)
+tstring_view
+trim_ws (tstring_view str)
 {
-    trim_trailing_ws (str);
-    trim_leading_ws (str);
+    return trim_leading_ws (trim_trailing_ws (str));
 }
 
 
@@ -111,23 +104,23 @@ CATCH_TEST_CASE( "String trimming", "[strings][properties]")
 {
     CATCH_SECTION ("trim trailing whitespace")
     {
-        tstring trailing_ws (LOG4CPLUS_TEXT ("abcd \t\n\v\f\r"));
-        trim_trailing_ws (trailing_ws);
-        CATCH_REQUIRE (trailing_ws == LOG4CPLUS_TEXT ("abcd"));
+        tstring const trailing_ws (LOG4CPLUS_TEXT ("abcd \t\n\v\f\r"));
+        CATCH_REQUIRE (trim_trailing_ws (trailing_ws)
+            == tstring_view (LOG4CPLUS_TEXT ("abcd")));
     }
 
     CATCH_SECTION ("trim leading whitespace")
     {
-        tstring leading_ws (LOG4CPLUS_TEXT (" \t\n\v\f\rabcd"));
-        trim_leading_ws (leading_ws);
-        CATCH_REQUIRE (leading_ws == LOG4CPLUS_TEXT ("abcd"));
+        tstring const leading_ws (LOG4CPLUS_TEXT (" \t\n\v\f\rabcd"));
+        CATCH_REQUIRE (trim_leading_ws (leading_ws)
+            == tstring_view (LOG4CPLUS_TEXT ("abcd")));
     }
 
     CATCH_SECTION ("trim all whitespace")
     {
-        tstring ws (LOG4CPLUS_TEXT (" \t\n\v\f\rabcd \t\n\v\f\r"));
-        trim_ws (ws);
-        CATCH_REQUIRE (ws == LOG4CPLUS_TEXT ("abcd"));
+        tstring const ws (LOG4CPLUS_TEXT (" \t\n\v\f\rabcd \t\n\v\f\r"));
+        CATCH_REQUIRE (trim_ws (ws)
+            == tstring_view (LOG4CPLUS_TEXT ("abcd")));
     }
 }
 #endif
@@ -232,27 +225,49 @@ Properties::init(tistream& input)
     if (! input)
         return;
 
-    tstring buffer;
-    while (std::getline (input, buffer))
+    // Slurp the whole stream in one go and tokenize the buffer in
+    // place using string views. Reading line by line with getline()
+    // and trimming through temporary substrings allocates several
+    // times per line, which adds up on large configuration files.
+    tstring text;
     {
-        trim_leading_ws (buffer);
+        tostringstream oss;
+        oss << input.rdbuf ();
+        text = oss.str ();
+    }
 
-        tstring::size_type const buffLen = buffer.size ();
-        if (buffLen == 0 || buffer[0] == PROPERTIES_COMMENT_CHAR)
+    tstring_view rest (text);
+    while (! rest.empty ())
+    {
+        tstring_view line;
+        tstring_view::size_type const eol = rest.find (LOG4CPLUS_TEXT ('\n'));
+        if (eol == tstring_view::npos)
+        {
+            line = rest;
+            rest = tstring_view ();
+        }
+        else
+        {
+            line = rest.substr (0, eol);
+            rest.remove_prefix (eol + 1);
+        }
+
+        line = trim_leading_ws (line);
+
+        if (line.empty () || line.front () == PROPERTIES_COMMENT_CHAR)
             continue;
 
         // Check if we have a trailing \r because we are
         // reading a properties file produced on Windows.
-        if (buffer[buffLen-1] == LOG4CPLUS_TEXT('\r'))
+        if (line.back () == LOG4CPLUS_TEXT('\r'))
             // Remove trailing 'Windows' \r.
-            buffer.resize (buffLen - 1);
+            line.remove_suffix (1);
 
-        if (buffer.size () >= 7 + 1 + 1
-            && buffer.compare (0, 7, LOG4CPLUS_TEXT ("include")) == 0
-            && is_space (buffer[7]))
+        if (line.size () >= 7 + 1 + 1
+            && line.compare (0, 7, LOG4CPLUS_TEXT ("include")) == 0
+            && is_space (line[7]))
         {
-            tstring included (buffer, 8) ;
-            trim_ws (included);
+            tstring const included (trim_ws (line.substr (8)));
 
             tifstream file;
             imbue_file_from_flags (file, flags);
@@ -267,14 +282,14 @@ Properties::init(tistream& input)
         }
         else
         {
-            tstring::size_type const idx = buffer.find(LOG4CPLUS_TEXT ('='));
-            if (idx != tstring::npos)
+            tstring_view::size_type const idx
+                = line.find (LOG4CPLUS_TEXT ('='));
+            if (idx != tstring_view::npos)
             {
-                tstring key = buffer.substr(0, idx);
-                tstring value = buffer.substr(idx + 1);
-                trim_trailing_ws (key);
-                trim_ws (value);
-                setProperty(key, value);
+                tstring_view const key
+                    = trim_trailing_ws (line.substr (0, idx));
+                tstring_view const value = trim_ws (line.substr (idx + 1));
+                setProperty (tstring (key), tstring (value));
             }
         }
     }
@@ -305,6 +320,13 @@ Properties::exists(tchar const * key) const
 }
 
 
+bool
+Properties::exists(tstring_view key) const
+{
+    return data.find(key) != data.end();
+}
+
+
 tstring const &
 Properties::getProperty(const tstring& key) const
 {
@@ -319,6 +341,13 @@ Properties::getProperty(tchar const * key) const
 }
 
 
+log4cplus::tstring const &
+Properties::getProperty(tstring_view key) const
+{
+    return get_property_worker (key);
+}
+
+
 tstring
 Properties::getProperty(const tstring& key, const tstring& defaultVal) const
 {
@@ -480,8 +509,11 @@ CATCH_TEST_CASE ("Properties", "[properties]")
         props.setProperty (PROP_ABC, LOG4CPLUS_TEXT ("true"));
         CATCH_REQUIRE (props.exists (PROP_ABC));
         CATCH_REQUIRE (props.exists (LOG4CPLUS_C_STR_TO_TSTRING (PROP_ABC)));
+        CATCH_REQUIRE (props.exists (tstring_view (PROP_ABC)));
         CATCH_REQUIRE (props.getProperty (PROP_ABC)
             == LOG4CPLUS_TEXT ("true"));
+        CATCH_REQUIRE (props.getProperty (tstring_view (PROP_ABC))
+            == LOG4CPLUS_TEXT ("true"));
     }
 
     CATCH_SECTION ("type conversions work")
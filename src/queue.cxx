@@ -26,33 +26,238 @@
 
 #include <log4cplus/helpers/queue.h>
 #include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/memorybudget.h>
+#include <log4cplus/internal/env.h>
+#include <log4cplus/internal/tracepoints.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
 #include <stdexcept>
 #include <algorithm>
 #include <iterator>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 
 namespace log4cplus::thread {
 
 
 Queue::Queue (unsigned len)
-    : ev_consumer (false)
+    : queue_size (0)
+    , ev_consumer (false)
     , sem (len, len)
     , flags (DRAIN)
+    , max_len (len)
+    , overflow_policy (BLOCK)
+    , drop_below_level (WARN_LOG_LEVEL)
+    , dropped (0)
+    , occupancy (0)
+    , spill_pending_bytes (0)
 { }
 
 
-Queue::~Queue () = default;
+Queue::~Queue ()
+{
+    for (auto const & region : locked_regions)
+        internal::unlock_memory (region.first, region.second);
+}
+
+
+bool
+Queue::lock_region (void * addr, std::size_t size)
+{
+    if (! internal::lock_memory (addr, size))
+        return false;
+
+    locked_regions.emplace_back (addr, size);
+    return true;
+}
+
+
+bool
+Queue::lock_storage ()
+{
+    // The deque-style queue grows lazily; pre-size it to its bound so
+    // that there is a stable region to pin. Growth past the reserved
+    // capacity (e.g. the spill buffer) stays unlocked.
+    queue.reserve (max_len);
+    return lock_region (queue.data (),
+        queue.capacity () * sizeof (spi::InternalLoggingEvent));
+}
 
 
+std::size_t
+Queue::get_occupancy () const
+{
+    return occupancy.load (std::memory_order_relaxed);
+}
+
+
+void
+Queue::set_overflow_policy (OverflowPolicy policy, LogLevel drop_below)
+{
+    overflow_policy = policy;
+    drop_below_level = drop_below;
+}
+
+
+std::size_t
+Queue::event_memory_cost (spi::InternalLoggingEvent const & ev)
+{
+    // Rough estimate: the event object plus its heap allocated
+    // strings. The exact figure does not matter as long as charge and
+    // release agree, which they do because the strings are not
+    // mutated while the event sits in the queue.
+    return sizeof (spi::InternalLoggingEvent)
+        + (ev.getMessage ().size () + ev.getLoggerName ().size ())
+        * sizeof (tchar);
+}
+
+
+bool
+Queue::budget_shed (spi::InternalLoggingEvent const & ev)
+{
+    helpers::MemoryBudget & budget = helpers::MemoryBudget::instance ();
+    if (! budget.shouldShed (ev.getLogLevel ()))
+        return false;
+
+    budget.countShedEvent ();
+    dropped.fetch_add (1, std::memory_order_relaxed);
+    return true;
+}
+
+
+void
+Queue::budget_release (queue_storage_type const & buf)
+{
+    if (buf.empty ())
+        return;
+
+    std::size_t total = 0;
+    for (spi::InternalLoggingEvent const & ev : buf)
+        total += event_memory_cost (ev);
+
+    helpers::MemoryBudget::instance ().release (total);
+}
+
+
+template <typename EventRef>
+void
+Queue::recycle_push (EventRef && ev)
+{
+    if (queue_size < queue.size ())
+    {
+        // Reuse the string storage of an already delivered event
+        // shell handed back by the consumer's last swap, so the
+        // steady-state producer path does not allocate.
+        if constexpr (std::is_lvalue_reference_v<EventRef>)
+            queue[queue_size].assign (ev);
+        else
+            queue[queue_size] = std::move (ev);
+    }
+    else
+        queue.push_back (std::forward<EventRef> (ev));
+    ++queue_size;
+}
+
+
+template <typename EventRef>
 Queue::flags_type
-Queue::put_event (spi::InternalLoggingEvent const & ev)
+Queue::put_event_worker (EventRef && ev)
 {
+    LOG4CPLUS_TRACEPOINT1 (queue_put, this);
+
     flags_type ret_flags = ERROR_BIT;
     try
     {
         ev.gatherThreadSpecificData ();
 
+        if (budget_shed (ev))
+        {
+            ret_flags &= ~ERROR_BIT;
+            return ret_flags;
+        }
+
+        std::size_t const ev_cost = event_memory_cost (ev);
+
+        if (overflow_policy != BLOCK)
+        {
+            // The drop policies enforce the queue limit by checking
+            // the queue length under the mutex instead of through the
+            // semaphore, so that a full queue never blocks producers.
+            MutexGuard mguard (mutex);
+
+            ret_flags |= flags;
+
+            if (flags & EXIT)
+            {
+                ret_flags &= ~(ERROR_BIT | ERROR_AFTER);
+                return ret_flags;
+            }
+
+            if (queue_size >= max_len)
+            {
+                if (overflow_policy == SPILL_TO_DISK)
+                {
+                    // Park the event for the consumer to persist to
+                    // disk. The parking buffer is bounded by a fixed
+                    // memory budget; beyond that the event is
+                    // dropped.
+                    if (spill_pending_bytes + ev_cost
+                        <= spill_pending_max_bytes)
+                    {
+                        spill_pending.push_back (
+                            std::forward<EventRef> (ev));
+                        spill_pending_bytes += ev_cost;
+                    }
+                    else
+                        dropped.fetch_add (1, std::memory_order_relaxed);
+                    mguard.unlock ();
+                    mguard.detach ();
+                    ev_consumer.signal ();
+                    ret_flags &= ~(ERROR_BIT | ERROR_AFTER);
+                    return ret_flags;
+                }
+                else if (overflow_policy == DROP_OLDEST)
+                {
+                    // O(queue length), but only ever paid while the
+                    // queue is overflowing. The rotate keeps the
+                    // oldest event's shell around as recyclable
+                    // storage for the incoming event instead of
+                    // destroying it.
+                    std::rotate (queue.begin (), queue.begin () + 1,
+                        queue.begin () + queue_size);
+                    --queue_size;
+                }
+                else if (overflow_policy == DROP_NEWEST
+                    || ev.getLogLevel () < drop_below_level)
+                {
+                    mguard.unlock ();
+                    mguard.detach ();
+                    dropped.fetch_add (1, std::memory_order_relaxed);
+                    ret_flags &= ~(ERROR_BIT | ERROR_AFTER);
+                    return ret_flags;
+                }
+                // else: DROP_BELOW_LEVEL event at or above the
+                // threshold; it is enqueued over the limit.
+
+                if (overflow_policy == DROP_OLDEST)
+                    dropped.fetch_add (1, std::memory_order_relaxed);
+            }
+
+            recycle_push (std::forward<EventRef> (ev));
+            occupancy.store (queue_size, std::memory_order_relaxed);
+            helpers::MemoryBudget::instance ().charge (ev_cost);
+            ret_flags |= ERROR_AFTER;
+            flags |= QUEUE;
+            ret_flags |= flags;
+            mguard.unlock ();
+            mguard.detach ();
+            ev_consumer.signal ();
+
+            ret_flags &= ~(ERROR_BIT | ERROR_AFTER);
+            return ret_flags;
+        }
+
         SemaphoreGuard semguard (sem);
         MutexGuard mguard (mutex);
 
@@ -65,7 +270,9 @@ Queue::put_event (spi::InternalLoggingEvent const & ev)
         }
         else
         {
-            queue.push_back (ev);
+            recycle_push (std::forward<EventRef> (ev));
+            occupancy.store (queue_size, std::memory_order_relaxed);
+            helpers::MemoryBudget::instance ().charge (ev_cost);
             ret_flags |= ERROR_AFTER;
             semguard.detach ();
             flags |= QUEUE;
@@ -88,6 +295,20 @@ Queue::put_event (spi::InternalLoggingEvent const & ev)
 }
 
 
+Queue::flags_type
+Queue::put_event (spi::InternalLoggingEvent const & ev)
+{
+    return put_event_worker (ev);
+}
+
+
+Queue::flags_type
+Queue::put_event (spi::InternalLoggingEvent && ev)
+{
+    return put_event_worker (std::move (ev));
+}
+
+
 Queue::flags_type
 Queue::signal_exit (bool drain)
 {
@@ -141,25 +362,41 @@ Queue::get_events (queue_storage_type * buf)
             if (((QUEUE & flags) && ! (EXIT & flags))
                 || ((EXIT | DRAIN | QUEUE) & flags) == (EXIT | DRAIN | QUEUE))
             {
-                assert (! queue.empty ());
+                assert (queue_size != 0);
 
-                std::size_t const count = queue.size ();
+                std::size_t const count = queue_size;
+                // The swap hands the consumer's previously delivered
+                // events back as spare shells for producers to
+                // recycle; only the first count elements of *buf are
+                // live events, any trailing shells are trimmed.
                 queue.swap (*buf);
-                queue.clear ();
+                queue_size = 0;
+                occupancy.store (0, std::memory_order_relaxed);
+                if (buf->size () > count)
+                    buf->resize (count);
+                budget_release (*buf);
                 flags &= ~QUEUE;
-                for (std::size_t i = 0; i != count; ++i)
-                    sem.unlock ();
+                // The drop policies do not go through the semaphore.
+                if (overflow_policy == BLOCK)
+                    for (std::size_t i = 0; i != count; ++i)
+                        sem.unlock ();
 
                 ret_flags = flags | EVENT;
+                LOG4CPLUS_TRACEPOINT2 (queue_get, this, count);
                 break;
             }
             else if (((EXIT | QUEUE) & flags) == (EXIT | QUEUE))
             {
-                assert (! queue.empty ());
+                assert (queue_size != 0);
+                queue.resize (queue_size);
+                budget_release (queue);
                 queue.clear ();
+                queue_size = 0;
+                occupancy.store (0, std::memory_order_relaxed);
                 flags &= ~QUEUE;
                 ev_consumer.reset ();
-                sem.unlock ();
+                if (overflow_policy == BLOCK)
+                    sem.unlock ();
                 ret_flags = flags;
                 break;
             }
@@ -186,6 +423,660 @@ Queue::get_events (queue_storage_type * buf)
 }
 
 
+Queue::flags_type
+Queue::try_get_events (queue_storage_type * buf)
+{
+    flags_type ret_flags = 0;
+
+    try
+    {
+        MutexGuard mguard (mutex);
+
+        ret_flags = flags;
+
+        if (((QUEUE & flags) && ! (EXIT & flags))
+            || ((EXIT | DRAIN | QUEUE) & flags) == (EXIT | DRAIN | QUEUE))
+        {
+            assert (queue_size != 0);
+
+            std::size_t const count = queue_size;
+            // Same shell recycling swap as in get_events().
+            queue.swap (*buf);
+            queue_size = 0;
+            occupancy.store (0, std::memory_order_relaxed);
+            if (buf->size () > count)
+                buf->resize (count);
+            budget_release (*buf);
+            flags &= ~QUEUE;
+            // The drop policies do not go through the semaphore.
+            if (overflow_policy == BLOCK)
+                for (std::size_t i = 0; i != count; ++i)
+                    sem.unlock ();
+
+            ret_flags = flags | EVENT;
+            LOG4CPLUS_TRACEPOINT2 (queue_get, this, count);
+        }
+    }
+    catch (std::runtime_error const & e)
+    {
+        log4cplus::helpers::getLogLog().error(
+            LOG4CPLUS_TEXT("try_get_events() exception: ")
+            + LOG4CPLUS_C_STR_TO_TSTRING(e.what()));
+        ret_flags |= ERROR_BIT;
+    }
+
+    return ret_flags;
+}
+
+
+bool
+Queue::take_spill_pending (queue_storage_type & buf)
+{
+    MutexGuard mguard (mutex);
+
+    if (spill_pending.empty ())
+        return false;
+
+    // The swap hands the caller's previously used storage back to the
+    // producers' side for reuse.
+    buf.swap (spill_pending);
+    spill_pending_bytes = 0;
+    return true;
+}
+
+
+bool
+Queue::has_spill_pending ()
+{
+    MutexGuard mguard (mutex);
+    return ! spill_pending.empty ();
+}
+
+
+namespace
+{
+
+//! Round n up to the nearest power of two, at least 2.
+static
+std::size_t
+round_up_pow2 (std::size_t n)
+{
+    std::size_t result = 2;
+    while (result < n)
+        result <<= 1;
+    return result;
+}
+
+} // namespace
+
+
+RingQueue::RingQueue (unsigned len)
+    : Queue (len)
+    , ring (round_up_pow2 (len))
+    , mask (ring.size () - 1)
+    , enqueue_pos (0)
+    , dequeue_pos (0)
+    , ring_flags (DRAIN)
+{
+    for (std::size_t i = 0; i != ring.size (); ++i)
+        ring[i].seq.store (i, std::memory_order_relaxed);
+}
+
+
+RingQueue::~RingQueue () = default;
+
+
+std::size_t
+RingQueue::get_occupancy () const
+{
+    std::size_t const tail = dequeue_pos.load (std::memory_order_relaxed);
+    std::size_t const head = enqueue_pos.load (std::memory_order_relaxed);
+    return head >= tail ? head - tail : 0;
+}
+
+
+bool
+RingQueue::lock_storage ()
+{
+    return lock_region (ring.data (), ring.size () * sizeof (Slot));
+}
+
+
+template <typename EventRef>
+RingQueue::flags_type
+RingQueue::put_event_worker (EventRef && ev)
+{
+    LOG4CPLUS_TRACEPOINT1 (queue_put, this);
+
+    flags_type ret_flags = ERROR_BIT;
+    try
+    {
+        ev.gatherThreadSpecificData ();
+
+        if (budget_shed (ev))
+            return ring_flags.load (std::memory_order_acquire);
+
+        std::size_t const ev_cost = event_memory_cost (ev);
+
+        std::size_t pos = enqueue_pos.load (std::memory_order_relaxed);
+        while (true)
+        {
+            flags_type const f
+                = ring_flags.load (std::memory_order_acquire);
+            if (f & EXIT)
+                return f;
+
+            Slot & slot = ring[pos & mask];
+            std::size_t const seq
+                = slot.seq.load (std::memory_order_acquire);
+            std::ptrdiff_t const diff
+                = static_cast<std::ptrdiff_t>(seq)
+                - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                // The slot is free. Claim it with a single CAS.
+                if (enqueue_pos.compare_exchange_weak (pos, pos + 1,
+                        std::memory_order_relaxed))
+                {
+                    if constexpr (std::is_lvalue_reference_v<EventRef>)
+                        // Member-wise assignment reuses the string
+                        // storage kept alive in the slot from previous
+                        // laps, so the steady-state producer path does
+                        // not allocate.
+                        slot.ev.assign (ev);
+                    else
+                        // Swap based move assignment; the slot's
+                        // recycled storage ends up in the expiring
+                        // source event.
+                        slot.ev = std::move (ev);
+                    // Publish the slot to the consumer.
+                    slot.seq.store (pos + 1, std::memory_order_release);
+                    helpers::MemoryBudget::instance ().charge (ev_cost);
+                    ret_flags
+                        = ring_flags.fetch_or (QUEUE,
+                            std::memory_order_release)
+                        | QUEUE;
+                    ev_consumer.signal ();
+                    return ret_flags;
+                }
+            }
+            else if (diff < 0)
+            {
+                // The ring is full.
+                if (overflow_policy == BLOCK
+                    || (overflow_policy == DROP_BELOW_LEVEL
+                        && ev.getLogLevel () >= drop_below_level))
+                {
+                    // Yield until the consumer frees a slot, mirroring
+                    // the blocking behaviour of Queue.
+                    std::this_thread::yield ();
+                    pos = enqueue_pos.load (std::memory_order_relaxed);
+                }
+                else
+                {
+                    // DROP_OLDEST cannot be honored here because the
+                    // consumer owns the head of the ring; the incoming
+                    // event is dropped instead.
+                    dropped.fetch_add (1, std::memory_order_relaxed);
+                    return f;
+                }
+            }
+            else
+                // Another producer has claimed this position, move on.
+                pos = enqueue_pos.load (std::memory_order_relaxed);
+        }
+    }
+    catch (std::runtime_error const & e)
+    {
+        log4cplus::helpers::getLogLog().error(
+            LOG4CPLUS_TEXT("put_event() exception: ")
+            + LOG4CPLUS_C_STR_TO_TSTRING(e.what()));
+        return ret_flags;
+    }
+}
+
+
+RingQueue::flags_type
+RingQueue::put_event (spi::InternalLoggingEvent const & ev)
+{
+    return put_event_worker (ev);
+}
+
+
+RingQueue::flags_type
+RingQueue::put_event (spi::InternalLoggingEvent && ev)
+{
+    return put_event_worker (std::move (ev));
+}
+
+
+RingQueue::flags_type
+RingQueue::signal_exit (bool drain)
+{
+    flags_type ret_flags;
+    if (drain)
+        ret_flags = ring_flags.fetch_or (EXIT | DRAIN,
+            std::memory_order_release) | EXIT | DRAIN;
+    else
+    {
+        ring_flags.fetch_and (static_cast<flags_type>(~DRAIN),
+            std::memory_order_release);
+        ret_flags = ring_flags.fetch_or (EXIT,
+            std::memory_order_release) | EXIT;
+        ret_flags &= ~flags_type (DRAIN);
+    }
+
+    ev_consumer.signal ();
+    return ret_flags;
+}
+
+
+RingQueue::flags_type
+RingQueue::get_events (queue_storage_type * buf)
+{
+    while (true)
+    {
+        flags_type const f = ring_flags.load (std::memory_order_acquire);
+
+        // Drain all published slots in one batch. Events are copied
+        // out instead of swapped out so that both the slot and the
+        // recycled elements of *buf retain their string storage
+        // across queue round trips.
+        std::size_t count = 0;
+        std::size_t dpos = dequeue_pos.load (std::memory_order_relaxed);
+        while (true)
+        {
+            Slot & slot = ring[dpos & mask];
+            std::size_t const seq
+                = slot.seq.load (std::memory_order_acquire);
+            if (seq != dpos + 1)
+                break;
+
+            if (count < buf->size ())
+                (*buf)[count].assign (slot.ev);
+            else
+            {
+                buf->emplace_back ();
+                buf->back ().assign (slot.ev);
+            }
+
+            // Mark the slot free for the next lap of producers.
+            slot.seq.store (dpos + mask + 1,
+                std::memory_order_release);
+            ++dpos;
+            dequeue_pos.store (dpos, std::memory_order_relaxed);
+            ++count;
+        }
+
+        if (count != 0)
+        {
+            buf->resize (count);
+            budget_release (*buf);
+            LOG4CPLUS_TRACEPOINT2 (queue_get, this, count);
+            return f | EVENT;
+        }
+
+        if (f & EXIT)
+        {
+            if ((f & DRAIN)
+                && dpos
+                != enqueue_pos.load (std::memory_order_acquire))
+            {
+                // A producer has claimed a slot but has not published
+                // it yet; wait for it so that no event is lost.
+                std::this_thread::yield ();
+                continue;
+            }
+
+            ring_flags.fetch_and (static_cast<flags_type>(~QUEUE),
+                std::memory_order_release);
+            return f & ~flags_type (QUEUE);
+        }
+
+        ring_flags.fetch_and (static_cast<flags_type>(~QUEUE),
+            std::memory_order_release);
+        ev_consumer.reset ();
+
+        // Re-check for events published between the drain above and
+        // the reset, then sleep until a producer signals.
+        if (ring[dpos & mask].seq.load (std::memory_order_acquire)
+            == dpos + 1
+            || (ring_flags.load (std::memory_order_acquire) & EXIT))
+            continue;
+
+        ev_consumer.wait ();
+    }
+}
+
+
+RingQueue::flags_type
+RingQueue::try_get_events (queue_storage_type * buf)
+{
+    flags_type const f = ring_flags.load (std::memory_order_acquire);
+
+    // Same batch drain as in get_events(), but return immediately
+    // instead of parking on ev_consumer when no slot is published.
+    std::size_t count = 0;
+    std::size_t dpos = dequeue_pos.load (std::memory_order_relaxed);
+    while (true)
+    {
+        Slot & slot = ring[dpos & mask];
+        std::size_t const seq
+            = slot.seq.load (std::memory_order_acquire);
+        if (seq != dpos + 1)
+            break;
+
+        if (count < buf->size ())
+            (*buf)[count].assign (slot.ev);
+        else
+        {
+            buf->emplace_back ();
+            buf->back ().assign (slot.ev);
+        }
+
+        // Mark the slot free for the next lap of producers.
+        slot.seq.store (dpos + mask + 1,
+            std::memory_order_release);
+        ++dpos;
+        dequeue_pos.store (dpos, std::memory_order_relaxed);
+        ++count;
+    }
+
+    if (count != 0)
+    {
+        buf->resize (count);
+        budget_release (*buf);
+        LOG4CPLUS_TRACEPOINT2 (queue_get, this, count);
+        return f | EVENT;
+    }
+
+    return f & ~flags_type (QUEUE);
+}
+
+
+DoubleBufferQueue::DoubleBufferQueue (unsigned len)
+    : Queue (len)
+    , capacity ((std::max) (len, 1u))
+    , state (0)
+    , db_flags (DRAIN)
+{
+    for (Buffer & buffer : buffers)
+    {
+        buffer.events.resize (capacity);
+        buffer.published.store (0, std::memory_order_relaxed);
+    }
+}
+
+
+DoubleBufferQueue::~DoubleBufferQueue () = default;
+
+
+std::size_t
+DoubleBufferQueue::get_occupancy () const
+{
+    // Only the claims in the active buffer are counted; a retired
+    // buffer being drained right now is already on its way out.
+    return (std::min) (state.load (std::memory_order_relaxed)
+        & ~buffer_select_bit, capacity);
+}
+
+
+bool
+DoubleBufferQueue::lock_storage ()
+{
+    bool locked = true;
+    for (Buffer & buffer : buffers)
+        locked = lock_region (buffer.events.data (),
+            buffer.events.size () * sizeof (spi::InternalLoggingEvent))
+            && locked;
+
+    return locked;
+}
+
+
+template <typename EventRef>
+DoubleBufferQueue::flags_type
+DoubleBufferQueue::put_event_worker (EventRef && ev)
+{
+    LOG4CPLUS_TRACEPOINT1 (queue_put, this);
+
+    flags_type ret_flags = ERROR_BIT;
+    try
+    {
+        ev.gatherThreadSpecificData ();
+
+        if (budget_shed (ev))
+            return db_flags.load (std::memory_order_acquire);
+
+        std::size_t const ev_cost = event_memory_cost (ev);
+
+        while (true)
+        {
+            flags_type const f = db_flags.load (std::memory_order_acquire);
+            if (f & EXIT)
+                return f;
+
+            // Claim a slot in the active buffer with a single
+            // fetch-and-add. The claim may overshoot the capacity;
+            // such claims are simply discarded by the consumer's
+            // exchange and retried in the other buffer.
+            std::size_t const s
+                = state.fetch_add (1, std::memory_order_acquire);
+            std::size_t const index = s & ~buffer_select_bit;
+            if (index >= capacity)
+            {
+                // The active buffer is full.
+                if (overflow_policy == BLOCK
+                    || (overflow_policy == DROP_BELOW_LEVEL
+                        && ev.getLogLevel () >= drop_below_level))
+                {
+                    // Yield until the consumer swaps buffers,
+                    // mirroring the blocking behaviour of Queue.
+                    std::this_thread::yield ();
+                    continue;
+                }
+
+                // DROP_OLDEST cannot be honored here because the
+                // consumer owns the retired buffer; the incoming event
+                // is dropped instead.
+                dropped.fetch_add (1, std::memory_order_relaxed);
+                return f;
+            }
+
+            Buffer & buffer = buffers[(s & buffer_select_bit) ? 1 : 0];
+            if constexpr (std::is_lvalue_reference_v<EventRef>)
+                // Member-wise assignment reuses the string storage
+                // kept alive in the slot from previous swaps, so the
+                // steady-state producer path does not allocate.
+                buffer.events[index].assign (ev);
+            else
+                // Swap based move assignment; the slot's recycled
+                // storage ends up in the expiring source event.
+                buffer.events[index] = std::move (ev);
+            // Publish the slot to the consumer.
+            buffer.published.fetch_add (1, std::memory_order_release);
+            helpers::MemoryBudget::instance ().charge (ev_cost);
+
+            ret_flags = db_flags.fetch_or (QUEUE, std::memory_order_release)
+                | QUEUE;
+            ev_consumer.signal ();
+            return ret_flags;
+        }
+    }
+    catch (std::runtime_error const & e)
+    {
+        log4cplus::helpers::getLogLog().error(
+            LOG4CPLUS_TEXT("put_event() exception: ")
+            + LOG4CPLUS_C_STR_TO_TSTRING(e.what()));
+        return ret_flags;
+    }
+}
+
+
+DoubleBufferQueue::flags_type
+DoubleBufferQueue::put_event (spi::InternalLoggingEvent const & ev)
+{
+    return put_event_worker (ev);
+}
+
+
+DoubleBufferQueue::flags_type
+DoubleBufferQueue::put_event (spi::InternalLoggingEvent && ev)
+{
+    return put_event_worker (std::move (ev));
+}
+
+
+DoubleBufferQueue::flags_type
+DoubleBufferQueue::signal_exit (bool drain)
+{
+    flags_type ret_flags;
+    if (drain)
+        ret_flags = db_flags.fetch_or (EXIT | DRAIN,
+            std::memory_order_release) | EXIT | DRAIN;
+    else
+    {
+        db_flags.fetch_and (static_cast<flags_type>(~DRAIN),
+            std::memory_order_release);
+        ret_flags = db_flags.fetch_or (EXIT,
+            std::memory_order_release) | EXIT;
+        ret_flags &= ~flags_type (DRAIN);
+    }
+
+    ev_consumer.signal ();
+    return ret_flags;
+}
+
+
+DoubleBufferQueue::flags_type
+DoubleBufferQueue::get_events (queue_storage_type * buf)
+{
+    while (true)
+    {
+        flags_type const f = db_flags.load (std::memory_order_acquire);
+
+        // Take the whole active buffer out of circulation by flipping
+        // the buffer selector; producers that claimed slots before the
+        // exchange finish writing into the retired buffer, later ones
+        // land in the other buffer.
+        std::size_t const old_state = state.load (std::memory_order_relaxed);
+        std::size_t const old_select = old_state & buffer_select_bit;
+        std::size_t const exchanged
+            = state.exchange (old_select ^ buffer_select_bit,
+                std::memory_order_acq_rel);
+        std::size_t const claimed
+            = (std::min) (exchanged & ~buffer_select_bit, capacity);
+
+        Buffer & buffer = buffers[old_select ? 1 : 0];
+
+        // Wait for producers that claimed a slot before the exchange
+        // but have not finished writing their event yet.
+        while (buffer.published.load (std::memory_order_acquire) != claimed)
+            std::this_thread::yield ();
+
+        if (claimed != 0)
+        {
+            // Copy events out instead of swapping storage so that both
+            // the retired buffer and the recycled elements of *buf
+            // keep their string storage across queue round trips.
+            for (std::size_t i = 0; i != claimed; ++i)
+            {
+                if (i < buf->size ())
+                    (*buf)[i].assign (buffer.events[i]);
+                else
+                {
+                    buf->emplace_back ();
+                    buf->back ().assign (buffer.events[i]);
+                }
+            }
+            buf->resize (claimed);
+            budget_release (*buf);
+            buffer.published.store (0, std::memory_order_release);
+            LOG4CPLUS_TRACEPOINT2 (queue_get, this, claimed);
+            return f | EVENT;
+        }
+
+        buffer.published.store (0, std::memory_order_release);
+
+        if (f & EXIT)
+        {
+            if ((f & DRAIN)
+                && (state.load (std::memory_order_acquire)
+                    & ~buffer_select_bit) != 0)
+            {
+                // A producer has claimed a slot in the now active
+                // buffer; loop around so that no event is lost.
+                std::this_thread::yield ();
+                continue;
+            }
+
+            db_flags.fetch_and (static_cast<flags_type>(~QUEUE),
+                std::memory_order_release);
+            return f & ~flags_type (QUEUE);
+        }
+
+        db_flags.fetch_and (static_cast<flags_type>(~QUEUE),
+            std::memory_order_release);
+        ev_consumer.reset ();
+
+        // Re-check for events claimed between the exchange above and
+        // the reset, then sleep until a producer signals.
+        if ((state.load (std::memory_order_acquire) & ~buffer_select_bit) != 0
+            || (db_flags.load (std::memory_order_acquire) & EXIT))
+            continue;
+
+        ev_consumer.wait ();
+    }
+}
+
+
+DoubleBufferQueue::flags_type
+DoubleBufferQueue::try_get_events (queue_storage_type * buf)
+{
+    flags_type const f = db_flags.load (std::memory_order_acquire);
+
+    // Same buffer flip as in get_events(), but return immediately
+    // instead of parking on ev_consumer when the retired buffer turns
+    // out to be empty.
+    std::size_t const old_state = state.load (std::memory_order_relaxed);
+    std::size_t const old_select = old_state & buffer_select_bit;
+    std::size_t const exchanged
+        = state.exchange (old_select ^ buffer_select_bit,
+            std::memory_order_acq_rel);
+    std::size_t const claimed
+        = (std::min) (exchanged & ~buffer_select_bit, capacity);
+
+    Buffer & buffer = buffers[old_select ? 1 : 0];
+
+    // Wait for producers that claimed a slot before the exchange
+    // but have not finished writing their event yet.
+    while (buffer.published.load (std::memory_order_acquire) != claimed)
+        std::this_thread::yield ();
+
+    if (claimed != 0)
+    {
+        for (std::size_t i = 0; i != claimed; ++i)
+        {
+            if (i < buf->size ())
+                (*buf)[i].assign (buffer.events[i]);
+            else
+            {
+                buf->emplace_back ();
+                buf->back ().assign (buffer.events[i]);
+            }
+        }
+        buf->resize (claimed);
+        budget_release (*buf);
+        buffer.published.store (0, std::memory_order_release);
+        LOG4CPLUS_TRACEPOINT2 (queue_get, this, claimed);
+        return f | EVENT;
+    }
+
+    buffer.published.store (0, std::memory_order_release);
+    return f & ~flags_type (QUEUE);
+}
+
+
 } // namespace log4cplus::thread
 
 
@@ -0,0 +1,543 @@
+// Module:  LOG4CPLUS
+// File:    sharedmemoryappender.cxx
+// Created: 8/2026
+// Author:  Vaclav Zeman
+//
+//
+//  Copyright (C) 2026, Vaclav Zeman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <log4cplus/sharedmemoryappender.h>
+
+#if defined (LOG4CPLUS_HAVE_SYS_MMAN_H) && ! defined (_WIN32)
+
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+namespace log4cplus {
+
+
+namespace {
+
+
+std::uint64_t const ring_magic = 0x4C34534D52494E47ull; // "L4SMRING"
+std::uint32_t const ring_version = 1;
+
+
+// Every frame starts with one 64 bit word followed by the payload,
+// padded to an 8 byte boundary:
+//
+//   bits 63..62  tag: free, pending, committed or skip
+//   bits 61..32  stamp: the frame's monotonic ring position, used to
+//                tell a fresh word from leftovers of a previous lap
+//   bits 31..0   payload size in bytes
+//
+// A producer reserves its frame with one compare-and-swap on the head
+// counter, stores the word with the pending tag, copies the payload
+// and republishes the word with the committed tag. The drainer never
+// interprets bytes whose stamp does not match the position it expects,
+// so no cleanup of consumed regions is necessary.
+
+unsigned const frame_tag_free = 0;
+unsigned const frame_tag_pending = 1;
+unsigned const frame_tag_committed = 2;
+unsigned const frame_tag_skip = 3;
+
+
+inline
+std::uint64_t
+frame_total (std::uint64_t size)
+{
+    return 8 + ((size + 7) & ~std::uint64_t (7));
+}
+
+
+inline
+std::uint64_t
+frame_stamp (std::uint64_t pos)
+{
+    return (pos >> 3) & 0x3FFFFFFFull;
+}
+
+
+inline
+std::uint64_t
+make_frame_word (unsigned tag, std::uint64_t pos, std::uint64_t size)
+{
+    return (std::uint64_t (tag) << 62) | (frame_stamp (pos) << 32) | size;
+}
+
+
+struct RingHeader
+{
+    std::atomic<std::uint64_t> magic;
+    std::uint32_t version;
+    std::uint32_t unused;
+    std::uint64_t capacity;
+    char pad0[40];
+    // Head and tail live on separate cache lines so that producers
+    // and the drainer do not false share.
+    std::atomic<std::uint64_t> head;
+    char pad1[56];
+    std::atomic<std::uint64_t> tail;
+    char pad2[56];
+    std::atomic<std::uint64_t> dropped;
+    char pad3[56];
+};
+
+
+} // namespace
+
+
+//! Producer and consumer side of the shared memory ring. The object
+//! itself is process local; all shared state lives in the mapping.
+struct SharedMemoryAppender::Ring
+{
+    int fd = -1;
+    RingHeader * hdr = nullptr;
+    char * data = nullptr;
+    std::uint64_t capacity = 0;
+    std::size_t map_size = 0;
+
+    ~Ring ()
+    {
+        close_ring ();
+    }
+
+    bool
+    open_ring (tstring const & name, std::size_t requested_capacity)
+    {
+        std::string const sname (LOG4CPLUS_TSTRING_TO_STRING (name));
+
+        std::uint64_t cap = 4096;
+        while (cap < requested_capacity)
+            cap <<= 1;
+
+        fd = ::shm_open (sname.c_str (), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd != -1)
+        {
+            // We created the object; size it and initialize the
+            // header. The magic is published last so that attaching
+            // processes never see a half initialized ring.
+            map_size = sizeof (RingHeader) + cap;
+            if (::ftruncate (fd, static_cast<off_t>(map_size)) == -1
+                || ! map ())
+            {
+                close_ring ();
+                ::shm_unlink (sname.c_str ());
+                return false;
+            }
+
+            hdr->version = ring_version;
+            hdr->capacity = cap;
+            hdr->head.store (0, std::memory_order_relaxed);
+            hdr->tail.store (0, std::memory_order_relaxed);
+            hdr->dropped.store (0, std::memory_order_relaxed);
+            hdr->magic.store (ring_magic, std::memory_order_release);
+        }
+        else if (errno == EEXIST)
+        {
+            fd = ::shm_open (sname.c_str (), O_RDWR, 0644);
+            if (fd == -1)
+                return false;
+
+            // The creator may still be between shm_open() and the
+            // magic store; give it a moment.
+            struct stat st;
+            for (int i = 0; ; ++i)
+            {
+                if (::fstat (fd, &st) == -1)
+                {
+                    close_ring ();
+                    return false;
+                }
+
+                if (st.st_size
+                    > static_cast<off_t>(sizeof (RingHeader)))
+                    break;
+
+                if (i == 1000)
+                {
+                    close_ring ();
+                    return false;
+                }
+
+                ::usleep (1000);
+            }
+
+            map_size = static_cast<std::size_t>(st.st_size);
+            if (! map ())
+            {
+                close_ring ();
+                return false;
+            }
+
+            for (int i = 0;
+                 hdr->magic.load (std::memory_order_acquire) != ring_magic;
+                 ++i)
+            {
+                if (i == 1000)
+                {
+                    close_ring ();
+                    return false;
+                }
+
+                ::usleep (1000);
+            }
+
+            if (hdr->version != ring_version
+                || map_size != sizeof (RingHeader) + hdr->capacity)
+            {
+                close_ring ();
+                return false;
+            }
+        }
+        else
+            return false;
+
+        capacity = hdr->capacity;
+        return true;
+    }
+
+    bool
+    map ()
+    {
+        void * const p = ::mmap (nullptr, map_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED)
+            return false;
+
+        hdr = static_cast<RingHeader *>(p);
+        data = static_cast<char *>(p) + sizeof (RingHeader);
+        return true;
+    }
+
+    std::atomic<std::uint64_t> &
+    word_at (std::uint64_t off)
+    {
+        return *reinterpret_cast<std::atomic<std::uint64_t> *>(data + off);
+    }
+
+    //! Lock-free multi producer append of one framed event. Returns
+    //! false when the event was dropped because the ring is full or
+    //! the payload is unreasonably large.
+    bool
+    write (char const * buf, std::size_t size)
+    {
+        std::uint64_t const total = frame_total (size);
+        if (size > 0xFFFFFFFFull || total > capacity / 2)
+        {
+            hdr->dropped.fetch_add (1, std::memory_order_relaxed);
+            return false;
+        }
+
+        std::uint64_t h = hdr->head.load (std::memory_order_relaxed);
+        for (;;)
+        {
+            std::uint64_t const t = hdr->tail.load (std::memory_order_acquire);
+            std::uint64_t const off = h & (capacity - 1);
+            std::uint64_t const rem = capacity - off;
+            // Frames do not wrap; when the tail of the ring is too
+            // short the reservation also covers it with a skip frame
+            // and the payload starts at offset 0.
+            std::uint64_t const need = rem < total ? rem + total : total;
+
+            if (h + need - t > capacity)
+            {
+                hdr->dropped.fetch_add (1, std::memory_order_relaxed);
+                return false;
+            }
+
+            if (! hdr->head.compare_exchange_weak (h, h + need,
+                    std::memory_order_relaxed))
+                continue;
+
+            std::uint64_t pos = h;
+            std::uint64_t o = off;
+            if (rem < total)
+            {
+                word_at (o).store (
+                    make_frame_word (frame_tag_skip, pos, rem - 8),
+                    std::memory_order_release);
+                pos += rem;
+                o = 0;
+            }
+
+            // Publish the reservation before copying so that the
+            // drainer can skip the frame, knowing its length, if this
+            // process dies mid copy.
+            word_at (o).store (
+                make_frame_word (frame_tag_pending, pos, size),
+                std::memory_order_release);
+            std::memcpy (data + o + 8, buf, size);
+            word_at (o).store (
+                make_frame_word (frame_tag_committed, pos, size),
+                std::memory_order_release);
+            return true;
+        }
+    }
+
+    //! Single consumer drain of all published frames.
+    std::size_t
+    drain (std::ostream & out, unsigned stall_limit,
+        std::uint64_t & stall_pos, unsigned & stall_count)
+    {
+        std::size_t written = 0;
+        std::uint64_t t = hdr->tail.load (std::memory_order_relaxed);
+        for (;;)
+        {
+            std::uint64_t const h = hdr->head.load (std::memory_order_acquire);
+            if (t == h)
+                break;
+
+            std::uint64_t const off = t & (capacity - 1);
+            std::uint64_t const word
+                = word_at (off).load (std::memory_order_acquire);
+            auto const tag = unsigned (word >> 62);
+            std::uint64_t const size = word & 0xFFFFFFFFull;
+            bool const valid = tag != frame_tag_free
+                && ((word >> 32) & 0x3FFFFFFFull) == frame_stamp (t);
+
+            if (valid && tag == frame_tag_committed)
+            {
+                out.write (data + off + 8,
+                    static_cast<std::streamsize>(size));
+                written += size;
+                t += frame_total (size);
+            }
+            else if (valid && tag == frame_tag_skip)
+                t += frame_total (size);
+            else
+            {
+                // An unpublished reservation heads the queue. Give
+                // its producer stall_limit calls to finish before
+                // declaring it dead.
+                if (stall_pos != t)
+                {
+                    stall_pos = t;
+                    stall_count = 0;
+                }
+
+                if (++stall_count <= stall_limit)
+                    break;
+
+                hdr->dropped.fetch_add (1, std::memory_order_relaxed);
+                if (valid)
+                    // A pending frame of known length; skip just it.
+                    t += frame_total (size);
+                else
+                    // The producer died before publishing even the
+                    // reservation length; the only safe recovery is
+                    // to discard up to the head.
+                    t = h;
+
+                stall_pos = t;
+                stall_count = 0;
+            }
+
+            hdr->tail.store (t, std::memory_order_release);
+        }
+
+        return written;
+    }
+
+    std::size_t
+    dropped_count () const
+    {
+        return static_cast<std::size_t>(
+            hdr->dropped.load (std::memory_order_relaxed));
+    }
+
+    void
+    close_ring ()
+    {
+        if (hdr)
+        {
+            ::munmap (hdr, map_size);
+            hdr = nullptr;
+            data = nullptr;
+        }
+
+        if (fd != -1)
+        {
+            ::close (fd);
+            fd = -1;
+        }
+    }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SharedMemoryAppender ctors and dtor
+///////////////////////////////////////////////////////////////////////////////
+
+SharedMemoryAppender::SharedMemoryAppender(const tstring& memoryName_,
+    std::size_t memorySize_)
+    : memoryName(memoryName_)
+    , memorySize(memorySize_)
+{
+    init();
+}
+
+
+SharedMemoryAppender::SharedMemoryAppender(
+    const helpers::Properties & properties)
+    : Appender(properties)
+    , memorySize(4 * 1024 * 1024)
+{
+    memoryName = properties.getProperty(LOG4CPLUS_TEXT("MemoryName"));
+
+    unsigned long size = 0;
+    if (properties.getULong (size, LOG4CPLUS_TEXT ("MemorySize")))
+        memorySize = size;
+
+    init();
+}
+
+
+SharedMemoryAppender::~SharedMemoryAppender()
+{
+    destructorImpl();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SharedMemoryAppender public methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+SharedMemoryAppender::close()
+{
+    thread::MutexGuard guard (access_mutex);
+    // The shared memory object itself persists for the drainer and
+    // other producers; only this process' mapping goes away.
+    ring.reset ();
+    closed = true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SharedMemoryAppender protected methods
+///////////////////////////////////////////////////////////////////////////////
+
+void
+SharedMemoryAppender::init()
+{
+    if (memoryName.empty ())
+    {
+        getErrorHandler()->error(
+            LOG4CPLUS_TEXT("SharedMemoryAppender requires MemoryName"));
+        return;
+    }
+
+    auto r = std::make_unique<Ring> ();
+    if (r->open_ring (memoryName, memorySize))
+        ring = std::move (r);
+    else
+        getErrorHandler()->error(
+            LOG4CPLUS_TEXT("Unable to open shared memory ring: ")
+            + memoryName);
+}
+
+
+void
+SharedMemoryAppender::append(const spi::InternalLoggingEvent& event)
+{
+    if (! ring)
+        return;
+
+    tstring const & str = formatEvent (event);
+#if defined (UNICODE)
+    std::string const chars (LOG4CPLUS_TSTRING_TO_STRING (str));
+    char const * const data = chars.c_str ();
+    std::size_t const size = chars.size ();
+#else
+    char const * const data = str.c_str ();
+    std::size_t const size = str.size ();
+#endif
+    if (! ring->write (data, size))
+        getErrorHandler()->error(
+            LOG4CPLUS_TEXT("Shared memory ring is full, dropping events: ")
+            + memoryName);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SharedMemoryAppender::Drainer
+///////////////////////////////////////////////////////////////////////////////
+
+struct SharedMemoryAppender::Drainer::Data
+{
+    Ring ring;
+    std::uint64_t stall_pos = ~std::uint64_t (0);
+    unsigned stall_count = 0;
+};
+
+
+SharedMemoryAppender::Drainer::Drainer (const tstring& memoryName)
+    : data (new Data)
+{
+    if (! data->ring.open_ring (memoryName, 4 * 1024 * 1024))
+        throw std::runtime_error (
+            "could not open shared memory ring: "
+            + LOG4CPLUS_TSTRING_TO_STRING (memoryName));
+}
+
+
+SharedMemoryAppender::Drainer::~Drainer () = default;
+
+
+std::size_t
+SharedMemoryAppender::Drainer::drainOnce (std::ostream & out,
+    unsigned stallLimit)
+{
+    return data->ring.drain (out, stallLimit, data->stall_pos,
+        data->stall_count);
+}
+
+
+std::size_t
+SharedMemoryAppender::Drainer::getDroppedCount () const
+{
+    return data->ring.dropped_count ();
+}
+
+
+} // namespace log4cplus
+
+#endif // LOG4CPLUS_HAVE_SYS_MMAN_H && ! _WIN32
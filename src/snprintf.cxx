@@ -25,6 +25,7 @@
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/internal/internal.h>
 #include <cstdarg>
+#include <cstdint>
 #include <cstdio>
 #if defined (UNICODE)
 #include <cwchar>
@@ -191,14 +192,50 @@ snprintf_buf::print (tchar const * fmt, ...)
 }
 
 
+tstring_view
+snprintf_buf::print_view (tchar const * fmt, ...)
+{
+    assert (fmt);
+
+    tchar const * str = nullptr;
+    int ret = 0;
+    std::va_list args;
+
+    do
+    {
+        va_start (args, fmt);
+        ret = print_va_list (str, fmt, args);
+        va_end (args);
+    }
+    while (ret == -1);
+
+    return str
+        ? tstring_view (str, static_cast<std::size_t>(ret))
+        : tstring_view ();
+}
+
+
 int
 snprintf_buf::print_va_list (tchar const * & str, tchar const * fmt,
     std::va_list args)
 {
     int printed;
-    std::size_t const fmt_len = std::char_traits<tchar>::length (fmt);
     std::size_t buf_size = buf.size ();
-    std::size_t const output_estimate = fmt_len + fmt_len / 2 + 1;
+
+    // Use the output size recorded for this format string the last
+    // time around, and fall back to an estimate derived from the
+    // format length for formats we have not seen yet.
+    format_size_cache_entry & cached = format_size_cache[
+        (reinterpret_cast<std::uintptr_t>(fmt) / sizeof (void *))
+        % format_size_cache_len];
+    std::size_t output_estimate;
+    if (cached.fmt == fmt)
+        output_estimate = cached.size;
+    else
+    {
+        std::size_t const fmt_len = std::char_traits<tchar>::length (fmt);
+        output_estimate = fmt_len + fmt_len / 2 + 1;
+    }
     if (output_estimate > buf_size)
         buf.resize (buf_size = output_estimate);
 
@@ -229,6 +266,8 @@ snprintf_buf::print_va_list (tchar const * & str, tchar const * fmt,
     assert (printed == sprinted);
 
     buf[sprinted] = 0;
+    cached = format_size_cache_entry { fmt,
+        static_cast<std::size_t>(sprinted) + 1 };
 
 #else
     printed = vsntprintf (&buf[0], buf_size - 1, fmt, args);
@@ -255,7 +294,11 @@ snprintf_buf::print_va_list (tchar const * & str, tchar const * fmt,
         printed = -1;
     }
     else
+    {
         buf[printed] = 0;
+        cached = format_size_cache_entry { fmt,
+            static_cast<std::size_t>(printed) + 2 };
+    }
 
 #endif
 
@@ -280,6 +323,30 @@ CATCH_TEST_CASE ("snprintf_buf", "[snprintf_buf]")
                 len)
             == 0);
     }
+
+    CATCH_SECTION ("print_view returns sized view")
+    {
+        tstring_view const result
+            = buf.print_view (LOG4CPLUS_TEXT ("%s=%d"),
+                LOG4CPLUS_TEXT ("value"), 7);
+        CATCH_REQUIRE (result == LOG4CPLUS_TEXT ("value=7"));
+    }
+
+    CATCH_SECTION ("repeated format uses cached size")
+    {
+        // Repeated prints of the same format with growing output
+        // exercise the per format size cache including an undershot
+        // cached estimate.
+        tchar const * const fmt = LOG4CPLUS_TEXT ("%s");
+        tstring const short_str (10, LOG4CPLUS_TEXT ('s'));
+        tstring const long_str (1000, LOG4CPLUS_TEXT ('l'));
+        CATCH_REQUIRE (buf.print_view (fmt, short_str.c_str ())
+            == short_str);
+        CATCH_REQUIRE (buf.print_view (fmt, long_str.c_str ())
+            == long_str);
+        CATCH_REQUIRE (buf.print_view (fmt, short_str.c_str ())
+            == short_str);
+    }
 }
 
 #endif
@@ -26,6 +26,12 @@
 #include <vector>
 #include <algorithm>
 #include <cerrno>
+#include <chrono>
+#include <climits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <log4cplus/internal/socket.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
@@ -131,7 +137,7 @@ int const TYPE_SOCK_CLOEXEC =
 
 SOCKET_TYPE
 openSocket(tstring const & host, unsigned short port, bool udp, bool ipv6,
-    SocketState& state)
+    SocketState& state, bool reusePort /*= false*/)
 {
     struct addrinfo addr_info_hints = addrinfo();
     struct addrinfo * ai = nullptr;
@@ -178,6 +184,28 @@ openSocket(tstring const & host, unsigned short port, bool udp, bool ipv6,
             + helpers::convertIntegerToString (eno));
     }
 
+    if (reusePort)
+    {
+#if defined (SO_REUSEPORT)
+        // Must be set before bind() on every socket sharing the
+        // port; the kernel then distributes incoming connections
+        // between the listeners.
+        ret = setsockopt (sock_holder.sock, SOL_SOCKET, SO_REUSEPORT,
+            &optval, optlen);
+        if (ret != 0)
+        {
+            int const eno = errno;
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("setsockopt(SO_REUSEPORT) failed: ")
+                + helpers::convertIntegerToString (eno));
+        }
+#else
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("SO_REUSEPORT is not supported")
+            LOG4CPLUS_TEXT (" on this platform."));
+#endif
+    }
+
     retval = bind (sock_holder.sock, ai->ai_addr, ai->ai_addrlen);
     if (retval < 0)
         return INVALID_SOCKET_VALUE;
@@ -190,40 +218,389 @@ openSocket(tstring const & host, unsigned short port, bool udp, bool ipv6,
 }
 
 
+namespace
+{
+
+//! Connects \c sock non-blocking and waits for the result with
+//! poll() for at most \c timeout_msec milliseconds. Returns 0 on
+//! success, -1 otherwise, and restores the socket's blocking mode.
+static
+int
+connect_with_timeout (int sock, struct sockaddr * addr, socklen_t addrlen,
+    unsigned timeout_msec)
+{
+    int const flags = fcntl (sock, F_GETFL, 0);
+    if (flags == -1 || fcntl (sock, F_SETFL, flags | O_NONBLOCK) == -1)
+        return -1;
+
+    int retval;
+    while ((retval = ::connect (sock, addr, addrlen)) == -1
+        && errno == EINTR)
+        ;
+    if (retval == -1 && errno == EINPROGRESS)
+    {
+        struct pollfd pfd;
+        pfd.fd = sock;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        while ((retval = poll (&pfd, 1, static_cast<int>(timeout_msec)))
+                == -1
+            && errno == EINTR)
+            ;
+        if (retval == 1)
+        {
+            int so_error = 0;
+            socklen_t len = sizeof (so_error);
+            if (getsockopt (sock, SOL_SOCKET, SO_ERROR, &so_error, &len)
+                    == 0
+                && so_error == 0)
+                retval = 0;
+            else
+                retval = -1;
+        }
+        else
+            // Timed out (0) or poll() failed (-1).
+            retval = -1;
+    }
+
+    fcntl (sock, F_SETFL, flags);
+    return retval;
+}
+
+
+//! One resolved socket address together with the parameters needed
+//! to create a matching socket.
+struct resolved_address
+{
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    int family;
+    int socktype;
+    int protocol;
+};
+
+
+//! Cached resolution of one host:port. The resolution parameters are
+//! kept so that refreshStaleAddresses() can re-run getaddrinfo()
+//! without the original caller.
+struct address_cache_entry
+{
+    std::string host;
+    std::string port;
+    int family;
+    int socktype;
+    int protocol;
+    std::vector<resolved_address> addresses;
+    std::chrono::steady_clock::time_point resolved_at;
+};
+
+
+std::mutex address_cache_mtx;
+std::map<std::string, address_cache_entry> address_cache;
+
+//! How long a resolution stays fresh. Stale entries are still used
+//! as a last resort when re-resolution fails.
+std::chrono::seconds const address_cache_ttl {60};
+
+
+static
+std::string
+address_cache_key (std::string const & host, std::string const & port,
+    int family, int socktype)
+{
+    std::string key = host;
+    key += '|';
+    key += port;
+    key += '|';
+    key += convertIntegerToNarrowString (family);
+    key += '|';
+    key += convertIntegerToNarrowString (socktype);
+    return key;
+}
+
+
+static
+int
+resolve_addresses (std::string const & host, std::string const & port,
+    int family, int socktype, int protocol,
+    std::vector<resolved_address> & out)
+{
+    struct addrinfo addr_info_hints = addrinfo ();
+    addr_info_hints.ai_family = family;
+    addr_info_hints.ai_socktype = socktype;
+    addr_info_hints.ai_protocol = protocol;
+    addr_info_hints.ai_flags = AI_NUMERICSERV;
+
+    struct addrinfo * ai = nullptr;
+    int const ret = getaddrinfo (host.c_str (), port.c_str (),
+        &addr_info_hints, &ai);
+    if (ret != 0)
+        return ret;
+
+    std::unique_ptr<struct addrinfo, addrinfo_deleter> addr_info (ai);
+
+    out.clear ();
+    for (struct addrinfo * rp = ai; rp; rp = rp->ai_next)
+    {
+        resolved_address ra;
+        std::memcpy (&ra.addr, rp->ai_addr, rp->ai_addrlen);
+        ra.addrlen = rp->ai_addrlen;
+        ra.family = rp->ai_family;
+        ra.socktype = rp->ai_socktype;
+        ra.protocol = rp->ai_protocol;
+        out.push_back (ra);
+    }
+
+    return 0;
+}
+
+
+//! Returns the addresses of host:port, preferring a fresh cache
+//! entry, then a synchronous resolution, then a stale cache entry -
+//! so a DNS outage at the moment of a failover does not lose an
+//! endpoint that resolved fine a minute ago.
+static
+int
+get_cached_addresses (std::string const & host, std::string const & port,
+    int family, int socktype, int protocol,
+    std::vector<resolved_address> & out)
+{
+    std::string const key = address_cache_key (host, port, family,
+        socktype);
+    std::vector<resolved_address> stale;
+
+    {
+        std::lock_guard<std::mutex> guard (address_cache_mtx);
+        auto const it = address_cache.find (key);
+        if (it != address_cache.end ())
+        {
+            if (std::chrono::steady_clock::now () - it->second.resolved_at
+                < address_cache_ttl)
+            {
+                out = it->second.addresses;
+                return 0;
+            }
+            stale = it->second.addresses;
+        }
+    }
+
+    int const ret = resolve_addresses (host, port, family, socktype,
+        protocol, out);
+    if (ret == 0)
+    {
+        std::lock_guard<std::mutex> guard (address_cache_mtx);
+        address_cache[key] = address_cache_entry {host, port, family,
+            socktype, protocol, out, std::chrono::steady_clock::now ()};
+        return 0;
+    }
+
+    if (! stale.empty ())
+    {
+        out = std::move (stale);
+        return 0;
+    }
+
+    return ret;
+}
+
+
+//! Races non-blocking connects to all candidate addresses at once,
+//! happy-eyeballs style, and returns the first socket that completes
+//! within \c timeout_msec; the losers are closed. Returns -1 when
+//! none succeeds.
+static
+int
+race_connect (std::vector<resolved_address> const & addrs,
+    unsigned timeout_msec)
+{
+    std::vector<struct pollfd> pfds;
+    pfds.reserve (addrs.size ());
+
+    for (resolved_address const & ra : addrs)
+    {
+        int const fd = ::socket (ra.family,
+            ra.socktype | TYPE_SOCK_CLOEXEC, ra.protocol);
+        if (fd < 0)
+            continue;
+
+#if ! defined (SOCK_CLOEXEC)
+        trySetCloseOnExec (fd);
+#endif
+
+        int const flags = fcntl (fd, F_GETFL, 0);
+        if (flags == -1 || fcntl (fd, F_SETFL, flags | O_NONBLOCK) == -1)
+        {
+            ::close (fd);
+            continue;
+        }
+
+        int retval;
+        while ((retval = ::connect (fd,
+                    reinterpret_cast<struct sockaddr const *>(&ra.addr),
+                    ra.addrlen)) == -1
+            && errno == EINTR)
+            ;
+        if (retval == 0)
+        {
+            // Connected immediately (e.g. loopback); no race needed.
+            for (struct pollfd const & pfd : pfds)
+                ::close (pfd.fd);
+            fcntl (fd, F_SETFL, flags);
+            return fd;
+        }
+        else if (errno == EINPROGRESS)
+        {
+            struct pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            pfds.push_back (pfd);
+        }
+        else
+            ::close (fd);
+    }
+
+    auto const deadline = std::chrono::steady_clock::now ()
+        + std::chrono::milliseconds (timeout_msec);
+
+    while (! pfds.empty ())
+    {
+        auto const remaining
+            = std::chrono::duration_cast<std::chrono::milliseconds> (
+                deadline - std::chrono::steady_clock::now ()).count ();
+        if (remaining <= 0)
+            break;
+
+        int retval;
+        while ((retval = poll (pfds.data (),
+                    static_cast<nfds_t>(pfds.size ()),
+                    static_cast<int>(remaining))) == -1
+            && errno == EINTR)
+            ;
+        if (retval <= 0)
+            break;
+
+        for (std::size_t i = 0; i != pfds.size (); )
+        {
+            if (pfds[i].revents == 0)
+            {
+                ++i;
+                continue;
+            }
+
+            int so_error = 0;
+            socklen_t len = sizeof (so_error);
+            if (getsockopt (pfds[i].fd, SOL_SOCKET, SO_ERROR, &so_error,
+                    &len) == 0
+                && so_error == 0)
+            {
+                // The first address to complete wins.
+                int const winner = pfds[i].fd;
+                for (std::size_t j = 0; j != pfds.size (); ++j)
+                {
+                    if (j != i)
+                        ::close (pfds[j].fd);
+                }
+
+                int const flags = fcntl (winner, F_GETFL, 0);
+                if (flags != -1)
+                    fcntl (winner, F_SETFL, flags & ~O_NONBLOCK);
+                return winner;
+            }
+
+            ::close (pfds[i].fd);
+            pfds[i] = pfds.back ();
+            pfds.pop_back ();
+        }
+    }
+
+    for (struct pollfd const & pfd : pfds)
+        ::close (pfd.fd);
+
+    return -1;
+}
+
+} // namespace
+
+
+void
+refreshStaleAddresses ()
+{
+    // Snapshot the stale entries under the lock and resolve outside
+    // of it; getaddrinfo() can block for a while and connectSocket()
+    // must not wait behind it.
+    std::vector<address_cache_entry> stale;
+    {
+        std::lock_guard<std::mutex> guard (address_cache_mtx);
+        auto const now = std::chrono::steady_clock::now ();
+        for (auto const & kv : address_cache)
+        {
+            if (now - kv.second.resolved_at >= address_cache_ttl)
+                stale.push_back (kv.second);
+        }
+    }
+
+    for (address_cache_entry & entry : stale)
+    {
+        std::vector<resolved_address> addresses;
+        if (resolve_addresses (entry.host, entry.port, entry.family,
+                entry.socktype, entry.protocol, addresses) != 0)
+            // Keep the stale addresses; they are better than nothing
+            // when the endpoint itself is still up.
+            continue;
+
+        std::string const key = address_cache_key (entry.host, entry.port,
+            entry.family, entry.socktype);
+        std::lock_guard<std::mutex> guard (address_cache_mtx);
+        auto const it = address_cache.find (key);
+        if (it != address_cache.end ())
+        {
+            it->second.addresses = std::move (addresses);
+            it->second.resolved_at = std::chrono::steady_clock::now ();
+        }
+    }
+}
+
+
 SOCKET_TYPE
 connectSocket(const tstring& hostn, unsigned short port, bool udp, bool ipv6,
-    SocketState& state)
+    SocketState& state, unsigned connect_timeout_msec)
 {
     int retval;
-    struct addrinfo addr_info_hints = addrinfo();
-    struct addrinfo * ai = nullptr;
-    std::unique_ptr<struct addrinfo, addrinfo_deleter> addr_info;
     int const family = ipv6 ? AF_INET6 : AF_INET;
     int const socket_type = udp ? SOCK_DGRAM : SOCK_STREAM;
     int const protocol = udp ? IPPROTO_UDP : IPPROTO_TCP;
     std::string const port_str = convertIntegerToNarrowString(port);
 
-    addr_info_hints.ai_family = family;
-    addr_info_hints.ai_socktype = socket_type;
-    addr_info_hints.ai_protocol = protocol;
-    addr_info_hints.ai_flags = AI_NUMERICSERV;
-    retval = getaddrinfo (LOG4CPLUS_TSTRING_TO_STRING(hostn).c_str(),
-        port_str.c_str(), &addr_info_hints, &ai);
-    if (retval != 0)
+    std::vector<resolved_address> addrs;
+    retval = get_cached_addresses (LOG4CPLUS_TSTRING_TO_STRING (hostn),
+        port_str, family, socket_type, protocol, addrs);
+    if (retval != 0 || addrs.empty ())
     {
         set_last_socket_error (retval);
         return INVALID_SOCKET_VALUE;
     }
 
-    addr_info.reset(ai);
+    if (connect_timeout_msec != 0 && addrs.size () > 1 && ! udp)
+    {
+        // With a bounded timeout and several candidate addresses,
+        // race them instead of burning up to one timeout per address
+        // sequentially.
+        int const fd = race_connect (addrs, connect_timeout_msec);
+        if (fd < 0)
+            return INVALID_SOCKET_VALUE;
+
+        state = ok;
+        return to_log4cplus_socket (fd);
+    }
 
-    struct addrinfo * rp;
     socket_holder sock_holder;
-    for (rp = ai; rp; rp = rp->ai_next)
+    bool connected = false;
+    for (resolved_address const & ra : addrs)
     {
         sock_holder.reset (
-            ::socket(rp->ai_family, rp->ai_socktype | TYPE_SOCK_CLOEXEC,
-                rp->ai_protocol));
+            ::socket(ra.family, ra.socktype | TYPE_SOCK_CLOEXEC,
+                ra.protocol));
         if (sock_holder.sock < 0)
             continue;
 
@@ -231,15 +608,25 @@ connectSocket(const tstring& hostn, unsigned short port, bool udp, bool ipv6,
         trySetCloseOnExec (sock_holder.sock);
 #endif
 
-        while ((retval = ::connect (sock_holder.sock, rp->ai_addr,
-                    rp->ai_addrlen)) == -1
-            && (errno == EINTR))
-            ;
+        struct sockaddr * const sa
+            = reinterpret_cast<struct sockaddr *>(
+                const_cast<struct sockaddr_storage *>(&ra.addr));
+        if (connect_timeout_msec != 0)
+            retval = connect_with_timeout (sock_holder.sock, sa,
+                ra.addrlen, connect_timeout_msec);
+        else
+            while ((retval = ::connect (sock_holder.sock, sa, ra.addrlen))
+                    == -1
+                && (errno == EINTR))
+                ;
         if (retval == 0)
+        {
+            connected = true;
             break;
+        }
     }
 
-    if (rp == nullptr)
+    if (! connected)
         // No address succeeded.
         return INVALID_SOCKET_VALUE;
 
@@ -404,28 +791,49 @@ write(SOCKET_TYPE sock, std::size_t bufferCount,
     int flags = 0;
 #endif
 
-    std::vector<iovec> iovecs (bufferCount);
-    for (std::size_t i = 0; i != bufferCount; ++i)
+    // sendmsg() rejects more than IOV_MAX buffers per call, so larger
+    // batches are sent in several calls.
+#if defined (IOV_MAX)
+    std::size_t const max_buffers = IOV_MAX;
+#else
+    std::size_t const max_buffers = 16;
+#endif
+
+    std::vector<iovec> iovecs ((std::min) (bufferCount, max_buffers));
+    long written = 0;
+
+    for (std::size_t i = 0; i != bufferCount; )
     {
-        iovec & iov = iovecs[i];
-        std::memset (&iov, 0, sizeof (iov));
-        SocketBuffer const & buffer = *buffers[i];
+        std::size_t const chunk = (std::min) (bufferCount - i, max_buffers);
+        for (std::size_t j = 0; j != chunk; ++j)
+        {
+            iovec & iov = iovecs[j];
+            std::memset (&iov, 0, sizeof (iov));
+            SocketBuffer const & buffer = *buffers[i + j];
+
+            iov.iov_base = buffer.getBuffer();
+            iov.iov_len = buffer.getSize();
+        }
 
-        iov.iov_base = buffer.getBuffer();
-        iov.iov_len = buffer.getSize();
+        msghdr message;
+        std::memset (&message, 0, sizeof (message));
+        message.msg_name = nullptr;
+        message.msg_namelen = 0;
+        message.msg_control = nullptr;
+        message.msg_controllen = 0;
+        message.msg_flags = 0;
+        message.msg_iov = &iovecs[0];
+        message.msg_iovlen = chunk;
+
+        long const res = sendmsg (to_os_socket (sock), &message, flags);
+        if (res <= 0)
+            return res;
+
+        written += res;
+        i += chunk;
     }
 
-    msghdr message;
-    std::memset (&message, 0, sizeof (message));
-    message.msg_name = nullptr;
-    message.msg_namelen = 0;
-    message.msg_control = nullptr;
-    message.msg_controllen = 0;
-    message.msg_flags = 0;
-    message.msg_iov = &iovecs[0];
-    message.msg_iovlen = iovecs.size ();
-
-    return sendmsg (to_os_socket (sock), &message, flags);
+    return written;
 }
 
 
@@ -506,12 +914,116 @@ setTCPNoDelay (SOCKET_TYPE sock, bool val)
 }
 
 
+int
+setTCPKeepAlive (SOCKET_TYPE sock, bool enable, int idleSeconds,
+    int intervalSeconds, int probeCount)
+{
+    int result;
+    int enabled = static_cast<int>(enable);
+    if ((result = setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &enabled,
+                sizeof(enabled))) != 0)
+    {
+        set_last_socket_error (errno);
+        return result;
+    }
+
+    if (! enable)
+        return 0;
+
+#if defined (SOL_TCP) || defined (IPPROTO_TCP)
+#if defined (SOL_TCP)
+    int level = SOL_TCP;
+
+#elif defined (IPPROTO_TCP)
+    int level = IPPROTO_TCP;
+
+#endif
+
+#if defined (TCP_KEEPIDLE)
+    if (idleSeconds > 0
+        && (result = setsockopt(sock, level, TCP_KEEPIDLE, &idleSeconds,
+                sizeof(idleSeconds))) != 0)
+    {
+        set_last_socket_error (errno);
+        return result;
+    }
+#else
+    static_cast<void>(idleSeconds);
+#endif
+
+#if defined (TCP_KEEPINTVL)
+    if (intervalSeconds > 0
+        && (result = setsockopt(sock, level, TCP_KEEPINTVL,
+                &intervalSeconds, sizeof(intervalSeconds))) != 0)
+    {
+        set_last_socket_error (errno);
+        return result;
+    }
+#else
+    static_cast<void>(intervalSeconds);
+#endif
+
+#if defined (TCP_KEEPCNT)
+    if (probeCount > 0
+        && (result = setsockopt(sock, level, TCP_KEEPCNT, &probeCount,
+                sizeof(probeCount))) != 0)
+    {
+        set_last_socket_error (errno);
+        return result;
+    }
+#else
+    static_cast<void>(probeCount);
+#endif
+
+#else
+    static_cast<void>(idleSeconds);
+    static_cast<void>(intervalSeconds);
+    static_cast<void>(probeCount);
+
+#endif
+
+    return 0;
+}
+
+
+int
+setTCPUserTimeout (SOCKET_TYPE sock, int timeoutMilliseconds)
+{
+#if (defined (SOL_TCP) || defined (IPPROTO_TCP)) \
+    && defined (TCP_USER_TIMEOUT)
+#if defined (SOL_TCP)
+    int level = SOL_TCP;
+
+#elif defined (IPPROTO_TCP)
+    int level = IPPROTO_TCP;
+
+#endif
+
+    int result;
+    unsigned int timeout = static_cast<unsigned int>(timeoutMilliseconds);
+    if ((result = setsockopt(sock, level, TCP_USER_TIMEOUT, &timeout,
+                sizeof(timeout))) != 0)
+        set_last_socket_error (errno);
+
+    return result;
+
+#else
+    // No recognizable TCP_USER_TIMEOUT option.
+    static_cast<void>(sock);
+    static_cast<void>(timeoutMilliseconds);
+    return 0;
+
+#endif
+}
+
+
 //
 // ServerSocket OS dependent stuff
 //
 
 ServerSocket::ServerSocket(unsigned short port, bool udp /*= false*/,
-    bool ipv6 /*= false*/, tstring const & host /*= tstring ()*/)
+    bool ipv6 /*= false*/, tstring const & host /*= tstring ()*/,
+    bool reusePort /*= false*/)
 {
     // Initialize these here so that we do not try to close invalid handles
     // in dtor if the following `openSocket()` fails.
@@ -521,7 +1033,7 @@ ServerSocket::ServerSocket(unsigned short port, bool udp /*= false*/,
     int fds[2] = {-1, -1};
     int ret;
 
-    sock = openSocket (host, port, udp, ipv6, state);
+    sock = openSocket (host, port, udp, ipv6, state, reusePort);
     if (sock == INVALID_SOCKET_VALUE)
         goto error;
 
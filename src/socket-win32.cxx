@@ -166,8 +166,16 @@ namespace log4cplus { namespace helpers {
 
 SOCKET_TYPE
 openSocket(tstring const & host, unsigned short port, bool udp, bool ipv6,
-    SocketState& state)
+    SocketState& state, bool reusePort /*= false*/)
 {
+    if (reusePort)
+        // Winsock has no equivalent of SO_REUSEPORT's load balanced
+        // port sharing; SO_REUSEADDR semantics differ and would
+        // allow hijacking the port instead.
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("SO_REUSEPORT is not supported")
+            LOG4CPLUS_TEXT (" on this platform."));
+
     ADDRINFOT addr_info_hints{};
     PADDRINFOT ai = nullptr;
     std::unique_ptr<ADDRINFOT, ADDRINFOT_deleter> addr_info;
@@ -221,9 +229,69 @@ error:
 }
 
 
+namespace
+{
+
+//! Connects \c sock non-blocking and waits for the result with
+//! select() for at most \c timeout_msec milliseconds. Returns 0 on
+//! success, SOCKET_ERROR otherwise, and restores the socket's
+//! blocking mode.
+static
+int
+connect_with_timeout (os_socket_type sock, struct sockaddr * addr,
+    int addrlen, unsigned timeout_msec)
+{
+    u_long non_blocking = 1;
+    if (ioctlsocket (sock, FIONBIO, &non_blocking) != 0)
+        return SOCKET_ERROR;
+
+    int retval = ::connect (sock, addr, addrlen);
+    if (retval == SOCKET_ERROR && WSAGetLastError () == WSAEWOULDBLOCK)
+    {
+        fd_set write_set;
+        FD_ZERO (&write_set);
+        FD_SET (sock, &write_set);
+        fd_set except_set = write_set;
+        TIMEVAL tv;
+        tv.tv_sec = static_cast<long>(timeout_msec / 1000);
+        tv.tv_usec = static_cast<long>(timeout_msec % 1000 * 1000);
+        retval = ::select (0, nullptr, &write_set, &except_set, &tv);
+        if (retval == 1 && FD_ISSET (sock, &write_set))
+        {
+            int so_error = 0;
+            int len = sizeof (so_error);
+            if (getsockopt (sock, SOL_SOCKET, SO_ERROR,
+                    reinterpret_cast<char *>(&so_error), &len) == 0
+                && so_error == 0)
+                retval = 0;
+            else
+                retval = SOCKET_ERROR;
+        }
+        else
+            // Timed out (0), failed (SOCKET_ERROR) or the connection
+            // attempt ended up in the exception set.
+            retval = SOCKET_ERROR;
+    }
+
+    non_blocking = 0;
+    ioctlsocket (sock, FIONBIO, &non_blocking);
+    return retval;
+}
+
+} // namespace
+
+
+void
+refreshStaleAddresses ()
+{
+    // The DNS cache only exists in the BSD sockets implementation so
+    // far; the Winsock path resolves on every connect.
+}
+
+
 SOCKET_TYPE
 connectSocket(const tstring& hostn, unsigned short port, bool udp, bool ipv6,
-    SocketState& state)
+    SocketState& state, unsigned connect_timeout_msec)
 {
     ADDRINFOT addr_info_hints{};
     PADDRINFOT ai = nullptr;
@@ -265,11 +333,15 @@ connectSocket(const tstring& hostn, unsigned short port, bool udp, bool ipv6,
         if (sock_holder.sock == INVALID_OS_SOCKET_VALUE)
             continue;
 
-        while (
-            (retval = ::connect(sock_holder.sock, rp->ai_addr,
-                static_cast<int>(rp->ai_addrlen))) == -1
-            && (WSAGetLastError() == WSAEINTR))
-            ;
+        if (connect_timeout_msec != 0)
+            retval = connect_with_timeout (sock_holder.sock, rp->ai_addr,
+                static_cast<int>(rp->ai_addrlen), connect_timeout_msec);
+        else
+            while (
+                (retval = ::connect(sock_holder.sock, rp->ai_addr,
+                    static_cast<int>(rp->ai_addrlen))) == -1
+                && (WSAGetLastError() == WSAEINTR))
+                ;
         if (retval != SOCKET_ERROR)
             break;
     }
@@ -501,6 +573,91 @@ setTCPNoDelay (SOCKET_TYPE sock, bool val)
 }
 
 
+int
+setTCPKeepAlive (SOCKET_TYPE sock, bool enable, int idleSeconds,
+    int intervalSeconds, int probeCount)
+{
+    int result;
+    int enabled = static_cast<int>(enable);
+    if ((result = setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE,
+            reinterpret_cast<char*>(&enabled), sizeof(enabled))) != 0)
+    {
+        set_last_socket_error (WSAGetLastError ());
+        return result;
+    }
+
+    if (! enable)
+        return 0;
+
+    // The per probe knobs are only available with sufficiently recent
+    // SDKs and Windows versions; when they are missing the system
+    // defaults apply.
+#if defined (TCP_KEEPIDLE)
+    if (idleSeconds > 0
+        && (result = setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE,
+                reinterpret_cast<char*>(&idleSeconds),
+                sizeof(idleSeconds))) != 0)
+    {
+        set_last_socket_error (WSAGetLastError ());
+        return result;
+    }
+#else
+    static_cast<void>(idleSeconds);
+#endif
+
+#if defined (TCP_KEEPINTVL)
+    if (intervalSeconds > 0
+        && (result = setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL,
+                reinterpret_cast<char*>(&intervalSeconds),
+                sizeof(intervalSeconds))) != 0)
+    {
+        set_last_socket_error (WSAGetLastError ());
+        return result;
+    }
+#else
+    static_cast<void>(intervalSeconds);
+#endif
+
+#if defined (TCP_KEEPCNT)
+    if (probeCount > 0
+        && (result = setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT,
+                reinterpret_cast<char*>(&probeCount),
+                sizeof(probeCount))) != 0)
+    {
+        set_last_socket_error (WSAGetLastError ());
+        return result;
+    }
+#else
+    static_cast<void>(probeCount);
+#endif
+
+    return 0;
+}
+
+
+int
+setTCPUserTimeout (SOCKET_TYPE sock, int timeoutMilliseconds)
+{
+#if defined (TCP_MAXRT)
+    // TCP_MAXRT is the closest Windows equivalent of
+    // TCP_USER_TIMEOUT; it takes seconds.
+    int result;
+    int seconds = (timeoutMilliseconds + 999) / 1000;
+    if ((result = setsockopt(sock, IPPROTO_TCP, TCP_MAXRT,
+            reinterpret_cast<char*>(&seconds), sizeof(seconds))) != 0)
+        set_last_socket_error (WSAGetLastError ());
+
+    return result;
+
+#else
+    static_cast<void>(sock);
+    static_cast<void>(timeoutMilliseconds);
+    return 0;
+
+#endif
+}
+
+
 //
 // ServerSocket OS dependent stuff
 //
@@ -555,14 +712,15 @@ socketEventHandlingCleanup (SOCKET_TYPE s, HANDLE ev)
 
 
 ServerSocket::ServerSocket(unsigned short port, bool udp /*= false*/,
-    bool ipv6 /*= false*/, tstring const & host /*= tstring ()*/)
+    bool ipv6 /*= false*/, tstring const & host /*= tstring ()*/,
+    bool reusePort /*= false*/)
 {
     // Initialize these here so that we do not try to close invalid handles
     // in dtor if the following `openSocket()` fails.
     interruptHandles[0] = 0;
     interruptHandles[1] = 0;
 
-    sock = openSocket (host, port, udp, ipv6, state);
+    sock = openSocket (host, port, udp, ipv6, state, reusePort);
     if (sock == INVALID_SOCKET_VALUE)
     {
         err = get_last_socket_error ();
@@ -130,10 +130,12 @@ Socket::Socket()
 
 
 Socket::Socket(const tstring& address, unsigned short port,
-    bool udp /*= false*/, bool ipv6 /*= false */)
+    bool udp /*= false*/, bool ipv6 /*= false */,
+    unsigned connect_timeout_msec /*= 0*/)
     : AbstractSocket()
 {
-    sock = connectSocket(address, port, udp, ipv6, state);
+    sock = connectSocket(address, port, udp, ipv6, state,
+        connect_timeout_msec);
     if (sock == INVALID_SOCKET_VALUE)
         goto error;
 
@@ -222,6 +224,22 @@ Socket::write(const std::string & buffer)
 }
 
 
+int
+Socket::setKeepAlive (bool enable, int idleSeconds, int intervalSeconds,
+    int probeCount)
+{
+    return helpers::setTCPKeepAlive (sock, enable, idleSeconds,
+        intervalSeconds, probeCount);
+}
+
+
+int
+Socket::setUserTimeout (int timeoutMilliseconds)
+{
+    return helpers::setTCPUserTimeout (sock, timeoutMilliseconds);
+}
+
+
 //
 //
 //
@@ -19,12 +19,18 @@
 // limitations under the License.
 
 #include <cstdlib>
+#include <deque>
+#include <iterator>
+#include <map>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 #include <log4cplus/socketappender.h>
 #include <log4cplus/layout.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/helpers/loglog.h>
 #include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
 #include <log4cplus/internal/internal.h>
 
@@ -32,6 +38,304 @@
 namespace log4cplus {
 
 int const LOG4CPLUS_MESSAGE_VERSION = 3;
+int const LOG4CPLUS_BATCH_MESSAGE_VERSION = 4;
+int const LOG4CPLUS_HEARTBEAT_MESSAGE_VERSION = 5;
+int const LOG4CPLUS_COMPRESSED_MESSAGE_VERSION = 6;
+
+
+namespace
+{
+
+//! Parses the comma separated "host:port" list of the Hosts
+//! property. Entries without a port use \c default_port.
+static
+std::vector<std::pair<tstring, unsigned> >
+parseDestinations (tstring const & hosts, unsigned default_port)
+{
+    std::vector<tstring> tokens;
+    helpers::tokenize (hosts, LOG4CPLUS_TEXT (','),
+        std::back_insert_iterator<std::vector<tstring> > (tokens));
+
+    std::vector<std::pair<tstring, unsigned> > destinations;
+    destinations.reserve (tokens.size ());
+    for (tstring const & token : tokens)
+    {
+        if (token.empty ())
+            continue;
+
+        tstring::size_type const colon = token.rfind (LOG4CPLUS_TEXT (':'));
+        if (colon == tstring::npos)
+        {
+            destinations.emplace_back (token, default_port);
+            continue;
+        }
+
+        unsigned ep_port = default_port;
+        try
+        {
+            ep_port = static_cast<unsigned>(
+                std::stoul (token.substr (colon + 1)));
+        }
+        catch (std::logic_error const &)
+        {
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("SocketAppender- Bad port in Hosts entry: ")
+                + token);
+        }
+        destinations.emplace_back (token.substr (0, colon), ep_port);
+    }
+
+    return destinations;
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+//! Builds the one byte heartbeat frame with its size prefix.
+static
+helpers::SocketBuffer
+makeHeartbeatFrame ()
+{
+    helpers::SocketBuffer heartbeat (sizeof (unsigned int) + 1);
+    heartbeat.appendInt (1);
+    heartbeat.appendByte (
+        static_cast<unsigned char>(LOG4CPLUS_HEARTBEAT_MESSAGE_VERSION));
+    return heartbeat;
+}
+
+#endif
+
+} // namespace
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+//! Drains the internal queue and writes batches of events to pooled
+//! connections, so that logging threads never block on the network.
+class SocketAppender::SenderThread
+    : public thread::AbstractThread
+{
+public:
+    SenderThread (helpers::SharedObjectPtr<SocketAppender> a,
+        thread::QueuePtr q)
+        : appender (std::move (a))
+        , queue (std::move (q))
+    { }
+
+    void run() override
+    {
+        thread::Queue::queue_storage_type ev_buf;
+
+        while (true)
+        {
+            unsigned qflags = queue->get_events (&ev_buf);
+            if (qflags & thread::Queue::EVENT)
+                appender->sendBatch (ev_buf.data (), ev_buf.size ());
+
+            if (((thread::Queue::EXIT | thread::Queue::DRAIN
+                    | thread::Queue::EVENT) & qflags)
+                == (thread::Queue::EXIT | thread::Queue::DRAIN
+                    | thread::Queue::EVENT))
+                continue;
+            else if (thread::Queue::EXIT & qflags)
+                break;
+        }
+    }
+
+private:
+    helpers::SharedObjectPtr<SocketAppender> appender;
+    thread::QueuePtr queue;
+};
+
+
+//! Drains the elastic send buffer filled by logging threads and
+//! writes each drained chunk to the server as one large write over
+//! its own connection, so that TCP backpressure stalls this thread
+//! instead of the logging threads.
+class SocketAppender::FlusherThread
+    : public thread::AbstractThread
+{
+public:
+    explicit FlusherThread (helpers::SharedObjectPtr<SocketAppender> a)
+        : appender (std::move (a))
+    { }
+
+    void run () override
+    {
+        std::vector<char> chunk;
+
+        while (true)
+        {
+            appender->send_buffer_data.timed_wait (flush_interval_msec);
+            // Reset before the swap so that a signal raised by a
+            // frame buffered during the swap is not lost.
+            appender->send_buffer_data.reset ();
+
+            bool exit_flag;
+            {
+                thread::MutexGuard guard (appender->send_buffer_mutex);
+                chunk.swap (appender->send_buffer);
+                exit_flag = appender->send_buffer_exit;
+            }
+            appender->send_buffer_space.signal ();
+
+            if (! chunk.empty ())
+            {
+                writeChunk (chunk);
+                chunk.clear ();
+            }
+
+            if (exit_flag)
+                break;
+        }
+
+        socket.close ();
+    }
+
+private:
+    //! Upper bound on how long buffered bytes below the low
+    //! watermark wait before they are flushed anyway.
+    static unsigned long const flush_interval_msec = 100;
+
+    void writeChunk (std::vector<char> & chunk)
+    {
+        // The chunk is a concatenation of standard size prefixed
+        // frames, so it can go over the wire verbatim; wrap it
+        // without copying.
+        helpers::SocketBuffer blob (chunk.data (), chunk.size ());
+
+        if (! socket.isOpen ())
+        {
+            socket = helpers::Socket (appender->host,
+                static_cast<unsigned short>(appender->port), false,
+                appender->ipv6, appender->connectTimeout);
+            appender->applySocketOptions (socket);
+        }
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+        if (appender->compressStream)
+        {
+            // writeCompressed() also replicates the envelope, so a
+            // dead primary does not stop the replicas.
+            helpers::SocketBuffer const * const buffers[1] = { &blob };
+            if (! appender->writeCompressed (socket, 1, buffers, true))
+            {
+                helpers::getLogLog().error(
+                    LOG4CPLUS_TEXT("SocketAppender::FlusherThread")
+                    LOG4CPLUS_TEXT(
+                        "- Write failed, dropping buffered events"));
+                socket.close ();
+            }
+            return;
+        }
+#endif
+
+        if (! socket.isOpen () || ! socket.write (blob))
+        {
+            // Matches the unbuffered path: events bound for an
+            // unreachable server are dropped, not retried.
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("SocketAppender::FlusherThread")
+                LOG4CPLUS_TEXT("- Write failed, dropping buffered events"));
+            socket.close ();
+        }
+
+        if (! appender->replicas.empty ())
+        {
+            helpers::SocketBuffer const * const buffers[1] = { &blob };
+            appender->replicateBuffers (1, buffers);
+        }
+    }
+
+    helpers::SharedObjectPtr<SocketAppender> appender;
+    //! The flusher's own connection; the appender's primary socket
+    //! stays with the connector thread.
+    helpers::Socket socket;
+};
+
+
+//! One replicated destination beyond the primary host. It speaks the
+//! connector thread client protocol for its own socket and guards it
+//! with its own mutex, so each destination heartbeats and reconnects
+//! independently of the primary and of the other replicas.
+struct SocketAppender::Endpoint
+    : public virtual helpers::IConnectorThreadClient
+{
+    Endpoint (SocketAppender & appender_, tstring host_, unsigned port_)
+        : appender (appender_)
+        , host (std::move (host_))
+        , port (port_)
+        , connected (false)
+    { }
+
+    thread::Mutex const & ctcGetAccessMutex () const override
+    {
+        return access_mutex;
+    }
+
+    helpers::Socket & ctcGetSocket () override
+    {
+        return socket;
+    }
+
+    helpers::Socket ctcConnect () override
+    {
+        helpers::Socket sock (host, static_cast<unsigned short>(port),
+            false, appender.ipv6, appender.connectTimeout);
+        appender.applySocketOptions (sock);
+        return sock;
+    }
+
+    void ctcSetConnected () override
+    {
+        connected = true;
+    }
+
+    void ctcHeartbeat () override;
+
+    SocketAppender & appender;
+    tstring host;
+    unsigned port;
+    thread::Mutex access_mutex;
+    helpers::Socket socket;
+    volatile bool connected;
+    helpers::SharedObjectPtr<helpers::ConnectorThread> connector;
+};
+
+
+void
+SocketAppender::Endpoint::ctcHeartbeat ()
+{
+    if (appender.heartbeatInterval == 0)
+        return;
+
+    helpers::SocketBuffer heartbeat (makeHeartbeatFrame ());
+
+    bool ret;
+    {
+        thread::MutexGuard guard (access_mutex);
+        if (! connected || ! socket.isOpen ())
+            return;
+
+        ret = socket.write (heartbeat);
+    }
+
+    if (! ret)
+    {
+        helpers::getLogLog().warn(
+            LOG4CPLUS_TEXT("SocketAppender::Endpoint::ctcHeartbeat()")
+            LOG4CPLUS_TEXT("- Heartbeat write failed, reconnecting"));
+
+        {
+            thread::MutexGuard guard (access_mutex);
+            connected = false;
+            socket.close ();
+        }
+        connector->trigger ();
+    }
+}
+
+#endif
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -45,6 +349,9 @@ SocketAppender::SocketAppender(const tstring& host_,
     , serverName(serverName_)
     , ipv6(ipv6_)
 {
+    // The wire format serializes the NDC and thread name regardless
+    // of any layout.
+    spi::addNeededEventFields (spi::EventFieldNDC | spi::EventFieldThread);
     openSocket();
     initConnector ();
 }
@@ -55,13 +362,112 @@ SocketAppender::SocketAppender(const helpers::Properties & properties)
  : Appender(properties),
    port(9998)
 {
+    spi::addNeededEventFields (spi::EventFieldNDC | spi::EventFieldThread);
     host = properties.getProperty( LOG4CPLUS_TEXT("host") );
     properties.getUInt (port, LOG4CPLUS_TEXT("port"));
     serverName = properties.getProperty( LOG4CPLUS_TEXT("ServerName") );
     properties.getBool(ipv6, LOG4CPLUS_TEXT("IPv6"));
+    properties.getBool(batchFraming, LOG4CPLUS_TEXT("BatchFraming"));
+    properties.getBool(tcpKeepAlive, LOG4CPLUS_TEXT("TCPKeepAlive"));
+    properties.getUInt(tcpKeepAliveIdle, LOG4CPLUS_TEXT("TCPKeepAliveIdle"));
+    properties.getUInt(tcpKeepAliveInterval,
+        LOG4CPLUS_TEXT("TCPKeepAliveInterval"));
+    properties.getUInt(tcpKeepAliveCount,
+        LOG4CPLUS_TEXT("TCPKeepAliveCount"));
+    properties.getUInt(tcpUserTimeout, LOG4CPLUS_TEXT("TCPUserTimeout"));
+    properties.getUInt(connectTimeout, LOG4CPLUS_TEXT("ConnectTimeout"));
+    properties.getUInt(heartbeatInterval,
+        LOG4CPLUS_TEXT("HeartbeatInterval"));
+    properties.getBool(compressStream, LOG4CPLUS_TEXT("Compress"));
+#if ! defined (LOG4CPLUS_WITH_ZLIB)
+    if (compressStream)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("SocketAppender- Compress is ignored,")
+            LOG4CPLUS_TEXT (" log4cplus was built without zlib support"));
+        compressStream = false;
+    }
+#endif
 
-    openSocket();
+    // A comma separated Hosts list makes the first entry the primary
+    // destination and every further entry a replicated one.
+    std::vector<std::pair<tstring, unsigned> > destinations
+        = parseDestinations (
+            properties.getProperty (LOG4CPLUS_TEXT ("Hosts")), port);
+    if (! destinations.empty ())
+    {
+        host = destinations.front ().first;
+        port = destinations.front ().second;
+    }
+
+    unsigned queue_len = 100;
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    properties.getBool(asyncSend, LOG4CPLUS_TEXT("AsyncSend"));
+    properties.getUInt(queue_len, LOG4CPLUS_TEXT("QueueLimit"));
+    properties.getUInt(connectionPoolSize,
+        LOG4CPLUS_TEXT("ConnectionPoolSize"));
+
+    unsigned send_buffer_size = 0;
+    unsigned send_buffer_low = 0;
+    properties.getUInt (send_buffer_size, LOG4CPLUS_TEXT ("SendBufferSize"));
+    properties.getUInt (send_buffer_low,
+        LOG4CPLUS_TEXT ("SendBufferLowWatermark"));
+    if (send_buffer_size != 0 && asyncSend)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("SocketAppender- SendBufferSize is ignored")
+            LOG4CPLUS_TEXT (" when AsyncSend is enabled"));
+        send_buffer_size = 0;
+    }
+    sendBufferSize = send_buffer_size;
+    sendBufferLowWatermark = send_buffer_low;
+
+    tstring const overflow_policy = properties.getProperty (
+        LOG4CPLUS_TEXT ("SendBufferOverflowPolicy"));
+    if (! overflow_policy.empty ()
+        && overflow_policy != LOG4CPLUS_TEXT ("Block"))
+    {
+        if (overflow_policy == LOG4CPLUS_TEXT ("DropNewest"))
+            sendBufferDrop = true;
+        else
+            helpers::getLogLog ().error (
+                LOG4CPLUS_TEXT ("SocketAppender")
+                LOG4CPLUS_TEXT ("- Unknown SendBufferOverflowPolicy: ")
+                + overflow_policy);
+    }
+#endif
+
+    bool deferConnect = false;
+    properties.getBool (deferConnect, LOG4CPLUS_TEXT ("DeferConnect"));
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+    // There is no connector thread to hand the connection off to.
+    deferConnect = false;
+#endif
+
+    if (! deferConnect)
+        openSocket();
     initConnector ();
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (deferConnect)
+    {
+        // Let the connector thread perform the initial connection so
+        // that construction does not block on DNS or connect().
+        connected = false;
+        connector->trigger ();
+    }
+
+    if (destinations.size () > 1)
+        initReplicas (destinations);
+
+    if (asyncSend)
+        initSender (queue_len);
+    else if (sendBufferSize != 0)
+        initSendBuffer ();
+#else
+    static_cast<void>(queue_len);
+#endif
 }
 
 
@@ -84,6 +490,46 @@ SocketAppender::close()
         LOG4CPLUS_TEXT("Entering SocketAppender::close()..."));
 
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (queue)
+        queue->signal_exit ();
+
+    if (sender_thread && sender_thread->isRunning ())
+        sender_thread->join ();
+
+    sender_thread = nullptr;
+    queue = nullptr;
+
+    if (flusher_thread)
+    {
+        {
+            thread::MutexGuard guard (send_buffer_mutex);
+            send_buffer_exit = true;
+        }
+        // Wake both the flusher for its final drain and any producer
+        // still blocked on a full buffer.
+        send_buffer_data.signal ();
+        send_buffer_space.signal ();
+        if (flusher_thread->isRunning ())
+            flusher_thread->join ();
+        flusher_thread = nullptr;
+
+        if (droppedFrames != 0)
+            helpers::getLogLog ().warn (
+                LOG4CPLUS_TEXT ("SocketAppender::close()- Dropped ")
+                + helpers::convertIntegerToString (droppedFrames)
+                + LOG4CPLUS_TEXT (" frames on full send buffer"));
+    }
+
+    for (helpers::Socket & pooled : socketPool)
+        pooled.close ();
+
+    for (std::unique_ptr<Endpoint> const & endpoint : replicas)
+    {
+        endpoint->connector->terminate ();
+        endpoint->socket.close ();
+    }
+    replicas.clear ();
+
     connector->terminate ();
 #endif
 
@@ -101,17 +547,36 @@ void
 SocketAppender::openSocket()
 {
     if(!socket.isOpen()) {
-        socket = helpers::Socket(host, static_cast<unsigned short>(port), false, ipv6);
+        socket = helpers::Socket(host, static_cast<unsigned short>(port),
+            false, ipv6, connectTimeout);
+        applySocketOptions (socket);
     }
 }
 
 
+void
+SocketAppender::applySocketOptions (helpers::Socket & sock)
+{
+    if (! sock.isOpen ())
+        return;
+
+    if (tcpKeepAlive)
+        sock.setKeepAlive (true, static_cast<int>(tcpKeepAliveIdle),
+            static_cast<int>(tcpKeepAliveInterval),
+            static_cast<int>(tcpKeepAliveCount));
+
+    if (tcpUserTimeout != 0)
+        sock.setUserTimeout (static_cast<int>(tcpUserTimeout));
+}
+
+
 void
 SocketAppender::initConnector ()
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
     connected = true;
-    connector = new helpers::ConnectorThread (*this);
+    connector = new helpers::ConnectorThread (*this,
+        heartbeatInterval != 0 ? heartbeatInterval * 1000 : 30 * 1000);
     connector->start ();
 #endif
 }
@@ -121,10 +586,45 @@ void
 SocketAppender::append(const spi::InternalLoggingEvent& event)
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (sender_thread && sender_thread->isRunning ())
+    {
+        unsigned ret = queue->put_event (event);
+        if (ret & (thread::Queue::ERROR_BIT | thread::Queue::ERROR_AFTER))
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT("SocketAppender::append()")
+                LOG4CPLUS_TEXT("- Cannot queue event for sender thread"));
+        return;
+    }
+
+    if (flusher_thread)
+    {
+        msgBuffer.reserve (LOG4CPLUS_MAX_MESSAGE_SIZE
+            - sizeof (unsigned int));
+        try
+        {
+            convertToBuffer (msgBuffer, event, serverName);
+        }
+        catch (std::runtime_error const &)
+        {
+            return;
+        }
+
+        sizeBuffer.reserve (sizeof (unsigned int));
+        sizeBuffer.appendInt (static_cast<unsigned>(msgBuffer.getSize ()));
+
+        helpers::SocketBuffer const * const buffers[2]
+            = { &sizeBuffer, &msgBuffer };
+        bufferFrames (2, buffers);
+        return;
+    }
+
     if (! connected)
     {
         connector->trigger ();
-        return;
+        // A dead primary must not stop delivery to the replica
+        // destinations.
+        if (replicas.empty ())
+            return;
     }
 
 #else
@@ -139,8 +639,7 @@ SocketAppender::append(const spi::InternalLoggingEvent& event)
     }
 #endif
 
-    helpers::SocketBuffer msgBuffer(LOG4CPLUS_MAX_MESSAGE_SIZE
-        - sizeof (unsigned int));
+    msgBuffer.reserve (LOG4CPLUS_MAX_MESSAGE_SIZE - sizeof (unsigned int));
 
     try
     {
@@ -151,24 +650,461 @@ SocketAppender::append(const spi::InternalLoggingEvent& event)
         return;
     }
 
-    helpers::SocketBuffer buffer(sizeof(unsigned int));
-    buffer.appendInt(static_cast<unsigned>(msgBuffer.getSize()));
+    sizeBuffer.reserve (sizeof (unsigned int));
+    sizeBuffer.appendInt(static_cast<unsigned>(msgBuffer.getSize()));
 
-    bool ret = helpers::Socket::write(socket, buffer, msgBuffer);
-    if (! ret)
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (connected
+        && ! helpers::Socket::write(socket, sizeBuffer, msgBuffer))
     {
         helpers::getLogLog().error(
             LOG4CPLUS_TEXT(
                 "SocketAppender::append()- Write failed"));
 
+        connected = false;
+        connector->trigger ();
+    }
+
+    if (! replicas.empty ())
+    {
+        helpers::SocketBuffer const * const buffers[2]
+            = { &sizeBuffer, &msgBuffer };
+        replicateBuffers (2, buffers);
+    }
+#else
+    if (! helpers::Socket::write(socket, sizeBuffer, msgBuffer))
+        helpers::getLogLog().error(
+            LOG4CPLUS_TEXT(
+                "SocketAppender::append()- Write failed"));
+#endif
+}
+
+
+void
+SocketAppender::appendBatch(const spi::InternalLoggingEvent* events,
+    std::size_t count)
+{
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (sender_thread && sender_thread->isRunning ())
+    {
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            unsigned ret = queue->put_event (events[i]);
+            if (ret & (thread::Queue::ERROR_BIT
+                    | thread::Queue::ERROR_AFTER))
+            {
+                helpers::getLogLog().error(
+                    LOG4CPLUS_TEXT("SocketAppender::appendBatch()")
+                    LOG4CPLUS_TEXT(
+                        "- Cannot queue event for sender thread"));
+                return;
+            }
+        }
+        return;
+    }
+
+    if (flusher_thread)
+    {
+        if (batchFraming)
+        {
+            std::unique_ptr<helpers::SocketBuffer> batchBuffer
+                = helpers::convertBatchToBuffer (events, count, serverName);
+            sizeBuffer.reserve (sizeof (unsigned int));
+            sizeBuffer.appendInt (
+                static_cast<unsigned>(batchBuffer->getSize ()));
+
+            helpers::SocketBuffer const * const buffers[2]
+                = { &sizeBuffer, batchBuffer.get () };
+            bufferFrames (2, buffers);
+            return;
+        }
+
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            msgBuffer.reserve (LOG4CPLUS_MAX_MESSAGE_SIZE
+                - sizeof (unsigned int));
+            try
+            {
+                convertToBuffer (msgBuffer, events[i], serverName);
+            }
+            catch (std::runtime_error const &)
+            {
+                continue;
+            }
+
+            sizeBuffer.reserve (sizeof (unsigned int));
+            sizeBuffer.appendInt (
+                static_cast<unsigned>(msgBuffer.getSize ()));
+
+            helpers::SocketBuffer const * const buffers[2]
+                = { &sizeBuffer, &msgBuffer };
+            bufferFrames (2, buffers);
+        }
+        return;
+    }
+
+    if (! connected)
+    {
+        connector->trigger ();
+        // A dead primary must not stop delivery to the replica
+        // destinations.
+        if (replicas.empty ())
+            return;
+    }
+
+    // Writing to a closed primary socket fails immediately; only a
+    // newly broken connection is worth reporting.
+    if (! writeBatch (socket, events, count, true) && connected)
+    {
+        helpers::getLogLog().error(
+            LOG4CPLUS_TEXT(
+                "SocketAppender::appendBatch()- Write failed"));
+
         connected = false;
         connector->trigger ();
+    }
+#else
+    if(!socket.isOpen()) {
+        openSocket();
+        if(!socket.isOpen()) {
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT(
+                    "SocketAppender::appendBatch()- Cannot connect to server"));
+            return;
+        }
+    }
+
+    if (! writeBatch (socket, events, count))
+        helpers::getLogLog().error(
+            LOG4CPLUS_TEXT(
+                "SocketAppender::appendBatch()- Write failed"));
+#endif
+}
+
+
+bool
+SocketAppender::writeBatch(helpers::Socket & sock,
+    const spi::InternalLoggingEvent* events, std::size_t count,
+    bool replicate)
+{
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+    static_cast<void>(replicate);
+#endif
+
+    if (batchFraming)
+    {
+        std::unique_ptr<helpers::SocketBuffer> msgBuffer
+            = helpers::convertBatchToBuffer (events, count, serverName);
+
+        helpers::SocketBuffer sizeBuffer(sizeof(unsigned int));
+        sizeBuffer.appendInt(static_cast<unsigned>(msgBuffer->getSize()));
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+        if (compressStream)
+        {
+            helpers::SocketBuffer const * const buffers[2]
+                = { &sizeBuffer, msgBuffer.get () };
+            return writeCompressed (sock, 2, buffers, replicate);
+        }
+#endif
+
+        bool const ret
+            = helpers::Socket::write (sock, sizeBuffer, *msgBuffer);
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        if (replicate && ! replicas.empty ())
+        {
+            helpers::SocketBuffer const * const buffers[2]
+                = { &sizeBuffer, msgBuffer.get () };
+            replicateBuffers (2, buffers);
+        }
+#endif
+        return ret;
+    }
+
+    // Serialize the whole batch up front and hand the size prefix and
+    // payload buffer of each event to a single scatter-gather write,
+    // instead of paying one syscall per event.
+    std::deque<helpers::SocketBuffer> buffers;
+    std::vector<helpers::SocketBuffer const *> bufferPtrs;
+    bufferPtrs.reserve (2 * count);
+
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        helpers::SocketBuffer & msgBuffer = buffers.emplace_back (
+            LOG4CPLUS_MAX_MESSAGE_SIZE - sizeof (unsigned int));
+        try
+        {
+            convertToBuffer (msgBuffer, events[i], serverName);
+        }
+        catch (std::runtime_error const &)
+        {
+            buffers.pop_back ();
+            continue;
+        }
+
+        helpers::SocketBuffer & header = buffers.emplace_back (
+            sizeof (unsigned int));
+        header.appendInt (static_cast<unsigned>(msgBuffer.getSize ()));
+
+        bufferPtrs.push_back (&header);
+        bufferPtrs.push_back (&msgBuffer);
+    }
+
+    if (bufferPtrs.empty ())
+        return true;
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+    if (compressStream)
+        return writeCompressed (sock, bufferPtrs.size (),
+            bufferPtrs.data (), replicate);
+#endif
+
+    bool const ret = sock.write (bufferPtrs.size (), bufferPtrs.data ());
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (replicate && ! replicas.empty ())
+        replicateBuffers (bufferPtrs.size (), bufferPtrs.data ());
+#endif
+    return ret;
+}
+
+
+#if defined (LOG4CPLUS_WITH_ZLIB)
+
+bool
+SocketAppender::writeCompressed (helpers::Socket & sock,
+    std::size_t bufferCount, helpers::SocketBuffer const * const * buffers,
+    bool replicate)
+{
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+    static_cast<void>(replicate);
+#endif
+
+    compress_in.clear ();
+    for (std::size_t i = 0; i != bufferCount; ++i)
+    {
+        char const * const data = buffers[i]->getBuffer ();
+        compress_in.insert (compress_in.end (), data,
+            data + buffers[i]->getSize ());
+    }
+
+    if (! compressor.compress (compress_out, compress_in.data (),
+            compress_in.size ()))
+    {
+        // Ship the frames uncompressed rather than dropping them.
+        bool const ret = sock.write (bufferCount, buffers);
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        if (replicate && ! replicas.empty ())
+            replicateBuffers (bufferCount, buffers);
+#endif
+        return ret;
+    }
+
+    // Envelope frame: outer size prefix, version byte, uncompressed
+    // size and the deflate stream.
+    helpers::SocketBuffer header (2 * sizeof (unsigned int) + 1);
+    header.appendInt (static_cast<unsigned>(
+        compress_out.size () + sizeof (unsigned int) + 1));
+    header.appendByte (
+        static_cast<unsigned char>(LOG4CPLUS_COMPRESSED_MESSAGE_VERSION));
+    header.appendInt (static_cast<unsigned>(compress_in.size ()));
+
+    helpers::SocketBuffer body (compress_out.data (), compress_out.size ());
+    helpers::SocketBuffer const * const envelope[2] = { &header, &body };
+
+    bool const ret = sock.write (2, envelope);
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    if (replicate && ! replicas.empty ())
+        replicateBuffers (2, envelope);
 #endif
+    return ret;
+}
+
+#endif // LOG4CPLUS_WITH_ZLIB
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+void
+SocketAppender::initSender (unsigned queue_len)
+{
+    if (connectionPoolSize == 0)
+        connectionPoolSize = 1;
+
+    socketPool.resize (connectionPoolSize);
+
+    queue = new thread::Queue (queue_len);
+    sender_thread = new SenderThread (
+        helpers::SharedObjectPtr<SocketAppender> (this), queue);
+    sender_thread->start ();
+}
+
+
+void
+SocketAppender::initSendBuffer ()
+{
+    if (sendBufferLowWatermark == 0
+        || sendBufferLowWatermark > sendBufferSize)
+        sendBufferLowWatermark = sendBufferSize / 2;
+
+    send_buffer.reserve (sendBufferSize);
+
+    flusher_thread = new FlusherThread (
+        helpers::SharedObjectPtr<SocketAppender> (this));
+    flusher_thread->start ();
+}
+
+
+void
+SocketAppender::bufferFrames (std::size_t bufferCount,
+    helpers::SocketBuffer const * const * buffers)
+{
+    while (true)
+    {
+        {
+            thread::MutexGuard guard (send_buffer_mutex);
+            if (send_buffer_exit)
+                return;
+
+            if (send_buffer.size () < sendBufferSize)
+            {
+                // The buffer is elastic: the last frame before the
+                // high watermark may push it past sendBufferSize.
+                for (std::size_t i = 0; i != bufferCount; ++i)
+                {
+                    char const * const data = buffers[i]->getBuffer ();
+                    send_buffer.insert (send_buffer.end (), data,
+                        data + buffers[i]->getSize ());
+                }
+
+                if (send_buffer.size () >= sendBufferLowWatermark)
+                    send_buffer_data.signal ();
+
+                return;
+            }
+        }
+
+        if (sendBufferDrop)
+        {
+            ++droppedFrames;
+            return;
+        }
+
+        // Reset space before kicking the flusher so that its signal
+        // after the swap cannot be lost between our check and wait.
+        send_buffer_space.reset ();
+        send_buffer_data.signal ();
+        send_buffer_space.wait ();
+    }
+}
+
+
+//! Runs in the sender thread.
+void
+SocketAppender::sendBatch (const spi::InternalLoggingEvent* events,
+    std::size_t count)
+{
+    helpers::Socket * sock = pickSocket ();
+    if (! sock)
+        return;
+
+    if (! writeBatch (*sock, events, count, true))
+    {
+        // Reconnect the pooled connection and retry the batch once
+        // before giving up on it. The replicas already received the
+        // batch above, so the retry writes to the primary only.
+        *sock = helpers::Socket (host, static_cast<unsigned short>(port),
+            false, ipv6, connectTimeout);
+        applySocketOptions (*sock);
+        if (! sock->isOpen () || ! writeBatch (*sock, events, count))
+            helpers::getLogLog().error(
+                LOG4CPLUS_TEXT(
+                    "SocketAppender::sendBatch()- Write failed"));
+    }
+}
+
+
+helpers::Socket *
+SocketAppender::pickSocket ()
+{
+    helpers::Socket & sock = socketPool[nextSocket++ % socketPool.size ()];
+    if (! sock.isOpen ())
+    {
+        sock = helpers::Socket (host, static_cast<unsigned short>(port),
+            false, ipv6, connectTimeout);
+        applySocketOptions (sock);
+    }
+
+    if (! sock.isOpen ())
+    {
+        helpers::getLogLog().error(
+            LOG4CPLUS_TEXT(
+                "SocketAppender::pickSocket()- Cannot connect to server"));
+        return nullptr;
+    }
+
+    return &sock;
+}
+
+
+void
+SocketAppender::initReplicas (
+    std::vector<std::pair<tstring, unsigned> > const & destinations)
+{
+    // The first destination is the primary host; every further one
+    // becomes a replica with its own connection and connector thread.
+    for (std::size_t i = 1; i != destinations.size (); ++i)
+    {
+        std::unique_ptr<Endpoint> endpoint (new Endpoint (*this,
+            destinations[i].first, destinations[i].second));
+        endpoint->socket = endpoint->ctcConnect ();
+        endpoint->connected = endpoint->socket.isOpen ();
+        endpoint->connector = new helpers::ConnectorThread (*endpoint,
+            heartbeatInterval != 0 ? heartbeatInterval * 1000 : 30 * 1000);
+        endpoint->connector->start ();
+        replicas.push_back (std::move (endpoint));
     }
 }
 
 
+//! Writes the already serialized buffers to every replica
+//! destination. Runs in whichever thread produced the buffers; each
+//! endpoint's own mutex serializes its socket against the endpoint's
+//! connector thread.
+void
+SocketAppender::replicateBuffers (std::size_t bufferCount,
+    helpers::SocketBuffer const * const * buffers)
+{
+    for (std::unique_ptr<Endpoint> const & endpoint : replicas)
+    {
+        bool trigger = false;
+        {
+            thread::MutexGuard guard (endpoint->access_mutex);
+            if (! endpoint->connected || ! endpoint->socket.isOpen ())
+                trigger = true;
+            else if (! endpoint->socket.write (bufferCount, buffers))
+            {
+                helpers::getLogLog().error(
+                    LOG4CPLUS_TEXT("SocketAppender::replicateBuffers()")
+                    LOG4CPLUS_TEXT("- Write to ") + endpoint->host
+                    + LOG4CPLUS_TEXT(" failed"));
+
+                endpoint->connected = false;
+                endpoint->socket.close ();
+                trigger = true;
+            }
+        }
+
+        if (trigger)
+            endpoint->connector->trigger ();
+    }
+}
+
+#endif // LOG4CPLUS_SINGLE_THREADED
+
+
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 thread::Mutex const &
 SocketAppender::ctcGetAccessMutex () const
@@ -187,7 +1123,9 @@ SocketAppender::ctcGetSocket ()
 helpers::Socket
 SocketAppender::ctcConnect ()
 {
-    return helpers::Socket (host, static_cast<unsigned short>(port));
+    helpers::Socket sock (host, static_cast<unsigned short>(port));
+    applySocketOptions (sock);
+    return sock;
 }
 
 void
@@ -196,6 +1134,44 @@ SocketAppender::ctcSetConnected ()
     connected = true;
 }
 
+
+void
+SocketAppender::ctcHeartbeat ()
+{
+    if (heartbeatInterval == 0)
+        return;
+
+    // A heartbeat is the smallest possible frame: a size prefix of
+    // one followed by the heartbeat version byte. The receiver
+    // discards it; its only purpose is to make a dead connection fail
+    // a write here, in the connector thread, instead of stalling a
+    // later event append.
+    helpers::SocketBuffer heartbeat (makeHeartbeatFrame ());
+
+    bool ret;
+    {
+        thread::MutexGuard guard (access_mutex);
+        if (! connected || ! socket.isOpen ())
+            return;
+
+        ret = socket.write (heartbeat);
+    }
+
+    if (! ret)
+    {
+        helpers::getLogLog().warn(
+            LOG4CPLUS_TEXT("SocketAppender::ctcHeartbeat()")
+            LOG4CPLUS_TEXT("- Heartbeat write failed, reconnecting"));
+
+        {
+            thread::MutexGuard guard (access_mutex);
+            connected = false;
+            socket.close ();
+        }
+        connector->trigger ();
+    }
+}
+
 #endif
 
 
@@ -246,25 +1222,36 @@ readFromBuffer(SocketBuffer& buffer)
 
     unsigned char sizeOfChar = buffer.readByte();
 
-    tstring serverName = buffer.readString(sizeOfChar);
-    tstring loggerName = buffer.readString(sizeOfChar);
+    // The fields are parsed as views straight into the receive buffer
+    // (or into the per field scratch strings when a character
+    // conversion is needed) and stay valid until the event
+    // constructor below copies them into the event's own storage, so
+    // no intermediate tstring per field is created.
+    tstring scratch[7];
+    tstring_view serverName = buffer.readStringView(sizeOfChar, scratch[0]);
+    tstring_view loggerName = buffer.readStringView(sizeOfChar, scratch[1]);
     LogLevel ll = buffer.readInt();
-    tstring ndc = buffer.readString(sizeOfChar);
+    tstring_view ndc = buffer.readStringView(sizeOfChar, scratch[2]);
+    tstring ndcStorage;
     if(! serverName.empty ()) {
         if(ndc.empty ()) {
             ndc = serverName;
         }
         else {
-            ndc = serverName + LOG4CPLUS_TEXT(" - ") + ndc;
+            ndcStorage.reserve (serverName.size () + 3 + ndc.size ());
+            ndcStorage.append (serverName.data (), serverName.size ());
+            ndcStorage.append (LOG4CPLUS_TEXT(" - "));
+            ndcStorage.append (ndc.data (), ndc.size ());
+            ndc = ndcStorage;
         }
     }
-    tstring message = buffer.readString(sizeOfChar);
-    tstring thread = buffer.readString(sizeOfChar);
+    tstring_view message = buffer.readStringView(sizeOfChar, scratch[3]);
+    tstring_view thread = buffer.readStringView(sizeOfChar, scratch[4]);
     long sec = buffer.readInt();
     long usec = buffer.readInt();
-    tstring file = buffer.readString(sizeOfChar);
+    tstring_view file = buffer.readStringView(sizeOfChar, scratch[5]);
     int line = buffer.readInt();
-    tstring function = buffer.readString(sizeOfChar);
+    tstring_view function = buffer.readStringView(sizeOfChar, scratch[6]);
 
     // TODO: Pass MDC through.
     spi::InternalLoggingEvent ev (loggerName, ll, ndc,
@@ -275,6 +1262,180 @@ readFromBuffer(SocketBuffer& buffer)
 }
 
 
+namespace
+{
+
+//! Number of bytes appendString() will use for given string.
+static
+std::size_t
+stringWireSize (tstring const & str)
+{
+    std::size_t const sizeOfChar = sizeof (tchar) == 1 ? 1 : 2;
+    return sizeof (unsigned int) + str.length () * sizeOfChar;
+}
+
+} // namespace
+
+
+std::unique_ptr<SocketBuffer>
+convertBatchToBuffer (const spi::InternalLoggingEvent* events,
+    std::size_t count, const tstring& serverName)
+{
+    // Repeated strings--logger names, thread ids, files and
+    // functions--are emitted once in a dictionary and referenced by
+    // index from each event.
+    std::map<tstring, unsigned> dictIndex;
+    std::vector<tstring const *> dict;
+
+    auto const intern = [&] (tstring const & str) -> unsigned
+    {
+        auto const res = dictIndex.emplace (str,
+            static_cast<unsigned>(dict.size ()));
+        if (res.second)
+            dict.push_back (&res.first->first);
+        return res.first->second;
+    };
+
+    struct EventRefs { unsigned logger, thr, file, func; };
+    std::vector<EventRefs> refs;
+    refs.reserve (count);
+
+    std::size_t size = 2 + stringWireSize (serverName)
+        + 2 * sizeof (unsigned int);
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        spi::InternalLoggingEvent const & event = events[i];
+        refs.push_back (EventRefs {
+            intern (event.getLoggerName ()),
+            intern (event.getThread ()),
+            intern (event.getFile ()),
+            intern (event.getFunction ()) });
+        size += 8 * sizeof (unsigned int)
+            + stringWireSize (event.getNDC ())
+            + stringWireSize (event.getMessage ());
+    }
+
+    for (tstring const * entry : dict)
+        size += stringWireSize (*entry);
+
+    std::unique_ptr<SocketBuffer> buffer (new SocketBuffer (size));
+    buffer->appendByte (LOG4CPLUS_BATCH_MESSAGE_VERSION);
+#ifndef UNICODE
+    buffer->appendByte (1);
+#else
+    buffer->appendByte (2);
+#endif
+
+    buffer->appendString (serverName);
+
+    buffer->appendInt (static_cast<unsigned>(dict.size ()));
+    for (tstring const * entry : dict)
+        buffer->appendString (*entry);
+
+    buffer->appendInt (static_cast<unsigned>(count));
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        spi::InternalLoggingEvent const & event = events[i];
+        buffer->appendInt (refs[i].logger);
+        buffer->appendInt (event.getLogLevel ());
+        buffer->appendString (event.getNDC ());
+        buffer->appendString (event.getMessage ());
+        buffer->appendInt (refs[i].thr);
+        buffer->appendInt (
+            static_cast<unsigned int>(to_time_t (event.getTimestamp ())));
+        buffer->appendInt (
+            static_cast<unsigned int>(
+                microseconds_part (event.getTimestamp ())));
+        buffer->appendInt (refs[i].file);
+        buffer->appendInt (event.getLine ());
+        buffer->appendInt (refs[i].func);
+    }
+
+    return buffer;
+}
+
+
+void
+readBatchFromBuffer (SocketBuffer& buffer,
+    std::vector<spi::InternalLoggingEvent>& events)
+{
+    unsigned char msgVersion = buffer.readByte ();
+    if (msgVersion != LOG4CPLUS_BATCH_MESSAGE_VERSION)
+    {
+        LogLog::getLogLog ()->warn (
+            LOG4CPLUS_TEXT ("readBatchFromBuffer() received socket message")
+            LOG4CPLUS_TEXT (" with an invalid version"));
+        return;
+    }
+
+    unsigned char sizeOfChar = buffer.readByte ();
+
+    // Like in readFromBuffer(), all fields--including the dictionary
+    // entries--are parsed as views into the receive buffer and only
+    // copied once, by the event constructor, into the events' own
+    // storage. The deque provides stable backing storage for entries
+    // that needed a character conversion.
+    tstring scratch;
+    tstring_view serverName = buffer.readStringView (sizeOfChar, scratch);
+
+    unsigned const dictSize = buffer.readInt ();
+    std::vector<tstring_view> dict;
+    std::deque<tstring> dictScratch;
+    dict.reserve (dictSize);
+    for (unsigned i = 0; i != dictSize; ++i)
+    {
+        dictScratch.emplace_back ();
+        dict.push_back (buffer.readStringView (sizeOfChar,
+            dictScratch.back ()));
+    }
+
+    auto const lookup = [&] (unsigned idx) -> tstring_view
+    {
+        return idx < dict.size () ? dict[idx] : tstring_view ();
+    };
+
+    unsigned const eventCount = buffer.readInt ();
+    events.reserve (events.size () + eventCount);
+    for (unsigned i = 0; i != eventCount; ++i)
+    {
+        tstring_view loggerName = lookup (buffer.readInt ());
+        LogLevel ll = buffer.readInt ();
+        tstring ndcScratch;
+        tstring_view ndc = buffer.readStringView (sizeOfChar, ndcScratch);
+        tstring ndcStorage;
+        if (! serverName.empty ())
+        {
+            if (ndc.empty ())
+                ndc = serverName;
+            else
+            {
+                ndcStorage.reserve (serverName.size () + 3 + ndc.size ());
+                ndcStorage.append (serverName.data (), serverName.size ());
+                ndcStorage.append (LOG4CPLUS_TEXT (" - "));
+                ndcStorage.append (ndc.data (), ndc.size ());
+                ndc = ndcStorage;
+            }
+        }
+        tstring msgScratch;
+        tstring_view message = buffer.readStringView (sizeOfChar,
+            msgScratch);
+        tstring_view thread = lookup (buffer.readInt ());
+        long sec = buffer.readInt ();
+        long usec = buffer.readInt ();
+        tstring_view file = lookup (buffer.readInt ());
+        int line = buffer.readInt ();
+        tstring_view function = lookup (buffer.readInt ());
+
+        // TODO: Pass MDC through.
+        events.push_back (spi::InternalLoggingEvent (loggerName, ll, ndc,
+            MappedDiagnosticContextMap (), message, thread,
+            internal::empty_str,
+            from_time_t (sec) + chrono::microseconds (usec), file,
+            line, function));
+    }
+}
+
+
 } // namespace helpers
 
 
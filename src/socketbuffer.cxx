@@ -20,6 +20,7 @@
 
 #include <cstring>
 #include <limits>
+#include <utility>
 #include <log4cplus/helpers/socketbuffer.h>
 #include <log4cplus/helpers/loglog.h>
 
@@ -51,16 +52,96 @@ namespace log4cplus::helpers {
 
 SocketBuffer::SocketBuffer(std::size_t maxsize_)
 : maxsize(maxsize_),
+  capacity(maxsize_),
   size(0),
   pos(0),
-  buffer(new char[maxsize])
+  buffer(new char[maxsize]),
+  owned(true)
 {
 }
 
 
+SocketBuffer::SocketBuffer(char * data, std::size_t size_)
+: maxsize(size_),
+  capacity(0),
+  size(size_),
+  pos(0),
+  buffer(data),
+  owned(false)
+{
+}
+
+
+SocketBuffer::SocketBuffer(SocketBuffer && rhs) noexcept
+: maxsize(rhs.maxsize),
+  capacity(rhs.capacity),
+  size(rhs.size),
+  pos(rhs.pos),
+  buffer(rhs.buffer),
+  owned(rhs.owned)
+{
+    rhs.maxsize = 0;
+    rhs.capacity = 0;
+    rhs.size = 0;
+    rhs.pos = 0;
+    rhs.buffer = nullptr;
+    rhs.owned = false;
+}
+
+
+SocketBuffer &
+SocketBuffer::operator= (SocketBuffer && rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        if (owned)
+            delete [] buffer;
+
+        maxsize = rhs.maxsize;
+        capacity = rhs.capacity;
+        size = rhs.size;
+        pos = rhs.pos;
+        buffer = rhs.buffer;
+        owned = rhs.owned;
+
+        rhs.maxsize = 0;
+        rhs.capacity = 0;
+        rhs.size = 0;
+        rhs.pos = 0;
+        rhs.buffer = nullptr;
+        rhs.owned = false;
+    }
+
+    return *this;
+}
+
+
 SocketBuffer::~SocketBuffer()
 {
-    delete [] buffer;
+    if (owned)
+        delete [] buffer;
+}
+
+
+void
+SocketBuffer::reserve(std::size_t max)
+{
+    if (max > capacity)
+    {
+        // The contents are discarded anyway, so allocate fresh
+        // storage instead of a copying reallocation and skip any
+        // initialization of it.
+        if (owned)
+            delete [] buffer;
+
+        buffer = new char[max];
+        capacity = max;
+        owned = true;
+    }
+
+    maxsize = max;
+    size = 0;
+    pos = 0;
 }
 
 
@@ -191,6 +272,40 @@ SocketBuffer::readString(unsigned char sizeOfChar)
 }
 
 
+tstring_view
+SocketBuffer::readStringView(unsigned char sizeOfChar, tstring & scratch)
+{
+#ifndef UNICODE
+    if(sizeOfChar == 1) {
+        std::size_t strlen = readInt();
+
+        if(strlen == 0) {
+            return tstring_view();
+        }
+        if(pos > maxsize) {
+            getLogLog().error(LOG4CPLUS_TEXT("SocketBuffer::readStringView()- end of buffer reached"));
+            return tstring_view();
+        }
+
+        if((pos + strlen) > maxsize) {
+            getLogLog().error(LOG4CPLUS_TEXT("SocketBuffer::readStringView()- Attempt to read beyond end of buffer"));
+            strlen = (maxsize - 1) - pos;
+        }
+
+        tstring_view const ret(&buffer[pos], strlen);
+        pos += strlen;
+        return ret;
+    }
+#endif
+
+    // The wire character size does not match the native tchar or a
+    // byte order conversion is needed; fall back to converting into
+    // the caller provided scratch string.
+    scratch = readString(sizeOfChar);
+    return tstring_view(scratch);
+}
+
+
 
 void
 SocketBuffer::appendByte(unsigned char val)
@@ -321,6 +436,43 @@ CATCH_TEST_CASE ("SocketBuffer", "[sockets]")
 
         CATCH_REQUIRE_THROWS (small_sb.appendByte (1));
     }
+
+    CATCH_SECTION ("move transfers the storage")
+    {
+        small_sb.appendByte (42);
+        char * const storage = small_sb.getBuffer ();
+
+        SocketBuffer moved_sb (std::move (small_sb));
+        CATCH_REQUIRE (moved_sb.getBuffer () == storage);
+        CATCH_REQUIRE (moved_sb.getSize () == 1);
+        CATCH_REQUIRE (moved_sb.readByte () == 42);
+        CATCH_REQUIRE (! small_sb.getBuffer ());
+    }
+
+    CATCH_SECTION ("reserve keeps large enough storage")
+    {
+        char * const storage = small_sb.getBuffer ();
+
+        small_sb.reserve (SMALL_BUFFER_SIZE - 1);
+        CATCH_REQUIRE (small_sb.getBuffer () == storage);
+        CATCH_REQUIRE (small_sb.getMaxSize () == SMALL_BUFFER_SIZE - 1);
+        CATCH_REQUIRE (small_sb.getPos () == 0);
+        CATCH_REQUIRE (small_sb.getSize () == 0);
+
+        small_sb.reserve (2 * SMALL_BUFFER_SIZE);
+        CATCH_REQUIRE (small_sb.getMaxSize () == 2 * SMALL_BUFFER_SIZE);
+    }
+
+    CATCH_SECTION ("wrapping buffer reads without copying")
+    {
+        small_sb.appendInt (0xCAFEBABE);
+
+        SocketBuffer wrapped_sb (small_sb.getBuffer (),
+            small_sb.getSize ());
+        CATCH_REQUIRE (wrapped_sb.getBuffer () == small_sb.getBuffer ());
+        CATCH_REQUIRE (wrapped_sb.getSize () == small_sb.getSize ());
+        CATCH_REQUIRE (wrapped_sb.readInt () == 0xCAFEBABE);
+    }
 }
 #endif
 
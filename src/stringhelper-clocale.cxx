@@ -36,6 +36,8 @@ namespace log4cplus::helpers
 
 
 void clear_mbstate (std::mbstate_t & mbs);
+bool towstring_ascii (std::wstring &, char const *, std::size_t);
+bool tostring_ascii (std::string &, wchar_t const *, std::size_t);
 
 
 #if defined (LOG4CPLUS_WORKING_C_LOCALE)
@@ -44,6 +46,9 @@ static
 void
 tostring_internal (std::string & result, wchar_t const * src, std::size_t size)
 {
+    if (tostring_ascii (result, src, size))
+        return;
+
     std::vector<char> result_buf (MB_CUR_MAX);
 
     wchar_t const * src_it = src;
@@ -105,6 +110,9 @@ static
 void
 towstring_internal (std::wstring & result, char const * src, std::size_t size)
 {
+    if (towstring_ascii (result, src, size))
+        return;
+
     char const * src_it = src;
     char const * const src_end_it = src + size;
 
@@ -40,6 +40,8 @@ namespace log4cplus::helpers
 {
 
 void clear_mbstate (std::mbstate_t &);
+bool towstring_ascii (std::wstring &, char const *, std::size_t);
+bool tostring_ascii (std::string &, wchar_t const *, std::size_t);
 
 #ifdef LOG4CPLUS_WORKING_LOCALE
 
@@ -54,6 +56,9 @@ towstring_internal (std::wstring & outstr, const char * src, std::size_t size,
         return;
     }
 
+    if (towstring_ascii (outstr, src, size))
+        return;
+
     typedef std::codecvt<wchar_t, char, std::mbstate_t> CodeCvt;
     const CodeCvt & cdcvt = std::use_facet<CodeCvt>(loc);
     std::mbstate_t state;
@@ -152,6 +157,9 @@ tostring_internal (std::string & outstr, const wchar_t * src, std::size_t size,
         return;
     }
 
+    if (tostring_ascii (outstr, src, size))
+        return;
+
     typedef std::codecvt<wchar_t, char, std::mbstate_t> CodeCvt;
     const CodeCvt & cdcvt = std::use_facet<CodeCvt>(loc);
     std::mbstate_t state;
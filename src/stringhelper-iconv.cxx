@@ -61,6 +61,9 @@ namespace log4cplus
 namespace helpers
 {
 
+bool towstring_ascii (std::wstring &, char const *, std::size_t);
+bool tostring_ascii (std::string &, wchar_t const *, std::size_t);
+
 namespace
 {
 
@@ -124,6 +127,14 @@ struct iconv_handle
         return call_iconv (iconv, inbuf, inbytesleft, outbuf, outbytesleft);
     }
 
+    //! Returns the descriptor to its initial shift state so that it
+    //! can be reused for an unrelated conversion.
+    void
+    reset ()
+    {
+        do_iconv (nullptr, nullptr, nullptr, nullptr);
+    }
+
     iconv_t handle;
 };
 
@@ -158,13 +169,19 @@ void
 iconv_conv (std::basic_string<DestType> & result, char const * destenc,
     SrcType const * src, std::size_t size, char const * srcenc)
 {
-    iconv_handle cvt (destenc, srcenc);
+    // Each instantiation of this template is only ever called with a
+    // single encoding pair, so the descriptor opened on the thread's
+    // first conversion can be kept and reused; iconv_open() and
+    // iconv_close() per call would otherwise dominate short
+    // conversions.
+    thread_local iconv_handle cvt (destenc, srcenc);
     if (cvt.handle == iconv_error_handle)
     {
         // TODO: Better error handling.
         result.resize (0);
         return;
     }
+    cvt.reset ();
 
     typedef DestType outbuf_type;
     typedef SrcType inbuf_type;
@@ -230,7 +247,8 @@ std::string
 tostring (const std::wstring_view & src)
 {
     std::string ret;
-    iconv_conv (ret, "UTF-8", src.data (), src.size (), "WCHAR_T");
+    if (! tostring_ascii (ret, src.data (), src.size ()))
+        iconv_conv (ret, "UTF-8", src.data (), src.size (), "WCHAR_T");
     return ret;
 }
 
@@ -239,7 +257,8 @@ std::string
 tostring (const std::wstring & src)
 {
     std::string ret;
-    iconv_conv (ret, "UTF-8", src.c_str (), src.size (), "WCHAR_T");
+    if (! tostring_ascii (ret, src.c_str (), src.size ()))
+        iconv_conv (ret, "UTF-8", src.c_str (), src.size (), "WCHAR_T");
     return ret;
 }
 
@@ -249,7 +268,9 @@ tostring (wchar_t const * src)
 {
     assert (src);
     std::string ret;
-    iconv_conv (ret, "UTF-8", src, std::wcslen (src), "WCHAR_T");
+    std::size_t const size = std::wcslen (src);
+    if (! tostring_ascii (ret, src, size))
+        iconv_conv (ret, "UTF-8", src, size, "WCHAR_T");
     return ret;
 }
 
@@ -258,7 +279,8 @@ std::wstring
 towstring (const std::string_view& src)
 {
     std::wstring ret;
-    iconv_conv (ret, "WCHAR_T", src.data (), src.size (), "UTF-8");
+    if (! towstring_ascii (ret, src.data (), src.size ()))
+        iconv_conv (ret, "WCHAR_T", src.data (), src.size (), "UTF-8");
     return ret;
 }
 
@@ -267,7 +289,8 @@ std::wstring
 towstring (const std::string& src)
 {
     std::wstring ret;
-    iconv_conv (ret, "WCHAR_T", src.c_str (), src.size (), "UTF-8");
+    if (! towstring_ascii (ret, src.c_str (), src.size ()))
+        iconv_conv (ret, "WCHAR_T", src.c_str (), src.size (), "UTF-8");
     return ret;
 }
 
@@ -277,7 +300,9 @@ towstring (char const * src)
 {
     assert (src);
     std::wstring ret;
-    iconv_conv (ret, "WCHAR_T", src, std::strlen (src), "UTF-8");
+    std::size_t const size = std::strlen (src);
+    if (! towstring_ascii (ret, src, size))
+        iconv_conv (ret, "WCHAR_T", src, size, "UTF-8");
     return ret;
 }
 
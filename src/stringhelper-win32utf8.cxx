@@ -0,0 +1,168 @@
+//  Copyright (C) 2010-2017, Vaclav Haisman. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modifica-
+//  tion, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of  source code must  retain the above copyright  notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED WARRANTIES,
+//  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS  FOR A PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN NO  EVENT SHALL  THE
+//  APACHE SOFTWARE  FOUNDATION  OR ITS CONTRIBUTORS  BE LIABLE FOR  ANY DIRECT,
+//  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY, OR CONSEQUENTIAL  DAMAGES (INCLU-
+//  DING, BUT NOT LIMITED TO, PROCUREMENT  OF SUBSTITUTE GOODS OR SERVICES; LOSS
+//  OF USE, DATA, OR  PROFITS; OR BUSINESS  INTERRUPTION)  HOWEVER CAUSED AND ON
+//  ANY  THEORY OF LIABILITY,  WHETHER  IN CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT OF THE  USE OF
+//  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <log4cplus/helpers/stringhelper.h>
+
+// Character conversion backend of the UTF-8 native Windows build
+// (LOG4CPLUS_UTF8_NATIVE): narrow strings hold UTF-8, so the
+// conversions at the wide API boundary are a fixed CP_UTF8 transcoding
+// instead of a locale dependent one. MultiByteToWideChar() and
+// WideCharToMultiByte() are stateless, so unlike the locale backends
+// there is no converter object to create or cache per call.
+
+#if defined (_WIN32) && defined (LOG4CPLUS_UTF8_NATIVE)
+
+#include <cassert>
+#include <cstring>
+#include <cwchar>
+
+#include <windows.h>
+
+
+namespace log4cplus
+{
+
+namespace helpers
+{
+
+
+bool towstring_ascii (std::wstring &, char const *, std::size_t);
+bool tostring_ascii (std::string &, wchar_t const *, std::size_t);
+
+
+namespace
+{
+
+
+static
+void
+utf8_to_wide (std::wstring & outstr, char const * src, std::size_t size)
+{
+    outstr.clear ();
+    if (size == 0)
+        return;
+
+    int const src_size = static_cast<int>(size);
+    int const out_size = MultiByteToWideChar (CP_UTF8, 0, src, src_size,
+        nullptr, 0);
+    if (out_size <= 0)
+        return;
+
+    outstr.resize (static_cast<std::size_t>(out_size));
+    MultiByteToWideChar (CP_UTF8, 0, src, src_size, &outstr[0], out_size);
+}
+
+
+static
+void
+wide_to_utf8 (std::string & outstr, wchar_t const * src, std::size_t size)
+{
+    outstr.clear ();
+    if (size == 0)
+        return;
+
+    int const src_size = static_cast<int>(size);
+    int const out_size = WideCharToMultiByte (CP_UTF8, 0, src, src_size,
+        nullptr, 0, nullptr, nullptr);
+    if (out_size <= 0)
+        return;
+
+    outstr.resize (static_cast<std::size_t>(out_size));
+    WideCharToMultiByte (CP_UTF8, 0, src, src_size, &outstr[0], out_size,
+        nullptr, nullptr);
+}
+
+
+} // namespace
+
+
+std::string
+tostring (const std::wstring_view & src)
+{
+    std::string ret;
+    if (! tostring_ascii (ret, src.data (), src.size ()))
+        wide_to_utf8 (ret, src.data (), src.size ());
+    return ret;
+}
+
+
+std::string
+tostring (const std::wstring & src)
+{
+    std::string ret;
+    if (! tostring_ascii (ret, src.c_str (), src.size ()))
+        wide_to_utf8 (ret, src.c_str (), src.size ());
+    return ret;
+}
+
+
+std::string
+tostring (wchar_t const * src)
+{
+    assert (src);
+    std::string ret;
+    std::size_t const size = std::wcslen (src);
+    if (! tostring_ascii (ret, src, size))
+        wide_to_utf8 (ret, src, size);
+    return ret;
+}
+
+
+std::wstring
+towstring (const std::string_view & src)
+{
+    std::wstring ret;
+    if (! towstring_ascii (ret, src.data (), src.size ()))
+        utf8_to_wide (ret, src.data (), src.size ());
+    return ret;
+}
+
+
+std::wstring
+towstring (const std::string & src)
+{
+    std::wstring ret;
+    if (! towstring_ascii (ret, src.c_str (), src.size ()))
+        utf8_to_wide (ret, src.c_str (), src.size ());
+    return ret;
+}
+
+
+std::wstring
+towstring (char const * src)
+{
+    assert (src);
+    std::wstring ret;
+    std::size_t const size = std::strlen (src);
+    if (! towstring_ascii (ret, src, size))
+        utf8_to_wide (ret, src, size);
+    return ret;
+}
+
+
+} // namespace helpers
+
+} // namespace log4cplus
+
+#endif // _WIN32 && LOG4CPLUS_UTF8_NATIVE
@@ -24,6 +24,7 @@
 
 #include <iterator>
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <cwchar>
 #include <cwctype>
@@ -75,12 +76,59 @@ clear_mbstate (std::mbstate_t & mbs)
 }
 
 
+//! ASCII fast path shared by all character conversion backends.
+//! ASCII code units map 1:1 between the narrow and wide encodings
+//! every backend handles, so for a pure ASCII input -- the vast
+//! majority of log messages -- the whole codecvt/iconv machinery can
+//! be skipped in favour of a plain widening copy. The scan tests
+//! eight bytes at a time and both loops compile down to vector
+//! instructions on mainstream compilers. Returns false without a
+//! defined outstr value when a non-ASCII unit is found; the caller
+//! then redoes the conversion through its usual slow path.
+bool
+towstring_ascii (std::wstring & outstr, char const * src, std::size_t size)
+{
+    std::uint64_t chunk;
+    std::size_t i = 0;
+    for (; i + sizeof (chunk) <= size; i += sizeof (chunk))
+    {
+        std::memcpy (&chunk, src + i, sizeof (chunk));
+        if (chunk & UINT64_C (0x8080808080808080))
+            return false;
+    }
+    for (; i != size; ++i)
+        if (static_cast<unsigned char>(src[i]) >= 0x80u)
+            return false;
+
+    outstr.resize (size);
+    std::copy (src, src + size, outstr.begin ());
+    return true;
+}
+
+
+//! Narrowing counterpart of towstring_ascii().
+bool
+tostring_ascii (std::string & outstr, wchar_t const * src, std::size_t size)
+{
+    for (std::size_t i = 0; i != size; ++i)
+        if (static_cast<std::uint32_t>(src[i]) >= 0x80u)
+            return false;
+
+    outstr.resize (size);
+    std::copy (src, src + size, outstr.begin ());
+    return true;
+}
+
+
 #if defined (LOG4CPLUS_POOR_MANS_CHCONV)
 
 static
 void
 tostring_internal (std::string & ret, wchar_t const * src, std::size_t size)
 {
+    if (tostring_ascii (ret, src, size))
+        return;
+
     ret.resize(size);
     for (std::size_t i = 0; i < size; ++i)
     {
@@ -125,6 +173,9 @@ static
 void
 towstring_internal (std::wstring & ret, char const * src, std::size_t size)
 {
+    if (towstring_ascii (ret, src, size))
+        return;
+
     ret.resize(size);
     for (std::size_t i = 0; i < size; ++i)
     {
@@ -206,6 +257,42 @@ struct tolower_func
 } // namespace
 
 
+namespace
+{
+
+
+//! Branchless ASCII case conversion over the whole string. The loop
+//! carries no data dependent branches so compilers vectorize it; the
+//! accumulator records whether any non-ASCII character was seen so
+//! that the caller can redo the conversion with the locale aware
+//! per-character functions in that (rare) case.
+template <typename Func>
+static
+tstring
+transform_ascii (tstring_view const & s, tchar from_lo, tchar from_hi,
+    tchar delta, Func fallback)
+{
+    typedef std::char_traits<tchar> traits;
+
+    tstring ret (s);
+    traits::int_type acc = 0;
+    for (tchar & ch : ret)
+    {
+        acc |= traits::to_int_type (ch);
+        if (ch >= from_lo && ch <= from_hi)
+            ch = static_cast<tchar>(ch + delta);
+    }
+
+    if (LOG4CPLUS_UNLIKELY (acc > 127))
+        std::transform (s.begin (), s.end (), ret.begin (), fallback);
+
+    return ret;
+}
+
+
+} // namespace
+
+
 tchar
 toUpper (tchar ch)
 {
@@ -216,10 +303,8 @@ toUpper (tchar ch)
 tstring
 toUpper(const tstring_view& s)
 {
-    tstring ret;
-    std::transform(s.begin(), s.end(), std::back_inserter (ret),
-        toupper_func ());
-    return ret;
+    return transform_ascii (s, LOG4CPLUS_TEXT ('a'), LOG4CPLUS_TEXT ('z'),
+        LOG4CPLUS_TEXT ('A') - LOG4CPLUS_TEXT ('a'), toupper_func ());
 }
 
 
@@ -233,10 +318,8 @@ toLower (tchar ch)
 tstring
 toLower(const tstring_view& s)
 {
-    tstring ret;
-    std::transform(s.begin(), s.end(), std::back_inserter (ret),
-        tolower_func ());
-    return ret;
+    return transform_ascii (s, LOG4CPLUS_TEXT ('A'), LOG4CPLUS_TEXT ('Z'),
+        LOG4CPLUS_TEXT ('a') - LOG4CPLUS_TEXT ('A'), tolower_func ());
 }
 
 
@@ -458,6 +541,53 @@ CATCH_TEST_CASE( "Strings helpers", "[strings]" )
         }
     }
 
+    CATCH_SECTION ("case conversion")
+    {
+        CATCH_SECTION ("ASCII")
+        {
+            CATCH_REQUIRE (toUpper (
+                tstring_view (LOG4CPLUS_TEXT ("mIxEd 09, case!")))
+                == LOG4CPLUS_TEXT ("MIXED 09, CASE!"));
+            CATCH_REQUIRE (toLower (
+                tstring_view (LOG4CPLUS_TEXT ("mIxEd 09, case!")))
+                == LOG4CPLUS_TEXT ("mixed 09, case!"));
+        }
+
+        CATCH_SECTION ("non-ASCII falls back to locale aware path")
+        {
+            tstring str (LOG4CPLUS_TEXT ("abc"));
+            str += static_cast<tchar>(0xFF);
+            tstring expected;
+            std::transform (str.begin (), str.end (),
+                std::back_inserter (expected), toupper_func ());
+            CATCH_REQUIRE (toUpper (tstring_view (str)) == expected);
+        }
+    }
+
+    CATCH_SECTION ("narrow/wide conversion")
+    {
+        CATCH_SECTION ("ASCII round trip")
+        {
+            // Longer than one 8 byte block so that both the block
+            // scan and the tail scan run.
+            std::string const narrow (19, 'a');
+            std::wstring const wide (19, L'a');
+            CATCH_REQUIRE (towstring (narrow) == wide);
+            CATCH_REQUIRE (tostring (wide) == narrow);
+        }
+
+#if defined (LOG4CPLUS_POOR_MANS_CHCONV)
+        CATCH_SECTION ("non-ASCII falls back to the slow path")
+        {
+            std::string narrow (9, 'x');
+            narrow += static_cast<char>(0x80);
+            std::wstring expected (9, L'x');
+            expected += L'?';
+            CATCH_REQUIRE (towstring (narrow) == expected);
+        }
+#endif
+    }
+
     CATCH_SECTION ("convert integer to string")
     {
 
@@ -26,6 +26,8 @@
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/internal/env.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
+#include <algorithm>
+#include <array>
 #include <cstring>
 
 #if defined (LOG4CPLUS_HAVE_SYSLOG_H)
@@ -101,6 +103,53 @@ int const fallback_facility = 0;
 #endif
 
 
+static
+int
+mapSysLogLevel (LogLevel ll)
+{
+    if(ll < INFO_LOG_LEVEL /* || ll < DEBUG_LOG_LEVEL*/) {
+        return LOG_DEBUG;
+    }
+    else if(ll < WARN_LOG_LEVEL) {
+        return LOG_INFO;
+    }
+    else if(ll < ERROR_LOG_LEVEL) {
+        return LOG_WARNING;
+    }
+    else if(ll < FATAL_LOG_LEVEL) {
+        return LOG_ERR;
+    }
+    else if(ll == FATAL_LOG_LEVEL) {
+        return LOG_CRIT;
+    }
+
+    return LOG_ALERT;  // ll > FATAL_LOG_LEVEL
+}
+
+
+// Level to syslog priority mapping precomputed at a granularity of
+// 1000 LogLevel units per bucket; 64 buckets cover the whole range
+// from TRACE_LOG_LEVEL (0) past OFF_LOG_LEVEL (60000). All standard
+// levels are multiples of 10000 so the table reproduces
+// mapSysLogLevel() exactly for them.
+static std::size_t const syslog_level_bucket = 1000;
+static std::size_t const syslog_level_table_size = 64;
+
+static
+std::array<int, syslog_level_table_size>
+buildSysLogLevelTable ()
+{
+    std::array<int, syslog_level_table_size> table;
+    for (std::size_t i = 0; i != syslog_level_table_size; ++i)
+        table[i] = mapSysLogLevel (
+            static_cast<LogLevel>(i * syslog_level_bucket));
+    return table;
+}
+
+static std::array<int, syslog_level_table_size> const syslog_level_table (
+    buildSysLogLevelTable ());
+
+
 static
 int
 parseFacility (const tstring& text)
@@ -351,23 +400,10 @@ SysLogAppender::close()
 int
 SysLogAppender::getSysLogLevel(const LogLevel& ll) const
 {
-    if(ll < INFO_LOG_LEVEL /* || ll < DEBUG_LOG_LEVEL*/) {
-        return LOG_DEBUG;
-    }
-    else if(ll < WARN_LOG_LEVEL) {
-        return LOG_INFO;
-    }
-    else if(ll < ERROR_LOG_LEVEL) {
-        return LOG_WARNING;
-    }
-    else if(ll < FATAL_LOG_LEVEL) {
-        return LOG_ERR;
-    }
-    else if(ll == FATAL_LOG_LEVEL) {
-        return LOG_CRIT;
-    }
-
-    return LOG_ALERT;  // ll > FATAL_LOG_LEVEL
+    std::size_t const index = ll <= 0 ? 0
+        : (std::min) (static_cast<std::size_t>(ll) / syslog_level_bucket,
+            syslog_level_table_size - 1);
+    return syslog_level_table[index];
 }
 
 
@@ -400,49 +436,85 @@ tstring const SysLogAppender::remoteTimeFormat (
     LOG4CPLUS_TEXT ("%Y-%m-%dT%H:%M:%S.%qZ"));
 
 
-void
-SysLogAppender::appendRemote(const spi::InternalLoggingEvent& event)
+bool
+SysLogAppender::ensureConnected ()
 {
+    if (connected)
+        return true;
 
-    if (! connected)
-    {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-        connector->trigger ();
-        return;
+    connector->trigger ();
+    return false;
 
 #else
-        openSocket ();
-        if (! connected)
-        {
-            helpers::getLogLog ().error (
-                LOG4CPLUS_TEXT ("SysLogAppender")
-                LOG4CPLUS_TEXT ("- failed to connect to ")
-                + host + LOG4CPLUS_TEXT (":")
-                + helpers::convertIntegerToString (port));
-            return;
-        }
-#endif
+    openSocket ();
+    if (! connected)
+    {
+        helpers::getLogLog ().error (
+            LOG4CPLUS_TEXT ("SysLogAppender")
+            LOG4CPLUS_TEXT ("- failed to connect to ")
+            + host + LOG4CPLUS_TEXT (":")
+            + helpers::convertIntegerToString (port));
+        return false;
     }
 
+    return true;
+#endif
+}
+
+
+void
+SysLogAppender::formatRemoteEvent (const spi::InternalLoggingEvent& event)
+{
     int const level = getSysLogLevel(event.getLogLevel());
     internal::appender_sratch_pad & appender_sp = internal::get_appender_sp ();
     detail::clear_tostringstream (appender_sp.oss);
 
+    // The HOSTNAME, APP-NAME and PROCID fields are constant for the
+    // lifetime of this appender; format them once.
+    if (staticHeaderFields.empty ())
+    {
+        tostringstream oss;
+        oss
+            // HOSTNAME
+            << LOG4CPLUS_TEXT (' ') << hostname
+            // APP-NAME
+            << LOG4CPLUS_TEXT (' ') << ident
+            // PROCID
+            << LOG4CPLUS_TEXT (' ') << internal::get_process_id ();
+        staticHeaderFields = oss.str ();
+    }
+
+    // The seconds part of the TIMESTAMP field changes at most once
+    // per second; only the millisecond fraction is formatted per
+    // event.
+    helpers::Time const timestamp = event.getTimestamp ();
+    helpers::Time const second = helpers::truncate_fractions (timestamp);
+    if (cachedSecondStr.empty () || second != cachedSecond)
+    {
+        static tstring const seconds_format (
+            LOG4CPLUS_TEXT ("%Y-%m-%dT%H:%M:%S"));
+        cachedSecondStr = helpers::getFormattedTime (seconds_format, second,
+            true);
+        cachedSecond = second;
+    }
+    long const msec = helpers::microseconds_part (timestamp) / 1000;
+
     appender_sp.oss
         // PRI
         << LOG4CPLUS_TEXT ('<') << (level | facility) << LOG4CPLUS_TEXT ('>')
         // VERSION
         << 1
         // TIMESTAMP
-        << LOG4CPLUS_TEXT (' ')
-        << helpers::getFormattedTime (remoteTimeFormat, event.getTimestamp (),
-            true)
-        // HOSTNAME
-        << LOG4CPLUS_TEXT (' ') << hostname
-        // APP-NAME
-        << LOG4CPLUS_TEXT (' ') << ident
-        // PROCID
-        << LOG4CPLUS_TEXT (' ') << internal::get_process_id ()
+        << LOG4CPLUS_TEXT (' ') << cachedSecondStr << LOG4CPLUS_TEXT ('.');
+    if (msec < 100)
+        appender_sp.oss << LOG4CPLUS_TEXT ('0');
+    if (msec < 10)
+        appender_sp.oss << LOG4CPLUS_TEXT ('0');
+    appender_sp.oss
+        << msec << LOG4CPLUS_TEXT ('Z')
+        // HOSTNAME, APP-NAME, PROCID
+        << staticHeaderFields
         // MSGID
         << LOG4CPLUS_TEXT (' ') << event.getLoggerName ()
         // STRUCTURED-DATA
@@ -451,7 +523,18 @@ SysLogAppender::appendRemote(const spi::InternalLoggingEvent& event)
 
     // MSG
     layout->formatAndAppend (appender_sp.oss, event);
+}
+
+
+void
+SysLogAppender::appendRemote(const spi::InternalLoggingEvent& event)
+{
+    if (! ensureConnected ())
+        return;
 
+    formatRemoteEvent (event);
+
+    internal::appender_sratch_pad & appender_sp = internal::get_appender_sp ();
     appender_sp.chstr = LOG4CPLUS_TSTRING_TO_STRING (appender_sp.oss.str ());
 
     if (remoteSyslogType != RSTUdp)
@@ -481,6 +564,55 @@ SysLogAppender::appendRemote(const spi::InternalLoggingEvent& event)
 }
 
 
+void
+SysLogAppender::appendBatch (const spi::InternalLoggingEvent* events,
+    std::size_t count)
+{
+    // Only remote TCP syslog can coalesce several octet counted
+    // frames into one stream write; UDP needs one datagram per
+    // message and the local syslog() API takes one message per call.
+    if (appendFunc != &SysLogAppender::appendRemote
+        || remoteSyslogType == RSTUdp)
+    {
+        Appender::appendBatch (events, count);
+        return;
+    }
+
+    if (! ensureConnected ())
+        return;
+
+    internal::appender_sratch_pad & appender_sp = internal::get_appender_sp ();
+    std::string batch;
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        formatRemoteEvent (events[i]);
+        appender_sp.chstr
+            = LOG4CPLUS_TSTRING_TO_STRING (appender_sp.oss.str ());
+
+        // see (RFC6587, 3.4.1 Octet
+        // Counting)[http://tools.ietf.org/html/rfc6587#section-3.4.1]
+        batch += helpers::convertIntegerToNarrowString (
+            appender_sp.chstr.size ());
+        batch += ' ';
+        batch += appender_sp.chstr;
+    }
+
+    bool ret = syslogSocket.write (batch);
+    if (! ret)
+    {
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("SysLogAppender::appendBatch")
+            LOG4CPLUS_TEXT ("- socket write failed"));
+
+        connected = false;
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+        connector->trigger ();
+#endif
+    }
+}
+
+
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
 thread::Mutex const &
 SysLogAppender::ctcGetAccessMutex () const
@@ -45,6 +45,9 @@
 #  include <pthread.h>
 #  include <sched.h>
 #  include <signal.h>
+#  if defined (__linux__)
+#    include <sys/resource.h>
+#  endif
 #elif defined (LOG4CPLUS_USE_WIN32_THREADS)
 #  include <process.h>
 #endif
@@ -62,9 +65,12 @@
 #include <log4cplus/thread/impl/tls.h>
 #include <log4cplus/ndc.h>
 #include <log4cplus/helpers/loglog.h>
+#include <log4cplus/helpers/property.h>
 #include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/internal/internal.h>
+#include <cstdlib>
+#include <iterator>
 
 #endif // LOG4CPLUS_SINGLE_THREADED
 
@@ -97,10 +103,10 @@ yield()
 }
 
 #if defined(LOG4CPLUS_SINGLE_THREADED)
-static log4cplus::tstring thread_name
+static ThreadNamePtr thread_name
     LOG4CPLUS_INIT_PRIORITY (LOG4CPLUS_INIT_PRIORITY_BASE - 1)
-    (LOG4CPLUS_TEXT("single"));
-static log4cplus::tstring thread_name2
+    (std::make_shared<log4cplus::tstring const> (LOG4CPLUS_TEXT("single")));
+static ThreadNamePtr thread_name2
     LOG4CPLUS_INIT_PRIORITY (LOG4CPLUS_INIT_PRIORITY_BASE - 1)
     (thread_name);
 #endif
@@ -108,20 +114,29 @@ static log4cplus::tstring thread_name2
 LOG4CPLUS_EXPORT
 log4cplus::tstring const &
 getCurrentThreadName()
+{
+    return *getCurrentThreadNamePtr ();
+}
+
+
+LOG4CPLUS_EXPORT
+ThreadNamePtr const &
+getCurrentThreadNamePtr()
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    log4cplus::tstring & name = log4cplus::internal::get_thread_name_str ();
-    if (LOG4CPLUS_UNLIKELY (name.empty ()))
+    ThreadNamePtr & name = log4cplus::internal::get_thread_name_ptr ();
+    if (LOG4CPLUS_UNLIKELY (! name))
     {
         log4cplus::tostringstream tmp;
         tmp << impl::getCurrentThreadId ();
-        name = tmp.str ();
+        name = std::make_shared<log4cplus::tstring const> (tmp.str ());
     }
 #else
-    log4cplus::tstring & name = thread_name;
-    if (LOG4CPLUS_UNLIKELY(name.empty()))
+    ThreadNamePtr & name = thread_name;
+    if (LOG4CPLUS_UNLIKELY(! name))
     {
-        name = LOG4CPLUS_TEXT("single");
+        name = std::make_shared<log4cplus::tstring const> (
+            LOG4CPLUS_TEXT("single"));
     }
 #endif
 
@@ -163,21 +178,29 @@ get_current_thread_name_alt (log4cplus::tostream * s)
 LOG4CPLUS_EXPORT
 log4cplus::tstring const &
 getCurrentThreadName2()
+{
+    return *getCurrentThreadName2Ptr ();
+}
+
+
+LOG4CPLUS_EXPORT
+ThreadNamePtr const &
+getCurrentThreadName2Ptr()
 {
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    log4cplus::tstring & name = log4cplus::internal::get_thread_name2_str ();
-    if (LOG4CPLUS_UNLIKELY (name.empty ()))
+    ThreadNamePtr & name = log4cplus::internal::get_thread_name2_ptr ();
+    if (LOG4CPLUS_UNLIKELY (! name))
     {
         log4cplus::tostringstream tmp;
         get_current_thread_name_alt (&tmp);
-        name = tmp.str ();
+        name = std::make_shared<log4cplus::tstring const> (tmp.str ());
     }
 
 #else
-    log4cplus::tstring & name = thread_name2;
-    if (LOG4CPLUS_UNLIKELY(name.empty()))
+    ThreadNamePtr & name = thread_name2;
+    if (LOG4CPLUS_UNLIKELY(! name))
     {
-        name = getCurrentThreadName();
+        name = getCurrentThreadNamePtr ();
     }
 
 #endif
@@ -187,19 +210,30 @@ getCurrentThreadName2()
 
 LOG4CPLUS_EXPORT void setCurrentThreadName(const log4cplus::tstring & name)
 {
+    // Publish a fresh immutable name; events that already hold the
+    // previous handle keep seeing the old name. An empty name resets
+    // the handle so that the next use regenerates the default.
+    ThreadNamePtr new_name;
+    if (! name.empty ())
+        new_name = std::make_shared<log4cplus::tstring const> (name);
+
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    log4cplus::internal::get_thread_name_str() = name;
+    log4cplus::internal::get_thread_name_ptr() = std::move (new_name);
 #else
-    thread_name = name;
+    thread_name = std::move (new_name);
 #endif
 }
 
 LOG4CPLUS_EXPORT void setCurrentThreadName2(const log4cplus::tstring & name)
 {
+    ThreadNamePtr new_name;
+    if (! name.empty ())
+        new_name = std::make_shared<log4cplus::tstring const> (name);
+
 #if ! defined (LOG4CPLUS_SINGLE_THREADED)
-    log4cplus::internal::get_thread_name2_str() = name;
+    log4cplus::internal::get_thread_name2_ptr() = std::move (new_name);
 #else
-    thread_name2 = name;
+    thread_name2 = std::move (new_name);
 #endif
 }
 
@@ -253,6 +287,176 @@ AbstractThread::isRunning() const
 }
 
 
+AbstractThread::SchedulingOptions
+AbstractThread::schedulingOptionsFromProperties (
+    helpers::Properties const & props)
+{
+    SchedulingOptions options;
+
+    tstring const & affinity_str
+        = props.getProperty (LOG4CPLUS_TEXT ("ThreadAffinity"));
+    if (! affinity_str.empty ())
+    {
+        std::vector<tstring> tokens;
+        helpers::tokenize (affinity_str, LOG4CPLUS_TEXT (','),
+            std::back_inserter (tokens));
+        for (tstring const & token : tokens)
+        {
+            if (token.empty ())
+                continue;
+
+            int const cpu = std::atoi (
+                LOG4CPLUS_TSTRING_TO_STRING (token).c_str ());
+            if (cpu >= 0)
+                options.affinity.push_back (static_cast<unsigned>(cpu));
+            else
+                helpers::getLogLog ().warn (
+                    LOG4CPLUS_TEXT ("Invalid ThreadAffinity CPU index: ")
+                    + token);
+        }
+    }
+
+    tstring const priority_str = helpers::toUpper (
+        props.getProperty (LOG4CPLUS_TEXT ("ThreadPriority")));
+    if (priority_str == LOG4CPLUS_TEXT ("LOWEST"))
+        options.priority = SchedulingOptions::LOWEST;
+    else if (priority_str == LOG4CPLUS_TEXT ("BELOW_NORMAL"))
+        options.priority = SchedulingOptions::BELOW_NORMAL;
+    else if (priority_str == LOG4CPLUS_TEXT ("NORMAL"))
+        options.priority = SchedulingOptions::NORMAL;
+    else if (priority_str == LOG4CPLUS_TEXT ("ABOVE_NORMAL"))
+        options.priority = SchedulingOptions::ABOVE_NORMAL;
+    else if (priority_str == LOG4CPLUS_TEXT ("HIGHEST"))
+        options.priority = SchedulingOptions::HIGHEST;
+    else if (! priority_str.empty ())
+        helpers::getLogLog ().warn (
+            LOG4CPLUS_TEXT ("Unknown ThreadPriority value: ")
+            + priority_str);
+
+    props.getInt (options.nice_value, LOG4CPLUS_TEXT ("ThreadNiceValue"));
+
+    return options;
+}
+
+
+void
+AbstractThread::setSchedulingOptions (SchedulingOptions options)
+{
+    sched_options = std::move (options);
+}
+
+
+void
+AbstractThread::applySchedulingOptions () const
+{
+    helpers::LogLog & loglog = helpers::getLogLog ();
+
+#if defined (LOG4CPLUS_USE_PTHREADS) && defined (__linux__)
+    if (! sched_options.affinity.empty ())
+    {
+        cpu_set_t cpus;
+        CPU_ZERO (&cpus);
+        for (unsigned const cpu : sched_options.affinity)
+            if (cpu < CPU_SETSIZE)
+                CPU_SET (cpu, &cpus);
+
+        if (pthread_setaffinity_np (pthread_self (), sizeof (cpus), &cpus)
+            != 0)
+            loglog.warn (
+                LOG4CPLUS_TEXT ("applySchedulingOptions()")
+                LOG4CPLUS_TEXT ("- pthread_setaffinity_np() failed"));
+    }
+
+    int nice_value = sched_options.nice_value;
+    if (nice_value == 0)
+    {
+        // Threads have their own nice value on Linux, so the symbolic
+        // priority translates into one when no explicit value is set.
+        switch (sched_options.priority)
+        {
+        case SchedulingOptions::LOWEST:
+            nice_value = 19;
+            break;
+
+        case SchedulingOptions::BELOW_NORMAL:
+            nice_value = 5;
+            break;
+
+        case SchedulingOptions::ABOVE_NORMAL:
+            nice_value = -5;
+            break;
+
+        case SchedulingOptions::HIGHEST:
+            nice_value = -19;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+#if defined (LOG4CPLUS_HAVE_GETTID)
+    if (nice_value != 0
+        && setpriority (PRIO_PROCESS,
+            static_cast<id_t>(syscall (SYS_gettid)), nice_value) == -1)
+        loglog.warn (
+            LOG4CPLUS_TEXT ("applySchedulingOptions()")
+            LOG4CPLUS_TEXT ("- setpriority() failed"));
+#endif
+
+#elif defined (_WIN32)
+    if (! sched_options.affinity.empty ())
+    {
+        DWORD_PTR mask = 0;
+        for (unsigned const cpu : sched_options.affinity)
+            if (cpu < sizeof (DWORD_PTR) * 8)
+                mask |= static_cast<DWORD_PTR>(1) << cpu;
+
+        if (mask != 0
+            && SetThreadAffinityMask (GetCurrentThread (), mask) == 0)
+            loglog.warn (
+                LOG4CPLUS_TEXT ("applySchedulingOptions()")
+                LOG4CPLUS_TEXT ("- SetThreadAffinityMask() failed"));
+    }
+
+    // ThreadNiceValue has no Windows equivalent; only the symbolic
+    // priority is applied there.
+    int priority = THREAD_PRIORITY_NORMAL;
+    switch (sched_options.priority)
+    {
+    case SchedulingOptions::LOWEST:
+        priority = THREAD_PRIORITY_LOWEST;
+        break;
+
+    case SchedulingOptions::BELOW_NORMAL:
+        priority = THREAD_PRIORITY_BELOW_NORMAL;
+        break;
+
+    case SchedulingOptions::ABOVE_NORMAL:
+        priority = THREAD_PRIORITY_ABOVE_NORMAL;
+        break;
+
+    case SchedulingOptions::HIGHEST:
+        priority = THREAD_PRIORITY_HIGHEST;
+        break;
+
+    default:
+        break;
+    }
+
+    if (sched_options.priority != SchedulingOptions::DEFAULT
+        && ! SetThreadPriority (GetCurrentThread (), priority))
+        loglog.warn (
+            LOG4CPLUS_TEXT ("applySchedulingOptions()")
+            LOG4CPLUS_TEXT ("- SetThreadPriority() failed"));
+
+#else
+    (void) loglog;
+
+#endif
+}
+
+
 void
 AbstractThread::start()
 {
@@ -263,6 +467,7 @@ AbstractThread::start()
             [this] (AbstractThreadPtr const & thread_ptr) {
                     (void) thread_ptr;
                     blockAllSignals ();
+                    this->applySchedulingOptions ();
                     helpers::LogLog & loglog = helpers::getLogLog();
                     try
                     {
@@ -23,8 +23,11 @@
 #include <log4cplus/streams.h>
 #include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/internal/internal.h>
+#include <log4cplus/thread/threads.h>
+#include <log4cplus/thread/syncprims-pub-impl.h>
 
 #include <algorithm>
+#include <atomic>
 #include <vector>
 #include <iomanip>
 #include <cassert>
@@ -45,10 +48,6 @@
 #include <sys/timeb.h>
 #endif
 
-#if defined(LOG4CPLUS_HAVE_GMTIME_R) && !defined(LOG4CPLUS_SINGLE_THREADED)
-#define LOG4CPLUS_NEED_GMTIME_R
-#endif
-
 #if defined(LOG4CPLUS_HAVE_LOCALTIME_R) && !defined(LOG4CPLUS_SINGLE_THREADED)
 #define LOG4CPLUS_NEED_LOCALTIME_R
 #endif
@@ -61,8 +60,96 @@ namespace log4cplus::helpers {
 const int ONE_SEC_IN_USEC = 1000000;
 
 using std::mktime;
-using std::gmtime;
 using std::localtime;
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Coarse timestamps
+//////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+
+std::atomic<long long> cached_now_usec {0};
+
+} // namespace detail
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+
+namespace
+{
+
+//! Refreshes detail::cached_now_usec at the configured granularity
+//! until told to exit.
+class TimeTicker
+    : public thread::AbstractThread
+{
+public:
+    explicit TimeTicker (unsigned granularity_msec_)
+        : granularity_msec (granularity_msec_)
+    { }
+
+    void run () override
+    {
+        while (true)
+        {
+            detail::cached_now_usec.store (
+                time_cast (Clock::now ()).time_since_epoch ().count (),
+                std::memory_order_relaxed);
+            ticker_wakeup.timed_wait (granularity_msec);
+            if (ticker_exit.load (std::memory_order_acquire))
+                break;
+        }
+    }
+
+    void terminate ()
+    {
+        ticker_exit.store (true, std::memory_order_release);
+        ticker_wakeup.signal ();
+        join ();
+    }
+
+private:
+    unsigned const granularity_msec;
+    thread::ManualResetEvent ticker_wakeup;
+    std::atomic<bool> ticker_exit {false};
+};
+
+thread::Mutex ticker_mutex;
+helpers::SharedObjectPtr<TimeTicker> ticker;
+
+} // namespace
+
+#endif // ! LOG4CPLUS_SINGLE_THREADED
+
+
+void
+setCoarseTimestampGranularity (unsigned granularity_msec)
+{
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+    if (granularity_msec != 0)
+        getLogLog ().warn (
+            LOG4CPLUS_TEXT ("Coarse timestamps are not available in")
+            LOG4CPLUS_TEXT (" single threaded log4cplus; ignoring."));
+#else
+    thread::MutexGuard guard (ticker_mutex);
+
+    if (ticker)
+    {
+        ticker->terminate ();
+        ticker = helpers::SharedObjectPtr<TimeTicker> ();
+    }
+    detail::cached_now_usec.store (0, std::memory_order_relaxed);
+
+    if (granularity_msec != 0)
+    {
+        ticker = helpers::SharedObjectPtr<TimeTicker> (
+            new TimeTicker (granularity_msec));
+        ticker->start ();
+    }
+#endif
+}
 #if defined (UNICODE)
 using std::wcsftime;
 #else
@@ -84,23 +171,140 @@ from_struct_tm (tm * t)
     }
 }
 
+namespace
+{
+
+// Sets the BSD/glibc extension fields tm_gmtoff and tm_zone when the
+// platform's struct tm has them (strftime() consults them for %z and
+// %Z); expands to nothing elsewhere. The int/long dummy parameter
+// makes the first overload preferred when it is viable.
+template <typename TM>
+static auto
+set_tm_zone (TM * t, long gmtoff, char const * zone, int)
+    -> decltype ((void) t->tm_gmtoff)
+{
+    t->tm_gmtoff = gmtoff;
+    t->tm_zone = zone;
+}
+
+
+template <typename TM>
+static void
+set_tm_zone (TM *, long, char const *, long)
+{ }
+
+
+template <typename TM>
+static auto
+get_tm_zone (TM const * t, int) -> decltype (t->tm_zone)
+{
+    return t->tm_zone;
+}
+
+
+template <typename TM>
+static char const *
+get_tm_zone (TM const *, long)
+{
+    return nullptr;
+}
+
+
+//! Days since 1970-01-01 for a civil date; the inverse of
+//! fill_tm_from_utc(). Both are Howard Hinnant's public domain
+//! chrono-compatible date algorithms.
+static
+long long
+days_from_civil (int y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    long long const era = (y >= 0 ? y : y - 399) / 400;
+    unsigned const yoe = static_cast<unsigned>(y - era * 400);
+    unsigned const doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<long long>(doe) - 719468;
+}
+
+
+//! Fills the civil date and time fields of \c t from seconds since
+//! the epoch using pure integer arithmetic; no libc time conversion
+//! (and therefore no timezone database lock) is involved.
+static
+void
+fill_tm_from_utc (tm * t, time_t clock)
+{
+    long long days = static_cast<long long>(clock) / 86400;
+    long long rem = static_cast<long long>(clock) % 86400;
+    if (rem < 0)
+    {
+        rem += 86400;
+        --days;
+    }
+
+    t->tm_hour = static_cast<int>(rem / 3600);
+    t->tm_min = static_cast<int>(rem % 3600 / 60);
+    t->tm_sec = static_cast<int>(rem % 60);
+    // 1970-01-01 was a Thursday.
+    t->tm_wday = static_cast<int>((days % 7 + 11) % 7);
+
+    // civil_from_days
+    long long const z = days + 719468;
+    long long const era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned const doe = static_cast<unsigned>(z - era * 146097);
+    unsigned const yoe
+        = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long const y = static_cast<long long>(yoe) + era * 400;
+    unsigned const doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned const mp = (5 * doy + 2) / 153;
+    unsigned const d = doy - (153 * mp + 2) / 5 + 1;
+    unsigned const m = mp < 10 ? mp + 3 : mp - 9;
+    int const year = static_cast<int>(y + (m <= 2));
+
+    t->tm_year = year - 1900;
+    t->tm_mon = static_cast<int>(m) - 1;
+    t->tm_mday = static_cast<int>(d);
+
+    static int const days_before_month[12]
+        = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+    bool const leap
+        = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    t->tm_yday = days_before_month[m - 1] + (m > 2 && leap ? 1 : 0)
+        + static_cast<int>(d) - 1;
+    t->tm_isdst = 0;
+}
+
+
+//! Cached local time UTC offset; see
+//! setLocalTimeOffsetCacheSeconds(). The fields race benignly: every
+//! revalidating thread stores the same values and valid_until is
+//! written last, so a stale reader at worst revalidates once more.
+std::atomic<unsigned> lt_cache_secs {0};
+std::atomic<long long> lt_valid_until {0};
+std::atomic<long> lt_offset {0};
+std::atomic<int> lt_isdst {0};
+std::atomic<char const *> lt_zone {nullptr};
+
+} // namespace
+
+
+void
+setLocalTimeOffsetCacheSeconds (unsigned secs)
+{
+    lt_cache_secs.store (secs, std::memory_order_relaxed);
+    // Force revalidation on the next localTime() call.
+    lt_valid_until.store (0, std::memory_order_relaxed);
+}
+
+
 void
 gmTime (tm* t, Time const & the_time)
 {
-    time_t clock = to_time_t (the_time);
-#if defined (LOG4CPLUS_HAVE_GMTIME_S) && defined (_MSC_VER)
-    errno_t eno;
-    if (LOG4CPLUS_UNLIKELY ((eno = gmtime_s (t, &clock)) != 0))
-        throw std::system_error (eno, std::system_category (),
-            "gmTime(): gmtime_s() failed");
-#elif defined (LOG4CPLUS_HAVE_GMTIME_S) && defined (__BORLANDC__)
-    gmtime_s (&clock, t);
-#elif defined (LOG4CPLUS_NEED_GMTIME_R)
-    gmtime_r (&clock, t);
-#else
-    tm* tmp = helpers::gmtime(&clock);
-    *t = *tmp;
-#endif
+    // UTC needs no timezone database, so the conversion is pure
+    // arithmetic; the libc call (and the lock glibc takes around the
+    // timezone state) is skipped entirely.
+    *t = tm ();
+    fill_tm_from_utc (t, to_time_t (the_time));
+    set_tm_zone (t, 0, "GMT", 0);
 }
 
 
@@ -108,6 +312,22 @@ void
 localTime (tm* t, Time const & the_time)
 {
     time_t clock = to_time_t (the_time);
+
+    unsigned const cache_secs
+        = lt_cache_secs.load (std::memory_order_relaxed);
+    if (cache_secs != 0
+        && static_cast<long long>(clock)
+            < lt_valid_until.load (std::memory_order_relaxed))
+    {
+        long const offset = lt_offset.load (std::memory_order_relaxed);
+        *t = tm ();
+        fill_tm_from_utc (t, clock + offset);
+        t->tm_isdst = lt_isdst.load (std::memory_order_relaxed);
+        set_tm_zone (t, offset, lt_zone.load (std::memory_order_relaxed),
+            0);
+        return;
+    }
+
 #ifdef LOG4CPLUS_NEED_LOCALTIME_R
     ::localtime_r(&clock, t);
 #elif defined (LOG4CPLUS_HAVE_LOCALTIME_S)
@@ -119,6 +339,23 @@ localTime (tm* t, Time const & the_time)
     tm* tmp = helpers::localtime(&clock);
     *t = *tmp;
 #endif
+
+    if (cache_secs != 0)
+    {
+        // Capture the UTC offset the libc conversion implies and let
+        // the arithmetic path above serve the next cache_secs worth
+        // of conversions.
+        long const offset = static_cast<long>(
+            days_from_civil (t->tm_year + 1900, t->tm_mon + 1, t->tm_mday)
+                * 86400LL
+            + t->tm_hour * 3600 + t->tm_min * 60 + t->tm_sec
+            - static_cast<long long>(clock));
+        lt_offset.store (offset, std::memory_order_relaxed);
+        lt_isdst.store (t->tm_isdst, std::memory_order_relaxed);
+        lt_zone.store (get_tm_zone (t, 0), std::memory_order_relaxed);
+        lt_valid_until.store (static_cast<long long>(clock) + cache_secs,
+            std::memory_order_relaxed);
+    }
 }
 
 
@@ -315,4 +552,130 @@ getFormattedTime(const log4cplus::tstring& fmt_orig,
 }
 
 
+//////////////////////////////////////////////////////////////////////////////
+// CachedTimeFormatter
+//////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+//! Append \c value zero padded to three digits. \c value is always
+//! in the [0, 999] range here.
+static
+void
+append_three_digits (tstring & str, long value)
+{
+    str.push_back (
+        static_cast<tchar>(LOG4CPLUS_TEXT ('0') + value / 100));
+    str.push_back (
+        static_cast<tchar>(LOG4CPLUS_TEXT ('0') + value / 10 % 10));
+    str.push_back (
+        static_cast<tchar>(LOG4CPLUS_TEXT ('0') + value % 10));
+}
+
+} // namespace
+
+
+CachedTimeFormatter::CachedTimeFormatter (tstring const & fmt,
+    bool use_gmtime_)
+    : use_gmtime (use_gmtime_)
+    , cached_sec ()
+{
+    // Split the format at the %q, %Q and %s specifiers. The remaining
+    // segments change at most once per second and their strftime
+    // output can therefore be cached.
+
+    enum State
+    {
+        TEXT,
+        PERCENT_SIGN
+    };
+
+    State state = TEXT;
+    tstring current;
+    for (tchar const fmt_ch : fmt)
+    {
+        switch (state)
+        {
+        case TEXT:
+            if (fmt_ch == LOG4CPLUS_TEXT ('%'))
+                state = PERCENT_SIGN;
+            else
+                current.push_back (fmt_ch);
+            break;
+
+        case PERCENT_SIGN:
+            if (fmt_ch == LOG4CPLUS_TEXT ('q'))
+                segments.push_back (Segment {current, FIELD_MILLIS});
+            else if (fmt_ch == LOG4CPLUS_TEXT ('Q'))
+                segments.push_back (Segment {current, FIELD_FRACTIONAL});
+            else if (fmt_ch == LOG4CPLUS_TEXT ('s'))
+                segments.push_back (Segment {current, FIELD_EPOCH});
+            else
+            {
+                current.push_back (LOG4CPLUS_TEXT ('%'));
+                current.push_back (fmt_ch);
+                state = TEXT;
+                continue;
+            }
+            current.clear ();
+            state = TEXT;
+            break;
+        }
+    }
+
+    if (state == PERCENT_SIGN)
+        current.push_back (LOG4CPLUS_TEXT ('%'));
+    segments.push_back (Segment {current, FIELD_NONE});
+
+    cached_segments.resize (segments.size ());
+}
+
+
+void
+CachedTimeFormatter::format (tstring & result, Time const & the_time)
+{
+    std::time_t const sec = to_time_t (the_time);
+
+    // Re-run strftime only when the second changes; sub-second fields
+    // are rendered below from the raw timestamp.
+    if (! cache_valid || sec != cached_sec)
+    {
+        for (std::size_t i = 0; i != segments.size (); ++i)
+        {
+            cached_segments[i] = getFormattedTime (segments[i].fmt,
+                the_time, use_gmtime);
+            // The value of %s also only changes with the second, so
+            // it is rendered into the cached segment.
+            if (segments[i].field == FIELD_EPOCH)
+                cached_segments[i] += convertIntegerToString (sec);
+        }
+        cached_sec = sec;
+        cache_valid = true;
+    }
+
+    long const tv_usec = microseconds_part (the_time);
+    for (std::size_t i = 0; i != segments.size (); ++i)
+    {
+        result.append (cached_segments[i]);
+        switch (segments[i].field)
+        {
+        case FIELD_NONE:
+        case FIELD_EPOCH:
+            break;
+
+        case FIELD_MILLIS:
+            append_three_digits (result, tv_usec / 1000);
+            break;
+
+        case FIELD_FRACTIONAL:
+            append_three_digits (result, tv_usec / 1000);
+            result.push_back (LOG4CPLUS_TEXT ('.'));
+            append_three_digits (result, tv_usec % 1000);
+            break;
+        }
+    }
+}
+
+
 } // namespace log4cplus::helpers
@@ -23,6 +23,7 @@
 
 #include <log4cplus/config/windowsh-inc.h>
 #include <log4cplus/win32debugappender.h>
+#include <log4cplus/helpers/stringhelper.h>
 #include <log4cplus/internal/internal.h>
 #include <log4cplus/internal/cygwin-win32.h>
 #include <log4cplus/thread/syncprims-pub-impl.h>
@@ -80,6 +81,11 @@ Win32DebugAppender::append(const spi::InternalLoggingEvent& event)
 #if defined (__CYGWIN__)
     cygwin::output_debug_stringW (
         helpers::towstring (formatEvent (event)).c_str ());
+#elif defined (LOG4CPLUS_UTF8_NATIVE)
+    // OutputDebugStringA() would interpret the bytes in the ANSI code
+    // page; convert at the sink and use the wide call instead.
+    ::OutputDebugStringW (
+        helpers::towstring (formatEvent (event)).c_str ());
 #else
     const tchar * s = formatEvent (event).c_str();
     ::OutputDebugString(s);
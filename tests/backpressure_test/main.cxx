@@ -0,0 +1,516 @@
+#include <log4cplus/config.hxx>
+#include <log4cplus/streams.h>
+
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+
+#include <iostream>
+
+int
+main ()
+{
+    log4cplus::tcout
+        << LOG4CPLUS_TEXT ("Single threaded build, skipping backpressure test.")
+        << std::endl;
+    return 0;
+}
+
+#else
+
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/appender.h>
+#include <log4cplus/asyncappender.h>
+#include <log4cplus/spi/factory.h>
+#include <log4cplus/helpers/property.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/initializer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+using namespace std;
+using namespace log4cplus;
+using namespace log4cplus::helpers;
+
+
+typedef std::chrono::steady_clock bench_clock;
+
+
+namespace log4cplus
+{
+
+
+/**
+ * Test-only sink simulating a degrading downstream where a
+ * FileAppender would normally sit. It formats each event, paces its
+ * "output" to a configured byte rate, optionally adds latency jitter
+ * and periodically reports an injected failure through its error
+ * handler instead of appending.
+ *
+ * <h3>Properties</h3>
+ * <dl>
+ * <dt><tt>BytesPerSec</tt></dt>
+ * <dd>Simulated sink bandwidth in bytes per second. Default is
+ * 1000000.</dd>
+ *
+ * <dt><tt>JitterMicros</tt></dt>
+ * <dd>Upper bound of the uniformly distributed extra latency added
+ * per event, in microseconds. Default is 0.</dd>
+ *
+ * <dt><tt>FailEvery</tt></dt>
+ * <dd>Report an injected failure for every N-th event. 0 (the
+ * default) disables failure injection.</dd>
+ * </dl>
+ */
+class ThrottledAppender
+    : public Appender
+{
+public:
+    ThrottledAppender (unsigned long bytes_per_sec_,
+        unsigned long jitter_micros_, unsigned long fail_every_,
+        bool async_ = false)
+        : bytes_per_sec ((std::max) (bytes_per_sec_, 1ul))
+        , jitter_micros (jitter_micros_)
+        , fail_every (fail_every_)
+    {
+        async = async_;
+    }
+
+    explicit ThrottledAppender (helpers::Properties const & properties)
+        : Appender (properties)
+        , bytes_per_sec (1000000)
+        , jitter_micros (0)
+        , fail_every (0)
+    {
+        properties.getULong (bytes_per_sec, LOG4CPLUS_TEXT ("BytesPerSec"));
+        properties.getULong (jitter_micros, LOG4CPLUS_TEXT ("JitterMicros"));
+        properties.getULong (fail_every, LOG4CPLUS_TEXT ("FailEvery"));
+        bytes_per_sec = (std::max) (bytes_per_sec, 1ul);
+    }
+
+    ~ThrottledAppender () override
+    {
+        destructorImpl ();
+    }
+
+    void close () override
+    {
+        closed = true;
+    }
+
+    unsigned long getAppendedCount () const
+    {
+        return appended_events.load (std::memory_order_relaxed);
+    }
+
+    unsigned long getInjectedFailureCount () const
+    {
+        return injected_failures.load (std::memory_order_relaxed);
+    }
+
+protected:
+    void append (spi::InternalLoggingEvent const & event) override
+    {
+        unsigned long const count
+            = appended_events.fetch_add (1, std::memory_order_relaxed) + 1;
+        if (fail_every != 0 && count % fail_every == 0)
+        {
+            injected_failures.fetch_add (1, std::memory_order_relaxed);
+            getErrorHandler ()->error (
+                LOG4CPLUS_TEXT ("ThrottledAppender: injected sink failure"));
+            return;
+        }
+
+        tstring const & line = formatEvent (event);
+        unsigned long const bytes = static_cast<unsigned long>(
+            (line.size () + 1) * sizeof (tchar));
+
+        // Pace the sink to the configured byte rate. append() runs
+        // under the appender mutex, so the pacing state needs no
+        // synchronization of its own.
+        bench_clock::time_point const now = bench_clock::now ();
+        if (next_free < now)
+            next_free = now;
+        next_free += std::chrono::microseconds (
+            bytes * 1000000ull / bytes_per_sec);
+
+        bench_clock::time_point wake = next_free;
+        if (jitter_micros != 0)
+            wake += std::chrono::microseconds (
+                jitter_rng () % (jitter_micros + 1));
+
+        if (wake > now)
+            std::this_thread::sleep_until (wake);
+    }
+
+private:
+    unsigned long bytes_per_sec;
+    unsigned long jitter_micros;
+    unsigned long fail_every;
+
+    //! Point in time at which the simulated sink has written all
+    //! bytes handed to it so far.
+    bench_clock::time_point next_free;
+
+    //! Deterministically seeded; the jitter needs no real entropy.
+    std::minstd_rand jitter_rng {42};
+
+    std::atomic<unsigned long> appended_events {0};
+    std::atomic<unsigned long> injected_failures {0};
+};
+
+
+} // namespace log4cplus
+
+
+namespace
+{
+
+
+//! Per thread base 2 histogram of per event logging call latencies
+//! in nanoseconds; merged and summarized after the run.
+struct LatencyHistogram
+{
+    unsigned long long buckets[64] = {};
+
+    void record (bench_clock::duration d)
+    {
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds> (
+            d).count ();
+        if (ns < 0)
+            ns = 0;
+
+        std::size_t bucket = 0;
+        while (ns > 1 && bucket != 63)
+        {
+            ns >>= 1;
+            ++bucket;
+        }
+        ++buckets[bucket];
+    }
+
+    void merge (LatencyHistogram const & other)
+    {
+        for (std::size_t i = 0; i != 64; ++i)
+            buckets[i] += other.buckets[i];
+    }
+
+    unsigned long long total () const
+    {
+        unsigned long long sum = 0;
+        for (unsigned long long count : buckets)
+            sum += count;
+        return sum;
+    }
+
+    //! Estimates the q-th quantile in microseconds, interpolating
+    //! linearly within the bucket holding the requested rank.
+    double quantile (double q) const
+    {
+        unsigned long long const sum = total ();
+        if (sum == 0)
+            return 0.0;
+
+        double const rank = q * static_cast<double>(sum);
+        unsigned long long cumulative = 0;
+        for (std::size_t i = 0; i != 64; ++i)
+        {
+            if (buckets[i] == 0)
+                continue;
+
+            cumulative += buckets[i];
+            if (static_cast<double>(cumulative) >= rank)
+            {
+                double const lo = i == 0
+                    ? 0.0
+                    : static_cast<double>(1ull << i);
+                double const hi = i == 63
+                    ? 2.0 * static_cast<double>(1ull << 63)
+                    : static_cast<double>(1ull << (i + 1));
+                double const fraction
+                    = (rank - static_cast<double>(cumulative - buckets[i]))
+                    / static_cast<double>(buckets[i]);
+                return (lo + fraction * (hi - lo)) / 1000.0;
+            }
+        }
+
+        return 0.0;
+    }
+};
+
+
+unsigned const producer_threads = 4;
+std::size_t const events_per_thread = 1000;
+
+
+//! Runs `producer_threads` workers hammering `appender` through a
+//! dedicated logger and reports producer side latency quantiles,
+//! which is what degrades first when the sink falls behind. `drain`
+//! runs inside the timed region so queue flushing is paid for;
+//! `report_extra` can append scenario specific counters to the line.
+void
+run_scenario (tstring const & name, SharedAppenderPtr const & appender,
+    std::function<void ()> const & drain,
+    std::function<void (tostream &)> const & report_extra)
+{
+    Logger logger = Logger::getInstance (
+        LOG4CPLUS_TEXT ("backpressure.") + name);
+    logger.removeAllAppenders ();
+    logger.addAppender (appender);
+    logger.setAdditivity (false);
+
+    std::vector<LatencyHistogram> histograms (producer_threads);
+    std::vector<std::thread> threads;
+    threads.reserve (producer_threads);
+
+    std::atomic<unsigned> ready (0);
+    std::atomic<bool> go (false);
+
+    for (unsigned t = 0; t != producer_threads; ++t)
+    {
+        LatencyHistogram & histogram = histograms[t];
+        threads.emplace_back (
+            [logger, &histogram, &ready, &go] ()
+            {
+                ready.fetch_add (1, std::memory_order_release);
+                while (! go.load (std::memory_order_acquire))
+                    std::this_thread::yield ();
+
+                for (std::size_t i = 0; i != events_per_thread; ++i)
+                {
+                    bench_clock::time_point const before
+                        = bench_clock::now ();
+                    LOG4CPLUS_INFO (logger,
+                        LOG4CPLUS_TEXT ("backpressure benchmark event"));
+                    histogram.record (bench_clock::now () - before);
+                }
+            });
+    }
+
+    while (ready.load (std::memory_order_acquire) != producer_threads)
+        std::this_thread::yield ();
+
+    bench_clock::time_point const start = bench_clock::now ();
+    go.store (true, std::memory_order_release);
+
+    for (std::thread & t : threads)
+        t.join ();
+    if (drain)
+        drain ();
+
+    double const seconds
+        = std::chrono::duration<double> (bench_clock::now () - start)
+        .count ();
+
+    LatencyHistogram merged;
+    for (LatencyHistogram const & histogram : histograms)
+        merged.merge (histogram);
+
+    double const total_events
+        = static_cast<double>(producer_threads) * events_per_thread;
+
+    tcout << std::left << std::setw (18) << name
+          << std::right
+          << std::fixed << std::setprecision (0)
+          << std::setw (10) << total_events / seconds
+          << LOG4CPLUS_TEXT (" ev/s")
+          << std::setprecision (2)
+          << std::setw (10) << merged.quantile (0.50)
+          << LOG4CPLUS_TEXT (" us p50")
+          << std::setw (10) << merged.quantile (0.95)
+          << LOG4CPLUS_TEXT (" us p95")
+          << std::setw (10) << merged.quantile (0.99)
+          << LOG4CPLUS_TEXT (" us p99");
+    if (report_extra)
+        report_extra (tcout);
+    tcout << endl;
+
+    logger.removeAllAppenders ();
+}
+
+
+//! Simulated sink bandwidth; well below what the producers offer, so
+//! every scenario actually runs into its backpressure mechanism.
+unsigned long const sink_bytes_per_sec = 1000000;
+unsigned long const sink_jitter_micros = 10;
+
+
+SharedAppenderPtr
+make_async_over_throttled (tstring const & name,
+    tstring const & overflow_policy, AsyncAppender * & out)
+{
+    helpers::Properties props;
+    props.setProperty (LOG4CPLUS_TEXT ("Appender"),
+        LOG4CPLUS_TEXT ("log4cplus::ThrottledAppender"));
+    props.setProperty (LOG4CPLUS_TEXT ("Appender.BytesPerSec"),
+        convertIntegerToString (sink_bytes_per_sec));
+    props.setProperty (LOG4CPLUS_TEXT ("Appender.JitterMicros"),
+        convertIntegerToString (sink_jitter_micros));
+    props.setProperty (LOG4CPLUS_TEXT ("QueueLimit"),
+        LOG4CPLUS_TEXT ("200"));
+    if (! overflow_policy.empty ())
+        props.setProperty (LOG4CPLUS_TEXT ("OverflowPolicy"),
+            overflow_policy);
+
+    out = new AsyncAppender (props);
+    out->setName (name);
+    return SharedAppenderPtr (out);
+}
+
+
+void
+run_async_scenario (tstring const & name, tstring const & overflow_policy)
+{
+    AsyncAppender * async = nullptr;
+    SharedAppenderPtr appender
+        = make_async_over_throttled (name, overflow_policy, async);
+
+    auto dropped = std::make_shared<std::size_t> (0);
+    run_scenario (name, appender,
+        [async, dropped] ()
+        {
+            // All drops happen on the producer side and the producers
+            // have joined by now; the count must be read before
+            // close() releases the queue.
+            *dropped = async->getDroppedCount ();
+            // Closing signals the queue exit and joins the consumer
+            // after it has drained the remaining events.
+            async->close ();
+        },
+        [dropped] (tostream & out)
+        {
+            out << LOG4CPLUS_TEXT ("  dropped ") << *dropped;
+        });
+}
+
+
+} // namespace
+
+
+int
+main ()
+{
+    log4cplus::Initializer initializer;
+
+    spi::AppenderFactoryRegistry & registry
+        = spi::getAppenderFactoryRegistry ();
+    LOG4CPLUS_REG_APPENDER (registry, ThrottledAppender);
+
+    // Synchronous baseline; the producers feel the full sink latency.
+    {
+        SharedAppenderPtr appender (new ThrottledAppender (
+            sink_bytes_per_sec, sink_jitter_micros, 0));
+        appender->setName (LOG4CPLUS_TEXT ("sync-throttled"));
+        run_scenario (LOG4CPLUS_TEXT ("sync-throttled"), appender,
+            std::function<void ()> (),
+            std::function<void (tostream &)> ());
+    }
+
+    // AsyncAppend=true path; exercises Appender::asyncDoAppend()'s
+    // in-flight accounting and the shared thread pool.
+    {
+        ThrottledAppender * throttled = new ThrottledAppender (
+            sink_bytes_per_sec, sink_jitter_micros, 0, true);
+        SharedAppenderPtr appender (throttled);
+        appender->setName (LOG4CPLUS_TEXT ("direct-async"));
+        run_scenario (LOG4CPLUS_TEXT ("direct-async"), appender,
+            [appender] () { appender->waitToFinishAsyncLogging (); },
+            std::function<void (tostream &)> ());
+    }
+
+    // AsyncAppender overflow policies over the degrading sink.
+    run_async_scenario (LOG4CPLUS_TEXT ("async-block"), tstring ());
+    run_async_scenario (LOG4CPLUS_TEXT ("async-dropoldest"),
+        LOG4CPLUS_TEXT ("DropOldest"));
+    run_async_scenario (LOG4CPLUS_TEXT ("async-dropnewest"),
+        LOG4CPLUS_TEXT ("DropNewest"));
+    // The INFO benchmark events are below the WARN threshold and may
+    // all be shed once the queue is over its limit.
+    run_async_scenario (LOG4CPLUS_TEXT ("async-droplevel"),
+        LOG4CPLUS_TEXT ("DropBelowLevel=WARN"));
+
+    // SpillToDisk parks overflowing events in a local file and
+    // replays them once the sink catches up, so every produced event
+    // must reach the sink eventually.
+    {
+        helpers::Properties props;
+        props.setProperty (LOG4CPLUS_TEXT ("Appender"),
+            LOG4CPLUS_TEXT ("log4cplus::ThrottledAppender"));
+        props.setProperty (LOG4CPLUS_TEXT ("Appender.BytesPerSec"),
+            convertIntegerToString (sink_bytes_per_sec));
+        props.setProperty (LOG4CPLUS_TEXT ("Appender.JitterMicros"),
+            convertIntegerToString (sink_jitter_micros));
+        props.setProperty (LOG4CPLUS_TEXT ("QueueLimit"),
+            LOG4CPLUS_TEXT ("200"));
+        props.setProperty (LOG4CPLUS_TEXT ("OverflowPolicy"),
+            LOG4CPLUS_TEXT ("SpillToDisk"));
+        props.setProperty (LOG4CPLUS_TEXT ("SpillFile"),
+            LOG4CPLUS_TEXT ("backpressure_spill.bin"));
+
+        AsyncAppender * async = new AsyncAppender (props);
+        async->setName (LOG4CPLUS_TEXT ("async-spilltodisk"));
+        SharedAppenderPtr appender (async);
+        SharedAppenderPtr sink = async->getAllAppenders ().front ();
+
+        auto dropped = std::make_shared<std::size_t> (0);
+        run_scenario (LOG4CPLUS_TEXT ("async-spilltodisk"), appender,
+            [async, dropped] ()
+            {
+                *dropped = async->getDroppedCount ();
+                async->close ();
+            },
+            [dropped] (tostream & out)
+            {
+                out << LOG4CPLUS_TEXT ("  dropped ") << *dropped;
+            });
+
+        unsigned long const delivered = static_cast<ThrottledAppender &>(
+            *sink).getAppendedCount ();
+        unsigned long const total
+            = static_cast<unsigned long>(producer_threads)
+            * events_per_thread;
+        if (delivered + *dropped != total)
+        {
+            tcout << LOG4CPLUS_TEXT ("spill scenario lost events: ")
+                  << delivered << LOG4CPLUS_TEXT (" delivered + ")
+                  << *dropped << LOG4CPLUS_TEXT (" dropped != ")
+                  << total << endl;
+            return 1;
+        }
+    }
+
+    // Failure injection; the error handler absorbs the failures and
+    // the producers must not be disturbed beyond the sink pacing.
+    {
+        ThrottledAppender * throttled = new ThrottledAppender (
+            sink_bytes_per_sec, sink_jitter_micros, 500);
+        SharedAppenderPtr appender (throttled);
+        appender->setName (LOG4CPLUS_TEXT ("failure-inject"));
+        run_scenario (LOG4CPLUS_TEXT ("failure-inject"), appender,
+            std::function<void ()> (),
+            [throttled] (tostream & out)
+            {
+                out << LOG4CPLUS_TEXT ("  failures ")
+                    << throttled->getInjectedFailureCount ();
+            });
+
+        if (throttled->getInjectedFailureCount () == 0)
+        {
+            tcout << LOG4CPLUS_TEXT ("failure injection did not trigger")
+                  << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+#endif // LOG4CPLUS_SINGLE_THREADED
@@ -0,0 +1,54 @@
+// Instrument the logging macros of this translation unit with cycle
+// counting latency probes.
+#define LOG4CPLUS_CALL_LATENCY
+
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/consoleappender.h>
+#include <log4cplus/initializer.h>
+#include <cstdint>
+#include <iostream>
+
+using namespace log4cplus;
+
+
+int
+main ()
+{
+    Initializer initializer;
+
+    Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("latency"));
+    logger.addAppender (SharedAppenderPtr (new ConsoleAppender));
+    logger.setLogLevel (INFO_LOG_LEVEL);
+
+    CallLatencyHistogram const before = getCallLatencyHistogram ();
+
+    // Both delivered and level suppressed calls must be counted; the
+    // probe brackets the whole macro body.
+    for (int i = 0; i != 10; ++i)
+    {
+        LOG4CPLUS_INFO (logger, LOG4CPLUS_TEXT ("timed message ") << i);
+        LOG4CPLUS_DEBUG (logger, LOG4CPLUS_TEXT ("suppressed ") << i);
+    }
+
+    CallLatencyHistogram const after = getCallLatencyHistogram ();
+    if (after.count - before.count != 20)
+    {
+        std::cout << "unexpected invocation count "
+            << (after.count - before.count) << std::endl;
+        return 1;
+    }
+
+    std::uint64_t bucket_sum = 0;
+    for (std::uint64_t bucket : after.buckets)
+        bucket_sum += bucket;
+    if (bucket_sum != after.count)
+    {
+        std::cout << "bucket sum " << bucket_sum
+            << " does not match count " << after.count << std::endl;
+        return 2;
+    }
+
+    std::cout << "OK" << std::endl;
+    return 0;
+}
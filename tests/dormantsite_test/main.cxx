@@ -0,0 +1,98 @@
+// Compile DEBUG and below out of this translation unit, but keep
+// dormant, runtime switchable sites behind them.
+#define LOG4CPLUS_DISABLE_DEBUG
+#define LOG4CPLUS_DORMANT_SITES
+
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/appender.h>
+#include <log4cplus/initializer.h>
+#include <iostream>
+
+using namespace log4cplus;
+
+
+namespace
+{
+
+class CountingAppender
+    : public Appender
+{
+public:
+    CountingAppender ()
+        : count (0)
+    { }
+
+    ~CountingAppender () override
+    {
+        destructorImpl ();
+    }
+
+    void close () override
+    {
+        closed = true;
+    }
+
+    void append (spi::InternalLoggingEvent const &) override
+    {
+        ++count;
+    }
+
+    int count;
+};
+
+
+void
+emitDebug (Logger & logger, int value)
+{
+    LOG4CPLUS_DEBUG (logger,
+        LOG4CPLUS_TEXT ("dormant value ") << value);
+}
+
+} // namespace
+
+
+int
+main ()
+{
+    Initializer initializer;
+
+    Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("dormant"));
+    CountingAppender * counter = new CountingAppender;
+    logger.addAppender (SharedAppenderPtr (counter));
+
+    // The DEBUG level is compiled out; the first pass only registers
+    // the site.
+    emitDebug (logger, 0);
+    if (counter->count != 0)
+    {
+        std::cout << "dormant site logged while disabled" << std::endl;
+        return 1;
+    }
+
+    // Switch the site on by source file name and log through it.
+    std::size_t const switched
+        = enableDormantLogSites (LOG4CPLUS_TEXT ("main.cxx"));
+    if (switched == 0)
+    {
+        std::cout << "no dormant site registered" << std::endl;
+        return 2;
+    }
+
+    emitDebug (logger, 1);
+    emitDebug (logger, 2);
+
+    // And off again.
+    enableDormantLogSites (LOG4CPLUS_TEXT ("main.cxx"), -1, false);
+    emitDebug (logger, 3);
+
+    if (counter->count != 2)
+    {
+        std::cout << "unexpected event count " << counter->count
+            << std::endl;
+        return 3;
+    }
+
+    std::cout << "OK" << std::endl;
+    return 0;
+}
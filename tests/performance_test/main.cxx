@@ -1,29 +1,281 @@
 #include <log4cplus/logger.h>
 #include <log4cplus/loggingmacros.h>
 #include <log4cplus/configurator.h>
-#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/hierarchy.h>
+#include <log4cplus/layout.h>
+#include <log4cplus/fileappender.h>
+#include <log4cplus/nullappender.h>
+#include <log4cplus/helpers/property.h>
 #include <log4cplus/helpers/stringhelper.h>
-#include <log4cplus/helpers/timehelper.h>
 #include <log4cplus/helpers/fileinfo.h>
+#include <log4cplus/helpers/queue.h>
 #include <log4cplus/spi/loggingevent.h>
 #include <log4cplus/initializer.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iomanip>
+#include <vector>
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+#include <thread>
+#endif
+
 
 using namespace std;
 using namespace log4cplus;
 using namespace log4cplus::helpers;
 
-typedef helpers::chrono::high_resolution_clock hr_clock;
-typedef helpers::chrono::duration<double, std::ratio<1>> sec_dur_type;
 
-log4cplus::tostream& operator <<(log4cplus::tostream& s, const Time& t)
+namespace
+{
+
+
+typedef std::chrono::steady_clock bench_clock;
+typedef std::chrono::duration<double, std::nano> ns_dur_type;
+
+
+//! Minimal micro-benchmark harness. Each case is a callable running
+//! its workload `iterations` times; the harness calibrates the
+//! iteration count until one repetition takes long enough to measure,
+//! then reports the median and minimum nanoseconds per operation over
+//! several repetitions.
+//!
+//! Regression thresholds come from the `benchmark.threshold.` subset
+//! of the configuration file, e.g.
+//!
+//!     benchmark.threshold.macro/disabled=20
+//!
+//! fails the run when the `macro/disabled` case's median exceeds
+//! 20 ns per operation. Cases without a threshold are informational.
+class BenchmarkRunner
+{
+public:
+    explicit
+    BenchmarkRunner (Properties thresholds_)
+        : thresholds (std::move (thresholds_))
+        , failures (0)
+    { }
+
+    //! Returns the median nanoseconds per operation, so callers can
+    //! derive per-stage costs from several cases by subtraction.
+    double run (tstring const & name,
+        std::function<void (std::size_t)> const & body,
+        std::size_t max_iterations = 0);
+
+    int failure_count () const
+    {
+        return failures;
+    }
+
+private:
+    Properties thresholds;
+    int failures;
+};
+
+
+double
+BenchmarkRunner::run (tstring const & name,
+    std::function<void (std::size_t)> const & body,
+    std::size_t max_iterations)
+{
+    double const min_seconds = 0.05;
+    int const repetitions = 5;
+
+    // Calibrate the iteration count so that one repetition runs long
+    // enough for the clock resolution not to matter.
+    std::size_t iterations = 1;
+    for (;;)
+    {
+        bench_clock::time_point const start = bench_clock::now ();
+        body (iterations);
+        double const elapsed
+            = std::chrono::duration<double> (bench_clock::now () - start)
+            .count ();
+        if (elapsed >= min_seconds
+            || (max_iterations != 0 && iterations >= max_iterations))
+            break;
+
+        iterations *= 2;
+        if (max_iterations != 0)
+            iterations = (std::min) (iterations, max_iterations);
+    }
+
+    std::vector<double> samples;
+    samples.reserve (repetitions);
+    for (int rep = 0; rep != repetitions; ++rep)
+    {
+        bench_clock::time_point const start = bench_clock::now ();
+        body (iterations);
+        samples.push_back (
+            ns_dur_type (bench_clock::now () - start).count ()
+            / static_cast<double>(iterations));
+    }
+
+    std::sort (samples.begin (), samples.end ());
+    double const median = samples[samples.size () / 2];
+    double const minimum = samples.front ();
+
+    tcout << std::left << std::setw (40) << name
+          << std::right << std::fixed << std::setprecision (1)
+          << std::setw (12) << median << LOG4CPLUS_TEXT (" ns/op median")
+          << std::setw (12) << minimum << LOG4CPLUS_TEXT (" ns/op min")
+          << std::setw (12) << iterations << LOG4CPLUS_TEXT (" iters");
+
+    unsigned long threshold = 0;
+    if (thresholds.getULong (threshold, name)
+        && median > static_cast<double>(threshold))
+    {
+        tcout << LOG4CPLUS_TEXT ("  REGRESSION (threshold ") << threshold
+              << LOG4CPLUS_TEXT (" ns/op)");
+        ++failures;
+    }
+
+    tcout << endl;
+    return median;
+}
+
+
+spi::InternalLoggingEvent
+make_event ()
+{
+    return spi::InternalLoggingEvent (LOG4CPLUS_TEXT ("bench.logger"),
+        INFO_LOG_LEVEL, LOG4CPLUS_TEXT ("This is a benchmark message..."),
+        __FILE__, __LINE__, "main");
+}
+
+
+//
+// Benchmark cases.
+//
+
+void
+macro_disabled_benchmark (std::size_t iterations)
+{
+    Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("bench.disabled"));
+    logger.setLogLevel (ERROR_LOG_LEVEL);
+    for (std::size_t i = 0; i != iterations; ++i)
+        LOG4CPLUS_DEBUG (logger, LOG4CPLUS_TEXT ("never formatted ") << i);
+}
+
+
+void
+layout_benchmark (tstring const & pattern, std::size_t iterations)
+{
+    PatternLayout layout (pattern);
+    spi::InternalLoggingEvent const event (make_event ());
+    tostringstream oss;
+    for (std::size_t i = 0; i != iterations; ++i)
+    {
+        // Rewind instead of resetting so the buffer is reused.
+        oss.clear ();
+        oss.seekp (0);
+        layout.formatAndAppend (oss, event);
+    }
+}
+
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+void
+queue_put_benchmark (thread::QueuePtr const & queue, unsigned producers,
+    std::size_t iterations)
 {
-    return s << to_time_t (t) << "sec "
-             << microseconds_part (t) << "usec";
+    std::thread consumer (
+        [queue] ()
+        {
+            thread::Queue::queue_storage_type buf;
+            for (;;)
+            {
+                thread::Queue::flags_type const flags
+                    = queue->get_events (&buf);
+                buf.clear ();
+                if ((flags & thread::Queue::EXIT)
+                    && ! (flags & thread::Queue::EVENT))
+                    break;
+            }
+        });
+
+    spi::InternalLoggingEvent const event (make_event ());
+    std::size_t const per_producer
+        = (std::max) (iterations / producers, std::size_t (1));
+
+    std::vector<std::thread> threads;
+    threads.reserve (producers);
+    for (unsigned p = 0; p != producers; ++p)
+        threads.emplace_back (
+            [queue, &event, per_producer] ()
+            {
+                for (std::size_t i = 0; i != per_producer; ++i)
+                    queue->put_event (event);
+            });
+
+    for (std::thread & t : threads)
+        t.join ();
+
+    queue->signal_exit (true);
+    consumer.join ();
 }
+#endif
 
 
-#define LOOP_COUNT 100000
+void
+file_appender_benchmark (bool immediate_flush, std::size_t iterations)
+{
+    tstring const filename = LOG4CPLUS_TEXT ("bench_fileappender.log");
+    SharedAppenderPtr appender (
+        new FileAppender (filename, std::ios_base::trunc, immediate_flush));
+    appender->setName (LOG4CPLUS_TEXT ("bench"));
+    appender->setLayout (
+        std::make_unique<PatternLayout> (LOG4CPLUS_TEXT ("%p %c - %m%n")));
+
+    spi::InternalLoggingEvent const event (make_event ());
+    for (std::size_t i = 0; i != iterations; ++i)
+        appender->doAppend (event);
+
+    appender->close ();
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (filename).c_str ());
+}
+
+
+//! Appends one event repeatedly through the given appender with the
+//! formatted line cache disabled, so that every iteration pays the
+//! full configured pipeline instead of copying the cached line.
+void
+calibration_benchmark (SharedAppenderPtr const & appender,
+    std::size_t iterations)
+{
+    spi::InternalLoggingEvent const event (make_event ());
+    event.enableFormattedLineCache (false);
+    for (std::size_t i = 0; i != iterations; ++i)
+        appender->doAppend (event);
+}
+
+
+void
+hierarchy_hit_benchmark (std::size_t iterations)
+{
+    Hierarchy h;
+    tstring const name = LOG4CPLUS_TEXT ("bench.hierarchy.hit");
+    h.getInstance (name);
+    for (std::size_t i = 0; i != iterations; ++i)
+        h.getInstance (name);
+}
+
+
+void
+hierarchy_miss_benchmark (std::vector<tstring> const & names,
+    std::size_t iterations)
+{
+    // A fresh hierarchy per repetition so that every lookup really
+    // misses and creates the logger.
+    Hierarchy h;
+    for (std::size_t i = 0; i != iterations; ++i)
+        h.getInstance (names[i]);
+}
+
+
+} // namespace
 
 
 log4cplus::tstring
@@ -45,104 +297,127 @@ getPropertiesFileArgument (int argc, char * argv[])
 int
 main(int argc, char * argv[])
 {
-    tcout << LOG4CPLUS_TEXT("Entering main()...") << endl;
     log4cplus::Initializer initializer;
 
-    PropertyConfigurator::doConfigure(getPropertiesFileArgument (argc, argv));
-    Logger root = Logger::getRoot();
-    try {
-        Logger logger = Logger::getInstance(LOG4CPLUS_TEXT("testlogger"));
-
-        LOG4CPLUS_WARN(Logger::getRoot (), "Starting test loop....");
-
-        hr_clock::time_point start = hr_clock::now ();
-        tstring msg(LOG4CPLUS_TEXT("This is a WARNING..."));
-        int i = 0;
-        for(i=0; i<LOOP_COUNT; ++i) {
-            LOG4CPLUS_WARN(logger, msg);
-        }
-        hr_clock::time_point end = hr_clock::now ();
-        hr_clock::duration diff = end - start;
-        double diff_seconds = sec_dur_type (diff).count ();
-        LOG4CPLUS_WARN(LOG4CPLUS_TEXT("root"), "Logging " << LOOP_COUNT
-                       << " took: " << diff_seconds << endl);
-        LOG4CPLUS_WARN(root, "Logging average: " << (diff_seconds/LOOP_COUNT)
-                       << endl);
-
-        start = hr_clock::now ();
-        for(i=0; i<LOOP_COUNT; ++i) {
-            tostringstream buffer;
-            buffer /*<< "test"*/ << 123122;
-            tstring tmp = buffer.str();
-        }
-        end = hr_clock::now ();
-        diff = end - start;
-        diff_seconds = sec_dur_type (diff).count ();
-        LOG4CPLUS_WARN(root, "tostringstream average: "
-                       << (diff_seconds/LOOP_COUNT) << endl);
-
-        start = hr_clock::now ();
-        for(i=0; i<LOOP_COUNT; ++i) {
-            log4cplus::spi::InternalLoggingEvent e(logger.getName(),
-                log4cplus::WARN_LOG_LEVEL, msg, __FILE__, __LINE__, "main");
-        }
-        end = hr_clock::now ();
-        diff = end - start;
-        diff_seconds = sec_dur_type (diff).count ();
-        LOG4CPLUS_WARN(root, "Creating log " << LOOP_COUNT << " objects took: "
-                       << diff_seconds);
-        LOG4CPLUS_WARN(root, "Creating log object average: "
-                       << (diff_seconds/LOOP_COUNT) << endl);
-
-        start = hr_clock::now ();
-        for(i=0; i<LOOP_COUNT; ++i) {
-            log4cplus::spi::InternalLoggingEvent e(logger.getName(),
-                log4cplus::WARN_LOG_LEVEL, msg, __FILE__, __LINE__, "main");
-            e.getNDC();
-            e.getThread();
-        }
-        end = hr_clock::now ();
-        diff = end - start;
-        diff_seconds = sec_dur_type (diff).count ();
-        LOG4CPLUS_WARN(root, "Creating FULL log " << LOOP_COUNT
-                       << " objects took: " << diff_seconds);
-        LOG4CPLUS_WARN(root, "Creating FULL log object average: "
-                       << (diff_seconds/LOOP_COUNT) << endl);
-
-        start = hr_clock::now ();
-        for(i=0; i<LOOP_COUNT; ++i) {
-            log4cplus::spi::InternalLoggingEvent e(logger.getName(),
-                log4cplus::WARN_LOG_LEVEL, msg, __FILE__, __LINE__, "main");
-            e.getNDC();
-        }
-        end = hr_clock::now ();
-        diff = end - start;
-        diff_seconds = sec_dur_type (diff).count ();
-        LOG4CPLUS_WARN(root, "getNDC() " << LOOP_COUNT << " calls took: "
-                       << diff_seconds);
-        LOG4CPLUS_WARN(root, "getNDC() average: " << (diff_seconds/LOOP_COUNT)
-                       << endl);
-
-        start = hr_clock::now ();
-        for(i=0; i<LOOP_COUNT; ++i) {
-            log4cplus::spi::InternalLoggingEvent e(logger.getName(),
-                log4cplus::WARN_LOG_LEVEL, msg, __FILE__, __LINE__, "main");
-            e.getThread();
-        }
-        end = hr_clock::now ();
-        diff = end - start;
-        diff_seconds = sec_dur_type (diff).count ();
-        LOG4CPLUS_WARN(root, "getThread() " << LOOP_COUNT << " calls took: "
-                       << diff_seconds);
-        LOG4CPLUS_WARN(root, "getThread() average: "
-                       << (diff_seconds/LOOP_COUNT) << endl);
-    }
-    catch(...) {
-        tcout << LOG4CPLUS_TEXT("Exception...") << endl;
-        LOG4CPLUS_FATAL(root, "Exception occurred...");
+    tstring const propertiesFile = getPropertiesFileArgument (argc, argv);
+    PropertyConfigurator::doConfigure (propertiesFile);
+
+    Properties const properties (propertiesFile);
+    BenchmarkRunner runner (
+        properties.getPropertySubset (
+            LOG4CPLUS_TEXT ("benchmark.threshold.")));
+
+    runner.run (LOG4CPLUS_TEXT ("macro/disabled"), macro_disabled_benchmark);
+
+    static tchar const * const patterns[] = {
+        LOG4CPLUS_TEXT ("%m"),
+        LOG4CPLUS_TEXT ("%d"),
+        LOG4CPLUS_TEXT ("%p"),
+        LOG4CPLUS_TEXT ("%c"),
+        LOG4CPLUS_TEXT ("%t"),
+        LOG4CPLUS_TEXT ("%F:%L"),
+        LOG4CPLUS_TEXT ("%d{%y-%m-%d %H:%M:%S,%q} [%t] %-5p %c <%x> - %m%n")
+    };
+    for (tchar const * pattern : patterns)
+        runner.run (tstring (LOG4CPLUS_TEXT ("layout/")) + pattern,
+            [pattern] (std::size_t iterations)
+            { layout_benchmark (pattern, iterations); });
+
+#if ! defined (LOG4CPLUS_SINGLE_THREADED)
+    struct QueueBackend
+    {
+        tchar const * name;
+        thread::Queue * (* create) ();
+    };
+    static QueueBackend const backends[] = {
+        { LOG4CPLUS_TEXT ("Queue"),
+          [] () -> thread::Queue * { return new thread::Queue (1000); } },
+        { LOG4CPLUS_TEXT ("RingQueue"),
+          [] () -> thread::Queue * { return new thread::RingQueue (1000); } },
+        { LOG4CPLUS_TEXT ("DoubleBufferQueue"),
+          [] () -> thread::Queue *
+          { return new thread::DoubleBufferQueue (1000); } }
+    };
+    static unsigned const producer_counts[] = { 1, 8, 32 };
+    for (QueueBackend const & backend : backends)
+        for (unsigned producers : producer_counts)
+            runner.run (tstring (LOG4CPLUS_TEXT ("queue/put_event/"))
+                    + backend.name + LOG4CPLUS_TEXT ("/")
+                    + convertIntegerToString (producers),
+                [&backend, producers] (std::size_t iterations)
+                {
+                    thread::QueuePtr const queue (backend.create ());
+                    queue_put_benchmark (queue, producers, iterations);
+                });
+#endif
+
+    runner.run (LOG4CPLUS_TEXT ("file/immediate-flush"),
+        [] (std::size_t iterations)
+        { file_appender_benchmark (true, iterations); });
+    runner.run (LOG4CPLUS_TEXT ("file/buffered"),
+        [] (std::size_t iterations)
+        { file_appender_benchmark (false, iterations); });
+
+    // Calibration: the NullAppender modes stop the append pipeline
+    // after successive stages, so the per-stage costs of a real file
+    // appender with the same layout fall out by subtraction.
+    tstring const calib_file_name
+        = LOG4CPLUS_TEXT ("bench_calibration.log");
+    auto calibration_case = [] (SharedAppenderPtr appender)
+    {
+        appender->setName (LOG4CPLUS_TEXT ("calibration"));
+        appender->setLayout (std::make_unique<PatternLayout> (
+            LOG4CPLUS_TEXT ("%p %c - %m%n")));
+        return [appender] (std::size_t iterations)
+        { calibration_benchmark (appender, iterations); };
+    };
+
+    double const calib_discard = runner.run (
+        LOG4CPLUS_TEXT ("calibration/discard"),
+        calibration_case (SharedAppenderPtr (
+            new NullAppender (NullAppender::Discard))));
+    double const calib_format = runner.run (
+        LOG4CPLUS_TEXT ("calibration/format"),
+        calibration_case (SharedAppenderPtr (
+            new NullAppender (NullAppender::Format))));
+    double const calib_copy = runner.run (
+        LOG4CPLUS_TEXT ("calibration/format+copy"),
+        calibration_case (SharedAppenderPtr (
+            new NullAppender (NullAppender::FormatAndCopy))));
+    {
+        SharedAppenderPtr const calib_file_appender (
+            new FileAppender (calib_file_name, std::ios_base::trunc, false));
+        double const calib_file = runner.run (
+            LOG4CPLUS_TEXT ("calibration/file"),
+            calibration_case (calib_file_appender));
+
+        tcout << LOG4CPLUS_TEXT ("calibration stages (median ns/op):")
+              << endl
+              << LOG4CPLUS_TEXT ("  dispatch  ") << calib_discard << endl
+              << LOG4CPLUS_TEXT ("  layout    ")
+              << calib_format - calib_discard << endl
+              << LOG4CPLUS_TEXT ("  line copy ")
+              << calib_copy - calib_format << endl
+              << LOG4CPLUS_TEXT ("  file I/O  ")
+              << calib_file - calib_copy << endl;
+
+        calib_file_appender->close ();
     }
+    std::remove (LOG4CPLUS_TSTRING_TO_STRING (calib_file_name).c_str ());
+
+    runner.run (LOG4CPLUS_TEXT ("hierarchy/getInstance-hit"),
+        hierarchy_hit_benchmark);
 
-    tcout << LOG4CPLUS_TEXT("Exiting main()...") << endl;
+    std::size_t const miss_cap = 1 << 18;
+    std::vector<tstring> missNames;
+    missNames.reserve (miss_cap);
+    for (std::size_t i = 0; i != miss_cap; ++i)
+        missNames.push_back (LOG4CPLUS_TEXT ("bench.miss.")
+            + convertIntegerToString (i));
+    runner.run (LOG4CPLUS_TEXT ("hierarchy/getInstance-miss"),
+        [&missNames] (std::size_t iterations)
+        { hierarchy_miss_benchmark (missNames, iterations); },
+        miss_cap);
 
-    return 0;
+    return runner.failure_count () == 0 ? 0 : 1;
 }
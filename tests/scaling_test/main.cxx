@@ -0,0 +1,278 @@
+#include <log4cplus/config.hxx>
+#include <log4cplus/streams.h>
+
+#if defined (LOG4CPLUS_SINGLE_THREADED)
+
+#include <iostream>
+
+int
+main ()
+{
+    log4cplus::tcout
+        << LOG4CPLUS_TEXT ("Single threaded build, skipping scaling test.")
+        << std::endl;
+    return 0;
+}
+
+#else
+
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/nullappender.h>
+#include <log4cplus/asyncappender.h>
+#include <log4cplus/helpers/stringhelper.h>
+#include <log4cplus/initializer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+
+using namespace std;
+using namespace log4cplus;
+using namespace log4cplus::helpers;
+
+
+namespace
+{
+
+
+typedef std::chrono::steady_clock bench_clock;
+
+
+//! Per thread base 2 histogram of per event logging call latencies
+//! in nanoseconds. Each worker records into its own instance; the
+//! histograms are merged and summarized after the run.
+struct LatencyHistogram
+{
+    unsigned long long buckets[64] = {};
+
+    void record (bench_clock::duration d)
+    {
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds> (
+            d).count ();
+        if (ns < 0)
+            ns = 0;
+
+        std::size_t bucket = 0;
+        while (ns > 1 && bucket != 63)
+        {
+            ns >>= 1;
+            ++bucket;
+        }
+        ++buckets[bucket];
+    }
+
+    void merge (LatencyHistogram const & other)
+    {
+        for (std::size_t i = 0; i != 64; ++i)
+            buckets[i] += other.buckets[i];
+    }
+
+    unsigned long long total () const
+    {
+        unsigned long long sum = 0;
+        for (unsigned long long count : buckets)
+            sum += count;
+        return sum;
+    }
+
+    //! Estimates the q-th quantile in microseconds, interpolating
+    //! linearly within the bucket holding the requested rank.
+    double quantile (double q) const
+    {
+        unsigned long long const sum = total ();
+        if (sum == 0)
+            return 0.0;
+
+        double const rank = q * static_cast<double>(sum);
+        unsigned long long cumulative = 0;
+        for (std::size_t i = 0; i != 64; ++i)
+        {
+            if (buckets[i] == 0)
+                continue;
+
+            cumulative += buckets[i];
+            if (static_cast<double>(cumulative) >= rank)
+            {
+                double const lo = i == 0
+                    ? 0.0
+                    : static_cast<double>(1ull << i);
+                double const hi = i == 63
+                    ? 2.0 * static_cast<double>(1ull << 63)
+                    : static_cast<double>(1ull << (i + 1));
+                double const fraction
+                    = (rank - static_cast<double>(cumulative - buckets[i]))
+                    / static_cast<double>(buckets[i]);
+                return (lo + fraction * (hi - lo)) / 1000.0;
+            }
+        }
+
+        return 0.0;
+    }
+};
+
+
+std::size_t const events_per_thread = 20000;
+
+
+//! Drives `thread_count` workers through loggers supplied by
+//! `logger_for_thread`, waits for them on a start flag so they
+//! contend from the first event, and reports throughput and latency
+//! quantiles. `drain` runs inside the timed region so asynchronous
+//! configurations pay for flushing their queues.
+void
+run_scenario (tstring const & name, unsigned thread_count,
+    std::function<Logger (unsigned)> const & logger_for_thread,
+    std::function<void ()> const & drain)
+{
+    std::vector<LatencyHistogram> histograms (thread_count);
+    std::vector<std::thread> threads;
+    threads.reserve (thread_count);
+
+    std::atomic<unsigned> ready (0);
+    std::atomic<bool> go (false);
+
+    for (unsigned t = 0; t != thread_count; ++t)
+    {
+        Logger logger = logger_for_thread (t);
+        LatencyHistogram & histogram = histograms[t];
+        threads.emplace_back (
+            [logger, &histogram, &ready, &go] ()
+            {
+                ready.fetch_add (1, std::memory_order_release);
+                while (! go.load (std::memory_order_acquire))
+                    std::this_thread::yield ();
+
+                for (std::size_t i = 0; i != events_per_thread; ++i)
+                {
+                    bench_clock::time_point const before
+                        = bench_clock::now ();
+                    LOG4CPLUS_INFO (logger,
+                        LOG4CPLUS_TEXT ("scaling benchmark event"));
+                    histogram.record (bench_clock::now () - before);
+                }
+            });
+    }
+
+    while (ready.load (std::memory_order_acquire) != thread_count)
+        std::this_thread::yield ();
+
+    bench_clock::time_point const start = bench_clock::now ();
+    go.store (true, std::memory_order_release);
+
+    for (std::thread & t : threads)
+        t.join ();
+    if (drain)
+        drain ();
+
+    double const seconds
+        = std::chrono::duration<double> (bench_clock::now () - start)
+        .count ();
+
+    LatencyHistogram merged;
+    double worst_thread_p99 = 0.0;
+    for (LatencyHistogram const & histogram : histograms)
+    {
+        worst_thread_p99
+            = (std::max) (worst_thread_p99, histogram.quantile (0.99));
+        merged.merge (histogram);
+    }
+
+    double const total_events
+        = static_cast<double>(thread_count) * events_per_thread;
+
+    tcout << std::left << std::setw (18) << name
+          << std::right
+          << std::setw (4) << thread_count << LOG4CPLUS_TEXT (" thr")
+          << std::fixed << std::setprecision (0)
+          << std::setw (12) << total_events / seconds
+          << LOG4CPLUS_TEXT (" ev/s")
+          << std::setprecision (2)
+          << std::setw (10) << merged.quantile (0.50)
+          << LOG4CPLUS_TEXT (" us p50")
+          << std::setw (10) << merged.quantile (0.99)
+          << LOG4CPLUS_TEXT (" us p99")
+          << std::setw (10) << worst_thread_p99
+          << LOG4CPLUS_TEXT (" us worst thread p99")
+          << endl;
+}
+
+
+Logger
+make_null_logger (tstring const & name)
+{
+    Logger logger = Logger::getInstance (name);
+    if (logger.getAllAppenders ().empty ())
+    {
+        SharedAppenderPtr appender (new NullAppender);
+        appender->setName (name);
+        logger.addAppender (appender);
+    }
+    logger.setAdditivity (false);
+    return logger;
+}
+
+
+} // namespace
+
+
+int
+main ()
+{
+    log4cplus::Initializer initializer;
+
+    unsigned hw = std::thread::hardware_concurrency ();
+    if (hw == 0)
+        hw = 4;
+
+    std::vector<unsigned> thread_counts;
+    for (unsigned n = 1; n < 2 * hw; n *= 2)
+        thread_counts.push_back (n);
+    thread_counts.push_back (2 * hw);
+
+    for (unsigned thread_count : thread_counts)
+    {
+        Logger shared = make_null_logger (LOG4CPLUS_TEXT ("scale.shared"));
+        run_scenario (LOG4CPLUS_TEXT ("shared-logger"), thread_count,
+            [&shared] (unsigned) { return shared; },
+            std::function<void ()> ());
+    }
+
+    for (unsigned thread_count : thread_counts)
+    {
+        run_scenario (LOG4CPLUS_TEXT ("distinct-logger"), thread_count,
+            [] (unsigned t)
+            {
+                return make_null_logger (LOG4CPLUS_TEXT ("scale.distinct.")
+                    + convertIntegerToString (t));
+            },
+            std::function<void ()> ());
+    }
+
+    for (unsigned thread_count : thread_counts)
+    {
+        Logger logger = Logger::getInstance (LOG4CPLUS_TEXT ("scale.async"));
+        logger.removeAllAppenders ();
+        SharedAppenderPtr sink (new NullAppender);
+        sink->setName (LOG4CPLUS_TEXT ("scale.async.sink"));
+        SharedAppenderPtr appender (new AsyncAppender (sink, 1000));
+        appender->setName (LOG4CPLUS_TEXT ("scale.async"));
+        logger.addAppender (appender);
+        logger.setAdditivity (false);
+
+        run_scenario (LOG4CPLUS_TEXT ("async-appender"), thread_count,
+            [&logger] (unsigned) { return logger; },
+            [&appender] () { appender->waitToFinishAsyncLogging (); });
+
+        logger.removeAllAppenders ();
+    }
+
+    return 0;
+}
+
+#endif // LOG4CPLUS_SINGLE_THREADED